@@ -76,117 +76,142 @@ void BloomApp::Render()
 {
 	auto& context = GraphicsContext::Begin("Frame");
 
-	// Offscreen color pass
+	// The graph places every barrier below, from what each pass says it reads and writes
+	m_renderGraph.Reset();
+
+	auto offscreenColor0 = m_renderGraph.ImportColorBuffer("Offscreen ColorBuffer 0", m_offscreenColorBuffer[0]);
+	auto offscreenColor1 = m_renderGraph.ImportColorBuffer("Offscreen ColorBuffer 1", m_offscreenColorBuffer[1]);
+	auto offscreenDepth = m_renderGraph.ImportDepthBuffer("Offscreen Depth Buffer", m_offscreenDepthBuffer);
+	auto backBuffer = m_renderGraph.ImportColorBuffer("Back Buffer", GetColorBuffer(), ResourceState::Present);
+	auto depthBuffer = m_renderGraph.ImportDepthBuffer("Depth Buffer", GetDepthBuffer());
 
 	if (m_bloom)
 	{
-		ScopedDrawEvent offscreenEvent(context, "Offscreen pass");
-
-		context.TransitionResource(m_offscreenColorBuffer[0], ResourceState::RenderTarget);
-		context.TransitionResource(m_offscreenDepthBuffer, ResourceState::DepthWrite);
-		context.ClearColor(m_offscreenColorBuffer[0]);
-		context.ClearDepth(m_offscreenDepthBuffer);
-
 		// 3D scene (glow pass)
-		{
-			ScopedDrawEvent event(context, "Glow pass");
+		m_renderGraph.AddPass("Glow pass",
+			[&](RenderGraphPassBuilder& builder)
+			{
+				builder.Write(offscreenColor0, ResourceState::RenderTarget);
+				builder.Write(offscreenDepth, ResourceState::DepthWrite);
+			},
+			[this](GraphicsContext& context, const RenderGraph&)
+			{
+				context.ClearColor(m_offscreenColorBuffer[0]);
+				context.ClearDepth(m_offscreenDepthBuffer);
 
-			context.BeginRendering(m_offscreenColorBuffer[0], m_offscreenDepthBuffer);
+				context.BeginRendering(m_offscreenColorBuffer[0], m_offscreenDepthBuffer);
 
-			context.SetViewportAndScissor(0u, 0u, m_offscreenBufferSize, m_offscreenBufferSize);
+				context.SetViewportAndScissor(0u, 0u, m_offscreenBufferSize, m_offscreenBufferSize);
 
-			context.SetRootSignature(m_sceneRootSignature);
-			context.SetGraphicsPipeline(m_colorPassPipeline);
+				context.SetRootSignature(m_sceneRootSignature);
+				context.SetGraphicsPipeline(m_colorPassPipeline);
 
-			context.SetRootCBV(0, m_sceneConstantBuffer);
+				context.SetRootCBV(0, m_sceneConstantBuffer);
 
-			// Render UFO model
-			m_ufoGlowModel->Render(context);
+				// Render UFO model
+				m_ufoGlowModel->Render(context);
 
-			context.EndRendering();
-		}
+				context.EndRendering();
+			});
 
 		// Vertical blur pass
-		{
-			ScopedDrawEvent event(context, "Vertical blur");
-
-			context.TransitionResource(m_offscreenColorBuffer[0], ResourceState::PixelShaderResource);
-			context.TransitionResource(m_offscreenColorBuffer[1], ResourceState::RenderTarget);
-			context.ClearColor(m_offscreenColorBuffer[1]);
+		m_renderGraph.AddPass("Vertical blur",
+			[&](RenderGraphPassBuilder& builder)
+			{
+				builder.Read(offscreenColor0, ResourceState::PixelShaderResource);
+				builder.Write(offscreenColor1, ResourceState::RenderTarget);
+			},
+			[this](GraphicsContext& context, const RenderGraph&)
+			{
+				context.ClearColor(m_offscreenColorBuffer[1]);
 
-			context.BeginRendering(m_offscreenColorBuffer[1]);
+				context.BeginRendering(m_offscreenColorBuffer[1]);
 
-			context.SetRootSignature(m_blurRootSignature);
-			context.SetGraphicsPipeline(m_blurVertPipeline);
+				context.SetRootSignature(m_blurRootSignature);
+				context.SetGraphicsPipeline(m_blurVertPipeline);
 
-			context.SetDescriptors(0, m_blurVertDescriptorSet);
+				context.SetDescriptors(0, m_blurVertDescriptorSet);
 
-			context.Draw(3);
+				context.Draw(3);
 
-			context.EndRendering();
-		}
+				context.EndRendering();
+			});
 	}
 	else
 	{
-		context.TransitionResource(m_offscreenColorBuffer[1], ResourceState::RenderTarget);
-		context.ClearColor(m_offscreenColorBuffer[1]);
+		m_renderGraph.AddPass("Clear bloom",
+			[&](RenderGraphPassBuilder& builder)
+			{
+				builder.Write(offscreenColor1, ResourceState::RenderTarget);
+			},
+			[this](GraphicsContext& context, const RenderGraph&)
+			{
+				context.ClearColor(m_offscreenColorBuffer[1]);
+			});
 	}
 
-	// Backbuffer color pass
+	// Backbuffer color pass: skybox, 3D scene (phong pass), horizontal blur and UI
+	m_renderGraph.AddPass("Backbuffer color pass",
+		[&](RenderGraphPassBuilder& builder)
+		{
+			builder.Read(offscreenColor1, ResourceState::PixelShaderResource);
+			builder.Write(backBuffer, ResourceState::RenderTarget);
+			builder.Write(depthBuffer, ResourceState::DepthWrite);
+		},
+		[this](GraphicsContext& context, const RenderGraph&)
+		{
+			context.ClearColor(GetColorBuffer());
+			context.ClearDepth(GetDepthBuffer());
 
-	context.TransitionResource(GetColorBuffer(), ResourceState::RenderTarget);
-	context.TransitionResource(m_offscreenColorBuffer[1], ResourceState::PixelShaderResource);
-	context.TransitionResource(GetDepthBuffer(), ResourceState::DepthWrite);
-	context.ClearColor(GetColorBuffer());
-	context.ClearDepth(GetDepthBuffer());
+			context.BeginRendering(GetColorBuffer(), GetDepthBuffer());
 
-	context.BeginRendering(GetColorBuffer(), GetDepthBuffer());
+			context.SetViewportAndScissor(0u, 0u, GetWindowWidth(), GetWindowHeight());
 
-	context.SetViewportAndScissor(0u, 0u, GetWindowWidth(), GetWindowHeight());
+			// Skybox
+			{
+				ScopedDrawEvent event(context, "Skybox");
 
-	// Skybox
-	{
-		ScopedDrawEvent event(context, "Skybox");
+				context.SetRootSignature(m_skyboxRootSignature);
+				context.SetGraphicsPipeline(m_skyboxPipeline);
 
-		context.SetRootSignature(m_skyboxRootSignature);
-		context.SetGraphicsPipeline(m_skyboxPipeline);
+				context.SetRootCBV(0, m_skyboxConstantBuffer);
+				context.SetDescriptors(1, m_skyBoxSrvDescriptorSet);
 
-		context.SetRootCBV(0, m_skyboxConstantBuffer);
-		context.SetDescriptors(1, m_skyBoxSrvDescriptorSet);
+				// Render skybox model
+				m_skyboxModel->Render(context);
+			}
 
-		// Render skybox model
-		m_skyboxModel->Render(context);
-	}
+			// 3D scene (phong pass)
+			{
+				ScopedDrawEvent event(context, "Phong pass");
 
-	// 3D scene (phong pass)
-	{
-		ScopedDrawEvent event(context, "Phong pass");
+				context.SetRootSignature(m_sceneRootSignature);
+				context.SetGraphicsPipeline(m_phongPassPipeline);
 
-		context.SetRootSignature(m_sceneRootSignature);
-		context.SetGraphicsPipeline(m_phongPassPipeline);
+				context.SetRootCBV(0, m_sceneConstantBuffer);
 
-		context.SetRootCBV(0, m_sceneConstantBuffer);
+				// Render UFO model
+				m_ufoGlowModel->Render(context);
+			}
 
-		// Render UFO model
-		m_ufoGlowModel->Render(context);
-	}
+			// Horizontal blur pass
+			{
+				ScopedDrawEvent event(context, "Horizontal blur");
 
-	// Horizontal blur pass
-	{
-		ScopedDrawEvent event(context, "Horizontal blur");
+				context.SetRootSignature(m_blurRootSignature);
+				context.SetGraphicsPipeline(m_blurHorizPipeline);
 
-		context.SetRootSignature(m_blurRootSignature);
-		context.SetGraphicsPipeline(m_blurHorizPipeline);
+				context.SetDescriptors(0, m_blurHorizDescriptorSet);
 
-		context.SetDescriptors(0, m_blurHorizDescriptorSet);
+				context.Draw(3);
+			}
 
-		context.Draw(3);
-	}
+			RenderUI(context);
 
-	RenderUI(context);
+			context.EndRendering();
+		});
 
-	context.EndRendering();
-	context.TransitionResource(GetColorBuffer(), ResourceState::Present);
+	m_renderGraph.Execute(context);
 
 	context.Finish();
 }
@@ -13,6 +13,8 @@
 #include "Application.h"
 #include "CameraController.h"
 
+#include "Graphics\RenderGraph.h"
+
 
 class BloomApp : public Luna::Application
 {
@@ -105,6 +107,8 @@ protected:
 	Luna::ModelPtr m_skyboxModel;
 	Luna::TexturePtr m_skyboxTexture;
 
+	Luna::RenderGraph m_renderGraph;
+
 	Luna::CameraController m_controller{ m_camera, Math::Vector3(Math::kYUnitVector) };
 
 	bool m_bloom{ true };
@@ -321,10 +321,11 @@ void DynamicIndexingApp::LoadAssets()
 			// The y position is based off of the city's row and column 
 			// position to prevent z-fighting.
 			m_modelMatrices[index] = Matrix4::MakeTranslation({ cityOffsetX, 0.02f * (i * m_cityColumnCount + j), cityOffsetZ });
-			m_modelBounds[index] = m_modelMatrices[index] * m_modelBoundingBox;
 			++index;
 		}
 	}
+
+	TransformBoundingBoxes(m_modelMatrices, m_modelBoundingBox, m_modelBounds);
 	m_sceneBoundingBox = BoundingBoxUnion(m_modelBounds);
 }
 
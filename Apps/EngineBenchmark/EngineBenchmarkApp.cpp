@@ -0,0 +1,301 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "EngineBenchmarkApp.h"
+
+#include "Core\JobSystem.h"
+#include "Graphics\CommandContext.h"
+#include "Graphics\CommonStates.h"
+#include "Graphics\DeviceManager.h"
+#include "Graphics\UploadQueue.h"
+
+using namespace Luna;
+using namespace std;
+
+
+EngineBenchmarkApp::EngineBenchmarkApp(uint32_t width, uint32_t height)
+	: Application{ width, height, s_appName }
+{
+}
+
+
+int EngineBenchmarkApp::ProcessCommandLine(int argc, char* argv[])
+{
+	// Pull out the benchmark options, and leave the rest to the Application
+	vector<char*> applicationArgs;
+	for (int i = 0; i < argc; ++i)
+	{
+		const string_view arg{ argv[i] };
+		if (arg == "--uploads" && i + 1 < argc)
+		{
+			m_numUploads = max((uint32_t)atoi(argv[++i]), 1u);
+		}
+		else if (arg == "--upload-size" && i + 1 < argc)
+		{
+			m_uploadSize = Math::AlignUp(max((uint32_t)atoi(argv[++i]), 16u), 16);
+		}
+		else if (arg == "--draws" && i + 1 < argc)
+		{
+			m_numDraws = max((uint32_t)atoi(argv[++i]), 1u);
+		}
+		else
+		{
+			applicationArgs.push_back(argv[i]);
+		}
+	}
+
+	return Application::ProcessCommandLine((int)applicationArgs.size(), applicationArgs.data());
+}
+
+
+void EngineBenchmarkApp::Configure()
+{
+	// Application config, before device creation
+	Application::Configure();
+}
+
+
+void EngineBenchmarkApp::Startup()
+{
+	RunUploadBenchmark();
+	RunParallelRecordingBenchmark();
+}
+
+
+void EngineBenchmarkApp::Shutdown()
+{
+	m_graphicsPipeline.reset();
+	m_rootSignature.reset();
+	m_vertexBuffer.reset();
+	m_renderTarget.reset();
+}
+
+
+void EngineBenchmarkApp::Update()
+{
+	// Every benchmark runs from Startup(), so there is nothing left to do
+	m_isRunning = false;
+}
+
+
+void EngineBenchmarkApp::Render()
+{
+	Application::Render();
+}
+
+
+void EngineBenchmarkApp::CreateDeviceDependentResources()
+{
+	// Create any resources that depend on the device, but not the window size
+}
+
+
+void EngineBenchmarkApp::CreateWindowSizeDependentResources()
+{
+	// Create any resources that depend on window size.  May be called when the window size changes.
+}
+
+
+void EngineBenchmarkApp::RunUploadBenchmark()
+{
+	// Warm up the upload allocator and the context pool, so the first run doesn't pay for them
+	TimeUploads(64, false, false);
+
+	const auto statsBefore = GetUploadQueue()->GetStats();
+	const double waitForEachMs = TimeUploads(m_numUploads, true, false);
+	const auto statsWaitForEach = GetUploadQueue()->GetStats();
+	const double batchedMs = TimeUploads(m_numUploads, false, false);
+	const auto statsBatched = GetUploadQueue()->GetStats();
+	const double batchedAllThreadsMs = TimeUploads(m_numUploads, false, true);
+	const auto statsBatchedAllThreads = GetUploadQueue()->GetStats();
+
+	LogInfo(LogApplication) << format("Upload benchmark: {} buffers of {} bytes", m_numUploads, m_uploadSize) << endl;
+	LogInfo(LogApplication) << format("  Wait for each:         {:8.2f} ms, {} batches",
+		waitForEachMs, statsWaitForEach.numBatches - statsBefore.numBatches) << endl;
+	LogInfo(LogApplication) << format("  Batched:               {:8.2f} ms, {} batches, {} ring stalls, {:.1f}x",
+		batchedMs, statsBatched.numBatches - statsWaitForEach.numBatches, statsBatched.numRingStalls - statsWaitForEach.numRingStalls,
+		waitForEachMs / batchedMs) << endl;
+	LogInfo(LogApplication) << format("  Batched, {:2} threads:   {:8.2f} ms, {} batches, {} ring stalls, {:.1f}x",
+		GetJobSystem()->GetNumWorkers() + 1, batchedAllThreadsMs, statsBatchedAllThreads.numBatches - statsBatched.numBatches,
+		statsBatchedAllThreads.numRingStalls - statsBatched.numRingStalls, waitForEachMs / batchedAllThreadsMs) << endl;
+}
+
+
+double EngineBenchmarkApp::TimeUploads(uint32_t numUploads, bool waitForEach, bool useAllThreads)
+{
+	vector<uint8_t> data(m_uploadSize, 0x5a);
+	vector<GpuBufferPtr> buffers(numUploads);
+
+	GpuBufferDesc bufferDesc{
+		.name = "Upload Benchmark Buffer",
+		.resourceType = ResourceType::VertexBuffer,
+		.memoryAccess = MemoryAccess::GpuReadWrite,
+		.elementCount = m_uploadSize / 16,
+		.elementSize = 16
+	};
+
+	auto uploadQueue = GetUploadQueue();
+
+	auto initializeBuffer = [&](uint32_t index)
+	{
+		buffers[index] = CreateGpuBuffer(bufferDesc);
+		const UploadTicket ticket = CommandContext::InitializeBuffer(buffers[index], data.data(), data.size());
+		if (waitForEach)
+		{
+			uploadQueue->Wait(ticket);
+		}
+	};
+
+	const auto startTime = chrono::high_resolution_clock::now();
+
+	if (useAllThreads)
+	{
+		ParallelFor(numUploads, initializeBuffer);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < numUploads; ++i)
+		{
+			initializeBuffer(i);
+		}
+	}
+	uploadQueue->WaitForAll();
+
+	const double elapsedMs = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+
+	// Keep the release of the buffers out of the next run
+	buffers.clear();
+	m_deviceManager->WaitForGpu();
+
+	return elapsedMs;
+}
+
+
+void EngineBenchmarkApp::RunParallelRecordingBenchmark()
+{
+	// An offscreen target, so the benchmark doesn't depend on the swap chain
+	ColorBufferDesc renderTargetDesc{
+		.name		= "Parallel Recording Benchmark Target",
+		.width		= 256,
+		.height		= 256,
+		.format		= Format::RGBA8_UNorm
+	};
+	m_renderTarget = CreateColorBuffer(renderTargetDesc);
+
+	const float vertexData[] = { -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	GpuBufferDesc vertexBufferDesc{
+		.name			= "Parallel Recording Benchmark Vertex Buffer",
+		.resourceType	= ResourceType::VertexBuffer,
+		.memoryAccess	= MemoryAccess::GpuReadWrite,
+		.elementCount	= 3,
+		.elementSize	= 3 * sizeof(float),
+		.initialData	= vertexData
+	};
+	m_vertexBuffer = CreateGpuBuffer(vertexBufferDesc);
+
+	// Per-draw root constants, like a draw's object index
+	RootSignatureDesc rootSignatureDesc{
+		.name				= "Parallel Recording Benchmark Root Signature",
+		.rootParameters		= { RootConstants(0, 4, ShaderStage::Vertex) }
+	};
+	m_rootSignature = CreateRootSignature(rootSignatureDesc);
+
+	VertexStreamDesc vertexStreamDesc{
+		.inputSlot				= 0,
+		.stride					= 3 * sizeof(float),
+		.inputClassification	= InputClassification::PerVertexData
+	};
+
+	GraphicsPipelineDesc pipelineDesc{
+		.name				= "Parallel Recording Benchmark PSO",
+		.blendState			= CommonStates::BlendDisable(),
+		.depthStencilState	= CommonStates::DepthStateDisabled(),
+		.rasterizerState	= CommonStates::RasterizerTwoSided(),
+		.rtvFormats			= { Format::RGBA8_UNorm },
+		.dsvFormat			= Format::Unknown,
+		.topology			= PrimitiveTopology::TriangleList,
+		.vertexShader		= { .shaderFile = "SampleVS" },
+		.pixelShader		= { .shaderFile = "SamplePS" },
+		.vertexStreams		= { vertexStreamDesc },
+		.vertexElements		= { { "POSITION", 0, Format::RGB32_Float, 0, 0, InputClassification::PerVertexData, 0 } },
+		.rootSignature		= m_rootSignature
+	};
+	m_graphicsPipeline = CreateGraphicsPipeline(pipelineDesc);
+
+	// Warm up the context pool, so the runs below don't pay for creating contexts
+	const uint32_t numThreads = GetJobSystem() ? GetJobSystem()->GetNumWorkers() + 1 : 1;
+	TimeRecording(min(m_numDraws, 1024u), numThreads * 2);
+
+	const double serialMs = TimeRecording(m_numDraws, 0);
+
+	LogInfo(LogApplication) << format("Parallel recording benchmark: {} draws, {} threads", m_numDraws, numThreads) << endl;
+	LogInfo(LogApplication) << format("  One context:           {:8.2f} ms, {:6.1f} ns/draw", serialMs, serialMs * 1.0e6 / m_numDraws) << endl;
+
+	for (uint32_t numContexts = 1; numContexts <= numThreads * 2; numContexts *= 2)
+	{
+		const double parallelMs = TimeRecording(m_numDraws, numContexts);
+		LogInfo(LogApplication) << format("  {:2} parallel contexts:  {:8.2f} ms, {:6.1f} ns/draw, {:.2f}x",
+			numContexts, parallelMs, parallelMs * 1.0e6 / m_numDraws, serialMs / parallelMs) << endl;
+	}
+}
+
+
+double EngineBenchmarkApp::TimeRecording(uint32_t numDraws, uint32_t numContexts)
+{
+	auto& context = GraphicsContext::Begin("Parallel Recording Benchmark");
+
+	context.TransitionResource(m_renderTarget, ResourceState::RenderTarget);
+	context.BeginRendering(m_renderTarget);
+	context.SetViewportAndScissor(0u, 0u, (uint32_t)m_renderTarget->GetWidth(), m_renderTarget->GetHeight());
+	context.SetRootSignature(m_rootSignature);
+	context.SetGraphicsPipeline(m_graphicsPipeline);
+	context.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+
+	const auto startTime = chrono::high_resolution_clock::now();
+
+	if (numContexts == 0)
+	{
+		RecordDraws(context, 0, numDraws);
+		context.EndRendering();
+	}
+	else
+	{
+		// Children inherit the target, root signature and pipeline, so each one only binds its topology and vertex buffer
+		auto childContexts = context.BeginParallelRecording(numContexts);
+
+		ParallelFor(numContexts, [&](uint32_t index)
+			{
+				const uint32_t firstDraw = (uint32_t)((uint64_t)numDraws * index / numContexts);
+				const uint32_t endDraw = (uint32_t)((uint64_t)numDraws * (index + 1) / numContexts);
+				RecordDraws(*childContexts[index], firstDraw, endDraw);
+			});
+
+		context.EndParallelRecording();
+	}
+
+	context.Finish(true);
+
+	return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+}
+
+
+void EngineBenchmarkApp::RecordDraws(GraphicsContext& context, uint32_t firstDraw, uint32_t endDraw)
+{
+	context.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+	context.SetVertexBuffer(0, m_vertexBuffer);
+
+	for (uint32_t i = firstDraw; i < endDraw; ++i)
+	{
+		context.SetConstants(0, i, i * 3, i * 5, i * 7);
+		context.Draw(3);
+	}
+}
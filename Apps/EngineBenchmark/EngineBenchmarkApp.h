@@ -0,0 +1,57 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Application.h"
+
+
+// Measures CPU-side engine costs, and exits when done.  Meant to be run headless, with --null, but works on
+// any backend.
+class EngineBenchmarkApp : public Luna::Application
+{
+public:
+	EngineBenchmarkApp(uint32_t width, uint32_t height);
+
+	int ProcessCommandLine(int argc, char* argv[]) final;
+
+	void Configure() final;
+	void Startup() final;
+	void Shutdown() final;
+
+	void Update() final;
+	void Render() final;
+
+protected:
+	void CreateDeviceDependentResources() final;
+	void CreateWindowSizeDependentResources() final;
+
+private:
+	// Initializes many small buffers, waiting on each one like the old Finish(true) path, then batched through
+	// the UploadQueue from one thread and from all of the job system's threads
+	void RunUploadBenchmark();
+	double TimeUploads(uint32_t numUploads, bool waitForEach, bool useAllThreads);
+
+	// Records many small draws into one context, then split across more and more parallel recording contexts,
+	// each filled by its own job
+	void RunParallelRecordingBenchmark();
+	double TimeRecording(uint32_t numDraws, uint32_t numContexts);
+	void RecordDraws(Luna::GraphicsContext& context, uint32_t firstDraw, uint32_t endDraw);
+
+private:
+	uint32_t m_numUploads{ 10000 };
+	uint32_t m_uploadSize{ 256 };
+
+	uint32_t m_numDraws{ 100000 };
+	Luna::ColorBufferPtr m_renderTarget;
+	Luna::GpuBufferPtr m_vertexBuffer;
+	Luna::RootSignaturePtr m_rootSignature;
+	Luna::GraphicsPipelinePtr m_graphicsPipeline;
+};
@@ -0,0 +1,4 @@
+float4 main() : SV_TARGET
+{
+	return float4(1.0f, 1.0f, 1.0f, 1.0f);
+}
\ No newline at end of file
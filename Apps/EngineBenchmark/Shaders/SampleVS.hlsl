@@ -0,0 +1,4 @@
+float4 main( float4 pos : POSITION ) : SV_POSITION
+{
+	return pos;
+}
\ No newline at end of file
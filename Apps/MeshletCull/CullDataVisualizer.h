@@ -11,9 +11,9 @@
 #pragma once
 
 #include "Graphics\GpuBuffer.h"
+#include "Graphics\MeshletModel.h"
 #include "Graphics\PipelineState.h"
 #include "Graphics\RootSignature.h"
-#include "MeshletModel.h"
 
 
 // Forward declarations
@@ -32,7 +32,7 @@ class CullDataVisualizer
 public:
 	CullDataVisualizer(Luna::Application* application);
 
-	void Render(Luna::GraphicsContext& context, const MeshletMesh& mesh, uint32_t offset, uint32_t count);
+	void Render(Luna::GraphicsContext& context, const Luna::MeshletMesh& mesh, uint32_t offset, uint32_t count);
 	void Update(Math::Matrix4 worldMatrix, Math::Matrix4 viewMatrix, Math::Matrix4 projectionMatrix, Math::Vector4 color);
 
 protected:
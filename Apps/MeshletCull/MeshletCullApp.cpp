@@ -523,7 +523,7 @@ void MeshletCullApp::Pick()
 		auto& cull = mesh.cullingData[i];
 
 		// Quick narrow-phase test against the meshlet's sphere bounds.
-		XMFLOAT4 boundingSphereVec{ cull.boundingSphere.Center.x, cull.boundingSphere.Center.y, cull.boundingSphere.Center.z, cull.boundingSphere.Radius };
+		XMFLOAT4 boundingSphereVec{ cull.boundingSphere[0], cull.boundingSphere[1], cull.boundingSphere[2], cull.boundingSphere[3] };
 		if (!RayIntersectSphere(org, dir, XMLoadFloat4(&boundingSphereVec)))
 		{
 			continue;
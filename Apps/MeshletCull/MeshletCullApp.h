@@ -14,7 +14,7 @@
 #include "CameraController.h"
 #include "CullDataVisualizer.h"
 #include "FrustumVisualizer.h"
-#include "MeshletModel.h"
+#include "Graphics\MeshletModel.h"
 #include "Shaders/Shared.h"
 
 
@@ -53,7 +53,7 @@ protected:
 
 	struct SceneObject
 	{
-		MeshletModel model;
+		Luna::MeshletModel model;
 		Math::Matrix4 worldMatrix;
 		Luna::GpuBufferPtr instanceBuffer;
 		void* instanceData;
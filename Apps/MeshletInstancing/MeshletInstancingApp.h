@@ -12,8 +12,7 @@
 
 #include "Application.h"
 #include "CameraController.h"
-
-#include "MeshletModel.h"
+#include "Graphics\MeshletModel.h"
 
 
 class MeshletInstancingApp : public Luna::Application
@@ -71,7 +70,7 @@ protected:
 	Luna::MeshletPipelinePtr m_meshletPipeline;
 	bool m_pipelineCreated{ false };
 
-	MeshletModel m_model;
+	Luna::MeshletModel m_model;
 
 	int32_t m_instanceLevel{ 0 };
 	const int32_t m_maxInstanceLevel{ 5 };
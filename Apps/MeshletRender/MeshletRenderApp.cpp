@@ -122,7 +122,10 @@ void MeshletRenderApp::CreateDeviceDependentResources()
 	
 	InitRootSignature();
 
+	// Draw meshlets built by the engine, rather than the ones baked into the file, within the output limits
+	// of MeshletMS.hlsl
 	m_model.LoadFromFile("Dragon_LOD0.bin");
+	m_model.RebuildMeshlets(MeshletBuildDesc{ .maxVertices = 64, .maxPrimitives = 126 });
 	m_model.InitResources(m_deviceManager->GetDevice());
 
 	InitDescriptorSets();
@@ -12,8 +12,7 @@
 
 #include "Application.h"
 #include "CameraController.h"
-
-#include "MeshletModel.h"
+#include "Graphics\MeshletModel.h"
 
 
 class MeshletRenderApp : public Luna::Application
@@ -59,7 +58,7 @@ protected:
 	Luna::MeshletPipelinePtr m_meshletPipeline;
 	bool m_pipelineCreated{ false };
 
-	MeshletModel m_model;
+	Luna::MeshletModel m_model;
 
 	Luna::CameraController m_controller{ m_camera, Math::Vector3(Math::kYUnitVector) };
 };
\ No newline at end of file
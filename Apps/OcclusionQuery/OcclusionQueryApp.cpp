@@ -21,6 +21,22 @@ using namespace Math;
 using namespace std;
 
 
+namespace
+{
+
+// The twelve triangles of a box, with corner i at (i & 1 ? max : min, i & 2 ? max : min, i & 4 ? max : min)
+constexpr uint32_t s_boxIndices[] = {
+	0, 6, 4, 0, 2, 6,
+	1, 7, 3, 1, 5, 7,
+	0, 5, 1, 0, 4, 5,
+	2, 7, 6, 2, 3, 7,
+	0, 3, 2, 0, 1, 3,
+	4, 7, 5, 4, 6, 7
+};
+
+} // anonymous namespace
+
+
 OcclusionQueryApp::OcclusionQueryApp(uint32_t width, uint32_t height)
 	: Application{ width, height, s_appName }
 {}
@@ -67,6 +83,12 @@ void OcclusionQueryApp::UpdateUI()
 		m_uiOverlay->Text("Teapot: %d samples passed", m_passedSamples[0]);
 		m_uiOverlay->Text("Sphere: %d samples passed", m_passedSamples[1]);
 	}
+
+	if (m_uiOverlay->Header("CPU occlusion culling"))
+	{
+		m_uiOverlay->Text("Teapot: %s", m_cpuVisible[0] ? "visible" : "hidden");
+		m_uiOverlay->Text("Sphere: %s", m_cpuVisible[1] ? "visible" : "hidden");
+	}
 }
 
 
@@ -311,20 +333,66 @@ void OcclusionQueryApp::UpdateConstantBuffers()
 		m_readbackBuffer->Unmap();
 	}
 
+	const Matrix4 teapotMatrix = rotationMatrix * Matrix4(AffineTransform::MakeTranslation(Vector3(0.0f, 0.0f, -3.0f)));
+	const Matrix4 sphereMatrix = rotationMatrix * Matrix4(AffineTransform::MakeTranslation(Vector3(0.0f, 0.0f, 3.0f)));
+	UpdateCpuOcclusion(rotationMatrix, teapotMatrix, sphereMatrix);
+
 	m_teapotConstants.projectionMatrix = projectionMatrix;
-	m_teapotConstants.modelViewMatrix = viewMatrix * rotationMatrix * Matrix4(AffineTransform::MakeTranslation(Vector3(0.0f, 0.0f, -3.0f)));
+	m_teapotConstants.modelViewMatrix = viewMatrix * teapotMatrix;
 	m_teapotConstants.visible = teapotQueryResult > 0 ? 1.0f : 0.0f;
 	m_teapotConstants.color = DirectX::Colors::Red;
 	m_teapotConstantBuffer->Update(sizeof(m_teapotConstants), &m_teapotConstants);
 
 	m_sphereConstants.projectionMatrix = projectionMatrix;
-	m_sphereConstants.modelViewMatrix = viewMatrix * rotationMatrix * Matrix4(AffineTransform::MakeTranslation(Vector3(0.0f, 0.0f, 3.0f)));
+	m_sphereConstants.modelViewMatrix = viewMatrix * sphereMatrix;
 	m_sphereConstants.visible = sphereQueryResult > 0 ? 1.0f : 0.0f;
 	m_sphereConstants.color = DirectX::Colors::Green;
 	m_sphereConstantBuffer->Update(sizeof(m_sphereConstants), &m_sphereConstants);
 }
 
 
+void OcclusionQueryApp::UpdateCpuOcclusion(const Matrix4& occluderMatrix, const Matrix4& teapotMatrix, const Matrix4& sphereMatrix)
+{
+	// The occluder plane is flat, so its bounding box is the plane itself, and the box's sides have no area
+	const Vector3 planeMin = m_occluderModel->boundingBox.GetMin();
+	const Vector3 planeMax = m_occluderModel->boundingBox.GetMax();
+	array<float, 24> planePositions;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		planePositions[3 * i] = (i & 1) ? planeMax.GetX() : planeMin.GetX();
+		planePositions[3 * i + 1] = (i & 2) ? planeMax.GetY() : planeMin.GetY();
+		planePositions[3 * i + 2] = (i & 4) ? planeMax.GetZ() : planeMin.GetZ();
+	}
+
+	m_occlusionCuller.BeginFrame(m_camera.GetViewProjectionMatrix());
+	m_occlusionCuller.AddOccluder(occluderMatrix, planePositions, 3, s_boxIndices);
+	m_occlusionCuller.RasterizeOccluders();
+
+	// World-space bounds of the teapot and the sphere, culled by the frustum first, and then by the occluder
+	const BoundingBox bounds[2] = { teapotMatrix * m_teapotModel->boundingBox, sphereMatrix * m_sphereModel->boundingBox };
+	float minX[2], minY[2], minZ[2], maxX[2], maxY[2], maxZ[2];
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		const Vector3 boundsMin = bounds[i].GetMin();
+		const Vector3 boundsMax = bounds[i].GetMax();
+		minX[i] = boundsMin.GetX();
+		minY[i] = boundsMin.GetY();
+		minZ[i] = boundsMin.GetZ();
+		maxX[i] = boundsMax.GetX();
+		maxY[i] = boundsMax.GetY();
+		maxZ[i] = boundsMax.GetZ();
+	}
+	const BoundingBoxSoA boxes{ minX, minY, minZ, maxX, maxY, maxZ };
+
+	uint64_t visibleMask{ 0 };
+	m_camera.GetWorldSpaceFrustum().CullBoundingBoxes(boxes, span<uint64_t>{ &visibleMask, 1 });
+	m_occlusionCuller.CullBoundingBoxes(boxes, span<uint64_t>{ &visibleMask, 1 });
+
+	m_cpuVisible[0] = (visibleMask & 1) != 0;
+	m_cpuVisible[1] = (visibleMask & 2) != 0;
+}
+
+
 void OcclusionQueryApp::LoadAssets()
 {
 	auto layout = VertexLayout<VertexComponent::PositionNormalColor>();
@@ -13,6 +13,8 @@
 #include "Application.h"
 #include "CameraController.h"
 
+#include "Graphics\OcclusionCuller.h"
+
 class OcclusionQueryApp : public Luna::Application
 {
 public:
@@ -37,6 +39,7 @@ protected:
 	void InitQueryHeap();
 
 	void UpdateConstantBuffers();
+	void UpdateCpuOcclusion(const Math::Matrix4& occluderMatrix, const Math::Matrix4& teapotMatrix, const Math::Matrix4& sphereMatrix);
 
 	void LoadAssets();
 
@@ -76,4 +79,8 @@ protected:
 	float m_zoom{ -10.0f };
 
 	uint32_t m_passedSamples[2]{ 0,0 };
+
+	// The same test on the CPU, ready in the same frame.  The occluder plane is drawn two-sided.
+	Luna::OcclusionCuller m_occlusionCuller{ Luna::OcclusionCullerDesc{ .cullMode = Luna::CullMode::None } };
+	bool m_cpuVisible[2]{ true, true };
 };
\ No newline at end of file
@@ -18,6 +18,7 @@
 #include "Graphics\CommandContext.h"
 #include "Graphics\Device.h"
 #include "Graphics\DeviceManager.h"
+#include "Graphics\GpuProfiler.h"
 
 #include <glfw\glfw3.h>
 #define GLFW_EXPOSE_NATIVE_WIN32 1
@@ -127,20 +128,26 @@ int Application::ProcessCommandLine(int argc, char* argv[])
 	// Graphic API selection
 	bool bDX12{ false };
 	bool bVulkan{ false };
+	bool bNull{ false };
 	auto dxOpt = app.add_flag("--dx,--dx12,--d3d12", bDX12, "Select DirectX renderer");
 	auto vkOpt = app.add_flag("--vk,--vulkan", bVulkan, "Select Vulkan renderer");
-	dxOpt->excludes(vkOpt);
-	vkOpt->excludes(dxOpt);
+	auto nullOpt = app.add_flag("--null", bNull, "Select headless null renderer");
+	dxOpt->excludes(vkOpt)->excludes(nullOpt);
+	vkOpt->excludes(dxOpt)->excludes(nullOpt);
+	nullOpt->excludes(dxOpt)->excludes(vkOpt);
 
 	// Width, height
 	auto widthOpt = app.add_option("--resx,--width", m_appInfo.width, "Sets initial window width");
 	auto heightOpt = app.add_option("--resy,--height", m_appInfo.height, "Sets initial window height");
 
+	// Frame count
+	app.add_option("--frames", m_appInfo.numFrames, "Exit after rendering this many frames");
+
 	// Parse command line
 	CLI11_PARSE(app, argc, argv);
 
 	// Set application parameters from command line
-	m_appInfo.api = bVulkan ? GraphicsApi::Vulkan : GraphicsApi::D3D12;
+	m_appInfo.api = bNull ? GraphicsApi::Null : (bVulkan ? GraphicsApi::Vulkan : GraphicsApi::D3D12);
 	m_appNameWithApi = format("[{}] {}", GraphicsApiToString(m_appInfo.api), m_appInfo.name);
 
 	return 0;
@@ -217,7 +224,9 @@ void Application::Run()
 		return;
 	}
 
-	while (m_isRunning && !glfwWindowShouldClose(m_pWindow))
+	const auto startTime = chrono::high_resolution_clock::now();
+
+	while (m_isRunning && (m_pWindow == nullptr || !glfwWindowShouldClose(m_pWindow)))
 	{
 		FRAMEPRO_FRAME_START();
 		if (!g_isFrameProRunning)
@@ -225,15 +234,30 @@ void Application::Run()
 			g_isFrameProRunning = true;
 		}
 
-		glfwPollEvents();
+		if (m_pWindow != nullptr)
+		{
+			glfwPollEvents();
 
-		UpdateWindowSize();
+			UpdateWindowSize();
+		}
 
 		m_isRunning = Tick();
+
+		if (m_appInfo.numFrames > 0 && m_deviceManager->GetFrameNumber() >= m_appInfo.numFrames)
+		{
+			m_isRunning = false;
+		}
 	}
 
 	m_deviceManager->WaitForGpu();
 
+	const uint64_t numFrames = m_deviceManager->GetFrameNumber();
+	if (numFrames > 0)
+	{
+		const double totalMs = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+		LogInfo(LogApplication) << format("Ran {} frames in {:.2f} ms ({:.3f} ms/frame CPU)", numFrames, totalMs, totalMs / (double)numFrames) << endl;
+	}
+
 	Finalize();
 }
 
@@ -326,6 +350,12 @@ void Application::CreateWindowSizeDependentResources()
 
 void Application::UpdateWindowSize()
 {
+	// Headless apps keep the size they were configured with
+	if (m_pWindow == nullptr)
+	{
+		return;
+	}
+
 	int width{ 0 };
 	int height{ 0 };
 	glfwGetWindowSize(m_pWindow, &width, &height);
@@ -427,9 +457,9 @@ SamplerPtr Application::CreateSampler(const SamplerDesc& samplerDesc)
 }
 
 
-TexturePtr Application::LoadTexture(const std::string& filename, Format format, bool forceSrgb, bool retainData)
+TexturePtr Application::LoadTexture(const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage)
 {
-	return GetTextureManager()->Load(filename, format, forceSrgb, retainData);
+	return GetTextureManager()->Load(filename, format, forceSrgb, retainData, usage);
 }
 
 
@@ -441,7 +471,7 @@ ModelPtr Application::LoadModel(const std::string& filename, const VertexLayoutB
 
 void Application::PrepareUI()
 {
-	if (!m_showUI)
+	if (!m_showUI || !m_uiOverlay)
 		return;
 
 	ScopedEvent event("PrepareUI");
@@ -466,11 +496,18 @@ void Application::PrepareUI()
 	ImGui::TextUnformatted(m_deviceManager->GetDeviceName().c_str());
 	ImGui::Text("%.2f ms/frame (%.1d fps)", (1000.0f / m_timer.GetFramesPerSecond()), m_timer.GetFramesPerSecond());
 
+	ImGui::Checkbox("Profiler", &m_showProfiler);
+
 	ImGui::PushItemWidth(110.0f * m_uiOverlay->GetScale());
 	UpdateUI();
 	ImGui::PopItemWidth();
 
 	ImGui::End();
+
+	if (m_showProfiler)
+	{
+		m_uiOverlay->ProfilerWindow(*m_frameProfiler, &m_showProfiler);
+	}
 	ImGui::PopStyleVar();
 	ImGui::Render();
 
@@ -480,7 +517,7 @@ void Application::PrepareUI()
 
 void Application::RenderUI(GraphicsContext& context)
 {
-	if (!m_showUI)
+	if (!m_showUI || !m_uiOverlay)
 		return;
 
 	m_uiOverlay->Render(context);
@@ -516,21 +553,40 @@ bool Application::Initialize()
 	// This is the first place we can post a startup message
 	LogInfo(LogApplication) << "App " << m_appInfo.name << " initializing" << endl;
 
+	m_jobSystem = make_unique<JobSystem>();
+	LogInfo(LogApplication) << "Job system started with " << m_jobSystem->GetNumWorkers() << " worker threads" << endl;
+
+	m_frameProfiler = make_unique<FrameProfiler>();
+
 	// Application setup before device creation
 	Configure();
 
-	if (!CreateAppWindow())
+	if (IsHeadless())
 	{
-		return false;
+		LogInfo(LogApplication) << "Running headless" << (m_appInfo.numFrames > 0 ? format(" for {} frames", m_appInfo.numFrames) : "") << endl;
+		m_showUI = false;
+	}
+	else
+	{
+		if (!CreateAppWindow())
+		{
+			return false;
+		}
+
+		m_hwnd = glfwGetWin32Window(m_pWindow);
 	}
 
-	m_hwnd = glfwGetWin32Window(m_pWindow);
 	m_inputSystem = make_unique<InputSystem>(m_hwnd);
 
 	CreateDeviceManager();
 
+	m_gpuProfiler = make_unique<GpuProfiler>();
+
 	m_grid = make_unique<Grid>(this, m_gridColor);
-	m_uiOverlay = make_unique<UIOverlay>(this, m_pWindow, m_appInfo.api);
+	if (!IsHeadless())
+	{
+		m_uiOverlay = make_unique<UIOverlay>(this, m_pWindow, m_appInfo.api);
+	}
 
 	// Call the base then the derived function
 	Application::CreateDeviceDependentResources();
@@ -557,9 +613,13 @@ void Application::Finalize()
 	Shutdown();
 
 	m_uiOverlay.reset();
+	m_gpuProfiler.reset();
 
-	glfwDestroyWindow(m_pWindow);
-	m_pWindow = nullptr;
+	if (m_pWindow != nullptr)
+	{
+		glfwDestroyWindow(m_pWindow);
+		m_pWindow = nullptr;
+	}
 }
 
 
@@ -570,6 +630,9 @@ bool Application::Tick()
 		return false;
 	}
 
+	// Close out the previous tick, so that every scope inside it is complete
+	m_frameProfiler->EndFrame();
+
 	ScopedEvent event{ "Application::Tick" };
 
 	m_inputSystem->Update((float)m_timer.GetElapsedSeconds());
@@ -600,11 +663,13 @@ bool Application::Tick()
 		ScopedEvent event("Frame");
 
 		m_deviceManager->BeginFrame();
+		m_gpuProfiler->BeginFrame();
 		Render();
+		m_gpuProfiler->EndFrame();
 		m_deviceManager->Present();
 	}
 
-	if ((frameCount % 1000) == 0)
+	if (m_pWindow != nullptr && (frameCount % 1000) == 0)
 	{
 		string windowTitle = format("{} - {} fps", m_appNameWithApi, m_timer.GetFramesPerSecond());
 		glfwSetWindowTitle(m_pWindow, windowTitle.c_str());
@@ -658,6 +723,12 @@ void Application::CreateDeviceManager()
 
 int Run(Application* pApplication)
 {
+	if (pApplication->IsHeadless())
+	{
+		pApplication->Run();
+		return 0;
+	}
+
 	glfwSetErrorCallback(GlfwErrorCallback);
 
 	if (!glfwInit())
@@ -35,7 +35,10 @@ namespace Luna
 
 // Forward declarations
 class FileSystem;
+class FrameProfiler;
+class GpuProfiler;
 class InputSystem;
+class JobSystem;
 class LogSystem;
 enum class GraphicsApi;
 
@@ -58,12 +61,16 @@ struct ApplicationInfo
 	bool useDebugMarkers{ false };
 #endif
 
+	// Stop after this many frames, 0 runs until the window is closed
+	uint32_t numFrames{ 0 };
+
 	ApplicationInfo& SetName(const std::string& value) { name = value; return *this; }
 	constexpr ApplicationInfo& SetWidth(uint32_t value) noexcept { width = value; return *this; }
 	constexpr ApplicationInfo& SetHeight(uint32_t value) noexcept { height = value; return *this; }
 	constexpr ApplicationInfo& SetApi(GraphicsApi value) noexcept { api = value; return *this; }
 	constexpr ApplicationInfo& SetUseValidation(bool value) noexcept { useValidation = value; return *this; }
 	constexpr ApplicationInfo& SetUseDebugMarkers(bool value) noexcept { useDebugMarkers = value; return *this; }
+	constexpr ApplicationInfo& SetNumFrames(uint32_t value) noexcept { numFrames = value; return *this; }
 };
 
 
@@ -116,6 +123,9 @@ public:
 
 	const ApplicationInfo& GetInfo() const { return m_appInfo; }
 
+	// The null backend runs without a window, input or UI
+	bool IsHeadless() const { return m_appInfo.api == GraphicsApi::Null; }
+
 	// Wrappers for graphics resource creation
 	ColorBufferPtr CreateColorBuffer(const ColorBufferDesc& colorBufferDesc);
 	DepthBufferPtr CreateDepthBuffer(const DepthBufferDesc& depthBufferDesc);
@@ -131,7 +141,7 @@ public:
 	SamplerPtr CreateSampler(const SamplerDesc& samplerDesc);
 
 	// Wrappers for resource loading
-	TexturePtr LoadTexture(const std::string& filename, Format format = Format::Unknown, bool forceSrgb = false, bool retainData = false);
+	TexturePtr LoadTexture(const std::string& filename, Format format = Format::Unknown, bool forceSrgb = false, bool retainData = false, TextureUsage usage = TextureUsage::Default);
 	ModelPtr LoadModel(const std::string& filename, const VertexLayoutBase& layout, float scale = 1.0f, ModelLoad loadFlags = ModelLoad::StandardDefault, bool loadMaterials = false);
 
 protected:
@@ -164,6 +174,7 @@ protected:
 	bool m_isVisible{ true };
 	bool m_isWindowFocused{ false };
 	bool m_showUI{ true };
+	bool m_showProfiler{ false };
 	bool m_showGrid{ false };
 
 	// Frame timer
@@ -179,9 +190,12 @@ protected:
 	// Engine systems
 	std::unique_ptr<FileSystem> m_fileSystem;
 	std::unique_ptr<LogSystem> m_logSystem;
+	std::unique_ptr<JobSystem> m_jobSystem;
+	std::unique_ptr<FrameProfiler> m_frameProfiler;
 	std::unique_ptr<InputSystem> m_inputSystem;
 
 	std::unique_ptr<IDeviceManager> m_deviceManager;
+	std::unique_ptr<GpuProfiler> m_gpuProfiler;
 
 	std::unique_ptr<UIOverlay> m_uiOverlay;
 	std::unique_ptr<Grid> m_grid;
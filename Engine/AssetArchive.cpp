@@ -0,0 +1,648 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "AssetArchive.h"
+
+#include "MappedFile.h"
+
+#include <bit>
+
+using namespace std;
+
+
+namespace
+{
+
+// Bump this whenever the layout below, or the compressed format, changes
+constexpr uint32_t s_archiveMagic = 0x4B41504C; // 'LPAK'
+constexpr uint32_t s_archiveVersion = 1;
+constexpr uint64_t s_entryAlignment = 64 * 1024;
+
+// Sequences of the LZ coder.  Matches must be at least this long, and within this distance.
+constexpr size_t s_lzMinMatch = 4;
+constexpr size_t s_lzMaxOffset = 65535;
+constexpr uint32_t s_lzHashBits = 16;
+
+
+struct FileRange
+{
+	uint64_t offset{ 0 };
+	uint64_t size{ 0 };
+};
+
+
+// Followed by the entry, bucket and name tables, and then by the entries themselves
+struct FileHeader
+{
+	uint32_t magic{ s_archiveMagic };
+	uint32_t version{ s_archiveVersion };
+	uint64_t fileSize{ 0 };
+	uint32_t numEntries{ 0 };
+	uint32_t numBuckets{ 0 };	// Power of 2, at least twice the number of entries
+	FileRange entryTable;
+	FileRange bucketTable;		// Index + 1 of an entry, or 0 for an empty bucket.  Probed linearly.
+	FileRange nameTable;
+};
+
+
+enum class EntryCompression : uint32_t
+{
+	None,
+	LZ
+};
+
+
+struct FileEntry
+{
+	uint64_t pathHash{ 0 };
+	FileRange data;				// As stored
+	uint64_t size{ 0 };			// Once decompressed
+	uint32_t nameOffset{ 0 };	// Into the name table, normalized
+	uint32_t nameLength{ 0 };
+	EntryCompression compression{ EntryCompression::None };
+	uint32_t padding{ 0 };
+};
+
+
+bool IsValid(FileRange range, uint64_t fileSize, uint64_t alignment = 1)
+{
+	return range.offset <= fileSize &&
+		range.size <= fileSize - range.offset &&
+		(range.offset % alignment) == 0;
+}
+
+
+// LZ77, with sequences laid out like LZ4 blocks.  Each sequence is a token, holding the literal count and the
+// match length in its high and low nibbles, then the literals, a 16-bit little-endian match offset, and the rest
+// of the match length.  Nibbles of 15 continue in bytes, which add up until one is less than 255.  The last
+// sequence holds only literals.
+uint32_t Load32(const uint8_t* data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+
+void WriteLZLength(vector<std::byte>& outData, size_t length)
+{
+	for (; length >= 255; length -= 255)
+	{
+		outData.push_back(std::byte{ 255 });
+	}
+	outData.push_back((std::byte)length);
+}
+
+
+void WriteLZSequence(vector<std::byte>& outData, const uint8_t* literals, size_t numLiterals, size_t matchLength, size_t matchOffset)
+{
+	const size_t matchCode = matchLength > 0 ? matchLength - s_lzMinMatch : 0;
+
+	outData.push_back((std::byte)((min<size_t>(numLiterals, 15) << 4) | min<size_t>(matchCode, 15)));
+	if (numLiterals >= 15)
+	{
+		WriteLZLength(outData, numLiterals - 15);
+	}
+	outData.insert(outData.end(), (const std::byte*)literals, (const std::byte*)literals + numLiterals);
+
+	if (matchLength == 0)
+	{
+		return;
+	}
+
+	outData.push_back((std::byte)(matchOffset & 0xFF));
+	outData.push_back((std::byte)(matchOffset >> 8));
+	if (matchCode >= 15)
+	{
+		WriteLZLength(outData, matchCode - 15);
+	}
+}
+
+
+// Greedy, against the last position seen for each hash of 4 bytes
+void CompressLZ(span<const std::byte> srcData, vector<std::byte>& outData)
+{
+	constexpr size_t noPosition = numeric_limits<size_t>::max();
+
+	const uint8_t* src = (const uint8_t*)srcData.data();
+	const size_t srcSize = srcData.size();
+
+	outData.clear();
+	outData.reserve(srcSize + srcSize / 255 + 16);
+
+	vector<size_t> lastPositions(1ull << s_lzHashBits, noPosition);
+
+	size_t anchor = 0;
+	size_t pos = 0;
+	while (pos + s_lzMinMatch <= srcSize)
+	{
+		const uint32_t sequence = Load32(src + pos);
+		const uint32_t hash = (sequence * 2654435761u) >> (32 - s_lzHashBits);
+
+		const size_t candidate = lastPositions[hash];
+		lastPositions[hash] = pos;
+
+		if (candidate == noPosition || pos - candidate > s_lzMaxOffset || Load32(src + candidate) != sequence)
+		{
+			++pos;
+			continue;
+		}
+
+		size_t matchLength = s_lzMinMatch;
+		while (pos + matchLength < srcSize && src[candidate + matchLength] == src[pos + matchLength])
+		{
+			++matchLength;
+		}
+
+		WriteLZSequence(outData, src + anchor, pos - anchor, matchLength, pos - candidate);
+
+		pos += matchLength;
+		anchor = pos;
+	}
+
+	WriteLZSequence(outData, src + anchor, srcSize - anchor, 0, 0);
+}
+
+
+// Checks every length and offset against both buffers, so a corrupt entry fails rather than overrunning them
+bool DecompressLZ(span<const std::byte> srcData, span<std::byte> dstData)
+{
+	const uint8_t* src = (const uint8_t*)srcData.data();
+	const uint8_t* const srcEnd = src + srcData.size();
+	uint8_t* const dstBegin = (uint8_t*)dstData.data();
+	uint8_t* const dstEnd = dstBegin + dstData.size();
+	uint8_t* dst = dstBegin;
+
+	auto ReadLength = [&src, srcEnd](size_t& length)
+	{
+		uint8_t value = 255;
+		while (value == 255)
+		{
+			if (src == srcEnd)
+			{
+				return false;
+			}
+			value = *src++;
+			length += value;
+		}
+		return true;
+	};
+
+	while (src < srcEnd)
+	{
+		const uint8_t token = *src++;
+
+		size_t numLiterals = token >> 4;
+		if (numLiterals == 15 && !ReadLength(numLiterals))
+		{
+			return false;
+		}
+
+		if (numLiterals > (size_t)(srcEnd - src) || numLiterals > (size_t)(dstEnd - dst))
+		{
+			return false;
+		}
+
+		if (numLiterals > 0)
+		{
+			memcpy(dst, src, numLiterals);
+		}
+		src += numLiterals;
+		dst += numLiterals;
+
+		// The last sequence has no match
+		if (src == srcEnd)
+		{
+			break;
+		}
+
+		if (srcEnd - src < 2)
+		{
+			return false;
+		}
+
+		const size_t matchOffset = (size_t)src[0] | ((size_t)src[1] << 8);
+		src += 2;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(matchLength))
+		{
+			return false;
+		}
+		matchLength += s_lzMinMatch;
+
+		if (matchOffset == 0 || matchOffset > (size_t)(dst - dstBegin) || matchLength > (size_t)(dstEnd - dst))
+		{
+			return false;
+		}
+
+		const uint8_t* match = dst - matchOffset;
+		if (matchOffset >= matchLength)
+		{
+			memcpy(dst, match, matchLength);
+		}
+		else
+		{
+			// Overlapping matches repeat the last matchOffset bytes
+			for (size_t i = 0; i < matchLength; ++i)
+			{
+				dst[i] = match[i];
+			}
+		}
+		dst += matchLength;
+	}
+
+	return dst == dstEnd;
+}
+
+
+bool WritePadding(ostream& outFile, uint64_t endOffset)
+{
+	static const char s_zeros[4096]{};
+
+	for (uint64_t offset = (uint64_t)outFile.tellp(); offset < endOffset; )
+	{
+		const uint64_t numBytes = min<uint64_t>(endOffset - offset, sizeof(s_zeros));
+		outFile.write(s_zeros, (streamsize)numBytes);
+		offset += numBytes;
+	}
+	return (bool)outFile;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+bool BuildAssetArchive(const AssetArchiveBuildDesc& desc, AssetArchiveBuildStats* outStats)
+{
+	vector<filesystem::path> files = desc.files;
+	if (files.empty())
+	{
+		error_code ec;
+		for (const auto& dirEntry : filesystem::recursive_directory_iterator(desc.rootPath, ec))
+		{
+			if (dirEntry.is_regular_file())
+			{
+				files.push_back(dirEntry.path().lexically_relative(desc.rootPath));
+			}
+		}
+
+		if (ec)
+		{
+			LogWarning(LogFileSystem) << "Failed to list the files in " << desc.rootPath.string() << endl;
+			return false;
+		}
+	}
+
+	// Sorted by name, so that the same files always build the same archive
+	vector<pair<string, filesystem::path>> namedFiles;
+	namedFiles.reserve(files.size());
+	for (const auto& file : files)
+	{
+		namedFiles.emplace_back(AssetArchive::NormalizePath(file.string()), desc.rootPath / file);
+	}
+	sort(namedFiles.begin(), namedFiles.end());
+
+	for (size_t i = 1; i < namedFiles.size(); ++i)
+	{
+		if (namedFiles[i].first == namedFiles[i - 1].first)
+		{
+			LogWarning(LogFileSystem) << "Archive " << desc.archiveFileName << " would hold " << namedFiles[i].first << " twice" << endl;
+			return false;
+		}
+	}
+
+	if (namedFiles.size() >= numeric_limits<uint32_t>::max() / 2)
+	{
+		return false;
+	}
+
+	// The tables go first, so that opening the archive only touches its first pages
+	FileHeader header{};
+	header.numEntries = (uint32_t)namedFiles.size();
+	header.numBuckets = bit_ceil(max(2u * header.numEntries, 1u));
+
+	string names;
+	vector<FileEntry> entries(namedFiles.size());
+	for (size_t i = 0; i < namedFiles.size(); ++i)
+	{
+		const string& name = namedFiles[i].first;
+		entries[i].pathHash = Utility::HashStable(name.data(), name.size());
+		entries[i].nameOffset = (uint32_t)names.size();
+		entries[i].nameLength = (uint32_t)name.size();
+		names += name;
+	}
+
+	header.entryTable = FileRange{ Math::AlignUp(sizeof(FileHeader), alignof(FileEntry)), sizeof(FileEntry) * entries.size() };
+	header.bucketTable = FileRange{ header.entryTable.offset + header.entryTable.size, sizeof(uint32_t) * header.numBuckets };
+	header.nameTable = FileRange{ header.bucketTable.offset + header.bucketTable.size, names.size() };
+
+	if (names.size() > numeric_limits<uint32_t>::max())
+	{
+		return false;
+	}
+
+	vector<uint32_t> buckets(header.numBuckets, 0);
+	for (uint32_t i = 0; i < header.numEntries; ++i)
+	{
+		uint32_t bucket = (uint32_t)entries[i].pathHash & (header.numBuckets - 1);
+		while (buckets[bucket] != 0)
+		{
+			bucket = (bucket + 1) & (header.numBuckets - 1);
+		}
+		buckets[bucket] = i + 1;
+	}
+
+	AssetArchiveBuildStats stats{ .numEntries = header.numEntries };
+
+	const bool written = FileSystem::WriteFileAtomic(desc.archiveFileName, [&](ostream& outFile)
+		{
+			vector<std::byte> compressedData;
+			for (size_t i = 0; i < namedFiles.size(); ++i)
+			{
+				FileEntry& entry = entries[i];
+
+				const uint64_t offset = Math::AlignUp(max<uint64_t>((uint64_t)outFile.tellp(), header.nameTable.offset + header.nameTable.size), s_entryAlignment);
+				if (!WritePadding(outFile, offset))
+				{
+					return false;
+				}
+
+				// Empty files can't be mapped, and don't need to be
+				error_code ec;
+				const uint64_t fileSize = (uint64_t)filesystem::file_size(namedFiles[i].second, ec);
+
+				MappedFile sourceFile;
+				if (ec || (fileSize > 0 && !sourceFile.Open(namedFiles[i].second.string())))
+				{
+					LogWarning(LogFileSystem) << "Failed to read " << namedFiles[i].second.string() << " into archive " << desc.archiveFileName << endl;
+					return false;
+				}
+
+				span<const std::byte> data = sourceFile.GetSpan();
+				entry.size = data.size();
+
+				if (desc.compress && !data.empty())
+				{
+					CompressLZ(data, compressedData);
+					if (compressedData.size() <= data.size() - data.size() / 8)
+					{
+						data = compressedData;
+						entry.compression = EntryCompression::LZ;
+						++stats.numCompressedEntries;
+					}
+				}
+
+				entry.data = FileRange{ offset, data.size() };
+				outFile.write((const char*)data.data(), (streamsize)data.size());
+
+				stats.totalBytes += entry.size;
+				stats.storedBytes += entry.data.size;
+			}
+
+			header.fileSize = max<uint64_t>((uint64_t)outFile.tellp(), header.nameTable.offset + header.nameTable.size);
+			if (!WritePadding(outFile, header.fileSize))
+			{
+				return false;
+			}
+
+			outFile.seekp(0);
+			outFile.write((const char*)&header, sizeof(header));
+			outFile.seekp((streamoff)header.entryTable.offset);
+			outFile.write((const char*)entries.data(), (streamsize)header.entryTable.size);
+			outFile.write((const char*)buckets.data(), (streamsize)header.bucketTable.size);
+			outFile.write(names.data(), (streamsize)names.size());
+			return true;
+		});
+	if (!written)
+	{
+		return false;
+	}
+
+	if (outStats != nullptr)
+	{
+		*outStats = stats;
+	}
+
+	return true;
+}
+
+
+AssetArchive::~AssetArchive()
+{
+	Close();
+}
+
+
+bool AssetArchive::Open(const string& fileName)
+{
+	Close();
+
+	auto file = make_shared<MappedFile>();
+	if (!file->Open(fileName) || file->GetSize() < sizeof(FileHeader))
+	{
+		return false;
+	}
+
+	const FileHeader& header = *(const FileHeader*)file->GetData();
+	const uint64_t fileSize = file->GetSize();
+
+	if (header.magic != s_archiveMagic ||
+		header.version != s_archiveVersion ||
+		header.fileSize != fileSize)
+	{
+		return false;
+	}
+
+	if (!has_single_bit(header.numBuckets) ||
+		header.numBuckets <= header.numEntries ||
+		!IsValid(header.entryTable, fileSize, alignof(FileEntry)) ||
+		header.entryTable.size != sizeof(FileEntry) * header.numEntries ||
+		!IsValid(header.bucketTable, fileSize, alignof(uint32_t)) ||
+		header.bucketTable.size != sizeof(uint32_t) * header.numBuckets ||
+		!IsValid(header.nameTable, fileSize))
+	{
+		return false;
+	}
+
+	// Validated once here, so that lookups and reads can trust the tables
+	const FileEntry* entries = (const FileEntry*)(file->GetData() + header.entryTable.offset);
+	for (uint32_t i = 0; i < header.numEntries; ++i)
+	{
+		const FileEntry& entry = entries[i];
+		if (!IsValid(entry.data, fileSize) ||
+			entry.nameOffset > header.nameTable.size ||
+			entry.nameLength > header.nameTable.size - entry.nameOffset ||
+			entry.size > (uint64_t)numeric_limits<size_t>::max())
+		{
+			return false;
+		}
+
+		// Each byte of an LZ stream adds at most 255 bytes of output, which also bounds what a corrupt entry can allocate
+		if (entry.compression == EntryCompression::None ? entry.data.size != entry.size :
+			(entry.compression != EntryCompression::LZ || entry.size / 255 > entry.data.size))
+		{
+			return false;
+		}
+	}
+
+	const uint32_t* buckets = (const uint32_t*)(file->GetData() + header.bucketTable.offset);
+	for (uint32_t i = 0; i < header.numBuckets; ++i)
+	{
+		if (buckets[i] > header.numEntries)
+		{
+			return false;
+		}
+	}
+
+	m_fileName = fileName;
+	m_file = move(file);
+	m_entries = entries;
+	m_buckets = buckets;
+	m_names = (const char*)(m_file->GetData() + header.nameTable.offset);
+	m_numEntries = header.numEntries;
+	m_numBuckets = header.numBuckets;
+
+	return true;
+}
+
+
+void AssetArchive::Close()
+{
+	// Data handed out by ReadFile() holds its own reference to the mapping
+	m_fileName.clear();
+	m_file.reset();
+
+	m_entries = nullptr;
+	m_buckets = nullptr;
+	m_names = nullptr;
+	m_numEntries = 0;
+	m_numBuckets = 0;
+}
+
+
+bool AssetArchive::Contains(const string& path) const
+{
+	return FindEntry(NormalizePath(path)) != s_invalidEntry;
+}
+
+
+bool AssetArchive::ReadFile(const string& path, FileData& outData) const
+{
+	const uint32_t entryIndex = FindEntry(NormalizePath(path));
+	if (entryIndex == s_invalidEntry)
+	{
+		return false;
+	}
+
+	const FileEntry& entry = ((const FileEntry*)m_entries)[entryIndex];
+	const std::byte* data = m_file->GetData() + entry.data.offset;
+
+	if (entry.compression == EntryCompression::None)
+	{
+		outData = FileData{ m_file, data, (size_t)entry.size };
+		return true;
+	}
+
+	shared_ptr<std::byte[]> decompressedData(new std::byte[(size_t)entry.size]);
+	if (!DecompressLZ({ data, (size_t)entry.data.size }, { decompressedData.get(), (size_t)entry.size }))
+	{
+		LogWarning(LogFileSystem) << "Failed to decompress " << path << " from archive " << m_fileName << endl;
+		return false;
+	}
+
+	outData = FileData{ decompressedData, decompressedData.get(), (size_t)entry.size };
+	return true;
+}
+
+
+string AssetArchive::NormalizePath(const string& path)
+{
+	string normalized;
+	normalized.reserve(path.size());
+
+	size_t segmentStart = 0;
+	while (segmentStart <= path.size())
+	{
+		size_t segmentEnd = path.find_first_of("/\\", segmentStart);
+		if (segmentEnd == string::npos)
+		{
+			segmentEnd = path.size();
+		}
+
+		const string_view segment{ path.data() + segmentStart, segmentEnd - segmentStart };
+		const size_t lastSeparator = normalized.rfind('/');
+		const string_view lastSegment = lastSeparator == string::npos ? string_view{ normalized } : string_view{ normalized }.substr(lastSeparator + 1);
+
+		if (segment.empty() || segment == ".")
+		{
+			// Skip
+		}
+		else if (segment == ".." && !normalized.empty() && lastSegment != "..")
+		{
+			normalized.resize(lastSeparator == string::npos ? 0 : lastSeparator);
+		}
+		else
+		{
+			if (!normalized.empty())
+			{
+				normalized += '/';
+			}
+			for (char c : segment)
+			{
+				normalized += (char)tolower((unsigned char)c);
+			}
+		}
+
+		segmentStart = segmentEnd + 1;
+	}
+
+	return normalized;
+}
+
+
+uint32_t AssetArchive::FindEntry(const string& normalizedPath) const noexcept
+{
+	if (m_numBuckets == 0)
+	{
+		return s_invalidEntry;
+	}
+
+	const FileEntry* entries = (const FileEntry*)m_entries;
+	const uint64_t hash = Utility::HashStable(normalizedPath.data(), normalizedPath.size());
+	const uint32_t mask = m_numBuckets - 1;
+
+	uint32_t bucket = (uint32_t)hash & mask;
+	for (uint32_t i = 0; i < m_numBuckets; ++i)
+	{
+		const uint32_t slot = m_buckets[bucket];
+		if (slot == 0)
+		{
+			break;
+		}
+
+		// The hash only narrows it down, so compare the full path
+		const FileEntry& entry = entries[slot - 1];
+		if (entry.pathHash == hash && string_view{ m_names + entry.nameOffset, entry.nameLength } == normalizedPath)
+		{
+			return slot - 1;
+		}
+
+		bucket = (bucket + 1) & mask;
+	}
+
+	return s_invalidEntry;
+}
+
+} // namespace Luna
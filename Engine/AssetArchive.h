@@ -0,0 +1,88 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "FileSystem.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+class MappedFile;
+
+
+struct AssetArchiveBuildDesc
+{
+	std::string archiveFileName;
+	std::filesystem::path rootPath;				// Entries are named by their path relative to this
+	std::vector<std::filesystem::path> files;	// Relative to rootPath, or every file under rootPath if empty
+	bool compress{ true };						// Entries that don't shrink by at least 1/8 are stored as is
+};
+
+
+struct AssetArchiveBuildStats
+{
+	uint32_t numEntries{ 0 };
+	uint32_t numCompressedEntries{ 0 };
+	uint64_t totalBytes{ 0 };	// Of the files, before compression
+	uint64_t storedBytes{ 0 };	// Of the entries, after compression, not counting alignment
+};
+
+
+// Packs files into an archive for AssetArchive.  Entries start on 64KB boundaries, which is the allocation
+// granularity of file views on Windows, so any entry can also be mapped on its own.
+bool BuildAssetArchive(const AssetArchiveBuildDesc& desc, AssetArchiveBuildStats* outStats = nullptr);
+
+
+// Read-only pack archive, mapped into memory.  Entries are found by a hashed table of contents, so lookups never
+// touch the file system.  Paths are matched without regard to case or the direction of the slashes.
+class AssetArchive : NonCopyable
+{
+public:
+	AssetArchive() = default;
+	~AssetArchive();
+
+	bool Open(const std::string& fileName);
+	void Close();
+
+	bool IsOpen() const noexcept { return m_file != nullptr; }
+	const std::string& GetFileName() const noexcept { return m_fileName; }
+	uint32_t GetNumEntries() const noexcept { return m_numEntries; }
+
+	bool Contains(const std::string& path) const;
+
+	// Stored entries point straight into the mapping, which outData keeps open.  Compressed entries are decoded
+	// into a buffer that outData owns.
+	bool ReadFile(const std::string& path, FileData& outData) const;
+
+	// Lower case, with forward slashes, and without "." or ".." segments
+	static std::string NormalizePath(const std::string& path);
+
+private:
+	// Index of the entry, or s_invalidEntry
+	uint32_t FindEntry(const std::string& normalizedPath) const noexcept;
+
+	static constexpr uint32_t s_invalidEntry = ~0u;
+
+private:
+	std::string m_fileName;
+	std::shared_ptr<MappedFile> m_file;
+
+	// Table of contents, in the mapping
+	const void* m_entries{ nullptr };
+	const uint32_t* m_buckets{ nullptr };
+	const char* m_names{ nullptr };
+	uint32_t m_numEntries{ 0 };
+	uint32_t m_numBuckets{ 0 };
+};
+
+} // namespace Luna
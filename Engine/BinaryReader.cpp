@@ -57,34 +57,45 @@ HRESULT BinaryReader::ReadEntireFile(const string& fileName, unique_ptr<std::byt
 
 	fileSize = fileInfo.EndOfFile;
 
-	// File is too big for 32-bit allocation, so reject read.
-	if (fileSize.HighPart > 0)
+	// File is too big to address, so reject read.
+	if ((uint64_t)fileSize.QuadPart > (uint64_t)numeric_limits<size_t>::max())
 	{
 		return E_FAIL;
 	}
 
+	const size_t totalBytes = (size_t)fileSize.QuadPart;
+
 	// Create enough space for the file data.
-	data.reset(new std::byte[fileSize.LowPart]);
+	data.reset(new std::byte[totalBytes]);
 
 	if (!data)
 	{
 		return E_OUTOFMEMORY;
 	}
 
-	// Read the data in.
-	DWORD bytesRead{ 0 };
+	// Read the data in.  ReadFile() takes a 32-bit size, so files over 4GB are read in chunks.
+	constexpr size_t maxChunkBytes = 1ull << 30;
 
-	if (!ReadFile(hFile.get(), data.get(), fileSize.LowPart, &bytesRead, nullptr))
+	size_t totalBytesRead{ 0 };
+	while (totalBytesRead < totalBytes)
 	{
-		return HRESULT_FROM_WIN32(GetLastError());
-	}
+		const DWORD chunkBytes = (DWORD)min(totalBytes - totalBytesRead, maxChunkBytes);
 
-	if (bytesRead < fileSize.LowPart)
-	{
-		return E_FAIL;
+		DWORD bytesRead{ 0 };
+		if (!ReadFile(hFile.get(), data.get() + totalBytesRead, chunkBytes, &bytesRead, nullptr))
+		{
+			return HRESULT_FROM_WIN32(GetLastError());
+		}
+
+		if (bytesRead < chunkBytes)
+		{
+			return E_FAIL;
+		}
+
+		totalBytesRead += bytesRead;
 	}
 
-	*dataSize = bytesRead;
+	*dataSize = totalBytes;
 
 	return S_OK;
 }
\ No newline at end of file
@@ -12,6 +12,11 @@
 
 #include <type_traits>
 
+
+namespace Luna
+{
+
+// Specialize EnableBitmaskOperators in namespace Luna to give an enum class these operators
 template<typename E>
 struct EnableBitmaskOperators
 {
@@ -46,6 +51,15 @@ operator^(E lhs, E rhs) noexcept
 }
 
 
+template <typename E>
+constexpr typename std::enable_if<EnableBitmaskOperators<E>::enable, E>::type
+operator~(E value) noexcept
+{
+	using underlying = std::underlying_type_t<E>;
+	return static_cast<E>(~static_cast<underlying>(value));
+}
+
+
 template <typename E>
 constexpr typename std::enable_if<EnableBitmaskOperators<E>::enable, E&>::type
 operator|=(E& lhs, E rhs) noexcept
@@ -141,4 +155,6 @@ RemoveFlag(E bitmask, E flag) noexcept
 	using underlying = std::underlying_type_t<E>;
 	bitmask &= static_cast<E>(~static_cast<underlying>(flag));
 	return bitmask;
-}
\ No newline at end of file
+}
+
+} // namespace Luna
\ No newline at end of file
@@ -17,7 +17,8 @@ enum class GraphicsApi
 {
 	Unknown,
 	D3D12,
-	Vulkan
+	Vulkan,
+	Null
 };
 
 inline std::string GraphicsApiToString(GraphicsApi graphicsApi)
@@ -28,6 +29,8 @@ inline std::string GraphicsApiToString(GraphicsApi graphicsApi)
 		return "D3D12";
 	case GraphicsApi::Vulkan:
 		return "Vulkan";
+	case GraphicsApi::Null:
+		return "Null";
 	default:
 		return "Unknown";
 	}
@@ -0,0 +1,125 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "CpuFeatures.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+using namespace std;
+
+
+namespace
+{
+
+struct CpuFeatures
+{
+	bool hasSSE41{ false };
+	bool hasAVX{ false };
+	bool hasAVX2{ false };
+};
+
+
+#if defined(_M_X64) || defined(__x86_64__)
+void CpuId(uint32_t leaf, uint32_t subLeaf, uint32_t outInfo[4]) noexcept
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, (int)leaf, (int)subLeaf);
+	for (int i = 0; i < 4; ++i)
+	{
+		outInfo[i] = (uint32_t)info[i];
+	}
+#else
+	__cpuid_count(leaf, subLeaf, outInfo[0], outInfo[1], outInfo[2], outInfo[3]);
+#endif
+}
+
+
+// XCR0, the register of state components the OS saves on context switches
+uint64_t GetEnabledXState() noexcept
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t low{ 0 };
+	uint32_t high{ 0 };
+	__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((uint64_t)high << 32) | low;
+#endif
+}
+#endif
+
+
+CpuFeatures DetectCpuFeatures() noexcept
+{
+	CpuFeatures features{};
+
+#if defined(_M_X64) || defined(__x86_64__)
+	uint32_t info[4];
+	CpuId(0, 0, info);
+	const uint32_t maxLeaf = info[0];
+
+	CpuId(1, 0, info);
+	features.hasSSE41 = (info[2] & (1u << 19)) != 0;
+
+	const bool hasOSXSave = (info[2] & (1u << 27)) != 0;
+	const bool hasYmmState = hasOSXSave && (GetEnabledXState() & 0x6) == 0x6;
+
+	features.hasAVX = hasYmmState && (info[2] & (1u << 28)) != 0;
+
+	if (maxLeaf >= 7)
+	{
+		CpuId(7, 0, info);
+		features.hasAVX2 = features.hasAVX && (info[1] & (1u << 5)) != 0;
+	}
+#endif
+
+	return features;
+}
+
+
+const CpuFeatures& GetCpuFeatures() noexcept
+{
+	static const CpuFeatures s_features = DetectCpuFeatures();
+	return s_features;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+bool HasSSE41() noexcept
+{
+	return GetCpuFeatures().hasSSE41;
+}
+
+
+bool HasAVX() noexcept
+{
+	return GetCpuFeatures().hasAVX;
+}
+
+
+bool HasAVX2() noexcept
+{
+	return GetCpuFeatures().hasAVX2;
+}
+
+} // namespace Luna
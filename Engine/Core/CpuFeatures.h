@@ -0,0 +1,38 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+// Runtime checks for the x64 instruction sets beyond SSE2, which every x64 CPU has.  These build with MSVC,
+// GCC and Clang, and are false on other architectures.  Functions that use SSE4.1, AVX or AVX2 intrinsics must be
+// marked with LUNA_TARGET_SSE41, LUNA_TARGET_AVX or LUNA_TARGET_AVX2, which GCC and Clang need in order to compile
+// them without building the whole file for those instruction sets.
+
+#if defined(_MSC_VER)
+#define LUNA_TARGET_SSE41
+#define LUNA_TARGET_AVX
+#define LUNA_TARGET_AVX2
+#else
+#define LUNA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define LUNA_TARGET_AVX __attribute__((target("avx")))
+#define LUNA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+namespace Luna
+{
+
+bool HasSSE41() noexcept;
+
+// Both also check that the OS saves the upper halves of the YMM registers.  The results are detected once.
+bool HasAVX() noexcept;
+bool HasAVX2() noexcept;
+
+} // namespace Luna
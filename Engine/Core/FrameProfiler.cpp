@@ -0,0 +1,514 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FrameProfiler.h"
+
+using namespace std;
+
+
+namespace
+{
+
+Luna::FrameProfiler* g_frameProfiler{ nullptr };
+std::atomic<uint64_t> g_nextProfilerInstanceId{ 1 };
+
+// Must be a power of 2
+constexpr uint32_t s_threadBufferCapacity = 16384;
+constexpr size_t s_maxHistoryFrames = 120;
+// Marks a scope that was opened while the profiler was disabled, so that its EndScope() still pairs up
+constexpr uint32_t s_disabledNameId = ~0u;
+
+
+uint64_t SteadyClockNow()
+{
+	return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void WriteJsonString(ostream& stream, const string& str)
+{
+	stream << '"';
+	for (const char c : str)
+	{
+		switch (c)
+		{
+		case '"':	stream << "\\\""; break;
+		case '\\':	stream << "\\\\"; break;
+		case '\n':	stream << "\\n"; break;
+		case '\r':	stream << "\\r"; break;
+		case '\t':	stream << "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				char escaped[8]{};
+				snprintf(escaped, sizeof(escaped), "\\u%04x", (uint32_t)(unsigned char)c);
+				stream << escaped;
+			}
+			else
+			{
+				stream << c;
+			}
+			break;
+		}
+	}
+	stream << '"';
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+// Single-producer, single-consumer ring of completed scopes.  Only the owning thread writes events, and only
+// EndFrame() reads them.
+struct FrameProfiler::ThreadBuffer
+{
+	struct OpenScope
+	{
+		uint32_t nameId{ 0 };
+		uint64_t start{ 0 };
+	};
+
+	uint32_t threadIndex{ 0 };
+	unique_ptr<ProfileEvent[]> events{ make_unique<ProfileEvent[]>(s_threadBufferCapacity) };
+	alignas(64) atomic<uint64_t> writePos{ 0 };
+	alignas(64) atomic<uint64_t> readPos{ 0 };
+
+	// Owning thread only
+	vector<OpenScope> openScopes;
+	unordered_map<string, uint32_t> nameCache;
+};
+
+
+FrameProfiler::FrameProfiler(ProfilerClock clock, uint64_t clockFrequency)
+	: m_clock{ clock ? clock : SteadyClockNow }
+	, m_clockFrequency{ clock ? clockFrequency : 1'000'000'000ull }
+	, m_instanceId{ g_nextProfilerInstanceId.fetch_add(1) }
+{
+	assert(m_clockFrequency > 0);
+
+	m_cpuTree.emplace_back();
+	m_gpuTree.emplace_back();
+
+	m_frameStart = m_clock();
+
+	assert(g_frameProfiler == nullptr);
+	g_frameProfiler = this;
+}
+
+
+FrameProfiler::~FrameProfiler()
+{
+	g_frameProfiler = nullptr;
+}
+
+
+uint32_t FrameProfiler::RegisterName(const string& name)
+{
+	lock_guard lock(m_nameMutex);
+
+	auto it = m_nameMap.find(name);
+	if (it != m_nameMap.end())
+	{
+		return it->second;
+	}
+
+	const uint32_t nameId = (uint32_t)m_names.size();
+	m_names.push_back(name);
+	m_nameMap.emplace(name, nameId);
+
+	return nameId;
+}
+
+
+string FrameProfiler::GetName(uint32_t nameId) const
+{
+	lock_guard lock(m_nameMutex);
+
+	return nameId < m_names.size() ? m_names[nameId] : string{};
+}
+
+
+void FrameProfiler::BeginScope(const string& name)
+{
+	ThreadBuffer* threadBuffer = GetThreadBuffer();
+
+	if (!IsEnabled())
+	{
+		threadBuffer->openScopes.push_back({ s_disabledNameId, 0 });
+		return;
+	}
+
+	uint32_t nameId{ 0 };
+	auto it = threadBuffer->nameCache.find(name);
+	if (it != threadBuffer->nameCache.end())
+	{
+		nameId = it->second;
+	}
+	else
+	{
+		nameId = RegisterName(name);
+		threadBuffer->nameCache.emplace(name, nameId);
+	}
+
+	threadBuffer->openScopes.push_back({ nameId, m_clock() });
+}
+
+
+void FrameProfiler::BeginScope(uint32_t nameId)
+{
+	ThreadBuffer* threadBuffer = GetThreadBuffer();
+
+	if (!IsEnabled())
+	{
+		threadBuffer->openScopes.push_back({ s_disabledNameId, 0 });
+		return;
+	}
+
+	threadBuffer->openScopes.push_back({ nameId, m_clock() });
+}
+
+
+void FrameProfiler::EndScope()
+{
+	ThreadBuffer* threadBuffer = GetThreadBuffer();
+
+	if (threadBuffer->openScopes.empty())
+	{
+		return;
+	}
+
+	const ThreadBuffer::OpenScope scope = threadBuffer->openScopes.back();
+	threadBuffer->openScopes.pop_back();
+
+	if (scope.nameId == s_disabledNameId)
+	{
+		return;
+	}
+
+	const uint64_t writePos = threadBuffer->writePos.load(memory_order_relaxed);
+	const uint64_t readPos = threadBuffer->readPos.load(memory_order_acquire);
+	if (writePos - readPos >= s_threadBufferCapacity)
+	{
+		m_numDroppedEvents.fetch_add(1, memory_order_relaxed);
+		return;
+	}
+
+	ProfileEvent& event = threadBuffer->events[writePos & (s_threadBufferCapacity - 1)];
+	event.nameId = scope.nameId;
+	event.threadIndex = threadBuffer->threadIndex;
+	event.depth = (uint32_t)threadBuffer->openScopes.size();
+	event.start = scope.start;
+	event.end = m_clock();
+
+	threadBuffer->writePos.store(writePos + 1, memory_order_release);
+}
+
+
+void FrameProfiler::EndFrame()
+{
+	const uint64_t frameEnd = m_clock();
+
+	ProfileFrame frame{
+		.frameNumber	= m_frameNumber,
+		.start			= m_frameStart,
+		.end			= frameEnd
+	};
+
+	{
+		lock_guard lock(m_threadMutex);
+		for (auto& threadBuffer : m_threadBuffers)
+		{
+			Drain(*threadBuffer, frame.cpuEvents);
+		}
+	}
+
+	UpdateTree(m_cpuTree, frame.cpuEvents);
+
+	m_history.push_back(move(frame));
+	while (m_history.size() > s_maxHistoryFrames)
+	{
+		m_history.pop_front();
+	}
+
+	++m_frameNumber;
+	m_frameStart = frameEnd;
+}
+
+
+void FrameProfiler::AddGpuEvents(uint64_t frameNumber, span<const ProfileEvent> events)
+{
+	for (auto it = m_history.rbegin(); it != m_history.rend(); ++it)
+	{
+		if (it->frameNumber == frameNumber)
+		{
+			assert(!it->hasGpuEvents);
+
+			it->gpuEvents.assign(events.begin(), events.end());
+			it->hasGpuEvents = true;
+
+			UpdateTree(m_gpuTree, it->gpuEvents);
+			return;
+		}
+	}
+}
+
+
+const vector<ProfileNode>& FrameProfiler::GetTree(ProfileTimeline timeline) const
+{
+	return timeline == ProfileTimeline::Cpu ? m_cpuTree : m_gpuTree;
+}
+
+
+void FrameProfiler::ResetStats()
+{
+	for (auto* tree : { &m_cpuTree, &m_gpuTree })
+	{
+		for (auto& node : *tree)
+		{
+			node.minMs = 0.0;
+			node.maxMs = 0.0;
+			node.totalMs = 0.0;
+			node.numFrames = 0;
+		}
+	}
+}
+
+
+void FrameProfiler::ExportChromeTrace(ostream& stream) const
+{
+	const uint64_t baseTime = m_history.empty() ? 0 : m_history.front().start;
+	const double ticksToUs = 1'000'000.0 / (double)m_clockFrequency;
+
+	bool firstEvent = true;
+	auto BeginEvent = [&stream, &firstEvent]()
+		{
+			stream << (firstEvent ? "\n" : ",\n");
+			firstEvent = false;
+		};
+
+	auto WriteMetadata = [&](uint32_t pid, uint32_t tid, const char* type, const string& name)
+		{
+			BeginEvent();
+			stream << "{\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"name\":\"" << type << "\",\"args\":{\"name\":";
+			WriteJsonString(stream, name);
+			stream << "}}";
+		};
+
+	auto WriteSpan = [&](uint32_t pid, uint32_t tid, const string& name, uint64_t start, uint64_t end)
+		{
+			const double ts = (double)(start - baseTime) * ticksToUs;
+			const double dur = (double)(end >= start ? end - start : 0) * ticksToUs;
+
+			BeginEvent();
+			stream << "{\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"name\":";
+			WriteJsonString(stream, name);
+			char times[64]{};
+			snprintf(times, sizeof(times), ",\"ts\":%.3f,\"dur\":%.3f}", ts, dur);
+			stream << times;
+		};
+
+	// CPU threads are offset by one, to leave track 0 for the frame markers
+	constexpr uint32_t cpuPid = 1;
+	constexpr uint32_t gpuPid = 2;
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	WriteMetadata(cpuPid, 0, "process_name", "CPU");
+	WriteMetadata(gpuPid, 0, "process_name", "GPU");
+	WriteMetadata(cpuPid, 0, "thread_name", "Frames");
+
+	set<uint32_t> cpuThreads;
+	set<uint32_t> gpuQueues;
+
+	for (const auto& frame : m_history)
+	{
+		WriteSpan(cpuPid, 0, "Frame " + to_string(frame.frameNumber), frame.start, frame.end);
+
+		for (const auto& event : frame.cpuEvents)
+		{
+			cpuThreads.insert(event.threadIndex);
+			WriteSpan(cpuPid, event.threadIndex + 1, GetName(event.nameId), event.start, event.end);
+		}
+
+		for (const auto& event : frame.gpuEvents)
+		{
+			gpuQueues.insert(event.threadIndex);
+			WriteSpan(gpuPid, event.threadIndex, GetName(event.nameId), event.start, event.end);
+		}
+	}
+
+	for (uint32_t threadIndex : cpuThreads)
+	{
+		WriteMetadata(cpuPid, threadIndex + 1, "thread_name", "Thread " + to_string(threadIndex));
+	}
+
+	for (uint32_t queueIndex : gpuQueues)
+	{
+		WriteMetadata(gpuPid, queueIndex, "thread_name", "Queue " + to_string(queueIndex));
+	}
+
+	stream << "\n]}\n";
+}
+
+
+bool FrameProfiler::ExportChromeTrace(const string& filename) const
+{
+	ofstream outFile(filename, ios::out | ios::trunc);
+	if (!outFile)
+	{
+		return false;
+	}
+
+	ExportChromeTrace(outFile);
+
+	return outFile.good();
+}
+
+
+FrameProfiler::ThreadBuffer* FrameProfiler::GetThreadBuffer()
+{
+	// Cached per thread, and checked against the instance, in case the profiler has been recreated
+	static thread_local ThreadBuffer* t_threadBuffer{ nullptr };
+	static thread_local uint64_t t_instanceId{ 0 };
+
+	if (t_instanceId != m_instanceId)
+	{
+		auto threadBuffer = make_unique<ThreadBuffer>();
+
+		lock_guard lock(m_threadMutex);
+		threadBuffer->threadIndex = (uint32_t)m_threadBuffers.size();
+		t_threadBuffer = threadBuffer.get();
+		t_instanceId = m_instanceId;
+		m_threadBuffers.push_back(move(threadBuffer));
+	}
+
+	return t_threadBuffer;
+}
+
+
+void FrameProfiler::Drain(ThreadBuffer& threadBuffer, vector<ProfileEvent>& outEvents)
+{
+	const uint64_t readPos = threadBuffer.readPos.load(memory_order_relaxed);
+	const uint64_t writePos = threadBuffer.writePos.load(memory_order_acquire);
+
+	for (uint64_t pos = readPos; pos < writePos; ++pos)
+	{
+		outEvents.push_back(threadBuffer.events[pos & (s_threadBufferCapacity - 1)]);
+	}
+
+	threadBuffer.readPos.store(writePos, memory_order_release);
+}
+
+
+void FrameProfiler::UpdateTree(vector<ProfileNode>& tree, vector<ProfileEvent>& events)
+{
+	// Within a thread, a parent starts no later than its children, so after sorting, each event's parent is
+	// the most recent event one level up
+	sort(events.begin(), events.end(),
+		[](const ProfileEvent& a, const ProfileEvent& b)
+		{
+			if (a.threadIndex != b.threadIndex)
+			{
+				return a.threadIndex < b.threadIndex;
+			}
+			if (a.start != b.start)
+			{
+				return a.start < b.start;
+			}
+			return a.depth < b.depth;
+		});
+
+	m_frameTicks.assign(tree.size(), 0);
+	m_frameCalls.assign(tree.size(), 0);
+
+	uint32_t currentThread = ~0u;
+	for (const auto& event : events)
+	{
+		if (event.threadIndex != currentThread)
+		{
+			currentThread = event.threadIndex;
+			m_scopeStack.clear();
+		}
+
+		// Scopes whose parents started in an earlier frame attach to the deepest parent still known
+		if (m_scopeStack.size() > event.depth)
+		{
+			m_scopeStack.resize(event.depth);
+		}
+		const uint32_t parent = m_scopeStack.empty() ? 0 : m_scopeStack.back();
+
+		const uint32_t node = FindOrAddChild(tree, parent, event.nameId);
+		if (node >= m_frameTicks.size())
+		{
+			m_frameTicks.resize(node + 1, 0);
+			m_frameCalls.resize(node + 1, 0);
+		}
+
+		m_frameTicks[node] += event.end >= event.start ? event.end - event.start : 0;
+		m_frameCalls[node] += 1;
+
+		m_scopeStack.push_back(node);
+	}
+
+	for (size_t i = 1; i < tree.size(); ++i)
+	{
+		ProfileNode& node = tree[i];
+
+		if (m_frameCalls[i] == 0)
+		{
+			node.lastMs = 0.0;
+			node.lastCalls = 0;
+			continue;
+		}
+
+		const double ms = TicksToMs(m_frameTicks[i]);
+		node.lastMs = ms;
+		node.lastCalls = m_frameCalls[i];
+
+		node.minMs = node.numFrames > 0 ? min(node.minMs, ms) : ms;
+		node.maxMs = node.numFrames > 0 ? max(node.maxMs, ms) : ms;
+		node.totalMs += ms;
+		++node.numFrames;
+	}
+}
+
+
+uint32_t FrameProfiler::FindOrAddChild(vector<ProfileNode>& tree, uint32_t parent, uint32_t nameId)
+{
+	for (uint32_t child : tree[parent].children)
+	{
+		if (tree[child].nameId == nameId)
+		{
+			return child;
+		}
+	}
+
+	const uint32_t node = (uint32_t)tree.size();
+
+	ProfileNode newNode{};
+	newNode.nameId = nameId;
+	newNode.parent = parent;
+	tree.push_back(move(newNode));
+	tree[parent].children.push_back(node);
+
+	return node;
+}
+
+
+FrameProfiler* GetFrameProfiler()
+{
+	return g_frameProfiler;
+}
+
+} // namespace Luna
@@ -0,0 +1,160 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/NonCopyable.h"
+#include "Core/NonMovable.h"
+
+namespace Luna
+{
+
+// Returns the current time in profiler ticks.  Replaceable so that the profiler can be driven by a mock clock.
+using ProfilerClock = uint64_t(*)();
+
+constexpr uint32_t InvalidProfileNode = ~0u;
+
+
+enum class ProfileTimeline : uint8_t
+{
+	Cpu,
+	Gpu
+};
+
+
+// A completed scope.  Times are in profiler ticks, and GPU scopes are converted into the CPU clock's domain.
+struct ProfileEvent
+{
+	uint32_t nameId{ 0 };
+	uint32_t threadIndex{ 0 };	// CPU thread, or GPU queue
+	uint32_t depth{ 0 };
+	uint64_t start{ 0 };
+	uint64_t end{ 0 };
+};
+
+
+struct ProfileFrame
+{
+	uint64_t frameNumber{ 0 };
+	uint64_t start{ 0 };
+	uint64_t end{ 0 };
+	std::vector<ProfileEvent> cpuEvents;
+	std::vector<ProfileEvent> gpuEvents;
+	bool hasGpuEvents{ false };
+};
+
+
+// One scope in the frame tree.  Scopes with the same name under the same parent are merged, across threads.
+struct ProfileNode
+{
+	uint32_t nameId{ 0 };
+	uint32_t parent{ InvalidProfileNode };
+	std::vector<uint32_t> children;
+
+	// Inclusive time and call count for the most recent frame the node appeared in
+	double lastMs{ 0.0 };
+	uint32_t lastCalls{ 0 };
+
+	// Per-frame statistics since the last reset
+	double minMs{ 0.0 };
+	double maxMs{ 0.0 };
+	double totalMs{ 0.0 };
+	uint32_t numFrames{ 0 };
+
+	double GetAvgMs() const noexcept { return numFrames > 0 ? totalMs / numFrames : 0.0; }
+};
+
+
+// Hierarchical frame profiler.  Every thread records nested scopes into its own buffer without locking, and
+// the frame's owner collects them in EndFrame(), builds the frame tree and keeps a short history of raw
+// events for trace export.  GPU scopes are added later, once their timestamps have been read back.
+class FrameProfiler : NonCopyable, NonMovable
+{
+public:
+	// A null clock uses std::chrono::steady_clock, with a frequency of 1GHz
+	explicit FrameProfiler(ProfilerClock clock = nullptr, uint64_t clockFrequency = 0);
+	~FrameProfiler();
+
+	void SetEnabled(bool enabled) noexcept { m_enabled.store(enabled, std::memory_order_relaxed); }
+	bool IsEnabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+
+	uint64_t GetTime() const { return m_clock(); }
+	uint64_t GetClockFrequency() const noexcept { return m_clockFrequency; }
+	double TicksToMs(uint64_t ticks) const noexcept { return 1000.0 * (double)ticks / (double)m_clockFrequency; }
+
+	// Thread-safe
+	uint32_t RegisterName(const std::string& name);
+	std::string GetName(uint32_t nameId) const;
+
+	// Called by the recording thread.  Scopes must nest.
+	void BeginScope(const std::string& name);
+	void BeginScope(uint32_t nameId);
+	void EndScope();
+
+	// Closes the current frame and starts the next one.  Call from one thread only, the same one that reads
+	// the trees and history.
+	void EndFrame();
+
+	// Attaches GPU scopes to a frame that was already closed.  Ignored if the frame is no longer in the history.
+	void AddGpuEvents(uint64_t frameNumber, std::span<const ProfileEvent> events);
+
+	uint64_t GetFrameNumber() const noexcept { return m_frameNumber; }
+
+	const std::vector<ProfileNode>& GetTree(ProfileTimeline timeline) const;
+	const std::deque<ProfileFrame>& GetHistory() const noexcept { return m_history; }
+	uint64_t GetNumDroppedEvents() const noexcept { return m_numDroppedEvents.load(std::memory_order_relaxed); }
+
+	void ResetStats();
+
+	// Writes the frame history in the Chrome trace event format, viewable in chrome://tracing or Perfetto
+	void ExportChromeTrace(std::ostream& stream) const;
+	bool ExportChromeTrace(const std::string& filename) const;
+
+private:
+	struct ThreadBuffer;
+
+	ThreadBuffer* GetThreadBuffer();
+	void Drain(ThreadBuffer& threadBuffer, std::vector<ProfileEvent>& outEvents);
+	void UpdateTree(std::vector<ProfileNode>& tree, std::vector<ProfileEvent>& events);
+	uint32_t FindOrAddChild(std::vector<ProfileNode>& tree, uint32_t parent, uint32_t nameId);
+
+private:
+	ProfilerClock m_clock{ nullptr };
+	uint64_t m_clockFrequency{ 0 };
+	const uint64_t m_instanceId{ 0 };
+	std::atomic<bool> m_enabled{ true };
+
+	mutable std::mutex m_nameMutex;
+	std::vector<std::string> m_names;
+	std::unordered_map<std::string, uint32_t> m_nameMap;
+
+	std::mutex m_threadMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> m_threadBuffers;
+	std::atomic<uint64_t> m_numDroppedEvents{ 0 };
+
+	uint64_t m_frameNumber{ 0 };
+	uint64_t m_frameStart{ 0 };
+
+	// Node 0 is the root of each tree
+	std::vector<ProfileNode> m_cpuTree;
+	std::vector<ProfileNode> m_gpuTree;
+	std::deque<ProfileFrame> m_history;
+	std::vector<uint32_t> m_scopeStack;
+	std::vector<uint64_t> m_frameTicks;
+	std::vector<uint32_t> m_frameCalls;
+};
+
+
+FrameProfiler* GetFrameProfiler();
+
+// Profiler log category
+inline LogCategory LogProfiler{ "LogProfiler" };
+
+} // namespace Luna
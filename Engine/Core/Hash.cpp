@@ -11,10 +11,372 @@
 
 #include "Hash.h"
 
+#ifdef _M_X64
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+
+// Multipliers from xxHash
+const uint64_t s_prime64_1{ 0x9E3779B185EBCA87ull };
+const uint64_t s_prime64_2{ 0xC2B2AE3D27D4EB4Full };
+const uint64_t s_prime64_3{ 0x165667B19E3779F9ull };
+const uint32_t s_prime32_1{ 0x9E3779B1u };
+
+// Long inputs are consumed in 64-byte stripes, eight 64-bit lanes each, and the lanes are scrambled after every
+// block of 16 stripes
+const size_t s_stripeSize{ 64 };
+const size_t s_stripesPerBlock{ 16 };
+const size_t s_maxShortSize{ 64 };
+
+
+struct HashKeys
+{
+	uint64_t stripe[8];	// Mixed into each stripe, and into the scramble
+	uint64_t init[8];	// Starting lanes, and the short-input path
+	uint64_t merge[8];	// Folding the lanes down to one value
+};
+
+
+constexpr uint64_t SplitMix64(uint64_t& state) noexcept
+{
+	state += 0x9E3779B97F4A7C15ull;
+
+	uint64_t z = state;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+
+// Drawn from SplitMix64 rather than typed in, so none of them can be accidentally weak
+constexpr HashKeys MakeHashKeys() noexcept
+{
+	HashKeys keys{};
+	uint64_t state{ s_prime64_3 };
+
+	for (uint64_t& key : keys.stripe) { key = SplitMix64(state); }
+	for (uint64_t& key : keys.init) { key = SplitMix64(state); }
+	for (uint64_t& key : keys.merge) { key = SplitMix64(state); }
+
+	return keys;
+}
+
+alignas(32) constexpr HashKeys s_keys{ MakeHashKeys() };
+
+
+inline uint64_t Read64(const uint8_t* data) noexcept
+{
+	uint64_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+
+inline uint32_t Read32(const uint8_t* data) noexcept
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+
+// Folds the full 128-bit product, so every input bit reaches the result
+inline uint64_t Mul128Fold64(uint64_t a, uint64_t b) noexcept
+{
+#ifdef _M_X64
+	uint64_t high;
+	const uint64_t low = _umul128(a, b, &high);
+	return low ^ high;
+#else
+	const uint64_t aLow = a & 0xFFFFFFFF;
+	const uint64_t aHigh = a >> 32;
+	const uint64_t bLow = b & 0xFFFFFFFF;
+	const uint64_t bHigh = b >> 32;
+
+	const uint64_t lowLow = aLow * bLow;
+	const uint64_t highLow = aHigh * bLow;
+	const uint64_t lowHigh = aLow * bHigh;
+	const uint64_t highHigh = aHigh * bHigh;
+
+	const uint64_t cross = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + lowHigh;
+	const uint64_t high = (highLow >> 32) + (cross >> 32) + highHigh;
+	const uint64_t low = (cross << 32) | (lowLow & 0xFFFFFFFF);
+	return low ^ high;
+#endif
+}
+
+
+inline uint64_t Avalanche(uint64_t hash) noexcept
+{
+	hash ^= hash >> 33;
+	hash *= s_prime64_2;
+	hash ^= hash >> 29;
+	hash *= s_prime64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+
+uint64_t HashShort(const uint8_t* data, size_t size, uint64_t seed) noexcept
+{
+	uint64_t hash = seed + size * s_prime64_1;
+
+	if (size > 16)
+	{
+		// 16-byte chunks, the last one backed up to end at the end of the input
+		const size_t numChunks = (size + 15) / 16;
+		for (size_t i = 0; i < numChunks; ++i)
+		{
+			const uint8_t* chunk = data + std::min(16 * i, size - 16);
+			hash += Mul128Fold64(Read64(chunk) ^ s_keys.init[2 * i], Read64(chunk + 8) ^ s_keys.init[2 * i + 1]);
+		}
+	}
+	else
+	{
+		uint64_t low{ 0 };
+		uint64_t high{ 0 };
+
+		if (size > 8)
+		{
+			low = Read64(data);
+			high = Read64(data + size - 8);
+		}
+		else if (size >= 4)
+		{
+			low = Read32(data);
+			high = Read32(data + size - 4);
+		}
+		else if (size > 0)
+		{
+			low = (uint64_t)data[0] | ((uint64_t)data[size / 2] << 8) | ((uint64_t)data[size - 1] << 16);
+		}
+
+		hash += Mul128Fold64(low ^ s_keys.init[0], high ^ s_keys.init[1]);
+	}
+
+	return Avalanche(hash);
+}
+
+
+// Each kernel adds numStripes stripes into the lanes, keying stripe n with stripeKey + n * s_prime64_1, then
+// scrambles the lanes if asked.  Lane i takes the product of the two halves of its keyed value, and the raw value
+// goes to its neighbour, lane i ^ 1, so no lane can be zeroed out by its own input.
+void AccumulateScalar(uint64_t* lanes, const uint8_t* data, size_t numStripes, uint64_t stripeKey, bool scramble) noexcept
+{
+	for (size_t n = 0; n < numStripes; ++n, data += s_stripeSize, stripeKey += s_prime64_1)
+	{
+		for (size_t i = 0; i < 8; ++i)
+		{
+			const uint64_t value = Read64(data + 8 * i);
+			const uint64_t keyed = value ^ (s_keys.stripe[i] + stripeKey);
+
+			lanes[i ^ 1] += value;
+			lanes[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+		}
+	}
+
+	if (scramble)
+	{
+		for (size_t i = 0; i < 8; ++i)
+		{
+			lanes[i] = (lanes[i] ^ (lanes[i] >> 47) ^ s_keys.stripe[i]) * s_prime32_1;
+		}
+	}
+}
+
+
+#ifdef _M_X64
+void AccumulateSSE2(uint64_t* lanes, const uint8_t* data, size_t numStripes, uint64_t stripeKey, bool scramble) noexcept
+{
+	__m128i acc[4];
+	for (size_t j = 0; j < 4; ++j)
+	{
+		acc[j] = _mm_loadu_si128((const __m128i*)lanes + j);
+	}
+
+	for (size_t n = 0; n < numStripes; ++n, data += s_stripeSize, stripeKey += s_prime64_1)
+	{
+		const __m128i stripeKeys = _mm_set1_epi64x((long long)stripeKey);
+
+		for (size_t j = 0; j < 4; ++j)
+		{
+			const __m128i value = _mm_loadu_si128((const __m128i*)data + j);
+			const __m128i keys = _mm_add_epi64(_mm_load_si128((const __m128i*)s_keys.stripe + j), stripeKeys);
+			const __m128i keyed = _mm_xor_si128(value, keys);
+			const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+			const __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+
+			acc[j] = _mm_add_epi64(acc[j], _mm_add_epi64(product, swapped));
+		}
+	}
+
+	if (scramble)
+	{
+		const __m128i prime = _mm_set1_epi32((int)s_prime32_1);
+
+		for (size_t j = 0; j < 4; ++j)
+		{
+			const __m128i keys = _mm_load_si128((const __m128i*)s_keys.stripe + j);
+			const __m128i mixed = _mm_xor_si128(_mm_xor_si128(acc[j], _mm_srli_epi64(acc[j], 47)), keys);
+
+			// 64 x 32-bit multiply, from the products of each half
+			const __m128i low = _mm_mul_epu32(mixed, prime);
+			const __m128i high = _mm_mul_epu32(_mm_srli_epi64(mixed, 32), prime);
+			acc[j] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+		}
+	}
+
+	for (size_t j = 0; j < 4; ++j)
+	{
+		_mm_storeu_si128((__m128i*)lanes + j, acc[j]);
+	}
+}
+
+
+void AccumulateAVX2(uint64_t* lanes, const uint8_t* data, size_t numStripes, uint64_t stripeKey, bool scramble) noexcept
+{
+	__m256i acc[2];
+	for (size_t j = 0; j < 2; ++j)
+	{
+		acc[j] = _mm256_loadu_si256((const __m256i*)lanes + j);
+	}
+
+	for (size_t n = 0; n < numStripes; ++n, data += s_stripeSize, stripeKey += s_prime64_1)
+	{
+		const __m256i stripeKeys = _mm256_set1_epi64x((long long)stripeKey);
+
+		for (size_t j = 0; j < 2; ++j)
+		{
+			const __m256i value = _mm256_loadu_si256((const __m256i*)data + j);
+			const __m256i keys = _mm256_add_epi64(_mm256_load_si256((const __m256i*)s_keys.stripe + j), stripeKeys);
+			const __m256i keyed = _mm256_xor_si256(value, keys);
+			const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+
+			// Swaps within each 128-bit half, which is the same i ^ 1 pairing as the other paths
+			const __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+
+			acc[j] = _mm256_add_epi64(acc[j], _mm256_add_epi64(product, swapped));
+		}
+	}
+
+	if (scramble)
+	{
+		const __m256i prime = _mm256_set1_epi32((int)s_prime32_1);
+
+		for (size_t j = 0; j < 2; ++j)
+		{
+			const __m256i keys = _mm256_load_si256((const __m256i*)s_keys.stripe + j);
+			const __m256i mixed = _mm256_xor_si256(_mm256_xor_si256(acc[j], _mm256_srli_epi64(acc[j], 47)), keys);
+
+			const __m256i low = _mm256_mul_epu32(mixed, prime);
+			const __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(mixed, 32), prime);
+			acc[j] = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+		}
+	}
+
+	for (size_t j = 0; j < 2; ++j)
+	{
+		_mm256_storeu_si256((__m256i*)lanes + j, acc[j]);
+	}
+}
+
+
+bool HasAVX2() noexcept
+{
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	const int maxLeaf = cpuInfo[0];
+
+	__cpuid(cpuInfo, 1);
+
+	// The OS must also save the upper halves of the YMM registers on context switches
+	const bool hasOSXSave = (cpuInfo[2] & (1 << 27)) != 0;
+	const bool hasAVX = (cpuInfo[2] & (1 << 28)) != 0;
+	const bool hasYmmState = hasOSXSave && (_xgetbv(0) & 0x6) == 0x6;
+
+	bool hasAVX2 = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(cpuInfo, 7, 0);
+		hasAVX2 = (cpuInfo[1] & (1 << 5)) != 0;
+	}
+
+	return hasAVX && hasAVX2 && hasYmmState;
+}
+#endif // _M_X64
+
+
+using AccumulateFunction = void (*)(uint64_t*, const uint8_t*, size_t, uint64_t, bool) noexcept;
+
+AccumulateFunction GetAccumulateFunction() noexcept
+{
+#ifdef _M_X64
+	// SSE2 is part of x64
+	return HasAVX2() ? AccumulateAVX2 : AccumulateSSE2;
+#else
+	return AccumulateScalar;
+#endif
+}
+
+
+uint64_t HashLong(AccumulateFunction accumulate, const uint8_t* data, size_t size, uint64_t seed) noexcept
+{
+	assert(size > s_stripeSize);
+
+	alignas(32) uint64_t lanes[8];
+	for (size_t i = 0; i < 8; ++i)
+	{
+		lanes[i] = s_keys.init[i] + seed;
+	}
+
+	// Every stripe but the last, which is always the final 64 bytes, overlapping the stripe before it if the size
+	// isn't a multiple of 64
+	const size_t numStripes = (size - 1) / s_stripeSize;
+	for (size_t stripe = 0; stripe < numStripes; stripe += s_stripesPerBlock)
+	{
+		const size_t count = std::min(s_stripesPerBlock, numStripes - stripe);
+		accumulate(lanes, data + stripe * s_stripeSize, count, 0, count == s_stripesPerBlock);
+	}
+
+	accumulate(lanes, data + size - s_stripeSize, 1, s_prime64_2, false);
+
+	uint64_t hash = seed + size * s_prime64_1;
+	for (size_t i = 0; i < 8; i += 2)
+	{
+		hash += Mul128Fold64(lanes[i] ^ s_keys.merge[i], lanes[i + 1] ^ s_keys.merge[i + 1]);
+	}
+
+	return Avalanche(hash);
+}
+
+} // anonymous namespace
+
 
 namespace Utility
 {
 
 const size_t g_hashStart = 2166136261U;
 
-} // namespace Utility
\ No newline at end of file
+
+uint64_t HashBytes64(const void* data, size_t sizeInBytes, uint64_t seed) noexcept
+{
+	assert(data != nullptr || sizeInBytes == 0);
+
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	if (sizeInBytes <= s_maxShortSize)
+	{
+		return HashShort(bytes, sizeInBytes, seed);
+	}
+
+	// Picked on first use, so hashing from another file's static initializers is safe
+	static const AccumulateFunction accumulate = GetAccumulateFunction();
+
+	return HashLong(accumulate, bytes, sizeInBytes, seed);
+}
+
+} // namespace Utility
@@ -12,7 +12,9 @@
 
 #pragma once
 
+#if !defined(LUNA_HEADLESS)
 #include "Math\CommonMath.h"
+#endif
 
 // This requires SSE4.2 which is present on Intel Nehalem (Nov. 2008)
 // and AMD Bulldozer (Oct. 2011) processors.  I could put a runtime
@@ -25,6 +27,7 @@
 #endif
 
 #if ENABLE_SSE_CRC32
+#include <nmmintrin.h>
 #pragma intrinsic(_mm_crc32_u32)
 #pragma intrinsic(_mm_crc32_u64)
 #endif
@@ -37,8 +40,8 @@ extern const size_t g_hashStart;
 inline size_t HashRange(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
 {
 #if ENABLE_SSE_CRC32
-	const uint64_t* Iter64 = (const uint64_t*)Math::AlignUp(Begin, 8);
-	const uint64_t* const End64 = (const uint64_t* const)Math::AlignDown(End, 8);
+	const uint64_t* Iter64 = (const uint64_t*)(((uintptr_t)Begin + 7) & ~(uintptr_t)7);
+	const uint64_t* const End64 = (const uint64_t* const)((uintptr_t)End & ~(uintptr_t)7);
 
 	// If not 64-bit aligned, start with a single u32
 	if ((uint32_t*)Iter64 > Begin)
@@ -68,7 +71,37 @@ template <typename T> inline size_t HashState(const T* StateDesc, size_t Count =
 
 inline size_t HashMerge(size_t hash1, size_t hash2)
 {
+#if ENABLE_SSE_CRC32
 	return _mm_crc32_u64(hash1, hash2);
+#else
+	// boost::hash_combine, widened to 64 bits
+	return hash1 ^ (hash2 + 0x9E3779B97F4A7C15ull + (hash1 << 6) + (hash1 >> 2));
+#endif
+}
+
+// A 64-bit hash of arbitrary bytes with far fewer collisions than the CRC-based hashes above, which only carry 32
+// bits.  Long inputs run through AVX2 or SSE2 when the CPU has them, but every path produces the same value.
+uint64_t HashBytes64(const void* data, size_t sizeInBytes, uint64_t seed = 0) noexcept;
+
+// FNV-1a, whose value depends on nothing but the bytes, so unlike std::hash it can be stored on disk or used to name
+// a file.  Slower than HashBytes64() on long inputs.
+constexpr uint64_t g_stableHashStart = 14695981039346656037ull;
+
+inline uint64_t HashStable(const void* data, size_t sizeInBytes, uint64_t hash = g_stableHashStart) noexcept
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < sizeInBytes; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+template <typename T> inline uint64_t HashStableValue(const T& value, uint64_t hash) noexcept
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Only the bytes of the value are hashed");
+	return HashStable(&value, sizeof(T), hash);
 }
 
 } // namespace Utility
@@ -0,0 +1,82 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#pragma once
+
+// Included by StdafxHeadless.h.  Headless builds have no COM, so this stands in for the part of it that
+// platform-independent code relies on:  reference counting through IUnknown, held by wil::com_ptr.  Code that
+// only keeps objects alive, like DeferredReleaseQueue, then builds and runs unchanged, and tests implement
+// IUnknown on their own counted objects.
+
+struct IUnknown
+{
+	virtual unsigned long AddRef() = 0;
+	virtual unsigned long Release() = 0;
+
+protected:
+	~IUnknown() = default;
+};
+
+
+namespace wil
+{
+
+template <class T>
+class com_ptr
+{
+public:
+	com_ptr() noexcept = default;
+
+	com_ptr(T* ptr) noexcept
+		: m_ptr{ ptr }
+	{
+		if (m_ptr)
+		{
+			m_ptr->AddRef();
+		}
+	}
+
+	com_ptr(const com_ptr& other) noexcept
+		: com_ptr{ other.m_ptr }
+	{}
+
+	com_ptr(com_ptr&& other) noexcept
+		: m_ptr{ other.m_ptr }
+	{
+		other.m_ptr = nullptr;
+	}
+
+	~com_ptr() { reset(); }
+
+	com_ptr& operator=(com_ptr other) noexcept
+	{
+		std::swap(m_ptr, other.m_ptr);
+		return *this;
+	}
+
+	void reset() noexcept
+	{
+		if (T* ptr = m_ptr)
+		{
+			m_ptr = nullptr;
+			ptr->Release();
+		}
+	}
+
+	T* get() const noexcept { return m_ptr; }
+	T* operator->() const noexcept { return m_ptr; }
+	explicit operator bool() const noexcept { return m_ptr != nullptr; }
+
+private:
+	T* m_ptr{ nullptr };
+};
+
+} // namespace wil
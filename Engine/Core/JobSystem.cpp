@@ -0,0 +1,421 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "JobSystem.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+static JobSystem* g_jobSystem{ nullptr };
+
+static constexpr uint32_t s_invalidWorkerIndex = ~0u;
+static thread_local uint32_t t_workerIndex{ s_invalidWorkerIndex };
+
+
+void JobCounter::Decrement()
+{
+	assert(m_value.load(memory_order_relaxed) > 0);
+
+	if (m_value.fetch_sub(1, memory_order_acq_rel) != 1)
+	{
+		return;
+	}
+
+	// Release the jobs that were waiting on this counter
+	vector<Continuation> continuations;
+	{
+		lock_guard lock(m_continuationMutex);
+		continuations.swap(m_continuations);
+	}
+
+	auto jobSystem = GetJobSystem();
+	for (auto& continuation : continuations)
+	{
+		if (jobSystem)
+		{
+			jobSystem->Enqueue(move(continuation.function), continuation.counter);
+		}
+		else
+		{
+			try
+			{
+				continuation.function();
+			}
+			catch (...)
+			{
+				continuation.counter->SetException(current_exception());
+			}
+			continuation.counter->Decrement();
+		}
+	}
+
+	NotifyJobWaiters();
+}
+
+
+bool JobCounter::HasFailed() const
+{
+	lock_guard lock(m_exceptionMutex);
+	return m_exception != nullptr;
+}
+
+
+void JobCounter::RethrowIfFailed() const
+{
+	exception_ptr exception;
+	{
+		lock_guard lock(m_exceptionMutex);
+		exception = m_exception;
+	}
+
+	if (exception)
+	{
+		rethrow_exception(exception);
+	}
+}
+
+
+void JobCounter::SetException(exception_ptr exception)
+{
+	lock_guard lock(m_exceptionMutex);
+	if (!m_exception)
+	{
+		m_exception = move(exception);
+	}
+}
+
+
+JobSystem::JobSystem(uint32_t numWorkers)
+{
+	if (numWorkers == 0)
+	{
+		const uint32_t numHardwareThreads = thread::hardware_concurrency();
+		numWorkers = numHardwareThreads > 1 ? numHardwareThreads - 1 : 1;
+	}
+
+	m_queues.reserve(numWorkers + 1);
+	for (uint32_t i = 0; i < numWorkers + 1; ++i)
+	{
+		m_queues.emplace_back(make_unique<WorkQueue>());
+	}
+
+	assert(g_jobSystem == nullptr);
+	g_jobSystem = this;
+
+	m_workers.reserve(numWorkers);
+	for (uint32_t i = 0; i < numWorkers; ++i)
+	{
+		m_workers.emplace_back([this, i] { WorkerLoop(i); });
+	}
+}
+
+
+JobSystem::~JobSystem()
+{
+	{
+		lock_guard lock(m_wakeMutex);
+		m_shutdown = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	assert(!HasQueuedJobs());
+
+	g_jobSystem = nullptr;
+}
+
+
+bool JobSystem::IsWorkerThread() const noexcept
+{
+	return t_workerIndex != s_invalidWorkerIndex;
+}
+
+
+uint32_t JobSystem::GetWorkerIndex() const noexcept
+{
+	return IsWorkerThread() ? t_workerIndex : (uint32_t)m_workers.size();
+}
+
+
+JobHandle JobSystem::Schedule(JobFunction function)
+{
+	auto counter = MakeJobHandle(1);
+	Enqueue(move(function), counter);
+	return counter;
+}
+
+
+JobHandle JobSystem::Schedule(JobFunction function, const JobHandle& dependency)
+{
+	auto counter = MakeJobHandle(1);
+	Schedule(move(function), dependency, counter);
+	return counter;
+}
+
+
+void JobSystem::Schedule(JobFunction function, const JobHandle& dependency, const JobHandle& counter)
+{
+	assert(counter);
+
+	if (dependency)
+	{
+		lock_guard lock(dependency->m_continuationMutex);
+
+		// The dependency releases its continuations after its value reaches zero, so checking under the
+		// lock guarantees the job is either queued here or picked up by JobCounter::Decrement()
+		if (!dependency->IsDone())
+		{
+			dependency->m_continuations.push_back({ move(function), counter });
+			return;
+		}
+	}
+
+	Enqueue(move(function), counter);
+}
+
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (TryRunOneJob(true))
+		{
+			continue;
+		}
+
+		SleepUntil([&counter] { return counter.IsDone(); });
+	}
+
+	counter.RethrowIfFailed();
+}
+
+
+void JobSystem::NotifyWaiters()
+{
+	// Taking the lock orders this against a waiter that has just tested its condition
+	{
+		lock_guard lock(m_wakeMutex);
+	}
+	m_wakeCondition.notify_all();
+}
+
+
+JobSystemStats JobSystem::GetStats() const
+{
+	JobSystemStats stats{
+		.numJobsExecuted		= m_numJobsExecuted.load(memory_order_relaxed),
+		.numJobsStolen			= m_numJobsStolen.load(memory_order_relaxed),
+		.numJobsRunWhileWaiting = m_numJobsRunWhileWaiting.load(memory_order_relaxed)
+	};
+	return stats;
+}
+
+
+void JobSystem::Enqueue(JobFunction function, const JobHandle& counter)
+{
+	const uint32_t queueIndex = GetWorkerIndex();
+
+	// Count the job before it becomes visible, so the count never underflows when it is popped right away
+	m_numQueuedJobs.fetch_add(1);
+	{
+		auto& queue = *m_queues[queueIndex];
+		lock_guard lock(queue.mutex);
+		queue.jobs.push_back({ move(function), counter });
+	}
+
+	// Busy workers find the job on their own, so producers only serialize on the wake mutex when a thread is
+	// asleep.  Taking the lock orders the notification against a sleeper that has just tested its condition.
+	if (m_numSleepers.load() > 0)
+	{
+		{
+			lock_guard lock(m_wakeMutex);
+		}
+		m_wakeCondition.notify_one();
+	}
+}
+
+
+bool JobSystem::TryRunOneJob(bool isWaiting)
+{
+	const uint32_t ownIndex = GetWorkerIndex();
+
+	Job job;
+	if (TryPop(ownIndex, job) || TrySteal(ownIndex, job))
+	{
+		if (isWaiting)
+		{
+			m_numJobsRunWhileWaiting.fetch_add(1, memory_order_relaxed);
+		}
+
+		RunJob(job);
+		return true;
+	}
+
+	return false;
+}
+
+
+bool JobSystem::TryPop(uint32_t queueIndex, Job& outJob)
+{
+	auto& queue = *m_queues[queueIndex];
+	lock_guard lock(queue.mutex);
+
+	if (queue.jobs.empty())
+	{
+		return false;
+	}
+
+	// Workers take their newest job, since its data is most likely still in cache.  The shared queue is
+	// drained oldest-first to keep submission order for external threads.
+	if (queueIndex < m_workers.size())
+	{
+		outJob = move(queue.jobs.back());
+		queue.jobs.pop_back();
+	}
+	else
+	{
+		outJob = move(queue.jobs.front());
+		queue.jobs.pop_front();
+	}
+
+	m_numQueuedJobs.fetch_sub(1, memory_order_relaxed);
+	return true;
+}
+
+
+bool JobSystem::TrySteal(uint32_t thiefIndex, Job& outJob)
+{
+	if (!HasQueuedJobs())
+	{
+		return false;
+	}
+
+	// Start with the neighbouring queue, so that thieves spread out over the victims
+	const uint32_t numQueues = (uint32_t)m_queues.size();
+	for (uint32_t i = 1; i < numQueues; ++i)
+	{
+		const uint32_t victimIndex = (thiefIndex + i) % numQueues;
+		auto& queue = *m_queues[victimIndex];
+
+		lock_guard lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			outJob = move(queue.jobs.front());
+			queue.jobs.pop_front();
+
+			m_numQueuedJobs.fetch_sub(1, memory_order_relaxed);
+			m_numJobsStolen.fetch_add(1, memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void JobSystem::RunJob(Job& job)
+{
+	// The exception is caught here rather than left to unwind, since it would skip the decrement and leave the
+	// waiters asleep.  It also must not escape into a Wait() on another counter that ran this job in passing.
+	exception_ptr exception;
+	try
+	{
+		job.function();
+	}
+	catch (...)
+	{
+		exception = current_exception();
+	}
+	m_numJobsExecuted.fetch_add(1, memory_order_relaxed);
+
+	if (job.counter)
+	{
+		if (exception)
+		{
+			job.counter->SetException(move(exception));
+		}
+		job.counter->Decrement();
+	}
+	else if (exception)
+	{
+		rethrow_exception(exception);
+	}
+}
+
+
+void JobSystem::WorkerLoop(uint32_t workerIndex)
+{
+	t_workerIndex = workerIndex;
+
+	while (true)
+	{
+		if (TryRunOneJob(false))
+		{
+			continue;
+		}
+
+		SleepUntil([] { return false; });
+
+		if (m_shutdown && !HasQueuedJobs())
+		{
+			break;
+		}
+	}
+
+	t_workerIndex = s_invalidWorkerIndex;
+}
+
+
+JobSystem* GetJobSystem()
+{
+	return g_jobSystem;
+}
+
+
+void WaitForJob(const JobHandle& handle)
+{
+	if (!handle)
+	{
+		return;
+	}
+
+	if (auto jobSystem = GetJobSystem())
+	{
+		jobSystem->Wait(*handle);
+	}
+	else
+	{
+		while (!handle->IsDone())
+		{
+			this_thread::yield();
+		}
+		handle->RethrowIfFailed();
+	}
+}
+
+
+void NotifyJobWaiters()
+{
+	if (auto jobSystem = GetJobSystem())
+	{
+		jobSystem->NotifyWaiters();
+	}
+}
+
+} // namespace Luna
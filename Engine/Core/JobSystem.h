@@ -0,0 +1,270 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/NonCopyable.h"
+#include "Core/NonMovable.h"
+
+namespace Luna
+{
+
+// Forward declarations
+class JobCounter;
+class JobSystem;
+
+using JobHandle = std::shared_ptr<JobCounter>;
+using JobFunction = std::function<void()>;
+
+
+// Dependency counter shared by a group of jobs.  The counter reaches zero when every job in the group
+// has finished, at which point any jobs scheduled against it are released to the workers.  A counter can
+// also be used as a one-shot event by creating it with a value of 1 and calling Decrement() once.
+class JobCounter : NonCopyable, NonMovable
+{
+	friend class JobSystem;
+
+public:
+	explicit JobCounter(uint32_t initialValue = 0) : m_value{ initialValue } {}
+
+	bool IsDone() const noexcept { return m_value.load(std::memory_order_acquire) == 0; }
+
+	void Increment(uint32_t count = 1) noexcept { m_value.fetch_add(count, std::memory_order_relaxed); }
+	void Decrement();
+
+	// A job that throws still counts as finished, so that its waiters wake and the jobs depending on it run.  The
+	// first exception thrown by a job counted here is kept, and rethrown by every wait on the counter, on the
+	// waiting thread.
+	bool HasFailed() const;
+	void RethrowIfFailed() const;
+
+private:
+	void SetException(std::exception_ptr exception);
+
+	struct Continuation
+	{
+		JobFunction function;
+		JobHandle counter;
+	};
+
+	std::atomic<uint32_t> m_value{ 0 };
+	std::mutex m_continuationMutex;
+	std::vector<Continuation> m_continuations;
+
+	mutable std::mutex m_exceptionMutex;
+	std::exception_ptr m_exception;
+};
+
+
+inline JobHandle MakeJobHandle(uint32_t initialValue = 0)
+{
+	return std::make_shared<JobCounter>(initialValue);
+}
+
+
+struct JobSystemStats
+{
+	uint64_t numJobsExecuted{ 0 };
+	uint64_t numJobsStolen{ 0 };
+	uint64_t numJobsRunWhileWaiting{ 0 };
+};
+
+
+// Work-stealing job scheduler with one queue per worker thread.  Workers pop their own queue LIFO for
+// cache locality and steal FIFO from other queues when empty.  Threads that are not workers submit to a
+// shared queue.  Any thread that waits on a job, counter or condition runs queued jobs instead of spinning,
+// and sleeps only when there is no work left to do.
+class JobSystem : NonCopyable, NonMovable
+{
+	friend class JobCounter;
+
+public:
+	// A worker count of 0 uses one worker per hardware thread, less one for the calling thread
+	explicit JobSystem(uint32_t numWorkers = 0);
+	~JobSystem();
+
+	uint32_t GetNumWorkers() const noexcept { return (uint32_t)m_workers.size(); }
+	bool IsWorkerThread() const noexcept;
+
+	// Index of the calling worker thread, or GetNumWorkers() for threads that are not workers
+	uint32_t GetWorkerIndex() const noexcept;
+
+	// Schedules a job.  The returned handle completes when the job has run.
+	JobHandle Schedule(JobFunction function);
+
+	// Schedules a job that runs once the dependency has completed
+	JobHandle Schedule(JobFunction function, const JobHandle& dependency);
+
+	// Schedules a job that decrements an existing counter when done.  The counter must already account for it.
+	void Schedule(JobFunction function, const JobHandle& dependency, const JobHandle& counter);
+
+	// Rethrows the first exception thrown by a job on the counter, once every job on it has finished
+	void Wait(const JobHandle& handle) { if (handle) { Wait(*handle); } }
+	void Wait(const JobCounter& counter);
+
+	// Waits for an externally-signalled condition, running jobs while it is false.  The producer must call
+	// NotifyWaiters() after making the condition true.
+	template <class TPredicate>
+	void WaitUntil(TPredicate&& predicate)
+	{
+		while (!predicate())
+		{
+			if (TryRunOneJob(true))
+			{
+				continue;
+			}
+
+			SleepUntil(predicate);
+		}
+	}
+
+	void NotifyWaiters();
+
+	// Invokes function(index) for every index in [0, count), split into batches of batchSize.  The calling
+	// thread takes part, and the call returns when every index has been processed.
+	template <class TFunction>
+	void ParallelFor(uint32_t count, uint32_t batchSize, TFunction&& function)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		batchSize = std::max(batchSize, 1u);
+		const uint32_t numBatches = (count + batchSize - 1) / batchSize;
+
+		if (numBatches == 1 || m_workers.empty())
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				function(i);
+			}
+			return;
+		}
+
+		auto counter = MakeJobHandle(numBatches);
+		for (uint32_t batch = 0; batch < numBatches; ++batch)
+		{
+			const uint32_t begin = batch * batchSize;
+			const uint32_t end = std::min(begin + batchSize, count);
+			Enqueue([begin, end, &function] { for (uint32_t i = begin; i < end; ++i) { function(i); } }, counter);
+		}
+
+		Wait(*counter);
+	}
+
+	template <class TFunction>
+	void ParallelFor(uint32_t count, TFunction&& function)
+	{
+		// Aim for a few batches per thread, so that stealing can even out uneven workloads
+		const uint32_t numThreads = GetNumWorkers() + 1;
+		const uint32_t batchSize = std::max(1u, count / (numThreads * 4));
+		ParallelFor(count, batchSize, std::forward<TFunction>(function));
+	}
+
+	JobSystemStats GetStats() const;
+
+private:
+	struct Job
+	{
+		JobFunction function;
+		JobHandle counter;
+	};
+
+	struct alignas(64) WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void Enqueue(JobFunction function, const JobHandle& counter);
+	bool TryRunOneJob(bool isWaiting);
+	bool TryPop(uint32_t queueIndex, Job& outJob);
+	bool TrySteal(uint32_t thiefIndex, Job& outJob);
+	void RunJob(Job& job);
+	void WorkerLoop(uint32_t workerIndex);
+
+	// The job count and the sleeper count are sequentially consistent, so a sleeper that misses a new job
+	// is always seen by the Enqueue() that queued it
+	bool HasQueuedJobs() const noexcept { return m_numQueuedJobs.load() > 0; }
+
+	// Blocks until the predicate holds, a job is queued, or the system shuts down
+	template <class TPredicate>
+	void SleepUntil(TPredicate&& predicate)
+	{
+		std::unique_lock lock(m_wakeMutex);
+
+		m_numSleepers.fetch_add(1);
+		m_wakeCondition.wait(lock, [&] { return predicate() || HasQueuedJobs() || m_shutdown; });
+		m_numSleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+private:
+	std::vector<std::thread> m_workers;
+
+	// One queue per worker, plus a shared queue for non-worker threads at the end
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::atomic<uint32_t> m_numQueuedJobs{ 0 };
+
+	// Threads blocked in SleepUntil().  Enqueue() only takes the wake mutex to notify when there are any.
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<uint32_t> m_numSleepers{ 0 };
+	std::atomic<bool> m_shutdown{ false };
+
+	std::atomic<uint64_t> m_numJobsExecuted{ 0 };
+	std::atomic<uint64_t> m_numJobsStolen{ 0 };
+	std::atomic<uint64_t> m_numJobsRunWhileWaiting{ 0 };
+};
+
+
+JobSystem* GetJobSystem();
+
+
+// Convenience wrappers that fall back to running inline when no JobSystem exists
+void WaitForJob(const JobHandle& handle);
+
+template <class TFunction>
+void ParallelFor(uint32_t count, TFunction&& function)
+{
+	if (auto jobSystem = GetJobSystem())
+	{
+		jobSystem->ParallelFor(count, std::forward<TFunction>(function));
+	}
+	else
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			function(i);
+		}
+	}
+}
+
+
+template <class TPredicate>
+void WaitUntil(TPredicate&& predicate)
+{
+	if (auto jobSystem = GetJobSystem())
+	{
+		jobSystem->WaitUntil(std::forward<TPredicate>(predicate));
+	}
+	else
+	{
+		while (!predicate())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+void NotifyJobWaiters();
+
+} // namespace Luna
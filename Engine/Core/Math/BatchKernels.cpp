@@ -0,0 +1,649 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "BatchKernels.h"
+
+#include "Core/CpuFeatures.h"
+
+#include <immintrin.h>
+#include <limits>
+
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+// The scalar kernels are the reference for the SIMD ones, and finish the elements left over by them.  Each kernel
+// returns the index of the first element it did not process.  The SSE transform kernels go one element at a time,
+// so they only run when AVX is not used.
+//
+// Points and box centers are transformed as ((w + z * mz) + y * my) + x * mx, the order XMVector3Transform()
+// uses, and products as (x * mx + z * mz) + (y * my + w * mw), the order of XMMatrixMultiply().  No kernel uses
+// FMA, which would round differently.
+
+size_t TransformPointsScalar(const float* mat, const float* points, float* outPoints, size_t first, size_t count) noexcept
+{
+	for (size_t i = first; i < count; ++i)
+	{
+		const float x = points[4 * i];
+		const float y = points[4 * i + 1];
+		const float z = points[4 * i + 2];
+
+		for (size_t c = 0; c < 4; ++c)
+		{
+			outPoints[4 * i + c] = ((mat[12 + c] + z * mat[8 + c]) + y * mat[4 + c]) + x * mat[c];
+		}
+	}
+	return count;
+}
+
+
+size_t TransformPointsSSE(const float* mat, const float* points, float* outPoints, size_t first, size_t count) noexcept
+{
+	const __m128 row0 = _mm_loadu_ps(mat);
+	const __m128 row1 = _mm_loadu_ps(mat + 4);
+	const __m128 row2 = _mm_loadu_ps(mat + 8);
+	const __m128 row3 = _mm_loadu_ps(mat + 12);
+
+	for (size_t i = first; i < count; ++i)
+	{
+		const __m128 point = _mm_loadu_ps(points + 4 * i);
+
+		__m128 result = _mm_add_ps(row3, _mm_mul_ps(_mm_shuffle_ps(point, point, 0xaa), row2));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(point, point, 0x55), row1));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(point, point, 0x00), row0));
+
+		_mm_storeu_ps(outPoints + 4 * i, result);
+	}
+	return count;
+}
+
+
+LUNA_TARGET_AVX size_t TransformPointsAVX(const float* mat, const float* points, float* outPoints, size_t first, size_t count) noexcept
+{
+	const __m256 row0 = _mm256_broadcast_ps((const __m128*)mat);
+	const __m256 row1 = _mm256_broadcast_ps((const __m128*)(mat + 4));
+	const __m256 row2 = _mm256_broadcast_ps((const __m128*)(mat + 8));
+	const __m256 row3 = _mm256_broadcast_ps((const __m128*)(mat + 12));
+
+	size_t i = first;
+	for (; i + 2 <= count; i += 2)
+	{
+		const __m256 point = _mm256_loadu_ps(points + 4 * i);
+
+		__m256 result = _mm256_add_ps(row3, _mm256_mul_ps(_mm256_permute_ps(point, 0xaa), row2));
+		result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_permute_ps(point, 0x55), row1));
+		result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_permute_ps(point, 0x00), row0));
+
+		_mm256_storeu_ps(outPoints + 4 * i, result);
+	}
+
+	_mm256_zeroupper();
+	return i;
+}
+
+
+size_t MultiplyMatricesScalar(const float* a, const float* b, float* outMatrices, size_t first, size_t count) noexcept
+{
+	for (size_t i = first; i < count; ++i)
+	{
+		const float* lhs = a + 16 * i;
+		const float* rhs = b + 16 * i;
+
+		float result[16];
+		for (size_t r = 0; r < 4; ++r)
+		{
+			for (size_t c = 0; c < 4; ++c)
+			{
+				result[4 * r + c] = (rhs[4 * r] * lhs[c] + rhs[4 * r + 2] * lhs[8 + c]) + (rhs[4 * r + 1] * lhs[4 + c] + rhs[4 * r + 3] * lhs[12 + c]);
+			}
+		}
+
+		// Written last, so the output can be either input
+		memcpy(outMatrices + 16 * i, result, sizeof(result));
+	}
+	return count;
+}
+
+
+inline __m128 MultiplyRowSSE(__m128 row, __m128 lhs0, __m128 lhs1, __m128 lhs2, __m128 lhs3) noexcept
+{
+	const __m128 xz = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, 0x00), lhs0), _mm_mul_ps(_mm_shuffle_ps(row, row, 0xaa), lhs2));
+	const __m128 yw = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, 0x55), lhs1), _mm_mul_ps(_mm_shuffle_ps(row, row, 0xff), lhs3));
+	return _mm_add_ps(xz, yw);
+}
+
+
+size_t MultiplyMatricesSSE(const float* a, const float* b, float* outMatrices, size_t first, size_t count) noexcept
+{
+	for (size_t i = first; i < count; ++i)
+	{
+		const float* lhs = a + 16 * i;
+		const float* rhs = b + 16 * i;
+
+		const __m128 lhs0 = _mm_loadu_ps(lhs);
+		const __m128 lhs1 = _mm_loadu_ps(lhs + 4);
+		const __m128 lhs2 = _mm_loadu_ps(lhs + 8);
+		const __m128 lhs3 = _mm_loadu_ps(lhs + 12);
+
+		const __m128 result0 = MultiplyRowSSE(_mm_loadu_ps(rhs), lhs0, lhs1, lhs2, lhs3);
+		const __m128 result1 = MultiplyRowSSE(_mm_loadu_ps(rhs + 4), lhs0, lhs1, lhs2, lhs3);
+		const __m128 result2 = MultiplyRowSSE(_mm_loadu_ps(rhs + 8), lhs0, lhs1, lhs2, lhs3);
+		const __m128 result3 = MultiplyRowSSE(_mm_loadu_ps(rhs + 12), lhs0, lhs1, lhs2, lhs3);
+
+		float* result = outMatrices + 16 * i;
+		_mm_storeu_ps(result, result0);
+		_mm_storeu_ps(result + 4, result1);
+		_mm_storeu_ps(result + 8, result2);
+		_mm_storeu_ps(result + 12, result3);
+	}
+	return count;
+}
+
+
+// Multiplies two rows of the right-hand matrix at once
+LUNA_TARGET_AVX inline __m256 MultiplyRowsAVX(__m256 rows, __m256 lhs0, __m256 lhs1, __m256 lhs2, __m256 lhs3) noexcept
+{
+	const __m256 xz = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(rows, 0x00), lhs0), _mm256_mul_ps(_mm256_permute_ps(rows, 0xaa), lhs2));
+	const __m256 yw = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(rows, 0x55), lhs1), _mm256_mul_ps(_mm256_permute_ps(rows, 0xff), lhs3));
+	return _mm256_add_ps(xz, yw);
+}
+
+
+LUNA_TARGET_AVX size_t MultiplyMatricesAVX(const float* a, const float* b, float* outMatrices, size_t first, size_t count) noexcept
+{
+	for (size_t i = first; i < count; ++i)
+	{
+		const float* lhs = a + 16 * i;
+		const float* rhs = b + 16 * i;
+
+		const __m256 lhs0 = _mm256_broadcast_ps((const __m128*)lhs);
+		const __m256 lhs1 = _mm256_broadcast_ps((const __m128*)(lhs + 4));
+		const __m256 lhs2 = _mm256_broadcast_ps((const __m128*)(lhs + 8));
+		const __m256 lhs3 = _mm256_broadcast_ps((const __m128*)(lhs + 12));
+
+		const __m256 result01 = MultiplyRowsAVX(_mm256_loadu_ps(rhs), lhs0, lhs1, lhs2, lhs3);
+		const __m256 result23 = MultiplyRowsAVX(_mm256_loadu_ps(rhs + 8), lhs0, lhs1, lhs2, lhs3);
+
+		_mm256_storeu_ps(outMatrices + 16 * i, result01);
+		_mm256_storeu_ps(outMatrices + 16 * i + 8, result23);
+	}
+
+	_mm256_zeroupper();
+	return count;
+}
+
+
+// The box is transformed by its center and extents:  the new extents are the old ones times the absolute
+// value of the matrix, which bounds all eight transformed corners exactly.  boxStride is 8 to step through an
+// array of boxes, or 0 to transform the same box by every matrix.
+
+size_t TransformBoxesScalar(const float* matrices, const float* boxes, size_t boxStride, float* outBoxes, size_t first, size_t count) noexcept
+{
+	for (size_t i = first; i < count; ++i)
+	{
+		const float* mat = matrices + 16 * i;
+		const float* box = boxes + boxStride * i;
+
+		const float centerX = box[0], centerY = box[1], centerZ = box[2];
+		const float extentX = box[4], extentY = box[5], extentZ = box[6];
+
+		float* outBox = outBoxes + 8 * i;
+		for (size_t c = 0; c < 4; ++c)
+		{
+			outBox[c] = ((mat[12 + c] + centerZ * mat[8 + c]) + centerY * mat[4 + c]) + centerX * mat[c];
+			outBox[4 + c] = (extentZ * fabsf(mat[8 + c]) + extentY * fabsf(mat[4 + c])) + extentX * fabsf(mat[c]);
+		}
+	}
+	return count;
+}
+
+
+size_t TransformBoxesSSE(const float* matrices, const float* boxes, size_t boxStride, float* outBoxes, size_t first, size_t count) noexcept
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (size_t i = first; i < count; ++i)
+	{
+		const float* mat = matrices + 16 * i;
+		const float* box = boxes + boxStride * i;
+
+		const __m128 row0 = _mm_loadu_ps(mat);
+		const __m128 row1 = _mm_loadu_ps(mat + 4);
+		const __m128 row2 = _mm_loadu_ps(mat + 8);
+		const __m128 row3 = _mm_loadu_ps(mat + 12);
+
+		const __m128 center = _mm_loadu_ps(box);
+		const __m128 extents = _mm_loadu_ps(box + 4);
+
+		__m128 outCenter = _mm_add_ps(row3, _mm_mul_ps(_mm_shuffle_ps(center, center, 0xaa), row2));
+		outCenter = _mm_add_ps(outCenter, _mm_mul_ps(_mm_shuffle_ps(center, center, 0x55), row1));
+		outCenter = _mm_add_ps(outCenter, _mm_mul_ps(_mm_shuffle_ps(center, center, 0x00), row0));
+
+		__m128 outExtents = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(extents, extents, 0xaa), _mm_andnot_ps(signMask, row2)),
+			_mm_mul_ps(_mm_shuffle_ps(extents, extents, 0x55), _mm_andnot_ps(signMask, row1)));
+		outExtents = _mm_add_ps(outExtents, _mm_mul_ps(_mm_shuffle_ps(extents, extents, 0x00), _mm_andnot_ps(signMask, row0)));
+
+		_mm_storeu_ps(outBoxes + 8 * i, outCenter);
+		_mm_storeu_ps(outBoxes + 8 * i + 4, outExtents);
+	}
+	return count;
+}
+
+
+LUNA_TARGET_AVX size_t TransformBoxesAVX(const float* matrices, const float* boxes, size_t boxStride, float* outBoxes, size_t first, size_t count) noexcept
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	size_t i = first;
+	for (; i + 2 <= count; i += 2)
+	{
+		const float* mat = matrices + 16 * i;
+
+		// Low halves hold the first box and its matrix, high halves the second
+		const __m256 mat01 = _mm256_loadu_ps(mat);
+		const __m256 mat23 = _mm256_loadu_ps(mat + 8);
+		const __m256 nextMat01 = _mm256_loadu_ps(mat + 16);
+		const __m256 nextMat23 = _mm256_loadu_ps(mat + 24);
+		const __m256 row0 = _mm256_permute2f128_ps(mat01, nextMat01, 0x20);
+		const __m256 row1 = _mm256_permute2f128_ps(mat01, nextMat01, 0x31);
+		const __m256 row2 = _mm256_permute2f128_ps(mat23, nextMat23, 0x20);
+		const __m256 row3 = _mm256_permute2f128_ps(mat23, nextMat23, 0x31);
+
+		const __m256 box = _mm256_loadu_ps(boxes + boxStride * i);
+		const __m256 nextBox = _mm256_loadu_ps(boxes + boxStride * (i + 1));
+		const __m256 center = _mm256_permute2f128_ps(box, nextBox, 0x20);
+		const __m256 extents = _mm256_permute2f128_ps(box, nextBox, 0x31);
+
+		__m256 outCenter = _mm256_add_ps(row3, _mm256_mul_ps(_mm256_permute_ps(center, 0xaa), row2));
+		outCenter = _mm256_add_ps(outCenter, _mm256_mul_ps(_mm256_permute_ps(center, 0x55), row1));
+		outCenter = _mm256_add_ps(outCenter, _mm256_mul_ps(_mm256_permute_ps(center, 0x00), row0));
+
+		__m256 outExtents = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(extents, 0xaa), _mm256_andnot_ps(signMask, row2)),
+			_mm256_mul_ps(_mm256_permute_ps(extents, 0x55), _mm256_andnot_ps(signMask, row1)));
+		outExtents = _mm256_add_ps(outExtents, _mm256_mul_ps(_mm256_permute_ps(extents, 0x00), _mm256_andnot_ps(signMask, row0)));
+
+		_mm256_storeu_ps(outBoxes + 8 * i, _mm256_permute2f128_ps(outCenter, outExtents, 0x20));
+		_mm256_storeu_ps(outBoxes + 8 * i + 8, _mm256_permute2f128_ps(outCenter, outExtents, 0x31));
+	}
+
+	_mm256_zeroupper();
+	return i;
+}
+
+
+// Running bounds for the reductions, seeded so that the first element replaces them
+struct MinMax3
+{
+	float minX{ numeric_limits<float>::max() };
+	float minY{ numeric_limits<float>::max() };
+	float minZ{ numeric_limits<float>::max() };
+	float maxX{ -numeric_limits<float>::max() };
+	float maxY{ -numeric_limits<float>::max() };
+	float maxZ{ -numeric_limits<float>::max() };
+};
+
+
+float ReduceMinSSE(__m128 v) noexcept
+{
+	v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 0x55));
+	return _mm_cvtss_f32(v);
+}
+
+
+float ReduceMaxSSE(__m128 v) noexcept
+{
+	v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 0x55));
+	return _mm_cvtss_f32(v);
+}
+
+
+LUNA_TARGET_AVX float ReduceMinAVX(__m256 v) noexcept
+{
+	return ReduceMinSSE(_mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+
+LUNA_TARGET_AVX float ReduceMaxAVX(__m256 v) noexcept
+{
+	return ReduceMaxSSE(_mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+
+// Bounds of low - offset and high + offset per axis.  Points pass themselves as low and high with no offsets,
+// boxes their min and max corners with no offsets, and spheres their center with their radius for all three axes.
+// Min and max are exact, so the order of the reduction doesn't change the result.
+struct BoundsInput
+{
+	const float* lowX;
+	const float* lowY;
+	const float* lowZ;
+	const float* highX;
+	const float* highY;
+	const float* highZ;
+	const float* offsetX;
+	const float* offsetY;
+	const float* offsetZ;
+};
+
+
+size_t ReduceBoundsScalar(const BoundsInput& input, MinMax3& bounds, size_t first, size_t count) noexcept
+{
+	for (size_t i = first; i < count; ++i)
+	{
+		const float offsetX = input.offsetX ? input.offsetX[i] : 0.0f;
+		const float offsetY = input.offsetY ? input.offsetY[i] : 0.0f;
+		const float offsetZ = input.offsetZ ? input.offsetZ[i] : 0.0f;
+
+		bounds.minX = min(bounds.minX, input.lowX[i] - offsetX);
+		bounds.minY = min(bounds.minY, input.lowY[i] - offsetY);
+		bounds.minZ = min(bounds.minZ, input.lowZ[i] - offsetZ);
+		bounds.maxX = max(bounds.maxX, input.highX[i] + offsetX);
+		bounds.maxY = max(bounds.maxY, input.highY[i] + offsetY);
+		bounds.maxZ = max(bounds.maxZ, input.highZ[i] + offsetZ);
+	}
+	return count;
+}
+
+
+size_t ReduceBoundsSSE(const BoundsInput& input, MinMax3& bounds, size_t first, size_t count) noexcept
+{
+	__m128 minX = _mm_set1_ps(bounds.minX), minY = _mm_set1_ps(bounds.minY), minZ = _mm_set1_ps(bounds.minZ);
+	__m128 maxX = _mm_set1_ps(bounds.maxX), maxY = _mm_set1_ps(bounds.maxY), maxZ = _mm_set1_ps(bounds.maxZ);
+
+	size_t i = first;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 lowX = _mm_loadu_ps(input.lowX + i);
+		const __m128 lowY = _mm_loadu_ps(input.lowY + i);
+		const __m128 lowZ = _mm_loadu_ps(input.lowZ + i);
+		const __m128 highX = _mm_loadu_ps(input.highX + i);
+		const __m128 highY = _mm_loadu_ps(input.highY + i);
+		const __m128 highZ = _mm_loadu_ps(input.highZ + i);
+		const __m128 offsetX = input.offsetX ? _mm_loadu_ps(input.offsetX + i) : _mm_setzero_ps();
+		const __m128 offsetY = input.offsetY ? _mm_loadu_ps(input.offsetY + i) : _mm_setzero_ps();
+		const __m128 offsetZ = input.offsetZ ? _mm_loadu_ps(input.offsetZ + i) : _mm_setzero_ps();
+
+		minX = _mm_min_ps(minX, _mm_sub_ps(lowX, offsetX));
+		minY = _mm_min_ps(minY, _mm_sub_ps(lowY, offsetY));
+		minZ = _mm_min_ps(minZ, _mm_sub_ps(lowZ, offsetZ));
+		maxX = _mm_max_ps(maxX, _mm_add_ps(highX, offsetX));
+		maxY = _mm_max_ps(maxY, _mm_add_ps(highY, offsetY));
+		maxZ = _mm_max_ps(maxZ, _mm_add_ps(highZ, offsetZ));
+	}
+
+	bounds.minX = ReduceMinSSE(minX);
+	bounds.minY = ReduceMinSSE(minY);
+	bounds.minZ = ReduceMinSSE(minZ);
+	bounds.maxX = ReduceMaxSSE(maxX);
+	bounds.maxY = ReduceMaxSSE(maxY);
+	bounds.maxZ = ReduceMaxSSE(maxZ);
+	return i;
+}
+
+
+LUNA_TARGET_AVX size_t ReduceBoundsAVX(const BoundsInput& input, MinMax3& bounds, size_t first, size_t count) noexcept
+{
+	__m256 minX = _mm256_set1_ps(bounds.minX), minY = _mm256_set1_ps(bounds.minY), minZ = _mm256_set1_ps(bounds.minZ);
+	__m256 maxX = _mm256_set1_ps(bounds.maxX), maxY = _mm256_set1_ps(bounds.maxY), maxZ = _mm256_set1_ps(bounds.maxZ);
+
+	size_t i = first;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 lowX = _mm256_loadu_ps(input.lowX + i);
+		const __m256 lowY = _mm256_loadu_ps(input.lowY + i);
+		const __m256 lowZ = _mm256_loadu_ps(input.lowZ + i);
+		const __m256 highX = _mm256_loadu_ps(input.highX + i);
+		const __m256 highY = _mm256_loadu_ps(input.highY + i);
+		const __m256 highZ = _mm256_loadu_ps(input.highZ + i);
+		const __m256 offsetX = input.offsetX ? _mm256_loadu_ps(input.offsetX + i) : _mm256_setzero_ps();
+		const __m256 offsetY = input.offsetY ? _mm256_loadu_ps(input.offsetY + i) : _mm256_setzero_ps();
+		const __m256 offsetZ = input.offsetZ ? _mm256_loadu_ps(input.offsetZ + i) : _mm256_setzero_ps();
+
+		minX = _mm256_min_ps(minX, _mm256_sub_ps(lowX, offsetX));
+		minY = _mm256_min_ps(minY, _mm256_sub_ps(lowY, offsetY));
+		minZ = _mm256_min_ps(minZ, _mm256_sub_ps(lowZ, offsetZ));
+		maxX = _mm256_max_ps(maxX, _mm256_add_ps(highX, offsetX));
+		maxY = _mm256_max_ps(maxY, _mm256_add_ps(highY, offsetY));
+		maxZ = _mm256_max_ps(maxZ, _mm256_add_ps(highZ, offsetZ));
+	}
+
+	bounds.minX = ReduceMinAVX(minX);
+	bounds.minY = ReduceMinAVX(minY);
+	bounds.minZ = ReduceMinAVX(minZ);
+	bounds.maxX = ReduceMaxAVX(maxX);
+	bounds.maxY = ReduceMaxAVX(maxY);
+	bounds.maxZ = ReduceMaxAVX(maxZ);
+
+	_mm256_zeroupper();
+	return i;
+}
+
+
+// Largest distance from the center to the far side of a sphere, with the distance summed as
+// (dx * dx + dy * dy) + dz * dz and square roots that are correctly rounded on every path
+size_t ReduceSphereRadiusScalar(const BoundingSphereSoA& spheres, const float center[3], float& radius, size_t first, size_t count) noexcept
+{
+	for (size_t i = first; i < count; ++i)
+	{
+		const float dx = spheres.centerX[i] - center[0];
+		const float dy = spheres.centerY[i] - center[1];
+		const float dz = spheres.centerZ[i] - center[2];
+		radius = max(radius, sqrtf((dx * dx + dy * dy) + dz * dz) + spheres.radius[i]);
+	}
+	return count;
+}
+
+
+size_t ReduceSphereRadiusSSE(const BoundingSphereSoA& spheres, const float center[3], float& radius, size_t first, size_t count) noexcept
+{
+	const __m128 centerX = _mm_set1_ps(center[0]);
+	const __m128 centerY = _mm_set1_ps(center[1]);
+	const __m128 centerZ = _mm_set1_ps(center[2]);
+	__m128 maxRadius = _mm_set1_ps(radius);
+
+	size_t i = first;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&spheres.centerX[i]), centerX);
+		const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&spheres.centerY[i]), centerY);
+		const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&spheres.centerZ[i]), centerZ);
+		const __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		maxRadius = _mm_max_ps(maxRadius, _mm_add_ps(_mm_sqrt_ps(distanceSq), _mm_loadu_ps(&spheres.radius[i])));
+	}
+
+	radius = ReduceMaxSSE(maxRadius);
+	return i;
+}
+
+
+LUNA_TARGET_AVX size_t ReduceSphereRadiusAVX(const BoundingSphereSoA& spheres, const float center[3], float& radius, size_t first, size_t count) noexcept
+{
+	const __m256 centerX = _mm256_set1_ps(center[0]);
+	const __m256 centerY = _mm256_set1_ps(center[1]);
+	const __m256 centerZ = _mm256_set1_ps(center[2]);
+	__m256 maxRadius = _mm256_set1_ps(radius);
+
+	size_t i = first;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&spheres.centerX[i]), centerX);
+		const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&spheres.centerY[i]), centerY);
+		const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&spheres.centerZ[i]), centerZ);
+		const __m256 distanceSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		maxRadius = _mm256_max_ps(maxRadius, _mm256_add_ps(_mm256_sqrt_ps(distanceSq), _mm256_loadu_ps(&spheres.radius[i])));
+	}
+
+	radius = ReduceMaxAVX(maxRadius);
+
+	_mm256_zeroupper();
+	return i;
+}
+
+
+bool UseAVX(BatchPath path) noexcept
+{
+	return (path == BatchPath::AVX || path == BatchPath::Best) && Luna::HasAVX();
+}
+
+
+MinMax3 ReduceBounds(const BoundsInput& input, size_t count, BatchPath path) noexcept
+{
+	MinMax3 bounds;
+
+	size_t first = 0;
+	if (UseAVX(path))
+	{
+		first = ReduceBoundsAVX(input, bounds, first, count);
+	}
+	if (path != BatchPath::Scalar)
+	{
+		first = ReduceBoundsSSE(input, bounds, first, count);
+	}
+	ReduceBoundsScalar(input, bounds, first, count);
+
+	return bounds;
+}
+
+
+BatchBounds ToBatchBounds(const MinMax3& bounds) noexcept
+{
+	return BatchBounds{
+		.min = { bounds.minX, bounds.minY, bounds.minZ },
+		.max = { bounds.maxX, bounds.maxY, bounds.maxZ }
+	};
+}
+
+} // anonymous namespace
+
+
+namespace Math
+{
+
+void TransformPoints(const float* mat, const float* points, float* outPoints, size_t count, BatchPath path) noexcept
+{
+	size_t first = 0;
+	if (UseAVX(path))
+	{
+		first = TransformPointsAVX(mat, points, outPoints, first, count);
+	}
+	else if (path != BatchPath::Scalar)
+	{
+		first = TransformPointsSSE(mat, points, outPoints, first, count);
+	}
+	TransformPointsScalar(mat, points, outPoints, first, count);
+}
+
+
+void MultiplyMatrices(const float* a, const float* b, float* outMatrices, size_t count, BatchPath path) noexcept
+{
+	size_t first = 0;
+	if (UseAVX(path))
+	{
+		first = MultiplyMatricesAVX(a, b, outMatrices, first, count);
+	}
+	else if (path != BatchPath::Scalar)
+	{
+		first = MultiplyMatricesSSE(a, b, outMatrices, first, count);
+	}
+	MultiplyMatricesScalar(a, b, outMatrices, first, count);
+}
+
+
+void TransformBoundingBoxes(const float* matrices, const float* boxes, size_t boxStride, float* outBoxes, size_t count, BatchPath path) noexcept
+{
+	assert(boxStride == 0 || boxStride == 8);
+
+	size_t first = 0;
+	if (UseAVX(path))
+	{
+		first = TransformBoxesAVX(matrices, boxes, boxStride, outBoxes, first, count);
+	}
+	else if (path != BatchPath::Scalar)
+	{
+		first = TransformBoxesSSE(matrices, boxes, boxStride, outBoxes, first, count);
+	}
+	TransformBoxesScalar(matrices, boxes, boxStride, outBoxes, first, count);
+}
+
+
+BatchBounds ComputeBounds(const Vector3SoA& points, BatchPath path) noexcept
+{
+	assert(points.y.size() == points.GetCount() && points.z.size() == points.GetCount());
+
+	if (points.GetCount() == 0)
+	{
+		return BatchBounds{};
+	}
+
+	const BoundsInput input{ points.x.data(), points.y.data(), points.z.data(), points.x.data(), points.y.data(), points.z.data(), nullptr, nullptr, nullptr };
+	return ToBatchBounds(ReduceBounds(input, points.GetCount(), path));
+}
+
+
+BatchBounds ComputeBounds(const BoundingBoxSoA& boxes, BatchPath path) noexcept
+{
+	assert(boxes.minY.size() == boxes.GetCount() && boxes.minZ.size() == boxes.GetCount());
+	assert(boxes.maxX.size() == boxes.GetCount() && boxes.maxY.size() == boxes.GetCount() && boxes.maxZ.size() == boxes.GetCount());
+
+	if (boxes.GetCount() == 0)
+	{
+		return BatchBounds{};
+	}
+
+	const BoundsInput input{ boxes.minX.data(), boxes.minY.data(), boxes.minZ.data(), boxes.maxX.data(), boxes.maxY.data(), boxes.maxZ.data(), nullptr, nullptr, nullptr };
+	return ToBatchBounds(ReduceBounds(input, boxes.GetCount(), path));
+}
+
+
+void ComputeBoundingSphere(const BoundingSphereSoA& spheres, float outCenter[3], float& outRadius, BatchPath path) noexcept
+{
+	assert(spheres.centerY.size() == spheres.GetCount() && spheres.centerZ.size() == spheres.GetCount() && spheres.radius.size() == spheres.GetCount());
+
+	const size_t count = spheres.GetCount();
+	if (count == 0)
+	{
+		outCenter[0] = outCenter[1] = outCenter[2] = 0.0f;
+		outRadius = 0.0f;
+		return;
+	}
+
+	const float* radius = spheres.radius.data();
+	const BoundsInput input{ spheres.centerX.data(), spheres.centerY.data(), spheres.centerZ.data(), spheres.centerX.data(), spheres.centerY.data(), spheres.centerZ.data(), radius, radius, radius };
+	const MinMax3 bounds = ReduceBounds(input, count, path);
+
+	outCenter[0] = 0.5f * (bounds.minX + bounds.maxX);
+	outCenter[1] = 0.5f * (bounds.minY + bounds.maxY);
+	outCenter[2] = 0.5f * (bounds.minZ + bounds.maxZ);
+
+	float maxRadius = 0.0f;
+
+	size_t first = 0;
+	if (UseAVX(path))
+	{
+		first = ReduceSphereRadiusAVX(spheres, outCenter, maxRadius, first, count);
+	}
+	if (path != BatchPath::Scalar)
+	{
+		first = ReduceSphereRadiusSSE(spheres, outCenter, maxRadius, first, count);
+	}
+	ReduceSphereRadiusScalar(spheres, outCenter, maxRadius, first, count);
+
+	outRadius = maxRadius;
+}
+
+} // namespace Math
@@ -0,0 +1,52 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#pragma once
+
+#include "BatchTypes.h"
+
+
+namespace Math
+{
+
+// The kernels behind BatchMath.h, on plain floats.  A point is four floats, the last unused, a matrix is four rows
+// of four, and a box is its center followed by its extents, four floats each.  Every path computes each element
+// with the same operations, in the same order, as Matrix4::operator*() and operator*(Matrix4, BoundingBox), and
+// without FMA, so all of them give the same bits.  Outputs may be the inputs, but must not otherwise overlap them.
+
+// outPoints[i] = mat * points[i]
+void TransformPoints(const float* mat, const float* points, float* outPoints, size_t count, BatchPath path = BatchPath::Best) noexcept;
+
+// outMatrices[i] = a[i] * b[i]
+void MultiplyMatrices(const float* a, const float* b, float* outMatrices, size_t count, BatchPath path = BatchPath::Best) noexcept;
+
+// outBoxes[i] = matrices[i] * boxes[i].  boxStride is 8 to step through an array of boxes, or 0 to transform the
+// same box by every matrix.
+void TransformBoundingBoxes(const float* matrices, const float* boxes, size_t boxStride, float* outBoxes, size_t count,
+	BatchPath path = BatchPath::Best) noexcept;
+
+
+// Min and max corners
+struct BatchBounds
+{
+	float min[3]{};
+	float max[3]{};
+};
+
+// Min and max are exact, so every path gives the same bounds.  Empty inputs give a zero-sized box at the origin.
+BatchBounds ComputeBounds(const Vector3SoA& points, BatchPath path = BatchPath::Best) noexcept;
+BatchBounds ComputeBounds(const BoundingBoxSoA& boxes, BatchPath path = BatchPath::Best) noexcept;
+
+// Centered on the box around all of the spheres, see BoundingSphereUnion().  Square roots are correctly rounded
+// on every path.
+void ComputeBoundingSphere(const BoundingSphereSoA& spheres, float outCenter[3], float& outRadius, BatchPath path = BatchPath::Best) noexcept;
+
+} // namespace Math
@@ -0,0 +1,89 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "BatchMath.h"
+
+#include "BatchKernels.h"
+
+using namespace Math;
+using namespace std;
+
+
+// The kernels work on the float arrays behind the math types.  A Vector3 is four floats, the last unused, a
+// Matrix4 is four rows of four, and a BoundingBox is its center followed by its extents.
+static_assert(sizeof(Vector3) == 4 * sizeof(float));
+static_assert(sizeof(Matrix4) == 16 * sizeof(float));
+static_assert(sizeof(BoundingBox) == 8 * sizeof(float));
+
+
+namespace Math
+{
+
+void TransformPoints(const Matrix4& mat, span<const Vector3> points, span<Vector3> outPoints) noexcept
+{
+	assert(outPoints.size() == points.size());
+
+	TransformPoints((const float*)&mat, (const float*)points.data(), (float*)outPoints.data(), points.size());
+}
+
+
+void MultiplyMatrices(span<const Matrix4> a, span<const Matrix4> b, span<Matrix4> outMatrices) noexcept
+{
+	assert(b.size() == a.size() && outMatrices.size() == a.size());
+
+	MultiplyMatrices((const float*)a.data(), (const float*)b.data(), (float*)outMatrices.data(), a.size());
+}
+
+
+void TransformBoundingBoxes(span<const Matrix4> matrices, span<const BoundingBox> boxes, span<BoundingBox> outBoxes) noexcept
+{
+	assert(boxes.size() == matrices.size() && outBoxes.size() == matrices.size());
+
+	TransformBoundingBoxes((const float*)matrices.data(), (const float*)boxes.data(), 8, (float*)outBoxes.data(), matrices.size());
+}
+
+
+void TransformBoundingBoxes(span<const Matrix4> matrices, const BoundingBox& box, span<BoundingBox> outBoxes) noexcept
+{
+	assert(outBoxes.size() == matrices.size());
+
+	TransformBoundingBoxes((const float*)matrices.data(), (const float*)&box, 0, (float*)outBoxes.data(), matrices.size());
+}
+
+
+BoundingBox ComputeBoundingBox(const Vector3SoA& points) noexcept
+{
+	const BatchBounds bounds = ComputeBounds(points);
+
+	return BoundingBoxFromMinMax(Vector3(bounds.min[0], bounds.min[1], bounds.min[2]), Vector3(bounds.max[0], bounds.max[1], bounds.max[2]));
+}
+
+
+BoundingBox BoundingBoxUnion(const BoundingBoxSoA& boxes) noexcept
+{
+	const BatchBounds bounds = ComputeBounds(boxes);
+
+	return BoundingBoxFromMinMax(Vector3(bounds.min[0], bounds.min[1], bounds.min[2]), Vector3(bounds.max[0], bounds.max[1], bounds.max[2]));
+}
+
+
+BoundingSphere BoundingSphereUnion(const BoundingSphereSoA& spheres) noexcept
+{
+	float center[3];
+	float radius{ 0.0f };
+	ComputeBoundingSphere(spheres, center, radius);
+
+	return BoundingSphere(Vector3(center[0], center[1], center[2]), radius);
+}
+
+} // namespace Math
@@ -0,0 +1,47 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "BatchTypes.h"
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Matrix4.h"
+
+
+namespace Math
+{
+
+// Batch transforms.  These run 2 elements per iteration with AVX when the CPU supports it, and otherwise 1 with
+// SSE.  Each output element is computed with the same operations, in the same order, as Matrix4::operator*()
+// and operator*(Matrix4, BoundingBox), so every path gives the same bits.  Outputs may be the inputs, but must
+// not otherwise overlap them.
+
+// outPoints[i] = mat * points[i]
+void TransformPoints(const Matrix4& mat, std::span<const Vector3> points, std::span<Vector3> outPoints) noexcept;
+
+// outMatrices[i] = a[i] * b[i]
+void MultiplyMatrices(std::span<const Matrix4> a, std::span<const Matrix4> b, std::span<Matrix4> outMatrices) noexcept;
+
+// outBoxes[i] = matrices[i] * boxes[i], or matrices[i] * box
+void TransformBoundingBoxes(std::span<const Matrix4> matrices, std::span<const BoundingBox> boxes, std::span<BoundingBox> outBoxes) noexcept;
+void TransformBoundingBoxes(std::span<const Matrix4> matrices, const BoundingBox& box, std::span<BoundingBox> outBoxes) noexcept;
+
+
+// Batch reductions, 8 elements per iteration with AVX, or 4 with SSE.  Empty inputs give a zero-sized volume at
+// the origin.
+BoundingBox ComputeBoundingBox(const Vector3SoA& points) noexcept;
+BoundingBox BoundingBoxUnion(const BoundingBoxSoA& boxes) noexcept;
+
+// Centered on the box around all of the spheres, which is not the smallest enclosing sphere, but is found in
+// two passes and never grows with the order of the spheres like pairwise merging does
+BoundingSphere BoundingSphereUnion(const BoundingSphereSoA& spheres) noexcept;
+
+} // namespace Math
@@ -0,0 +1,70 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+// Plain float data for the batch functions in BatchMath.h, FrustumCulling.h and Frustum.  Nothing here depends on
+// DirectXMath, so the kernels behind those functions can be built and tested on their own.
+
+#include <cstddef>
+#include <span>
+
+
+namespace Math
+{
+
+// The widest instruction set a batch function may use.  Best is AVX when the CPU and OS support it, and SSE
+// otherwise.  The narrower paths exist so that tests and benchmarks can compare them against each other.
+enum class BatchPath
+{
+	Scalar,
+	SSE,
+	AVX,
+	Best
+};
+
+
+// Structure-of-arrays data for the batch functions.  Each array holds one value per element, and all of them
+// must have the same length.
+struct Vector3SoA
+{
+	std::span<const float> x;
+	std::span<const float> y;
+	std::span<const float> z;
+
+	size_t GetCount() const noexcept { return x.size(); }
+};
+
+
+struct BoundingSphereSoA
+{
+	std::span<const float> centerX;
+	std::span<const float> centerY;
+	std::span<const float> centerZ;
+	std::span<const float> radius;
+
+	size_t GetCount() const noexcept { return centerX.size(); }
+};
+
+
+// Boxes as their min and max corners, the same bounds that Frustum::IntersectBoundingBox() takes
+struct BoundingBoxSoA
+{
+	std::span<const float> minX;
+	std::span<const float> minY;
+	std::span<const float> minZ;
+	std::span<const float> maxX;
+	std::span<const float> maxY;
+	std::span<const float> maxZ;
+
+	size_t GetCount() const noexcept { return minX.size(); }
+};
+
+} // namespace Math
@@ -20,58 +20,43 @@ using namespace std;
 namespace Math
 {
 
-static const Vector3 s_boxCorners[] =
-{
-	{ -1.0f, -1.0f,  1.0f },
-	{  1.0f, -1.0f,  1.0f },
-	{  1.0f,  1.0f,  1.0f },
-	{ -1.0f,  1.0f,  1.0f },
-	{ -1.0f, -1.0f, -1.0f },
-	{  1.0f, -1.0f, -1.0f },
-	{  1.0f,  1.0f, -1.0f },
-	{ -1.0f,  1.0f, -1.0f }
-};
-
-
-BoundingBox BoundingBoxUnion(span<BoundingBox> boxes) noexcept
+BoundingBox BoundingBoxUnion(span<const BoundingBox> boxes) noexcept
 {
 	float maxF = numeric_limits<float>::max();
-	Vector3 minExtents(maxF, maxF, maxF);
-	Vector3 maxExtents(-maxF, -maxF, -maxF);
+	Vector3 minExtents0(maxF, maxF, maxF), minExtents1(maxF, maxF, maxF);
+	Vector3 maxExtents0(-maxF, -maxF, -maxF), maxExtents1(-maxF, -maxF, -maxF);
+
+	// Two sets of bounds, so consecutive boxes don't wait on each other's Min/Max
+	size_t i = 0;
+	for (; i + 2 <= boxes.size(); i += 2)
+	{
+		minExtents0 = Min(minExtents0, boxes[i].GetMin());
+		maxExtents0 = Max(maxExtents0, boxes[i].GetMax());
+		minExtents1 = Min(minExtents1, boxes[i + 1].GetMin());
+		maxExtents1 = Max(maxExtents1, boxes[i + 1].GetMax());
+	}
 
-	for (const auto& box : boxes)
+	if (i < boxes.size())
 	{
-		minExtents = Min(minExtents, box.GetMin());
-		maxExtents = Max(maxExtents, box.GetMax());
+		minExtents0 = Min(minExtents0, boxes[i].GetMin());
+		maxExtents0 = Max(maxExtents0, boxes[i].GetMax());
 	}
 
-	return BoundingBoxFromMinMax(minExtents, maxExtents);
+	return BoundingBoxFromMinMax(Min(minExtents0, minExtents1), Max(maxExtents0, maxExtents1));
 }
 
 
 BoundingBox operator*(Matrix4 mat, BoundingBox box) noexcept
 {
-	// Load center and extents.
-	Vector3 center = box.GetCenter();
-	Vector3 extents = box.GetExtents();
+	// Transform the center, and bound the transformed extents with the absolute value of the matrix, which gives
+	// the same box as transforming all eight corners.  This matches TransformBoundingBoxes() bit for bit.
+	const Vector3 extents = box.GetExtents();
 
-	// Compute and transform the corners and find new min/max bounds.
-	Vector3 corner = MultiplyAdd(extents, s_boxCorners[0], center);
-	corner = mat * corner;
-
-	Vector3 minExtents, maxExtents;
-	minExtents = maxExtents = corner;
-
-	for (size_t i = 1; i < 8; ++i)
-	{
-		corner = MultiplyAdd(extents, s_boxCorners[i], center);
-		corner = mat * corner;
-
-		minExtents = Min(minExtents, corner);
-		maxExtents = Max(maxExtents, corner);
-	}
+	const Vector3 center = mat * box.GetCenter();
+	Vector3 newExtents = extents.GetZ() * Abs(Vector3(mat.GetZ())) + extents.GetY() * Abs(Vector3(mat.GetY()));
+	newExtents = newExtents + extents.GetX() * Abs(Vector3(mat.GetX()));
 
-	return BoundingBoxFromMinMax(Vector3(minExtents), Vector3(maxExtents));
+	return BoundingBox(center, newExtents);
 }
 
 } // namespace Math
\ No newline at end of file
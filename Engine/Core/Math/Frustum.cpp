@@ -15,9 +15,31 @@
 
 #include "Frustum.h"
 
+#include "FrustumCulling.h"
+
 using namespace Math;
 
 
+namespace
+{
+
+FrustumPlanes GetFrustumPlanes(const Frustum& frustum) noexcept
+{
+	FrustumPlanes planes{};
+	for (int i = 0; i < 6; ++i)
+	{
+		const Vector4 plane = Vector4(frustum.GetFrustumPlane((Frustum::PlaneID)i));
+		planes.normalX[i] = plane.GetX();
+		planes.normalY[i] = plane.GetY();
+		planes.normalZ[i] = plane.GetZ();
+		planes.distance[i] = plane.GetW();
+	}
+	return planes;
+}
+
+} // anonymous namespace
+
+
 void Frustum::ConstructPerspectiveFrustum(float HTan, float VTan, float NearClip, float FarClip) noexcept
 {
 	const float NearX = HTan * NearClip;
@@ -119,4 +141,28 @@ Frustum::Frustum(const Matrix4& ProjMat) noexcept
 
 		ConstructPerspectiveFrustum(RcpXX, RcpYY, NearClip, FarClip);
 	}
-}
\ No newline at end of file
+}
+
+
+uint32_t Frustum::CullSpheres(const BoundingSphereSoA& spheres, std::span<uint32_t> outVisible) const noexcept
+{
+	return Math::CullSpheres(GetFrustumPlanes(*this), spheres, outVisible);
+}
+
+
+void Frustum::CullSpheres(const BoundingSphereSoA& spheres, std::span<uint64_t> outVisibleMask) const noexcept
+{
+	Math::CullSpheres(GetFrustumPlanes(*this), spheres, outVisibleMask);
+}
+
+
+uint32_t Frustum::CullBoundingBoxes(const BoundingBoxSoA& boxes, std::span<uint32_t> outVisible) const noexcept
+{
+	return Math::CullBoundingBoxes(GetFrustumPlanes(*this), boxes, outVisible);
+}
+
+
+void Frustum::CullBoundingBoxes(const BoundingBoxSoA& boxes, std::span<uint64_t> outVisibleMask) const noexcept
+{
+	Math::CullBoundingBoxes(GetFrustumPlanes(*this), boxes, outVisibleMask);
+}
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include "BatchTypes.h"
 #include "BoundingPlane.h"
 #include "BoundingSphere.h"
 
@@ -48,6 +49,18 @@ public:
 	// simple struct in the Model project.)
 	bool IntersectBoundingBox(const Vector3 minBound, const Vector3 maxBound) const noexcept;
 
+	// Batch versions of the tests above, for thousands of objects at a time, through the functions in
+	// FrustumCulling.h.  Boxes are culled from the same min and max corners as IntersectBoundingBox(), but the
+	// plane distances are summed in a fixed order rather than by DirectXMath's dot product, so an object within
+	// rounding error of a plane can get a different answer from the single-object tests.
+	// The index forms write the indices of the visible objects to outVisible, which must have room for every
+	// object, and return how many were written.  The mask forms set bit (i % 64) of outVisibleMask[i / 64] for
+	// each visible object i, and clear all other bits.
+	uint32_t CullSpheres(const BoundingSphereSoA& spheres, std::span<uint32_t> outVisible) const noexcept;
+	void CullSpheres(const BoundingSphereSoA& spheres, std::span<uint64_t> outVisibleMask) const noexcept;
+	uint32_t CullBoundingBoxes(const BoundingBoxSoA& boxes, std::span<uint32_t> outVisible) const noexcept;
+	void CullBoundingBoxes(const BoundingBoxSoA& boxes, std::span<uint64_t> outVisibleMask) const noexcept;
+
 	friend Frustum operator*(const OrthogonalTransform& xform, const Frustum& frustum) noexcept;	// Fast
 	friend Frustum operator*(const AffineTransform& xform, const Frustum& frustum) noexcept;		// Slow
 	friend Frustum operator*(const Matrix4& xform, const Frustum& frustum) noexcept;				// Slowest (and most general)
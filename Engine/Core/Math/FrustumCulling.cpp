@@ -0,0 +1,334 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FrustumCulling.h"
+
+#include "Core/CpuFeatures.h"
+
+#include <immintrin.h>
+
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+// Receives the visibility of a run of objects, as a bitmask with one bit per object starting at firstIndex
+class VisibleIndexWriter
+{
+public:
+	explicit VisibleIndexWriter(span<uint32_t> outVisible) noexcept : m_outVisible{ outVisible } {}
+
+	void Write(uint32_t firstIndex, uint32_t visibleBits) noexcept
+	{
+		while (visibleBits != 0)
+		{
+			m_outVisible[m_numVisible++] = firstIndex + (uint32_t)countr_zero(visibleBits);
+			visibleBits &= visibleBits - 1;
+		}
+	}
+
+	uint32_t GetNumVisible() const noexcept { return m_numVisible; }
+
+private:
+	span<uint32_t> m_outVisible;
+	uint32_t m_numVisible{ 0 };
+};
+
+
+class VisibleMaskWriter
+{
+public:
+	explicit VisibleMaskWriter(span<uint64_t> outVisibleMask) noexcept : m_outVisibleMask{ outVisibleMask }
+	{
+		fill(m_outVisibleMask.begin(), m_outVisibleMask.end(), 0ull);
+	}
+
+	// Runs start at multiples of their length, so they never straddle two words
+	void Write(uint32_t firstIndex, uint32_t visibleBits) noexcept
+	{
+		m_outVisibleMask[firstIndex / 64] |= (uint64_t)visibleBits << (firstIndex % 64);
+	}
+
+private:
+	span<uint64_t> m_outVisibleMask;
+};
+
+
+// The kernels below evaluate each plane distance as ((x * nx + y * ny) + z * nz) + d, and each returns the index
+// of the first object it did not process.  The scalar kernels finish the objects left over by the SIMD ones.
+
+template <class TWriter>
+uint32_t CullSpheresScalar(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, uint32_t first, uint32_t count, TWriter& writer) noexcept
+{
+	for (uint32_t i = first; i < count; ++i)
+	{
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; ++p)
+		{
+			const float distance = spheres.centerX[i] * planes.normalX[p] + spheres.centerY[i] * planes.normalY[p] + spheres.centerZ[i] * planes.normalZ[p] + planes.distance[p];
+			visible = !(distance + spheres.radius[i] < 0.0f);
+		}
+
+		if (visible)
+		{
+			writer.Write(i, 1);
+		}
+	}
+	return count;
+}
+
+
+template <class TWriter>
+uint32_t CullSpheresSSE(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, uint32_t first, uint32_t count, TWriter& writer) noexcept
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	uint32_t i = first;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 centerX = _mm_loadu_ps(&spheres.centerX[i]);
+		const __m128 centerY = _mm_loadu_ps(&spheres.centerY[i]);
+		const __m128 centerZ = _mm_loadu_ps(&spheres.centerZ[i]);
+		const __m128 radius = _mm_loadu_ps(&spheres.radius[i]);
+
+		__m128 culled = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(planes.normalX[p])), _mm_mul_ps(centerY, _mm_set1_ps(planes.normalY[p])));
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerZ, _mm_set1_ps(planes.normalZ[p])));
+			distance = _mm_add_ps(distance, _mm_set1_ps(planes.distance[p]));
+			culled = _mm_or_ps(culled, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		writer.Write(i, ~(uint32_t)_mm_movemask_ps(culled) & 0xf);
+	}
+	return i;
+}
+
+
+template <class TWriter>
+LUNA_TARGET_AVX uint32_t CullSpheresAVX(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, uint32_t first, uint32_t count, TWriter& writer) noexcept
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	uint32_t i = first;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 centerX = _mm256_loadu_ps(&spheres.centerX[i]);
+		const __m256 centerY = _mm256_loadu_ps(&spheres.centerY[i]);
+		const __m256 centerZ = _mm256_loadu_ps(&spheres.centerZ[i]);
+		const __m256 radius = _mm256_loadu_ps(&spheres.radius[i]);
+
+		__m256 culled = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(planes.normalX[p])), _mm256_mul_ps(centerY, _mm256_set1_ps(planes.normalY[p])));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(centerZ, _mm256_set1_ps(planes.normalZ[p])));
+			distance = _mm256_add_ps(distance, _mm256_set1_ps(planes.distance[p]));
+			culled = _mm256_or_ps(culled, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+		}
+
+		writer.Write(i, ~(uint32_t)_mm256_movemask_ps(culled) & 0xff);
+	}
+
+	_mm256_zeroupper();
+	return i;
+}
+
+
+template <class TWriter>
+uint32_t CullBoxesScalar(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, uint32_t first, uint32_t count, TWriter& writer) noexcept
+{
+	for (uint32_t i = first; i < count; ++i)
+	{
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; ++p)
+		{
+			const float cornerX = planes.normalX[p] > 0.0f ? boxes.maxX[i] : boxes.minX[i];
+			const float cornerY = planes.normalY[p] > 0.0f ? boxes.maxY[i] : boxes.minY[i];
+			const float cornerZ = planes.normalZ[p] > 0.0f ? boxes.maxZ[i] : boxes.minZ[i];
+			const float distance = cornerX * planes.normalX[p] + cornerY * planes.normalY[p] + cornerZ * planes.normalZ[p] + planes.distance[p];
+			visible = !(distance < 0.0f);
+		}
+
+		if (visible)
+		{
+			writer.Write(i, 1);
+		}
+	}
+	return count;
+}
+
+
+template <class TWriter>
+uint32_t CullBoxesSSE(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, uint32_t first, uint32_t count, TWriter& writer) noexcept
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	uint32_t i = first;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 minX = _mm_loadu_ps(&boxes.minX[i]);
+		const __m128 minY = _mm_loadu_ps(&boxes.minY[i]);
+		const __m128 minZ = _mm_loadu_ps(&boxes.minZ[i]);
+		const __m128 maxX = _mm_loadu_ps(&boxes.maxX[i]);
+		const __m128 maxY = _mm_loadu_ps(&boxes.maxY[i]);
+		const __m128 maxZ = _mm_loadu_ps(&boxes.maxZ[i]);
+
+		__m128 culled = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			// The corner is picked per plane, not per box, so it needs no blend
+			const __m128 cornerX = planes.normalX[p] > 0.0f ? maxX : minX;
+			const __m128 cornerY = planes.normalY[p] > 0.0f ? maxY : minY;
+			const __m128 cornerZ = planes.normalZ[p] > 0.0f ? maxZ : minZ;
+
+			__m128 distance = _mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(planes.normalX[p])), _mm_mul_ps(cornerY, _mm_set1_ps(planes.normalY[p])));
+			distance = _mm_add_ps(distance, _mm_mul_ps(cornerZ, _mm_set1_ps(planes.normalZ[p])));
+			distance = _mm_add_ps(distance, _mm_set1_ps(planes.distance[p]));
+			culled = _mm_or_ps(culled, _mm_cmplt_ps(distance, zero));
+		}
+
+		writer.Write(i, ~(uint32_t)_mm_movemask_ps(culled) & 0xf);
+	}
+	return i;
+}
+
+
+template <class TWriter>
+LUNA_TARGET_AVX uint32_t CullBoxesAVX(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, uint32_t first, uint32_t count, TWriter& writer) noexcept
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	uint32_t i = first;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 minX = _mm256_loadu_ps(&boxes.minX[i]);
+		const __m256 minY = _mm256_loadu_ps(&boxes.minY[i]);
+		const __m256 minZ = _mm256_loadu_ps(&boxes.minZ[i]);
+		const __m256 maxX = _mm256_loadu_ps(&boxes.maxX[i]);
+		const __m256 maxY = _mm256_loadu_ps(&boxes.maxY[i]);
+		const __m256 maxZ = _mm256_loadu_ps(&boxes.maxZ[i]);
+
+		__m256 culled = zero;
+		for (int p = 0; p < 6; ++p)
+		{
+			const __m256 cornerX = planes.normalX[p] > 0.0f ? maxX : minX;
+			const __m256 cornerY = planes.normalY[p] > 0.0f ? maxY : minY;
+			const __m256 cornerZ = planes.normalZ[p] > 0.0f ? maxZ : minZ;
+
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(cornerX, _mm256_set1_ps(planes.normalX[p])), _mm256_mul_ps(cornerY, _mm256_set1_ps(planes.normalY[p])));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(cornerZ, _mm256_set1_ps(planes.normalZ[p])));
+			distance = _mm256_add_ps(distance, _mm256_set1_ps(planes.distance[p]));
+			culled = _mm256_or_ps(culled, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+		}
+
+		writer.Write(i, ~(uint32_t)_mm256_movemask_ps(culled) & 0xff);
+	}
+
+	_mm256_zeroupper();
+	return i;
+}
+
+
+bool UseAVX(BatchPath path) noexcept
+{
+	return (path == BatchPath::AVX || path == BatchPath::Best) && Luna::HasAVX();
+}
+
+
+template <class TWriter>
+void CullSpheresBatch(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, BatchPath path, TWriter& writer) noexcept
+{
+	assert(spheres.centerY.size() == spheres.GetCount() && spheres.centerZ.size() == spheres.GetCount() && spheres.radius.size() == spheres.GetCount());
+
+	const uint32_t count = (uint32_t)spheres.GetCount();
+
+	uint32_t first = 0;
+	if (UseAVX(path))
+	{
+		first = CullSpheresAVX(planes, spheres, first, count, writer);
+	}
+	if (path != BatchPath::Scalar)
+	{
+		first = CullSpheresSSE(planes, spheres, first, count, writer);
+	}
+	CullSpheresScalar(planes, spheres, first, count, writer);
+}
+
+
+template <class TWriter>
+void CullBoxesBatch(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, BatchPath path, TWriter& writer) noexcept
+{
+	assert(boxes.minY.size() == boxes.GetCount() && boxes.minZ.size() == boxes.GetCount());
+	assert(boxes.maxX.size() == boxes.GetCount() && boxes.maxY.size() == boxes.GetCount() && boxes.maxZ.size() == boxes.GetCount());
+
+	const uint32_t count = (uint32_t)boxes.GetCount();
+
+	uint32_t first = 0;
+	if (UseAVX(path))
+	{
+		first = CullBoxesAVX(planes, boxes, first, count, writer);
+	}
+	if (path != BatchPath::Scalar)
+	{
+		first = CullBoxesSSE(planes, boxes, first, count, writer);
+	}
+	CullBoxesScalar(planes, boxes, first, count, writer);
+}
+
+} // anonymous namespace
+
+
+namespace Math
+{
+
+uint32_t CullSpheres(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, span<uint32_t> outVisible, BatchPath path) noexcept
+{
+	assert(outVisible.size() >= spheres.GetCount());
+
+	VisibleIndexWriter writer{ outVisible };
+	CullSpheresBatch(planes, spheres, path, writer);
+	return writer.GetNumVisible();
+}
+
+
+void CullSpheres(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, span<uint64_t> outVisibleMask, BatchPath path) noexcept
+{
+	assert(outVisibleMask.size() >= (spheres.GetCount() + 63) / 64);
+
+	VisibleMaskWriter writer{ outVisibleMask };
+	CullSpheresBatch(planes, spheres, path, writer);
+}
+
+
+uint32_t CullBoundingBoxes(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, span<uint32_t> outVisible, BatchPath path) noexcept
+{
+	assert(outVisible.size() >= boxes.GetCount());
+
+	VisibleIndexWriter writer{ outVisible };
+	CullBoxesBatch(planes, boxes, path, writer);
+	return writer.GetNumVisible();
+}
+
+
+void CullBoundingBoxes(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, span<uint64_t> outVisibleMask, BatchPath path) noexcept
+{
+	assert(outVisibleMask.size() >= (boxes.GetCount() + 63) / 64);
+
+	VisibleMaskWriter writer{ outVisibleMask };
+	CullBoxesBatch(planes, boxes, path, writer);
+}
+
+} // namespace Math
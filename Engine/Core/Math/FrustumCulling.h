@@ -0,0 +1,46 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "BatchTypes.h"
+
+#include <cstdint>
+
+
+namespace Math
+{
+
+// A frustum's planes as plain floats, in Frustum::PlaneID order.  A point is inside plane i when
+// ((x * normalX[i] + y * normalY[i]) + z * normalZ[i]) + distance[i] is not negative.
+struct FrustumPlanes
+{
+	float normalX[6];
+	float normalY[6];
+	float normalZ[6];
+	float distance[6];
+};
+
+
+// Batch frustum culling, 8 objects per iteration with AVX, or 4 with SSE.  A sphere is culled when its center's
+// distance from any plane, plus its radius, is negative.  A box is culled when the corner farthest along any
+// plane's normal is behind that plane, with each coordinate of the corner taken from max where the normal is
+// positive and from min otherwise.  Every path computes the distances in the order above and without FMA, so
+// all of them return the same objects.
+//
+// The index forms write the indices of the visible objects to outVisible, which must have room for every object,
+// and return how many were written.  The mask forms set bit (i % 64) of outVisibleMask[i / 64] for each visible
+// object i, and clear all other bits.
+uint32_t CullSpheres(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, std::span<uint32_t> outVisible, BatchPath path = BatchPath::Best) noexcept;
+void CullSpheres(const FrustumPlanes& planes, const BoundingSphereSoA& spheres, std::span<uint64_t> outVisibleMask, BatchPath path = BatchPath::Best) noexcept;
+uint32_t CullBoundingBoxes(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, std::span<uint32_t> outVisible, BatchPath path = BatchPath::Best) noexcept;
+void CullBoundingBoxes(const FrustumPlanes& planes, const BoundingBoxSoA& boxes, std::span<uint64_t> outVisibleMask, BatchPath path = BatchPath::Best) noexcept;
+
+} // namespace Math
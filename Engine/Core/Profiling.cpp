@@ -13,6 +13,7 @@
 #include "Profiling.h"
 
 #include "Application.h"
+#include "FrameProfiler.h"
 
 #include "pix3.h"
 
@@ -55,6 +56,11 @@ ScopedEvent::ScopedEvent(const std::string& event)
 	}
 #endif
 
+	if (auto frameProfiler = GetFrameProfiler())
+	{
+		frameProfiler->BeginScope(event);
+	}
+
 	BeginEvent(event);
 }
 
@@ -62,6 +68,11 @@ ScopedEvent::~ScopedEvent()
 {
 	EndEvent();
 
+	if (auto frameProfiler = GetFrameProfiler())
+	{
+		frameProfiler->EndScope();
+	}
+
 #if FRAMEPRO_ENABLED
 	if (m_eventStarted && IsFrameProRunning())
 	{
@@ -61,4 +61,5 @@
 #include "Math\Matrix4.h"
 #include "Math\Functions.inl"
 #include "Math\Random.h"
+#include "Math\BatchMath.h"
 #include "Math\Frustum.h"
\ No newline at end of file
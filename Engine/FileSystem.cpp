@@ -12,6 +12,9 @@
 
 #include "FileSystem.h"
 
+#include "AssetArchive.h"
+#include "MappedFile.h"
+
 
 using namespace std;
 
@@ -20,10 +23,50 @@ namespace
 {
 
 constexpr uint32_t s_maxPathLength = 4096;
+
+// Smaller loose files are read rather than mapped.  Mapping costs a page fault for every page touched, and the
+// system calls to map and unmap the file, which is more than a copy of a few pages.
+constexpr uint64_t s_minMappedFileSize = 64 * 1024;
+
 shared_mutex s_mutex;
 
 Luna::FileSystem* g_filesystem{ nullptr };
 
+
+bool ReadLooseFile(const filesystem::path& fullPath, Luna::FileData& outData)
+{
+	ifstream inFile(fullPath, ios::in | ios::binary | ios::ate);
+	if (!inFile)
+	{
+		return false;
+	}
+
+	const uint64_t fileSize = (uint64_t)inFile.tellg();
+	if (fileSize < s_minMappedFileSize)
+	{
+		auto data = make_shared_for_overwrite<std::byte[]>((size_t)fileSize);
+		inFile.seekg(0);
+		if (!inFile.read((char*)data.get(), (streamsize)fileSize))
+		{
+			return false;
+		}
+
+		outData = Luna::FileData{ data, data.get(), (size_t)fileSize };
+		return true;
+	}
+
+	inFile.close();
+
+	auto mappedFile = make_shared<Luna::MappedFile>();
+	if (!mappedFile->Open(fullPath.string()))
+	{
+		return false;
+	}
+
+	outData = Luna::FileData{ mappedFile, mappedFile->GetData(), mappedFile->GetSize() };
+	return true;
+}
+
 } // anonymous namespace
 
 
@@ -72,6 +115,7 @@ void FileSystem::SetRootPath(const string& rootPathStr)
 
 	m_rootPath = rootPathStr;
 	m_logPath = m_rootPath / "Logs";
+	m_cachePath = m_rootPath / "Cache";
 }
 
 
@@ -88,6 +132,7 @@ void FileSystem::SetRootPath(const filesystem::path& rootPath)
 
 	m_rootPath = rootPath;
 	m_logPath = m_rootPath / "Logs";
+	m_cachePath = m_rootPath / "Cache";
 }
 
 
@@ -129,6 +174,8 @@ void FileSystem::AddSearchPath(const string& searchPathStr, bool appendPath)
 	newPathDesc->localPath = searchPath;
 	newPathDesc->fullPath = fullSearchPath;
 
+	ClearLookupCache();
+
 	if (appendPath)
 	{
 		if (prev == nullptr)
@@ -175,6 +222,7 @@ void FileSystem::RemoveSearchPath(const string& searchPathStr)
 				prev->next = cur->next;
 			}
 			delete cur;
+			ClearLookupCache();
 			break;
 		}
 		prev = cur;
@@ -200,23 +248,51 @@ vector<filesystem::path> FileSystem::GetSearchPaths() const
 }
 
 
-bool FileSystem::Exists(const string& fname) const
+bool FileSystem::MountArchive(const string& archivePathStr)
 {
-	const filesystem::path filePath{ fname };
+	string archiveFilename;
+	{
+		shared_lock<shared_mutex> CS(s_mutex);
+		archiveFilename = (m_rootPath / filesystem::path{ archivePathStr }).string();
+	}
+
+	auto archive = make_unique<AssetArchive>();
+	if (!archive->Open(archiveFilename))
+	{
+		LogWarning(LogFileSystem) << "Failed to mount archive " << archiveFilename << endl;
+		return false;
+	}
+
+	unique_lock<shared_mutex> CS(s_mutex);
 
+	erase_if(m_archives, [&archiveFilename](const auto& mounted) { return mounted->GetFileName() == archiveFilename; });
+	m_archives.insert(m_archives.begin(), move(archive));
+
+	return true;
+}
+
+
+void FileSystem::UnmountArchive(const string& archivePathStr)
+{
+	unique_lock<shared_mutex> CS(s_mutex);
+
+	// Data already read from the archive stays valid, since it keeps the mapping open
+	const string archiveFilename = (m_rootPath / filesystem::path{ archivePathStr }).string();
+	erase_if(m_archives, [&archiveFilename](const auto& mounted) { return mounted->GetFileName() == archiveFilename; });
+}
+
+
+bool FileSystem::Exists(const string& fname) const
+{
 	shared_lock<shared_mutex> CS(s_mutex);
 
-	PathDesc* cur = m_searchPaths;
-	while (cur)
+	if (FindArchive(fname) != nullptr)
 	{
-		auto fullPath = cur->fullPath / filePath;
-		if (filesystem::exists(fullPath))
-		{
-			return true;
-		}
-		cur = cur->next;
+		return true;
 	}
-	return false;
+
+	filesystem::path fullPath;
+	return FindLooseFile(fname, fullPath);
 }
 
 
@@ -251,19 +327,12 @@ bool FileSystem::IsDirectory(const string& dname) const
 
 string FileSystem::GetFullPath(const string& fname)
 {
-	const filesystem::path filePath{ fname };
-
 	shared_lock<shared_mutex> CS(s_mutex);
 
-	PathDesc* cur = m_searchPaths;
-	while (cur)
+	filesystem::path fullPath;
+	if (FindLooseFile(fname, fullPath))
 	{
-		auto fullPath = cur->fullPath / filePath;
-		if (filesystem::exists(fullPath))
-		{
-			return fullPath.string();
-		}
-		cur = cur->next;
+		return fullPath.string();
 	}
 	return "";
 }
@@ -279,6 +348,79 @@ string FileSystem::GetFileExtension(const string& fname)
 }
 
 
+bool FileSystem::ReadFile(const string& fname, FileData& outData) const
+{
+	shared_lock<shared_mutex> CS(s_mutex);
+
+	if (const AssetArchive* archive = FindArchive(fname))
+	{
+		return archive->ReadFile(fname, outData);
+	}
+
+	filesystem::path fullPath;
+	if (!FindLooseFile(fname, fullPath))
+	{
+		return false;
+	}
+
+	if (ReadLooseFile(fullPath, outData))
+	{
+		return true;
+	}
+
+	// The file has moved since it was found
+	ForgetLooseFile(fname);
+	return FindLooseFile(fname, fullPath) && ReadLooseFile(fullPath, outData);
+}
+
+
+void FileSystem::ClearLookupCache()
+{
+	lock_guard lock(m_lookupCacheMutex);
+	m_lookupCache.clear();
+}
+
+
+bool FileSystem::WriteFileAtomic(const string& fileName, span<const std::byte> data)
+{
+	return WriteFileAtomic(fileName, [data](ostream& outFile)
+		{
+			outFile.write((const char*)data.data(), (streamsize)data.size());
+			return true;
+		});
+}
+
+
+bool FileSystem::WriteFileAtomic(const string& fileName, const function<bool(ostream&)>& writer)
+{
+	const string tempFileName = fileName + ".tmp";
+
+	bool written = false;
+	{
+		ofstream outFile(tempFileName, ios::out | ios::binary | ios::trunc);
+		if (outFile)
+		{
+			written = writer(outFile);
+			outFile.close();
+			written = written && !outFile.fail();
+		}
+	}
+
+	error_code ec;
+	if (written)
+	{
+		filesystem::rename(tempFileName, fileName, ec);
+		if (!ec)
+		{
+			return true;
+		}
+	}
+
+	filesystem::remove(tempFileName, ec);
+	return false;
+}
+
+
 bool FileSystem::EnsureDirectory(const string& pathStr)
 {
 	shared_lock<shared_mutex> CS(s_mutex);
@@ -298,16 +440,26 @@ bool FileSystem::EnsureLogDirectory()
 }
 
 
+bool FileSystem::EnsureCacheDirectory()
+{
+	return EnsureDirectory(m_cachePath.string());
+}
+
+
 void FileSystem::Initialize()
 {
 	unique_lock<shared_mutex> CS(s_mutex);
 
 	// Get Path
+#if defined(_WIN32)
 	string pathStr;
 	pathStr.resize(s_maxPathLength, 0);
 	GetModuleFileNameA(nullptr, &pathStr[0], s_maxPathLength);
 
 	filesystem::path binFilePath{ pathStr };
+#else
+	filesystem::path binFilePath = filesystem::read_symlink("/proc/self/exe");
+#endif
 	filesystem::path binPath = binFilePath.remove_filename().parent_path();
 
 	filesystem::current_path(binPath);
@@ -329,6 +481,63 @@ void FileSystem::RemoveAllSearchPaths()
 		cur = temp;
 	}
 	m_searchPaths = nullptr;
+
+	ClearLookupCache();
+}
+
+
+const AssetArchive* FileSystem::FindArchive(const string& fname) const
+{
+	for (const auto& archive : m_archives)
+	{
+		if (archive->Contains(fname))
+		{
+			return archive.get();
+		}
+	}
+	return nullptr;
+}
+
+
+bool FileSystem::FindLooseFile(const string& fname, filesystem::path& outFullPath) const
+{
+	{
+		lock_guard lock(m_lookupCacheMutex);
+		auto it = m_lookupCache.find(fname);
+		if (it != m_lookupCache.end())
+		{
+			outFullPath = it->second;
+			return !outFullPath.empty();
+		}
+	}
+
+	const filesystem::path filePath{ fname };
+
+	filesystem::path foundPath;
+	PathDesc* cur = m_searchPaths;
+	while (cur)
+	{
+		auto fullPath = cur->fullPath / filePath;
+		if (filesystem::exists(fullPath))
+		{
+			foundPath = move(fullPath);
+			break;
+		}
+		cur = cur->next;
+	}
+
+	lock_guard lock(m_lookupCacheMutex);
+	m_lookupCache.emplace(fname, foundPath);
+
+	outFullPath = move(foundPath);
+	return !outFullPath.empty();
+}
+
+
+void FileSystem::ForgetLooseFile(const string& fname) const
+{
+	lock_guard lock(m_lookupCacheMutex);
+	m_lookupCache.erase(fname);
 }
 
 
@@ -13,6 +13,36 @@
 namespace Luna
 {
 
+// Forward declarations
+class AssetArchive;
+
+
+// Contents of a file read through the FileSystem.  Points into a file mapping, which it keeps open for as long as it,
+// or a copy of the owner, is alive.  Small loose files are read into memory that the owner keeps instead.
+class FileData
+{
+public:
+	FileData() = default;
+	FileData(std::shared_ptr<const void> owner, const std::byte* data, size_t size)
+		: m_owner{ std::move(owner) }
+		, m_data{ data }
+		, m_size{ size }
+	{}
+
+	const std::byte* GetData() const noexcept { return m_data; }
+	size_t GetSize() const noexcept { return m_size; }
+	std::span<const std::byte> GetSpan() const noexcept { return { m_data, m_size }; }
+
+	// Keeps the data alive, for anything that holds on to it past the FileData
+	const std::shared_ptr<const void>& GetOwner() const noexcept { return m_owner; }
+
+private:
+	std::shared_ptr<const void> m_owner;
+	const std::byte* m_data{ nullptr };
+	size_t m_size{ 0 };
+};
+
+
 class FileSystem : NonCopyable, NonMovable
 {
 public:
@@ -22,6 +52,7 @@ public:
 	const std::filesystem::path& GetBinaryPath() const { return m_binaryPath; }
 	const std::filesystem::path& GetRootPath() const { return m_rootPath; }
 	const std::filesystem::path& GetLogPath() const { return m_logPath; }
+	const std::filesystem::path& GetCachePath() const { return m_cachePath; }
 
 	// Sets root path to Bin\..
 	void SetDefaultRootPath();
@@ -33,19 +64,44 @@ public:
 
 	std::vector<std::filesystem::path> GetSearchPaths() const;
 
+	// Pack archives are searched before the loose files in the search paths, most recently mounted first
+	bool MountArchive(const std::string& archivePathStr);
+	void UnmountArchive(const std::string& archivePathStr);
+
 	bool Exists(const std::string& fname) const;
 	bool IsRegularFile(const std::string& fname) const;
 	bool IsDirectory(const std::string& dname) const;
+
+	// Only finds loose files, since files in archives have no path on disk
 	std::string GetFullPath(const std::string& pathStr);
 	std::string GetFileExtension(const std::string& fname);
 
+	// Reads a file from the mounted archives, or else from the search paths
+	bool ReadFile(const std::string& fname, FileData& outData) const;
+
+	// Where loose files were found, and which weren't found at all, is remembered until the search paths change.
+	// Call this after adding or removing files in the search paths.
+	void ClearLookupCache();
+
+	// Writes to a temporary next to the file and renames that over it, so a reader never sees a partial file.  If
+	// the writer returns false, or anything fails, the temporary is removed and any existing file is left alone.
+	static bool WriteFileAtomic(const std::string& fileName, std::span<const std::byte> data);
+	static bool WriteFileAtomic(const std::string& fileName, const std::function<bool(std::ostream&)>& writer);
+
 	bool EnsureDirectory(const std::string& pathStr);
 	bool EnsureLogDirectory();
+	bool EnsureCacheDirectory();
 
 private:
 	void Initialize();
 	void RemoveAllSearchPaths();
 
+	// Callers hold the search path lock.  Loose file lookups only check the search paths for names they haven't
+	// looked up before.
+	const AssetArchive* FindArchive(const std::string& fname) const;
+	bool FindLooseFile(const std::string& fname, std::filesystem::path& outFullPath) const;
+	void ForgetLooseFile(const std::string& fname) const;
+
 private:
 	std::string m_appName;
 
@@ -54,6 +110,7 @@ private:
 
 	std::filesystem::path m_rootPath;
 	std::filesystem::path m_logPath;
+	std::filesystem::path m_cachePath;
 
 	struct PathDesc
 	{
@@ -62,8 +119,17 @@ private:
 		PathDesc* next{ nullptr };
 	};
 	PathDesc* m_searchPaths{ nullptr };
+
+	std::vector<std::unique_ptr<AssetArchive>> m_archives;
+
+	// Lookup cache for loose files, with an empty path for files that weren't found
+	mutable std::mutex m_lookupCacheMutex;
+	mutable std::unordered_map<std::string, std::filesystem::path> m_lookupCache;
 };
 
+
+inline LogCategory LogFileSystem{ "LogFileSystem" };
+
 FileSystem* GetFileSystem();
 
 } // namespace Luna
\ No newline at end of file
@@ -0,0 +1,1298 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "BlockCompressor.h"
+
+#include "TextureInitializer.h"
+
+#include "Core/CpuFeatures.h"
+
+#include <immintrin.h>
+
+using namespace std;
+
+
+namespace
+{
+
+// Levels with fewer blocks than this are not worth splitting across jobs
+constexpr uint32_t s_minParallelBlocks = 32 * 32;
+constexpr uint32_t s_minBlockRowsPerBand = 2;
+
+// Least-squares passes over the endpoints of each block.  A pass is only kept if it lowers the error.
+constexpr uint32_t s_numRefinePasses = 2;
+
+// Where each palette entry sits between the two endpoints, used to solve for better endpoints.  Negative
+// entries are constants that the endpoints don't affect.
+constexpr float s_bc1Weights[16] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+constexpr float s_bc4Weights8[16] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+constexpr float s_bc4Weights6[16] = { 0.0f, 1.0f, 1.0f / 5.0f, 2.0f / 5.0f, 3.0f / 5.0f, 4.0f / 5.0f, -1.0f, -1.0f };
+
+// BC7 4-bit index interpolation weights, out of 64
+constexpr int32_t s_bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+
+enum class BlockFormat : uint8_t
+{
+	Unknown,
+	BC1,
+	BC3,
+	BC4,
+	BC5,
+	BC7
+};
+
+
+BlockFormat GetBlockFormat(Luna::Format format)
+{
+	using enum Luna::Format;
+
+	switch (format)
+	{
+	case BC1_UNorm:
+	case BC1_UNorm_Srgb:	return BlockFormat::BC1;
+	case BC3_UNorm:
+	case BC3_UNorm_Srgb:	return BlockFormat::BC3;
+	case BC4_UNorm:			return BlockFormat::BC4;
+	case BC5_UNorm:			return BlockFormat::BC5;
+	case BC7_UNorm:
+	case BC7_UNorm_Srgb:	return BlockFormat::BC7;
+	default:				return BlockFormat::Unknown;
+	}
+}
+
+
+uint32_t GetBlockBytes(BlockFormat blockFormat)
+{
+	switch (blockFormat)
+	{
+	case BlockFormat::BC1:
+	case BlockFormat::BC4:	return 8;
+	case BlockFormat::BC3:
+	case BlockFormat::BC5:
+	case BlockFormat::BC7:	return 16;
+	default:				return 0;
+	}
+}
+
+
+// The channels that the format stores, which are the ones the PSNR is measured over
+uint32_t GetNumStoredChannels(BlockFormat blockFormat)
+{
+	switch (blockFormat)
+	{
+	case BlockFormat::BC1:	return 3;
+	case BlockFormat::BC4:	return 1;
+	case BlockFormat::BC5:	return 2;
+	default:				return 4;
+	}
+}
+
+
+enum class KernelLevel : uint8_t
+{
+	Scalar,
+	SSE41,
+	AVX2
+};
+
+
+KernelLevel GetMaxKernelLevel() noexcept
+{
+	if (Luna::HasSSE41() && Luna::HasAVX2())
+	{
+		return KernelLevel::AVX2;
+	}
+	return Luna::HasSSE41() ? KernelLevel::SSE41 : KernelLevel::Scalar;
+}
+
+const KernelLevel s_maxKernelLevel = GetMaxKernelLevel();
+
+
+// One 4x4 block of texels, stored channel by channel, so that a row of texels in one channel loads straight
+// into a register
+struct Block
+{
+	alignas(32) int32_t texels[4][16];
+};
+
+
+// The colors that a block decodes to, given its endpoints
+struct Palette
+{
+	int32_t entries[16][4]{};
+	uint32_t numEntries{ 0 };
+};
+
+
+Block ExtractChannel(const Block& block, uint32_t channel)
+{
+	Block result{};
+	memcpy(result.texels[0], block.texels[channel], sizeof(block.texels[0]));
+	return result;
+}
+
+
+void LoadBlock(const std::byte* src, size_t rowPitch, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, Block& outBlock)
+{
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		const uint32_t srcY = min(blockY * 4 + y, height - 1);
+		const uint8_t* row = (const uint8_t*)(src + srcY * rowPitch);
+
+		for (uint32_t x = 0; x < 4; ++x)
+		{
+			const uint8_t* texel = row + min(blockX * 4 + x, width - 1) * 4;
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				outBlock.texels[c][y * 4 + x] = texel[c];
+			}
+		}
+	}
+}
+
+
+// Picks the nearest palette entry for each texel.  Everything is integer, so that each kernel makes exactly
+// the same choices, ties included.  Returns the summed squared error of the block.
+uint32_t FitIndicesScalar(const Block& block, const Palette& palette, uint32_t numChannels, uint8_t* outIndices)
+{
+	uint32_t totalError = 0;
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		int32_t bestError = INT32_MAX;
+		uint32_t bestIndex = 0;
+
+		for (uint32_t p = 0; p < palette.numEntries; ++p)
+		{
+			int32_t error = 0;
+			for (uint32_t c = 0; c < numChannels; ++c)
+			{
+				const int32_t delta = block.texels[c][i] - palette.entries[p][c];
+				error += delta * delta;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				bestIndex = p;
+			}
+		}
+
+		outIndices[i] = (uint8_t)bestIndex;
+		totalError += (uint32_t)bestError;
+	}
+
+	return totalError;
+}
+
+
+LUNA_TARGET_SSE41 uint32_t FitIndicesSSE41(const Block& block, const Palette& palette, uint32_t numChannels, uint8_t* outIndices)
+{
+	__m128i totalError = _mm_setzero_si128();
+
+	for (uint32_t i = 0; i < 16; i += 4)
+	{
+		__m128i texels[4];
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			texels[c] = _mm_load_si128((const __m128i*)&block.texels[c][i]);
+		}
+
+		__m128i bestError = _mm_set1_epi32(INT32_MAX);
+		__m128i bestIndex = _mm_setzero_si128();
+
+		for (uint32_t p = 0; p < palette.numEntries; ++p)
+		{
+			__m128i error = _mm_setzero_si128();
+			for (uint32_t c = 0; c < numChannels; ++c)
+			{
+				const __m128i delta = _mm_sub_epi32(texels[c], _mm_set1_epi32(palette.entries[p][c]));
+				error = _mm_add_epi32(error, _mm_mullo_epi32(delta, delta));
+			}
+
+			// Strictly less, so that the first of several equal entries wins, as in the scalar path
+			const __m128i isBetter = _mm_cmplt_epi32(error, bestError);
+			bestError = _mm_min_epi32(error, bestError);
+			bestIndex = _mm_blendv_epi8(bestIndex, _mm_set1_epi32((int)p), isBetter);
+		}
+
+		const __m128i packed = _mm_packs_epi32(bestIndex, bestIndex);
+		_mm_storeu_si32(outIndices + i, _mm_packus_epi16(packed, packed));
+
+		totalError = _mm_add_epi32(totalError, bestError);
+	}
+
+	totalError = _mm_add_epi32(totalError, _mm_shuffle_epi32(totalError, _MM_SHUFFLE(1, 0, 3, 2)));
+	totalError = _mm_add_epi32(totalError, _mm_shuffle_epi32(totalError, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t)_mm_cvtsi128_si32(totalError);
+}
+
+
+LUNA_TARGET_AVX2 uint32_t FitIndicesAVX2(const Block& block, const Palette& palette, uint32_t numChannels, uint8_t* outIndices)
+{
+	__m256i totalError = _mm256_setzero_si256();
+
+	for (uint32_t i = 0; i < 16; i += 8)
+	{
+		__m256i texels[4];
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			texels[c] = _mm256_load_si256((const __m256i*)&block.texels[c][i]);
+		}
+
+		__m256i bestError = _mm256_set1_epi32(INT32_MAX);
+		__m256i bestIndex = _mm256_setzero_si256();
+
+		for (uint32_t p = 0; p < palette.numEntries; ++p)
+		{
+			__m256i error = _mm256_setzero_si256();
+			for (uint32_t c = 0; c < numChannels; ++c)
+			{
+				const __m256i delta = _mm256_sub_epi32(texels[c], _mm256_set1_epi32(palette.entries[p][c]));
+				error = _mm256_add_epi32(error, _mm256_mullo_epi32(delta, delta));
+			}
+
+			const __m256i isBetter = _mm256_cmpgt_epi32(bestError, error);
+			bestError = _mm256_min_epi32(error, bestError);
+			bestIndex = _mm256_blendv_epi8(bestIndex, _mm256_set1_epi32((int)p), isBetter);
+		}
+
+		// Pack within each 128-bit lane, then gather the two lanes' four bytes
+		const __m256i packed16 = _mm256_packs_epi32(bestIndex, bestIndex);
+		const __m256i packed8 = _mm256_packus_epi16(packed16, packed16);
+		_mm_storeu_si32(outIndices + i, _mm256_castsi256_si128(packed8));
+		_mm_storeu_si32(outIndices + i + 4, _mm256_extracti128_si256(packed8, 1));
+
+		totalError = _mm256_add_epi32(totalError, bestError);
+	}
+
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(totalError), _mm256_extracti128_si256(totalError, 1));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t)_mm_cvtsi128_si32(sum);
+}
+
+
+uint32_t FitIndices(KernelLevel kernel, const Block& block, const Palette& palette, uint32_t numChannels, uint8_t* outIndices)
+{
+	switch (kernel)
+	{
+	case KernelLevel::AVX2:		return FitIndicesAVX2(block, palette, numChannels, outIndices);
+	case KernelLevel::SSE41:	return FitIndicesSSE41(block, palette, numChannels, outIndices);
+	default:					return FitIndicesScalar(block, palette, numChannels, outIndices);
+	}
+}
+
+
+// Starting endpoints: the extremes of the block along its principal axis, pulled in by 1/16 of the range at
+// each end, since the texels out at the extremes are usually few
+void FindAxisEndpoints(const Block& block, uint32_t numChannels, float* outHigh, float* outLow)
+{
+	float mean[4]{};
+	for (uint32_t c = 0; c < numChannels; ++c)
+	{
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			mean[c] += (float)block.texels[c][i];
+		}
+		mean[c] /= 16.0f;
+	}
+
+	float covariance[4][4]{};
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		for (uint32_t a = 0; a < numChannels; ++a)
+		{
+			const float deltaA = (float)block.texels[a][i] - mean[a];
+			for (uint32_t b = 0; b < numChannels; ++b)
+			{
+				covariance[a][b] += deltaA * ((float)block.texels[b][i] - mean[b]);
+			}
+		}
+	}
+
+	// Power iteration, starting from the row of the channel that varies most
+	uint32_t widestChannel = 0;
+	for (uint32_t c = 1; c < numChannels; ++c)
+	{
+		if (covariance[c][c] > covariance[widestChannel][widestChannel])
+		{
+			widestChannel = c;
+		}
+	}
+
+	float axis[4]{};
+	for (uint32_t c = 0; c < numChannels; ++c)
+	{
+		axis[c] = covariance[widestChannel][c];
+	}
+
+	for (uint32_t iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4]{};
+		float largest = 0.0f;
+		for (uint32_t a = 0; a < numChannels; ++a)
+		{
+			for (uint32_t b = 0; b < numChannels; ++b)
+			{
+				next[a] += covariance[a][b] * axis[b];
+			}
+			largest = max(largest, fabsf(next[a]));
+		}
+
+		if (largest == 0.0f)
+		{
+			break;
+		}
+
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			axis[c] = next[c] / largest;
+		}
+	}
+
+	float lengthSq = 0.0f;
+	for (uint32_t c = 0; c < numChannels; ++c)
+	{
+		lengthSq += axis[c] * axis[c];
+	}
+
+	// A flat block has no axis, and both endpoints land on the mean
+	if (lengthSq > 0.0f)
+	{
+		const float invLength = 1.0f / sqrtf(lengthSq);
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			axis[c] *= invLength;
+		}
+	}
+
+	float minT = FLT_MAX;
+	float maxT = -FLT_MAX;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		float t = 0.0f;
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			t += ((float)block.texels[c][i] - mean[c]) * axis[c];
+		}
+		minT = min(minT, t);
+		maxT = max(maxT, t);
+	}
+
+	const float inset = (maxT - minT) / 16.0f;
+	minT += inset;
+	maxT -= inset;
+
+	for (uint32_t c = 0; c < numChannels; ++c)
+	{
+		outHigh[c] = mean[c] + axis[c] * maxT;
+		outLow[c] = mean[c] + axis[c] * minT;
+	}
+}
+
+
+// Solves for the endpoints that minimize the squared error of the chosen indices, given where each palette
+// entry sits between the endpoints.  Fails when every texel uses the same entry.
+bool RefineEndpoints(const Block& block, uint32_t numChannels, const uint8_t* indices, const float* indexWeights, float* outE0, float* outE1)
+{
+	float a = 0.0f;
+	float b = 0.0f;
+	float c = 0.0f;
+	float x0[4]{};
+	float x1[4]{};
+
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const float w = indexWeights[indices[i]];
+		if (w < 0.0f)
+		{
+			continue;
+		}
+
+		const float w0 = 1.0f - w;
+		a += w0 * w0;
+		b += w0 * w;
+		c += w * w;
+
+		for (uint32_t ch = 0; ch < numChannels; ++ch)
+		{
+			x0[ch] += w0 * (float)block.texels[ch][i];
+			x1[ch] += w * (float)block.texels[ch][i];
+		}
+	}
+
+	const float det = a * c - b * b;
+	if (fabsf(det) < 1e-6f)
+	{
+		return false;
+	}
+
+	const float invDet = 1.0f / det;
+	for (uint32_t ch = 0; ch < numChannels; ++ch)
+	{
+		outE0[ch] = (c * x0[ch] - b * x1[ch]) * invDet;
+		outE1[ch] = (a * x1[ch] - b * x0[ch]) * invDet;
+	}
+
+	return true;
+}
+
+
+int32_t QuantizeChannel(float value, int32_t maxValue)
+{
+	return clamp((int32_t)lroundf(value * (float)maxValue / 255.0f), 0, maxValue);
+}
+
+
+uint16_t QuantizeRGB565(const float* color)
+{
+	return (uint16_t)((QuantizeChannel(color[0], 31) << 11) | (QuantizeChannel(color[1], 63) << 5) | QuantizeChannel(color[2], 31));
+}
+
+
+void ExpandRGB565(uint16_t color, int32_t* outColor)
+{
+	const int32_t r = (color >> 11) & 31;
+	const int32_t g = (color >> 5) & 63;
+	const int32_t b = color & 31;
+
+	outColor[0] = (r << 3) | (r >> 2);
+	outColor[1] = (g << 2) | (g >> 4);
+	outColor[2] = (b << 3) | (b >> 2);
+	outColor[3] = 255;
+}
+
+
+// Color blocks in BC2 and BC3 always use four colors, whatever the endpoint order
+Palette BuildBC1Palette(uint16_t c0, uint16_t c1, bool alwaysFourColors)
+{
+	Palette palette{ .numEntries = 4 };
+	ExpandRGB565(c0, palette.entries[0]);
+	ExpandRGB565(c1, palette.entries[1]);
+
+	const int32_t* e0 = palette.entries[0];
+	const int32_t* e1 = palette.entries[1];
+
+	if (c0 > c1 || alwaysFourColors)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette.entries[2][c] = (2 * e0[c] + e1[c] + 1) / 3;
+			palette.entries[3][c] = (e0[c] + 2 * e1[c] + 1) / 3;
+		}
+		palette.entries[2][3] = 255;
+		palette.entries[3][3] = 255;
+	}
+	else
+	{
+		// Three colors and transparent black
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette.entries[2][c] = (e0[c] + e1[c] + 1) / 2;
+			palette.entries[3][c] = 0;
+		}
+		palette.entries[2][3] = 255;
+		palette.entries[3][3] = 0;
+	}
+
+	return palette;
+}
+
+
+Palette BuildBC4Palette(int32_t e0, int32_t e1)
+{
+	Palette palette{ .numEntries = 8 };
+	palette.entries[0][0] = e0;
+	palette.entries[1][0] = e1;
+
+	if (e0 > e1)
+	{
+		for (int32_t k = 2; k < 8; ++k)
+		{
+			palette.entries[k][0] = ((8 - k) * e0 + (k - 1) * e1 + 3) / 7;
+		}
+	}
+	else
+	{
+		for (int32_t k = 2; k < 6; ++k)
+		{
+			palette.entries[k][0] = ((6 - k) * e0 + (k - 1) * e1 + 2) / 5;
+		}
+		palette.entries[6][0] = 0;
+		palette.entries[7][0] = 255;
+	}
+
+	return palette;
+}
+
+
+Palette BuildBC7Palette(const int32_t* e0, const int32_t* e1)
+{
+	Palette palette{ .numEntries = 16 };
+	for (uint32_t k = 0; k < 16; ++k)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			palette.entries[k][c] = ((64 - s_bc7Weights[k]) * e0[c] + s_bc7Weights[k] * e1[c] + 32) >> 6;
+		}
+	}
+	return palette;
+}
+
+
+struct BlockCandidate
+{
+	int32_t e0[4]{};
+	int32_t e1[4]{};
+	uint8_t indices[16]{};
+	uint32_t error{ UINT32_MAX };
+};
+
+
+// Returns true if the endpoints beat the best so far
+bool TryBC1Endpoints(KernelLevel kernel, const Block& block, const float* high, const float* low, bool alwaysFourColors, BlockCandidate& best)
+{
+	uint16_t c0 = QuantizeRGB565(high);
+	uint16_t c1 = QuantizeRGB565(low);
+
+	// Four colors need c0 > c1.  Equal endpoints fall back to three colors, where the transparent black entry
+	// must not be picked for an opaque texel.
+	if (c0 < c1)
+	{
+		swap(c0, c1);
+	}
+
+	Palette palette = BuildBC1Palette(c0, c1, alwaysFourColors);
+	if (c0 == c1 && !alwaysFourColors)
+	{
+		palette.numEntries = 3;
+	}
+
+	BlockCandidate candidate{ .e0 = { c0 }, .e1 = { c1 } };
+	candidate.error = FitIndices(kernel, block, palette, 3, candidate.indices);
+
+	if (candidate.error >= best.error)
+	{
+		return false;
+	}
+
+	best = candidate;
+	return true;
+}
+
+
+void EncodeBC1Block(KernelLevel kernel, const Block& block, bool alwaysFourColors, uint8_t* dst)
+{
+	float high[4];
+	float low[4];
+	FindAxisEndpoints(block, 3, high, low);
+
+	BlockCandidate best;
+	TryBC1Endpoints(kernel, block, high, low, alwaysFourColors, best);
+
+	for (uint32_t pass = 0; pass < s_numRefinePasses && best.error > 0 && best.e0[0] != best.e1[0]; ++pass)
+	{
+		if (!RefineEndpoints(block, 3, best.indices, s_bc1Weights, high, low) ||
+			!TryBC1Endpoints(kernel, block, high, low, alwaysFourColors, best))
+		{
+			break;
+		}
+	}
+
+	uint32_t indexBits = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		indexBits |= (uint32_t)best.indices[i] << (i * 2);
+	}
+
+	const uint16_t c0 = (uint16_t)best.e0[0];
+	const uint16_t c1 = (uint16_t)best.e1[0];
+	memcpy(dst, &c0, 2);
+	memcpy(dst + 2, &c1, 2);
+	memcpy(dst + 4, &indexBits, 4);
+}
+
+
+bool TryBC4Endpoints(KernelLevel kernel, const Block& block, float a, float b, bool sixValues, BlockCandidate& best)
+{
+	const int32_t low = clamp((int32_t)lroundf(min(a, b)), 0, 255);
+	const int32_t high = clamp((int32_t)lroundf(max(a, b)), 0, 255);
+
+	// The endpoint order selects the mode.  Equal endpoints decode as six values, which is exact for either.
+	const int32_t e0 = sixValues ? low : high;
+	const int32_t e1 = sixValues ? high : low;
+
+	const Palette palette = BuildBC4Palette(e0, e1);
+
+	BlockCandidate candidate{ .e0 = { e0 }, .e1 = { e1 } };
+	candidate.error = FitIndices(kernel, block, palette, 1, candidate.indices);
+
+	if (candidate.error >= best.error)
+	{
+		return false;
+	}
+
+	best = candidate;
+	return true;
+}
+
+
+// Encodes the first channel of the block
+void EncodeBC4Block(KernelLevel kernel, const Block& block, uint8_t* dst)
+{
+	int32_t minValue = 255;
+	int32_t maxValue = 0;
+	int32_t minInner = 255;
+	int32_t maxInner = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const int32_t value = block.texels[0][i];
+		minValue = min(minValue, value);
+		maxValue = max(maxValue, value);
+
+		if (value != 0 && value != 255)
+		{
+			minInner = min(minInner, value);
+			maxInner = max(maxInner, value);
+		}
+	}
+
+	BlockCandidate best;
+
+	// Eight interpolated values across the whole range, then six across the range without the 0 and 255
+	// texels, which that mode stores exactly
+	for (const bool sixValues : { false, true })
+	{
+		const float a = (float)(sixValues ? minInner : minValue);
+		const float b = (float)(sixValues ? maxInner : maxValue);
+		if (a > b)
+		{
+			continue;
+		}
+
+		bool improved = TryBC4Endpoints(kernel, block, a, b, sixValues, best);
+		const float* weights = sixValues ? s_bc4Weights6 : s_bc4Weights8;
+
+		for (uint32_t pass = 0; pass < s_numRefinePasses && improved && best.error > 0; ++pass)
+		{
+			float e0 = 0.0f;
+			float e1 = 0.0f;
+			improved = RefineEndpoints(block, 1, best.indices, weights, &e0, &e1) &&
+				TryBC4Endpoints(kernel, block, e0, e1, sixValues, best);
+		}
+	}
+
+	uint64_t bits = (uint64_t)best.e0[0] | ((uint64_t)best.e1[0] << 8);
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		bits |= (uint64_t)best.indices[i] << (16 + i * 3);
+	}
+	memcpy(dst, &bits, 8);
+}
+
+
+// Picks the shared low bit for an endpoint of 7-bit channels that rounds it closest
+void QuantizeBC7Endpoint(const float* color, int32_t* outColor)
+{
+	int32_t bestError = INT32_MAX;
+	for (int32_t pBit = 0; pBit < 2; ++pBit)
+	{
+		int32_t quantized[4];
+		int32_t error = 0;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			quantized[c] = (clamp((int32_t)lroundf((color[c] - (float)pBit) / 2.0f), 0, 127) << 1) | pBit;
+
+			const int32_t delta = quantized[c] - clamp((int32_t)lroundf(color[c]), 0, 255);
+			error += delta * delta;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			copy_n(quantized, 4, outColor);
+		}
+	}
+}
+
+
+bool TryBC7Endpoints(KernelLevel kernel, const Block& block, const float* high, const float* low, BlockCandidate& best)
+{
+	BlockCandidate candidate;
+	QuantizeBC7Endpoint(low, candidate.e0);
+	QuantizeBC7Endpoint(high, candidate.e1);
+
+	const Palette palette = BuildBC7Palette(candidate.e0, candidate.e1);
+	candidate.error = FitIndices(kernel, block, palette, 4, candidate.indices);
+
+	if (candidate.error >= best.error)
+	{
+		return false;
+	}
+
+	best = candidate;
+	return true;
+}
+
+
+class BitWriter
+{
+public:
+	void Write(uint64_t value, uint32_t numBits)
+	{
+		if (m_position < 64)
+		{
+			m_bits[0] |= value << m_position;
+			if (m_position + numBits > 64)
+			{
+				m_bits[1] |= value >> (64 - m_position);
+			}
+		}
+		else
+		{
+			m_bits[1] |= value << (m_position - 64);
+		}
+		m_position += numBits;
+	}
+
+	void CopyTo(uint8_t* dst) const
+	{
+		assert(m_position == 128);
+		memcpy(dst, m_bits, 16);
+	}
+
+private:
+	uint64_t m_bits[2]{};
+	uint32_t m_position{ 0 };
+};
+
+
+class BitReader
+{
+public:
+	explicit BitReader(const uint8_t* src)
+	{
+		memcpy(m_bits, src, 16);
+	}
+
+	uint32_t Read(uint32_t numBits)
+	{
+		uint64_t value = 0;
+		if (m_position < 64)
+		{
+			value = m_bits[0] >> m_position;
+			if (m_position + numBits > 64)
+			{
+				value |= m_bits[1] << (64 - m_position);
+			}
+		}
+		else
+		{
+			value = m_bits[1] >> (m_position - 64);
+		}
+		m_position += numBits;
+
+		return (uint32_t)(value & ((1ull << numBits) - 1));
+	}
+
+private:
+	uint64_t m_bits[2]{};
+	uint32_t m_position{ 0 };
+};
+
+
+// BC7 mode 6 only: one subset, 7-bit RGBA endpoints with a low bit each, and 4-bit indices.  The other modes
+// trade endpoint precision for partitions, which pays off on blocks with several distinct colors, but each one
+// multiplies the search.
+void EncodeBC7Block(KernelLevel kernel, const Block& block, uint8_t* dst)
+{
+	float high[4];
+	float low[4];
+	FindAxisEndpoints(block, 4, high, low);
+
+	BlockCandidate best;
+	TryBC7Endpoints(kernel, block, high, low, best);
+
+	float weights[16];
+	for (uint32_t k = 0; k < 16; ++k)
+	{
+		weights[k] = (float)s_bc7Weights[k] / 64.0f;
+	}
+
+	for (uint32_t pass = 0; pass < s_numRefinePasses && best.error > 0; ++pass)
+	{
+		// The palette runs from e0 to e1, so the solved endpoints come back as (low, high)
+		if (!RefineEndpoints(block, 4, best.indices, weights, low, high) ||
+			!TryBC7Endpoints(kernel, block, high, low, best))
+		{
+			break;
+		}
+	}
+
+	// The high bit of the first index is implied zero, so flip the palette if it's set
+	if (best.indices[0] & 8)
+	{
+		swap(best.e0, best.e1);
+		for (auto& index : best.indices)
+		{
+			index = (uint8_t)(15 - index);
+		}
+	}
+
+	BitWriter writer;
+	writer.Write(1 << 6, 7);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		writer.Write((uint64_t)best.e0[c] >> 1, 7);
+		writer.Write((uint64_t)best.e1[c] >> 1, 7);
+	}
+	writer.Write((uint64_t)best.e0[0] & 1, 1);
+	writer.Write((uint64_t)best.e1[0] & 1, 1);
+
+	writer.Write(best.indices[0], 3);
+	for (uint32_t i = 1; i < 16; ++i)
+	{
+		writer.Write(best.indices[i], 4);
+	}
+	writer.CopyTo(dst);
+}
+
+
+void EncodeBlock(KernelLevel kernel, BlockFormat blockFormat, const Block& block, uint8_t* dst)
+{
+	switch (blockFormat)
+	{
+	case BlockFormat::BC1:
+		EncodeBC1Block(kernel, block, false, dst);
+		break;
+
+	case BlockFormat::BC3:
+		EncodeBC4Block(kernel, ExtractChannel(block, 3), dst);
+		EncodeBC1Block(kernel, block, true, dst + 8);
+		break;
+
+	case BlockFormat::BC4:
+		EncodeBC4Block(kernel, block, dst);
+		break;
+
+	case BlockFormat::BC5:
+		EncodeBC4Block(kernel, block, dst);
+		EncodeBC4Block(kernel, ExtractChannel(block, 1), dst + 8);
+		break;
+
+	case BlockFormat::BC7:
+		EncodeBC7Block(kernel, block, dst);
+		break;
+
+	default:
+		assert(false);
+		break;
+	}
+}
+
+
+void DecodeBC1Block(const uint8_t* src, bool alwaysFourColors, uint8_t (*outTexels)[4])
+{
+	uint16_t c0;
+	uint16_t c1;
+	uint32_t indexBits;
+	memcpy(&c0, src, 2);
+	memcpy(&c1, src + 2, 2);
+	memcpy(&indexBits, src + 4, 4);
+
+	const Palette palette = BuildBC1Palette(c0, c1, alwaysFourColors);
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const int32_t* entry = palette.entries[(indexBits >> (i * 2)) & 3];
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			outTexels[i][c] = (uint8_t)entry[c];
+		}
+	}
+}
+
+
+void DecodeBC4Block(const uint8_t* src, uint32_t channel, uint8_t (*outTexels)[4])
+{
+	uint64_t bits;
+	memcpy(&bits, src, 8);
+
+	const Palette palette = BuildBC4Palette((int32_t)(bits & 0xFF), (int32_t)((bits >> 8) & 0xFF));
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		outTexels[i][channel] = (uint8_t)palette.entries[(bits >> (16 + i * 3)) & 7][0];
+	}
+}
+
+
+void DecodeBC7Block(const uint8_t* src, uint8_t (*outTexels)[4])
+{
+	BitReader reader{ src };
+
+	// Only mode 6 is decoded, which is the only one the encoder writes
+	if (reader.Read(7) != (1 << 6))
+	{
+		assert(false);
+		memset(outTexels, 0, 16 * 4);
+		return;
+	}
+
+	int32_t e0[4];
+	int32_t e1[4];
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		e0[c] = (int32_t)reader.Read(7) << 1;
+		e1[c] = (int32_t)reader.Read(7) << 1;
+	}
+
+	const int32_t pBit0 = (int32_t)reader.Read(1);
+	const int32_t pBit1 = (int32_t)reader.Read(1);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		e0[c] |= pBit0;
+		e1[c] |= pBit1;
+	}
+
+	const Palette palette = BuildBC7Palette(e0, e1);
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const int32_t* entry = palette.entries[reader.Read(i == 0 ? 3 : 4)];
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			outTexels[i][c] = (uint8_t)entry[c];
+		}
+	}
+}
+
+
+void DecodeBlock(BlockFormat blockFormat, const uint8_t* src, uint8_t (*outTexels)[4])
+{
+	switch (blockFormat)
+	{
+	case BlockFormat::BC1:
+		DecodeBC1Block(src, false, outTexels);
+		break;
+
+	case BlockFormat::BC3:
+		DecodeBC1Block(src + 8, true, outTexels);
+		DecodeBC4Block(src, 3, outTexels);
+		break;
+
+	case BlockFormat::BC4:
+	case BlockFormat::BC5:
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			outTexels[i][0] = outTexels[i][1] = outTexels[i][2] = 0;
+			outTexels[i][3] = 255;
+		}
+		DecodeBC4Block(src, 0, outTexels);
+		if (blockFormat == BlockFormat::BC5)
+		{
+			DecodeBC4Block(src + 8, 1, outTexels);
+		}
+		break;
+
+	case BlockFormat::BC7:
+		DecodeBC7Block(src, outTexels);
+		break;
+
+	default:
+		assert(false);
+		break;
+	}
+}
+
+
+struct BlockLevelContext
+{
+	KernelLevel kernel{ KernelLevel::Scalar };
+	BlockFormat blockFormat{ BlockFormat::Unknown };
+	uint32_t blockBytes{ 0 };
+
+	const std::byte* src{ nullptr };
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	size_t srcRowPitch{ 0 };
+
+	std::byte* dst{ nullptr };
+	uint32_t numBlocksWide{ 0 };
+	uint32_t numBlocksHigh{ 0 };
+	size_t dstRowPitch{ 0 };
+};
+
+
+void EncodeBand(const BlockLevelContext& level, uint32_t firstBlockRow, uint32_t endBlockRow)
+{
+	Block block;
+
+	for (uint32_t blockY = firstBlockRow; blockY < endBlockRow; ++blockY)
+	{
+		uint8_t* dstRow = (uint8_t*)(level.dst + blockY * level.dstRowPitch);
+
+		for (uint32_t blockX = 0; blockX < level.numBlocksWide; ++blockX)
+		{
+			LoadBlock(level.src, level.srcRowPitch, level.width, level.height, blockX, blockY, block);
+			EncodeBlock(level.kernel, level.blockFormat, block, dstRow + blockX * level.blockBytes);
+		}
+	}
+}
+
+
+// Summed squared error of one compressed level against its source, over the first numChannels channels
+uint64_t MeasureLevelError(Luna::Format format, const Luna::TextureSubresourceData& srcLevel, const Luna::TextureSubresourceData& dstLevel, uint32_t numChannels)
+{
+	vector<std::byte> decoded((size_t)dstLevel.width * dstLevel.height * 4);
+	Luna::DecompressBlocks(format, dstLevel.data, dstLevel.width, dstLevel.height, decoded.data());
+
+	uint64_t error = 0;
+	for (uint32_t y = 0; y < srcLevel.height; ++y)
+	{
+		const uint8_t* srcRow = (const uint8_t*)(srcLevel.data + y * srcLevel.rowPitch);
+		const uint8_t* decodedRow = (const uint8_t*)(decoded.data() + (size_t)y * srcLevel.width * 4);
+
+		for (uint32_t x = 0; x < srcLevel.width * 4; x += 4)
+		{
+			for (uint32_t c = 0; c < numChannels; ++c)
+			{
+				const int32_t delta = (int32_t)srcRow[x + c] - (int32_t)decodedRow[x + c];
+				error += (uint64_t)(delta * delta);
+			}
+		}
+	}
+
+	return error;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+const char* GetTextureUsageName(TextureUsage usage)
+{
+	switch (usage)
+	{
+	case TextureUsage::Albedo:				return "Albedo";
+	case TextureUsage::AlbedoHighQuality:	return "AlbedoHighQuality";
+	case TextureUsage::NormalMap:			return "NormalMap";
+	case TextureUsage::Mask:				return "Mask";
+	default:								return "Default";
+	}
+}
+
+
+double BlockCompressionStats::GetMegapixelsPerSecond() const noexcept
+{
+	return encodeSeconds > 0.0 ? (double)numTexels / (encodeSeconds * 1.0e6) : 0.0;
+}
+
+
+Format GetBlockCompressedFormat(TextureUsage usage, bool hasTranslucency, bool isSrgb)
+{
+	Format format = Format::Unknown;
+
+	switch (usage)
+	{
+	case TextureUsage::Albedo:				format = hasTranslucency ? Format::BC3_UNorm : Format::BC1_UNorm; break;
+	case TextureUsage::AlbedoHighQuality:	format = Format::BC7_UNorm; break;
+	case TextureUsage::NormalMap:			return Format::BC5_UNorm;
+	case TextureUsage::Mask:				return Format::BC4_UNorm;
+	default:								return Format::Unknown;
+	}
+
+	return isSrgb ? MakeSrgb(format) : format;
+}
+
+
+const char* GetBlockCompressedFormatName(Format format)
+{
+	switch (GetBlockFormat(format))
+	{
+	case BlockFormat::BC1:	return "BC1";
+	case BlockFormat::BC3:	return "BC3";
+	case BlockFormat::BC4:	return "BC4";
+	case BlockFormat::BC5:	return "BC5";
+	case BlockFormat::BC7:	return "BC7";
+	default:				return "Unknown";
+	}
+}
+
+
+bool IsBlockCompressionSupported(Format format)
+{
+	return format == Format::RGBA8_UNorm || format == Format::SRGBA8_UNorm;
+}
+
+
+bool CompressTexture(const BlockCompressionDesc& desc, const TextureInitializer& srcTexInit, vector<std::byte>& outStorage,
+	TextureInitializer& outTexInit, BlockCompressionStats* outStats)
+{
+	const BlockFormat blockFormat = GetBlockFormat(desc.format);
+	if (blockFormat == BlockFormat::Unknown ||
+		!IsBlockCompressionSupported(srcTexInit.format) ||
+		srcTexInit.dimension != TextureDimension::Texture2D ||
+		srcTexInit.arraySizeOrDepth != 1 ||
+		srcTexInit.subResourceData.empty())
+	{
+		return false;
+	}
+
+	const uint32_t blockBytes = GetBlockBytes(blockFormat);
+
+	outTexInit.format = desc.format;
+	outTexInit.dimension = TextureDimension::Texture2D;
+	outTexInit.width = srcTexInit.width;
+	outTexInit.height = srcTexInit.height;
+	outTexInit.arraySizeOrDepth = 1;
+	outTexInit.numMips = srcTexInit.numMips;
+	outTexInit.subResourceData.clear();
+	outTexInit.subResourceData.reserve(srcTexInit.subResourceData.size());
+
+	// Levels are packed back to back, as in a DDS file.  Blocks are 8 or 16 bytes, which already satisfies
+	// the Vulkan buffer offset alignment.
+	size_t totalBytes = 0;
+	for (const auto& srcLevel : srcTexInit.subResourceData)
+	{
+		size_t numBytes = 0;
+		size_t rowBytes = 0;
+		GetSurfaceInfo(srcLevel.width, srcLevel.height, desc.format, &numBytes, &rowBytes, nullptr, nullptr, nullptr);
+
+		TextureSubresourceData subResourceData{
+			.rowPitch			= rowBytes,
+			.slicePitch			= numBytes,
+			.bufferOffset		= totalBytes,
+			.mipLevel			= srcLevel.mipLevel,
+			.baseArrayLayer		= 0,
+			.layerCount			= 1,
+			.width				= srcLevel.width,
+			.height				= srcLevel.height,
+			.depth				= 1
+		};
+		outTexInit.subResourceData.push_back(subResourceData);
+
+		totalBytes += numBytes;
+	}
+
+	// The upload path copies whole 16-byte blocks
+	outStorage.resize(Math::AlignUp(totalBytes, 16));
+	for (auto& subResourceData : outTexInit.subResourceData)
+	{
+		subResourceData.data = outStorage.data() + subResourceData.bufferOffset;
+	}
+
+	outTexInit.baseData = outStorage.data();
+	outTexInit.totalBytes = totalBytes;
+
+	const KernelLevel kernel = desc.allowSimd ? s_maxKernelLevel : KernelLevel::Scalar;
+	JobSystem* jobSystem = desc.allowParallel ? GetJobSystem() : nullptr;
+
+	const auto startTime = chrono::steady_clock::now();
+
+	for (size_t levelIndex = 0; levelIndex < outTexInit.subResourceData.size(); ++levelIndex)
+	{
+		const auto& srcLevel = srcTexInit.subResourceData[levelIndex];
+		const auto& dstLevel = outTexInit.subResourceData[levelIndex];
+
+		const BlockLevelContext level{
+			.kernel			= kernel,
+			.blockFormat	= blockFormat,
+			.blockBytes		= blockBytes,
+			.src			= srcLevel.data,
+			.width			= srcLevel.width,
+			.height			= srcLevel.height,
+			.srcRowPitch	= srcLevel.rowPitch,
+			.dst			= dstLevel.data,
+			.numBlocksWide	= (uint32_t)(dstLevel.rowPitch / blockBytes),
+			.numBlocksHigh	= (uint32_t)(dstLevel.slicePitch / dstLevel.rowPitch),
+			.dstRowPitch	= dstLevel.rowPitch
+		};
+
+		const uint32_t numBlocks = level.numBlocksWide * level.numBlocksHigh;
+		if (jobSystem == nullptr || numBlocks < s_minParallelBlocks)
+		{
+			EncodeBand(level, 0, level.numBlocksHigh);
+			continue;
+		}
+
+		// A few bands per thread, so that stealing can even out the load
+		const uint32_t numThreads = jobSystem->GetNumWorkers() + 1;
+		const uint32_t rowsPerBand = max(s_minBlockRowsPerBand, (level.numBlocksHigh + numThreads * 4 - 1) / (numThreads * 4));
+		const uint32_t numBands = (level.numBlocksHigh + rowsPerBand - 1) / rowsPerBand;
+
+		jobSystem->ParallelFor(numBands, 1, [&level, rowsPerBand](uint32_t band)
+			{
+				const uint32_t firstRow = band * rowsPerBand;
+				EncodeBand(level, firstRow, min(firstRow + rowsPerBand, level.numBlocksHigh));
+			});
+	}
+
+	if (outStats != nullptr)
+	{
+		outStats->encodeSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+		const uint32_t numChannels = GetNumStoredChannels(blockFormat);
+
+		uint64_t totalError = 0;
+		outStats->numTexels = 0;
+		for (size_t levelIndex = 0; levelIndex < outTexInit.subResourceData.size(); ++levelIndex)
+		{
+			const auto& srcLevel = srcTexInit.subResourceData[levelIndex];
+			totalError += MeasureLevelError(desc.format, srcLevel, outTexInit.subResourceData[levelIndex], numChannels);
+			outStats->numTexels += (uint64_t)srcLevel.width * srcLevel.height;
+		}
+
+		const double meanSquaredError = (double)totalError / (double)(outStats->numTexels * numChannels);
+		outStats->psnr = meanSquaredError > 0.0
+			? 10.0 * log10(255.0 * 255.0 / meanSquaredError)
+			: numeric_limits<double>::infinity();
+	}
+
+	return true;
+}
+
+
+void DecompressBlocks(Format format, const std::byte* srcData, uint32_t width, uint32_t height, std::byte* dstData)
+{
+	const BlockFormat blockFormat = GetBlockFormat(format);
+	const uint32_t blockBytes = GetBlockBytes(blockFormat);
+	assert(blockBytes != 0);
+
+	const uint32_t numBlocksWide = max(1u, (width + 3) / 4);
+	const uint32_t numBlocksHigh = max(1u, (height + 3) / 4);
+
+	const uint8_t* src = (const uint8_t*)srcData;
+	uint8_t* dst = (uint8_t*)dstData;
+
+	uint8_t texels[16][4];
+	for (uint32_t blockY = 0; blockY < numBlocksHigh; ++blockY)
+	{
+		for (uint32_t blockX = 0; blockX < numBlocksWide; ++blockX)
+		{
+			DecodeBlock(blockFormat, src, texels);
+			src += blockBytes;
+
+			// Partial blocks at the edges only write the texels inside the image
+			for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y)
+			{
+				for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; ++x)
+				{
+					memcpy(dst + ((size_t)(blockY * 4 + y) * width + blockX * 4 + x) * 4, texels[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+}
+
+} // namespace Luna
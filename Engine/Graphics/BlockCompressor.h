@@ -0,0 +1,73 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics/Formats.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+struct TextureInitializer;
+
+
+// How a texture is sampled, which picks the block-compressed format it is stored in
+enum class TextureUsage : uint8_t
+{
+	Default,			// Stored as decoded, without compression
+	Albedo,				// BC1, or BC3 if any texel is translucent
+	AlbedoHighQuality,	// BC7
+	NormalMap,			// BC5, holding tangent-space X and Y.  Shaders must reconstruct Z.
+	Mask				// BC4, holding the red channel
+};
+
+const char* GetTextureUsageName(TextureUsage usage);
+
+
+struct BlockCompressionDesc
+{
+	Format format{ Format::Unknown };	// BC1, BC3, BC4, BC5 or BC7, either UNorm or sRGB
+	bool allowSimd{ true };				// The scalar path is the reference.  Both produce the same bits.
+	bool allowParallel{ true };			// Splits large levels into bands of block rows, run on the JobSystem
+};
+
+
+struct BlockCompressionStats
+{
+	uint64_t numTexels{ 0 };
+	double encodeSeconds{ 0.0 };
+	double psnr{ 0.0 };					// Over the channels the format stores, across all levels
+
+	double GetMegapixelsPerSecond() const noexcept;
+};
+
+
+// Returns Format::Unknown for TextureUsage::Default
+Format GetBlockCompressedFormat(TextureUsage usage, bool hasTranslucency, bool isSrgb);
+
+// "BC1" through "BC7", ignoring sRGB, for logging
+const char* GetBlockCompressedFormatName(Format format);
+
+// RGBA8_UNorm and SRGBA8_UNorm
+bool IsBlockCompressionSupported(Format format);
+
+// Compresses every level of a 2D RGBA8 texture, such as the output of GenerateMipChain().  Partial blocks at
+// the right and bottom edges repeat the edge texels.  Each level is written into outStorage, laid out as in a
+// DDS file, and outTexInit points into outStorage, which must outlive it.  Stats are only gathered when
+// outStats is set, since measuring the PSNR decodes every level again.
+bool CompressTexture(const BlockCompressionDesc& desc, const TextureInitializer& srcTexInit, std::vector<std::byte>& outStorage,
+	TextureInitializer& outTexInit, BlockCompressionStats* outStats = nullptr);
+
+// Decodes one level back to tightly packed RGBA8.  Channels the format doesn't store are 0, except alpha, which is 255.
+void DecompressBlocks(Format format, const std::byte* srcData, uint32_t width, uint32_t height, std::byte* dstData);
+
+} // namespace Luna
@@ -15,6 +15,7 @@
 #include "Application.h"
 #include "GraphicsCommon.h"
 #include "DeviceManager.h"
+#include "GpuProfiler.h"
 
 using namespace std;
 
@@ -28,21 +29,52 @@ CommandContext& CommandContext::Begin(const string id)
 	newContext->SetId(id);
 	newContext->BeginFrame();
 	newContext->BeginEvent(id);
+	newContext->BeginProfileScope(id);
 
-	// TODO
-#if 0
-	if (id.length() > 0)
+	return *newContext;
+}
+
+
+uint64_t CommandContext::Finish(bool bWaitForCompletion)
+{
+	// Uploads are recorded on the graphics queue, which runs command lists in the order they were submitted.
+	// Submitting the open batch just before a graphics context is all it takes to order every upload ahead of
+	// it, with no fence and no CPU wait.  The compute and copy queues aren't ordered against uploads, so
+	// flushing for them would buy nothing.  A context there waits for the UploadTickets of what it reads.
+	if (GetType() == CommandListType::Graphics)
 	{
-		EngineProfiling::BeginBlock(id, newContext);
+		GetUploadQueue()->FlushBeforeSubmit();
 	}
-#endif
 
-	return *newContext;
+	return Submit(bWaitForCompletion);
 }
 
 
-uint64_t CommandContext::Finish(bool bWaitForCompletion)
+UploadTicket CommandContext::InitializeBuffer(const GpuBufferPtr& destBuffer, const void* bufferData, size_t numBytes, size_t offset)
+{
+	return GetUploadQueue()->InitializeBuffer(destBuffer, bufferData, numBytes, offset);
+}
+
+
+UploadTicket CommandContext::InitializeTexture(const TexturePtr& destTexture, const TextureInitializer& texInit)
+{
+	return GetUploadQueue()->InitializeTexture(destTexture, texInit);
+}
+
+
+uint64_t CommandContext::Submit(bool bWaitForCompletion)
 {
+	assert_msg(m_childContexts.empty(), "Finish called with parallel recording still in progress");
+
+	if (m_hasProfileScope)
+	{
+		if (auto gpuProfiler = GetGpuProfiler())
+		{
+			gpuProfiler->EndScope(m_contextImpl.get());
+		}
+		m_hasProfileScope = false;
+	}
+
 	m_contextImpl->EndEvent();
 	uint64_t fenceValue = m_contextImpl->Finish(bWaitForCompletion);
 
@@ -52,23 +84,165 @@ uint64_t CommandContext::Finish(bool bWaitForCompletion)
 }
 
 
-void CommandContext::InitializeBuffer(const GpuBufferPtr& destBuffer, const void* bufferData, size_t numBytes, size_t offset)
+void CommandContext::BeginProfileScope(const string& id)
 {
-	CommandContext& initContext = CommandContext::Begin();
+	// Contexts with an id are timed as a whole, in addition to any scopes recorded inside them
+	auto gpuProfiler = GetGpuProfiler();
+	if (gpuProfiler && !id.empty())
+	{
+		gpuProfiler->BeginScope(m_contextImpl.get(), id);
+		m_hasProfileScope = true;
+	}
+}
 
-	initContext.m_contextImpl->InitializeBuffer_Internal(destBuffer.get(), bufferData, numBytes, offset);
 
-	initContext.Finish(true);
+void CommandContext::SetInheritedRenderTargets(span<const IColorBuffer*> renderTargets, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect)
+{
+	assert(renderTargets.size() <= m_inheritedState.renderTargets.size());
+
+	copy(renderTargets.begin(), renderTargets.end(), m_inheritedState.renderTargets.begin());
+	m_inheritedState.numRenderTargets = (uint32_t)renderTargets.size();
+	m_inheritedState.depthTarget = depthTarget;
+	m_inheritedState.depthStencilAspect = depthStencilAspect;
+	m_inheritedState.isRendering = true;
 }
 
 
-void CommandContext::InitializeTexture(const TexturePtr& destTexture, const TextureInitializer& texInit)
+void CommandContext::ApplyInheritedState(const InheritedState& state)
 {
-	CommandContext& initContext = CommandContext::Begin();
+	m_inheritedState = state;
 
-	initContext.m_contextImpl->InitializeTexture_Internal(destTexture.Get(), texInit);
+	if (state.isRendering)
+	{
+		span<const IColorBuffer*> renderTargets{ m_inheritedState.renderTargets.data(), state.numRenderTargets };
+		if (renderTargets.empty())
+		{
+			m_contextImpl->BeginRendering(state.depthTarget, state.depthStencilAspect);
+		}
+		else if (state.depthTarget != nullptr)
+		{
+			m_contextImpl->BeginRendering(renderTargets, state.depthTarget, state.depthStencilAspect);
+		}
+		else
+		{
+			m_contextImpl->BeginRendering(renderTargets);
+		}
+	}
+
+	if (state.rootSignature)
+	{
+		m_contextImpl->SetRootSignature(CommandListType::Graphics, state.rootSignature);
+	}
+
+	if (state.graphicsPipeline)
+	{
+		m_contextImpl->SetGraphicsPipeline(state.graphicsPipeline);
+	}
+	else if (state.meshletPipeline)
+	{
+		m_contextImpl->SetMeshletPipeline(state.meshletPipeline);
+	}
+
+	if (state.viewport)
+	{
+		const auto& [x, y, w, h, minDepth, maxDepth] = *state.viewport;
+		m_contextImpl->SetViewport(x, y, w, h, minDepth, maxDepth);
+	}
+
+	if (state.scissor)
+	{
+		const auto& [left, top, right, bottom] = *state.scissor;
+		m_contextImpl->SetScissor(left, top, right, bottom);
+	}
+
+	if (state.stencilRef)
+	{
+		m_contextImpl->SetStencilRef(*state.stencilRef);
+	}
+
+	if (state.blendFactor)
+	{
+		m_contextImpl->SetBlendFactor(*state.blendFactor);
+	}
+
+	if (state.primitiveTopology)
+	{
+		m_contextImpl->SetPrimitiveTopology(*state.primitiveTopology);
+	}
 
-	initContext.Finish(true);
+	if (state.depthBias)
+	{
+		const auto& [constantFactor, clamp, slopeFactor] = *state.depthBias;
+		m_contextImpl->SetDepthBias(constantFactor, clamp, slopeFactor);
+	}
+}
+
+
+span<GraphicsContext*> GraphicsContext::BeginParallelRecording(uint32_t numContexts)
+{
+	assert_msg(m_childContexts.empty(), "BeginParallelRecording called twice without EndParallelRecording");
+	assert(numContexts > 0);
+
+	ScopedEvent event("GraphicsContext::BeginParallelRecording");
+
+	auto deviceManager = GetDeviceManager();
+
+	m_childContexts.reserve(numContexts);
+	for (uint32_t i = 0; i < numContexts; ++i)
+	{
+		GraphicsContext& childContext = deviceManager->AllocateContext(GetType())->GetGraphicsContext();
+		childContext.SetId(format("Parallel Context {}", i));
+		childContext.BeginFrame();
+		childContext.ApplyInheritedState(m_inheritedState);
+
+		m_childContexts.push_back(&childContext);
+	}
+
+	return m_childContexts;
+}
+
+
+uint64_t GraphicsContext::EndParallelRecording()
+{
+	assert_msg(!m_childContexts.empty(), "EndParallelRecording called without BeginParallelRecording");
+
+	ScopedEvent event("GraphicsContext::EndParallelRecording");
+
+	// Render passes can't span command lists, so close them all before submitting
+	vector<ICommandContext*> childContextImpls;
+	childContextImpls.reserve(m_childContexts.size());
+
+	for (GraphicsContext* childContext : m_childContexts)
+	{
+		if (childContext->m_inheritedState.isRendering)
+		{
+			childContext->m_contextImpl->EndRendering();
+		}
+		childContextImpls.push_back(childContext->m_contextImpl.get());
+	}
+
+	const InheritedState parentState = m_inheritedState;
+	if (parentState.isRendering)
+	{
+		m_contextImpl->EndRendering();
+	}
+
+	// Submit any pending uploads first, so they execute ahead of the children, as in Finish()
+	GetUploadQueue()->FlushBeforeSubmit();
+
+	const uint64_t fenceValue = m_contextImpl->ExecuteChildren(childContextImpls);
+
+	auto deviceManager = GetDeviceManager();
+	for (GraphicsContext* childContext : m_childContexts)
+	{
+		deviceManager->FreeContext(childContext);
+	}
+	m_childContexts.clear();
+
+	// This context continues on a new command list, so restore the state it had before
+	ApplyInheritedState(parentState);
+
+	return fenceValue;
 }
 
 
@@ -79,16 +253,7 @@ ComputeContext& ComputeContext::Begin(const string& id, bool bAsync)
 	ComputeContext& newContext = GetDeviceManager()->AllocateContext(commandListType)->GetComputeContext();
 	newContext.SetId(id);
 	newContext.BeginFrame();
-
-	// TODO
-#if 0
-	if (id.length() > 0)
-	{
-		EngineProfiling::BeginBlock(id, newContext);
-	}
-#endif
-
-	//m_contextImpl->Begin
+	newContext.BeginProfileScope(id);
 
 	return newContext;
 }
@@ -106,6 +271,16 @@ ScopedDrawEvent::ScopedDrawEvent(CommandContext& context, const string& label)
 	}
 #endif
 
+	if (auto frameProfiler = GetFrameProfiler())
+	{
+		frameProfiler->BeginScope(label);
+	}
+
+	if (auto gpuProfiler = GetGpuProfiler())
+	{
+		gpuProfiler->BeginScope(m_context, label);
+	}
+
 	m_context->BeginEvent(label);
 }
 
@@ -122,6 +297,16 @@ ScopedDrawEvent::ScopedDrawEvent(ICommandContext* context, const std::string& la
 	}
 #endif
 
+	if (auto frameProfiler = GetFrameProfiler())
+	{
+		frameProfiler->BeginScope(label);
+	}
+
+	if (auto gpuProfiler = GetGpuProfiler())
+	{
+		gpuProfiler->BeginScope(m_context, label);
+	}
+
 	m_context->BeginEvent(label);
 }
 
@@ -130,6 +315,16 @@ ScopedDrawEvent::~ScopedDrawEvent()
 {
 	m_context->EndEvent();
 
+	if (auto gpuProfiler = GetGpuProfiler())
+	{
+		gpuProfiler->EndScope(m_context);
+	}
+
+	if (auto frameProfiler = GetFrameProfiler())
+	{
+		frameProfiler->EndScope();
+	}
+
 #if FRAMEPRO_ENABLED
 	if (m_eventStarted && IsFrameProRunning())
 	{
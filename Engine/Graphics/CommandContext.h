@@ -12,6 +12,7 @@
 
 #include "Graphics\Enums.h"
 #include "Graphics\Texture.h"
+#include "Graphics\UploadQueue.h"
 
 namespace Luna
 {
@@ -68,6 +69,10 @@ public:
 	// Flush existing commands and release the current context
 	virtual uint64_t Finish(bool bWaitForCompletion = false) = 0;
 
+	// Submit the commands recorded so far, followed by the child contexts in order, behind a single fence.  The
+	// children are finished, and this context carries on recording into a new command list with no state bound.
+	virtual uint64_t ExecuteChildren(std::span<ICommandContext* const> childContexts) = 0;
+
 	virtual void TransitionResource(IColorBuffer* colorBuffer, ResourceState newState, bool bFlushImmediate = false) = 0;
 	virtual void TransitionResource(IDepthBuffer* depthBuffer, ResourceState newState, bool bFlushImmediate = false) = 0;
 	virtual void TransitionResource(IGpuBuffer* gpuBuffer, ResourceState newState, bool bFlushImmediate = false) = 0;
@@ -76,6 +81,13 @@ public:
 	virtual void InsertUAVBarrier(const IGpuBuffer* gpuBuffer, bool bFlushImmediate = false) = 0;
 	virtual void FlushResourceBarriers() = 0;
 
+	// Split barriers.  The transition can overlap other work between the two calls, and the resource must not be
+	// used in between.  Backends without split barriers do the whole transition in EndResourceTransition().
+	virtual void BeginResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) = 0;
+	virtual void BeginResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) = 0;
+	virtual void EndResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) = 0;
+	virtual void EndResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) = 0;
+
 	virtual DynAlloc ReserveUploadMemory(size_t sizeInBytes) = 0;
 
 	// Graphics context
@@ -182,6 +194,7 @@ protected:
 class CommandContext : NonCopyable
 {
 	friend class ScopedDrawEvent;
+	friend class UploadQueue;
 
 public:
 	CommandContext(ICommandContext* pContextImpl)
@@ -212,8 +225,10 @@ public:
 		return reinterpret_cast<ComputeContext&>(*this);
 	}
 
-	static void InitializeBuffer(const GpuBufferPtr& destBuffer, const void* bufferData, size_t numBytes, size_t offset = 0);
-	static void InitializeTexture(const TexturePtr& destTexture, const TextureInitializer& texInit);
+	// Resource initialization is batched by the UploadQueue.  Wait on the returned ticket only if the CPU
+	// needs the upload to be complete.
+	static UploadTicket InitializeBuffer(const GpuBufferPtr& destBuffer, const void* bufferData, size_t numBytes, size_t offset = 0);
+	static UploadTicket InitializeTexture(const TexturePtr& destTexture, const TextureInitializer& texInit);
 
 	// Flush existing commands and release the current context
 	uint64_t Finish(bool bWaitForCompletion = false);
@@ -225,13 +240,50 @@ public:
 	void InsertUAVBarrier(const ColorBufferPtr& colorBuffer, bool bFlushImmediate = false);
 	void InsertUAVBarrier(const GpuBufferPtr& gpuBuffer, bool bFlushImmediate = false);
 	void FlushResourceBarriers();
+	void BeginResourceTransition(const ColorBufferPtr& colorBuffer, ResourceState newState);
+	void BeginResourceTransition(const DepthBufferPtr& depthBuffer, ResourceState newState);
+	void EndResourceTransition(const ColorBufferPtr& colorBuffer, ResourceState newState);
+	void EndResourceTransition(const DepthBufferPtr& depthBuffer, ResourceState newState);
 
 	DynAlloc ReserveUploadMemory(size_t sizeInBytes);
 
 	void BeginFrame();
 
+protected:
+	// Graphics state that parallel recording contexts inherit from their parent.  Resources are not owned, so
+	// the caller has to keep them alive until EndParallelRecording().
+	struct InheritedState
+	{
+		std::array<const IColorBuffer*, 8> renderTargets{};
+		uint32_t numRenderTargets{ 0 };
+		const IDepthBuffer* depthTarget{ nullptr };
+		DepthStencilAspect depthStencilAspect{ DepthStencilAspect::ReadWrite };
+		bool isRendering{ false };
+
+		const IRootSignature* rootSignature{ nullptr };
+		const IGraphicsPipeline* graphicsPipeline{ nullptr };
+		const IMeshletPipeline* meshletPipeline{ nullptr };
+
+		std::optional<std::array<float, 6>> viewport;
+		std::optional<std::array<uint32_t, 4>> scissor;
+		std::optional<uint32_t> stencilRef;
+		std::optional<Color> blendFactor;
+		std::optional<PrimitiveTopology> primitiveTopology;
+		std::optional<std::array<float, 3>> depthBias;
+	};
+
+	uint64_t Submit(bool bWaitForCompletion);
+	void BeginProfileScope(const std::string& id);
+
+	void SetInheritedRenderTargets(std::span<const IColorBuffer*> renderTargets, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect);
+	void ApplyInheritedState(const InheritedState& state);
+
 protected:
 	std::unique_ptr<ICommandContext> m_contextImpl;
+	bool m_hasProfileScope{ false };
+
+	InheritedState m_inheritedState;
+	std::vector<GraphicsContext*> m_childContexts;
 };
 
 
@@ -329,12 +381,23 @@ public:
 	void DispatchMesh(uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
 
 	void Resolve(const ColorBufferPtr& srcBuffer, const ColorBufferPtr& destBuffer, Format format);
+
+	// Parallel recording.  Hands out contexts that start with this context's render targets, root signature,
+	// pipeline and fixed-function state, and can each be recorded on a different thread.  EndParallelRecording()
+	// must be called once all of them are done, and submits this context's commands so far, followed by the
+	// children in order, behind a single fence.  Children must not transition resources, and root parameters are
+	// not inherited.  Afterwards this context picks up its own state again, except for root parameters, which
+	// have to be set again.
+	std::span<GraphicsContext*> BeginParallelRecording(uint32_t numContexts);
+	uint64_t EndParallelRecording();
 };
 
 
 class ComputeContext : public CommandContext
 {
 public:
+	// Async contexts run on the compute queue, which isn't ordered after UploadQueue batches.  Wait for the
+	// UploadTickets of any freshly initialized resources they read.
 	static ComputeContext& Begin(const std::string& id = "", bool bAsync = false);
 
 	void SetRootSignature(const RootSignaturePtr& rootSignature);
@@ -432,7 +495,10 @@ inline void CommandContext::SetMarker(const std::string& label)
 
 inline void CommandContext::Reset()
 {
+	assert(m_childContexts.empty());
+
 	m_contextImpl->Reset();
+	m_inheritedState = InheritedState{};
 }
 
 
@@ -484,6 +550,30 @@ inline void CommandContext::FlushResourceBarriers()
 }
 
 
+inline void CommandContext::BeginResourceTransition(const ColorBufferPtr& colorBuffer, ResourceState newState)
+{
+	m_contextImpl->BeginResourceTransition(colorBuffer.get(), newState);
+}
+
+
+inline void CommandContext::BeginResourceTransition(const DepthBufferPtr& depthBuffer, ResourceState newState)
+{
+	m_contextImpl->BeginResourceTransition(depthBuffer.get(), newState);
+}
+
+
+inline void CommandContext::EndResourceTransition(const ColorBufferPtr& colorBuffer, ResourceState newState)
+{
+	m_contextImpl->EndResourceTransition(colorBuffer.get(), newState);
+}
+
+
+inline void CommandContext::EndResourceTransition(const DepthBufferPtr& depthBuffer, ResourceState newState)
+{
+	m_contextImpl->EndResourceTransition(depthBuffer.get(), newState);
+}
+
+
 inline DynAlloc CommandContext::ReserveUploadMemory(size_t sizeInBytes)
 {
 	return m_contextImpl->ReserveUploadMemory(sizeInBytes);
@@ -540,18 +630,26 @@ inline void GraphicsContext::ClearDepthAndStencil(const DepthBufferPtr& depthBuf
 
 inline void GraphicsContext::BeginRendering(const ColorBufferPtr& renderTarget)
 {
-	m_contextImpl->BeginRendering(renderTarget.get());
+	const IColorBuffer* renderTargetPtr = renderTarget.get();
+	SetInheritedRenderTargets({ &renderTargetPtr, 1 }, nullptr, DepthStencilAspect::ReadWrite);
+
+	m_contextImpl->BeginRendering(renderTargetPtr);
 }
 
 
 inline void GraphicsContext::BeginRendering(const ColorBufferPtr& renderTarget, const DepthBufferPtr& depthTarget, DepthStencilAspect depthStencilAspect)
 {
-	m_contextImpl->BeginRendering(renderTarget.get(), depthTarget.get(), depthStencilAspect);
+	const IColorBuffer* renderTargetPtr = renderTarget.get();
+	SetInheritedRenderTargets({ &renderTargetPtr, 1 }, depthTarget.get(), depthStencilAspect);
+
+	m_contextImpl->BeginRendering(renderTargetPtr, depthTarget.get(), depthStencilAspect);
 }
 
 
 inline void GraphicsContext::BeginRendering(const DepthBufferPtr& depthTarget, DepthStencilAspect depthStencilAspect)
 {
+	SetInheritedRenderTargets({}, depthTarget.get(), depthStencilAspect);
+
 	m_contextImpl->BeginRendering(depthTarget.get(), depthStencilAspect);
 }
 
@@ -565,6 +663,8 @@ inline void GraphicsContext::BeginRendering(const std::vector<ColorBufferPtr>& r
 		renderTargetPtrs[i++] = rt.get();
 	}
 
+	SetInheritedRenderTargets(renderTargetPtrs, nullptr, DepthStencilAspect::ReadWrite);
+
 	m_contextImpl->BeginRendering(renderTargetPtrs);
 }
 
@@ -578,12 +678,16 @@ inline void GraphicsContext::BeginRendering(const std::vector<ColorBufferPtr>& r
 		renderTargetPtrs[i++] = rt.get();
 	}
 
+	SetInheritedRenderTargets(renderTargetPtrs, depthTarget.get(), depthStencilAspect);
+
 	m_contextImpl->BeginRendering(renderTargetPtrs, depthTarget.get(), depthStencilAspect);
 }
 
 
 inline void GraphicsContext::EndRendering()
 {
+	m_inheritedState.isRendering = false;
+
 	m_contextImpl->EndRendering();
 }
 
@@ -614,61 +718,81 @@ inline void GraphicsContext::ResetQueries(const QueryHeapPtr& queryHeap, uint32_
 
 inline void GraphicsContext::SetRootSignature(const RootSignaturePtr& rootSignature)
 {
+	m_inheritedState.rootSignature = rootSignature.get();
+
 	m_contextImpl->SetRootSignature(CommandListType::Graphics, rootSignature.get());
 }
 
 
 inline void GraphicsContext::SetGraphicsPipeline(const GraphicsPipelinePtr& graphicsPipeline)
 {
+	m_inheritedState.graphicsPipeline = graphicsPipeline.get();
+	m_inheritedState.meshletPipeline = nullptr;
+
 	m_contextImpl->SetGraphicsPipeline(graphicsPipeline.get());
 }
 
 
 inline void GraphicsContext::SetMeshletPipeline(const MeshletPipelinePtr& meshletPipeline)
 {
+	m_inheritedState.graphicsPipeline = nullptr;
+	m_inheritedState.meshletPipeline = meshletPipeline.get();
+
 	m_contextImpl->SetMeshletPipeline(meshletPipeline.get());
 }
 
 
 inline void GraphicsContext::SetViewport(float x, float y, float w, float h, float minDepth, float maxDepth)
 {
+	m_inheritedState.viewport = { x, y, w, h, minDepth, maxDepth };
+
 	m_contextImpl->SetViewport(x, y, w, h, minDepth, maxDepth);
 }
 
 
 inline void GraphicsContext::SetScissor(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom)
 {
+	m_inheritedState.scissor = { left, top, right, bottom };
+
 	m_contextImpl->SetScissor(left, top, right, bottom);
 }
 
 
 inline void GraphicsContext::SetViewportAndScissor(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
 {
-	m_contextImpl->SetViewport((float)x, (float)y, (float)w, (float)h, 0.0f, 1.0f);
-	m_contextImpl->SetScissor(x, y, x + w, y + h);
+	SetViewport((float)x, (float)y, (float)w, (float)h, 0.0f, 1.0f);
+	SetScissor(x, y, x + w, y + h);
 }
 
 
 inline void GraphicsContext::SetStencilRef(uint32_t stencilRef)
 {
+	m_inheritedState.stencilRef = stencilRef;
+
 	m_contextImpl->SetStencilRef(stencilRef);
 }
 
 
 inline void GraphicsContext::SetBlendFactor(Color blendFactor)
 {
+	m_inheritedState.blendFactor = blendFactor;
+
 	m_contextImpl->SetBlendFactor(blendFactor);
 }
 
 
 inline void GraphicsContext::SetPrimitiveTopology(PrimitiveTopology topology)
 {
+	m_inheritedState.primitiveTopology = topology;
+
 	m_contextImpl->SetPrimitiveTopology(topology);
 }
 
 
 inline void GraphicsContext::SetDepthBias(float depthBiasConstantFactor, float depthBiasClamp, float depthBiasSlopeFactor)
 {
+	m_inheritedState.depthBias = { depthBiasConstantFactor, depthBiasClamp, depthBiasSlopeFactor };
+
 	m_contextImpl->SetDepthBias(depthBiasConstantFactor, depthBiasClamp, depthBiasSlopeFactor);
 }
 
@@ -765,7 +889,7 @@ inline void GraphicsContext::SetSRV(uint32_t rootParam, uint32_t srvRegister, Gp
 
 inline void GraphicsContext::SetSRV(uint32_t rootParam, uint32_t srvRegister, TexturePtr& texture)
 {
-	m_contextImpl->SetSRV(CommandListType::Graphics, rootParam, srvRegister, texture.Get());
+	m_contextImpl->SetSRV(CommandListType::Graphics, rootParam, srvRegister, GetBindableTexture(texture));
 }
 
 
@@ -989,7 +1113,7 @@ inline void ComputeContext::SetSRV(uint32_t rootParam, uint32_t srvRegister, Gpu
 
 inline void ComputeContext::SetSRV(uint32_t rootParam, uint32_t srvRegister, TexturePtr& texture)
 {
-	m_contextImpl->SetSRV(CommandListType::Compute, rootParam, srvRegister, texture.Get());
+	m_contextImpl->SetSRV(CommandListType::Compute, rootParam, srvRegister, GetBindableTexture(texture));
 }
 
 
@@ -0,0 +1,34 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "CommandContextPool.h"
+
+#include "CommandContext.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+template class ContextPool<CommandContext>;
+
+
+CommandContextPool::CommandContextPool(BackendCreateFunction createFunction)
+	: ContextPool<CommandContext>{ [createFunction = move(createFunction)](CommandListType type)
+		{
+			return new CommandContext(createFunction(type));
+		} }
+{
+}
+
+} // namespace Luna
@@ -0,0 +1,37 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\ContextPool.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+class CommandContext;
+class ICommandContext;
+
+
+// Instantiated once, in CommandContextPool.cpp, where CommandContext is complete
+extern template class ContextPool<CommandContext>;
+
+
+// The command contexts of a device manager.  Each wraps a backend context made by createFunction.
+class CommandContextPool : public ContextPool<CommandContext>
+{
+public:
+	using BackendCreateFunction = std::function<ICommandContext*(CommandListType)>;
+
+	explicit CommandContextPool(BackendCreateFunction createFunction);
+};
+
+} // namespace Luna
@@ -0,0 +1,176 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/BitmaskEnum.h"
+#include "Graphics/Enums.h"
+
+
+namespace Luna
+{
+
+// Owns and recycles command contexts.  Each JobSystem worker keeps a private free list, so workers that record
+// contexts concurrently do not serialize on one lock.  Other threads share a locked free list, which is also where
+// workers fall back to when their own list is empty.  The worker lists are sized by the JobSystem that exists when
+// the pool is created, and without one every thread uses the shared list.
+// TContext needs GetType(), Initialize(), called once on a new context, and Reset(), called each time one is reused.
+// CommandContextPool is the pool of CommandContexts, and the headless tests drive this with contexts of their own.
+template <class TContext>
+class ContextPool : public NonCopyable
+{
+public:
+	using CreateFunction = std::function<TContext*(CommandListType)>;
+
+	explicit ContextPool(CreateFunction createFunction);
+	~ContextPool();
+
+	TContext* Allocate(CommandListType commandListType);
+	void Free(TContext* usedContext);
+
+	size_t GetNumContexts() const;
+
+private:
+	using FreeLists = std::array<std::vector<TContext*>, (size_t)CommandListType::Count>;
+
+	struct alignas(64) ThreadCache
+	{
+		FreeLists freeContexts;
+	};
+
+	ThreadCache* GetThreadCache();
+
+private:
+	CreateFunction m_createFunction;
+
+	mutable std::mutex m_mutex;
+	std::vector<std::unique_ptr<TContext>> m_contexts;
+	FreeLists m_freeContexts;
+
+	// One cache per JobSystem worker, only ever touched by that worker
+	std::vector<ThreadCache> m_threadCaches;
+};
+
+
+template <class TContext>
+ContextPool<TContext>::ContextPool(CreateFunction createFunction)
+	: m_createFunction{ std::move(createFunction) }
+{
+	if (auto jobSystem = GetJobSystem())
+	{
+		m_threadCaches.resize(jobSystem->GetNumWorkers());
+	}
+}
+
+
+template <class TContext>
+ContextPool<TContext>::~ContextPool()
+{
+	// The caches only hold pointers into m_contexts
+	m_threadCaches.clear();
+	m_contexts.clear();
+}
+
+
+template <class TContext>
+TContext* ContextPool<TContext>::Allocate(CommandListType commandListType)
+{
+	ScopedEvent event("CommandContextPool::Allocate");
+
+	const uint32_t typeIndex = (uint32_t)commandListType;
+
+	TContext* ret{ nullptr };
+	bool isNew{ false };
+
+	if (ThreadCache* threadCache = GetThreadCache())
+	{
+		auto& freeContexts = threadCache->freeContexts[typeIndex];
+		if (!freeContexts.empty())
+		{
+			ret = freeContexts.back();
+			freeContexts.pop_back();
+		}
+	}
+
+	if (ret == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto& freeContexts = m_freeContexts[typeIndex];
+		if (!freeContexts.empty())
+		{
+			ret = freeContexts.back();
+			freeContexts.pop_back();
+		}
+		else
+		{
+			ret = m_createFunction(commandListType);
+			m_contexts.emplace_back(ret);
+			isNew = true;
+		}
+	}
+
+	// Command list setup happens outside the lock
+	if (isNew)
+	{
+		ret->Initialize();
+	}
+	else
+	{
+		ret->Reset();
+	}
+
+	assert(ret != nullptr);
+	assert(ret->GetType() == commandListType);
+
+	return ret;
+}
+
+
+template <class TContext>
+void ContextPool<TContext>::Free(TContext* usedContext)
+{
+	assert(usedContext != nullptr);
+
+	const uint32_t typeIndex = (uint32_t)usedContext->GetType();
+
+	if (ThreadCache* threadCache = GetThreadCache())
+	{
+		threadCache->freeContexts[typeIndex].push_back(usedContext);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_freeContexts[typeIndex].push_back(usedContext);
+}
+
+
+template <class TContext>
+size_t ContextPool<TContext>::GetNumContexts() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_contexts.size();
+}
+
+
+template <class TContext>
+typename ContextPool<TContext>::ThreadCache* ContextPool<TContext>::GetThreadCache()
+{
+	auto jobSystem = GetJobSystem();
+	if (m_threadCaches.empty() || jobSystem == nullptr)
+	{
+		return nullptr;
+	}
+
+	const uint32_t workerIndex = jobSystem->GetWorkerIndex();
+	return workerIndex < (uint32_t)m_threadCaches.size() ? &m_threadCaches[workerIndex] : nullptr;
+}
+
+} // namespace Luna
@@ -12,6 +12,8 @@
 
 #include "ColorBuffer12.h"
 
+#include "DeviceManager12.h"
+
 namespace Luna::DX12
 {
 
@@ -26,6 +28,15 @@ ColorBuffer::ColorBuffer(Device* device)
 }
 
 
+ColorBuffer::~ColorBuffer()
+{
+	if (auto deviceManager = GetD3D12DeviceManager())
+	{
+		deviceManager->ReleaseResource(m_resource.get());
+	}
+}
+
+
 const IDescriptor* ColorBuffer::GetUavDescriptor(uint32_t index) const noexcept
 {
 	assert(index < m_uavDescriptors.size());
@@ -28,6 +28,7 @@ class ColorBuffer : public IColorBuffer
 
 public:
 	explicit ColorBuffer(Device* device);
+	~ColorBuffer() override;
 
 	const IDescriptor* GetSrvDescriptor() const noexcept override { return &m_srvDescriptor; }
 	const IDescriptor* GetRtvDescriptor() const noexcept override { return &m_rtvDescriptor; }
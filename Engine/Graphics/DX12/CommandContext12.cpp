@@ -171,41 +171,56 @@ uint64_t CommandContext12::Finish(bool bWaitForCompletion)
 {
 	assert(m_commandListType == CommandListType::Graphics || m_commandListType == CommandListType::Compute);
 
-	FlushResourceBarriers();
+	PrepareForSubmit();
 
-	// TODO
-#if 0
-	if (m_ID.length() > 0)
-	{
-		EngineProfiling::EndBlock(this);
-	}
-#endif
+	auto deviceManager = GetD3D12DeviceManager();
 
-	assert(m_currentAllocator != nullptr);
+	Queue& cmdQueue = deviceManager->GetQueue(m_commandListType);
 
-	if (m_bHasPendingDebugEvent)
+	uint64_t fenceValue = cmdQueue.ExecuteCommandList(m_commandList);
+	ReleaseAfterSubmit(fenceValue);
+
+	if (bWaitForCompletion)
 	{
-		EndEvent();
-		m_bHasPendingDebugEvent = false;
+		deviceManager->WaitForFence(fenceValue);
 	}
 
-	auto deviceManager = GetD3D12DeviceManager();
+	return fenceValue;
+}
 
-	Queue& cmdQueue = deviceManager->GetQueue(m_commandListType);
 
-	uint64_t fenceValue = cmdQueue.ExecuteCommandList(m_commandList);
-	cmdQueue.DiscardAllocator(fenceValue, m_currentAllocator);
-	m_currentAllocator = nullptr;
+uint64_t CommandContext12::ExecuteChildren(span<ICommandContext* const> childContexts)
+{
+	assert(m_commandListType == CommandListType::Graphics || m_commandListType == CommandListType::Compute);
 
-	m_dynamicViewDescriptorHeap.CleanupUsedHeaps(fenceValue);
-	m_dynamicSamplerDescriptorHeap.CleanupUsedHeaps(fenceValue);
-	m_cpuLinearAllocator.CleanupUsedPages(fenceValue);
+	PrepareForSubmit();
 
-	if (bWaitForCompletion)
+	vector<ID3D12CommandList*> commandLists;
+	commandLists.reserve(childContexts.size() + 1);
+	commandLists.push_back(m_commandList);
+
+	for (ICommandContext* childContext : childContexts)
 	{
-		deviceManager->WaitForFence(fenceValue);
+		CommandContext12* childContext12 = (CommandContext12*)childContext;
+		assert(childContext12 != nullptr && childContext12->m_commandListType == m_commandListType);
+
+		childContext12->PrepareForSubmit();
+		commandLists.push_back(childContext12->m_commandList);
 	}
 
+	Queue& cmdQueue = GetD3D12DeviceManager()->GetQueue(m_commandListType);
+
+	uint64_t fenceValue = cmdQueue.ExecuteCommandLists(commandLists);
+
+	for (ICommandContext* childContext : childContexts)
+	{
+		((CommandContext12*)childContext)->ReleaseAfterSubmit(fenceValue);
+	}
+	ReleaseAfterSubmit(fenceValue);
+
+	// Carry on recording into the same command list, with a fresh allocator
+	Reset();
+
 	return fenceValue;
 }
 
@@ -323,6 +338,65 @@ void CommandContext12::InsertUAVBarrier(const IGpuBuffer* gpuBuffer, bool bFlush
 }
 
 
+void CommandContext12::BeginResourceTransition(IColorBuffer* colorBuffer, ResourceState newState)
+{
+	// TODO: Try this with GetPlatformObject()
+	ColorBuffer* colorBuffer12 = (ColorBuffer*)colorBuffer;
+	assert(colorBuffer12 != nullptr);
+
+	// The usage state only changes once the transition ends
+	const ResourceState oldState = colorBuffer->GetUsageState();
+	if (oldState != newState)
+	{
+		TransitionResource_Internal(colorBuffer12->GetResource(), ResourceStateToDX12(oldState), ResourceStateToDX12(newState), false, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+	}
+}
+
+
+void CommandContext12::BeginResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState)
+{
+	// TODO: Try this with GetPlatformObject()
+	DepthBuffer* depthBuffer12 = (DepthBuffer*)depthBuffer;
+	assert(depthBuffer12 != nullptr);
+
+	const ResourceState oldState = depthBuffer->GetUsageState();
+	if (oldState != newState)
+	{
+		TransitionResource_Internal(depthBuffer12->GetResource(), ResourceStateToDX12(oldState), ResourceStateToDX12(newState), false, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+	}
+}
+
+
+void CommandContext12::EndResourceTransition(IColorBuffer* colorBuffer, ResourceState newState)
+{
+	// TODO: Try this with GetPlatformObject()
+	ColorBuffer* colorBuffer12 = (ColorBuffer*)colorBuffer;
+	assert(colorBuffer12 != nullptr);
+
+	const ResourceState oldState = colorBuffer->GetUsageState();
+	if (oldState != newState)
+	{
+		TransitionResource_Internal(colorBuffer12->GetResource(), ResourceStateToDX12(oldState), ResourceStateToDX12(newState), false, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+		colorBuffer->SetUsageState(newState);
+	}
+}
+
+
+void CommandContext12::EndResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState)
+{
+	// TODO: Try this with GetPlatformObject()
+	DepthBuffer* depthBuffer12 = (DepthBuffer*)depthBuffer;
+	assert(depthBuffer12 != nullptr);
+
+	const ResourceState oldState = depthBuffer->GetUsageState();
+	if (oldState != newState)
+	{
+		TransitionResource_Internal(depthBuffer12->GetResource(), ResourceStateToDX12(oldState), ResourceStateToDX12(newState), false, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+		depthBuffer->SetUsageState(newState);
+	}
+}
+
+
 void CommandContext12::FlushResourceBarriers()
 {
 	if (m_numBarriersToFlush > 0)
@@ -864,6 +938,9 @@ void CommandContext12::SetDescriptors(CommandListType type, uint32_t rootIndex,
 
 void CommandContext12::SetResources(CommandListType type, ResourceSet& resourceSet)
 {
+	// Held until the descriptor sets are bound, in case another thread is resolving the same set
+	auto pendingTextureLock = resourceSet.ResolvePendingTextures();
+
 	FlushResourceBarriers();
 
 	// TODO: Need to rework this.  Should use a single shader-visible heap (of each type) for all descriptors.
@@ -1229,7 +1306,7 @@ void CommandContext12::SetDescriptorHeaps(uint32_t heapCount, D3D12_DESCRIPTOR_H
 }
 
 
-void CommandContext12::TransitionResource_Internal(ID3D12Resource* resource, D3D12_RESOURCE_STATES oldState, D3D12_RESOURCE_STATES newState, bool bFlushImmediate)
+void CommandContext12::TransitionResource_Internal(ID3D12Resource* resource, D3D12_RESOURCE_STATES oldState, D3D12_RESOURCE_STATES newState, bool bFlushImmediate, D3D12_RESOURCE_BARRIER_FLAGS flags)
 {
 	if (oldState != newState)
 	{
@@ -1241,7 +1318,7 @@ void CommandContext12::TransitionResource_Internal(ID3D12Resource* resource, D3D
 		barrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 		barrierDesc.Transition.StateBefore = oldState;
 		barrierDesc.Transition.StateAfter = newState;
-		barrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		barrierDesc.Flags = flags;
 	}
 	else if (newState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
 	{
@@ -1271,6 +1348,33 @@ void CommandContext12::InsertUAVBarrier_Internal(ID3D12Resource* resource, bool
 }
 
 
+void CommandContext12::PrepareForSubmit()
+{
+	FlushResourceBarriers();
+
+	assert(m_currentAllocator != nullptr);
+
+	if (m_bHasPendingDebugEvent)
+	{
+		EndEvent();
+		m_bHasPendingDebugEvent = false;
+	}
+}
+
+
+void CommandContext12::ReleaseAfterSubmit(uint64_t fenceValue)
+{
+	Queue& cmdQueue = GetD3D12DeviceManager()->GetQueue(m_commandListType);
+
+	cmdQueue.DiscardAllocator(fenceValue, m_currentAllocator);
+	m_currentAllocator = nullptr;
+
+	m_dynamicViewDescriptorHeap.CleanupUsedHeaps(fenceValue);
+	m_dynamicSamplerDescriptorHeap.CleanupUsedHeaps(fenceValue);
+	m_cpuLinearAllocator.CleanupUsedPages(fenceValue);
+}
+
+
 void CommandContext12::InitializeBuffer_Internal(IGpuBuffer* destBuffer, const void* bufferData, size_t numBytes, size_t offset)
 { 
 	// TODO: Try this with GetPlatformObject()
@@ -51,6 +51,7 @@ public:
 
 	void BeginFrame() override {}
 	uint64_t Finish(bool bWaitForCompletion) override;
+	uint64_t ExecuteChildren(std::span<ICommandContext* const> childContexts) override;
 
 	void TransitionResource(IColorBuffer* colorBuffer, ResourceState newState, bool bFlushImmediate) override;
 	void TransitionResource(IDepthBuffer* depthBuffer, ResourceState newState, bool bFlushImmediate) override;
@@ -58,6 +59,10 @@ public:
 	void TransitionResource(ITexture* texture, ResourceState newState, bool bFlushImmediate) override;
 	void InsertUAVBarrier(const IColorBuffer* colorBuffer, bool bFlushImmediate) override;
 	void InsertUAVBarrier(const IGpuBuffer* gpuBuffer, bool bFlushImmediate) override;
+	void BeginResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) override;
+	void BeginResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) override;
+	void EndResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) override;
+	void EndResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) override;
 	void FlushResourceBarriers() override;
 
 	DynAlloc ReserveUploadMemory(size_t sizeInBytes) override;
@@ -159,7 +164,7 @@ public:
 	void SetDescriptorHeaps(uint32_t heapCount, D3D12_DESCRIPTOR_HEAP_TYPE types[], ID3D12DescriptorHeap* heapPtrs[]);
 
 protected:
-	void TransitionResource_Internal(ID3D12Resource* resource, D3D12_RESOURCE_STATES oldState, D3D12_RESOURCE_STATES newState, bool bFlushImmediate);
+	void TransitionResource_Internal(ID3D12Resource* resource, D3D12_RESOURCE_STATES oldState, D3D12_RESOURCE_STATES newState, bool bFlushImmediate, D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE);
 	void InsertUAVBarrier_Internal(ID3D12Resource* resource, bool bFlushImmediate);
 	void InitializeBuffer_Internal(IGpuBuffer* destBuffer, const void* bufferData, size_t numBytes, size_t offset) override;
 	void InitializeTexture_Internal(ITexture* destTexture, const TextureInitializer& texInit) override;
@@ -172,6 +177,9 @@ private:
 	void BindRenderTargets();
 	void ResetRenderTargets();
 
+	void PrepareForSubmit();
+	void ReleaseAfterSubmit(uint64_t fenceValue);
+
 private:
 	std::string m_id;
 	CommandListType m_commandListType;
@@ -12,6 +12,8 @@
 
 #include "DepthBuffer12.h"
 
+#include "DeviceManager12.h"
+
 
 namespace Luna::DX12
 {
@@ -27,6 +29,15 @@ DepthBuffer::DepthBuffer(Device* device)
 }
 
 
+DepthBuffer::~DepthBuffer()
+{
+	if (auto deviceManager = GetD3D12DeviceManager())
+	{
+		deviceManager->ReleaseResource(m_resource.get());
+	}
+}
+
+
 const IDescriptor* DepthBuffer::GetDsvDescriptor(DepthStencilAspect depthStencilAspect) const noexcept
 {
 	switch (depthStencilAspect)
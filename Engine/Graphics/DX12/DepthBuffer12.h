@@ -28,6 +28,7 @@ class DepthBuffer : public IDepthBuffer
 
 public:
 	explicit DepthBuffer(Device* device);
+	~DepthBuffer() override;
 
 	const IDescriptor* GetDsvDescriptor(DepthStencilAspect aspect) const noexcept override;
 	const IDescriptor* GetSrvDescriptor(bool depthSrv) const noexcept override;
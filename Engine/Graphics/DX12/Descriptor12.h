@@ -25,11 +25,14 @@ namespace Luna::DX12
 class Device;
 
 
+// Generational handle to a range of CPU descriptors from a DescriptorAllocator
 struct DescriptorHandle2
 {
 	uint32_t heapType : DESCRIPTOR_HANDLE_HEAP_TYPE_BIT_NUM { 0 };
 	uint32_t heapIndex : DESCRIPTOR_HANDLE_HEAP_INDEX_BIT_NUM { 0 };
 	uint32_t heapOffset : DESCRIPTOR_HANDLE_HEAP_OFFSET_BIT_NUM { 0 };
+	uint32_t count{ 0 };
+	uint32_t generation{ 0 };
 	bool allocated{ false };
 };
 
@@ -28,47 +28,85 @@ UserDescriptorHeap g_userDescriptorHeap[2] =
 };
 
 
-D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::Allocate(ID3D12Device* device, uint32_t count)
+static_assert(DESCRIPTOR_BATCH_SIZE <= (1 << DESCRIPTOR_HANDLE_HEAP_OFFSET_BIT_NUM));
+
+
+DescriptorAllocator::DescriptorAllocator(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type)
+	: m_device{ device }
+	, m_type{ type }
+	, m_descriptorSize{ device->GetDescriptorHandleIncrementSize(type) }
+	, m_slotAllocator{ DESCRIPTOR_BATCH_SIZE, [this](uint32_t heapIndex) { CreateHeap(heapIndex); } }
 {
-	assert(count <= m_numDescriptorsPerHeap);
+}
 
-	if (m_currentHeap == nullptr || m_remainingFreeHandles < count)
-	{
-		m_currentHeap = RequestNewHeap(device);
-		m_currentHandle = m_currentHeap->GetCPUDescriptorHandleForHeapStart();
-		m_remainingFreeHandles = m_numDescriptorsPerHeap;
-
-		if (m_descriptorSize == 0)
-		{
-			m_descriptorSize = GetDescriptorHandleIncrementSize(m_type);
-		}
-	}
 
-	auto handle = m_currentHandle;
-	m_currentHandle.ptr += count * m_descriptorSize;
-	m_remainingFreeHandles -= count;
-	return handle;
+DescriptorHandle2 DescriptorAllocator::Allocate(uint32_t count)
+{
+	const DescriptorSlotRange range = m_slotAllocator.Allocate(count);
+
+	return DescriptorHandle2{
+		.heapType		= (uint32_t)m_type,
+		.heapIndex		= range.pageIndex,
+		.heapOffset		= range.offset,
+		.count			= range.count,
+		.generation		= range.generation,
+		.allocated		= true
+	};
 }
 
 
-ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(ID3D12Device* device)
+void DescriptorAllocator::Free(const DescriptorHandle2& handle, uint64_t fenceValue)
 {
-	lock_guard<mutex> guard{ m_allocationMutex };
+	assert(handle.allocated && handle.heapType == (uint32_t)m_type);
+
+	m_slotAllocator.Free(HandleToRange(handle), fenceValue);
+}
+
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::GetCpuHandle(const DescriptorHandle2& handle) const
+{
+	assert(handle.heapType == (uint32_t)m_type);
+	assert_msg(m_slotAllocator.IsAllocated(HandleToRange(handle)), "Stale descriptor handle");
+
+	lock_guard<mutex> lock(m_heapMutex);
+
+	return D3D12_CPU_DESCRIPTOR_HANDLE{ m_heapBasePointers[handle.heapIndex] + handle.heapOffset * m_descriptorSize };
+}
+
+
+void DescriptorAllocator::CreateHeap(uint32_t heapIndex)
+{
+	// Can't create a new heap because the index doesn't fit into "DESCRIPTOR_HANDLE_HEAP_INDEX_BIT_NUM" bits
+	assert(heapIndex < (1 << DESCRIPTOR_HANDLE_HEAP_INDEX_BIT_NUM));
 
 	auto desc = D3D12_DESCRIPTOR_HEAP_DESC{
 		.Type				= m_type,
-		.NumDescriptors		= m_numDescriptorsPerHeap,
+		.NumDescriptors		= DESCRIPTOR_BATCH_SIZE,
 		.Flags				= D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
 		.NodeMask			= 1
 	};
 
 	wil::com_ptr<ID3D12DescriptorHeap> heap;
-	assert_succeeded(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap)));
+	assert_succeeded(m_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap)));
+
+	SetDebugName(heap.get(), format("DescriptorAllocator [{}] {}", D3DTypeToString(m_type), heapIndex));
+
+	lock_guard<mutex> lock(m_heapMutex);
+
+	assert(heapIndex == (uint32_t)m_heaps.size());
+	m_heapBasePointers.push_back(heap->GetCPUDescriptorHandleForHeapStart().ptr);
+	m_heaps.emplace_back(heap);
+}
 
-	SetDebugName(heap.get(), format("DescriptorAllocator [{}] {}", m_type, m_descriptorHeapPool.size()));
-	m_descriptorHeapPool.emplace_back(heap);
 
-	return heap.get();
+DescriptorSlotRange DescriptorAllocator::HandleToRange(const DescriptorHandle2& handle) const noexcept
+{
+	return DescriptorSlotRange{
+		.pageIndex		= handle.heapIndex,
+		.offset			= handle.heapOffset,
+		.count			= handle.count,
+		.generation		= handle.generation
+	};
 }
 
 
@@ -89,19 +127,59 @@ void UserDescriptorHeap::Create(const string& debugHeapName)
 
 void UserDescriptorHeap::Destroy()
 {
+	lock_guard<mutex> lock(m_mutex);
+
+	m_pendingFrees.clear();
+	m_freeRanges.clear();
 	m_heap = nullptr;
 }
 
 
 DescriptorHandle UserDescriptorHeap::Alloc(uint32_t count)
 {
+	lock_guard<mutex> lock(m_mutex);
+
+	// Tables are renamed with the same count they were created with, so an exact match is the common case
+	auto it = m_freeRanges.find(count);
+	if (it != m_freeRanges.end() && !it->second.empty())
+	{
+		DescriptorHandle ret = it->second.back();
+		it->second.pop_back();
+		return ret;
+	}
+
 	assert_msg(HasAvailableSpace(count), "Descriptor Heap out of space.  Increase heap size.");
 	DescriptorHandle ret = m_nextFreeHandle;
 	m_nextFreeHandle += count * m_descriptorSize;
+	m_numFreeDescriptors -= count;
 	return ret;
 }
 
 
+void UserDescriptorHeap::Free(const DescriptorHandle& handle, uint32_t count, uint64_t fenceValue)
+{
+	assert(ValidateHandle(handle));
+
+	lock_guard<mutex> lock(m_mutex);
+
+	m_pendingFrees.push_back({ .fenceValue = fenceValue, .handle = handle, .count = count });
+}
+
+
+void UserDescriptorHeap::Reclaim(uint64_t completedFenceValue)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	// Frees are stamped with increasing fence values, so stop at the first one still in flight
+	while (!m_pendingFrees.empty() && m_pendingFrees.front().fenceValue <= completedFenceValue)
+	{
+		const PendingFree& pending = m_pendingFrees.front();
+		m_freeRanges[pending.count].push_back(pending.handle);
+		m_pendingFrees.pop_front();
+	}
+}
+
+
 bool UserDescriptorHeap::ValidateHandle(const DescriptorHandle& dhandle) const
 {
 	if (dhandle.GetCpuHandle().ptr < m_firstHandle.GetCpuHandle().ptr ||
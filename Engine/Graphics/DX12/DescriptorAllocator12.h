@@ -10,35 +10,44 @@
 
 #pragma once
 
+#include "Graphics\DescriptorSlotAllocator.h"
+#include "Graphics\DX12\Descriptor12.h"
 #include "Graphics\DX12\DirectXCommon.h"
 
 
 namespace Luna::DX12
 {
 
-class DescriptorAllocator
+// CPU-only descriptors of one heap type.  Heaps of DESCRIPTOR_BATCH_SIZE descriptors are created on demand, and
+// freed descriptors are recycled once the fence they were freed against has completed.
+class DescriptorAllocator : public NonCopyable
 {
 public:
-	explicit DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type)
-		: m_type{ type }
-	{
-	}
+	DescriptorAllocator(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type);
 
-	D3D12_CPU_DESCRIPTOR_HANDLE Allocate(ID3D12Device* device, uint32_t count);
+	DescriptorHandle2 Allocate(uint32_t count = 1);
+	void Free(const DescriptorHandle2& handle, uint64_t fenceValue);
+	void Reclaim(uint64_t completedFenceValue) { m_slotAllocator.Reclaim(completedFenceValue); }
 
-private:
-	ID3D12DescriptorHeap* RequestNewHeap(ID3D12Device* device);
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(const DescriptorHandle2& handle) const;
+
+	D3D12_DESCRIPTOR_HEAP_TYPE GetType() const noexcept { return m_type; }
+	DescriptorSlotStats GetStats() const { return m_slotAllocator.GetStats(); }
 
 private:
-	static constexpr uint32_t m_numDescriptorsPerHeap{ 256 };
+	void CreateHeap(uint32_t heapIndex);
+	DescriptorSlotRange HandleToRange(const DescriptorHandle2& handle) const noexcept;
 
+private:
+	ID3D12Device* m_device{ nullptr };
 	D3D12_DESCRIPTOR_HEAP_TYPE m_type{ D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV };
-	std::mutex m_allocationMutex;
-	std::vector<wil::com_ptr<ID3D12DescriptorHeap>> m_descriptorHeapPool;
-	ID3D12DescriptorHeap* m_currentHeap{ nullptr };
-	D3D12_CPU_DESCRIPTOR_HANDLE m_currentHandle{ D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN };
 	uint32_t m_descriptorSize{ 0 };
-	uint32_t m_remainingFreeHandles{ 0 };
+
+	mutable std::mutex m_heapMutex;
+	std::vector<wil::com_ptr<ID3D12DescriptorHeap>> m_heaps;
+	std::vector<uint64_t> m_heapBasePointers;
+
+	DescriptorSlotAllocator m_slotAllocator;
 };
 
 
@@ -109,6 +118,11 @@ public:
 	bool HasAvailableSpace(uint32_t count) const { return count <= m_numFreeDescriptors; }
 	DescriptorHandle Alloc(uint32_t count = 1);
 
+	// The range goes back to Alloc() calls of the same count once Reclaim() sees a completed fence value at or
+	// past fenceValue
+	void Free(const DescriptorHandle& handle, uint32_t count, uint64_t fenceValue);
+	void Reclaim(uint64_t completedFenceValue);
+
 	DescriptorHandle GetHandleAtOffset(uint32_t offset) const { return m_firstHandle + offset * m_descriptorSize; }
 
 	bool ValidateHandle(const DescriptorHandle& dhandle) const;
@@ -122,6 +136,20 @@ private:
 	uint32_t m_numFreeDescriptors;
 	DescriptorHandle m_firstHandle;
 	DescriptorHandle m_nextFreeHandle;
+
+	std::mutex m_mutex;
+
+	// Freed ranges in the order they were freed, along with the fence they wait on
+	struct PendingFree
+	{
+		uint64_t fenceValue{ 0 };
+		DescriptorHandle handle;
+		uint32_t count{ 0 };
+	};
+	std::deque<PendingFree> m_pendingFrees;
+
+	// Reclaimed ranges, by count
+	std::unordered_map<uint32_t, std::vector<DescriptorHandle>> m_freeRanges;
 };
 
 extern UserDescriptorHeap g_userDescriptorHeap[];
@@ -16,6 +16,7 @@
 #include "DepthBuffer12.h"
 #include "Descriptor12.h"
 #include "Device12.h"
+#include "DeviceManager12.h"
 #include "GpuBuffer12.h"
 #include "Sampler12.h"
 #include "Texture12.h"
@@ -81,6 +82,9 @@ void DescriptorSet::SetSRV(uint32_t srvRegister, GpuBufferPtr gpuBuffer)
 
 void DescriptorSet::SetSRV(uint32_t srvRegister, TexturePtr texture)
 {
+	// Descriptor sets are not revisited once written, so this needs the real texture
+	texture->WaitForLoad();
+
 	const uint32_t descriptorSlot = GetSrvOffset(srvRegister);
 
 	UpdateDescriptor(descriptorSlot, ((const Descriptor*)texture->GetDescriptor())->GetHandleCPU());
@@ -137,6 +141,37 @@ void DescriptorSet::SetSampler(uint32_t samplerRegister, SamplerPtr sampler)
 }
 
 
+void DescriptorSet::Rename()
+{
+	if (m_descriptorHandle.IsNull())
+	{
+		return;
+	}
+
+	const D3D12_DESCRIPTOR_HEAP_TYPE heapType = m_isSamplerTable
+		? D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER
+		: D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+
+	DescriptorHandle oldHandle = m_descriptorHandle;
+	m_descriptorHandle = AllocateUserDescriptor(heapType, m_numDescriptors);
+
+	for (uint32_t i = 0; i < m_numDescriptors; ++i)
+	{
+		if (m_descriptors[i].ptr != D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+		{
+			UpdateDescriptor(i, m_descriptors[i]);
+		}
+	}
+
+	// Submitted work, and work still being recorded, may read the old table until the next graphics fence.
+	// Anything renamed after the device manager is gone is never reused.
+	auto deviceManager = GetD3D12DeviceManager();
+	const uint64_t fenceValue = deviceManager ? deviceManager->GetQueue(CommandListType::Graphics).GetNextFenceValue() : UINT64_MAX;
+
+	g_userDescriptorHeap[heapType].Free(oldHandle, m_numDescriptors, fenceValue);
+}
+
+
 bool DescriptorSet::HasBindableDescriptors() const
 {
 	return !m_descriptors.empty();
@@ -163,6 +198,8 @@ uint64_t DescriptorSet::GetGpuAddressWithOffset() const
 
 void DescriptorSet::UpdateDescriptor(uint32_t slot, D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
+	assert(slot < m_numDescriptors);
+
 	const D3D12_DESCRIPTOR_HEAP_TYPE heapType = m_isSamplerTable
 		? D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER
 		: D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
@@ -174,6 +211,8 @@ void DescriptorSet::UpdateDescriptor(uint32_t slot, D3D12_CPU_DESCRIPTOR_HANDLE
 	DescriptorHandle offsetHandle = m_descriptorHandle + slot * descriptorSize;
 
 	d3d12Device->CopyDescriptorsSimple(1, offsetHandle.GetCpuHandle(), descriptor, heapType);
+
+	m_descriptors[slot] = descriptor;
 }
 
 
@@ -46,6 +46,8 @@ public:
 
 	void SetSampler(uint32_t samplerRegister, SamplerPtr sampler) override;
 
+	void Rename() override;
+
 	bool HasBindableDescriptors() const;
 	D3D12_GPU_DESCRIPTOR_HANDLE GetGpuDescriptorHandle() const;
 	uint64_t GetGpuAddress() const;
@@ -64,7 +66,9 @@ protected:
 
 	RootParameter m_rootParameter;
 
-	std::array<D3D12_CPU_DESCRIPTOR_HANDLE, MaxDescriptorsPerTable> m_descriptors;
+	// CPU descriptors last copied into each slot, so Rename() can fill a new table without reading back from the
+	// shader-visible heap
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_descriptors;
 	DescriptorHandle m_descriptorHandle;
 	uint64_t m_gpuAddress{ D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN };
 	uint32_t m_numDescriptors{ 0 };
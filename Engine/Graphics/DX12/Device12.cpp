@@ -43,7 +43,10 @@ Device::Device(ID3D12Device* device, D3D12MA::Allocator* allocator)
 	: m_device{ device }
 	, m_allocator{ allocator }
 {
-	m_freeDescriptors.resize(D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES, vector<DescriptorHandle2>());
+	for (uint32_t i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+	{
+		m_descriptorAllocators[i] = make_unique<DescriptorAllocator>(device, (D3D12_DESCRIPTOR_HEAP_TYPE)i);
+	}
 
 	m_device2 = m_device.query<ID3D12Device2>();
 
@@ -654,19 +657,25 @@ Luna::RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& root
 	std::vector<uint32_t> descriptorTableSize;
 	descriptorTableSize.reserve(16);
 
-	// Calculate hash
-	size_t hashCode = 0;
+	// The key holds everything the serialized root signature depends on.  Parameters only point to their
+	// descriptor ranges, so tables are appended by content.
+	StateObjectKey key;
+	key.Append(d3d12RootSignatureDesc.Desc_1_1.NumParameters);
+
 	for (uint32_t param = 0; param < d3d12RootSignatureDesc.Desc_1_1.NumParameters; ++param)
 	{
 		const D3D12_ROOT_PARAMETER1& rootParam = d3d12RootSignatureDesc.Desc_1_1.pParameters[param];
 		descriptorTableSize.push_back(0);
 
+		key.Append(rootParam.ParameterType);
+		key.Append(rootParam.ShaderVisibility);
+
 		if (rootParam.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
 		{
 			assert(rootParam.DescriptorTable.pDescriptorRanges != nullptr);
 
-			hashCode = Utility::HashState(rootParam.DescriptorTable.pDescriptorRanges,
-				rootParam.DescriptorTable.NumDescriptorRanges, hashCode);
+			key.Append(rootParam.DescriptorTable.NumDescriptorRanges);
+			key.Append(rootParam.DescriptorTable.pDescriptorRanges, rootParam.DescriptorTable.NumDescriptorRanges);
 
 			// We keep track of sampler descriptor tables separately from CBV_SRV_UAV descriptor tables
 			if (rootParam.DescriptorTable.pDescriptorRanges->RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER)
@@ -683,64 +692,48 @@ Luna::RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& root
 				descriptorTableSize[param] += rootParam.DescriptorTable.pDescriptorRanges[tableRange].NumDescriptors;
 			}
 		}
-		else
-		{
-			hashCode = Utility::HashState(&rootParam, 1, hashCode);
-		}
-	}
-
-	ID3D12RootSignature** rootSignatureRef = nullptr;
-	bool firstCompile = false;
-	{
-		lock_guard<mutex> lock(m_rootSignatureMutex);
-
-		auto iter = m_rootSignatureHashMap.find(hashCode);
-
-		// Reserve space so the next inquiry will find that someone got here first.
-		if (iter == m_rootSignatureHashMap.end())
+		else if (rootParam.ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
 		{
-			rootSignatureRef = m_rootSignatureHashMap[hashCode].addressof();
-			firstCompile = true;
+			key.Append(rootParam.Constants);
 		}
 		else
 		{
-			rootSignatureRef = iter->second.addressof();
+			key.Append(rootParam.Descriptor);
 		}
 	}
 
-	ID3D12RootSignature* pRootSignature = nullptr;
-
-	if (firstCompile)
-	{
-		wil::com_ptr<ID3DBlob> pOutBlob, pErrorBlob;
+	key.Append(d3d12RootSignatureDesc.Desc_1_1.NumStaticSamplers);
+	key.Append(staticSamplers.data(), staticSamplers.size());
+	key.Append(d3d12RootSignatureDesc.Desc_1_1.Flags);
 
-		HRESULT hr = S_OK;
-		hr = D3D12SerializeVersionedRootSignature(&d3d12RootSignatureDesc, &pOutBlob, &pErrorBlob);
-		if (hr != S_OK)
+	auto pRootSignature = m_rootSignatureCache.FindOrCreate(key, [&]() -> wil::com_ptr<ID3D12RootSignature>
 		{
-			LogError(LogDirectX) << "Error compiling root signature, HRESULT  0x" << std::hex << std::setw(8) << hr << endl;
-			if (pErrorBlob)
+			wil::com_ptr<ID3DBlob> pOutBlob, pErrorBlob;
+
+			HRESULT hr = S_OK;
+			hr = D3D12SerializeVersionedRootSignature(&d3d12RootSignatureDesc, &pOutBlob, &pErrorBlob);
+			if (hr != S_OK)
 			{
-				LogError(LogDirectX) << (const char*)pErrorBlob->GetBufferPointer() << endl;
+				LogError(LogDirectX) << "Error compiling root signature, HRESULT  0x" << std::hex << std::setw(8) << hr << endl;
+				if (pErrorBlob)
+				{
+					LogError(LogDirectX) << (const char*)pErrorBlob->GetBufferPointer() << endl;
+				}
+				return nullptr;
 			}
-			return nullptr;
-		}
 
-		assert_succeeded(m_device->CreateRootSignature(0, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(),
-			IID_PPV_ARGS(&pRootSignature)));
+			wil::com_ptr<ID3D12RootSignature> pNewRootSignature;
+			assert_succeeded(m_device->CreateRootSignature(0, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(),
+				IID_PPV_ARGS(&pNewRootSignature)));
 
-		SetDebugName(pRootSignature, rootSignatureDesc.name);
+			SetDebugName(pNewRootSignature.get(), rootSignatureDesc.name);
 
-		m_rootSignatureHashMap[hashCode].attach(pRootSignature);
-		assert(*rootSignatureRef == pRootSignature);
-	}
-	else
+			return pNewRootSignature;
+		});
+
+	if (!pRootSignature)
 	{
-		while (rootSignatureRef == nullptr)
-		{
-			this_thread::yield();
-		}
-		pRootSignature = *rootSignatureRef;
+		return nullptr;
 	}
 
 	auto rootSignature = std::make_shared<RootSignature>();
@@ -766,13 +759,13 @@ Luna::GraphicsPipelinePtr Device::CreateGraphicsPipeline(const GraphicsPipelineD
 	{
 		CD3DX12_PIPELINE_STATE_STREAM5 pipelineStream5{};
 		FillGraphicsPipelineStateStream5(pipelineStream5, context.stateDesc, pipelineDesc);
-		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM5>(pipelineStream5, context.hashCode, pipelineDesc);
+		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM5>(pipelineStream5, context.key, context.persistentHash, pipelineDesc);
 	}
 	else
 	{
 		CD3DX12_PIPELINE_STATE_STREAM4 pipelineStream4{};
 		FillGraphicsPipelineStateStream4(pipelineStream4, context.stateDesc, pipelineDesc);
-		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.hashCode, pipelineDesc);
+		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.key, context.persistentHash, pipelineDesc);
 	}
 #endif
 
@@ -780,7 +773,7 @@ Luna::GraphicsPipelinePtr Device::CreateGraphicsPipeline(const GraphicsPipelineD
 	{
 		CD3DX12_PIPELINE_STATE_STREAM4 pipelineStream4{};
 		FillGraphicsPipelineStateStream4(pipelineStream4, context.stateDesc, pipelineDesc);
-		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.hashCode, pipelineDesc);
+		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.key, context.persistentHash, pipelineDesc);
 	}
 #endif
 
@@ -788,14 +781,14 @@ Luna::GraphicsPipelinePtr Device::CreateGraphicsPipeline(const GraphicsPipelineD
 	{
 		CD3DX12_PIPELINE_STATE_STREAM3 pipelineStream3{};
 		FillGraphicsPipelineStateStream3(pipelineStream3, context.stateDesc, pipelineDesc);
-		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM3>(pipelineStream3, context.hashCode, pipelineDesc);
+		return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM3>(pipelineStream3, context.key, context.persistentHash, pipelineDesc);
 	}
 #endif
 
 	
 	CD3DX12_PIPELINE_STATE_STREAM2 pipelineStream2{};
 	FillGraphicsPipelineStateStream2(pipelineStream2, context.stateDesc, pipelineDesc);
-	return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM2>(pipelineStream2, context.hashCode, pipelineDesc);
+	return CreateGraphicsPipelineStream<CD3DX12_PIPELINE_STATE_STREAM2>(pipelineStream2, context.key, context.persistentHash, pipelineDesc);
 }
 
 
@@ -816,50 +809,32 @@ Luna::ComputePipelinePtr Device::CreateComputePipeline(const ComputePipelineDesc
 	}
 	assert(d3d12PipelineDesc.pRootSignature != nullptr);
 
-	size_t hashCode = Utility::HashState(&d3d12PipelineDesc);
-
-	// Find or create compute pipeline state object
-	ID3D12PipelineState** pipelineStateRef = nullptr;
-	bool firstCompile = false;
-	{
-		lock_guard<mutex> lock(m_computePipelineStateMutex);
+	// The root signature and shader are cached too, so their addresses identify them.  The rest is appended field
+	// by field, since the desc has padding.
+	StateObjectKey key;
+	key.Append(d3d12PipelineDesc.pRootSignature);
+	key.Append(d3d12PipelineDesc.CS.pShaderBytecode);
+	key.Append(d3d12PipelineDesc.CS.BytecodeLength);
+	key.Append(d3d12PipelineDesc.NodeMask);
+	key.Append(d3d12PipelineDesc.Flags);
 
-		auto iter = m_computePipelineStateHashMap.find(hashCode);
-
-		// Reserve space so the next inquiry will find that someone got here first.
-		if (iter == m_computePipelineStateHashMap.end())
-		{
-			pipelineStateRef = m_computePipelineStateHashMap[hashCode].addressof();
-			firstCompile = true;
-		}
-		else
+	auto pPipelineState = m_computePipelineStateCache.FindOrCreate(key, [&]
 		{
-			pipelineStateRef = iter->second.addressof();
-		}
-	}
-
-	ID3D12PipelineState* pPipelineState = nullptr;
+			const size_t persistentHash = HashShaderBytecode(d3d12PipelineDesc.CS, Utility::HashState(&d3d12PipelineDesc.NodeMask));
 
-	if (firstCompile)
-	{
-		wil::com_ptr<ID3DBlob> pOutBlob, pErrorBlob;
+			wil::com_ptr<ID3D12PipelineState> pNewPipelineState;
+			if (!LoadCachedPipeline(persistentHash, d3d12PipelineDesc, &pNewPipelineState))
+			{
+				HRESULT res = m_device->CreateComputePipelineState(&d3d12PipelineDesc, IID_PPV_ARGS(&pNewPipelineState));
+				ThrowIfFailed(res);
 
-		HRESULT res = m_device->CreateComputePipelineState(&d3d12PipelineDesc, IID_PPV_ARGS(&pPipelineState));
-		ThrowIfFailed(res);
+				StoreCachedPipeline(persistentHash, pNewPipelineState.get());
+			}
 
-		SetDebugName(pPipelineState, pipelineDesc.name);
+			SetDebugName(pNewPipelineState.get(), pipelineDesc.name);
 
-		m_computePipelineStateHashMap[hashCode].attach(pPipelineState);
-		assert(*pipelineStateRef == pPipelineState);
-	}
-	else
-	{
-		while (pipelineStateRef == nullptr)
-		{
-			this_thread::yield();
-		}
-		pPipelineState = *pipelineStateRef;
-	}
+			return pNewPipelineState;
+		});
 
 	auto computePipeline = std::make_shared<ComputePipeline>();
 
@@ -881,13 +856,13 @@ MeshletPipelinePtr Device::CreateMeshletPipeline(const MeshletPipelineDesc& pipe
 	{
 		CD3DX12_PIPELINE_STATE_STREAM5 pipelineStream5{};
 		FillMeshletPipelineStateStream5(pipelineStream5, context.stateDesc, pipelineDesc);
-		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM5>(pipelineStream5, context.hashCode, pipelineDesc);
+		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM5>(pipelineStream5, context.key, context.persistentHash, pipelineDesc);
 	}
 	else
 	{
 		CD3DX12_PIPELINE_STATE_STREAM4 pipelineStream4{};
 		FillMeshletPipelineStateStream4(pipelineStream4, context.stateDesc, pipelineDesc);
-		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.hashCode, pipelineDesc);
+		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.key, context.persistentHash, pipelineDesc);
 	}
 #endif
 
@@ -895,7 +870,7 @@ MeshletPipelinePtr Device::CreateMeshletPipeline(const MeshletPipelineDesc& pipe
 	{
 		CD3DX12_PIPELINE_STATE_STREAM4 pipelineStream4{};
 		FillMeshletPipelineStateStream4(pipelineStream4, context.stateDesc, pipelineDesc);
-		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.hashCode, pipelineDesc);
+		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM4>(pipelineStream4, context.key, context.persistentHash, pipelineDesc);
 	}
 #endif
 
@@ -903,14 +878,14 @@ MeshletPipelinePtr Device::CreateMeshletPipeline(const MeshletPipelineDesc& pipe
 	{
 		CD3DX12_PIPELINE_STATE_STREAM3 pipelineStream3{};
 		FillMeshletPipelineStateStream3(pipelineStream3, context.stateDesc, pipelineDesc);
-		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM3>(pipelineStream3, context.hashCode, pipelineDesc);
+		return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM3>(pipelineStream3, context.key, context.persistentHash, pipelineDesc);
 	}
 #endif
 
 
 	CD3DX12_PIPELINE_STATE_STREAM2 pipelineStream2{};
 	FillMeshletPipelineStateStream2(pipelineStream2, context.stateDesc, pipelineDesc);
-	return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM2>(pipelineStream2, context.hashCode, pipelineDesc);
+	return CreateMeshletPipelineStream<CD3DX12_PIPELINE_STATE_STREAM2>(pipelineStream2, context.key, context.persistentHash, pipelineDesc);
 }
 
 
@@ -938,10 +913,7 @@ DescriptorSetPtr Device::CreateDescriptorSet(const DescriptorSetDesc& descriptor
 	auto descriptorSet = std::make_shared<DescriptorSet>(this, descriptorSetDesc.rootParameter);
 
 	descriptorSet->m_device = this;
-	for (uint32_t i = 0; i < MaxDescriptorsPerTable; ++i)
-	{
-		descriptorSet->m_descriptors[i].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-	}
+	descriptorSet->m_descriptors.resize(descriptorSetDesc.numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE{ .ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN });
 	descriptorSet->m_descriptorHandle = descriptorSetDesc.descriptorHandle;
 	descriptorSet->m_numDescriptors = descriptorSetDesc.numDescriptors;
 	descriptorSet->m_isSamplerTable = descriptorSetDesc.isSamplerTable;
@@ -1027,24 +999,17 @@ SamplerPtr Device::CreateSampler(const SamplerDesc& samplerDesc)
 		.MaxLOD				= { samplerDesc.maxLOD }
 	};
 
-	shared_ptr<Sampler> sampler;
-
-	const size_t hashValue = Utility::HashState(&d3d12SamplerDesc);
+	// Every field is four bytes, so the desc has no padding
+	StateObjectKey key;
+	key.Append(d3d12SamplerDesc);
 
-	std::lock_guard lock(m_samplerMutex);
-
-	auto iter = m_samplerMap.find(hashValue);
-	if (iter != m_samplerMap.end())
-	{
-		sampler = iter->second;
-	}
-	else
-	{
-		sampler = make_shared<Sampler>(this);
-		sampler->m_samplerDescriptor.CreateSampler(d3d12SamplerDesc);
+	auto sampler = m_samplerCache.FindOrCreate(key, [&]
+		{
+			auto newSampler = make_shared<Sampler>(this);
+			newSampler->m_samplerDescriptor.CreateSampler(d3d12SamplerDesc);
 
-		m_samplerMap[hashValue] = sampler;
-	}
+			return newSampler;
+		});
 
 	return sampler;
 }
@@ -1219,82 +1184,263 @@ void Device::FillCaps(const AdapterInfo& adapterInfo)
 }
 
 
-DescriptorHandle2 Device::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE heapType)
+void Device::LoadPipelineCache()
 {
-	lock_guard lock(m_freeDescriptorMutexes[heapType]);
+	// The runtime rejects libraries from another driver version itself, with D3D12_ERROR_DRIVER_VERSION_MISMATCH
+	m_pipelineCacheIdentity = PipelineCacheIdentity{
+		.api			= GraphicsApi::D3D12,
+		.vendorId		= m_caps.adapterInfo.vendorId,
+		.deviceId		= m_caps.adapterInfo.deviceId,
+		.driverVersion	= 0
+	};
 
-	DescriptorHandle2 descriptorHandle{};
+	const string filename = GetPipelineCacheFilename(GraphicsApi::D3D12);
+	const PipelineCacheStatus status = ReadPipelineCacheFile(filename, m_pipelineCacheIdentity, m_pipelineLibraryData);
+	if (status != PipelineCacheStatus::Loaded && status != PipelineCacheStatus::NotFound)
+	{
+		LogInfo(LogPipelineCache) << "Discarded pipeline cache " << filename << " (" << PipelineCacheStatusToString(status) << ")" << endl;
+	}
 
-	// Create a new descriptor heap if there is no a free descriptor
-	auto& freeDescriptors = m_freeDescriptors[heapType];
-	if (freeDescriptors.empty())
+	wil::com_ptr<ID3D12PipelineLibrary1> pipelineLibrary;
+	if (!m_pipelineLibraryData.empty())
 	{
-		lock_guard lock2(m_descriptorHeapLock);
-
-		// Can't create a new heap because the index doesn't fit into "DESCRIPTOR_HANDLE_HEAP_INDEX_BIT_NUM" bits
-		size_t heapIndex = m_descriptorHeaps.size();
-		assert(heapIndex < (1 << DESCRIPTOR_HANDLE_HEAP_INDEX_BIT_NUM));
-
-		// Create a new batch of descriptors
-		D3D12_DESCRIPTOR_HEAP_DESC desc{
-			.Type = heapType,
-			.NumDescriptors = DESCRIPTOR_BATCH_SIZE,
-			.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
-			.NodeMask = 1
-		};
+		HRESULT hr = m_device2->CreatePipelineLibrary(m_pipelineLibraryData.data(), m_pipelineLibraryData.size(), IID_PPV_ARGS(&pipelineLibrary));
+		if (SUCCEEDED(hr))
+		{
+			m_pipelineCacheBytesLoaded = m_pipelineLibraryData.size();
+		}
+		else
+		{
+			LogInfo(LogPipelineCache) << "Discarded pipeline cache " << filename << ", HRESULT 0x" << std::hex << std::setw(8) << hr << std::dec << endl;
 
-		wil::com_ptr<ID3D12DescriptorHeap> descriptorHeap;
-		assert_succeeded(m_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&descriptorHeap)));
+			m_pipelineLibraryData.clear();
 
-		DescriptorHeapDesc descriptorHeapDesc{
-			.heap = descriptorHeap,
-			.basePointerCPU = descriptorHeap->GetCPUDescriptorHandleForHeapStart().ptr,
-			.descriptorSize = m_device->GetDescriptorHandleIncrementSize(heapType)
-		};
+			error_code ec;
+			filesystem::remove(filename, ec);
+		}
+	}
 
-		m_descriptorHeaps.push_back(descriptorHeapDesc);
+	if (!pipelineLibrary)
+	{
+		HRESULT hr = m_device2->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&pipelineLibrary));
+		if (FAILED(hr))
+		{
+			LogWarning(LogPipelineCache) << "Pipeline libraries are not supported, pipelines will not be cached on disk" << endl;
+			return;
+		}
+	}
 
-		// Add the new batch of free descriptors
-		freeDescriptors.reserve(desc.NumDescriptors);
+	m_pipelineLibrary = pipelineLibrary;
+}
 
-		for (uint32_t i = 0; i < desc.NumDescriptors; ++i)
-		{
-			DescriptorHandle2 handle{
-				.heapType		= (uint32_t)heapType,
-				.heapIndex		= (uint32_t)heapIndex,
-				.heapOffset		= i,
-				.allocated		= true
-			};
 
-			freeDescriptors.push_back(handle);
-		}
+void Device::SavePipelineCache()
+{
+	lock_guard lock(m_pipelineLibraryMutex);
+
+	if (!m_pipelineLibrary || !m_pipelineLibraryDirty)
+	{
+		return;
+	}
+
+	vector<std::byte> serializedData(m_pipelineLibrary->GetSerializedSize());
+	HRESULT hr = m_pipelineLibrary->Serialize(serializedData.data(), serializedData.size());
+	if (FAILED(hr))
+	{
+		LogWarning(LogPipelineCache) << "Failed to serialize pipeline library, HRESULT 0x" << std::hex << std::setw(8) << hr << std::dec << endl;
+		return;
+	}
+
+	if (WritePipelineCacheFile(GetPipelineCacheFilename(GraphicsApi::D3D12), m_pipelineCacheIdentity, serializedData))
+	{
+		m_pipelineCacheBytesSaved = serializedData.size();
+		m_pipelineLibraryDirty = false;
+	}
+	else
+	{
+		LogWarning(LogPipelineCache) << "Failed to write pipeline cache" << endl;
+	}
+
+	LogInfo(LogPipelineCache) << "Pipeline cache: " << m_pipelineCacheHits << " hits, " << m_pipelineCacheMisses << " misses, "
+		<< m_pipelineCacheBytesLoaded << " bytes loaded, " << m_pipelineCacheBytesSaved << " bytes saved" << endl;
+}
+
+
+PipelineCacheStats Device::GetPipelineCacheStats() const
+{
+	PipelineCacheStats stats{
+		.numHits		= m_pipelineCacheHits.load(),
+		.numMisses		= m_pipelineCacheMisses.load(),
+		.bytesLoaded	= m_pipelineCacheBytesLoaded,
+		.bytesSaved		= m_pipelineCacheBytesSaved
+	};
+	return stats;
+}
+
+
+bool Device::LoadCachedPipeline(size_t persistentHash, const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc, ID3D12PipelineState** ppPipelineState)
+{
+	if (!m_pipelineLibrary)
+	{
+		return false;
+	}
+
+	const wstring pipelineName = format(L"{:016x}", persistentHash);
+
+	HRESULT hr{};
+	{
+		lock_guard lock(m_pipelineLibraryMutex);
+		hr = m_pipelineLibrary->LoadPipeline(pipelineName.c_str(), &streamDesc, IID_PPV_ARGS(ppPipelineState));
+	}
+
+	// E_INVALIDARG means the name is not in the library, or was stored with a different description
+	if (FAILED(hr))
+	{
+		++m_pipelineCacheMisses;
+		return false;
+	}
+
+	++m_pipelineCacheHits;
+	return true;
+}
+
+
+bool Device::LoadCachedPipeline(size_t persistentHash, const D3D12_COMPUTE_PIPELINE_STATE_DESC& computeDesc, ID3D12PipelineState** ppPipelineState)
+{
+	if (!m_pipelineLibrary)
+	{
+		return false;
 	}
 
-	// Reserve and return one descriptor
-	descriptorHandle = freeDescriptors.back();
-	freeDescriptors.pop_back();
+	const wstring pipelineName = format(L"{:016x}", persistentHash);
 
-	return descriptorHandle;
+	HRESULT hr{};
+	{
+		lock_guard lock(m_pipelineLibraryMutex);
+		hr = m_pipelineLibrary->LoadComputePipeline(pipelineName.c_str(), &computeDesc, IID_PPV_ARGS(ppPipelineState));
+	}
+
+	if (FAILED(hr))
+	{
+		++m_pipelineCacheMisses;
+		return false;
+	}
+
+	++m_pipelineCacheHits;
+	return true;
+}
+
+
+void Device::StoreCachedPipeline(size_t persistentHash, ID3D12PipelineState* pPipelineState)
+{
+	if (!m_pipelineLibrary)
+	{
+		return;
+	}
+
+	const wstring pipelineName = format(L"{:016x}", persistentHash);
+
+	lock_guard lock(m_pipelineLibraryMutex);
+
+	// Fails if the name is already taken by a pipeline with a different description, which just means this
+	// one is not cached
+	if (SUCCEEDED(m_pipelineLibrary->StorePipeline(pipelineName.c_str(), pPipelineState)))
+	{
+		m_pipelineLibraryDirty = true;
+	}
+}
+
+
+DescriptorHandle2 Device::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE heapType)
+{
+	return m_descriptorAllocators[heapType]->Allocate();
 }
 
 
 void Device::FreeDescriptorHandle(const DescriptorHandle2& handle)
 {
-	lock_guard lock(m_freeDescriptorMutexes[handle.heapType]);
+	// Contexts that are still recording may have copied the descriptor, so hold on to it until their work is done.
+	// Anything freed after the device manager is gone is never reused.
+	auto deviceManager = GetD3D12DeviceManager();
+	const uint64_t fenceValue = deviceManager ? deviceManager->GetQueue(CommandListType::Graphics).GetNextFenceValue() : UINT64_MAX;
 
-	auto& freeDescriptors = m_freeDescriptors[handle.heapType];
-	freeDescriptors.push_back(handle);
+	m_descriptorAllocators[handle.heapType]->Free(handle, fenceValue);
 }
 
 
 D3D12_CPU_DESCRIPTOR_HANDLE Device::GetDescriptorHandleCPU(const DescriptorHandle2 handle)
 {
-	lock_guard lock(m_descriptorHeapLock);
+	return m_descriptorAllocators[handle.heapType]->GetCpuHandle(handle);
+}
+
+
+void Device::ReclaimDescriptors(uint64_t completedFenceValue)
+{
+	for (auto& descriptorAllocator : m_descriptorAllocators)
+	{
+		descriptorAllocator->Reclaim(completedFenceValue);
+	}
+
+	g_userDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Reclaim(completedFenceValue);
+	g_userDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].Reclaim(completedFenceValue);
+}
+
+
+DescriptorSlotStats Device::GetDescriptorStats(D3D12_DESCRIPTOR_HEAP_TYPE heapType) const
+{
+	return m_descriptorAllocators[heapType]->GetStats();
+}
+
+
+void Device::LogDescriptorStats() const
+{
+	for (const auto& descriptorAllocator : m_descriptorAllocators)
+	{
+		const DescriptorSlotStats stats = descriptorAllocator->GetStats();
+		if (stats.numAllocations == 0)
+		{
+			continue;
+		}
+
+		LogInfo(LogDirectX) << format("{} descriptors: {} heaps, {} allocated, {} free, {} pending, {:.1f}% fragmentation, {:.1f}% of {} allocations reused",
+			D3DTypeToString(descriptorAllocator->GetType()),
+			stats.numPages,
+			stats.numAllocatedSlots,
+			stats.numFreeSlots,
+			stats.numPendingSlots,
+			100.0f * stats.GetFragmentation(),
+			100.0f * stats.GetReuseRate(),
+			stats.numAllocations) << endl;
+	}
+}
+
+
+void Device::LogStateObjectCacheStats() const
+{
+	const pair<const char*, StateObjectCacheStats> caches[] = {
+		{ "Root signature", m_rootSignatureCache.GetStats() },
+		{ "Graphics pipeline", m_graphicsPipelineStateCache.GetStats() },
+		{ "Compute pipeline", m_computePipelineStateCache.GetStats() },
+		{ "Meshlet pipeline", m_meshletPipelineStateCache.GetStats() },
+		{ "Sampler", m_samplerCache.GetStats() }
+	};
 
-	const DescriptorHeapDesc& descriptorHeapDesc = m_descriptorHeaps[handle.heapIndex];
-	D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandleCPU{ descriptorHeapDesc.basePointerCPU + handle.heapOffset * descriptorHeapDesc.descriptorSize };
+	for (const auto& [name, stats] : caches)
+	{
+		if (stats.numLookups == 0)
+		{
+			continue;
+		}
 
-	return descriptorHandleCPU;
+		LogInfo(LogDirectX) << format("{} cache: {} objects, {:.1f}% of {} lookups hit ({} waited on another thread), {} failures, {} hash collisions",
+			name,
+			stats.numEntries,
+			100.0f * stats.GetHitRate(),
+			stats.numLookups,
+			stats.numWaits,
+			stats.numFailures,
+			stats.numCollisions) << endl;
+	}
 }
 
 
@@ -1378,54 +1524,27 @@ TexturePtr Device::CreateTextureSimple(TextureDimension dimension, const Texture
 
 
 template <class TPipelineStream>
-GraphicsPipelinePtr Device::CreateGraphicsPipelineStream(TPipelineStream& pipelineStream, size_t hashCode, const GraphicsPipelineDesc& pipelineDesc)
+GraphicsPipelinePtr Device::CreateGraphicsPipelineStream(TPipelineStream& pipelineStream, const StateObjectKey& key, size_t persistentHash, const GraphicsPipelineDesc& pipelineDesc)
 {
-	// Find or create graphics pipeline state object
-	ID3D12PipelineState** pipelineStateRef = nullptr;
-	bool firstCompile = false;
-	{
-		lock_guard<mutex> lock(m_graphicsPipelineStateMutex);
-
-		auto iter = m_graphicsPipelineStateHashMap.find(hashCode);
-
-		// Reserve space so the next inquiry will find that someone got here first.
-		if (iter == m_graphicsPipelineStateHashMap.end())
+	auto pPipelineState = m_graphicsPipelineStateCache.FindOrCreate(key, [&]
 		{
-			pipelineStateRef = m_graphicsPipelineStateHashMap[hashCode].addressof();
-			firstCompile = true;
-		}
-		else
-		{
-			pipelineStateRef = iter->second.addressof();
-		}
-	}
+			D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {};
+			pipelineStateStreamDesc.pPipelineStateSubobjectStream = &pipelineStream;
+			pipelineStateStreamDesc.SizeInBytes = sizeof(pipelineStream);
 
-	ID3D12PipelineState* pPipelineState = nullptr;
-
-	if (firstCompile)
-	{
-		wil::com_ptr<ID3DBlob> pOutBlob, pErrorBlob;
-
-		D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {};
-		pipelineStateStreamDesc.pPipelineStateSubobjectStream = &pipelineStream;
-		pipelineStateStreamDesc.SizeInBytes = sizeof(pipelineStream);
+			wil::com_ptr<ID3D12PipelineState> pNewPipelineState;
+			if (!LoadCachedPipeline(persistentHash, pipelineStateStreamDesc, &pNewPipelineState))
+			{
+				HRESULT res = m_device2->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pNewPipelineState));
+				ThrowIfFailed(res);
 
-		HRESULT res = m_device2->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pPipelineState));
-		ThrowIfFailed(res);
+				StoreCachedPipeline(persistentHash, pNewPipelineState.get());
+			}
 
-		SetDebugName(pPipelineState, pipelineDesc.name);
+			SetDebugName(pNewPipelineState.get(), pipelineDesc.name);
 
-		m_graphicsPipelineStateHashMap[hashCode].attach(pPipelineState);
-		assert(*pipelineStateRef == pPipelineState);
-	}
-	else
-	{
-		while (pipelineStateRef == nullptr)
-		{
-			this_thread::yield();
-		}
-		pPipelineState = *pipelineStateRef;
-	}
+			return pNewPipelineState;
+		});
 
 	auto graphicsPipeline = std::make_shared<GraphicsPipeline>();
 
@@ -1438,54 +1557,27 @@ GraphicsPipelinePtr Device::CreateGraphicsPipelineStream(TPipelineStream& pipeli
 
 
 template <class TPipelineStream>
-MeshletPipelinePtr Device::CreateMeshletPipelineStream(TPipelineStream& pipelineStream, size_t hashCode, const MeshletPipelineDesc& pipelineDesc)
+MeshletPipelinePtr Device::CreateMeshletPipelineStream(TPipelineStream& pipelineStream, const StateObjectKey& key, size_t persistentHash, const MeshletPipelineDesc& pipelineDesc)
 {
-	// Find or create meshlet pipeline state object
-	ID3D12PipelineState** pipelineStateRef = nullptr;
-	bool firstCompile = false;
-	{
-		lock_guard<mutex> lock(m_meshletPipelineStateMutex);
-
-		auto iter = m_meshletPipelineStateHashMap.find(hashCode);
-
-		// Reserve space so the next inquiry will find that someone got here first.
-		if (iter == m_meshletPipelineStateHashMap.end())
-		{
-			pipelineStateRef = m_meshletPipelineStateHashMap[hashCode].addressof();
-			firstCompile = true;
-		}
-		else
+	auto pPipelineState = m_meshletPipelineStateCache.FindOrCreate(key, [&]
 		{
-			pipelineStateRef = iter->second.addressof();
-		}
-	}
-
-	ID3D12PipelineState* pPipelineState = nullptr;
-
-	if (firstCompile)
-	{
-		wil::com_ptr<ID3DBlob> pOutBlob, pErrorBlob;
+			D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {};
+			pipelineStateStreamDesc.pPipelineStateSubobjectStream = &pipelineStream;
+			pipelineStateStreamDesc.SizeInBytes = sizeof(pipelineStream);
 
-		D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {};
-		pipelineStateStreamDesc.pPipelineStateSubobjectStream = &pipelineStream;
-		pipelineStateStreamDesc.SizeInBytes = sizeof(pipelineStream);
+			wil::com_ptr<ID3D12PipelineState> pNewPipelineState;
+			if (!LoadCachedPipeline(persistentHash, pipelineStateStreamDesc, &pNewPipelineState))
+			{
+				HRESULT res = m_device2->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pNewPipelineState));
+				ThrowIfFailed(res);
 
-		HRESULT res = m_device2->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pPipelineState));
-		ThrowIfFailed(res);
+				StoreCachedPipeline(persistentHash, pNewPipelineState.get());
+			}
 
-		SetDebugName(pPipelineState, pipelineDesc.name);
+			SetDebugName(pNewPipelineState.get(), pipelineDesc.name);
 
-		m_meshletPipelineStateHashMap[hashCode].attach(pPipelineState);
-		assert(*pipelineStateRef == pPipelineState);
-	}
-	else
-	{
-		while (pipelineStateRef == nullptr)
-		{
-			this_thread::yield();
-		}
-		pPipelineState = *pipelineStateRef;
-	}
+			return pNewPipelineState;
+		});
 
 	auto meshletPipeline = std::make_shared<MeshletPipeline>();
 
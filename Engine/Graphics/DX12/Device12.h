@@ -12,6 +12,7 @@
 
 #include "Graphics\Device.h"
 #include "Graphics\DeviceCaps.h"
+#include "Graphics\StateObjectCache.h"
 #include "Graphics\DX12\DirectXCommon.h"
 #include "Graphics\DX12\Descriptor12.h"
 #include "Graphics\DX12\DescriptorAllocator12.h"
@@ -51,6 +52,8 @@ public:
 	ComputePipelinePtr CreateComputePipeline(const ComputePipelineDesc& pipelineDesc) override;
 	MeshletPipelinePtr CreateMeshletPipeline(const MeshletPipelineDesc& pipelineDesc) override;
 
+	PipelineCacheStats GetPipelineCacheStats() const override;
+
 	QueryHeapPtr CreateQueryHeap(const QueryHeapDesc& queryHeapDesc) override;
 
 	DescriptorSetPtr CreateDescriptorSet(const DescriptorSetDesc& descriptorSetDesc);
@@ -71,20 +74,34 @@ public:
 	// Caps
 	void FillCaps(const AdapterInfo& adapterInfo);
 
-	// CPU descriptors
+	// Persistent pipeline cache, loaded after the caps are filled in and saved before shutdown
+	void LoadPipelineCache();
+	void SavePipelineCache();
+
+	// CPU descriptors.  Freed handles are recycled once the graphics queue passes the fence they were freed on.
 	DescriptorHandle2 AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE heapType);
 	void FreeDescriptorHandle(const DescriptorHandle2& handle);
 	D3D12_CPU_DESCRIPTOR_HANDLE GetDescriptorHandleCPU(const DescriptorHandle2 handle);
+	void ReclaimDescriptors(uint64_t completedFenceValue);
+	DescriptorSlotStats GetDescriptorStats(D3D12_DESCRIPTOR_HEAP_TYPE heapType) const;
+	void LogDescriptorStats() const;
+
+	// Root signature, pipeline state and sampler caches
+	void LogStateObjectCacheStats() const;
 
 protected:
 	wil::com_ptr<D3D12MA::Allocation> AllocateBuffer(const GpuBufferDesc& gpuBufferDesc) const;
 	TexturePtr CreateTextureSimple(TextureDimension dimension, const TextureDesc& textureDesc);
 
 	template <class TPipelineStream>
-	GraphicsPipelinePtr CreateGraphicsPipelineStream(TPipelineStream& pipelineStream, size_t hashCode, const GraphicsPipelineDesc& pipelineDesc);
+	GraphicsPipelinePtr CreateGraphicsPipelineStream(TPipelineStream& pipelineStream, const StateObjectKey& key, size_t persistentHash, const GraphicsPipelineDesc& pipelineDesc);
 
 	template <class TPipelineStream>
-	MeshletPipelinePtr CreateMeshletPipelineStream(TPipelineStream& pipelineStream, size_t hashCode, const MeshletPipelineDesc& pipelineDesc);
+	MeshletPipelinePtr CreateMeshletPipelineStream(TPipelineStream& pipelineStream, const StateObjectKey& key, size_t persistentHash, const MeshletPipelineDesc& pipelineDesc);
+
+	bool LoadCachedPipeline(size_t persistentHash, const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc, ID3D12PipelineState** ppPipelineState);
+	bool LoadCachedPipeline(size_t persistentHash, const D3D12_COMPUTE_PIPELINE_STATE_DESC& computeDesc, ID3D12PipelineState** ppPipelineState);
+	void StoreCachedPipeline(size_t persistentHash, ID3D12PipelineState* pPipelineState);
 
 protected:
 	wil::com_ptr<ID3D12Device> m_device;
@@ -95,30 +112,25 @@ protected:
 	DeviceCaps m_caps{};
 
 	// CPU descriptors
-	std::array<std::mutex, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> m_freeDescriptorMutexes;
-	std::mutex m_descriptorHeapLock;
-	std::vector<std::vector<DescriptorHandle2>> m_freeDescriptors;
-	std::vector<DescriptorHeapDesc> m_descriptorHeaps;
-
-	// Root signature cache
-	std::mutex m_rootSignatureMutex;
-	std::map<size_t, wil::com_ptr<ID3D12RootSignature>> m_rootSignatureHashMap;
-
-	// Graphics pipeline state cache
-	std::mutex m_graphicsPipelineStateMutex;
-	std::map<size_t, wil::com_ptr<ID3D12PipelineState>> m_graphicsPipelineStateHashMap;
-
-	// Compute pipeline state cache
-	std::mutex m_computePipelineStateMutex;
-	std::map<size_t, wil::com_ptr<ID3D12PipelineState>> m_computePipelineStateHashMap;
-
-	// Meshlet pipeline state cache
-	std::mutex m_meshletPipelineStateMutex;
-	std::map<size_t, wil::com_ptr<ID3D12PipelineState>> m_meshletPipelineStateHashMap;
-
-	// Sampler state cache
-	std::mutex m_samplerMutex;
-	std::map<size_t, std::shared_ptr<Sampler>> m_samplerMap;
+	std::array<std::unique_ptr<DescriptorAllocator>, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> m_descriptorAllocators;
+
+	// State object caches
+	StateObjectCache<wil::com_ptr<ID3D12RootSignature>> m_rootSignatureCache;
+	StateObjectCache<wil::com_ptr<ID3D12PipelineState>> m_graphicsPipelineStateCache;
+	StateObjectCache<wil::com_ptr<ID3D12PipelineState>> m_computePipelineStateCache;
+	StateObjectCache<wil::com_ptr<ID3D12PipelineState>> m_meshletPipelineStateCache;
+	StateObjectCache<std::shared_ptr<Sampler>> m_samplerCache;
+
+	// Persistent pipeline cache.  The library reads from m_pipelineLibraryData, which must outlive it.
+	std::mutex m_pipelineLibraryMutex;
+	std::vector<std::byte> m_pipelineLibraryData;
+	wil::com_ptr<ID3D12PipelineLibrary1> m_pipelineLibrary;
+	PipelineCacheIdentity m_pipelineCacheIdentity{};
+	bool m_pipelineLibraryDirty{ false };
+	std::atomic<uint32_t> m_pipelineCacheHits{ 0 };
+	std::atomic<uint32_t> m_pipelineCacheMisses{ 0 };
+	uint64_t m_pipelineCacheBytesLoaded{ 0 };
+	uint64_t m_pipelineCacheBytesSaved{ 0 };
 };
 
 
@@ -241,6 +241,7 @@ DeviceRLDOHelper::~DeviceRLDOHelper()
 DeviceManager::DeviceManager(const DeviceManagerDesc& desc)
 	: m_desc{ desc }
 	, m_deviceRLDOHelper{ desc.enableValidation }
+	, m_contextPool{ [](CommandListType type) -> ICommandContext* { return new CommandContext12(type); } }
 {
 	m_bIsDeveloperModeEnabled = IsDeveloperModeEnabled();
 	m_bIsRenderDocAvailable = IsRenderDocAvailable();
@@ -249,6 +250,8 @@ DeviceManager::DeviceManager(const DeviceManagerDesc& desc)
 	m_fenceValues[1] = 0;
 	m_fenceValues[2] = 0;
 
+	DynamicDescriptorHeap::EnableTableCache(desc.enableDescriptorTableCache);
+
 	extern Luna::IDeviceManager* g_deviceManager;
 	assert(!g_deviceManager);
 
@@ -259,11 +262,39 @@ DeviceManager::DeviceManager(const DeviceManagerDesc& desc)
 
 DeviceManager::~DeviceManager()
 {
+	// Streaming textures record their uploads, so let them finish first
+	if (m_textureManager)
+	{
+		m_textureManager->WaitForAsyncLoads();
+	}
+
+	if (m_uploadQueue)
+	{
+		m_uploadQueue->Flush();
+	}
+
 	WaitForGpu();
 
-	// Flush pending deferred resources here
+	// Release the resources still referenced by in-flight upload batches
+	m_uploadQueue.reset();
+
+	// The GPU is idle, so everything still pending can go, whatever fence it was waiting on
 	ReleaseDeferredResources();
-	assert(m_deferredResources.empty());
+	m_deferredReleaseQueue.RetireAll();
+	assert(m_deferredReleaseQueue.IsEmpty());
+
+	const DeferredReleaseStats releaseStats = m_deferredReleaseQueue.GetStats();
+	LogInfo(LogDirectX) << format("Deferred release: {} objects released, at most {} pending at once",
+		releaseStats.numReleasedObjects, releaseStats.maxPendingObjects) << endl;
+
+	if (m_device)
+	{
+		m_device->SavePipelineCache();
+		m_device->LogDescriptorStats();
+		m_device->LogStateObjectCacheStats();
+	}
+
+	DynamicDescriptorHeap::LogTableCacheStats();
 
 	Shader::DestroyAll();
 	g_userDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].Destroy();
@@ -447,6 +478,8 @@ void DeviceManager::CreateWindowSizeDependentResources()
 
 	// Release resources tied to swap chain and update fence values
 	m_swapChainBuffers.clear();
+	m_deferredReleaseQueue.RetireAll();
+
 	const uint32_t backBufferCount = m_desc.numSwapChainBuffers;
 
 	// TODO: The window dimensions might have changed externally.  Need to pass those in from somewhere else.
@@ -537,32 +570,7 @@ void DeviceManager::CreateWindowSizeDependentResources()
 
 CommandContext* DeviceManager::AllocateContext(CommandListType commandListType)
 {
-	lock_guard<mutex> lockGuard(m_contextAllocationMutex);
-
-	D3D12_COMMAND_LIST_TYPE d3d12Type = CommandListTypeToDX12(commandListType);
-
-	auto& availableContexts = m_availableContexts[d3d12Type];
-
-	CommandContext* ret{ nullptr };
-	if (availableContexts.empty())
-	{
-		ICommandContext* contextImpl = new CommandContext12(commandListType);
-		ret = new CommandContext(contextImpl);
-
-		m_contextPool[d3d12Type].emplace_back(ret);
-		ret->Initialize();
-	}
-	else
-	{
-		ret = availableContexts.front();
-		availableContexts.pop();
-		ret->Reset();
-	}
-
-	assert(ret != nullptr);
-	assert(ret->GetType() == commandListType);
-
-	return ret;
+	return m_contextPool.Allocate(commandListType);
 }
 
 
@@ -588,10 +596,7 @@ void DeviceManager::CreateNewCommandList(
 
 void DeviceManager::FreeContext(CommandContext* usedContext)
 {
-	assert(usedContext != nullptr);
-	lock_guard<mutex> lockGuard(m_contextAllocationMutex);
-
-	m_availableContexts[(uint32_t)usedContext->GetType()].push(usedContext);
+	m_contextPool.Free(usedContext);
 }
 
 
@@ -661,6 +666,7 @@ void DeviceManager::HandleDeviceLost()
 	}*/
 
 	m_swapChainBuffers.clear();
+	m_deferredReleaseQueue.RetireAll();
 
 	m_queues[(uint32_t)QueueType::Graphics].reset();
 	m_queues[(uint32_t)QueueType::Compute].reset();
@@ -694,23 +700,34 @@ void DeviceManager::HandleDeviceLost()
 
 void DeviceManager::ReleaseResource(ID3D12Resource* resource, D3D12MA::Allocation* allocation)
 {
-	lock_guard lock(m_deferredReleaseMutex);
+	// Nothing can be in flight before the queues exist, and the caller's reference frees the resource right away
+	if (!m_bQueuesCreated)
+	{
+		return;
+	}
 
-	uint64_t nextFence = GetQueue(QueueType::Graphics).GetNextFenceValue();
+	const uint64_t nextFence = GetQueue(QueueType::Graphics).GetNextFenceValue();
 
-	DeferredReleaseResource deferredResource{ nextFence, resource, allocation };
-	m_deferredResources.emplace_back(deferredResource);
+	ReleaseObject(resource, nextFence);
+	ReleaseObject(allocation, nextFence);
 }
 
 
 void DeviceManager::ReleaseAllocation(D3D12MA::Allocation* allocation)
 {
-	lock_guard lock(m_deferredReleaseMutex);
+	if (!m_bQueuesCreated)
+	{
+		return;
+	}
 
-	uint64_t nextFence = GetQueue(QueueType::Graphics).GetNextFenceValue();
+	ReleaseObject(allocation, GetQueue(QueueType::Graphics).GetNextFenceValue());
+}
 
-	DeferredReleaseResource deferredResource{ nextFence, nullptr, allocation };
-	m_deferredResources.emplace_back(deferredResource);
+
+void DeviceManager::ReleaseObject(IUnknown* object, uint64_t fenceValue)
+{
+	// Fence values carry their queue in the top byte
+	m_deferredReleaseQueue.Release((uint32_t)(fenceValue >> 56), fenceValue, object);
 }
 
 
@@ -832,8 +849,10 @@ void DeviceManager::CreateDevice()
 
 	m_device->FillCaps(adapterInfos[chosenAdapterIdx]);
 	m_device->GetDeviceCaps().LogCaps();
+	m_device->LoadPipelineCache();
 
 	m_textureManager = std::make_unique<TextureManager>(m_device.get());
+	m_uploadQueue = std::make_unique<UploadQueue>();
 
 	// TODO: Create descriptor allocators
 }
@@ -1160,24 +1179,22 @@ void DeviceManager::ReleaseSwapChainBuffers()
 	WaitForGpu();
 
 	m_swapChainBuffers.clear();
+
+	// ResizeBuffers fails while anything still references the back buffers
+	m_deferredReleaseQueue.RetireAll();
 }
 
 
 void DeviceManager::ReleaseDeferredResources()
 {
-	lock_guard lock(m_deferredReleaseMutex);
+	for (uint32_t i = 0; i < (uint32_t)QueueType::Count; ++i)
+	{
+		m_deferredReleaseQueue.Retire(i, GetQueue((QueueType)i).GetCompletedFenceValue());
+	}
 
-	auto resourceIt = m_deferredResources.begin();
-	while (resourceIt != m_deferredResources.end())
+	if (m_device)
 	{
-		if (GetQueue(QueueType::Graphics).IsFenceComplete(resourceIt->fenceValue))
-		{
-			resourceIt = m_deferredResources.erase(resourceIt);
-		}
-		else
-		{
-			++resourceIt;
-		}
+		m_device->ReclaimDescriptors(GetQueue(QueueType::Graphics).GetCompletedFenceValue());
 	}
 }
 
@@ -11,8 +11,11 @@
 #pragma once
 
 #include "Graphics\ColorBuffer.h"
+#include "Graphics\CommandContextPool.h"
+#include "Graphics\DeferredReleaseQueue.h"
 #include "Graphics\DeviceManager.h"
 #include "Graphics\Texture.h"
+#include "Graphics\UploadQueue.h"
 #include "Graphics\DX12\DirectXCommon.h"
 
 using namespace Microsoft::WRL;
@@ -61,8 +64,8 @@ public:
 	void Present() final;
 
 	void WaitForGpu() final;
-	void WaitForFence(uint64_t fenceValue);
-	bool IsFenceComplete(uint64_t fenceValue);
+	void WaitForFence(uint64_t fenceValue) final;
+	bool IsFenceComplete(uint64_t fenceValue) final;
 
 	void SetWindowSize(uint32_t width, uint32_t height) final;
 	void CreateDeviceResources() final;
@@ -101,8 +104,11 @@ public:
 
 	void HandleDeviceLost();
 
+	// Deferred release.  Objects are held until the GPU is done with them, which is the next fence on the graphics
+	// queue unless a fence value is given.
 	void ReleaseResource(ID3D12Resource* resource, D3D12MA::Allocation* allocation = nullptr);
 	void ReleaseAllocation(D3D12MA::Allocation* allocation);
+	void ReleaseObject(IUnknown* object, uint64_t fenceValue);
 
 	ID3D12Device* GetD3D12Device() { return m_dxDevice.get(); }
 	D3D12MA::Allocator* GetAllocator() { return m_d3d12maAllocator.get(); }
@@ -152,6 +158,9 @@ private:
 	// Texture manager
 	std::unique_ptr<TextureManager> m_textureManager;
 
+	// Batched resource initialization
+	std::unique_ptr<UploadQueue> m_uploadQueue;
+
 	// Swap-chain objects
 	wil::com_ptr<IDXGISwapChain3> m_dxSwapChain;
 	std::vector<ColorBufferPtr> m_swapChainBuffers;
@@ -180,19 +189,11 @@ private:
 	uint64_t m_timestampFrequency{ 0 };
 
 	// Command context handling
-	std::mutex m_contextAllocationMutex;
-	std::vector<std::unique_ptr<CommandContext>> m_contextPool[4];
-	std::queue<CommandContext*> m_availableContexts[4];
-
-	// Deferred resource release
-	std::mutex m_deferredReleaseMutex;
-	struct DeferredReleaseResource
-	{
-		uint64_t fenceValue;
-		wil::com_ptr<ID3D12Resource> resource;
-		wil::com_ptr<D3D12MA::Allocation> allocation;
-	};
-	std::list<DeferredReleaseResource> m_deferredResources;
+	CommandContextPool m_contextPool;
+
+	// Deferred resource release, one ring of fence buckets per queue.  Declared after the allocator, so pending
+	// allocations are released before it is.
+	DeferredReleaseQueue m_deferredReleaseQueue{ (uint32_t)QueueType::Count };
 
 	// Indirect command signatures
 	wil::com_ptr<ID3D12CommandSignature> m_drawIndirectSignature;
@@ -28,6 +28,8 @@ mutex DynamicDescriptorHeap::sm_mutex;
 vector<wil::com_ptr<ID3D12DescriptorHeap>> DynamicDescriptorHeap::sm_descriptorHeapPool[2];
 queue<pair<uint64_t, ID3D12DescriptorHeap*>> DynamicDescriptorHeap::sm_retiredDescriptorHeaps[2];
 queue<ID3D12DescriptorHeap*> DynamicDescriptorHeap::sm_availableDescriptorHeaps[2];
+bool DynamicDescriptorHeap::sm_enableTableCache{ true };
+DescriptorTableCacheStats DynamicDescriptorHeap::sm_tableCacheStats[2];
 
 
 DynamicDescriptorHeap::DynamicDescriptorHeap(CommandContext12& owningContext, D3D12_DESCRIPTOR_HEAP_TYPE heapType)
@@ -37,6 +39,11 @@ DynamicDescriptorHeap::DynamicDescriptorHeap(CommandContext12& owningContext, D3
 	m_currentHeapPtr = nullptr;
 	m_currentOffset = 0;
 	m_descriptorSize = GetDescriptorHandleIncrementSize(heapType);
+
+	if (sm_enableTableCache)
+	{
+		m_tableCache = make_unique<DescriptorTableHashCache>();
+	}
 }
 
 
@@ -46,6 +53,47 @@ void DynamicDescriptorHeap::CleanupUsedHeaps(uint64_t fenceValue)
 	RetireUsedHeaps(fenceValue);
 	m_graphicsHandleCache.ClearCache();
 	m_computeHandleCache.ClearCache();
+
+	if (m_tableCache)
+	{
+		const uint32_t idx = m_descriptorType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER ? 1 : 0;
+
+		lock_guard<mutex> CS(sm_mutex);
+		sm_tableCacheStats[idx] += m_tableCache->TakeStats();
+	}
+}
+
+
+/* static */ DescriptorTableCacheStats DynamicDescriptorHeap::GetTableCacheStats()
+{
+	lock_guard<mutex> CS(sm_mutex);
+
+	DescriptorTableCacheStats stats = sm_tableCacheStats[0];
+	stats += sm_tableCacheStats[1];
+	return stats;
+}
+
+
+/* static */ void DynamicDescriptorHeap::LogTableCacheStats()
+{
+	lock_guard<mutex> CS(sm_mutex);
+
+	for (uint32_t idx = 0; idx < 2; ++idx)
+	{
+		const DescriptorTableCacheStats& stats = sm_tableCacheStats[idx];
+		if (stats.numLookups == 0)
+		{
+			continue;
+		}
+
+		LogInfo(LogDirectX) << format("{} descriptor tables: {:.1f}% of {} rebound from the table cache, {} inserts ({} dropped), {} resets",
+			D3DTypeToString(idx == 1 ? D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER : D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
+			100.0f * stats.GetHitRate(),
+			stats.numLookups,
+			stats.numInserts,
+			stats.numDroppedInserts,
+			stats.numResets) << endl;
+	}
 }
 
 
@@ -130,6 +178,12 @@ void DynamicDescriptorHeap::RetireCurrentHeap()
 	m_retiredHeaps.push_back(m_currentHeapPtr);
 	m_currentHeapPtr = nullptr;
 	m_currentOffset = 0;
+
+	// Cached tables point into the retired heap
+	if (m_tableCache)
+	{
+		m_tableCache->Reset();
+	}
 }
 
 
@@ -158,17 +212,19 @@ inline ID3D12DescriptorHeap* DynamicDescriptorHeap::GetHeapPointer()
 void DynamicDescriptorHeap::CopyAndBindStagedTables(DynamicDescriptorHeap::DescriptorHandleCache& handleCache, ID3D12GraphicsCommandList* cmdList,
 	void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE))
 {
-	uint32_t neededSize = handleCache.ComputeStagedSize();
+	const uint32_t neededSize = handleCache.ComputeStagedSize();
 	if (!HasSpace(neededSize))
 	{
 		RetireCurrentHeap();
 		UnbindAllValid();
-		neededSize = handleCache.ComputeStagedSize();
 	}
 
 	// This can trigger the creation of a new heap
 	m_owningContext.SetDescriptorHeap(m_descriptorType, GetHeapPointer());
-	handleCache.CopyAndBindStaleTables(m_descriptorType, m_descriptorSize, Allocate(neededSize), cmdList, SetFunc);
+
+	// Tables found in the table cache are rebound where they already are, so only the rest take up heap space
+	DescriptorHandle destHandleStart = m_firstDescriptor + m_currentOffset * m_descriptorSize;
+	m_currentOffset += handleCache.CopyAndBindStaleTables(m_descriptorType, m_descriptorSize, destHandleStart, m_tableCache.get(), cmdList, SetFunc);
 }
 
 
@@ -199,9 +255,9 @@ uint32_t DynamicDescriptorHeap::DescriptorHandleCache::ComputeStagedSize()
 }
 
 
-void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
+uint32_t DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
 	D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t descriptorSize,
-	DescriptorHandle destHandleStart, ID3D12GraphicsCommandList* cmdList,
+	DescriptorHandle destHandleStart, DescriptorTableHashCache* tableCache, ID3D12GraphicsCommandList* cmdList,
 	void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE))
 {
 	uint32_t staleParamCount = 0;
@@ -243,13 +299,40 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
 
 	auto device = GetD3D12Device();
 
+	uint32_t numCopiedDescriptors = 0;
+
 	for (uint32_t i = 0; i < staleParamCount; ++i)
 	{
 		rootIndex = rootIndices[i];
-		(cmdList->*SetFunc)(rootIndex, destHandleStart.GetGpuHandle());
 
 		DescriptorTableCache& rootDescTable = m_rootDescriptorTable[rootIndex];
 
+		if (tableCache != nullptr)
+		{
+			// Key on the handles that are set.  The unset entries are never read by the shader, so whatever a
+			// cached copy holds there doesn't matter.
+			uint64_t keyHandles[kMaxNumDescriptors];
+			for (uint32_t j = 0; j < tableSize[i]; ++j)
+			{
+				keyHandles[j] = (rootDescTable.assignedHandlesBitMap & (1 << j)) ? rootDescTable.tableStart[j].ptr : 0;
+			}
+
+			const span<const uint32_t> key{ (const uint32_t*)keyHandles, tableSize[i] * 2 };
+			const size_t hash = DescriptorTableHashCache::HashKey(key);
+
+			uint64_t cachedGpuPtr{ 0 };
+			if (tableCache->Find(hash, key, cachedGpuPtr))
+			{
+				(cmdList->*SetFunc)(rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE{ cachedGpuPtr });
+				continue;
+			}
+
+			tableCache->Insert(hash, key, destHandleStart.GetGpuHandle().ptr);
+		}
+
+		(cmdList->*SetFunc)(rootIndex, destHandleStart.GetGpuHandle());
+		numCopiedDescriptors += tableSize[i];
+
 		D3D12_CPU_DESCRIPTOR_HANDLE* srcHandles = rootDescTable.tableStart;
 		uint64_t setHandles = (uint64_t)rootDescTable.assignedHandlesBitMap;
 		D3D12_CPU_DESCRIPTOR_HANDLE curDest = destHandleStart.GetCpuHandle();
@@ -298,10 +381,15 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
 		}
 	}
 
-	device->GetD3D12Device()->CopyDescriptors(
-		numDestDescriptorRanges, destDescriptorRangeStarts, destDescriptorRangeSizes,
-		numSrcDescriptorRanges, srcDescriptorRangeStarts, srcDescriptorRangeSizes,
-		type);
+	if (numDestDescriptorRanges > 0)
+	{
+		device->GetD3D12Device()->CopyDescriptors(
+			numDestDescriptorRanges, destDescriptorRangeStarts, destDescriptorRangeSizes,
+			numSrcDescriptorRanges, srcDescriptorRangeStarts, srcDescriptorRangeSizes,
+			type);
+	}
+
+	return numCopiedDescriptors;
 }
 
 
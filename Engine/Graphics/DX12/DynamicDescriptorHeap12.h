@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "Graphics\DescriptorTableHashCache.h"
 #include "Graphics\DX12\DescriptorAllocator12.h"
 #include "Graphics\DX12\DirectXCommon.h"
 
@@ -34,6 +35,11 @@ public:
 		sm_descriptorHeapPool[1].clear();
 	}
 
+	// Rebind identical descriptor tables instead of copying them again.  Takes effect for heaps created afterwards.
+	static void EnableTableCache(bool enable) { sm_enableTableCache = enable; }
+	static DescriptorTableCacheStats GetTableCacheStats();
+	static void LogTableCacheStats();
+
 	void CleanupUsedHeaps(uint64_t fenceValue);
 
 	// Copy multiple handles into the cache area reserved for the specified root parameter.
@@ -92,13 +98,6 @@ private:
 	void RetireUsedHeaps(uint64_t fenceValue);
 	ID3D12DescriptorHeap* GetHeapPointer();
 
-	DescriptorHandle Allocate(uint32_t count)
-	{
-		DescriptorHandle ret = m_firstDescriptor + m_currentOffset * m_descriptorSize;
-		m_currentOffset += count;
-		return ret;
-	}
-
 	struct DescriptorHandleCache;
 
 	void CopyAndBindStagedTables(DescriptorHandleCache& handleCache, ID3D12GraphicsCommandList* cmdList,
@@ -114,6 +113,8 @@ private:
 	static std::vector<wil::com_ptr<ID3D12DescriptorHeap>> sm_descriptorHeapPool[2];
 	static std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> sm_retiredDescriptorHeaps[2];
 	static std::queue<ID3D12DescriptorHeap*> sm_availableDescriptorHeaps[2];
+	static bool sm_enableTableCache;
+	static DescriptorTableCacheStats sm_tableCacheStats[2];
 
 	// Non-static members
 	CommandContext12& m_owningContext;
@@ -124,6 +125,9 @@ private:
 	DescriptorHandle m_firstDescriptor;
 	std::vector<ID3D12DescriptorHeap*> m_retiredHeaps;
 
+	// Tables already copied into the current heap, keyed by their CPU handles
+	std::unique_ptr<DescriptorTableHashCache> m_tableCache;
+
 	// Describes a descriptor table entry:  a region of the handle cache and which handles have been set
 	struct DescriptorTableCache
 	{
@@ -153,7 +157,11 @@ private:
 		static const uint32_t kMaxNumDescriptorTables = 16;
 
 		uint32_t ComputeStagedSize();
-		void CopyAndBindStaleTables(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t descriptorSize, DescriptorHandle destHandleStart, ID3D12GraphicsCommandList* cmdList,
+
+		// Returns the number of descriptors written at destHandleStart, which is less than the staged size when
+		// tables are found in the table cache
+		uint32_t CopyAndBindStaleTables(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t descriptorSize, DescriptorHandle destHandleStart,
+			DescriptorTableHashCache* tableCache, ID3D12GraphicsCommandList* cmdList,
 			void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE));
 
 		DescriptorTableCache m_rootDescriptorTable[kMaxNumDescriptorTables];
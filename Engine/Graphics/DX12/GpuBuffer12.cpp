@@ -12,6 +12,8 @@
 
 #include "GpuBuffer12.h"
 
+#include "DeviceManager12.h"
+
 
 namespace Luna::DX12
 {
@@ -29,6 +31,16 @@ GpuBuffer::GpuBuffer(Device* device)
 }
 
 
+GpuBuffer::~GpuBuffer()
+{
+	// The allocation owns the buffer, so deferring it defers both
+	if (auto deviceManager = GetD3D12DeviceManager())
+	{
+		deviceManager->ReleaseAllocation(m_allocation.get());
+	}
+}
+
+
 void GpuBuffer::Update(size_t sizeInBytes, const void* data)
 {
 	Update(sizeInBytes, 0, data);
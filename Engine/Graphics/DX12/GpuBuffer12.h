@@ -28,6 +28,7 @@ class GpuBuffer : public IGpuBuffer
 
 public:
 	explicit GpuBuffer(Device* device);
+	~GpuBuffer() override;
 
 	void Update(size_t sizeInBytes, const void* data) override;
 	void Update(size_t sizeInBytes, size_t offset, const void* data) override;
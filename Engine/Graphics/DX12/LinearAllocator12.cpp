@@ -78,20 +78,14 @@ void LinearAllocatorPageManager::DiscardPages(uint64_t fenceValue, const vector<
 
 void LinearAllocatorPageManager::FreeLargePages(uint64_t fenceValue, const vector<LinearAllocationPage*>& largePages)
 {
-	lock_guard<mutex> lockGuard(m_mutex);
-
 	DeviceManager* deviceManager = GetD3D12DeviceManager();
 
-	while (!m_deletionQueue.empty() && deviceManager->IsFenceComplete(m_deletionQueue.front().first))
-	{
-		delete m_deletionQueue.front().second;
-		m_deletionQueue.pop();
-	}
-
+	// The page itself can go now.  Its resource waits in the device manager's deferred release queue.
 	for (auto iter = largePages.begin(); iter != largePages.end(); ++iter)
 	{
 		(*iter)->Unmap();
-		m_deletionQueue.push(make_pair(fenceValue, *iter));
+		deviceManager->ReleaseObject((*iter)->GetResource(), fenceValue);
+		delete *iter;
 	}
 }
 
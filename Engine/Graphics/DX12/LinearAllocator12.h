@@ -100,8 +100,8 @@ public:
 	// Discarded pages will get recycled.  This is for fixed size pages.
 	void DiscardPages(uint64_t fenceID, const std::vector<LinearAllocationPage*>& pages);
 
-	// Freed pages will be destroyed once their fence has passed.  This is for single-use,
-	// "large" pages.
+	// Freed pages will be destroyed once their fence has passed, through the device manager's
+	// deferred release queue.  This is for single-use, "large" pages.
 	void FreeLargePages(uint64_t fenceID, const std::vector<LinearAllocationPage*>& pages);
 
 	void Destroy() { m_pagePool.clear(); }
@@ -112,7 +112,6 @@ private:
 	LinearAllocatorType m_allocationType;
 	std::vector<std::unique_ptr<LinearAllocationPage>> m_pagePool;
 	std::queue<std::pair<uint64_t, LinearAllocationPage*>> m_retiredPages;
-	std::queue<std::pair<uint64_t, LinearAllocationPage*>> m_deletionQueue;
 	std::queue<LinearAllocationPage*> m_availablePages;
 	std::mutex m_mutex;
 };
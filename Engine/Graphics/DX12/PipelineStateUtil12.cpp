@@ -27,6 +27,103 @@ inline bool IsDepthBiasEnabled(const D3D12_RASTERIZER_DESC& desc)
 }
 
 
+size_t HashShaderBytecode(const D3D12_SHADER_BYTECODE& byteCode, size_t hash)
+{
+	if (byteCode.pShaderBytecode == nullptr)
+	{
+		return hash;
+	}
+
+	// DXIL and DXBC containers are a whole number of dwords
+	const uint32_t* begin = (const uint32_t*)byteCode.pShaderBytecode;
+	hash = Utility::HashState(&byteCode.BytecodeLength, 1, hash);
+	return Utility::HashRange(begin, begin + byteCode.BytecodeLength / sizeof(uint32_t), hash);
+}
+
+
+// The cache keys identify the shaders and root signature by address, so they only identify a pipeline within
+// one run.  These hash what each pointer points to instead, except for the root signature, which the pipeline
+// library checks itself when a pipeline is loaded.
+size_t ComputePersistentHash(const GraphicsPipelineContext& context)
+{
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC stateDesc = context.stateDesc;
+	stateDesc.pRootSignature = nullptr;
+	stateDesc.VS = D3D12_SHADER_BYTECODE{};
+	stateDesc.PS = D3D12_SHADER_BYTECODE{};
+	stateDesc.DS = D3D12_SHADER_BYTECODE{};
+	stateDesc.HS = D3D12_SHADER_BYTECODE{};
+	stateDesc.GS = D3D12_SHADER_BYTECODE{};
+	stateDesc.StreamOutput = D3D12_STREAM_OUTPUT_DESC{};
+	stateDesc.InputLayout.pInputElementDescs = nullptr;
+	stateDesc.CachedPSO = D3D12_CACHED_PIPELINE_STATE{};
+
+	size_t hash = Utility::HashState(&stateDesc);
+	hash = HashShaderBytecode(context.stateDesc.VS, hash);
+	hash = HashShaderBytecode(context.stateDesc.PS, hash);
+	hash = HashShaderBytecode(context.stateDesc.DS, hash);
+	hash = HashShaderBytecode(context.stateDesc.HS, hash);
+	hash = HashShaderBytecode(context.stateDesc.GS, hash);
+
+	for (uint32_t i = 0; i < context.stateDesc.InputLayout.NumElements; ++i)
+	{
+		D3D12_INPUT_ELEMENT_DESC element = context.inputElements.get()[i];
+		const string_view semanticName = element.SemanticName ? element.SemanticName : "";
+		element.SemanticName = nullptr;
+
+		hash = Utility::HashState(&element, 1, hash);
+		hash = Utility::HashMerge(hash, std::hash<string_view>{}(semanticName));
+	}
+
+	return hash;
+}
+
+
+size_t ComputePersistentHash(const MeshletPipelineContext& context)
+{
+	D3DX12_MESH_SHADER_PIPELINE_STATE_DESC stateDesc = context.stateDesc;
+	stateDesc.pRootSignature = nullptr;
+	stateDesc.AS = D3D12_SHADER_BYTECODE{};
+	stateDesc.MS = D3D12_SHADER_BYTECODE{};
+	stateDesc.PS = D3D12_SHADER_BYTECODE{};
+	stateDesc.CachedPSO = D3D12_CACHED_PIPELINE_STATE{};
+
+	size_t hash = Utility::HashState(&stateDesc);
+	hash = HashShaderBytecode(context.stateDesc.AS, hash);
+	hash = HashShaderBytecode(context.stateDesc.MS, hash);
+	hash = HashShaderBytecode(context.stateDesc.PS, hash);
+
+	return hash;
+}
+
+
+// Semantic names are pointers, so they are appended by content
+void AppendInputElements(StateObjectKey& key, const D3D12_INPUT_ELEMENT_DESC* inputElements, uint32_t numElements)
+{
+	key.Append(numElements);
+
+	for (uint32_t i = 0; i < numElements; ++i)
+	{
+		D3D12_INPUT_ELEMENT_DESC element = inputElements[i];
+		const string_view semanticName = element.SemanticName ? element.SemanticName : "";
+		element.SemanticName = nullptr;
+
+		key.Append(element);
+		key.AppendString(semanticName);
+	}
+}
+
+
+// The pipeline streams fill in a few fields that the older descs have no room for:  the float depth bias, the
+// depth bounds test, and the back face stencil masks
+void AppendStreamOnlyState(StateObjectKey& key, const RasterizerStateDesc& rasterizerState, const DepthStencilStateDesc& depthStencilState)
+{
+	key.Append(rasterizerState.depthBias);
+	key.Append(depthStencilState.depthBoundsTestEnable);
+	key.Append(depthStencilState.backFace.stencilReadMask);
+	key.Append(depthStencilState.backFace.stencilWriteMask);
+}
+
+
 void FillBlendDesc(D3D12_BLEND_DESC& blendDesc, const BlendStateDesc& desc)
 {
 	blendDesc.AlphaToCoverageEnable = desc.alphaToCoverageEnable ? TRUE : FALSE;
@@ -281,10 +378,13 @@ void FillGraphicsPipelineDesc(GraphicsPipelineContext& context, const GraphicsPi
 
 	context.stateDesc.InputLayout.pInputElementDescs = nullptr;
 
-	context.hashCode = Utility::HashState(&context.stateDesc);
-	context.hashCode = Utility::HashState(context.inputElements.get(), context.stateDesc.InputLayout.NumElements, context.hashCode);
+	context.key.Append(context.stateDesc);
+	AppendInputElements(context.key, context.inputElements.get(), context.stateDesc.InputLayout.NumElements);
+	AppendStreamOnlyState(context.key, desc.rasterizerState, desc.depthStencilState);
 
 	context.stateDesc.InputLayout.pInputElementDescs = context.inputElements.get();
+
+	context.persistentHash = ComputePersistentHash(context);
 }
 
 
@@ -406,7 +506,10 @@ void FillMeshletPipelineDesc(MeshletPipelineContext& context, const MeshletPipel
 	}
 	assert(context.stateDesc.pRootSignature != nullptr);
 
-	context.hashCode = Utility::HashState(&context.stateDesc);
+	context.key.Append(context.stateDesc);
+	AppendStreamOnlyState(context.key, desc.rasterizerState, desc.depthStencilState);
+
+	context.persistentHash = ComputePersistentHash(context);
 }
 
 
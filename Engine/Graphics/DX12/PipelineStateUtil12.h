@@ -11,6 +11,7 @@
 #pragma once
 
 #include "Graphics\PipelineState.h"
+#include "Graphics\StateObjectCache.h"
 #include "Graphics\DX12\DirectXCommon.h"
 
 namespace Luna::DX12
@@ -20,9 +21,13 @@ struct GraphicsPipelineContext
 {
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC stateDesc{};
 	std::unique_ptr<const D3D12_INPUT_ELEMENT_DESC> inputElements;
-	size_t hashCode{ 0 };
+	StateObjectKey key;
+	size_t persistentHash{ 0 };
 };
 
+// Hashes the shader's bytecode rather than its address, for keys that must match from one run to the next
+size_t HashShaderBytecode(const D3D12_SHADER_BYTECODE& byteCode, size_t hash);
+
 void FillGraphicsPipelineDesc(GraphicsPipelineContext& context, const GraphicsPipelineDesc& desc);
 void FillGraphicsPipelineStateStreamDefault(CD3DX12_PIPELINE_STATE_STREAM& stateStream, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& stateDesc, const GraphicsPipelineDesc& desc);
 void FillGraphicsPipelineStateStream1(CD3DX12_PIPELINE_STATE_STREAM1& stateStream, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& stateDesc, const GraphicsPipelineDesc& desc);
@@ -44,7 +49,8 @@ void FillGraphicsPipelineStateStream5(CD3DX12_PIPELINE_STATE_STREAM5& stateStrea
 struct MeshletPipelineContext
 {
 	D3DX12_MESH_SHADER_PIPELINE_STATE_DESC stateDesc{};
-	size_t hashCode{ 0 };
+	StateObjectKey key;
+	size_t persistentHash{ 0 };
 };
 
 void FillMeshletPipelineDesc(MeshletPipelineContext& context, const MeshletPipelineDesc& desc);
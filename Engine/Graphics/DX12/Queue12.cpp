@@ -51,13 +51,22 @@ Queue::~Queue()
 
 
 uint64_t Queue::ExecuteCommandList(ID3D12CommandList* commandList)
+{
+	return ExecuteCommandLists({ &commandList, 1 });
+}
+
+
+uint64_t Queue::ExecuteCommandLists(span<ID3D12CommandList*> commandLists)
 {
 	lock_guard<mutex> lockGuard(m_fenceMutex);
 
-	assert_succeeded(((ID3D12GraphicsCommandList*)commandList)->Close());
+	for (ID3D12CommandList* commandList : commandLists)
+	{
+		assert_succeeded(((ID3D12GraphicsCommandList*)commandList)->Close());
+	}
 
-	// Kickoff the command list
-	m_dxQueue->ExecuteCommandLists(1, &commandList);
+	// Kickoff the command lists
+	m_dxQueue->ExecuteCommandLists((UINT)commandLists.size(), commandLists.data());
 
 	// Signal the next fence value (with the GPU)
 	m_dxQueue->Signal(m_dxFence.get(), m_nextFenceValue);
@@ -107,6 +116,14 @@ bool Queue::IsFenceComplete(uint64_t fenceValue)
 }
 
 
+uint64_t Queue::GetCompletedFenceValue()
+{
+	m_lastCompletedFenceValue = std::max(m_lastCompletedFenceValue, m_dxFence->GetCompletedValue());
+
+	return m_lastCompletedFenceValue;
+}
+
+
 void Queue::WaitForFence(uint64_t fenceValue)
 {
 	if (IsFenceComplete(fenceValue))
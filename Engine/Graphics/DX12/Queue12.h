@@ -30,12 +30,15 @@ public:
 	ID3D12CommandQueue* GetCommandQueue() noexcept { return m_dxQueue.get(); }
 
 	uint64_t ExecuteCommandList(ID3D12CommandList* commandList);
+	// Closes and executes the command lists in order, signaling a single fence value behind the last one
+	uint64_t ExecuteCommandLists(std::span<ID3D12CommandList*> commandLists);
 	ID3D12CommandAllocator* RequestAllocator();
 	void DiscardAllocator(uint64_t fenceValueForReset, ID3D12CommandAllocator* allocator);
 
 	uint64_t IncrementFence();
 	uint64_t GetLastSubmittedFenceValue() const noexcept { return m_lastSubmittedFenceValue; }
 	uint64_t GetNextFenceValue() const noexcept { return m_nextFenceValue; }
+	uint64_t GetCompletedFenceValue();
 	bool IsFenceComplete(uint64_t fenceValue);
 	void WaitForFence(uint64_t fenceValue);
 	void WaitForGpu()
@@ -12,6 +12,8 @@
 
 #include "Texture12.h"
 
+#include "DeviceManager12.h"
+
 namespace Luna::DX12
 {
 
@@ -20,4 +22,14 @@ Texture::Texture(Device* device)
 	m_srvDescriptor.SetDevice(device);
 }
 
+
+Texture::~Texture()
+{
+	// The GPU may still be using the resource, so the device manager holds on to it until the current fence passes
+	if (auto deviceManager = GetD3D12DeviceManager())
+	{
+		deviceManager->ReleaseResource(m_resource.get());
+	}
+}
+
 } // namespace Luna::DX12
\ No newline at end of file
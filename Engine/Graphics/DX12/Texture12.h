@@ -28,6 +28,7 @@ class Texture : public ITexture
 
 public:
 	explicit Texture(Device* device);
+	~Texture() override;
 
 	bool IsValid() const noexcept override { return m_resource != nullptr; }
 
@@ -0,0 +1,188 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "DeferredReleaseQueue.h"
+
+using namespace std;
+
+
+namespace
+{
+
+const uint32_t s_initialBucketCount{ 8 };
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+DeferredReleaseQueue::DeferredReleaseQueue(uint32_t numQueues)
+	: m_numQueues{ numQueues }
+	, m_rings{ make_unique<Ring[]>(numQueues) }
+{
+	assert(numQueues > 0);
+}
+
+
+DeferredReleaseQueue::~DeferredReleaseQueue()
+{
+	RetireAll();
+}
+
+
+void DeferredReleaseQueue::Release(uint32_t queueIndex, uint64_t fenceValue, IUnknown* object)
+{
+	assert(queueIndex < m_numQueues);
+
+	if (object == nullptr)
+	{
+		return;
+	}
+
+	Ring& ring = m_rings[queueIndex];
+
+	{
+		lock_guard<mutex> lock(ring.mutex);
+
+		// Fence values only grow, so a new value opens a bucket at the tail.  An older value, such as a page retired
+		// against a fence that was signaled a while ago, joins the newest bucket, which just holds it a little longer.
+		Bucket* bucket = ring.count > 0 ? &GetBucket(ring, ring.count - 1) : nullptr;
+		if (bucket == nullptr || fenceValue > bucket->fenceValue)
+		{
+			if (ring.count == ring.buckets.size())
+			{
+				Grow(ring);
+			}
+
+			bucket = &GetBucket(ring, ring.count);
+			bucket->fenceValue = fenceValue;
+			++ring.count;
+		}
+
+		bucket->objects.emplace_back(object);
+	}
+
+	const uint64_t numPending = ++m_numPendingObjects;
+
+	uint64_t maxPending = m_maxPendingObjects.load(memory_order_relaxed);
+	while (numPending > maxPending && !m_maxPendingObjects.compare_exchange_weak(maxPending, numPending, memory_order_relaxed))
+	{
+	}
+}
+
+
+size_t DeferredReleaseQueue::Retire(uint32_t queueIndex, uint64_t completedFenceValue)
+{
+	assert(queueIndex < m_numQueues);
+
+	Ring& ring = m_rings[queueIndex];
+
+	vector<wil::com_ptr<IUnknown>> retiredObjects;
+
+	{
+		lock_guard<mutex> lock(ring.mutex);
+
+		// Buckets are in fence order, so stop at the first one still in flight
+		while (ring.count > 0)
+		{
+			Bucket& bucket = GetBucket(ring, 0);
+			if (bucket.fenceValue > completedFenceValue)
+			{
+				break;
+			}
+
+			retiredObjects.insert(retiredObjects.end(), make_move_iterator(bucket.objects.begin()), make_move_iterator(bucket.objects.end()));
+			bucket.objects.clear();
+
+			ring.head = (ring.head + 1) & ((uint32_t)ring.buckets.size() - 1);
+			--ring.count;
+		}
+	}
+
+	const size_t numRetired = retiredObjects.size();
+	retiredObjects.clear();
+
+	if (numRetired > 0)
+	{
+		m_numPendingObjects -= numRetired;
+		m_numReleasedObjects += numRetired;
+	}
+
+	return numRetired;
+}
+
+
+size_t DeferredReleaseQueue::RetireAll()
+{
+	size_t numRetired{ 0 };
+
+	for (uint32_t i = 0; i < m_numQueues; ++i)
+	{
+		numRetired += Retire(i, numeric_limits<uint64_t>::max());
+	}
+
+	return numRetired;
+}
+
+
+bool DeferredReleaseQueue::IsEmpty() const
+{
+	return m_numPendingObjects == 0;
+}
+
+
+DeferredReleaseStats DeferredReleaseQueue::GetStats() const
+{
+	uint32_t numPendingBuckets{ 0 };
+
+	for (uint32_t i = 0; i < m_numQueues; ++i)
+	{
+		lock_guard<mutex> lock(m_rings[i].mutex);
+
+		numPendingBuckets += m_rings[i].count;
+	}
+
+	return DeferredReleaseStats{
+		.numPendingObjects	= m_numPendingObjects,
+		.numReleasedObjects	= m_numReleasedObjects,
+		.maxPendingObjects	= m_maxPendingObjects,
+		.numPendingBuckets	= numPendingBuckets
+	};
+}
+
+
+DeferredReleaseQueue::Bucket& DeferredReleaseQueue::GetBucket(Ring& ring, uint32_t index) const noexcept
+{
+	assert(!ring.buckets.empty());
+
+	return ring.buckets[(ring.head + index) & ((uint32_t)ring.buckets.size() - 1)];
+}
+
+
+void DeferredReleaseQueue::Grow(Ring& ring)
+{
+	const uint32_t oldSize = (uint32_t)ring.buckets.size();
+	const uint32_t newSize = oldSize > 0 ? oldSize * 2 : s_initialBucketCount;
+
+	// Unwrap the ring so the oldest bucket lands at index 0
+	vector<Bucket> buckets(newSize);
+	for (uint32_t i = 0; i < oldSize; ++i)
+	{
+		buckets[i] = move(GetBucket(ring, i));
+	}
+
+	ring.buckets = move(buckets);
+	ring.head = 0;
+}
+
+} // namespace Luna
@@ -0,0 +1,79 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+
+namespace Luna
+{
+
+struct DeferredReleaseStats
+{
+	uint64_t numPendingObjects{ 0 };	// Waiting on a fence
+	uint64_t numReleasedObjects{ 0 };
+	uint64_t maxPendingObjects{ 0 };
+	uint32_t numPendingBuckets{ 0 };
+};
+
+
+// Keeps GPU objects alive until the queue that may still be using them passes a fence value, with no graphics API
+// behind it.  Objects are reference counted through IUnknown, which covers ID3D12Resource, D3D12MA::Allocation and
+// the Vulkan wrappers, so the queue just holds a reference.  Each queue has a ring of buckets, one per fence value
+// in the order they were handed out.  Release() appends to the newest bucket, and Retire() drops whole buckets at
+// once, stopping at the first fence still in flight.
+class DeferredReleaseQueue : public NonCopyable
+{
+public:
+	explicit DeferredReleaseQueue(uint32_t numQueues);
+	~DeferredReleaseQueue();
+
+	// The reference is dropped once Retire() sees a completed fence value at or past fenceValue on the same queue.
+	// Safe to call from any thread.  Null objects are ignored.
+	void Release(uint32_t queueIndex, uint64_t fenceValue, IUnknown* object);
+
+	// Returns the number of objects released.  The references are dropped outside the lock, so objects that
+	// release others from their destructors can call back into the queue.
+	size_t Retire(uint32_t queueIndex, uint64_t completedFenceValue);
+
+	// Ignores the fences, so only call this once the GPU is idle and nothing is recording
+	size_t RetireAll();
+
+	bool IsEmpty() const;
+	DeferredReleaseStats GetStats() const;
+
+private:
+	struct Bucket
+	{
+		uint64_t fenceValue{ 0 };
+		std::vector<wil::com_ptr<IUnknown>> objects;	// Keeps its capacity when the bucket is reused
+	};
+
+	struct Ring
+	{
+		mutable std::mutex mutex;
+		std::vector<Bucket> buckets;	// Power-of-two size, oldest fence at head
+		uint32_t head{ 0 };
+		uint32_t count{ 0 };
+	};
+
+	Bucket& GetBucket(Ring& ring, uint32_t index) const noexcept;
+	void Grow(Ring& ring);
+
+private:
+	const uint32_t m_numQueues;
+	std::unique_ptr<Ring[]> m_rings;
+
+	// Stats
+	std::atomic<uint64_t> m_numPendingObjects{ 0 };
+	std::atomic<uint64_t> m_numReleasedObjects{ 0 };
+	std::atomic<uint64_t> m_maxPendingObjects{ 0 };
+};
+
+} // namespace Luna
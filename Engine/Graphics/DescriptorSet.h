@@ -46,6 +46,11 @@ public:
 	virtual void SetCBV(uint32_t slot, GpuBufferPtr gpuBuffer) = 0;
 
 	virtual void SetSampler(uint32_t slot, SamplerPtr sampler) = 0;
+
+	// Moves the set to a new descriptor table holding the same descriptors, and frees the old table once the GPU
+	// is done with it.  Writes that follow cannot touch a table that submitted work, or work still being
+	// recorded, may read.
+	virtual void Rename() = 0;
 };
 
 using DescriptorSetPtr = std::shared_ptr<IDescriptorSet>;
@@ -0,0 +1,229 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "DescriptorSlotAllocator.h"
+
+#include <bit>
+
+using namespace std;
+
+
+namespace Luna
+{
+
+float DescriptorSlotStats::GetFragmentation() const noexcept
+{
+	const uint32_t numTotalSlots = numPages * slotsPerPage;
+	const uint32_t numUnusedSlots = numTotalSlots - numAllocatedSlots - numPendingSlots;
+
+	return numUnusedSlots > 0 ? (float)numFreeSlots / (float)numUnusedSlots : 0.0f;
+}
+
+
+float DescriptorSlotStats::GetReuseRate() const noexcept
+{
+	return numAllocations > 0 ? (float)numReusedAllocations / (float)numAllocations : 0.0f;
+}
+
+
+DescriptorSlotAllocator::DescriptorSlotAllocator(uint32_t slotsPerPage, CreatePageFunction createPageFunction)
+	: m_slotsPerPage{ slotsPerPage }
+	, m_numSizeClasses{ (uint32_t)countr_zero(slotsPerPage) + 1u }
+	, m_createPageFunction{ move(createPageFunction) }
+{
+	assert(has_single_bit(slotsPerPage));
+
+	m_freeLists.resize(m_numSizeClasses);
+}
+
+
+DescriptorSlotRange DescriptorSlotAllocator::Allocate(uint32_t count)
+{
+	assert(count > 0 && count <= m_slotsPerPage);
+
+	lock_guard<mutex> lock(m_mutex);
+
+	const uint32_t sizeClass = GetSizeClass(count);
+	const uint32_t classSize = 1u << sizeClass;
+
+	uint32_t slotIndex{ 0 };
+	bool bReused = PopFreeRange(sizeClass, slotIndex);
+
+	if (!bReused)
+	{
+		if (m_numPages == 0 || m_currentOffset + classSize > m_slotsPerPage)
+		{
+			// The rest of the current page goes to the smaller size classes
+			if (m_numPages > 0 && m_currentOffset < m_slotsPerPage)
+			{
+				AddFreeRange(GetSlotIndex(m_numPages - 1, m_currentOffset), m_slotsPerPage - m_currentOffset);
+			}
+
+			m_createPageFunction(m_numPages);
+
+			++m_numPages;
+			m_currentOffset = 0;
+			m_generations.resize((size_t)m_numPages * m_slotsPerPage, 0);
+		}
+
+		slotIndex = GetSlotIndex(m_numPages - 1, m_currentOffset);
+		m_currentOffset += classSize;
+	}
+
+	uint32_t& generation = m_generations[slotIndex];
+	++generation;
+	assert((generation & 1) == 1);
+
+	m_numAllocatedSlots += classSize;
+	m_numRequestedSlots += count;
+	++m_numAllocations;
+	m_numReusedAllocations += bReused ? 1 : 0;
+
+	return DescriptorSlotRange{
+		.pageIndex	= slotIndex / m_slotsPerPage,
+		.offset		= slotIndex % m_slotsPerPage,
+		.count		= count,
+		.generation = generation
+	};
+}
+
+
+void DescriptorSlotAllocator::Free(const DescriptorSlotRange& range, uint64_t fenceValue)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if (!IsAllocated_Internal(range))
+	{
+		assert_msg(false, "Descriptor range freed twice, or freed after it was reused");
+		return;
+	}
+
+	// Bump the generation now, so any use of the range from here on shows up as stale
+	++m_generations[GetSlotIndex(range.pageIndex, range.offset)];
+
+	const uint32_t classSize = 1u << GetSizeClass(range.count);
+
+	m_numAllocatedSlots -= classSize;
+	m_numRequestedSlots -= range.count;
+	m_numPendingSlots += classSize;
+
+	m_pendingFrees.emplace_back(fenceValue, range);
+}
+
+
+void DescriptorSlotAllocator::Reclaim(uint64_t completedFenceValue)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	// Frees are stamped with increasing fence values, so stop at the first one still in flight
+	while (!m_pendingFrees.empty() && m_pendingFrees.front().first <= completedFenceValue)
+	{
+		const DescriptorSlotRange& range = m_pendingFrees.front().second;
+		const uint32_t classSize = 1u << GetSizeClass(range.count);
+
+		m_numPendingSlots -= classSize;
+		AddFreeRange(GetSlotIndex(range.pageIndex, range.offset), classSize);
+
+		m_pendingFrees.pop_front();
+	}
+}
+
+
+bool DescriptorSlotAllocator::IsAllocated(const DescriptorSlotRange& range) const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return IsAllocated_Internal(range);
+}
+
+
+DescriptorSlotStats DescriptorSlotAllocator::GetStats() const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return DescriptorSlotStats{
+		.numPages				= m_numPages,
+		.slotsPerPage			= m_slotsPerPage,
+		.numAllocatedSlots		= m_numAllocatedSlots,
+		.numRequestedSlots		= m_numRequestedSlots,
+		.numFreeSlots			= m_numFreeSlots,
+		.numPendingSlots		= m_numPendingSlots,
+		.numAllocations			= m_numAllocations,
+		.numReusedAllocations	= m_numReusedAllocations
+	};
+}
+
+
+uint32_t DescriptorSlotAllocator::GetSizeClass(uint32_t count) const noexcept
+{
+	// Rounds up, so the class always covers the count
+	return (uint32_t)bit_width(count - 1);
+}
+
+
+bool DescriptorSlotAllocator::IsAllocated_Internal(const DescriptorSlotRange& range) const
+{
+	if (range.IsNull() || range.pageIndex >= m_numPages || range.offset + range.count > m_slotsPerPage)
+	{
+		return false;
+	}
+
+	const uint32_t generation = m_generations[GetSlotIndex(range.pageIndex, range.offset)];
+	return (generation & 1) == 1 && generation == range.generation;
+}
+
+
+bool DescriptorSlotAllocator::PopFreeRange(uint32_t sizeClass, uint32_t& slotIndex)
+{
+	// Take the smallest free range that fits, and hand what is left over back to the smaller classes
+	for (uint32_t i = sizeClass; i < m_numSizeClasses; ++i)
+	{
+		auto& freeList = m_freeLists[i];
+		if (freeList.empty())
+		{
+			continue;
+		}
+
+		slotIndex = freeList.back();
+		freeList.pop_back();
+		m_numFreeSlots -= 1u << i;
+
+		if (i > sizeClass)
+		{
+			const uint32_t classSize = 1u << sizeClass;
+			AddFreeRange(slotIndex + classSize, (1u << i) - classSize);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+
+void DescriptorSlotAllocator::AddFreeRange(uint32_t slotIndex, uint32_t count)
+{
+	m_numFreeSlots += count;
+
+	// Split into power-of-two ranges, largest first
+	while (count > 0)
+	{
+		const uint32_t sizeClass = (uint32_t)bit_width(count) - 1;
+
+		m_freeLists[sizeClass].push_back(slotIndex);
+
+		slotIndex += 1u << sizeClass;
+		count -= 1u << sizeClass;
+	}
+}
+
+} // namespace Luna
@@ -0,0 +1,106 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+
+namespace Luna
+{
+
+// A range of slots handed out by a DescriptorSlotAllocator.  The generation is odd while the range is allocated,
+// so copies of a range that has since been freed no longer match.
+struct DescriptorSlotRange
+{
+	uint32_t pageIndex{ 0 };
+	uint32_t offset{ 0 };
+	uint32_t count{ 0 };
+	uint32_t generation{ 0 };
+
+	bool IsNull() const noexcept { return count == 0; }
+};
+
+
+struct DescriptorSlotStats
+{
+	uint32_t numPages{ 0 };
+	uint32_t slotsPerPage{ 0 };
+	uint32_t numAllocatedSlots{ 0 };	// Rounded up to the size class
+	uint32_t numRequestedSlots{ 0 };
+	uint32_t numFreeSlots{ 0 };			// On the free lists, ready for reuse
+	uint32_t numPendingSlots{ 0 };		// Freed, but waiting on a fence
+	uint64_t numAllocations{ 0 };
+	uint64_t numReusedAllocations{ 0 };
+
+	// Share of the unallocated slots that sit on the free lists, rather than in the untouched end of the last page
+	float GetFragmentation() const noexcept;
+	float GetReuseRate() const noexcept;
+};
+
+
+// Allocation policy for CPU descriptor heaps, with no graphics API behind it.  Slots live in fixed-size pages, and
+// ranges are rounded up to a power-of-two size class, each with its own free list.  Freed ranges wait for a fence
+// value before they are handed out again, and per-slot generations catch double frees and stale ranges.
+class DescriptorSlotAllocator : public NonCopyable
+{
+public:
+	// Called with the allocator's lock held, before any slot in the new page is handed out
+	using CreatePageFunction = std::function<void(uint32_t pageIndex)>;
+
+	DescriptorSlotAllocator(uint32_t slotsPerPage, CreatePageFunction createPageFunction);
+
+	DescriptorSlotRange Allocate(uint32_t count = 1);
+
+	// The range is reused once Reclaim() sees a completed fence value at or past fenceValue
+	void Free(const DescriptorSlotRange& range, uint64_t fenceValue);
+	void Reclaim(uint64_t completedFenceValue);
+
+	// False for ranges that were never allocated, or that have been freed since
+	bool IsAllocated(const DescriptorSlotRange& range) const;
+
+	uint32_t GetSlotsPerPage() const noexcept { return m_slotsPerPage; }
+	DescriptorSlotStats GetStats() const;
+
+private:
+	uint32_t GetSizeClass(uint32_t count) const noexcept;
+	uint32_t GetSlotIndex(uint32_t pageIndex, uint32_t offset) const noexcept { return pageIndex * m_slotsPerPage + offset; }
+
+	bool IsAllocated_Internal(const DescriptorSlotRange& range) const;
+	bool PopFreeRange(uint32_t sizeClass, uint32_t& slotIndex);
+	void AddFreeRange(uint32_t slotIndex, uint32_t count);
+
+private:
+	const uint32_t m_slotsPerPage;
+	const uint32_t m_numSizeClasses;
+	CreatePageFunction m_createPageFunction;
+
+	mutable std::mutex m_mutex;
+
+	uint32_t m_numPages{ 0 };
+	uint32_t m_currentOffset{ 0 };
+
+	// Start slots of the free ranges, one list per size class
+	std::vector<std::vector<uint32_t>> m_freeLists;
+
+	// Freed ranges in the order they were freed, along with the fence they wait on
+	std::deque<std::pair<uint64_t, DescriptorSlotRange>> m_pendingFrees;
+
+	// Generation of every slot, odd while the range starting at that slot is allocated
+	std::vector<uint32_t> m_generations;
+
+	// Stats
+	uint32_t m_numAllocatedSlots{ 0 };
+	uint32_t m_numRequestedSlots{ 0 };
+	uint32_t m_numFreeSlots{ 0 };
+	uint32_t m_numPendingSlots{ 0 };
+	uint64_t m_numAllocations{ 0 };
+	uint64_t m_numReusedAllocations{ 0 };
+};
+
+} // namespace Luna
@@ -0,0 +1,161 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "DescriptorTableHashCache.h"
+
+#include <bit>
+
+using namespace std;
+
+
+namespace Luna
+{
+
+float DescriptorTableCacheStats::GetHitRate() const noexcept
+{
+	return numLookups > 0 ? (float)numHits / (float)numLookups : 0.0f;
+}
+
+
+DescriptorTableCacheStats& DescriptorTableCacheStats::operator+=(const DescriptorTableCacheStats& other) noexcept
+{
+	numLookups += other.numLookups;
+	numHits += other.numHits;
+	numInserts += other.numInserts;
+	numDroppedInserts += other.numDroppedInserts;
+	numResets += other.numResets;
+
+	return *this;
+}
+
+
+DescriptorTableHashCache::DescriptorTableHashCache(uint32_t maxEntries, uint32_t maxKeyWords)
+	: m_maxEntries{ maxEntries }
+	, m_maxKeyWords{ maxKeyWords }
+{
+	assert(maxEntries > 0 && maxKeyWords > 0);
+
+	// Twice as many slots as entries keeps the probe sequences short
+	const uint32_t numSlots = bit_ceil(2 * maxEntries);
+	m_entries.resize(numSlots);
+	m_slotMask = numSlots - 1;
+}
+
+
+/* static */ size_t DescriptorTableHashCache::HashKey(span<const uint32_t> key) noexcept
+{
+	return Utility::HashRange(key.data(), key.data() + key.size(), 2166136261U);
+}
+
+
+bool DescriptorTableHashCache::Find(size_t hash, span<const uint32_t> key, uint64_t& location)
+{
+	assert(!key.empty());
+
+	++m_stats.numLookups;
+
+	if (m_numEntries == 0)
+	{
+		return false;
+	}
+
+	for (uint32_t slot = (uint32_t)hash & m_slotMask; m_entries[slot].keySize != 0; slot = (slot + 1) & m_slotMask)
+	{
+		const Entry& entry = m_entries[slot];
+		if (entry.hash == hash && KeyEquals(entry, key))
+		{
+			location = entry.location;
+			++m_stats.numHits;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void DescriptorTableHashCache::Insert(size_t hash, span<const uint32_t> key, uint64_t location)
+{
+	assert(!key.empty());
+
+	if (m_numEntries == m_maxEntries || m_keyData.size() + key.size() > m_maxKeyWords)
+	{
+		++m_stats.numDroppedInserts;
+		return;
+	}
+
+	uint32_t slot = (uint32_t)hash & m_slotMask;
+	while (m_entries[slot].keySize != 0)
+	{
+		Entry& entry = m_entries[slot];
+
+		// Same contents copied again, point at the newest copy
+		if (entry.hash == hash && KeyEquals(entry, key))
+		{
+			entry.location = location;
+			return;
+		}
+
+		slot = (slot + 1) & m_slotMask;
+	}
+
+	Entry& entry = m_entries[slot];
+	entry.hash = hash;
+	entry.location = location;
+	entry.keyOffset = (uint32_t)m_keyData.size();
+	entry.keySize = (uint32_t)key.size();
+
+	m_keyData.insert(m_keyData.end(), key.begin(), key.end());
+
+	++m_numEntries;
+	++m_stats.numInserts;
+}
+
+
+void DescriptorTableHashCache::Reset()
+{
+	if (m_numEntries == 0)
+	{
+		return;
+	}
+
+	for (auto& entry : m_entries)
+	{
+		entry.keySize = 0;
+	}
+
+	m_keyData.clear();
+	m_numEntries = 0;
+
+	++m_stats.numResets;
+}
+
+
+DescriptorTableCacheStats DescriptorTableHashCache::TakeStats() noexcept
+{
+	DescriptorTableCacheStats stats = m_stats;
+	m_stats = DescriptorTableCacheStats{};
+	return stats;
+}
+
+
+bool DescriptorTableHashCache::KeyEquals(const Entry& entry, span<const uint32_t> key) const noexcept
+{
+	if (entry.keySize != (uint32_t)key.size())
+	{
+		return false;
+	}
+
+	return memcmp(m_keyData.data() + entry.keyOffset, key.data(), key.size_bytes()) == 0;
+}
+
+} // namespace Luna
@@ -0,0 +1,81 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+
+namespace Luna
+{
+
+struct DescriptorTableCacheStats
+{
+	uint64_t numLookups{ 0 };
+	uint64_t numHits{ 0 };
+	uint64_t numInserts{ 0 };
+	uint64_t numDroppedInserts{ 0 };	// The cache was full
+	uint64_t numResets{ 0 };
+
+	float GetHitRate() const noexcept;
+
+	DescriptorTableCacheStats& operator+=(const DescriptorTableCacheStats& other) noexcept;
+};
+
+
+// Remembers where the contents of a descriptor table were last copied in shader-visible memory, so an identical
+// table can be rebound rather than copied again.  Keys are the raw table contents (CPU descriptor handles, or
+// descriptor bytes), hashed and then compared in full, so a hash collision never binds the wrong table.  Locations
+// are only meaningful for the heap or buffer that was current when they were inserted, so the owner calls Reset()
+// whenever it retires that heap.  The cache is bounded:  once either the entry or key budget is used up, inserts
+// are dropped until the next reset.  Not thread-safe, each dynamic descriptor heap owns its own.
+class DescriptorTableHashCache : public NonCopyable
+{
+public:
+	explicit DescriptorTableHashCache(uint32_t maxEntries = 256, uint32_t maxKeyWords = 16384);
+
+	static size_t HashKey(std::span<const uint32_t> key) noexcept;
+
+	bool Find(size_t hash, std::span<const uint32_t> key, uint64_t& location);
+	void Insert(size_t hash, std::span<const uint32_t> key, uint64_t location);
+
+	void Reset();
+
+	uint32_t GetNumEntries() const noexcept { return m_numEntries; }
+	const DescriptorTableCacheStats& GetStats() const noexcept { return m_stats; }
+
+	// Hands back the stats gathered since the last call, for merging into a global total
+	DescriptorTableCacheStats TakeStats() noexcept;
+
+private:
+	struct Entry
+	{
+		size_t hash{ 0 };
+		uint64_t location{ 0 };
+		uint32_t keyOffset{ 0 };
+		uint32_t keySize{ 0 };	// Zero for an empty slot, keys are never empty
+	};
+
+	bool KeyEquals(const Entry& entry, std::span<const uint32_t> key) const noexcept;
+
+private:
+	const uint32_t m_maxEntries;
+	const uint32_t m_maxKeyWords;
+
+	// Open addressing with linear probing, kept at most half full
+	std::vector<Entry> m_entries;
+	uint32_t m_slotMask{ 0 };
+	uint32_t m_numEntries{ 0 };
+
+	// Key contents, packed end to end
+	std::vector<uint32_t> m_keyData;
+
+	DescriptorTableCacheStats m_stats;
+};
+
+} // namespace Luna
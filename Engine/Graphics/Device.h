@@ -16,6 +16,7 @@
 #include "Graphics\DepthBuffer.h"
 #include "Graphics\DescriptorSet.h"
 #include "Graphics\GpuBuffer.h"
+#include "Graphics\PipelineCache.h"
 #include "Graphics\PipelineState.h"
 #include "Graphics\QueryHeap.h"
 #include "Graphics\RootSignature.h"
@@ -49,6 +50,9 @@ public:
 	virtual ComputePipelinePtr CreateComputePipeline(const ComputePipelineDesc& pipelineDesc) = 0;
 	virtual MeshletPipelinePtr CreateMeshletPipeline(const MeshletPipelineDesc& pipelineDesc) = 0;
 
+	// Hits and misses against the on-disk pipeline cache, and the bytes read at startup and written at shutdown
+	virtual PipelineCacheStats GetPipelineCacheStats() const = 0;
+
 	virtual QueryHeapPtr CreateQueryHeap(const QueryHeapDesc& queryHeapDesc) = 0;
 
 	virtual SamplerPtr CreateSampler(const SamplerDesc& samplerDesc) = 0;
@@ -33,6 +33,7 @@ struct DeviceManagerDesc
 	bool logDeviceCaps{ true };
 	bool allowSoftwareDevice{ false };
 	bool preferDiscreteDevice{ true };
+	bool enableDescriptorTableCache{ true };
 
 	// TODO - set these values from ApplicationInfo
 	bool startMaximized{ false };
@@ -64,6 +65,7 @@ struct DeviceManagerDesc
 	constexpr DeviceManagerDesc& SetLogDeviceCaps(bool value) noexcept { logDeviceCaps = value; return *this; }
 	constexpr DeviceManagerDesc& SetAllowSoftwareDevice(bool value) noexcept { allowSoftwareDevice = value; return *this; }
 	constexpr DeviceManagerDesc& SetPreferDiscreteDevice(bool value) noexcept { preferDiscreteDevice = value; return *this; }
+	constexpr DeviceManagerDesc& SetEnableDescriptorTableCache(bool value) noexcept { enableDescriptorTableCache = value; return *this; }
 	constexpr DeviceManagerDesc& SetStartMaximized(bool value) noexcept { startMaximized = value; return *this; }
 	constexpr DeviceManagerDesc& SetStartFullscreen(bool value) noexcept { startFullscreen = value; return *this; }
 	constexpr DeviceManagerDesc& SetAllowModeSwitch(bool value) noexcept { allowModeSwitch = value; return *this; }
@@ -94,6 +96,8 @@ public:
 	virtual void Present() = 0;
 
 	virtual void WaitForGpu() = 0;
+	virtual void WaitForFence(uint64_t fenceValue) = 0;
+	virtual bool IsFenceComplete(uint64_t fenceValue) = 0;
 
 	virtual void SetWindowSize(uint32_t width, uint32_t height) = 0;
 	virtual void CreateDeviceResources() = 0;
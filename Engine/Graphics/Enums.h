@@ -817,6 +817,9 @@ enum class StaticBorderColor : uint8_t
 } // namespace Luna
 
 
+// Headless builds may use a standard library without std::format
+#ifdef __cpp_lib_format
+
 #define DECLARE_STRING_FORMATTERS(ENGINE_TYPE) \
 template <> \
 struct std::formatter<ENGINE_TYPE> : public std::formatter<std::string> \
@@ -834,4 +837,6 @@ DECLARE_STRING_FORMATTERS(Luna::CommandListType)
 DECLARE_STRING_FORMATTERS(Luna::QueueType)
 
 
-#undef DECLARE_STRING_FORMATTERS
\ No newline at end of file
+#undef DECLARE_STRING_FORMATTERS
+
+#endif // __cpp_lib_format
\ No newline at end of file
@@ -252,6 +252,9 @@ void GetSurfaceInfo(
 		bc = true;
 		bpe = 16;
 		break;
+
+	default:
+		break;
 	}
 
 	if (bc)
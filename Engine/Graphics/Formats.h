@@ -132,12 +132,29 @@ inline Format RemoveSrgb(Format format)
 	case Format::SBGRA8_UNorm: return Format::BGRA8_UNorm;
 	case Format::BC1_UNorm_Srgb: return Format::BC1_UNorm;
 	case Format::BC2_UNorm_Srgb: return Format::BC2_UNorm;
+	case Format::BC3_UNorm_Srgb: return Format::BC3_UNorm;
 	case Format::BC7_UNorm_Srgb: return Format::BC7_UNorm;
 	default:
 		return format;
 	}
 }
 
+
+inline Format MakeSrgb(Format format)
+{
+	switch (format)
+	{
+	case Format::RGBA8_UNorm: return Format::SRGBA8_UNorm;
+	case Format::BGRA8_UNorm: return Format::SBGRA8_UNorm;
+	case Format::BC1_UNorm: return Format::BC1_UNorm_Srgb;
+	case Format::BC2_UNorm: return Format::BC2_UNorm_Srgb;
+	case Format::BC3_UNorm: return Format::BC3_UNorm_Srgb;
+	case Format::BC7_UNorm: return Format::BC7_UNorm_Srgb;
+	default:
+		return format;
+	}
+}
+
 // TODO: use a struct for the out data
 void GetSurfaceInfo(
 	size_t width, 
@@ -0,0 +1,267 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "GpuProfiler.h"
+
+#include "CommandContext.h"
+#include "Device.h"
+#include "DeviceCaps.h"
+#include "DeviceManager.h"
+
+using namespace std;
+
+
+namespace
+{
+
+Luna::GpuProfiler* g_gpuProfiler{ nullptr };
+
+constexpr uint32_t s_invalidScope = ~0u;
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+GpuProfiler::GpuProfiler(uint32_t maxScopesPerFrame)
+	: m_maxQueriesPerFrame{ 2 * maxScopesPerFrame }
+{
+	auto deviceManager = GetDeviceManager();
+	const uint32_t numSlots = deviceManager->GetNumSwapChainBuffers();
+
+	m_slots.resize(numSlots);
+	m_timestampFrequency = deviceManager->GetDevice()->GetDeviceCaps().other.timestampFrequencyHz;
+
+	QueryHeapDesc queryHeapDesc{
+		.name			= "GpuProfiler Query Heap",
+		.type			= QueryHeapType::Timestamp,
+		.queryCount		= numSlots * m_maxQueriesPerFrame
+	};
+	m_queryHeap = deviceManager->GetDevice()->CreateQueryHeap(queryHeapDesc);
+
+	GpuBufferDesc readbackBufferDesc{
+		.name			= "GpuProfiler Readback Buffer",
+		.resourceType	= ResourceType::ReadbackBuffer,
+		.memoryAccess	= MemoryAccess::GpuReadWrite | MemoryAccess::CpuRead,
+		.elementCount	= numSlots * m_maxQueriesPerFrame,
+		.elementSize	= sizeof(uint64_t)
+	};
+	m_readbackBuffer = deviceManager->GetDevice()->CreateGpuBuffer(readbackBufferDesc);
+
+	// Vulkan requires queries to be reset before their first use
+	GraphicsContext& context = GraphicsContext::Begin();
+	context.ResetQueries(m_queryHeap, 0, numSlots * m_maxQueriesPerFrame);
+	context.Finish(true);
+
+	assert(g_gpuProfiler == nullptr);
+	g_gpuProfiler = this;
+}
+
+
+GpuProfiler::~GpuProfiler()
+{
+	g_gpuProfiler = nullptr;
+}
+
+
+void GpuProfiler::BeginFrame()
+{
+	auto frameProfiler = GetFrameProfiler();
+	if (!frameProfiler || m_timestampFrequency == 0)
+	{
+		return;
+	}
+
+	lock_guard lock(m_mutex);
+
+	// IDeviceManager::BeginFrame() has waited for the last frame that used this swap chain buffer
+	m_activeSlot = GetDeviceManager()->GetActiveFrame() % (uint32_t)m_slots.size();
+
+	FrameSlot& slot = m_slots[m_activeSlot];
+	if (slot.pending)
+	{
+		ReadBack(slot);
+	}
+
+	slot.frameNumber = frameProfiler->GetFrameNumber();
+	slot.numQueries = 0;
+	slot.scopes.clear();
+	slot.pending = false;
+
+	m_openScopes.clear();
+	m_frameActive = frameProfiler->IsEnabled();
+}
+
+
+void GpuProfiler::EndFrame()
+{
+	uint32_t numQueries{ 0 };
+	{
+		lock_guard lock(m_mutex);
+
+		if (!m_frameActive)
+		{
+			return;
+		}
+
+		// No more scopes this frame, including from the resolve context below
+		m_frameActive = false;
+
+		numQueries = m_slots[m_activeSlot].numQueries;
+		m_slots[m_activeSlot].pending = numQueries > 0;
+	}
+
+	if (numQueries == 0)
+	{
+		return;
+	}
+
+	const uint32_t firstQuery = m_activeSlot * m_maxQueriesPerFrame;
+
+	GraphicsContext& context = GraphicsContext::Begin("GpuProfiler Resolve");
+	context.ResolveQueries(m_queryHeap, firstQuery, numQueries, m_readbackBuffer, firstQuery * sizeof(uint64_t));
+	context.ResetQueries(m_queryHeap, firstQuery, numQueries);
+	context.Finish();
+}
+
+
+void GpuProfiler::BeginScope(ICommandContext* context, const string& name)
+{
+	lock_guard lock(m_mutex);
+
+	auto& openScopes = m_openScopes[context];
+
+	FrameSlot& slot = m_slots[m_activeSlot];
+	if (!m_frameActive || context->GetType() != CommandListType::Graphics || slot.numQueries + 2 > m_maxQueriesPerFrame)
+	{
+		openScopes.push_back(s_invalidScope);
+		return;
+	}
+
+	uint32_t nameId{ 0 };
+	auto it = m_nameIds.find(name);
+	if (it != m_nameIds.end())
+	{
+		nameId = it->second;
+	}
+	else
+	{
+		nameId = GetFrameProfiler()->RegisterName(name);
+		m_nameIds.emplace(name, nameId);
+	}
+
+	const uint32_t firstQuery = m_activeSlot * m_maxQueriesPerFrame;
+
+	Scope scope{
+		.nameId			= nameId,
+		.depth			= (uint32_t)openScopes.size(),
+		.beginQuery		= firstQuery + slot.numQueries,
+		.endQuery		= firstQuery + slot.numQueries + 1
+	};
+	slot.numQueries += 2;
+
+	openScopes.push_back((uint32_t)slot.scopes.size());
+	slot.scopes.push_back(scope);
+
+	context->EndQuery(m_queryHeap.get(), scope.beginQuery);
+}
+
+
+void GpuProfiler::EndScope(ICommandContext* context)
+{
+	lock_guard lock(m_mutex);
+
+	auto it = m_openScopes.find(context);
+	if (it == m_openScopes.end() || it->second.empty())
+	{
+		return;
+	}
+
+	const uint32_t scopeIndex = it->second.back();
+	it->second.pop_back();
+
+	if (scopeIndex == s_invalidScope)
+	{
+		return;
+	}
+
+	context->EndQuery(m_queryHeap.get(), m_slots[m_activeSlot].scopes[scopeIndex].endQuery);
+}
+
+
+void GpuProfiler::ReadBack(FrameSlot& slot)
+{
+	auto frameProfiler = GetFrameProfiler();
+
+	const uint64_t* timestamps = (const uint64_t*)m_readbackBuffer->Map();
+	if (!timestamps)
+	{
+		return;
+	}
+
+	const double gpuToCpuTicks = (double)frameProfiler->GetClockFrequency() / (double)m_timestampFrequency;
+
+	m_events.clear();
+	uint64_t firstGpuTime = ~0ull;
+	for (const auto& scope : slot.scopes)
+	{
+		const uint64_t start = (uint64_t)((double)timestamps[scope.beginQuery] * gpuToCpuTicks);
+		const uint64_t end = (uint64_t)((double)timestamps[scope.endQuery] * gpuToCpuTicks);
+
+		ProfileEvent event{
+			.nameId			= scope.nameId,
+			.threadIndex	= 0,
+			.depth			= scope.depth,
+			.start			= start,
+			.end			= end
+		};
+		m_events.push_back(event);
+
+		firstGpuTime = min(firstGpuTime, start);
+	}
+
+	m_readbackBuffer->Unmap();
+
+	// The GPU and CPU clocks are not calibrated against each other.  Work for a frame cannot start before the
+	// CPU began the frame, so the offset is anchored there, and only moves if the GPU would appear to run early.
+	// That keeps the spacing between GPU frames intact.
+	for (const auto& frame : frameProfiler->GetHistory())
+	{
+		if (frame.frameNumber == slot.frameNumber)
+		{
+			const int64_t minOffset = (int64_t)frame.start - (int64_t)firstGpuTime;
+			if (!m_hasClockOffset || m_clockOffset < minOffset)
+			{
+				m_clockOffset = minOffset;
+				m_hasClockOffset = true;
+			}
+			break;
+		}
+	}
+
+	for (auto& event : m_events)
+	{
+		event.start = (uint64_t)((int64_t)event.start + m_clockOffset);
+		event.end = (uint64_t)((int64_t)event.end + m_clockOffset);
+	}
+
+	frameProfiler->AddGpuEvents(slot.frameNumber, m_events);
+}
+
+
+GpuProfiler* GetGpuProfiler()
+{
+	return g_gpuProfiler;
+}
+
+} // namespace Luna
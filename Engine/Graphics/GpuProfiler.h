@@ -0,0 +1,87 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\FrameProfiler.h"
+#include "Graphics\GpuBuffer.h"
+#include "Graphics\QueryHeap.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+class ICommandContext;
+
+
+// Times GPU scopes with pairs of timestamp queries.  Each swap chain buffer has its own range of queries and
+// readback memory, which is read when the buffer comes around again, so results arrive a few frames late and
+// the CPU never waits on them.  Only graphics queue contexts are timed.
+class GpuProfiler : NonCopyable, NonMovable
+{
+public:
+	explicit GpuProfiler(uint32_t maxScopesPerFrame = 512);
+	~GpuProfiler();
+
+	// Call after IDeviceManager::BeginFrame(), and before IDeviceManager::Present()
+	void BeginFrame();
+	void EndFrame();
+
+	// Thread-safe.  Scopes nest per context.
+	void BeginScope(ICommandContext* context, const std::string& name);
+	void EndScope(ICommandContext* context);
+
+private:
+	struct Scope
+	{
+		uint32_t nameId{ 0 };
+		uint32_t depth{ 0 };
+		uint32_t beginQuery{ 0 };
+		uint32_t endQuery{ 0 };
+	};
+
+	struct FrameSlot
+	{
+		uint64_t frameNumber{ 0 };
+		uint32_t numQueries{ 0 };
+		std::vector<Scope> scopes;
+		bool pending{ false };
+	};
+
+	void ReadBack(FrameSlot& slot);
+
+private:
+	const uint32_t m_maxQueriesPerFrame{ 0 };
+	uint64_t m_timestampFrequency{ 0 };
+
+	QueryHeapPtr m_queryHeap;
+	GpuBufferPtr m_readbackBuffer;
+
+	std::mutex m_mutex;
+	std::vector<FrameSlot> m_slots;
+	uint32_t m_activeSlot{ 0 };
+	bool m_frameActive{ false };
+
+	// Open scopes per context, as indices into the active slot's scopes.  ~0 marks a scope that was not recorded.
+	std::unordered_map<ICommandContext*, std::vector<uint32_t>> m_openScopes;
+	std::unordered_map<std::string, uint32_t> m_nameIds;
+
+	// Maps GPU ticks onto the CPU profiler clock
+	bool m_hasClockOffset{ false };
+	int64_t m_clockOffset{ 0 };
+
+	std::vector<ProfileEvent> m_events;
+};
+
+
+GpuProfiler* GetGpuProfiler();
+
+} // namespace Luna
@@ -13,6 +13,7 @@
 #include "GraphicsCommon.h"
 
 #include "DX12\DeviceManager12.h"
+#include "Null\DeviceManagerNull.h"
 #include "Vulkan\DeviceManagerVK.h"
 
 using namespace std;
@@ -35,6 +36,12 @@ Luna::IDeviceManager* CreateVulkanDeviceManager(const Luna::DeviceManagerDesc& d
 	return new Luna::VK::DeviceManager(desc);
 }
 
+
+Luna::IDeviceManager* CreateNullDeviceManager(const Luna::DeviceManagerDesc& desc)
+{
+	return new Luna::Null::DeviceManager(desc);
+}
+
 } // anonymous namespace
 
 
@@ -100,6 +107,10 @@ IDeviceManager* CreateDeviceManager(const DeviceManagerDesc& desc)
 		return CreateVulkanDeviceManager(desc);
 		break;
 
+	case GraphicsApi::Null:
+		return CreateNullDeviceManager(desc);
+		break;
+
 		// Default to D3D12
 	default:
 		return CreateD3D12DeviceManager(desc);
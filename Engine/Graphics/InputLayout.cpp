@@ -12,6 +12,8 @@
 
 #include "InputLayout.h"
 
+#include <bit>
+
 using namespace std;
 
 
@@ -77,8 +79,28 @@ uint32_t GetVertexComponentSemantic(VertexComponent component)
 }
 
 
-Format GetVertexComponentFormat(VertexComponent component)
+Format GetVertexComponentFormat(VertexComponent component, VertexEncoding encoding)
 {
+	if (component == VertexComponent::Position)
+	{
+		assert_msg(!HasAllFlags(encoding, VertexEncoding::PositionHalf | VertexEncoding::PositionUNorm16), "Only one position encoding can be used");
+
+		if (HasFlag(encoding, VertexEncoding::PositionHalf))
+			return Format::RGBA16_Float;
+
+		if (HasFlag(encoding, VertexEncoding::PositionUNorm16))
+			return Format::RGBA16_UNorm;
+	}
+
+	if (component == VertexComponent::Normal && HasFlag(encoding, VertexEncoding::NormalOct16))
+		return Format::RG16_SNorm;
+
+	if (component == VertexComponent::Tangent && HasFlag(encoding, VertexEncoding::TangentOct16))
+		return Format::RGBA16_SNorm;
+
+	if (component == VertexComponent::Bitangent && HasFlag(encoding, VertexEncoding::TangentOct16))
+		return Format::RG16_SNorm;
+
 	if (component == VertexComponent::BlendIndices)
 		return Format::R32_UInt;
 
@@ -89,18 +111,33 @@ Format GetVertexComponentFormat(VertexComponent component)
 		component == VertexComponent::Texcoord1 ||
 		component == VertexComponent::Texcoord2 ||
 		component == VertexComponent::Texcoord3)
+	{
+		assert_msg(!HasAllFlags(encoding, VertexEncoding::TexcoordHalf | VertexEncoding::TexcoordUNorm16), "Only one texcoord encoding can be used");
+
+		if (HasFlag(encoding, VertexEncoding::TexcoordHalf))
+			return Format::RG16_Float;
+
+		if (HasFlag(encoding, VertexEncoding::TexcoordUNorm16))
+			return Format::RG16_UNorm;
+
 		return Format::RG32_Float;
+	}
 
 	if (component == VertexComponent::Color0 || component == VertexComponent::Color1)
-		return Format::RGBA32_Float;
+		return HasFlag(encoding, VertexEncoding::ColorUNorm8) ? Format::RGBA8_UNorm : Format::RGBA32_Float;
 
 	return Format::RGB32_Float;
 }
 
 
-uint32_t GetVertexComponentSizeInBytes(VertexComponent component)
+uint32_t GetVertexComponentSizeInBytes(VertexComponent component, VertexEncoding encoding)
 {
-	return sizeof(float) * GetVertexComponentNumFloats(component);
+	if (encoding == VertexEncoding::None)
+	{
+		return sizeof(float) * GetVertexComponentNumFloats(component);
+	}
+
+	return BitsPerPixel(GetVertexComponentFormat(component, encoding)) / 8;
 }
 
 
@@ -125,35 +162,38 @@ uint32_t GetVertexComponentNumFloats(VertexComponent component)
 }
 
 
-void VertexLayoutBase::Setup(VertexComponent components)
+void VertexLayoutBase::Setup(VertexComponent components, VertexEncoding encoding)
 {
-	static unordered_map<VertexComponent, uint32_t> cachedSizeInBytes;
+	static unordered_map<uint64_t, uint32_t> cachedSizeInBytes;
 	static unordered_map<VertexComponent, uint32_t> cachedNumFloats;
-	static unordered_map<VertexComponent, unique_ptr<vector<VertexElementDesc>>> cachedElements;
+	static unordered_map<uint64_t, unique_ptr<vector<VertexElementDesc>>> cachedElements;
 	static mutex cacheMutex;
 
 	scoped_lock lock(cacheMutex);
 
+	// Sizes and elements depend on the encoding, the float count doesn't
+	const uint64_t layoutKey = ((uint64_t)encoding << 32) | (uint64_t)components;
+
 	// Find or compute size in bytes
 	{
-		auto res = cachedSizeInBytes.find(components);
+		auto res = cachedSizeInBytes.find(layoutKey);
 		if (res != cachedSizeInBytes.end())
 		{
 			m_sizeInBytes = res->second;
 		}
 		else
 		{
-			unsigned long index{ 0 };
-			unsigned long tempComponents = unsigned long(components);
-			while (_BitScanForward(&index, tempComponents))
+			uint32_t tempComponents = (uint32_t)components;
+			while (tempComponents != 0)
 			{
+				const uint32_t index = (uint32_t)countr_zero(tempComponents);
 				VertexComponent singleComponent = VertexComponent(1 << index);
 				tempComponents ^= (1 << index);
 
-				m_sizeInBytes += GetVertexComponentSizeInBytes(singleComponent);
+				m_sizeInBytes += GetVertexComponentSizeInBytes(singleComponent, encoding);
 			}
 
-			cachedSizeInBytes[components] = m_sizeInBytes;
+			cachedSizeInBytes[layoutKey] = m_sizeInBytes;
 		}
 	}
 
@@ -166,10 +206,10 @@ void VertexLayoutBase::Setup(VertexComponent components)
 		}
 		else
 		{
-			unsigned long index{ 0 };
-			unsigned long tempComponents = unsigned long(components);
-			while (_BitScanForward(&index, tempComponents))
+			uint32_t tempComponents = (uint32_t)components;
+			while (tempComponents != 0)
 			{
+				const uint32_t index = (uint32_t)countr_zero(tempComponents);
 				VertexComponent singleComponent = VertexComponent(1 << index);
 				tempComponents ^= (1 << index);
 
@@ -182,7 +222,7 @@ void VertexLayoutBase::Setup(VertexComponent components)
 
 	// Find or construct list of VertexElementDescs
 	{
-		auto res = cachedElements.find(components);
+		auto res = cachedElements.find(layoutKey);
 		if (res != cachedElements.end())
 		{
 			m_elements = res->second.get();
@@ -191,18 +231,18 @@ void VertexLayoutBase::Setup(VertexComponent components)
 		{
 			auto elements = make_unique<vector<VertexElementDesc>>();
 
-			unsigned long index{ 0 };
-			unsigned long tempComponents = unsigned long(components);
+			uint32_t tempComponents = (uint32_t)components;
 			uint32_t offset{ 0 };
-			while (_BitScanForward(&index, tempComponents))
+			while (tempComponents != 0)
 			{
+				const uint32_t index = (uint32_t)countr_zero(tempComponents);
 				VertexComponent singleComponent = VertexComponent(1 << index);
 				tempComponents ^= (1 << index);
 
 				VertexElementDesc desc{
 					GetVertexComponentName(singleComponent),
 					GetVertexComponentSemantic(singleComponent),
-					GetVertexComponentFormat(singleComponent),
+					GetVertexComponentFormat(singleComponent, encoding),
 					0,
 					offset,
 					InputClassification::PerVertexData,
@@ -210,11 +250,11 @@ void VertexLayoutBase::Setup(VertexComponent components)
 
 				elements->push_back(desc);
 
-				offset += GetVertexComponentSizeInBytes(singleComponent);
+				offset += GetVertexComponentSizeInBytes(singleComponent, encoding);
 			}
 
 			m_elements = elements.get();
-			cachedElements[components] = move(elements);
+			cachedElements[layoutKey] = move(elements);
 		}
 	}
 }
@@ -10,8 +10,9 @@
 
 #pragma once
 
-#include "Graphics\Enums.h"
-#include "Graphics\Formats.h"
+#include "Core/BitmaskEnum.h"
+#include "Graphics/Enums.h"
+#include "Graphics/Formats.h"
 
 
 namespace Luna
@@ -83,8 +84,41 @@ enum class VertexComponent
 template <> struct EnableBitmaskOperators<VertexComponent> { static const bool enable = true; };
 
 
-uint32_t GetVertexComponentSizeInBytes(VertexComponent component);
+// Opt-in compact encodings for the vertex streams built by LoadModel.  Each flag applies to every component of
+// its kind (e.g. all texcoord sets).  Positions and texcoords that are normalized to a range are decoded with the
+// per-mesh VertexDecodeParams.
+enum class VertexEncoding
+{
+	None				= 0,
+	PositionHalf		= 1 << 0,	// RGBA16_Float, [-1, 1] across the mesh bounds
+	PositionUNorm16		= 1 << 1,	// RGBA16_UNorm, [0, 1] across the mesh bounds
+	NormalOct16			= 1 << 2,	// RG16_SNorm, octahedral
+	TangentOct16		= 1 << 3,	// Tangent RGBA16_SNorm: octahedral xy, bitangent sign in z.  Bitangent RG16_SNorm, octahedral
+	TexcoordHalf		= 1 << 4,	// RG16_Float
+	TexcoordUNorm16		= 1 << 5,	// RG16_UNorm, [0, 1] across the mesh's texcoord range
+	ColorUNorm8			= 1 << 6,	// RGBA8_UNorm
+
+	Compact = PositionUNorm16 | NormalOct16 | TangentOct16 | TexcoordUNorm16 | ColorUNorm8
+};
+
+template <> struct EnableBitmaskOperators<VertexEncoding> { static const bool enable = true; };
+
+
+// Per-mesh constants that undo the range normalization of the position and texcoord encodings:
+//   position = encoded.xyz * positionScale + positionOffset
+//   texcoord = encoded.xy * texcoordScaleOffset.xy + texcoordScaleOffset.zw
+// These are the identity for float streams.  Plain floats, so the model cache and the headless tests can use them.
+struct VertexDecodeParams
+{
+	float positionScale[3]{ 1.0f, 1.0f, 1.0f };
+	float positionOffset[3]{ 0.0f, 0.0f, 0.0f };
+	float texcoordScaleOffset[4]{ 1.0f, 1.0f, 0.0f, 0.0f };
+};
+
+
+uint32_t GetVertexComponentSizeInBytes(VertexComponent component, VertexEncoding encoding = VertexEncoding::None);
 uint32_t GetVertexComponentNumFloats(VertexComponent component);
+Format GetVertexComponentFormat(VertexComponent component, VertexEncoding encoding = VertexEncoding::None);
 
 
 class VertexLayoutBase
@@ -94,9 +128,10 @@ public:
 	uint32_t GetNumFloats() const { return m_numFloats; }
 	const std::vector<VertexElementDesc>& GetElements() const { return *m_elements; }
 	virtual VertexComponent GetComponents() const = 0;
+	virtual VertexEncoding GetEncoding() const = 0;
 
 protected:
-	void Setup(VertexComponent components);
+	void Setup(VertexComponent components, VertexEncoding encoding);
 
 protected:
 	uint32_t m_sizeInBytes{ 0 };
@@ -105,13 +140,14 @@ protected:
 };
 
 
-template <VertexComponent VC>
+template <VertexComponent VC, VertexEncoding VE = VertexEncoding::None>
 class VertexLayout : public VertexLayoutBase
 {
 public:
-	VertexLayout() { Setup(VC); }
+	VertexLayout() { Setup(VC, VE); }
 
 	VertexComponent GetComponents() const final { return VC; }
+	VertexEncoding GetEncoding() const final { return VE; }
 };
 
 } // namespace Luna
\ No newline at end of file
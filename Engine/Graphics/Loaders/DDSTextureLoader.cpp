@@ -247,7 +247,8 @@ bool CreateTextureFromDDS(
 	size_t maxSize,
 	Format format, 
 	bool forceSrgb,
-	bool retainData)
+	bool retainData,
+	std::shared_ptr<const void> dataOwner)
 {
 	uint32_t width = header->width;
 	uint32_t height = header->height;
@@ -468,7 +469,7 @@ bool CreateTextureFromDDS(
 	{
 		if (retainData)
 		{
-			texture->SetData(texInit.baseData, texInit.totalBytes);
+			texture->SetData(texInit.baseData, texInit.totalBytes, std::move(dataOwner));
 		}
 
 		return device->InitializeTexture(texture, texInit);
@@ -478,7 +479,8 @@ bool CreateTextureFromDDS(
 }
 
 
-bool CreateDDSTextureFromMemory(IDevice* device, ITexture* texture, const std::string& textureName, std::byte* data, size_t dataSize, Format format, bool forceSrgb, bool retainData)
+bool CreateDDSTextureFromMemory(IDevice* device, ITexture* texture, const std::string& textureName, std::byte* data, size_t dataSize, Format format, bool forceSrgb, bool retainData,
+	std::shared_ptr<const void> dataOwner)
 {
 	assert(device != nullptr);
 	assert(texture != nullptr);
@@ -527,7 +529,73 @@ bool CreateDDSTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 	}
 
 	const size_t maxSize = 0;
-	return CreateTextureFromDDS(device, texture, textureName, header, data + offset, dataSize - offset, maxSize, format, forceSrgb, retainData);
+	return CreateTextureFromDDS(device, texture, textureName, header, data + offset, dataSize - offset, maxSize, format, forceSrgb, retainData, std::move(dataOwner));
+}
+
+
+bool SaveDDSTextureToMemory(const TextureInitializer& texInit, std::vector<std::byte>& outData)
+{
+	if (texInit.dimension != TextureDimension::Texture2D ||
+		texInit.arraySizeOrDepth != 1 ||
+		texInit.subResourceData.size() != texInit.numMips)
+	{
+		return false;
+	}
+
+	const DXGI_FORMAT dxgiFormat = DX12::FormatToDxgi(texInit.format).srvFormat;
+	if (dxgiFormat == DXGI_FORMAT_UNKNOWN)
+	{
+		return false;
+	}
+
+	size_t numBlocksWide = 0;
+	GetSurfaceInfo(texInit.width, texInit.height, texInit.format, nullptr, nullptr, nullptr, &numBlocksWide, nullptr);
+	const bool isBlockCompressed = numBlocksWide != 0;
+
+	const auto& topLevel = texInit.subResourceData[0];
+
+	DDS_HEADER header{};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_MIPMAP | (isBlockCompressed ? DDS_HEADER_FLAGS_LINEARSIZE : DDS_HEADER_FLAGS_PITCH);
+	header.height = texInit.height;
+	header.width = (uint32_t)texInit.width;
+	header.pitchOrLinearSize = (uint32_t)(isBlockCompressed ? topLevel.slicePitch : topLevel.rowPitch);
+	header.depth = 1;
+	header.mipMapCount = texInit.numMips;
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.ddspf.flags = DDS_FOURCC;
+	header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE | (texInit.numMips > 1 ? DDS_SURFACE_FLAGS_MIPMAP : 0);
+
+	DDS_HEADER_DXT10 extHeader{};
+	extHeader.dxgiFormat = dxgiFormat;
+	extHeader.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	extHeader.arraySize = 1;
+
+	// Levels are written back to back, in the layout that FillTextureInitializer() expects
+	size_t dataSize = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+	for (const auto& subResourceData : texInit.subResourceData)
+	{
+		dataSize += subResourceData.slicePitch;
+	}
+
+	outData.resize(dataSize);
+	std::byte* dst = outData.data();
+
+	memcpy(dst, &DDS_MAGIC, sizeof(uint32_t));
+	dst += sizeof(uint32_t);
+	memcpy(dst, &header, sizeof(DDS_HEADER));
+	dst += sizeof(DDS_HEADER);
+	memcpy(dst, &extHeader, sizeof(DDS_HEADER_DXT10));
+	dst += sizeof(DDS_HEADER_DXT10);
+
+	for (const auto& subResourceData : texInit.subResourceData)
+	{
+		memcpy(dst, subResourceData.data, subResourceData.slicePitch);
+		dst += subResourceData.slicePitch;
+	}
+
+	return true;
 }
 
 } // namespace Luna
\ No newline at end of file
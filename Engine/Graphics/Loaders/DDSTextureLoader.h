@@ -19,6 +19,7 @@ namespace Luna
 // Forward declarations
 class IDevice;
 class ITexture;
+struct TextureInitializer;
 
 bool CreateDDSTextureFromMemory(
 	IDevice* device, 
@@ -28,7 +29,12 @@ bool CreateDDSTextureFromMemory(
 	size_t dataSize, 
 	Format format, 
 	bool forceSrgb,
-	bool retainData);
+	bool retainData,
+	std::shared_ptr<const void> dataOwner = nullptr);	// Keeps data alive, so retained data can point into it
+
+// Serializes a 2D texture with a single array slice as a DDS file, with the DX10 header, so that
+// CreateDDSTextureFromMemory() reads it back as is
+bool SaveDDSTextureToMemory(const TextureInitializer& texInit, std::vector<std::byte>& outData);
 
 // DDS texture log category
 inline LogCategory LogDDS{ "LogDDS" };
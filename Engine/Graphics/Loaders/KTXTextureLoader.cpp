@@ -132,6 +132,8 @@ bool CreateKTXTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 	assert(texture != nullptr);
 	assert(data != nullptr);
 
+	// libktx loads the image data into its own buffer, because KTX 1 files interleave image sizes with the levels,
+	// and KTX 2 levels may be supercompressed.  Retained data shares that buffer instead of copying it again.
 	ktxTexture* kTexture = nullptr;
 	auto result = ktxTexture_CreateFromMemory((const ktx_uint8_t*)data, dataSize, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &kTexture);
 	if (result != KTX_SUCCESS)
@@ -140,6 +142,8 @@ bool CreateKTXTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 		return false;
 	}
 
+	std::shared_ptr<ktxTexture> kTextureOwner(kTexture, [](ktxTexture* kTexture) { ktxTexture_Destroy(kTexture); });
+
 	const uint64_t width = kTexture->baseWidth;
 	const uint32_t height = kTexture->baseHeight;
 	const uint32_t depth = kTexture->baseDepth;
@@ -238,7 +242,7 @@ bool CreateKTXTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 	{
 		if (retainData)
 		{
-			texture->SetData(texInit.baseData, texInit.totalBytes);
+			texture->SetData(texInit.baseData, texInit.totalBytes, std::move(kTextureOwner));
 		}
 
 		return device->InitializeTexture(texture, texInit);
@@ -0,0 +1,536 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "ModelCache.h"
+
+#include "FileSystem.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Bump this whenever the layout below, or the way ModelLoader builds the streams, changes
+constexpr uint32_t s_modelCacheMagic = 0x4C444D4C; // 'LMDL'
+constexpr uint32_t s_modelCacheVersion = 4;
+constexpr uint64_t s_modelCacheAlignment = 16;
+
+
+struct FileRange
+{
+	uint64_t offset{ 0 };
+	uint64_t size{ 0 };
+};
+
+
+// The file starts with the header, tables, strings, mesh parts and LODs, which are covered by metadataHash, and
+// ends with the vertex and index streams, which are not
+struct FileHeader
+{
+	uint32_t magic{ s_modelCacheMagic };
+	uint32_t version{ s_modelCacheVersion };
+	uint64_t fileSize{ 0 };
+	uint64_t metadataSize{ 0 };
+	uint64_t metadataHash{ 0 };
+
+	// Copy of the key, verified in full on load
+	uint64_t sourceSize{ 0 };
+	uint64_t sourceWriteTime{ 0 };
+	uint32_t loadFlags{ 0 };
+	float scale{ 1.0f };
+	uint32_t components{ 0 };
+	uint32_t vertexStride{ 0 };
+	uint32_t loadMaterials{ 0 };
+	uint32_t numMeshes{ 0 };
+	uint32_t numMaterials{ 0 };
+	uint32_t encoding{ 0 };
+	FileRange sourcePath;
+
+	FileRange meshTable;
+	FileRange materialTable;
+};
+
+
+struct FileMesh
+{
+	FileRange name;
+	FileRange vertexData;
+	FileRange vertexDataPositionOnly;
+	FileRange indexData;
+	FileRange meshParts;
+	FileRange lods;
+	float boundsMin[3]{};
+	float boundsMax[3]{};
+	float positionScale[3]{};
+	float positionOffset[3]{};
+	float texcoordScaleOffset[4]{};
+	int32_t materialIndex{ -1 };
+	uint32_t vertexStride{ 0 };
+	uint32_t indexSize{ 0 };
+	uint32_t padding{ 0 };
+};
+
+
+struct FileMaterial
+{
+	float diffuseColor[4]{};
+	FileRange diffuseTexture;
+	FileRange normalTexture;
+};
+
+
+static_assert(is_trivially_copyable_v<Luna::MeshPart>);
+
+// The hash starts after the fields that hold it, and runs to the end of the metadata
+constexpr size_t s_metadataHashOffset = offsetof(FileHeader, sourceSize);
+
+
+uint64_t HashMetadata(span<const std::byte> data, uint64_t metadataSize)
+{
+	return Utility::HashStable(data.data() + s_metadataHashOffset, (size_t)metadataSize - s_metadataHashOffset);
+}
+
+
+// Every index a mesh part draws has to name a vertex in the buffer, or the GPU reads past the end of it
+template <typename TIndex>
+bool AreIndicesInRange(span<const std::byte> indexData, const Luna::MeshPart& meshPart, uint64_t numVertices)
+{
+	const TIndex* indices = (const TIndex*)indexData.data() + meshPart.indexBase;
+	for (uint32_t i = 0; i < meshPart.indexCount; ++i)
+	{
+		if ((uint64_t)meshPart.vertexBase + indices[i] >= numVertices)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Checks that the LODs and mesh parts stay inside the mesh's streams.  That is one test per part, but checking
+// the indices themselves reads the whole index stream, so it is only done when asked.
+bool AreMeshPartsValid(const Luna::CookedMesh& mesh, bool checkIndices)
+{
+	for (const Luna::CookedMeshLod& lod : mesh.lods)
+	{
+		if ((size_t)lod.meshPartOffset + lod.meshPartCount > mesh.meshParts.size())
+		{
+			return false;
+		}
+	}
+
+	const uint64_t numVertices = mesh.vertexData.size() / mesh.vertexStride;
+	const uint64_t numIndices = mesh.indexData.size() / mesh.indexSize;
+
+	for (const Luna::MeshPart& meshPart : mesh.meshParts)
+	{
+		if ((uint64_t)meshPart.indexBase + meshPart.indexCount > numIndices)
+		{
+			return false;
+		}
+
+		if (checkIndices)
+		{
+			const bool indicesInRange = (mesh.indexSize == sizeof(uint16_t))
+				? AreIndicesInRange<uint16_t>(mesh.indexData, meshPart, numVertices)
+				: AreIndicesInRange<uint32_t>(mesh.indexData, meshPart, numVertices);
+
+			if (!indicesInRange)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+class CacheWriter
+{
+public:
+	template <typename T>
+	FileRange Reserve(size_t count = 1)
+	{
+		return Append(nullptr, sizeof(T) * count);
+	}
+
+	FileRange Append(const void* data, size_t size)
+	{
+		const uint64_t offset = Math::AlignUp(m_data.size(), s_modelCacheAlignment);
+		m_data.resize(offset + size);
+		if (data != nullptr && size > 0)
+		{
+			memcpy(m_data.data() + offset, data, size);
+		}
+		return { offset, size };
+	}
+
+	FileRange Append(span<const std::byte> data) { return Append(data.data(), data.size()); }
+	FileRange Append(string_view str) { return Append(str.data(), str.size()); }
+
+	template <typename T>
+	T* Get(FileRange range, size_t index = 0) { return (T*)(m_data.data() + range.offset) + index; }
+
+	uint64_t GetSize() const { return m_data.size(); }
+	vector<std::byte>& GetData() { return m_data; }
+
+private:
+	vector<std::byte> m_data;
+};
+
+
+class CacheReader
+{
+public:
+	explicit CacheReader(span<const std::byte> data) : m_data{ data } {}
+
+	bool IsValid(FileRange range, size_t alignment = 1) const
+	{
+		return range.offset <= m_data.size() &&
+			range.size <= m_data.size() - range.offset &&
+			(range.offset % alignment) == 0;
+	}
+
+	template <typename T>
+	span<const T> GetArray(FileRange range) const
+	{
+		return { (const T*)(m_data.data() + range.offset), (size_t)(range.size / sizeof(T)) };
+	}
+
+	span<const std::byte> GetBytes(FileRange range) const { return m_data.subspan(range.offset, range.size); }
+	string_view GetString(FileRange range) const { return { (const char*)(m_data.data() + range.offset), (size_t)range.size }; }
+
+private:
+	span<const std::byte> m_data;
+};
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+uint64_t ModelCacheKey::GetHash() const
+{
+	uint64_t hash = Utility::HashStable(sourcePath.data(), sourcePath.size());
+	hash = Utility::HashStableValue(sourceSize, hash);
+	hash = Utility::HashStableValue(sourceWriteTime, hash);
+	hash = Utility::HashStableValue(loadFlags, hash);
+	hash = Utility::HashStableValue(scale, hash);
+	hash = Utility::HashStableValue(components, hash);
+	hash = Utility::HashStableValue(encoding, hash);
+	hash = Utility::HashStableValue(vertexStride, hash);
+	hash = Utility::HashStableValue(loadMaterials, hash);
+	return Utility::HashStableValue(s_modelCacheVersion, hash);
+}
+
+
+bool MakeModelCacheKey(const string& sourcePath, const VertexLayoutBase& layout, float scale, ModelLoad loadFlags, bool loadMaterials, ModelCacheKey& outKey)
+{
+	error_code ec;
+
+	const uint64_t sourceSize = (uint64_t)filesystem::file_size(sourcePath, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	const auto sourceWriteTime = filesystem::last_write_time(sourcePath, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	outKey.sourcePath = sourcePath;
+	outKey.sourceSize = sourceSize;
+	outKey.sourceWriteTime = (uint64_t)sourceWriteTime.time_since_epoch().count();
+	outKey.loadFlags = loadFlags;
+	outKey.scale = scale;
+	outKey.components = layout.GetComponents();
+	outKey.encoding = layout.GetEncoding();
+	outKey.vertexStride = layout.GetSizeInBytes();
+	outKey.loadMaterials = loadMaterials;
+
+	return true;
+}
+
+
+string GetModelCacheFilename(const ModelCacheKey& key)
+{
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)key.GetHash());
+
+	const string stem = filesystem::path{ key.sourcePath }.stem().string();
+	const filesystem::path filename = stem + "." + hashText + ".lmc";
+
+	return (GetFileSystem()->GetCachePath() / filename).string();
+}
+
+
+bool BuildModelCache(const ModelCacheKey& key, const CookedModel& model, vector<std::byte>& outData)
+{
+	for (const CookedMesh& mesh : model.meshes)
+	{
+		if (mesh.vertexStride == 0 ||
+			(mesh.indexSize != sizeof(uint16_t) && mesh.indexSize != sizeof(uint32_t)) ||
+			!AreMeshPartsValid(mesh, true))
+		{
+			return false;
+		}
+	}
+
+	CacheWriter writer;
+
+	const FileRange headerRange = writer.Reserve<FileHeader>();
+	const FileRange meshTable = writer.Reserve<FileMesh>(model.meshes.size());
+	const FileRange materialTable = writer.Reserve<FileMaterial>(model.materials.size());
+	const FileRange sourcePath = writer.Append(key.sourcePath);
+
+	// Metadata first, so that the hashed part of the file is one range
+	vector<FileMesh> fileMeshes(model.meshes.size());
+	for (size_t i = 0; i < model.meshes.size(); ++i)
+	{
+		const CookedMesh& mesh = model.meshes[i];
+		FileMesh& fileMesh = fileMeshes[i];
+
+		fileMesh.name = writer.Append(mesh.name);
+		fileMesh.meshParts = writer.Append(as_bytes(mesh.meshParts));
+		fileMesh.lods = writer.Append(as_bytes(mesh.lods));
+
+		memcpy(fileMesh.boundsMin, mesh.boundsMin, sizeof(fileMesh.boundsMin));
+		memcpy(fileMesh.boundsMax, mesh.boundsMax, sizeof(fileMesh.boundsMax));
+		memcpy(fileMesh.positionScale, mesh.decodeParams.positionScale, sizeof(fileMesh.positionScale));
+		memcpy(fileMesh.positionOffset, mesh.decodeParams.positionOffset, sizeof(fileMesh.positionOffset));
+		memcpy(fileMesh.texcoordScaleOffset, mesh.decodeParams.texcoordScaleOffset, sizeof(fileMesh.texcoordScaleOffset));
+
+		fileMesh.materialIndex = mesh.materialIndex;
+		fileMesh.vertexStride = mesh.vertexStride;
+		fileMesh.indexSize = mesh.indexSize;
+	}
+
+	for (size_t i = 0; i < model.materials.size(); ++i)
+	{
+		const CookedMaterial& material = model.materials[i];
+
+		FileMaterial fileMaterial{};
+		memcpy(fileMaterial.diffuseColor, material.diffuseColor, sizeof(fileMaterial.diffuseColor));
+		fileMaterial.diffuseTexture = writer.Append(material.diffuseTexture);
+		fileMaterial.normalTexture = writer.Append(material.normalTexture);
+
+		// Appending may have reallocated, so look up the table entry afresh
+		*writer.Get<FileMaterial>(materialTable, i) = fileMaterial;
+	}
+
+	const uint64_t metadataSize = writer.GetSize();
+
+	for (size_t i = 0; i < model.meshes.size(); ++i)
+	{
+		const CookedMesh& mesh = model.meshes[i];
+		FileMesh& fileMesh = fileMeshes[i];
+
+		fileMesh.vertexData = writer.Append(mesh.vertexData);
+		fileMesh.vertexDataPositionOnly = writer.Append(mesh.vertexDataPositionOnly);
+		fileMesh.indexData = writer.Append(mesh.indexData);
+
+		*writer.Get<FileMesh>(meshTable, i) = fileMesh;
+	}
+
+	FileHeader& header = *writer.Get<FileHeader>(headerRange);
+	header = FileHeader{};
+	header.fileSize = writer.GetSize();
+	header.metadataSize = metadataSize;
+	header.sourceSize = key.sourceSize;
+	header.sourceWriteTime = key.sourceWriteTime;
+	header.loadFlags = (uint32_t)key.loadFlags;
+	header.scale = key.scale;
+	header.components = (uint32_t)key.components;
+	header.encoding = (uint32_t)key.encoding;
+	header.vertexStride = key.vertexStride;
+	header.loadMaterials = key.loadMaterials ? 1 : 0;
+	header.numMeshes = (uint32_t)model.meshes.size();
+	header.numMaterials = (uint32_t)model.materials.size();
+	header.sourcePath = sourcePath;
+	header.meshTable = meshTable;
+	header.materialTable = materialTable;
+	header.metadataHash = HashMetadata(writer.GetData(), metadataSize);
+
+	outData = move(writer.GetData());
+	return true;
+}
+
+
+bool WriteModelCache(const string& cacheFilename, const ModelCacheKey& key, const CookedModel& model)
+{
+	vector<std::byte> data;
+	if (!BuildModelCache(key, model, data))
+	{
+		return false;
+	}
+
+	auto fileSystem = GetFileSystem();
+	if (!fileSystem->EnsureCacheDirectory())
+	{
+		return false;
+	}
+
+	return FileSystem::WriteFileAtomic(cacheFilename, data);
+}
+
+
+bool ReadModelCache(span<const std::byte> data, const ModelCacheKey& key, ModelCacheValidation validation, CookedModel& outModel)
+{
+	if (data.size() < sizeof(FileHeader))
+	{
+		return false;
+	}
+
+	CacheReader reader{ data };
+
+	const FileHeader& header = *(const FileHeader*)data.data();
+	if (header.magic != s_modelCacheMagic ||
+		header.version != s_modelCacheVersion ||
+		header.fileSize != data.size() ||
+		header.metadataSize < sizeof(FileHeader) ||
+		header.metadataSize > data.size())
+	{
+		return false;
+	}
+
+	if (header.metadataHash != HashMetadata(data, header.metadataSize))
+	{
+		return false;
+	}
+
+	if (header.sourceSize != key.sourceSize ||
+		header.sourceWriteTime != key.sourceWriteTime ||
+		header.loadFlags != (uint32_t)key.loadFlags ||
+		header.scale != key.scale ||
+		header.components != (uint32_t)key.components ||
+		header.encoding != (uint32_t)key.encoding ||
+		header.vertexStride != key.vertexStride ||
+		header.loadMaterials != (key.loadMaterials ? 1u : 0u))
+	{
+		return false;
+	}
+
+	if (!reader.IsValid(header.sourcePath) || reader.GetString(header.sourcePath) != key.sourcePath)
+	{
+		return false;
+	}
+
+	if (!reader.IsValid(header.meshTable, alignof(FileMesh)) ||
+		header.meshTable.size != sizeof(FileMesh) * header.numMeshes ||
+		!reader.IsValid(header.materialTable, alignof(FileMaterial)) ||
+		header.materialTable.size != sizeof(FileMaterial) * header.numMaterials)
+	{
+		return false;
+	}
+
+	const uint32_t positionStride = GetVertexComponentSizeInBytes(VertexComponent::Position, key.encoding);
+
+	CookedModel model;
+
+	auto fileMeshes = reader.GetArray<FileMesh>(header.meshTable);
+	model.meshes.reserve(fileMeshes.size());
+
+	for (const FileMesh& fileMesh : fileMeshes)
+	{
+		if (!reader.IsValid(fileMesh.name) ||
+			!reader.IsValid(fileMesh.vertexData) ||
+			!reader.IsValid(fileMesh.vertexDataPositionOnly) ||
+			!reader.IsValid(fileMesh.indexData) ||
+			!reader.IsValid(fileMesh.meshParts, alignof(MeshPart)) ||
+			(fileMesh.meshParts.size % sizeof(MeshPart)) != 0 ||
+			!reader.IsValid(fileMesh.lods, alignof(CookedMeshLod)) ||
+			(fileMesh.lods.size % sizeof(CookedMeshLod)) != 0 ||
+			(fileMesh.indexSize != sizeof(uint16_t) && fileMesh.indexSize != sizeof(uint32_t)) ||
+			fileMesh.materialIndex >= (int32_t)header.numMaterials)
+		{
+			return false;
+		}
+
+		// The streams have to match the vertex layout the caller asked for, and hold whole vertices and indices
+		if (fileMesh.vertexStride == 0 ||
+			fileMesh.vertexStride != header.vertexStride ||
+			(fileMesh.vertexData.size % fileMesh.vertexStride) != 0 ||
+			fileMesh.vertexDataPositionOnly.size != (fileMesh.vertexData.size / fileMesh.vertexStride) * positionStride ||
+			!reader.IsValid(fileMesh.indexData, fileMesh.indexSize) ||
+			(fileMesh.indexData.size % fileMesh.indexSize) != 0)
+		{
+			return false;
+		}
+
+		CookedMesh mesh{
+			.name					= reader.GetString(fileMesh.name),
+			.materialIndex			= fileMesh.materialIndex,
+			.vertexStride			= fileMesh.vertexStride,
+			.indexSize				= fileMesh.indexSize,
+			.vertexData				= reader.GetBytes(fileMesh.vertexData),
+			.vertexDataPositionOnly = reader.GetBytes(fileMesh.vertexDataPositionOnly),
+			.indexData				= reader.GetBytes(fileMesh.indexData),
+			.meshParts				= reader.GetArray<MeshPart>(fileMesh.meshParts),
+			.lods					= reader.GetArray<CookedMeshLod>(fileMesh.lods)
+		};
+
+		memcpy(mesh.boundsMin, fileMesh.boundsMin, sizeof(mesh.boundsMin));
+		memcpy(mesh.boundsMax, fileMesh.boundsMax, sizeof(mesh.boundsMax));
+		memcpy(mesh.decodeParams.positionScale, fileMesh.positionScale, sizeof(mesh.decodeParams.positionScale));
+		memcpy(mesh.decodeParams.positionOffset, fileMesh.positionOffset, sizeof(mesh.decodeParams.positionOffset));
+		memcpy(mesh.decodeParams.texcoordScaleOffset, fileMesh.texcoordScaleOffset, sizeof(mesh.decodeParams.texcoordScaleOffset));
+
+		// The writer checked every index, and the streams are not covered by the hash, so only a full validation
+		// reads them again
+		if (!AreMeshPartsValid(mesh, validation == ModelCacheValidation::Full))
+		{
+			return false;
+		}
+
+		model.meshes.push_back(mesh);
+	}
+
+	auto fileMaterials = reader.GetArray<FileMaterial>(header.materialTable);
+	model.materials.reserve(fileMaterials.size());
+
+	for (const FileMaterial& fileMaterial : fileMaterials)
+	{
+		if (!reader.IsValid(fileMaterial.diffuseTexture) || !reader.IsValid(fileMaterial.normalTexture))
+		{
+			return false;
+		}
+
+		CookedMaterial material{
+			.diffuseTexture = reader.GetString(fileMaterial.diffuseTexture),
+			.normalTexture	= reader.GetString(fileMaterial.normalTexture)
+		};
+		memcpy(material.diffuseColor, fileMaterial.diffuseColor, sizeof(material.diffuseColor));
+		model.materials.push_back(material);
+	}
+
+	outModel = move(model);
+	return true;
+}
+
+
+bool ReadModelCache(const MappedFile& cacheFile, const ModelCacheKey& key, ModelCacheValidation validation, CookedModel& outModel)
+{
+	if (!cacheFile.IsOpen())
+	{
+		return false;
+	}
+
+	return ReadModelCache(cacheFile.GetSpan(), key, validation, outModel);
+}
+
+} // namespace Luna
@@ -0,0 +1,110 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics/InputLayout.h"
+#include "Graphics/ModelTypes.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+class MappedFile;
+
+
+// A level of detail, as a range of CookedMesh::meshParts
+struct CookedMeshLod
+{
+	uint32_t meshPartOffset{ 0 };
+	uint32_t meshPartCount{ 0 };
+	float error{ 0.0f };
+	uint32_t padding{ 0 };
+};
+
+
+// Final vertex and index streams for one mesh, exactly as they are uploaded to the GPU.  The spans either
+// point into the ModelLoader's working data, or straight into a mapped cache file.  Bounds are plain floats, so the
+// cache builds without DirectXMath.
+struct CookedMesh
+{
+	std::string_view name;
+	int materialIndex{ -1 };
+	uint32_t vertexStride{ 0 };
+	uint32_t indexSize{ 0 };
+	std::span<const std::byte> vertexData;
+	std::span<const std::byte> vertexDataPositionOnly;
+	std::span<const std::byte> indexData;
+	std::span<const MeshPart> meshParts;
+	std::span<const CookedMeshLod> lods;	// Empty without LODs, in which case meshParts is all of LOD 0
+	float boundsMin[3]{ 0.0f, 0.0f, 0.0f };
+	float boundsMax[3]{ 0.0f, 0.0f, 0.0f };
+	VertexDecodeParams decodeParams{};
+};
+
+
+struct CookedMaterial
+{
+	float diffuseColor[4]{ 0.0f, 0.0f, 0.0f, 1.0f };
+	std::string_view diffuseTexture;
+	std::string_view normalTexture;
+};
+
+
+struct CookedModel
+{
+	std::vector<CookedMesh> meshes;
+	std::vector<CookedMaterial> materials;
+};
+
+
+// Everything that determines the cooked output of a model: the source file (including its size and
+// timestamp, so edits invalidate the cache), and each ModelLoader parameter that changes the streams
+struct ModelCacheKey
+{
+	std::string sourcePath;
+	uint64_t sourceSize{ 0 };
+	uint64_t sourceWriteTime{ 0 };
+	ModelLoad loadFlags{ ModelLoad::StandardDefault };
+	float scale{ 1.0f };
+	VertexComponent components{ VertexComponent::None };
+	VertexEncoding encoding{ VertexEncoding::None };
+	uint32_t vertexStride{ 0 };
+	bool loadMaterials{ false };
+
+	uint64_t GetHash() const;
+};
+
+
+bool MakeModelCacheKey(const std::string& sourcePath, const VertexLayoutBase& layout, float scale, ModelLoad loadFlags, bool loadMaterials, ModelCacheKey& outKey);
+std::string GetModelCacheFilename(const ModelCacheKey& key);
+
+// How much of a cache file ReadModelCache checks.  Header checks the key, the file size, a checksum of everything
+// but the vertex and index streams, and every range and stride, which costs the same however large the model is.
+// Full also checks every index against its vertex buffer, which reads the whole index stream.
+enum class ModelCacheValidation
+{
+	Header,
+	Full
+};
+
+
+// Serializes the model to a byte image of a cache file.  Fails if a mesh part reaches outside its streams, or an
+// index outside its vertex buffer, so that every file written holds indices in range.
+bool BuildModelCache(const ModelCacheKey& key, const CookedModel& model, std::vector<std::byte>& outData);
+bool WriteModelCache(const std::string& cacheFilename, const ModelCacheKey& key, const CookedModel& model);
+
+// Validates the bytes of a cache file against the key and fills in outModel, so a truncated, corrupt or stale file
+// is rejected rather than uploaded.  The spans in outModel point into data, so it must outlive them.
+bool ReadModelCache(std::span<const std::byte> data, const ModelCacheKey& key, ModelCacheValidation validation, CookedModel& outModel);
+bool ReadModelCache(const MappedFile& cacheFile, const ModelCacheKey& key, ModelCacheValidation validation, CookedModel& outModel);
+
+} // namespace Luna
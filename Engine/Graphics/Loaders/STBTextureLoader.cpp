@@ -12,7 +12,11 @@
 
 #include "STBTextureLoader.h"
 
+#include "DDSTextureLoader.h"
+
+#include "Graphics\BlockCompressor.h"
 #include "Graphics\Device.h"
+#include "Graphics\MipGenerator.h"
 #include "Graphics\Texture.h"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -40,12 +44,16 @@ bool CreateSTBTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 			}
 		});
 
+	if (!stbi_info_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents))
+	{
+		LogWarning(LogSTB) << "Unable to load image data from file " << textureName << std::endl;
+		return false;
+	}
+
 	Format fileFormat = Format::Unknown;
 
 	if (isHDR)
 	{
-		imageData = (std::byte*)stbi_loadf_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents, 4);
-
 		switch (numComponents)
 		{
 		case 1: fileFormat = Format::R32_Float; break;
@@ -56,8 +64,6 @@ bool CreateSTBTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 	}
 	else if (is16Bit)
 	{
-		imageData = (std::byte*)stbi_load_16_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents, 4);
-
 		switch (numComponents)
 		{
 		case 1: fileFormat = Format::R16_UNorm; break;
@@ -68,8 +74,6 @@ bool CreateSTBTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 	}
 	else
 	{
-		imageData = (std::byte*)stbi_load_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents, 4);
-
 		switch (numComponents)
 		{
 		case 1: fileFormat = Format::R8_UNorm; break;
@@ -84,46 +88,84 @@ bool CreateSTBTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 		format = fileFormat;
 	}
 
+	if (forceSrgb)
+	{
+		format = MakeSrgb(format);
+	}
+
 	if (format == Format::Unknown)
 	{
 		LogWarning(LogSTB) << "File " << textureName << " has unknown format" << std::endl;
 		return false;
 	}
 
+	// Expand or drop channels so that the image data matches the texture format's texel layout
+	const uint32_t bitsPerComponent = isHDR ? 32 : (is16Bit ? 16 : 8);
+	const int desiredComponents = std::clamp((int)(BitsPerPixel(format) / bitsPerComponent), 1, 4);
+
+	if (isHDR)
+	{
+		imageData = (std::byte*)stbi_loadf_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents, desiredComponents);
+	}
+	else if (is16Bit)
+	{
+		imageData = (std::byte*)stbi_load_16_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents, desiredComponents);
+	}
+	else
+	{
+		imageData = (std::byte*)stbi_load_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents, desiredComponents);
+	}
+
 	if (imageData == nullptr)
 	{
 		LogWarning(LogSTB) << "Unable to load image data from file " << textureName << std::endl;
 		return false;
 	}
 
-	TextureInitializer texInit{
+	// Build the full mip chain.  Lanczos rings around bright HDR texels, so float images use the box filter.
+	MipGenerationDesc mipDesc{
 		.format				= format,
-		.dimension			= TextureDimension::Texture2D,
 		.width				= (uint32_t)width,
 		.height				= (uint32_t)height,
-		.arraySizeOrDepth	= 1,
-		.numMips			= 1,
-		.baseData			= imageData,
-		.totalBytes			= width * height * BitsPerPixel(format) / 8
+		.filter				= isHDR ? MipFilter::Box : MipFilter::Lanczos
 	};
 
-	size_t numBytes = 0;
-	size_t rowBytes = 0;
-	GetSurfaceInfo(width, height, format, &numBytes, &rowBytes, nullptr, nullptr, nullptr);
-
-	TextureSubresourceData subResourceData{
-		.data				= imageData,
-		.rowPitch			= rowBytes,
-		.slicePitch			= numBytes,
-		.bufferOffset		= 0,
-		.mipLevel			= 0,
-		.baseArrayLayer		= 0,
-		.layerCount			= 1,
-		.width				= (uint32_t)width,
-		.height				= (uint32_t)height,
-		.depth				= 1
-	};
-	texInit.subResourceData.push_back(subResourceData);
+	std::vector<std::byte> mipData;
+	TextureInitializer texInit;
+
+	if (!GenerateMipChain(mipDesc, imageData, mipData, texInit))
+	{
+		LogWarning(LogSTB) << "Unable to generate mips for file " << textureName << ", loading the top level only" << std::endl;
+
+		texInit = TextureInitializer{
+			.format				= format,
+			.dimension			= TextureDimension::Texture2D,
+			.width				= (uint32_t)width,
+			.height				= (uint32_t)height,
+			.arraySizeOrDepth	= 1,
+			.numMips			= 1,
+			.baseData			= imageData,
+			.totalBytes			= width * height * BitsPerPixel(format) / 8
+		};
+
+		size_t numBytes = 0;
+		size_t rowBytes = 0;
+		GetSurfaceInfo(width, height, format, &numBytes, &rowBytes, nullptr, nullptr, nullptr);
+
+		TextureSubresourceData subResourceData{
+			.data				= imageData,
+			.rowPitch			= rowBytes,
+			.slicePitch			= numBytes,
+			.bufferOffset		= 0,
+			.mipLevel			= 0,
+			.baseArrayLayer		= 0,
+			.layerCount			= 1,
+			.width				= (uint32_t)width,
+			.height				= (uint32_t)height,
+			.depth				= 1
+		};
+		texInit.subResourceData.push_back(subResourceData);
+	}
 
 	if (retainData)
 	{
@@ -133,4 +175,76 @@ bool CreateSTBTextureFromMemory(IDevice* device, ITexture* texture, const std::s
 	return device->InitializeTexture(texture, texInit);
 }
 
+
+bool CompressSTBTextureToDDS(const std::string& textureName, std::byte* data, size_t dataSize, TextureUsage usage, bool forceSrgb, std::vector<std::byte>& outDdsData)
+{
+	if (usage == TextureUsage::Default || stbi_is_hdr_from_memory((const stbi_uc*)data, (int)dataSize))
+	{
+		return false;
+	}
+
+	int width = 0;
+	int height = 0;
+	int numComponents = 0;
+
+	// 16-bit images are narrowed to 8 bits, which is all that the block formats hold anyway
+	std::byte* imageData = (std::byte*)stbi_load_from_memory((const stbi_uc*)data, (int)dataSize, &width, &height, &numComponents, 4);
+	if (imageData == nullptr)
+	{
+		LogWarning(LogSTB) << "Unable to load image data from file " << textureName << std::endl;
+		return false;
+	}
+
+	auto exitGuard = wil::scope_exit([&]()
+		{
+			stbi_image_free(imageData);
+		});
+
+	bool hasTranslucency = false;
+	if (numComponents == 2 || numComponents == 4)
+	{
+		const size_t numBytes = (size_t)width * height * 4;
+		for (size_t i = 3; i < numBytes && !hasTranslucency; i += 4)
+		{
+			hasTranslucency = imageData[i] != std::byte{ 0xFF };
+		}
+	}
+
+	const Format compressedFormat = GetBlockCompressedFormat(usage, hasTranslucency, forceSrgb);
+
+	MipGenerationDesc mipDesc{
+		.format				= forceSrgb ? Format::SRGBA8_UNorm : Format::RGBA8_UNorm,
+		.width				= (uint32_t)width,
+		.height				= (uint32_t)height,
+		.filter				= MipFilter::Lanczos
+	};
+
+	std::vector<std::byte> mipData;
+	TextureInitializer mipInit;
+
+	if (!GenerateMipChain(mipDesc, imageData, mipData, mipInit))
+	{
+		LogWarning(LogSTB) << "Unable to generate mips for file " << textureName << std::endl;
+		return false;
+	}
+
+	BlockCompressionDesc compressionDesc{ .format = compressedFormat };
+	BlockCompressionStats stats;
+
+	std::vector<std::byte> compressedData;
+	TextureInitializer compressedInit;
+
+	if (!CompressTexture(compressionDesc, mipInit, compressedData, compressedInit, &stats))
+	{
+		LogWarning(LogSTB) << "Unable to block-compress file " << textureName << std::endl;
+		return false;
+	}
+
+	LogInfo(LogSTB) << std::format("{}: {}x{}, {} mips, {} as {} ({} -> {} bytes), PSNR {:.2f} dB, {:.1f} MPix/s",
+		textureName, width, height, compressedInit.numMips, GetTextureUsageName(usage), GetBlockCompressedFormatName(compressedFormat),
+		mipInit.totalBytes, compressedInit.totalBytes, stats.psnr, stats.GetMegapixelsPerSecond()) << std::endl;
+
+	return SaveDDSTextureToMemory(compressedInit, outDdsData);
+}
+
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "Graphics\BlockCompressor.h"
 #include "Graphics\GraphicsCommon.h"
 
 
@@ -21,6 +22,10 @@ class ITexture;
 
 bool CreateSTBTextureFromMemory(IDevice* device, ITexture* texture, const std::string& textureName, std::byte* data, size_t dataSize, Format format, bool forceSrgb, bool retainData);
 
+// Decodes an image to RGBA8, builds its mip chain, and block-compresses every level in the format that usage
+// picks.  The result is a complete DDS file.  Fails for TextureUsage::Default and for HDR images.
+bool CompressSTBTextureToDDS(const std::string& textureName, std::byte* data, size_t dataSize, TextureUsage usage, bool forceSrgb, std::vector<std::byte>& outDdsData);
+
 // STB texture log category
 inline LogCategory LogSTB{ "LogSTB" };
 
@@ -0,0 +1,92 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "TextureCache.h"
+
+#include "FileSystem.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Bump this whenever the encoder's output changes, so that stale textures are rebuilt
+constexpr uint32_t s_textureCacheVersion = 1;
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+uint64_t TextureCacheKey::GetHash() const
+{
+	uint64_t hash = Utility::HashStable(sourcePath.data(), sourcePath.size());
+	hash = Utility::HashStableValue(sourceSize, hash);
+	hash = Utility::HashStableValue(sourceWriteTime, hash);
+	hash = Utility::HashStableValue(usage, hash);
+	hash = Utility::HashStableValue(forceSrgb, hash);
+	return Utility::HashStableValue(s_textureCacheVersion, hash);
+}
+
+
+bool MakeTextureCacheKey(const string& sourcePath, TextureUsage usage, bool forceSrgb, TextureCacheKey& outKey)
+{
+	error_code ec;
+
+	const uint64_t sourceSize = (uint64_t)filesystem::file_size(sourcePath, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	const auto sourceWriteTime = filesystem::last_write_time(sourcePath, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	outKey.sourcePath = sourcePath;
+	outKey.sourceSize = sourceSize;
+	outKey.sourceWriteTime = (uint64_t)sourceWriteTime.time_since_epoch().count();
+	outKey.usage = usage;
+	outKey.forceSrgb = forceSrgb;
+
+	return true;
+}
+
+
+string GetTextureCacheFilename(const TextureCacheKey& key)
+{
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)key.GetHash());
+
+	const string stem = filesystem::path{ key.sourcePath }.stem().string();
+	const filesystem::path filename = stem + "." + hashText + ".dds";
+
+	return (GetFileSystem()->GetCachePath() / filename).string();
+}
+
+
+bool WriteTextureCache(const string& cacheFilename, span<const std::byte> ddsData)
+{
+	auto fileSystem = GetFileSystem();
+	if (!fileSystem->EnsureCacheDirectory())
+	{
+		return false;
+	}
+
+	return FileSystem::WriteFileAtomic(cacheFilename, ddsData);
+}
+
+} // namespace Luna
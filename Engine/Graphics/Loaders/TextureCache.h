@@ -0,0 +1,40 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics/BlockCompressor.h"
+
+
+namespace Luna
+{
+
+// Everything that determines a block-compressed texture: the source file (including its size and timestamp,
+// so edits invalidate the cache), and the load parameters that pick the format
+struct TextureCacheKey
+{
+	std::string sourcePath;
+	uint64_t sourceSize{ 0 };
+	uint64_t sourceWriteTime{ 0 };
+	TextureUsage usage{ TextureUsage::Default };
+	bool forceSrgb{ false };
+
+	uint64_t GetHash() const;
+};
+
+
+bool MakeTextureCacheKey(const std::string& sourcePath, TextureUsage usage, bool forceSrgb, TextureCacheKey& outKey);
+
+// A .dds file in the cache directory, so the cached texture loads through CreateDDSTextureFromMemory()
+std::string GetTextureCacheFilename(const TextureCacheKey& key);
+
+bool WriteTextureCache(const std::string& cacheFilename, std::span<const std::byte> ddsData);
+
+} // namespace Luna
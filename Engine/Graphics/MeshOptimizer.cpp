@@ -0,0 +1,724 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "MeshOptimizer.h"
+
+using namespace std;
+
+
+namespace
+{
+
+constexpr uint32_t s_invalidIndex = ~0u;
+
+// Forsyth's scoring constants, from "Linear-Speed Vertex Cache Optimisation"
+constexpr uint32_t s_forsythCacheSize = 32;
+constexpr float s_forsythCacheDecayPower = 1.5f;
+constexpr float s_forsythLastTriangleScore = 0.75f;
+constexpr float s_forsythValenceBoostScale = 2.0f;
+constexpr float s_forsythValenceBoostPower = 0.5f;
+constexpr uint32_t s_forsythMaxValence = 32;
+
+// Cache size used to split the cache-optimized order into clusters for overdraw sorting
+constexpr uint32_t s_overdrawCacheSize = 16;
+
+// Resolution of each of the six views rasterized by the overdraw analysis
+constexpr int32_t s_overdrawGridSize = 256;
+
+
+class ForsythScoreTable
+{
+public:
+	ForsythScoreTable()
+	{
+		for (uint32_t i = 0; i < s_forsythCacheSize; ++i)
+		{
+			if (i < 3)
+			{
+				// The last triangle's vertices get a fixed score, so that the very next triangle doesn't just reuse them
+				m_cacheScores[i] = s_forsythLastTriangleScore;
+			}
+			else
+			{
+				const float scale = 1.0f / (float)(s_forsythCacheSize - 3);
+				m_cacheScores[i] = powf(1.0f - (float)(i - 3) * scale, s_forsythCacheDecayPower);
+			}
+		}
+
+		m_valenceScores[0] = 0.0f;
+		for (uint32_t i = 1; i <= s_forsythMaxValence; ++i)
+		{
+			m_valenceScores[i] = s_forsythValenceBoostScale * powf((float)i, -s_forsythValenceBoostPower);
+		}
+	}
+
+	// Vertices with few triangles left get a boost, to finish them off and avoid leaving lone triangles behind
+	float GetScore(uint32_t cachePosition, uint32_t numLiveTriangles) const
+	{
+		if (numLiveTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		const float cacheScore = cachePosition < s_forsythCacheSize ? m_cacheScores[cachePosition] : 0.0f;
+		return cacheScore + m_valenceScores[min(numLiveTriangles, s_forsythMaxValence)];
+	}
+
+private:
+	float m_cacheScores[s_forsythCacheSize];
+	float m_valenceScores[s_forsythMaxValence + 1];
+};
+
+
+// FIFO cache simulation, with each vertex's insertion time standing in for its cache slot
+class FifoCache
+{
+public:
+	FifoCache(uint32_t numVertices, uint32_t cacheSize)
+		: m_insertTimes(numVertices, 0)
+		, m_cacheSize{ cacheSize }
+		, m_time{ cacheSize + 1 }
+	{}
+
+	// Returns true for a cache miss
+	bool Access(uint32_t vertex)
+	{
+		if (m_time - m_insertTimes[vertex] > m_cacheSize)
+		{
+			m_insertTimes[vertex] = m_time++;
+			return true;
+		}
+
+		return false;
+	}
+
+	uint32_t AccessTriangle(const uint32_t* triangle)
+	{
+		return (Access(triangle[0]) ? 1 : 0) + (Access(triangle[1]) ? 1 : 0) + (Access(triangle[2]) ? 1 : 0);
+	}
+
+	void Flush()
+	{
+		m_time += m_cacheSize + 1;
+	}
+
+private:
+	vector<uint32_t> m_insertTimes;
+	const uint32_t m_cacheSize;
+	uint32_t m_time;
+};
+
+
+// Plain float math, so that meshes optimize without DirectXMath in the headless tests
+struct Float3
+{
+	float x{ 0.0f };
+	float y{ 0.0f };
+	float z{ 0.0f };
+};
+
+
+Float3 operator+(const Float3& a, const Float3& b) { return Float3{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+Float3 operator-(const Float3& a, const Float3& b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+Float3 operator*(const Float3& a, float s) { return Float3{ a.x * s, a.y * s, a.z * s }; }
+
+
+float Dot(const Float3& a, const Float3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+Float3 Cross(const Float3& a, const Float3& b)
+{
+	return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+
+Float3 Normalize(const Float3& a)
+{
+	const float lengthSq = Dot(a, a);
+	return lengthSq > 0.0f ? a * (1.0f / sqrtf(lengthSq)) : Float3{};
+}
+
+
+Float3 Min(const Float3& a, const Float3& b) { return Float3{ min(a.x, b.x), min(a.y, b.y), min(a.z, b.z) }; }
+Float3 Max(const Float3& a, const Float3& b) { return Float3{ max(a.x, b.x), max(a.y, b.y), max(a.z, b.z) }; }
+
+
+Float3 LoadPosition(span<const float> positions, uint32_t positionStride, uint32_t vertex)
+{
+	const float* position = positions.data() + (size_t)vertex * positionStride;
+	return Float3{ position[0], position[1], position[2] };
+}
+
+
+struct RasterVertex
+{
+	float x;
+	float y;
+	float depth;
+};
+
+
+float EdgeFunction(const RasterVertex& a, const RasterVertex& b, float x, float y)
+{
+	return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+
+// Rasterizes one triangle with a less-than depth test, and returns the number of pixels that pass it.  The
+// viewer looks along +side down the depth axis, and triangles whose normal, cross(v1 - v0, v2 - v0), faces away
+// from it are culled.
+uint64_t RasterizeTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2, float side, vector<float>& depthBuffer)
+{
+	const float area = EdgeFunction(v0, v1, v2.x, v2.y);
+	if (area * side >= 0.0f)
+	{
+		return 0;
+	}
+
+	const int32_t minX = max((int32_t)floorf(min({ v0.x, v1.x, v2.x })), 0);
+	const int32_t minY = max((int32_t)floorf(min({ v0.y, v1.y, v2.y })), 0);
+	const int32_t maxX = min((int32_t)ceilf(max({ v0.x, v1.x, v2.x })), s_overdrawGridSize - 1);
+	const int32_t maxY = min((int32_t)ceilf(max({ v0.y, v1.y, v2.y })), s_overdrawGridSize - 1);
+
+	const float invArea = 1.0f / area;
+
+	uint64_t numShaded = 0;
+	for (int32_t y = minY; y <= maxY; ++y)
+	{
+		const float py = (float)y + 0.5f;
+		for (int32_t x = minX; x <= maxX; ++x)
+		{
+			const float px = (float)x + 0.5f;
+
+			// Normalized barycentrics are all positive inside the triangle, whichever way it winds
+			const float b0 = EdgeFunction(v1, v2, px, py) * invArea;
+			const float b1 = EdgeFunction(v2, v0, px, py) * invArea;
+			const float b2 = EdgeFunction(v0, v1, px, py) * invArea;
+			if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f)
+			{
+				continue;
+			}
+
+			const float depth = b0 * v0.depth + b1 * v1.depth + b2 * v2.depth;
+			float& storedDepth = depthBuffer[(size_t)y * s_overdrawGridSize + x];
+			if (depth < storedDepth)
+			{
+				storedDepth = depth;
+				++numShaded;
+			}
+		}
+	}
+
+	return numShaded;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+float VertexCacheStats::GetACMR() const noexcept
+{
+	return numTriangles > 0 ? (float)numTransformed / (float)numTriangles : 0.0f;
+}
+
+
+float VertexCacheStats::GetATVR() const noexcept
+{
+	return numVertices > 0 ? (float)numTransformed / (float)numVertices : 0.0f;
+}
+
+
+VertexCacheStats& VertexCacheStats::operator+=(const VertexCacheStats& other) noexcept
+{
+	numTriangles += other.numTriangles;
+	numVertices += other.numVertices;
+	numTransformed += other.numTransformed;
+
+	return *this;
+}
+
+
+float OverdrawStats::GetOverdraw() const noexcept
+{
+	return numPixelsCovered > 0 ? (float)numPixelsShaded / (float)numPixelsCovered : 0.0f;
+}
+
+
+OverdrawStats& OverdrawStats::operator+=(const OverdrawStats& other) noexcept
+{
+	numPixelsCovered += other.numPixelsCovered;
+	numPixelsShaded += other.numPixelsShaded;
+
+	return *this;
+}
+
+
+MeshOptimizeStats& MeshOptimizeStats::operator+=(const MeshOptimizeStats& other) noexcept
+{
+	vertexCacheBefore += other.vertexCacheBefore;
+	vertexCacheAfter += other.vertexCacheAfter;
+	overdrawBefore += other.overdrawBefore;
+	overdrawAfter += other.overdrawAfter;
+
+	return *this;
+}
+
+
+void OptimizeVertexCache(span<uint32_t> indices, uint32_t numVertices)
+{
+	assert((indices.size() % 3) == 0);
+
+	const uint32_t numTriangles = (uint32_t)(indices.size() / 3);
+	if (numTriangles < 2)
+	{
+		return;
+	}
+
+	static const ForsythScoreTable scoreTable;
+
+	// Triangles adjacent to each vertex.  Each vertex's live triangles are kept at the front of its range.
+	vector<uint32_t> numLiveTriangles(numVertices, 0);
+	for (uint32_t index : indices)
+	{
+		assert(index < numVertices);
+		++numLiveTriangles[index];
+	}
+
+	vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + numLiveTriangles[i];
+	}
+
+	vector<uint32_t> adjacency(indices.size());
+	{
+		vector<uint32_t> fillCounts(numVertices, 0);
+		for (uint32_t i = 0; i < numTriangles; ++i)
+		{
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				const uint32_t vertex = indices[i * 3 + j];
+				adjacency[adjacencyOffsets[vertex] + fillCounts[vertex]++] = i;
+			}
+		}
+	}
+
+	vector<uint32_t> cachePositions(numVertices, s_invalidIndex);
+	vector<float> vertexScores(numVertices);
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		vertexScores[i] = scoreTable.GetScore(s_invalidIndex, numLiveTriangles[i]);
+	}
+
+	vector<bool> emitted(numTriangles, false);
+	vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t cache[s_forsythCacheSize + 3];
+	uint32_t newCache[s_forsythCacheSize + 3];
+	uint32_t cacheCount = 0;
+
+	uint32_t bestTriangle = 0;
+	uint32_t inputCursor = 0;
+
+	for (uint32_t n = 0; n < numTriangles; ++n)
+	{
+		// Nothing in the cache has triangles left, so carry on from the next triangle in input order
+		if (bestTriangle == s_invalidIndex)
+		{
+			while (emitted[inputCursor])
+			{
+				++inputCursor;
+			}
+			bestTriangle = inputCursor;
+		}
+
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		output.insert(output.end(), triangle, triangle + 3);
+		emitted[bestTriangle] = true;
+
+		// The triangle's vertices move to the front of the cache, everything else shifts back
+		uint32_t newCacheCount = 0;
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			const uint32_t vertex = triangle[j];
+			newCache[newCacheCount++] = vertex;
+
+			// Retire the triangle from the vertex's adjacency
+			const uint32_t begin = adjacencyOffsets[vertex];
+			const uint32_t end = begin + numLiveTriangles[vertex];
+			for (uint32_t k = begin; k < end; ++k)
+			{
+				if (adjacency[k] == bestTriangle)
+				{
+					swap(adjacency[k], adjacency[end - 1]);
+					--numLiveTriangles[vertex];
+					break;
+				}
+			}
+		}
+
+		for (uint32_t j = 0; j < cacheCount; ++j)
+		{
+			const uint32_t vertex = cache[j];
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+
+		// Rescore the vertices that moved, including the ones that just fell out of the cache
+		for (uint32_t j = 0; j < newCacheCount; ++j)
+		{
+			const uint32_t vertex = newCache[j];
+			cachePositions[vertex] = j < s_forsythCacheSize ? j : s_invalidIndex;
+			vertexScores[vertex] = scoreTable.GetScore(cachePositions[vertex], numLiveTriangles[vertex]);
+		}
+
+		// The next triangle is the best scoring one that touches the cache
+		bestTriangle = s_invalidIndex;
+		float bestScore = -1.0f;
+		for (uint32_t j = 0; j < newCacheCount; ++j)
+		{
+			const uint32_t vertex = newCache[j];
+			const uint32_t begin = adjacencyOffsets[vertex];
+			const uint32_t end = begin + numLiveTriangles[vertex];
+			for (uint32_t k = begin; k < end; ++k)
+			{
+				const uint32_t t = adjacency[k];
+				const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+
+		cacheCount = min(newCacheCount, s_forsythCacheSize);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+	}
+
+	memcpy(indices.data(), output.data(), output.size() * sizeof(uint32_t));
+}
+
+
+void OptimizeOverdraw(span<uint32_t> indices, span<const float> positions, uint32_t positionStride, float threshold)
+{
+	assert((indices.size() % 3) == 0 && positionStride >= 3);
+
+	const uint32_t numTriangles = (uint32_t)(indices.size() / 3);
+	const uint32_t numVertices = (uint32_t)(positions.size() / positionStride);
+	if (numTriangles < 2 || numVertices == 0)
+	{
+		return;
+	}
+
+	// Hard boundaries, where the cache order already starts over:  triangles whose vertices all miss
+	vector<uint32_t> hardBoundaries;
+	{
+		FifoCache cache(numVertices, s_overdrawCacheSize);
+		for (uint32_t i = 0; i < numTriangles; ++i)
+		{
+			if (cache.AccessTriangle(&indices[i * 3]) == 3 || i == 0)
+			{
+				hardBoundaries.push_back(i);
+			}
+		}
+		hardBoundaries.push_back(numTriangles);
+	}
+
+	// Soft boundaries split each hard cluster further, as long as the extra cache flushes keep its ACMR within
+	// the threshold
+	vector<uint32_t> clusterStarts;
+	{
+		FifoCache cache(numVertices, s_overdrawCacheSize);
+		for (size_t c = 0; c + 1 < hardBoundaries.size(); ++c)
+		{
+			const uint32_t begin = hardBoundaries[c];
+			const uint32_t end = hardBoundaries[c + 1];
+
+			cache.Flush();
+			uint32_t clusterMisses = 0;
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				clusterMisses += cache.AccessTriangle(&indices[i * 3]);
+			}
+			const float targetACMR = threshold * (float)clusterMisses / (float)(end - begin);
+
+			cache.Flush();
+			clusterStarts.push_back(begin);
+
+			uint32_t softStart = begin;
+			uint32_t softMisses = 0;
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				softMisses += cache.AccessTriangle(&indices[i * 3]);
+
+				if (i + 1 < end && (float)softMisses <= targetACMR * (float)(i + 1 - softStart))
+				{
+					softStart = i + 1;
+					softMisses = 0;
+					clusterStarts.push_back(softStart);
+					cache.Flush();
+				}
+			}
+		}
+		clusterStarts.push_back(numTriangles);
+	}
+
+	const uint32_t numClusters = (uint32_t)clusterStarts.size() - 1;
+	if (numClusters < 2)
+	{
+		return;
+	}
+
+	// Area-weighted centroid and normal of each cluster, and of the whole mesh
+	vector<Float3> clusterCentroids(numClusters);
+	vector<Float3> clusterNormals(numClusters);
+	Float3 meshCentroid{};
+	float meshArea = 0.0f;
+
+	for (uint32_t c = 0; c < numClusters; ++c)
+	{
+		Float3 centroid{};
+		Float3 normal{};
+		float clusterArea = 0.0f;
+
+		for (uint32_t i = clusterStarts[c]; i < clusterStarts[c + 1]; ++i)
+		{
+			const Float3 p0 = LoadPosition(positions, positionStride, indices[i * 3]);
+			const Float3 p1 = LoadPosition(positions, positionStride, indices[i * 3 + 1]);
+			const Float3 p2 = LoadPosition(positions, positionStride, indices[i * 3 + 2]);
+
+			const Float3 crossProduct = Cross(p1 - p0, p2 - p0);
+			const float area = sqrtf(Dot(crossProduct, crossProduct));
+
+			centroid = centroid + (p0 + p1 + p2) * (area / 3.0f);
+			normal = normal + crossProduct;
+			clusterArea += area;
+		}
+
+		meshCentroid = meshCentroid + centroid;
+		meshArea += clusterArea;
+
+		clusterCentroids[c] = clusterArea > 0.0f ? centroid * (1.0f / clusterArea) : Float3{};
+		clusterNormals[c] = Normalize(normal);
+	}
+
+	if (meshArea <= 0.0f)
+	{
+		return;
+	}
+	meshCentroid = meshCentroid * (1.0f / meshArea);
+
+	// Clusters that face away from the center are the likeliest occluders, so they go first
+	vector<float> sortKeys(numClusters);
+	vector<uint32_t> clusterOrder(numClusters);
+	for (uint32_t c = 0; c < numClusters; ++c)
+	{
+		sortKeys[c] = Dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+		clusterOrder[c] = c;
+	}
+
+	stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (uint32_t c : clusterOrder)
+	{
+		output.insert(output.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+	}
+
+	memcpy(indices.data(), output.data(), output.size() * sizeof(uint32_t));
+}
+
+
+uint32_t OptimizeVertexFetchRemap(span<uint32_t> indices, uint32_t numVertices, vector<uint32_t>& outRemap)
+{
+	outRemap.assign(numVertices, s_invalidIndex);
+
+	uint32_t nextVertex = 0;
+	for (uint32_t& index : indices)
+	{
+		assert(index < numVertices);
+
+		uint32_t& newIndex = outRemap[index];
+		if (newIndex == s_invalidIndex)
+		{
+			newIndex = nextVertex++;
+		}
+		index = newIndex;
+	}
+
+	return nextVertex;
+}
+
+
+void RemapVertices(vector<float>& vertices, uint32_t vertexStride, span<const uint32_t> remap, uint32_t newNumVertices)
+{
+	assert(vertices.size() == remap.size() * vertexStride);
+
+	vector<float> remapped((size_t)newNumVertices * vertexStride);
+	for (size_t i = 0; i < remap.size(); ++i)
+	{
+		if (remap[i] != s_invalidIndex)
+		{
+			memcpy(remapped.data() + (size_t)remap[i] * vertexStride, vertices.data() + i * vertexStride, vertexStride * sizeof(float));
+		}
+	}
+
+	vertices.swap(remapped);
+}
+
+
+VertexCacheStats AnalyzeVertexCache(span<const uint32_t> indices, uint32_t numVertices, uint32_t cacheSize)
+{
+	assert((indices.size() % 3) == 0);
+
+	VertexCacheStats stats{};
+	stats.numTriangles = indices.size() / 3;
+
+	vector<bool> referenced(numVertices, false);
+	FifoCache cache(numVertices, cacheSize);
+
+	for (uint32_t index : indices)
+	{
+		assert(index < numVertices);
+
+		stats.numTransformed += cache.Access(index) ? 1 : 0;
+		if (!referenced[index])
+		{
+			referenced[index] = true;
+			++stats.numVertices;
+		}
+	}
+
+	return stats;
+}
+
+
+OverdrawStats AnalyzeOverdraw(span<const uint32_t> indices, span<const float> positions, uint32_t positionStride)
+{
+	assert((indices.size() % 3) == 0 && positionStride >= 3);
+
+	OverdrawStats stats{};
+
+	if (indices.empty())
+	{
+		return stats;
+	}
+
+	// Fit the mesh bounds into the grid, with the same scale on every axis
+	Float3 minPosition{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Float3 maxPosition{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32_t index : indices)
+	{
+		const Float3 position = LoadPosition(positions, positionStride, index);
+		minPosition = Min(minPosition, position);
+		maxPosition = Max(maxPosition, position);
+	}
+
+	const Float3 extents = maxPosition - minPosition;
+	const float maxExtent = max({ extents.x, extents.y, extents.z });
+	if (maxExtent <= 0.0f)
+	{
+		return stats;
+	}
+
+	const float scale = (float)s_overdrawGridSize / maxExtent;
+
+	vector<Float3> gridPositions(positions.size() / positionStride);
+	for (uint32_t index : indices)
+	{
+		gridPositions[index] = (LoadPosition(positions, positionStride, index) - minPosition) * scale;
+	}
+
+	vector<float> depthBuffer((size_t)s_overdrawGridSize * s_overdrawGridSize);
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		for (float side : { 1.0f, -1.0f })
+		{
+			fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				RasterVertex triangle[3];
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					const float* p = &gridPositions[indices[i + j]].x;
+					triangle[j] = RasterVertex{ p[(axis + 1) % 3], p[(axis + 2) % 3], p[axis] * side };
+				}
+
+				stats.numPixelsShaded += RasterizeTriangle(triangle[0], triangle[1], triangle[2], side, depthBuffer);
+			}
+
+			stats.numPixelsCovered += (uint64_t)count_if(depthBuffer.begin(), depthBuffer.end(), [](float depth) { return depth != FLT_MAX; });
+		}
+	}
+
+	return stats;
+}
+
+
+void OptimizeMesh(vector<uint32_t>& indices, vector<float>& vertices, uint32_t vertexStride, vector<float>& positionsOnly,
+	const MeshOptimizeDesc& desc, MeshOptimizeStats* outStats)
+{
+	ScopedEvent event("OptimizeMesh");
+
+	assert(vertexStride > 0);
+
+	const uint32_t numVertices = (uint32_t)(vertices.size() / vertexStride);
+	assert(positionsOnly.empty() || positionsOnly.size() == (size_t)numVertices * 3);
+
+	if (outStats)
+	{
+		outStats->vertexCacheBefore = AnalyzeVertexCache(indices, numVertices, desc.analyzeCacheSize);
+		if (!positionsOnly.empty())
+		{
+			outStats->overdrawBefore = AnalyzeOverdraw(indices, positionsOnly, 3);
+		}
+	}
+
+	OptimizeVertexCache(indices, numVertices);
+
+	if (!positionsOnly.empty())
+	{
+		OptimizeOverdraw(indices, positionsOnly, 3, desc.overdrawThreshold);
+	}
+
+	vector<uint32_t> remap;
+	const uint32_t newNumVertices = OptimizeVertexFetchRemap(indices, numVertices, remap);
+
+	RemapVertices(vertices, vertexStride, remap, newNumVertices);
+	if (!positionsOnly.empty())
+	{
+		RemapVertices(positionsOnly, 3, remap, newNumVertices);
+	}
+
+	if (outStats)
+	{
+		outStats->vertexCacheAfter = AnalyzeVertexCache(indices, newNumVertices, desc.analyzeCacheSize);
+		if (!positionsOnly.empty())
+		{
+			outStats->overdrawAfter = AnalyzeOverdraw(indices, positionsOnly, 3);
+		}
+	}
+}
+
+} // namespace Luna
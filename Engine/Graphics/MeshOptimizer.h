@@ -0,0 +1,91 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+
+namespace Luna
+{
+
+// Post-transform cache efficiency of an index buffer, measured against a FIFO cache.  Counts rather than
+// ratios, so that the stats of several meshes can be summed.
+struct VertexCacheStats
+{
+	uint64_t numTriangles{ 0 };
+	uint64_t numVertices{ 0 };		// Vertices referenced by the index buffer
+	uint64_t numTransformed{ 0 };	// Cache misses
+
+	float GetACMR() const noexcept;	// Average cache miss ratio, transformed vertices per triangle, 0.5 at best
+	float GetATVR() const noexcept;	// Average transformed vertex ratio, transformed vertices per vertex, 1.0 at best
+
+	VertexCacheStats& operator+=(const VertexCacheStats& other) noexcept;
+};
+
+
+// Overdraw of a mesh, measured by rasterizing it with depth testing from the six axis-aligned directions
+struct OverdrawStats
+{
+	uint64_t numPixelsCovered{ 0 };
+	uint64_t numPixelsShaded{ 0 };
+
+	float GetOverdraw() const noexcept;	// Shaded pixels per covered pixel, 1.0 at best
+
+	OverdrawStats& operator+=(const OverdrawStats& other) noexcept;
+};
+
+
+struct MeshOptimizeStats
+{
+	VertexCacheStats vertexCacheBefore;
+	VertexCacheStats vertexCacheAfter;
+	OverdrawStats overdrawBefore;
+	OverdrawStats overdrawAfter;
+
+	MeshOptimizeStats& operator+=(const MeshOptimizeStats& other) noexcept;
+};
+
+
+struct MeshOptimizeDesc
+{
+	// Cache size for the analysis.  The reordering itself is tuned for any cache from 16 to 32 entries.
+	uint32_t analyzeCacheSize{ 16 };
+
+	// How much worse than the cache-optimized order the ACMR may get to make room for overdraw sorting
+	float overdrawThreshold{ 1.05f };
+};
+
+
+// Reorders the triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm)
+void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t numVertices);
+
+// Reorders clusters of triangles, as split by the vertex cache order, so that outward-facing clusters come first
+// and occlude the rest (Sander, Nehab and Barczak).  Positions are three floats at the start of each
+// positionStride-float vertex.
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const float> positions, uint32_t positionStride, float threshold = 1.05f);
+
+// Renumbers the vertices in the order the index buffer first uses them, so that vertex fetch walks memory
+// forwards.  outRemap maps old vertex indices to new ones, with ~0u for unreferenced vertices, which are
+// dropped.  Returns the new vertex count.
+uint32_t OptimizeVertexFetchRemap(std::span<uint32_t> indices, uint32_t numVertices, std::vector<uint32_t>& outRemap);
+
+// Applies a remap from OptimizeVertexFetchRemap to a float vertex stream
+void RemapVertices(std::vector<float>& vertices, uint32_t vertexStride, std::span<const uint32_t> remap, uint32_t newNumVertices);
+
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t numVertices, uint32_t cacheSize = 16);
+OverdrawStats AnalyzeOverdraw(std::span<const uint32_t> indices, std::span<const float> positions, uint32_t positionStride);
+
+// Runs all three steps on one mesh.  vertices holds vertexStride floats per vertex, and positionsOnly holds
+// three floats per vertex, or is empty, in which case the overdraw step is skipped.  Both streams are
+// remapped.  Stats are only gathered when outStats is set, since the overdraw analysis rasterizes the mesh
+// several times.  The output only depends on the input, so meshes can be optimized in parallel.
+void OptimizeMesh(std::vector<uint32_t>& indices, std::vector<float>& vertices, uint32_t vertexStride, std::vector<float>& positionsOnly,
+	const MeshOptimizeDesc& desc, MeshOptimizeStats* outStats = nullptr);
+
+} // namespace Luna
@@ -0,0 +1,522 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "MeshSimplifier.h"
+
+#include "Graphics/MeshOptimizer.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Collapses that would turn a triangle by more than about 75 degrees are rejected
+constexpr float s_minNormalCosine = 0.25f;
+
+// A level has to drop at least this fraction of the triangles of the level before it to be worth keeping
+constexpr float s_minLodReduction = 0.1f;
+
+
+// Plain float math, so that meshes simplify without DirectXMath in the headless tests
+struct Float3
+{
+	float x{ 0.0f };
+	float y{ 0.0f };
+	float z{ 0.0f };
+};
+
+
+Float3 operator-(const Float3& a, const Float3& b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+Float3 operator*(const Float3& a, float s) { return Float3{ a.x * s, a.y * s, a.z * s }; }
+
+
+float Dot(const Float3& a, const Float3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+float Length(const Float3& a)
+{
+	return sqrtf(Dot(a, a));
+}
+
+
+Float3 Cross(const Float3& a, const Float3& b)
+{
+	return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+
+Float3 LoadPosition(span<const float> positions, uint32_t positionStride, uint32_t vertex)
+{
+	const float* position = positions.data() + (size_t)vertex * positionStride;
+	return Float3{ position[0], position[1], position[2] };
+}
+
+
+// Sum of squared distances to a set of planes, as the symmetric 4x4 matrix of Garland and Heckbert, with the
+// accumulated plane weight so the error can be averaged
+struct Quadric
+{
+	double a00{ 0.0 }, a01{ 0.0 }, a02{ 0.0 };
+	double a11{ 0.0 }, a12{ 0.0 };
+	double a22{ 0.0 };
+	double b0{ 0.0 }, b1{ 0.0 }, b2{ 0.0 };
+	double c{ 0.0 };
+	double weight{ 0.0 };
+
+	static Quadric FromPlane(double nx, double ny, double nz, double d, double weight)
+	{
+		Quadric q;
+		q.a00 = weight * nx * nx; q.a01 = weight * nx * ny; q.a02 = weight * nx * nz;
+		q.a11 = weight * ny * ny; q.a12 = weight * ny * nz;
+		q.a22 = weight * nz * nz;
+		q.b0 = weight * nx * d; q.b1 = weight * ny * d; q.b2 = weight * nz * d;
+		q.c = weight * d * d;
+		q.weight = weight;
+		return q;
+	}
+
+	Quadric& operator+=(const Quadric& other)
+	{
+		a00 += other.a00; a01 += other.a01; a02 += other.a02;
+		a11 += other.a11; a12 += other.a12;
+		a22 += other.a22;
+		b0 += other.b0; b1 += other.b1; b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+		return *this;
+	}
+
+	// Weighted average squared distance from p to the planes
+	double GetError(const Float3& p) const
+	{
+		const double x = p.x;
+		const double y = p.y;
+		const double z = p.z;
+
+		const double error =
+			a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z +
+			a11 * y * y + 2.0 * a12 * y * z +
+			a22 * z * z +
+			2.0 * (b0 * x + b1 * y + b2 * z) +
+			c;
+
+		return weight > 0.0 ? fabs(error) / weight : 0.0;
+	}
+};
+
+
+struct Collapse
+{
+	uint32_t from;
+	uint32_t to;
+	double error;
+};
+
+
+void ComputeBounds(span<const float> positions, uint32_t positionStride, Float3& outMin, float& outExtent)
+{
+	Float3 minPosition{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Float3 maxPosition{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (size_t i = 0; i + 3 <= positions.size(); i += positionStride)
+	{
+		const float* position = positions.data() + i;
+		minPosition = Float3{ min(minPosition.x, position[0]), min(minPosition.y, position[1]), min(minPosition.z, position[2]) };
+		maxPosition = Float3{ max(maxPosition.x, position[0]), max(maxPosition.y, position[1]), max(maxPosition.z, position[2]) };
+	}
+
+	const Float3 extents = maxPosition - minPosition;
+	outMin = minPosition;
+	outExtent = max({ extents.x, extents.y, extents.z, 0.0f });
+}
+
+
+Float3 TriangleNormal(const Float3& p0, const Float3& p1, const Float3& p2)
+{
+	return Cross(p1 - p0, p2 - p0);
+}
+
+
+// Checks whether moving vertex from onto to would fold over any of the triangles around from
+bool CollapseFlipsTriangles(uint32_t from, uint32_t to, span<const uint32_t> indices, span<const uint32_t> adjacentTriangles, const vector<Float3>& positions)
+{
+	for (uint32_t t : adjacentTriangles)
+	{
+		const uint32_t* triangle = &indices[t * 3];
+		if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+		{
+			// Collapses to a degenerate triangle, which gets removed
+			continue;
+		}
+
+		// Rotate the triangle so that from comes first, keeping the winding
+		const uint32_t k = triangle[0] == from ? 0 : (triangle[1] == from ? 1 : 2);
+		const Float3& p1 = positions[triangle[(k + 1) % 3]];
+		const Float3& p2 = positions[triangle[(k + 2) % 3]];
+
+		const Float3 oldNormal = TriangleNormal(positions[from], p1, p2);
+		const Float3 newNormal = TriangleNormal(positions[to], p1, p2);
+
+		const float dot = Dot(oldNormal, newNormal);
+		const float lengths = Length(oldNormal) * Length(newNormal);
+		if (dot < s_minNormalCosine * lengths)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+float SimplifyMesh(span<const uint32_t> indices, span<const float> positions, uint32_t positionStride,
+	uint32_t targetIndexCount, float targetError, vector<uint32_t>& outIndices)
+{
+	ScopedEvent event("SimplifyMesh");
+
+	assert((indices.size() % 3) == 0 && positionStride >= 3);
+
+	outIndices.assign(indices.begin(), indices.end());
+
+	const uint32_t numVertices = (uint32_t)(positions.size() / positionStride);
+	if (indices.size() <= targetIndexCount || numVertices == 0)
+	{
+		return 0.0f;
+	}
+
+	// Work in the unit cube, so that errors are relative to the mesh extent
+	Float3 minPosition;
+	float extent{ 0.0f };
+	ComputeBounds(positions, positionStride, minPosition, extent);
+	if (extent <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	vector<Float3> unitPositions(numVertices);
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		unitPositions[i] = (LoadPosition(positions, positionStride, i) - minPosition) * (1.0f / extent);
+	}
+
+	// Group vertices by position.  Sorting rather than hashing keeps the grouping deterministic.
+	vector<uint32_t> positionGroups(numVertices);
+	vector<uint32_t> groupSizes(numVertices, 0);
+	{
+		vector<uint32_t> sortedVertices(numVertices);
+		for (uint32_t i = 0; i < numVertices; ++i)
+		{
+			sortedVertices[i] = i;
+		}
+
+		auto positionLess = [&unitPositions](uint32_t a, uint32_t b)
+		{
+			const Float3& pa = unitPositions[a];
+			const Float3& pb = unitPositions[b];
+			return tie(pa.x, pa.y, pa.z) < tie(pb.x, pb.y, pb.z);
+		};
+		stable_sort(sortedVertices.begin(), sortedVertices.end(), positionLess);
+
+		uint32_t group = sortedVertices[0];
+		for (uint32_t i = 0; i < numVertices; ++i)
+		{
+			const uint32_t vertex = sortedVertices[i];
+			if (i > 0 && positionLess(sortedVertices[i - 1], vertex))
+			{
+				group = vertex;
+			}
+			positionGroups[vertex] = group;
+			++groupSizes[group];
+		}
+	}
+
+	// Seams have more than one vertex at a position, and border or non-manifold edges don't have exactly two
+	// triangles.  Vertices on either stay put.
+	vector<bool> locked(numVertices, false);
+	{
+		vector<pair<uint32_t, uint32_t>> edges;
+		edges.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				const uint32_t a = positionGroups[indices[i + j]];
+				const uint32_t b = positionGroups[indices[i + (j + 1) % 3]];
+				if (a != b)
+				{
+					edges.emplace_back(min(a, b), max(a, b));
+				}
+			}
+		}
+		sort(edges.begin(), edges.end());
+
+		vector<bool> lockedGroups(numVertices, false);
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t j = i + 1;
+			while (j < edges.size() && edges[j] == edges[i])
+			{
+				++j;
+			}
+
+			if (j - i != 2)
+			{
+				lockedGroups[edges[i].first] = true;
+				lockedGroups[edges[i].second] = true;
+			}
+			i = j;
+		}
+
+		for (uint32_t i = 0; i < numVertices; ++i)
+		{
+			const uint32_t group = positionGroups[i];
+			locked[i] = lockedGroups[group] || groupSizes[group] > 1;
+		}
+	}
+
+	// Area-weighted plane quadrics, accumulated per vertex
+	vector<Quadric> quadrics(numVertices);
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const Float3& p0 = unitPositions[indices[i]];
+		const Float3 normal = TriangleNormal(p0, unitPositions[indices[i + 1]], unitPositions[indices[i + 2]]);
+		const float doubleArea = Length(normal);
+		if (doubleArea <= 0.0f)
+		{
+			continue;
+		}
+
+		const Float3 n = normal * (1.0f / doubleArea);
+		const double d = -((double)n.x * p0.x + (double)n.y * p0.y + (double)n.z * p0.z);
+
+		const Quadric quadric = Quadric::FromPlane(n.x, n.y, n.z, d, 0.5 * doubleArea);
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			quadrics[indices[i + j]] += quadric;
+		}
+	}
+
+	const double maxError = (double)targetError * targetError;
+	double reachedError = 0.0;
+
+	vector<uint32_t> adjacencyOffsets(numVertices + 1);
+	vector<uint32_t> adjacency;
+	vector<Collapse> collapses;
+	vector<uint32_t> remap(numVertices);
+	vector<bool> touched(numVertices);
+
+	// Each pass collapses a set of independent edges, cheapest first, then compacts the index buffer
+	while (outIndices.size() > targetIndexCount)
+	{
+		const uint32_t numTriangles = (uint32_t)(outIndices.size() / 3);
+
+		// Triangles around each vertex
+		fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : outIndices)
+		{
+			++adjacencyOffsets[index + 1];
+		}
+		for (uint32_t i = 0; i < numVertices; ++i)
+		{
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+		adjacency.resize(outIndices.size());
+		{
+			vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t t = 0; t < numTriangles; ++t)
+			{
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					adjacency[fillOffsets[outIndices[t * 3 + j]]++] = t;
+				}
+			}
+		}
+
+		collapses.clear();
+		for (uint32_t t = 0; t < numTriangles; ++t)
+		{
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				const uint32_t from = outIndices[t * 3 + j];
+				const uint32_t to = outIndices[t * 3 + (j + 1) % 3];
+				if (locked[from] || from == to)
+				{
+					continue;
+				}
+
+				Quadric quadric = quadrics[from];
+				quadric += quadrics[to];
+
+				const double error = quadric.GetError(unitPositions[to]);
+				if (error <= maxError)
+				{
+					collapses.push_back(Collapse{ from, to, error });
+				}
+			}
+		}
+
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+		{
+			return tie(a.error, a.from, a.to) < tie(b.error, b.from, b.to);
+		});
+
+		for (uint32_t i = 0; i < numVertices; ++i)
+		{
+			remap[i] = i;
+		}
+		fill(touched.begin(), touched.end(), false);
+
+		const uint32_t targetTriangles = targetIndexCount / 3;
+		uint32_t remainingTriangles = numTriangles;
+		uint32_t numCollapsed = 0;
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (remainingTriangles <= targetTriangles)
+			{
+				break;
+			}
+
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			const span<const uint32_t> adjacentTriangles{ adjacency.data() + adjacencyOffsets[collapse.from], adjacencyOffsets[collapse.from + 1] - adjacencyOffsets[collapse.from] };
+			if (CollapseFlipsTriangles(collapse.from, collapse.to, outIndices, adjacentTriangles, unitPositions))
+			{
+				continue;
+			}
+
+			// Lock down every triangle around the collapsed vertex for the rest of the pass, so the remaining
+			// collapses see the positions they were checked against
+			for (uint32_t t : adjacentTriangles)
+			{
+				const uint32_t* triangle = &outIndices[t * 3];
+				touched[triangle[0]] = true;
+				touched[triangle[1]] = true;
+				touched[triangle[2]] = true;
+
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					--remainingTriangles;
+				}
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			reachedError = max(reachedError, collapse.error);
+			++numCollapsed;
+		}
+
+		if (numCollapsed == 0)
+		{
+			break;
+		}
+
+		// Apply the pass and drop the triangles that collapsed
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < outIndices.size(); i += 3)
+		{
+			const uint32_t i0 = remap[outIndices[i]];
+			const uint32_t i1 = remap[outIndices[i + 1]];
+			const uint32_t i2 = remap[outIndices[i + 2]];
+			if (i0 != i1 && i1 != i2 && i2 != i0)
+			{
+				outIndices[writeIndex++] = i0;
+				outIndices[writeIndex++] = i1;
+				outIndices[writeIndex++] = i2;
+			}
+		}
+		outIndices.resize(writeIndex);
+	}
+
+	const float error = (float)sqrt(reachedError);
+	assert(error <= targetError);
+
+	return error;
+}
+
+
+void GenerateMeshLods(vector<uint32_t>& indices, span<const float> positions, uint32_t positionStride,
+	const MeshLodDesc& desc, vector<MeshLodLevel>& outLevels)
+{
+	ScopedEvent event("GenerateMeshLods");
+
+	assert((indices.size() % 3) == 0);
+
+	outLevels.clear();
+	outLevels.push_back(MeshLodLevel{ .indexOffset = 0, .indexCount = (uint32_t)indices.size(), .error = 0.0f });
+
+	Float3 minPosition;
+	float extent{ 0.0f };
+	ComputeBounds(positions, positionStride, minPosition, extent);
+
+	const uint32_t numVertices = (uint32_t)(positions.size() / positionStride);
+
+	// Every level is simplified from a copy of LOD 0, since appending reallocates the index buffer
+	const vector<uint32_t> lod0Indices = indices;
+
+	vector<uint32_t> lodIndices;
+	uint32_t targetIndexCount = (uint32_t)indices.size();
+
+	for (uint32_t lod = 1; lod < desc.maxLods; ++lod)
+	{
+		targetIndexCount = (uint32_t)((float)targetIndexCount * desc.indexRatio) / 3 * 3;
+		if (targetIndexCount / 3 < desc.minTriangles)
+		{
+			break;
+		}
+
+		const float error = SimplifyMesh(lod0Indices, positions, positionStride, targetIndexCount, desc.maxError, lodIndices);
+
+		// Stalled, either on the error limit or on locked vertices
+		const uint32_t previousIndexCount = outLevels.back().indexCount;
+		if (lodIndices.empty() || (float)lodIndices.size() > (1.0f - s_minLodReduction) * (float)previousIndexCount)
+		{
+			break;
+		}
+
+		OptimizeVertexCache(lodIndices, numVertices);
+
+		const MeshLodLevel level{
+			.indexOffset	= (uint32_t)indices.size(),
+			.indexCount		= (uint32_t)lodIndices.size(),
+			.error			= max(error * extent, outLevels.back().error)
+		};
+
+		assert(level.indexCount < previousIndexCount);
+		assert(level.error <= desc.maxError * extent);
+
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+		outLevels.push_back(level);
+
+		// The next target follows what this level actually reached
+		targetIndexCount = level.indexCount;
+	}
+}
+
+} // namespace Luna
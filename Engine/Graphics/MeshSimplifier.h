@@ -0,0 +1,50 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+
+namespace Luna
+{
+
+struct MeshLodDesc
+{
+	uint32_t maxLods{ 4 };				// Including LOD 0
+	float indexRatio{ 0.5f };			// Target index count of each level, relative to the level before it
+	float maxError{ 0.02f };			// Largest error allowed, relative to the mesh extent
+	uint32_t minTriangles{ 64 };		// No level is built below this many triangles
+};
+
+
+// One level in a shared index buffer
+struct MeshLodLevel
+{
+	uint32_t indexOffset{ 0 };
+	uint32_t indexCount{ 0 };
+	float error{ 0.0f };	// Largest geometric deviation from LOD 0, in model units
+};
+
+
+// Simplifies an indexed triangle list by collapsing edges in order of quadric error (Garland and Heckbert).  Each
+// collapse moves a vertex onto a neighbor, so no vertices are made and the output indexes the same vertex buffer.
+// Vertices on open borders and on attribute seams (several vertices at one position) never move, which keeps UV
+// and normal discontinuities intact.  Stops at targetIndexCount, or before a collapse would exceed targetError,
+// relative to the mesh extent.  Returns the error reached, also relative to the mesh extent.  Positions are three
+// floats at the start of each positionStride-float vertex.
+float SimplifyMesh(std::span<const uint32_t> indices, std::span<const float> positions, uint32_t positionStride,
+	uint32_t targetIndexCount, float targetError, std::vector<uint32_t>& outIndices);
+
+// Appends a chain of simplified levels to an index buffer that holds LOD 0, each one cache-optimized, and returns
+// every level including LOD 0.  Levels are always simplified from LOD 0, so their errors don't compound.  The
+// chain stops early once simplification stalls, so it may be shorter than desc.maxLods.
+void GenerateMeshLods(std::vector<uint32_t>& indices, std::span<const float> positions, uint32_t positionStride,
+	const MeshLodDesc& desc, std::vector<MeshLodLevel>& outLevels);
+
+} // namespace Luna
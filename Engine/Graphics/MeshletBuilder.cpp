@@ -0,0 +1,503 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "MeshletBuilder.h"
+
+using namespace std;
+
+
+namespace
+{
+
+constexpr uint32_t s_invalidIndex = ~0u;
+
+// Narrowest spread (the minimum dot product between the cone axis and a triangle normal) that still
+// produces a useful normal cone
+constexpr float s_minConeDot = 0.1f;
+
+
+// Plain float math, so that meshlets build without DirectXMath in the headless tests
+struct Float3
+{
+	float x{ 0.0f };
+	float y{ 0.0f };
+	float z{ 0.0f };
+};
+
+
+Float3 operator+(const Float3& a, const Float3& b) { return Float3{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+Float3 operator-(const Float3& a, const Float3& b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+Float3 operator*(const Float3& a, float s) { return Float3{ a.x * s, a.y * s, a.z * s }; }
+
+
+float Dot(const Float3& a, const Float3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+Float3 Cross(const Float3& a, const Float3& b)
+{
+	return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+
+Float3 Normalize(const Float3& a)
+{
+	return a * (1.0f / sqrtf(Dot(a, a)));
+}
+
+
+// Ritter's bounding sphere: start from the most distant pair of axis-aligned extreme points, then grow the
+// sphere to take in every point left outside.  Not the smallest sphere, but close and linear in the points.
+void ComputeBoundingSphere(span<const Float3> points, Float3& outCenter, float& outRadius)
+{
+	outCenter = Float3{};
+	outRadius = 0.0f;
+
+	if (points.empty())
+	{
+		return;
+	}
+
+	array<Float3, 6> extremes;
+	extremes.fill(points[0]);
+	for (const auto& point : points)
+	{
+		if (point.x < extremes[0].x) extremes[0] = point;
+		if (point.x > extremes[1].x) extremes[1] = point;
+		if (point.y < extremes[2].y) extremes[2] = point;
+		if (point.y > extremes[3].y) extremes[3] = point;
+		if (point.z < extremes[4].z) extremes[4] = point;
+		if (point.z > extremes[5].z) extremes[5] = point;
+	}
+
+	uint32_t widestAxis = 0;
+	float widestDistanceSq = -1.0f;
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		const Float3 extent = extremes[2 * axis + 1] - extremes[2 * axis];
+		const float distanceSq = Dot(extent, extent);
+		if (distanceSq > widestDistanceSq)
+		{
+			widestAxis = axis;
+			widestDistanceSq = distanceSq;
+		}
+	}
+
+	Float3 center = (extremes[2 * widestAxis] + extremes[2 * widestAxis + 1]) * 0.5f;
+	float radius = sqrtf(widestDistanceSq) * 0.5f;
+
+	for (const auto& point : points)
+	{
+		const Float3 offset = point - center;
+		const float distance = sqrtf(Dot(offset, offset));
+		if (distance > radius)
+		{
+			const float newRadius = (radius + distance) * 0.5f;
+			center = center + offset * ((newRadius - radius) / distance);
+			radius = newRadius;
+		}
+	}
+
+	outCenter = center;
+	outRadius = radius;
+}
+
+
+uint32_t ReadIndex(const std::byte* indices, uint32_t indexSize, size_t i)
+{
+	if (indexSize == sizeof(uint16_t))
+	{
+		uint16_t index{ 0 };
+		memcpy(&index, indices + i * sizeof(uint16_t), sizeof(uint16_t));
+		return index;
+	}
+
+	uint32_t index{ 0 };
+	memcpy(&index, indices + i * sizeof(uint32_t), sizeof(uint32_t));
+	return index;
+}
+
+
+void WriteIndex(std::byte* indices, uint32_t indexSize, size_t i, uint32_t value)
+{
+	if (indexSize == sizeof(uint16_t))
+	{
+		const uint16_t index = (uint16_t)value;
+		memcpy(indices + i * sizeof(uint16_t), &index, sizeof(uint16_t));
+	}
+	else
+	{
+		memcpy(indices + i * sizeof(uint32_t), &value, sizeof(uint32_t));
+	}
+}
+
+
+uint8_t QuantizeSigned(float value)
+{
+	return (uint8_t)lroundf(clamp(value * 0.5f + 0.5f, 0.0f, 1.0f) * 255.0f);
+}
+
+
+float DequantizeSigned(uint8_t value)
+{
+	return (float)value / 255.0f * 2.0f - 1.0f;
+}
+
+
+Luna::MeshletCullData ComputeCullData(const vector<Float3>& vertexPositions, span<const uint32_t> meshletVertices, span<const Luna::MeshletTriangle> meshletTriangles)
+{
+	Luna::MeshletCullData cullData{};
+
+	// Start out with a degenerate cone, which the shaders never reject
+	cullData.normalCone[0] = 0;
+	cullData.normalCone[1] = 0;
+	cullData.normalCone[2] = 0;
+	cullData.normalCone[3] = 0xff;
+	cullData.apexOffset = 0.0f;
+
+	array<Float3, Luna::MaxMeshletVertices> points;
+	for (size_t i = 0; i < meshletVertices.size(); ++i)
+	{
+		points[i] = vertexPositions[meshletVertices[i]];
+	}
+
+	Float3 sphereCenter;
+	float sphereRadius{ 0.0f };
+	ComputeBoundingSphere({ points.data(), meshletVertices.size() }, sphereCenter, sphereRadius);
+
+	cullData.boundingSphere[0] = sphereCenter.x;
+	cullData.boundingSphere[1] = sphereCenter.y;
+	cullData.boundingSphere[2] = sphereCenter.z;
+	cullData.boundingSphere[3] = sphereRadius;
+
+	// Unit normals of the non-degenerate triangles, along with a point on each triangle's plane
+	array<Float3, Luna::MaxMeshletPrimitives> normals;
+	array<Float3, Luna::MaxMeshletPrimitives> planePoints;
+	uint32_t numNormals = 0;
+
+	for (const auto& triangle : meshletTriangles)
+	{
+		const Float3& p0 = points[triangle.i0];
+		const Float3& p1 = points[triangle.i1];
+		const Float3& p2 = points[triangle.i2];
+
+		const Float3 normal = Cross(p1 - p0, p2 - p0);
+		if (Dot(normal, normal) <= numeric_limits<float>::min())
+		{
+			continue;
+		}
+
+		normals[numNormals] = Normalize(normal);
+		planePoints[numNormals] = p0;
+		++numNormals;
+	}
+
+	if (numNormals == 0)
+	{
+		return cullData;
+	}
+
+	// The cone axis points at the center of the normals' bounding sphere
+	Float3 normalCenter;
+	float normalRadius{ 0.0f };
+	ComputeBoundingSphere({ normals.data(), numNormals }, normalCenter, normalRadius);
+
+	if (Dot(normalCenter, normalCenter) <= numeric_limits<float>::min())
+	{
+		return cullData;
+	}
+
+	const Float3 axisValue = Normalize(normalCenter);
+
+	// Measure the spread against the axis the shaders will decode, so that quantization stays conservative
+	const uint8_t axisX = QuantizeSigned(axisValue.x);
+	const uint8_t axisY = QuantizeSigned(axisValue.y);
+	const uint8_t axisZ = QuantizeSigned(axisValue.z);
+	const Float3 quantizedAxis{ DequantizeSigned(axisX), DequantizeSigned(axisY), DequantizeSigned(axisZ) };
+	if (Dot(quantizedAxis, quantizedAxis) <= numeric_limits<float>::min())
+	{
+		return cullData;
+	}
+	const Float3 axis = Normalize(quantizedAxis);
+
+	float minDot = 1.0f;
+	for (uint32_t i = 0; i < numNormals; ++i)
+	{
+		minDot = min(minDot, Dot(axis, normals[i]));
+	}
+
+	if (minDot < s_minConeDot)
+	{
+		return cullData;
+	}
+
+	// Move the apex back along the axis until it lies behind every triangle's plane
+	float maxOffset = 0.0f;
+	for (uint32_t i = 0; i < numNormals; ++i)
+	{
+		const float centerDistance = Dot(sphereCenter - planePoints[i], normals[i]);
+		const float axisDot = Dot(axis, normals[i]);
+		maxOffset = max(maxOffset, centerDistance / axisDot);
+	}
+
+	// w = -cos(angle + 90) = sin(angle), rounded up so the cone never shrinks
+	const float sinAngle = sqrtf(max(0.0f, 1.0f - minDot * minDot));
+
+	cullData.normalCone[0] = axisX;
+	cullData.normalCone[1] = axisY;
+	cullData.normalCone[2] = axisZ;
+	cullData.normalCone[3] = (uint8_t)min(255.0f, ceilf(sinAngle * 255.0f));
+	cullData.apexOffset = maxOffset;
+
+	return cullData;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+bool BuildMeshlets(span<const std::byte> positions, uint32_t positionStride, span<const std::byte> indices, uint32_t indexSize, const MeshletBuildDesc& desc, MeshletData& outData)
+{
+	outData = MeshletData{};
+
+	if (positionStride < sizeof(Float3) || (indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t)))
+	{
+		return false;
+	}
+
+	if (desc.maxVertices < 3 || desc.maxVertices > MaxMeshletVertices || desc.maxPrimitives == 0 || desc.maxPrimitives > MaxMeshletPrimitives)
+	{
+		return false;
+	}
+
+	const size_t numIndices = indices.size() / indexSize;
+	if (numIndices % 3 != 0 || positions.size() < sizeof(Float3))
+	{
+		return false;
+	}
+
+	const uint32_t numVertices = (uint32_t)((positions.size() - sizeof(Float3)) / positionStride + 1);
+	const uint32_t numTriangles = (uint32_t)(numIndices / 3);
+
+	vector<uint32_t> triangleIndices(numIndices);
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		triangleIndices[i] = ReadIndex(indices.data(), indexSize, i);
+		if (triangleIndices[i] >= numVertices)
+		{
+			return false;
+		}
+	}
+
+	vector<Float3> vertexPositions(numVertices);
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		memcpy(&vertexPositions[i], positions.data() + (size_t)i * positionStride, sizeof(Float3));
+	}
+
+	outData.indexSize = indexSize;
+
+	// Vertex to triangle adjacency, as one row of triangles per vertex
+	vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+	for (uint32_t index : triangleIndices)
+	{
+		++adjacencyOffsets[index + 1];
+	}
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	}
+
+	vector<uint32_t> adjacency(numIndices);
+	{
+		vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < numIndices; ++i)
+		{
+			adjacency[cursors[triangleIndices[i]]++] = (uint32_t)(i / 3);
+		}
+	}
+
+	vector<Float3> triangleCentroids(numTriangles);
+	for (uint32_t i = 0; i < numTriangles; ++i)
+	{
+		const Float3& p0 = vertexPositions[triangleIndices[3 * i + 0]];
+		const Float3& p1 = vertexPositions[triangleIndices[3 * i + 1]];
+		const Float3& p2 = vertexPositions[triangleIndices[3 * i + 2]];
+		triangleCentroids[i] = (p0 + p1 + p2) * (1.0f / 3.0f);
+	}
+
+	vector<uint8_t> isEmitted(numTriangles, 0);
+	vector<uint32_t> queuedForMeshlet(numTriangles, s_invalidIndex);
+	vector<uint32_t> localVertexIndices(numVertices, s_invalidIndex);
+
+	vector<uint32_t> meshletVertices;
+	meshletVertices.reserve(desc.maxVertices);
+
+	vector<uint32_t> candidates;
+
+	// Rough upper bound, most meshes are limited by the vertex count
+	outData.meshlets.reserve(numTriangles / min(desc.maxPrimitives, desc.maxVertices / 2 + 1) + 1);
+	outData.primitiveIndices.reserve(numTriangles);
+
+	auto CountNewVertices = [&](uint32_t triangle)
+	{
+		const uint32_t a = triangleIndices[3 * triangle + 0];
+		const uint32_t b = triangleIndices[3 * triangle + 1];
+		const uint32_t c = triangleIndices[3 * triangle + 2];
+
+		uint32_t count = (localVertexIndices[a] == s_invalidIndex) ? 1 : 0;
+		count += (localVertexIndices[b] == s_invalidIndex && b != a) ? 1 : 0;
+		count += (localVertexIndices[c] == s_invalidIndex && c != a && c != b) ? 1 : 0;
+		return count;
+	};
+
+	uint32_t numEmitted = 0;
+	uint32_t nextSeed = 0;
+
+	while (numEmitted < numTriangles)
+	{
+		const uint32_t meshletIndex = (uint32_t)outData.meshlets.size();
+
+		Meshlet meshlet{
+			.vertCount	= 0,
+			.vertOffset	= (uint32_t)(outData.uniqueVertexIndices.size() / indexSize),
+			.primCount	= 0,
+			.primOffset	= (uint32_t)outData.primitiveIndices.size()
+		};
+
+		meshletVertices.clear();
+		candidates.clear();
+		Float3 positionSum;
+
+		while (meshlet.primCount < desc.maxPrimitives)
+		{
+			if (candidates.empty())
+			{
+				// Nothing connected is left, so continue with the next free triangle in index order.  Meshes are
+				// usually optimized for the vertex cache, so it tends to be nearby.
+				while (nextSeed < numTriangles && isEmitted[nextSeed])
+				{
+					++nextSeed;
+				}
+
+				if (nextSeed == numTriangles)
+				{
+					break;
+				}
+
+				queuedForMeshlet[nextSeed] = meshletIndex;
+				candidates.push_back(nextSeed);
+			}
+
+			// Prefer the triangle that adds the fewest new vertices, then the one closest to the meshlet's center,
+			// which keeps meshlets compact and their bounds tight
+			const Float3 center = meshletVertices.empty()
+				? positionSum
+				: positionSum * (1.0f / (float)meshletVertices.size());
+
+			uint32_t bestTriangle = s_invalidIndex;
+			uint32_t bestNewVertices = s_invalidIndex;
+			float bestDistanceSq = numeric_limits<float>::max();
+
+			size_t numCandidates = 0;
+			for (size_t i = 0; i < candidates.size(); ++i)
+			{
+				const uint32_t triangle = candidates[i];
+				if (isEmitted[triangle])
+				{
+					continue;
+				}
+				candidates[numCandidates++] = triangle;
+
+				const uint32_t newVertices = CountNewVertices(triangle);
+				if (meshletVertices.size() + newVertices > desc.maxVertices)
+				{
+					continue;
+				}
+
+				const float distanceSq = meshletVertices.empty()
+					? 0.0f
+					: Dot(triangleCentroids[triangle] - center, triangleCentroids[triangle] - center);
+
+				if (newVertices < bestNewVertices || (newVertices == bestNewVertices && distanceSq < bestDistanceSq))
+				{
+					bestTriangle = triangle;
+					bestNewVertices = newVertices;
+					bestDistanceSq = distanceSq;
+				}
+			}
+			candidates.resize(numCandidates);
+
+			if (bestTriangle == s_invalidIndex)
+			{
+				break;
+			}
+
+			isEmitted[bestTriangle] = 1;
+			++numEmitted;
+
+			uint32_t localIndices[3];
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				const uint32_t vertex = triangleIndices[3 * bestTriangle + i];
+				if (localVertexIndices[vertex] == s_invalidIndex)
+				{
+					localVertexIndices[vertex] = (uint32_t)meshletVertices.size();
+					meshletVertices.push_back(vertex);
+					positionSum = positionSum + vertexPositions[vertex];
+
+					// Triangles around the vertices already in the meshlet were queued earlier
+					for (uint32_t j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex + 1]; ++j)
+					{
+						const uint32_t neighbor = adjacency[j];
+						if (!isEmitted[neighbor] && queuedForMeshlet[neighbor] != meshletIndex)
+						{
+							queuedForMeshlet[neighbor] = meshletIndex;
+							candidates.push_back(neighbor);
+						}
+					}
+				}
+				localIndices[i] = localVertexIndices[vertex];
+			}
+
+			MeshletTriangle packedTriangle{};
+			packedTriangle.i0 = localIndices[0];
+			packedTriangle.i1 = localIndices[1];
+			packedTriangle.i2 = localIndices[2];
+			outData.primitiveIndices.push_back(packedTriangle);
+			++meshlet.primCount;
+		}
+
+		meshlet.vertCount = (uint32_t)meshletVertices.size();
+
+		const size_t indexOffset = outData.uniqueVertexIndices.size() / indexSize;
+		outData.uniqueVertexIndices.resize(outData.uniqueVertexIndices.size() + meshletVertices.size() * indexSize);
+		for (size_t i = 0; i < meshletVertices.size(); ++i)
+		{
+			WriteIndex(outData.uniqueVertexIndices.data(), indexSize, indexOffset + i, meshletVertices[i]);
+			localVertexIndices[meshletVertices[i]] = s_invalidIndex;
+		}
+
+		const span<const MeshletTriangle> meshletTriangles{ outData.primitiveIndices.data() + meshlet.primOffset, meshlet.primCount };
+		outData.cullData.push_back(ComputeCullData(vertexPositions, meshletVertices, meshletTriangles));
+
+		outData.meshlets.push_back(meshlet);
+	}
+
+	return true;
+}
+
+} // namespace Luna
@@ -0,0 +1,71 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+namespace Luna
+{
+
+// Primitive indices are packed into 10 bits each, and the mesh shaders use one thread per vertex and primitive
+constexpr uint32_t MaxMeshletVertices = 256;
+constexpr uint32_t MaxMeshletPrimitives = 256;
+
+
+// The following structs match the layout of the buffers read by the meshlet amplification and mesh shaders
+struct Meshlet
+{
+	uint32_t vertCount{ 0 };
+	uint32_t vertOffset{ 0 };
+	uint32_t primCount{ 0 };
+	uint32_t primOffset{ 0 };
+};
+
+
+struct MeshletTriangle
+{
+	uint32_t i0 : 10;
+	uint32_t i1 : 10;
+	uint32_t i2 : 10;
+};
+
+
+struct MeshletCullData
+{
+	float boundingSphere[4];				// xyz = center, w = radius
+	uint8_t normalCone[4];					// xyz = axis, w = -cos(a + 90), w == 0xff means the cone is degenerate
+	float apexOffset;						// apex = center - axis * offset
+};
+
+
+struct MeshletBuildDesc
+{
+	uint32_t maxVertices{ 64 };
+	uint32_t maxPrimitives{ 126 };
+};
+
+
+// Meshlets for one mesh.  uniqueVertexIndices holds indexSize-byte indices into the mesh's vertex buffer, and
+// each meshlet's vertOffset and primOffset count elements, not bytes.
+struct MeshletData
+{
+	uint32_t indexSize{ 4 };
+	std::vector<Meshlet> meshlets;
+	std::vector<std::byte> uniqueVertexIndices;
+	std::vector<MeshletTriangle> primitiveIndices;
+	std::vector<MeshletCullData> cullData;
+};
+
+
+// Splits an indexed triangle list into meshlets and computes their culling data.  Positions are read as three
+// floats at the start of each positionStride-byte vertex.  The output only depends on the input, so it is
+// the same regardless of which thread builds it.
+bool BuildMeshlets(std::span<const std::byte> positions, uint32_t positionStride, std::span<const std::byte> indices, uint32_t indexSize, const MeshletBuildDesc& desc, MeshletData& outData);
+
+} // namespace Luna
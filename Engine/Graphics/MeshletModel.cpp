@@ -15,21 +15,21 @@
 #include "BinaryReader.h"
 #include "FileSystem.h"
 #include "Graphics\Device.h"
+#include "Graphics\Formats.h"
 
-using namespace Luna;
-using namespace Math;
+using namespace DirectX;
 using namespace std;
 
 
 namespace
 {
 
-vector<VertexElementDesc> c_vertexElements{
-	{ "POSITION", 0, Format::RGB32_Float, 0, APPEND_ALIGNED_ELEMENT, InputClassification::PerVertexData, 1 },
-	{ "NORMAL", 0, Format::RGB32_Float, 0, APPEND_ALIGNED_ELEMENT, InputClassification::PerVertexData, 1 },
-	{ "TEXCOORD", 0, Format::RG32_Float, 0, APPEND_ALIGNED_ELEMENT, InputClassification::PerVertexData, 1 },
-	{ "TANGENT", 0, Format::RGB32_Float, 0, APPEND_ALIGNED_ELEMENT, InputClassification::PerVertexData, 1 },
-	{ "BITANGENT", 0, Format::RGB32_Float, 0, APPEND_ALIGNED_ELEMENT, InputClassification::PerVertexData, 1 }
+vector<Luna::VertexElementDesc> c_vertexElements{
+	{ "POSITION", 0, Luna::Format::RGB32_Float, 0, Luna::APPEND_ALIGNED_ELEMENT, Luna::InputClassification::PerVertexData, 1 },
+	{ "NORMAL", 0, Luna::Format::RGB32_Float, 0, Luna::APPEND_ALIGNED_ELEMENT, Luna::InputClassification::PerVertexData, 1 },
+	{ "TEXCOORD", 0, Luna::Format::RG32_Float, 0, Luna::APPEND_ALIGNED_ELEMENT, Luna::InputClassification::PerVertexData, 1 },
+	{ "TANGENT", 0, Luna::Format::RGB32_Float, 0, Luna::APPEND_ALIGNED_ELEMENT, Luna::InputClassification::PerVertexData, 1 },
+	{ "BITANGENT", 0, Luna::Format::RGB32_Float, 0, Luna::APPEND_ALIGNED_ELEMENT, Luna::InputClassification::PerVertexData, 1 }
 };
 
 const uint32_t c_prolog = 'MSHL';
@@ -84,9 +84,42 @@ struct Accessor
 	uint32_t count;
 };
 
+
+// Finds the vertex buffer with the position attribute, and the byte offset of the positions within it
+void GetPositionStream(const Luna::MeshletMesh& mesh, uint32_t& outBufferIndex, uint32_t& outOffset)
+{
+	outBufferIndex = 0;
+	outOffset = 0;
+
+	for (const auto& desc : mesh.layoutElems)
+	{
+		if (strcmp(desc.semanticName, "POSITION") == 0)
+		{
+			outBufferIndex = desc.inputSlot;
+			break;
+		}
+	}
+
+	for (const auto& desc : mesh.layoutElems)
+	{
+		if (strcmp(desc.semanticName, "POSITION") == 0)
+		{
+			break;
+		}
+
+		if (desc.inputSlot == outBufferIndex)
+		{
+			outOffset += Luna::BlockSize(desc.format);
+		}
+	}
+}
+
 } // anonymous namespace
 
 
+namespace Luna
+{
+
 HRESULT MeshletModel::LoadFromFile(const string& filename)
 {
 	string filepath = GetFileSystem()->GetFullPath(filename);
@@ -152,7 +185,7 @@ HRESULT MeshletModel::LoadFromFile(const string& filename)
 			const Accessor& accessor = accessors[meshView.indexSubsets];
 			const BufferView& bufferView = bufferViews[accessor.bufferView];
 
-			mesh.indexSubsets = span<Subset>(reinterpret_cast<Subset*>(m_buffer.data() + bufferView.offset), accessor.count);
+			mesh.indexSubsets = span<MeshletSubset>(reinterpret_cast<MeshletSubset*>(m_buffer.data() + bufferView.offset), accessor.count);
 		}
 
 		// Vertex data & layout metadata
@@ -214,7 +247,7 @@ HRESULT MeshletModel::LoadFromFile(const string& filename)
 			const Accessor& accessor = accessors[meshView.meshletSubsets];
 			const BufferView& bufferView = bufferViews[accessor.bufferView];
 
-			mesh.meshletSubsets = { reinterpret_cast<Subset*>(m_buffer.data() + bufferView.offset), accessor.count };
+			mesh.meshletSubsets = { reinterpret_cast<MeshletSubset*>(m_buffer.data() + bufferView.offset), accessor.count };
 		}
 
 		// Unique Vertex Index data
@@ -230,7 +263,7 @@ HRESULT MeshletModel::LoadFromFile(const string& filename)
 			const Accessor& accessor = accessors[meshView.primitiveIndices];
 			const BufferView& bufferView = bufferViews[accessor.bufferView];
 
-			mesh.primitiveIndices = { reinterpret_cast<PackedTriangle*>(m_buffer.data() + bufferView.offset), accessor.count };
+			mesh.primitiveIndices = { reinterpret_cast<MeshletTriangle*>(m_buffer.data() + bufferView.offset), accessor.count };
 		}
 
 		// Cull data
@@ -238,7 +271,7 @@ HRESULT MeshletModel::LoadFromFile(const string& filename)
 			const Accessor& accessor = accessors[meshView.cullData];
 			const BufferView& bufferView = bufferViews[accessor.bufferView];
 
-			mesh.cullingData = { reinterpret_cast<CullData*>(m_buffer.data() + bufferView.offset), accessor.count };
+			mesh.cullingData = { reinterpret_cast<MeshletCullData*>(m_buffer.data() + bufferView.offset), accessor.count };
 		}
 	}
 
@@ -248,39 +281,13 @@ HRESULT MeshletModel::LoadFromFile(const string& filename)
 		auto& m = m_meshes[i];
 
 		uint32_t vbIndexPos = 0;
-
-		// Find the index of the vertex buffer of the position attribute
-		for (uint32_t j = 1; (uint32_t)j < m.layoutElems.size(); ++j)
-		{
-			auto& desc = m.layoutElems[j];
-			if (strcmp(desc.semanticName, "POSITION") == 0)
-			{
-				vbIndexPos = j;
-				break;
-			}
-		}
-
-		// Find the byte offset of the position attribute with its vertex buffer
 		uint32_t positionOffset = 0;
-
-		for (uint32_t j = 0; (uint32_t)j < m.layoutElems.size(); ++j)
-		{
-			auto& desc = m.layoutElems[j];
-			if (strcmp(desc.semanticName, "POSITION") == 0)
-			{
-				break;
-			}
-
-			if (desc.inputSlot == vbIndexPos)
-			{
-				positionOffset += BlockSize(m.layoutElems[j].format);
-			}
-		}
+		GetPositionStream(m, vbIndexPos, positionOffset);
 
 		XMFLOAT3* v0 = reinterpret_cast<XMFLOAT3*>(m.vertices[vbIndexPos].data() + positionOffset);
 		uint32_t stride = m.vertexStrides[vbIndexPos];
 
-		DirectX::BoundingSphere::CreateFromPoints(m.boundingSphere, m.vertexCount, v0, stride);
+		BoundingSphere::CreateFromPoints(m.boundingSphere, m.vertexCount, v0, stride);
 
 		if (i == 0)
 		{
@@ -288,7 +295,7 @@ HRESULT MeshletModel::LoadFromFile(const string& filename)
 		}
 		else
 		{
-			DirectX::BoundingSphere::CreateMerged(m_boundingSphere, m_boundingSphere, m.boundingSphere);
+			BoundingSphere::CreateMerged(m_boundingSphere, m_boundingSphere, m.boundingSphere);
 		}
 	}
 	
@@ -296,6 +303,62 @@ HRESULT MeshletModel::LoadFromFile(const string& filename)
 }
 
 
+bool MeshletModel::RebuildMeshlets(const MeshletBuildDesc& desc)
+{
+	for (auto& m : m_meshes)
+	{
+		uint32_t vbIndexPos = 0;
+		uint32_t positionOffset = 0;
+		GetPositionStream(m, vbIndexPos, positionOffset);
+
+		const span<const std::byte> positions = span<const std::byte>{ m.vertices[vbIndexPos] }.subspan(positionOffset);
+
+		MeshletData& built = m.builtMeshlets;
+		built = MeshletData{ .indexSize = m.indexSize };
+		m.builtMeshletSubsets.clear();
+
+		// The meshlet shaders draw one index subset at a time, so meshlets must not straddle two of them
+		for (const auto& indexSubset : m.indexSubsets)
+		{
+			MeshletData subsetMeshlets;
+			const auto indices = m.indices.subspan((size_t)indexSubset.offset * m.indexSize, (size_t)indexSubset.count * m.indexSize);
+			if (!BuildMeshlets(positions, m.vertexStrides[vbIndexPos], indices, m.indexSize, desc, subsetMeshlets))
+			{
+				LogWarning(LogGraphics) << "Failed to build meshlets, keeping the ones from the file" << endl;
+				return false;
+			}
+
+			const uint32_t vertOffset = (uint32_t)(built.uniqueVertexIndices.size() / m.indexSize);
+			const uint32_t primOffset = (uint32_t)built.primitiveIndices.size();
+
+			m.builtMeshletSubsets.push_back(MeshletSubset{ .offset = (uint32_t)built.meshlets.size(), .count = (uint32_t)subsetMeshlets.meshlets.size() });
+
+			for (auto meshlet : subsetMeshlets.meshlets)
+			{
+				meshlet.vertOffset += vertOffset;
+				meshlet.primOffset += primOffset;
+				built.meshlets.push_back(meshlet);
+			}
+			built.uniqueVertexIndices.insert(built.uniqueVertexIndices.end(), subsetMeshlets.uniqueVertexIndices.begin(), subsetMeshlets.uniqueVertexIndices.end());
+			built.primitiveIndices.insert(built.primitiveIndices.end(), subsetMeshlets.primitiveIndices.begin(), subsetMeshlets.primitiveIndices.end());
+			built.cullData.insert(built.cullData.end(), subsetMeshlets.cullData.begin(), subsetMeshlets.cullData.end());
+		}
+	}
+
+	// Only switch over once every mesh has built, so a failure leaves the model as it was loaded
+	for (auto& m : m_meshes)
+	{
+		m.meshletSubsets = m.builtMeshletSubsets;
+		m.meshlets = m.builtMeshlets.meshlets;
+		m.uniqueVertexIndices = { reinterpret_cast<uint8_t*>(m.builtMeshlets.uniqueVertexIndices.data()), m.builtMeshlets.uniqueVertexIndices.size() };
+		m.primitiveIndices = m.builtMeshlets.primitiveIndices;
+		m.cullingData = m.builtMeshlets.cullData;
+	}
+
+	return true;
+}
+
+
 HRESULT MeshletModel::InitResources(IDevice* device)
 {
 	// Create GpuBuffers
@@ -364,7 +427,7 @@ HRESULT MeshletModel::InitResources(IDevice* device)
 				.resourceType	= ResourceType::StructuredBuffer,
 				.memoryAccess	= MemoryAccess::GpuRead,
 				.elementCount	= m.primitiveIndices.size(),
-				.elementSize	= sizeof(PackedTriangle),
+				.elementSize	= sizeof(MeshletTriangle),
 				.initialData	= m.primitiveIndices.data()
 			};
 			m.primitiveIndexResource = device->CreateGpuBuffer(desc);
@@ -377,7 +440,7 @@ HRESULT MeshletModel::InitResources(IDevice* device)
 				.resourceType	= ResourceType::StructuredBuffer,
 				.memoryAccess	= MemoryAccess::GpuRead,
 				.elementCount	= m.cullingData.size(),
-				.elementSize	= sizeof(CullData),
+				.elementSize	= sizeof(MeshletCullData),
 				.initialData	= m.cullingData.data()
 			};
 			m.cullDataResource = device->CreateGpuBuffer(desc);
@@ -385,7 +448,7 @@ HRESULT MeshletModel::InitResources(IDevice* device)
 
 		// MeshInfo resource
 		{
-			MeshInfo info{
+			MeshletMeshInfo info{
 				.indexSize				= m.indexSize,
 				.meshletCount			= (uint32_t)m.meshlets.size(),
 				.lastMeshletVertCount	= m.meshlets.back().vertCount,
@@ -397,7 +460,7 @@ HRESULT MeshletModel::InitResources(IDevice* device)
 				.resourceType	= ResourceType::ConstantBuffer,
 				.memoryAccess	= MemoryAccess::CpuWrite | MemoryAccess::GpuRead,
 				.elementCount	= 1,
-				.elementSize	= sizeof(MeshInfo),
+				.elementSize	= sizeof(MeshletMeshInfo),
 				.initialData	= &info
 			};
 			m.meshInfoResource = device->CreateGpuBuffer(desc);
@@ -405,4 +468,6 @@ HRESULT MeshletModel::InitResources(IDevice* device)
 	}
 
 	return S_OK;
-}
\ No newline at end of file
+}
+
+} // namespace Luna
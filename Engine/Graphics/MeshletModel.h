@@ -12,25 +12,27 @@
 
 #include "Graphics\GpuBuffer.h"
 #include "Graphics\InputLayout.h"
+#include "Graphics\MeshletBuilder.h"
 
-#include "DirectXCollision.h"
+#include <DirectXCollision.h>
 
 
-// Forward declarations
 namespace Luna
 {
+
+// Forward declarations
 class IDevice;
-} // namespace Luna
 
 
-struct Subset
+struct MeshletSubset
 {
 	uint32_t offset{ 0 };
 	uint32_t count{ 0 };
 };
 
 
-struct MeshInfo
+// Matches the MeshInfo constant buffer read by the meshlet shaders
+struct MeshletMeshInfo
 {
 	uint32_t indexSize{ 0 };
 	uint32_t meshletCount{ 0 };
@@ -40,58 +42,37 @@ struct MeshInfo
 };
 
 
-struct Meshlet
-{
-	uint32_t vertCount{ 0 };
-	uint32_t vertOffset{ 0 };
-	uint32_t primCount{ 0 };
-	uint32_t primOffset{ 0 };
-};
-
-
-struct PackedTriangle
-{
-	uint32_t i0 : 10;
-	uint32_t i1 : 10;
-	uint32_t i2 : 10;
-};
-
-
-struct CullData
-{
-	DirectX::BoundingSphere boundingSphere; // xyz = center, w = radius
-	uint8_t normalCone[4];  // xyz = axis, w = -cos(a + 90)
-	float apexOffset;     // apex = center - axis * offset
-};
-
-
 struct MeshletMesh
 {
-	std::vector<Luna::VertexElementDesc> layoutElems;
+	std::vector<VertexElementDesc> layoutElems;
 
 	std::vector<std::span<std::byte>> vertices;
 	std::vector<uint32_t> vertexStrides;
 	uint32_t vertexCount;
 	DirectX::BoundingSphere boundingSphere;
 
-	std::span<Subset> indexSubsets;
+	std::span<MeshletSubset> indexSubsets;
 	std::span<std::byte> indices;
 	uint32_t indexSize;
 	uint32_t indexCount;
 
-	std::span<Subset> meshletSubsets;
+	std::span<MeshletSubset> meshletSubsets;
 	std::span<Meshlet> meshlets;
 	std::span<uint8_t> uniqueVertexIndices;
-	std::span<PackedTriangle> primitiveIndices;
-	std::span<CullData> cullingData;
+	std::span<MeshletTriangle> primitiveIndices;
+	std::span<MeshletCullData> cullingData;
+
+	// Storage for meshlets built at load time, instead of the ones baked into the file
+	MeshletData builtMeshlets;
+	std::vector<MeshletSubset> builtMeshletSubsets;
 
-	std::vector<Luna::GpuBufferPtr> vertexResources;
-	Luna::GpuBufferPtr indexResource;
-	Luna::GpuBufferPtr meshletResource;
-	Luna::GpuBufferPtr uniqueVertexIndexResource;
-	Luna::GpuBufferPtr primitiveIndexResource;
-	Luna::GpuBufferPtr cullDataResource; // TODO: Get rid of this?  I don't think it's used.
-	Luna::GpuBufferPtr meshInfoResource;
+	std::vector<GpuBufferPtr> vertexResources;
+	GpuBufferPtr indexResource;
+	GpuBufferPtr meshletResource;
+	GpuBufferPtr uniqueVertexIndexResource;
+	GpuBufferPtr primitiveIndexResource;
+	GpuBufferPtr cullDataResource;
+	GpuBufferPtr meshInfoResource;
 
 	// Calculates the number of instances of the last meshlet which can be packed into a single threadgroup.
 	uint32_t GetLastMeshletPackCount(uint32_t subsetIndex, uint32_t maxGroupVerts, uint32_t maxGroupPrims) const
@@ -132,11 +113,17 @@ struct MeshletMesh
 };
 
 
+// Loads the prebaked meshlet models (.bin files with an 'MSHL' prolog) that the meshlet samples share
 class MeshletModel
 {
 public:
 	HRESULT LoadFromFile(const std::string& filename);
-	HRESULT InitResources(Luna::IDevice* device);
+
+	// Replaces the meshlets baked into the file with ones from BuildMeshlets, built separately for each index
+	// subset.  Call it after LoadFromFile and before InitResources.
+	bool RebuildMeshlets(const MeshletBuildDesc& desc = MeshletBuildDesc{});
+
+	HRESULT InitResources(IDevice* device);
 
 	uint32_t GetMeshCount() const { return static_cast<uint32_t>(m_meshes.size()); }
 	const MeshletMesh& GetMesh(uint32_t i) const { return m_meshes[i]; }
@@ -152,4 +139,6 @@ private:
 	DirectX::BoundingSphere m_boundingSphere;
 
 	std::vector<std::byte> m_buffer;
-};
\ No newline at end of file
+};
+
+} // namespace Luna
@@ -0,0 +1,886 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "MipGenerator.h"
+
+#include "TextureInitializer.h"
+
+#include "Core/CpuFeatures.h"
+
+#include <bit>
+#include <cmath>
+#include <immintrin.h>
+#include <numbers>
+#include <numeric>
+
+using namespace std;
+
+
+namespace
+{
+
+// Levels smaller than this are not worth splitting across jobs
+constexpr uint32_t s_minParallelTexels = 128 * 128;
+constexpr uint32_t s_minRowsPerBand = 8;
+
+
+enum class ChannelType : uint8_t
+{
+	UNorm8,
+	UNorm16,
+	Float32
+};
+
+
+struct MipFormatInfo
+{
+	ChannelType channelType{ ChannelType::UNorm8 };
+	uint32_t numChannels{ 0 };
+	bool isSrgb{ false };
+
+	uint32_t GetBytesPerPixel() const noexcept
+	{
+		switch (channelType)
+		{
+		case ChannelType::UNorm8:	return numChannels;
+		case ChannelType::UNorm16:	return numChannels * 2;
+		default:					return numChannels * 4;
+		}
+	}
+};
+
+
+optional<MipFormatInfo> GetMipFormatInfo(Luna::Format format)
+{
+	using enum Luna::Format;
+
+	// Channel order does not matter to the filters, only which channels are stored as sRGB
+	switch (format)
+	{
+	case R8_UNorm:			return MipFormatInfo{ ChannelType::UNorm8, 1, false };
+	case RG8_UNorm:			return MipFormatInfo{ ChannelType::UNorm8, 2, false };
+	case RGBA8_UNorm:
+	case BGRA8_UNorm:		return MipFormatInfo{ ChannelType::UNorm8, 4, false };
+	case SRGBA8_UNorm:
+	case SBGRA8_UNorm:		return MipFormatInfo{ ChannelType::UNorm8, 4, true };
+	case R16_UNorm:			return MipFormatInfo{ ChannelType::UNorm16, 1, false };
+	case RG16_UNorm:		return MipFormatInfo{ ChannelType::UNorm16, 2, false };
+	case RGBA16_UNorm:		return MipFormatInfo{ ChannelType::UNorm16, 4, false };
+	case R32_Float:			return MipFormatInfo{ ChannelType::Float32, 1, false };
+	case RG32_Float:		return MipFormatInfo{ ChannelType::Float32, 2, false };
+	case RGB32_Float:		return MipFormatInfo{ ChannelType::Float32, 3, false };
+	case RGBA32_Float:		return MipFormatInfo{ ChannelType::Float32, 4, false };
+	default:				return nullopt;
+	}
+}
+
+
+enum class KernelLevel : uint8_t
+{
+	Scalar,
+	SSE41,
+	AVX2
+};
+
+
+KernelLevel GetMaxKernelLevel() noexcept
+{
+	if (Luna::HasSSE41() && Luna::HasAVX2())
+	{
+		return KernelLevel::AVX2;
+	}
+	return Luna::HasSSE41() ? KernelLevel::SSE41 : KernelLevel::Scalar;
+}
+
+const KernelLevel s_maxKernelLevel = GetMaxKernelLevel();
+
+
+// sRGB conversion tables.  Encoding rounds to the nearest sRGB code exactly: a linear value encodes to the
+// number of thresholds at or below it, and since neighbouring thresholds are further apart than one bucket,
+// the bucket's first code is either the answer or one short of it.
+struct SrgbTables
+{
+	float toLinear[256];
+	float thresholds[256];
+	uint8_t bucketCodes[4096];
+};
+
+
+double SrgbToLinear(double value)
+{
+	return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+}
+
+
+SrgbTables BuildSrgbTables()
+{
+	SrgbTables tables{};
+
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		tables.toLinear[i] = (float)SrgbToLinear(i / 255.0);
+	}
+
+	for (uint32_t i = 0; i < 255; ++i)
+	{
+		tables.thresholds[i] = (float)SrgbToLinear((i + 0.5) / 255.0);
+	}
+	tables.thresholds[255] = numeric_limits<float>::infinity();
+
+	uint32_t code = 0;
+	for (uint32_t bucket = 0; bucket < 4096; ++bucket)
+	{
+		const float bucketStart = (float)bucket / 4096.0f;
+		while (tables.thresholds[code] <= bucketStart)
+		{
+			++code;
+		}
+		tables.bucketCodes[bucket] = (uint8_t)code;
+	}
+
+	return tables;
+}
+
+const SrgbTables s_srgbTables = BuildSrgbTables();
+
+
+// Written so that NaN saturates to 0, the same as _mm_max_ps(x, 0) followed by _mm_min_ps(x, 1)
+inline float Saturate(float value) noexcept
+{
+	value = value > 0.0f ? value : 0.0f;
+	return value < 1.0f ? value : 1.0f;
+}
+
+
+inline uint8_t LinearToSrgb8(float value) noexcept
+{
+	value = Saturate(value);
+	const uint32_t bucket = min((uint32_t)(value * 4096.0f), 4095u);
+	const uint32_t code = s_srgbTables.bucketCodes[bucket];
+	return (uint8_t)(code + (value >= s_srgbTables.thresholds[code] ? 1 : 0));
+}
+
+
+// Rows are converted to and from four linear floats per texel, whatever the channel count.  Every kernel
+// below does its arithmetic in the same order as its scalar version, without FMA, so the results do not
+// depend on which instruction set ran them.  The SIMD kernels start at texel x, and return the first texel
+// they did not process, which the next narrower kernel picks up.
+
+LUNA_TARGET_AVX2 uint32_t DecodeRowUNorm4AVX2(bool is8Bit, float scale, const std::byte* src, uint32_t x, uint32_t width, float* dst)
+{
+	const __m256 scale8 = _mm256_set1_ps(scale);
+	for (; x + 2 <= width; x += 2)
+	{
+		const __m256i texels = is8Bit
+			? _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + x * 4)))
+			: _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + x * 8)));
+		_mm256_storeu_ps(dst + x * 4, _mm256_mul_ps(_mm256_cvtepi32_ps(texels), scale8));
+	}
+	_mm256_zeroupper();
+	return x;
+}
+
+
+LUNA_TARGET_SSE41 uint32_t DecodeRowUNorm4SSE41(bool is8Bit, float scale, const std::byte* src, uint32_t x, uint32_t width, float* dst)
+{
+	const __m128 scale4 = _mm_set1_ps(scale);
+	for (; x < width; ++x)
+	{
+		const __m128i texel = is8Bit
+			? _mm_cvtepu8_epi32(_mm_loadu_si32(src + x * 4))
+			: _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(src + x * 8)));
+		_mm_storeu_ps(dst + x * 4, _mm_mul_ps(_mm_cvtepi32_ps(texel), scale4));
+	}
+	return x;
+}
+
+
+void DecodeRow(KernelLevel kernel, const MipFormatInfo& info, const std::byte* src, uint32_t width, float* dst)
+{
+	const uint32_t numChannels = info.numChannels;
+
+	if (info.isSrgb)
+	{
+		const uint8_t* src8 = (const uint8_t*)src;
+		for (uint32_t x = 0; x < width; ++x, src8 += 4, dst += 4)
+		{
+			dst[0] = s_srgbTables.toLinear[src8[0]];
+			dst[1] = s_srgbTables.toLinear[src8[1]];
+			dst[2] = s_srgbTables.toLinear[src8[2]];
+			dst[3] = (float)src8[3] * (1.0f / 255.0f);
+		}
+		return;
+	}
+
+	if (info.channelType == ChannelType::Float32)
+	{
+		const float* src32 = (const float*)src;
+		if (numChannels == 4)
+		{
+			memcpy(dst, src32, width * 4 * sizeof(float));
+			return;
+		}
+
+		for (uint32_t x = 0; x < width; ++x, src32 += numChannels, dst += 4)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				dst[c] = c < numChannels ? src32[c] : 0.0f;
+			}
+		}
+		return;
+	}
+
+	const bool is8Bit = info.channelType == ChannelType::UNorm8;
+	const float scale = is8Bit ? 1.0f / 255.0f : 1.0f / 65535.0f;
+	uint32_t x = 0;
+
+	if (numChannels == 4 && kernel == KernelLevel::AVX2)
+	{
+		x = DecodeRowUNorm4AVX2(is8Bit, scale, src, x, width, dst);
+	}
+
+	if (numChannels == 4 && kernel != KernelLevel::Scalar)
+	{
+		x = DecodeRowUNorm4SSE41(is8Bit, scale, src, x, width, dst);
+	}
+
+	for (; x < width; ++x)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			float value = 0.0f;
+			if (c < numChannels)
+			{
+				value = is8Bit
+					? (float)((const uint8_t*)src)[x * numChannels + c]
+					: (float)((const uint16_t*)src)[x * numChannels + c];
+			}
+			dst[x * 4 + c] = value * scale;
+		}
+	}
+}
+
+
+LUNA_TARGET_AVX2 uint32_t EncodeRowUNorm4AVX2(bool is8Bit, float scale, const float* src, uint32_t x, uint32_t width, std::byte* dst)
+{
+	const __m256 zero8 = _mm256_setzero_ps();
+	const __m256 one8 = _mm256_set1_ps(1.0f);
+	const __m256 scale8 = _mm256_set1_ps(scale);
+	const __m256 half8 = _mm256_set1_ps(0.5f);
+	for (; x + 2 <= width; x += 2)
+	{
+		__m256 texels = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + x * 4), zero8), one8);
+		texels = _mm256_add_ps(_mm256_mul_ps(texels, scale8), half8);
+
+		const __m256i values = _mm256_cvttps_epi32(texels);
+		const __m128i low = _mm256_castsi256_si128(values);
+		const __m128i high = _mm256_extracti128_si256(values, 1);
+		if (is8Bit)
+		{
+			const __m128i packed = _mm_packs_epi32(low, high);
+			_mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(packed, packed));
+		}
+		else
+		{
+			_mm_storeu_si128((__m128i*)(dst + x * 8), _mm_packus_epi32(low, high));
+		}
+	}
+	_mm256_zeroupper();
+	return x;
+}
+
+
+LUNA_TARGET_SSE41 uint32_t EncodeRowUNorm4SSE41(bool is8Bit, float scale, const float* src, uint32_t x, uint32_t width, std::byte* dst)
+{
+	const __m128 zero4 = _mm_setzero_ps();
+	const __m128 one4 = _mm_set1_ps(1.0f);
+	const __m128 scale4 = _mm_set1_ps(scale);
+	const __m128 half4 = _mm_set1_ps(0.5f);
+	for (; x < width; ++x)
+	{
+		__m128 texel = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + x * 4), zero4), one4);
+		texel = _mm_add_ps(_mm_mul_ps(texel, scale4), half4);
+
+		const __m128i values = _mm_cvttps_epi32(texel);
+		const __m128i packed = _mm_packus_epi32(values, values);
+		if (is8Bit)
+		{
+			_mm_storeu_si32(dst + x * 4, _mm_packus_epi16(packed, packed));
+		}
+		else
+		{
+			_mm_storel_epi64((__m128i*)(dst + x * 8), packed);
+		}
+	}
+	return x;
+}
+
+
+void EncodeRow(KernelLevel kernel, const MipFormatInfo& info, const float* src, uint32_t width, std::byte* dst)
+{
+	const uint32_t numChannels = info.numChannels;
+
+	if (info.isSrgb)
+	{
+		uint8_t* dst8 = (uint8_t*)dst;
+		for (uint32_t x = 0; x < width; ++x, src += 4, dst8 += 4)
+		{
+			dst8[0] = LinearToSrgb8(src[0]);
+			dst8[1] = LinearToSrgb8(src[1]);
+			dst8[2] = LinearToSrgb8(src[2]);
+			dst8[3] = (uint8_t)(Saturate(src[3]) * 255.0f + 0.5f);
+		}
+		return;
+	}
+
+	if (info.channelType == ChannelType::Float32)
+	{
+		float* dst32 = (float*)dst;
+		if (numChannels == 4)
+		{
+			memcpy(dst32, src, width * 4 * sizeof(float));
+			return;
+		}
+
+		for (uint32_t x = 0; x < width; ++x, src += 4, dst32 += numChannels)
+		{
+			for (uint32_t c = 0; c < numChannels; ++c)
+			{
+				dst32[c] = src[c];
+			}
+		}
+		return;
+	}
+
+	const bool is8Bit = info.channelType == ChannelType::UNorm8;
+	const float scale = is8Bit ? 255.0f : 65535.0f;
+	uint32_t x = 0;
+
+	if (numChannels == 4 && kernel == KernelLevel::AVX2)
+	{
+		x = EncodeRowUNorm4AVX2(is8Bit, scale, src, x, width, dst);
+	}
+
+	if (numChannels == 4 && kernel != KernelLevel::Scalar)
+	{
+		x = EncodeRowUNorm4SSE41(is8Bit, scale, src, x, width, dst);
+	}
+
+	for (; x < width; ++x)
+	{
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			const uint32_t value = (uint32_t)(Saturate(src[x * 4 + c]) * scale + 0.5f);
+			if (is8Bit)
+			{
+				((uint8_t*)dst)[x * numChannels + c] = (uint8_t)value;
+			}
+			else
+			{
+				((uint16_t*)dst)[x * numChannels + c] = (uint16_t)value;
+			}
+		}
+	}
+}
+
+
+LUNA_TARGET_AVX2 uint32_t BoxFilterRowsAVX2(const float* row0, const float* row1, uint32_t x, uint32_t dstWidth, float* dst)
+{
+	const __m256 quarter8 = _mm256_set1_ps(0.25f);
+	for (; x + 2 <= dstWidth; x += 2)
+	{
+		// Gather texels (0, 2) and (1, 3) of each row, so that one add pairs up both 2x2 blocks
+		const __m256 a01 = _mm256_loadu_ps(row0 + x * 8);
+		const __m256 a23 = _mm256_loadu_ps(row0 + x * 8 + 8);
+		const __m256 b01 = _mm256_loadu_ps(row1 + x * 8);
+		const __m256 b23 = _mm256_loadu_ps(row1 + x * 8 + 8);
+
+		const __m256 sumA = _mm256_add_ps(_mm256_permute2f128_ps(a01, a23, 0x20), _mm256_permute2f128_ps(a01, a23, 0x31));
+		const __m256 sumB = _mm256_add_ps(_mm256_permute2f128_ps(b01, b23, 0x20), _mm256_permute2f128_ps(b01, b23, 0x31));
+		_mm256_storeu_ps(dst + x * 4, _mm256_mul_ps(_mm256_add_ps(sumA, sumB), quarter8));
+	}
+	_mm256_zeroupper();
+	return x;
+}
+
+
+uint32_t BoxFilterRowsSSE(const float* row0, const float* row1, uint32_t x, uint32_t dstWidth, float* dst)
+{
+	const __m128 quarter4 = _mm_set1_ps(0.25f);
+	for (; x < dstWidth; ++x)
+	{
+		const __m128 sumA = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+		const __m128 sumB = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+		_mm_storeu_ps(dst + x * 4, _mm_mul_ps(_mm_add_ps(sumA, sumB), quarter4));
+	}
+	return x;
+}
+
+
+// 2x2 box filter for levels whose source dimensions are both even.  row0 and row1 hold 2 * dstWidth texels.
+void BoxFilterRows(KernelLevel kernel, const float* row0, const float* row1, uint32_t dstWidth, float* dst)
+{
+	uint32_t x = 0;
+
+	if (kernel == KernelLevel::AVX2)
+	{
+		x = BoxFilterRowsAVX2(row0, row1, x, dstWidth, dst);
+	}
+
+	if (kernel != KernelLevel::Scalar)
+	{
+		x = BoxFilterRowsSSE(row0, row1, x, dstWidth, dst);
+	}
+
+	for (; x < dstWidth; ++x)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			const float sumA = row0[x * 8 + c] + row0[x * 8 + 4 + c];
+			const float sumB = row1[x * 8 + c] + row1[x * 8 + 4 + c];
+			dst[x * 4 + c] = (sumA + sumB) * 0.25f;
+		}
+	}
+}
+
+
+// Resampling weights along one axis.  Each destination texel reads numTaps consecutive source texels, starting
+// at firstTap.  Taps that fall past either edge are folded onto the edge texel, which clamps the image.
+struct FilterTable
+{
+	uint32_t numTaps{ 0 };
+	vector<uint32_t> firstTap;
+	vector<float> weights;
+};
+
+
+double LanczosWeight(double x)
+{
+	constexpr double radius = 2.0;
+
+	x = fabs(x);
+	if (x < 1e-8)
+	{
+		return 1.0;
+	}
+	if (x >= radius)
+	{
+		return 0.0;
+	}
+
+	const double pix = numbers::pi * x;
+	return radius * sin(pix) * sin(pix / radius) / (pix * pix);
+}
+
+
+FilterTable BuildFilterTable(Luna::MipFilter filter, uint32_t srcSize, uint32_t dstSize)
+{
+	const double scale = (double)srcSize / (double)dstSize;
+	const double halfWidth = (filter == Luna::MipFilter::Box ? 0.5 : 2.0) * scale;
+	const int32_t lastTexel = (int32_t)srcSize - 1;
+
+	auto GetTapRange = [&](uint32_t i)
+		{
+			const double center = (i + 0.5) * scale;
+			const int32_t begin = (int32_t)floor(center - halfWidth);
+			const int32_t end = (int32_t)ceil(center + halfWidth);
+			return make_pair(begin, end);
+		};
+
+	FilterTable table;
+	for (uint32_t i = 0; i < dstSize; ++i)
+	{
+		const auto [begin, end] = GetTapRange(i);
+		const int32_t first = clamp(begin, 0, lastTexel);
+		const int32_t last = clamp(end - 1, 0, lastTexel);
+		table.numTaps = max(table.numTaps, (uint32_t)(last - first + 1));
+	}
+
+	table.firstTap.resize(dstSize);
+	table.weights.resize((size_t)dstSize * table.numTaps);
+
+	vector<double> weights(table.numTaps);
+	for (uint32_t i = 0; i < dstSize; ++i)
+	{
+		const double center = (i + 0.5) * scale;
+		const auto [begin, end] = GetTapRange(i);
+		const uint32_t firstTap = (uint32_t)min(clamp(begin, 0, lastTexel), (int32_t)(srcSize - table.numTaps));
+
+		fill(weights.begin(), weights.end(), 0.0);
+		double totalWeight = 0.0;
+		for (int32_t j = begin; j < end; ++j)
+		{
+			double weight = 0.0;
+			if (filter == Luna::MipFilter::Box)
+			{
+				// Fraction of the source texel covered by the footprint
+				weight = max(0.0, min(j + 1.0, center + halfWidth) - max((double)j, center - halfWidth));
+			}
+			else
+			{
+				weight = LanczosWeight((j + 0.5 - center) / scale);
+			}
+
+			weights[clamp(j, 0, lastTexel) - firstTap] += weight;
+			totalWeight += weight;
+		}
+
+		table.firstTap[i] = firstTap;
+		for (uint32_t k = 0; k < table.numTaps; ++k)
+		{
+			table.weights[(size_t)i * table.numTaps + k] = (float)(weights[k] / totalWeight);
+		}
+	}
+
+	return table;
+}
+
+
+LUNA_TARGET_AVX2 uint32_t FilterRowAVX2(const FilterTable& table, const float* src, uint32_t x, uint32_t dstWidth, float* dst)
+{
+	const uint32_t numTaps = table.numTaps;
+
+	// Two destination texels at a time, one per 128-bit lane
+	for (; x + 2 <= dstWidth; x += 2)
+	{
+		const float* src0 = src + table.firstTap[x] * 4;
+		const float* src1 = src + table.firstTap[x + 1] * 4;
+		const float* weights0 = &table.weights[(size_t)x * numTaps];
+		const float* weights1 = weights0 + numTaps;
+
+		__m256 sum = _mm256_setzero_ps();
+		for (uint32_t k = 0; k < numTaps; ++k)
+		{
+			const __m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src0 + k * 4)), _mm_loadu_ps(src1 + k * 4), 1);
+			const __m256 weights = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights0[k])), _mm_set1_ps(weights1[k]), 1);
+			sum = k == 0 ? _mm256_mul_ps(weights, texels) : _mm256_add_ps(sum, _mm256_mul_ps(weights, texels));
+		}
+		_mm256_storeu_ps(dst + x * 4, sum);
+	}
+	_mm256_zeroupper();
+	return x;
+}
+
+
+uint32_t FilterRowSSE(const FilterTable& table, const float* src, uint32_t x, uint32_t dstWidth, float* dst)
+{
+	const uint32_t numTaps = table.numTaps;
+
+	for (; x < dstWidth; ++x)
+	{
+		const float* srcTexels = src + table.firstTap[x] * 4;
+		const float* weights = &table.weights[(size_t)x * numTaps];
+
+		__m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(srcTexels));
+		for (uint32_t k = 1; k < numTaps; ++k)
+		{
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(srcTexels + k * 4)));
+		}
+		_mm_storeu_ps(dst + x * 4, sum);
+	}
+	return x;
+}
+
+
+void FilterRow(KernelLevel kernel, const FilterTable& table, const float* src, uint32_t dstWidth, float* dst)
+{
+	const uint32_t numTaps = table.numTaps;
+	uint32_t x = 0;
+
+	if (kernel == KernelLevel::AVX2)
+	{
+		x = FilterRowAVX2(table, src, x, dstWidth, dst);
+	}
+
+	if (kernel != KernelLevel::Scalar)
+	{
+		x = FilterRowSSE(table, src, x, dstWidth, dst);
+	}
+
+	for (; x < dstWidth; ++x)
+	{
+		const float* srcTexels = src + table.firstTap[x] * 4;
+		const float* weights = &table.weights[(size_t)x * numTaps];
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			float sum = weights[0] * srcTexels[c];
+			for (uint32_t k = 1; k < numTaps; ++k)
+			{
+				sum = sum + weights[k] * srcTexels[k * 4 + c];
+			}
+			dst[x * 4 + c] = sum;
+		}
+	}
+}
+
+
+LUNA_TARGET_AVX2 uint32_t BlendRowsAVX2(const float* const* rows, const float* weights, uint32_t numTaps, uint32_t i, uint32_t numFloats, float* dst)
+{
+	for (; i + 8 <= numFloats; i += 8)
+	{
+		__m256 sum = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + i));
+		for (uint32_t k = 1; k < numTaps; ++k)
+		{
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+		}
+		_mm256_storeu_ps(dst + i, sum);
+	}
+	_mm256_zeroupper();
+	return i;
+}
+
+
+uint32_t BlendRowsSSE(const float* const* rows, const float* weights, uint32_t numTaps, uint32_t i, uint32_t numFloats, float* dst)
+{
+	for (; i + 4 <= numFloats; i += 4)
+	{
+		__m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+		for (uint32_t k = 1; k < numTaps; ++k)
+		{
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+		}
+		_mm_storeu_ps(dst + i, sum);
+	}
+	return i;
+}
+
+
+// Weighted sum of numTaps rows of numFloats floats each
+void BlendRows(KernelLevel kernel, const float* const* rows, const float* weights, uint32_t numTaps, uint32_t numFloats, float* dst)
+{
+	uint32_t i = 0;
+
+	if (kernel == KernelLevel::AVX2)
+	{
+		i = BlendRowsAVX2(rows, weights, numTaps, i, numFloats, dst);
+	}
+
+	if (kernel != KernelLevel::Scalar)
+	{
+		i = BlendRowsSSE(rows, weights, numTaps, i, numFloats, dst);
+	}
+
+	for (; i < numFloats; ++i)
+	{
+		float sum = weights[0] * rows[0][i];
+		for (uint32_t k = 1; k < numTaps; ++k)
+		{
+			sum = sum + weights[k] * rows[k][i];
+		}
+		dst[i] = sum;
+	}
+}
+
+
+struct MipLevelContext
+{
+	MipFormatInfo formatInfo;
+	KernelLevel kernel{ KernelLevel::Scalar };
+
+	const std::byte* src{ nullptr };
+	uint32_t srcWidth{ 0 };
+	uint32_t srcHeight{ 0 };
+	size_t srcRowPitch{ 0 };
+
+	std::byte* dst{ nullptr };
+	uint32_t dstWidth{ 0 };
+	uint32_t dstHeight{ 0 };
+	size_t dstRowPitch{ 0 };
+
+	bool isBox2x2{ false };
+	FilterTable horizontal;
+	FilterTable vertical;
+};
+
+
+// Produces destination rows [firstRow, endRow).  Bands are independent, so they can run on any thread.
+void GenerateBand(const MipLevelContext& level, uint32_t firstRow, uint32_t endRow)
+{
+	const size_t srcFloats = (size_t)level.srcWidth * 4;
+	const size_t dstFloats = (size_t)level.dstWidth * 4;
+
+	vector<float> result(dstFloats);
+
+	if (level.isBox2x2)
+	{
+		vector<float> row0(srcFloats);
+		vector<float> row1(srcFloats);
+
+		for (uint32_t y = firstRow; y < endRow; ++y)
+		{
+			DecodeRow(level.kernel, level.formatInfo, level.src + (2 * y) * level.srcRowPitch, level.srcWidth, row0.data());
+			DecodeRow(level.kernel, level.formatInfo, level.src + (2 * y + 1) * level.srcRowPitch, level.srcWidth, row1.data());
+			BoxFilterRows(level.kernel, row0.data(), row1.data(), level.dstWidth, result.data());
+			EncodeRow(level.kernel, level.formatInfo, result.data(), level.dstWidth, level.dst + y * level.dstRowPitch);
+		}
+		return;
+	}
+
+	// Filter every source row the band reads horizontally first, then blend those rows vertically
+	const uint32_t numTaps = level.vertical.numTaps;
+	const uint32_t firstSrcRow = level.vertical.firstTap[firstRow];
+	const uint32_t endSrcRow = level.vertical.firstTap[endRow - 1] + numTaps;
+
+	vector<float> decodedRow(srcFloats);
+	vector<float> filteredRows((endSrcRow - firstSrcRow) * dstFloats);
+
+	for (uint32_t row = firstSrcRow; row < endSrcRow; ++row)
+	{
+		DecodeRow(level.kernel, level.formatInfo, level.src + row * level.srcRowPitch, level.srcWidth, decodedRow.data());
+		FilterRow(level.kernel, level.horizontal, decodedRow.data(), level.dstWidth, &filteredRows[(row - firstSrcRow) * dstFloats]);
+	}
+
+	vector<const float*> rows(numTaps);
+	for (uint32_t y = firstRow; y < endRow; ++y)
+	{
+		for (uint32_t k = 0; k < numTaps; ++k)
+		{
+			rows[k] = &filteredRows[(level.vertical.firstTap[y] + k - firstSrcRow) * dstFloats];
+		}
+
+		BlendRows(level.kernel, rows.data(), &level.vertical.weights[(size_t)y * numTaps], numTaps, (uint32_t)dstFloats, result.data());
+		EncodeRow(level.kernel, level.formatInfo, result.data(), level.dstWidth, level.dst + y * level.dstRowPitch);
+	}
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+uint32_t GetFullMipCount(uint32_t width, uint32_t height)
+{
+	return (uint32_t)bit_width(max(max(width, height), 1u));
+}
+
+
+bool IsMipGenerationSupported(Format format)
+{
+	return GetMipFormatInfo(format).has_value();
+}
+
+
+bool GenerateMipChain(const MipGenerationDesc& desc, const std::byte* srcData, vector<std::byte>& outStorage, TextureInitializer& outTexInit)
+{
+	const auto formatInfo = GetMipFormatInfo(desc.format);
+	if (!formatInfo || desc.width == 0 || desc.height == 0 || srcData == nullptr)
+	{
+		return false;
+	}
+
+	const uint32_t fullMipCount = GetFullMipCount(desc.width, desc.height);
+	const uint32_t numMips = desc.numMips == 0 ? fullMipCount : min(desc.numMips, fullMipCount);
+
+	// Vulkan buffer offsets must be a multiple of both the texel size and 4 bytes
+	const size_t bytesPerPixel = formatInfo->GetBytesPerPixel();
+	const size_t levelAlignment = lcm(bytesPerPixel, (size_t)4);
+
+	outTexInit.format = desc.format;
+	outTexInit.dimension = TextureDimension::Texture2D;
+	outTexInit.width = desc.width;
+	outTexInit.height = desc.height;
+	outTexInit.arraySizeOrDepth = 1;
+	outTexInit.numMips = numMips;
+	outTexInit.subResourceData.clear();
+	outTexInit.subResourceData.reserve(numMips);
+
+	size_t totalBytes = 0;
+	for (uint32_t mipLevel = 0; mipLevel < numMips; ++mipLevel)
+	{
+		const uint32_t width = max(desc.width >> mipLevel, 1u);
+		const uint32_t height = max(desc.height >> mipLevel, 1u);
+
+		totalBytes = Math::DivideByMultiple(totalBytes, levelAlignment) * levelAlignment;
+
+		TextureSubresourceData subResourceData{
+			.rowPitch			= width * bytesPerPixel,
+			.slicePitch			= (size_t)width * height * bytesPerPixel,
+			.bufferOffset		= totalBytes,
+			.mipLevel			= mipLevel,
+			.baseArrayLayer		= 0,
+			.layerCount			= 1,
+			.width				= width,
+			.height				= height,
+			.depth				= 1
+		};
+		outTexInit.subResourceData.push_back(subResourceData);
+
+		totalBytes += subResourceData.slicePitch;
+	}
+
+	// The upload path copies whole 16-byte blocks
+	outStorage.resize(Math::AlignUp(totalBytes, 16));
+	for (auto& subResourceData : outTexInit.subResourceData)
+	{
+		subResourceData.data = outStorage.data() + subResourceData.bufferOffset;
+	}
+
+	outTexInit.baseData = outStorage.data();
+	outTexInit.totalBytes = totalBytes;
+
+	memcpy(outStorage.data(), srcData, outTexInit.subResourceData[0].slicePitch);
+
+	const KernelLevel kernel = desc.allowSimd ? s_maxKernelLevel : KernelLevel::Scalar;
+	JobSystem* jobSystem = desc.allowParallel ? GetJobSystem() : nullptr;
+
+	// Each level is filtered from the one above it
+	for (uint32_t mipLevel = 1; mipLevel < numMips; ++mipLevel)
+	{
+		const auto& srcLevel = outTexInit.subResourceData[mipLevel - 1];
+		const auto& dstLevel = outTexInit.subResourceData[mipLevel];
+
+		MipLevelContext level{
+			.formatInfo		= *formatInfo,
+			.kernel			= kernel,
+			.src			= srcLevel.data,
+			.srcWidth		= srcLevel.width,
+			.srcHeight		= srcLevel.height,
+			.srcRowPitch	= srcLevel.rowPitch,
+			.dst			= dstLevel.data,
+			.dstWidth		= dstLevel.width,
+			.dstHeight		= dstLevel.height,
+			.dstRowPitch	= dstLevel.rowPitch
+		};
+
+		level.isBox2x2 = desc.filter == MipFilter::Box && (srcLevel.width % 2) == 0 && (srcLevel.height % 2) == 0;
+		if (!level.isBox2x2)
+		{
+			level.horizontal = BuildFilterTable(desc.filter, level.srcWidth, level.dstWidth);
+			level.vertical = BuildFilterTable(desc.filter, level.srcHeight, level.dstHeight);
+		}
+
+		const uint32_t numTexels = level.dstWidth * level.dstHeight;
+		if (jobSystem == nullptr || numTexels < s_minParallelTexels)
+		{
+			GenerateBand(level, 0, level.dstHeight);
+			continue;
+		}
+
+		// A few bands per thread, so that stealing can even out the load
+		const uint32_t numThreads = jobSystem->GetNumWorkers() + 1;
+		const uint32_t rowsPerBand = max(s_minRowsPerBand, (level.dstHeight + numThreads * 4 - 1) / (numThreads * 4));
+		const uint32_t numBands = (level.dstHeight + rowsPerBand - 1) / rowsPerBand;
+
+		jobSystem->ParallelFor(numBands, 1, [&level, rowsPerBand](uint32_t band)
+			{
+				const uint32_t firstRow = band * rowsPerBand;
+				GenerateBand(level, firstRow, min(firstRow + rowsPerBand, level.dstHeight));
+			});
+	}
+
+	return true;
+}
+
+} // namespace Luna
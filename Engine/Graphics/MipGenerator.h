@@ -0,0 +1,53 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics/Formats.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+struct TextureInitializer;
+
+
+enum class MipFilter : uint8_t
+{
+	Box,		// Averages each 2x2 block.  Odd dimensions are weighted by how much of each texel the footprint covers.
+	Lanczos		// Separable Lanczos-2 windowed sinc.  Sharper than Box, but can ring around hard edges.
+};
+
+
+struct MipGenerationDesc
+{
+	Format format{ Format::Unknown };
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	uint32_t numMips{ 0 };			// 0 for the full chain
+	MipFilter filter{ MipFilter::Box };
+	bool allowSimd{ true };			// The scalar path is the reference.  Both produce the same bits.
+	bool allowParallel{ true };		// Splits large levels into bands of rows, run on the JobSystem
+};
+
+
+uint32_t GetFullMipCount(uint32_t width, uint32_t height);
+
+// 8-bit and 16-bit UNorm formats with 1, 2 or 4 channels, 32-bit float formats, and the sRGB 8-bit formats
+bool IsMipGenerationSupported(Format format);
+
+// Builds a full or partial mip chain for a 2D image from its top level, given as tightly packed rows.  sRGB
+// formats are filtered in linear space.  Each level is written into outStorage, and outTexInit is filled in
+// with the texture description, the subresources and the layout of outStorage, ready for
+// IDevice::InitializeTexture().  outTexInit points into outStorage, which must outlive it.
+bool GenerateMipChain(const MipGenerationDesc& desc, const std::byte* srcData, std::vector<std::byte>& outStorage, TextureInitializer& outTexInit);
+
+} // namespace Luna
@@ -13,11 +13,18 @@
 #include "Model.h"
 
 #include "Filesystem.h"
+#include "MappedFile.h"
+#include "Graphics\Camera.h"
 #include "Graphics\CommandContext.h"
 #include "Graphics\Device.h"
 #include "Graphics\InputLayout.h"
+#include "Graphics\MeshletBuilder.h"
+#include "Graphics\MeshOptimizer.h"
+#include "Graphics\MeshSimplifier.h"
+#include "Graphics\VertexEncoder.h"
 #include "Graphics\Loaders\DDSTextureLoader.h"
 #include "Graphics\Loaders\KTXTextureLoader.h"
+#include "Graphics\Loaders\ModelCache.h"
 #include "Graphics\Loaders\STBTextureLoader.h"
 
 #include <assimp/Importer.hpp> 
@@ -193,11 +200,39 @@ public:
 	ModelPtr Load();
 
 protected:
-	void ProcessNode(ModelPtr model, const aiNode* node, const aiScene* scene);
-	void ProcessMesh(ModelPtr model, const aiMesh* aiMesh, const aiScene* scene);
-	int ProcessMaterial(ModelPtr model, const aiMaterial* aiMaterial, const aiScene* scene);
-	TexturePtr FindOrCreateTexture(const aiScene* scene, const string& textureName);
-	TexturePtr CreateTexture(const aiScene* scene, const string& textureName);
+	// Final streams for one mesh from the Assimp import, kept until the model has been created and cooked
+	struct MeshData
+	{
+		string name;
+		int materialIndex{ -1 };
+		vector<float> vertexData;
+		vector<float> vertexDataPositionOnly;
+		vector<std::byte> encodedVertexData;
+		vector<std::byte> encodedVertexDataPositionOnly;
+		VertexDecodeParams decodeParams{};
+		vector<uint16_t> indexData16;
+		vector<uint32_t> indexData;
+		bool use16BitIndices{ true };
+		MeshPart meshPart{};
+		vector<MeshPart> lodMeshParts;
+		vector<CookedMeshLod> lods;
+		Vector3 minExtents{ kZero };
+		Vector3 maxExtents{ kZero };
+	};
+
+	ModelPtr LoadFromCache(const ModelCacheKey& cacheKey);
+	bool ImportScene(const string& fullpath);
+	CookedModel CookImportedScene() const;
+	ModelPtr CreateModel(const CookedModel& cookedModel);
+	void LogVertexEncodingSavings(const CookedModel& cookedModel) const;
+	void LogLodSummary() const;
+
+	void ProcessNode(const aiNode* node, const aiScene* scene);
+	void ProcessMesh(const aiMesh* aiMesh, const aiScene* scene);
+	void FinalizeMesh(MeshData& meshData, MeshOptimizeStats* optimizeStats) const;
+	int ProcessMaterial(const aiMaterial* aiMaterial, const aiScene* scene);
+	TexturePtr FindOrCreateTexture(const aiScene* scene, const string& textureName, TextureUsage usage);
+	TexturePtr CreateTexture(const aiScene* scene, const string& textureName, TextureUsage usage);
 
 protected:
 	IDevice* m_device{ nullptr };
@@ -208,6 +243,13 @@ protected:
 	bool m_loadMaterials{ false };
 
 	std::map<std::string, TexturePtr> m_textureCache;
+
+	vector<MeshMaterial> m_materials;
+
+	// Imported data, only filled in on a cache miss
+	vector<MeshData> m_meshData;
+	vector<pair<string, string>> m_materialTextureNames;
+	bool m_hasEmbeddedTextures{ false };
 };
 
 
@@ -226,6 +268,81 @@ ModelPtr ModelLoader::Load()
 	const string fullpath = GetFileSystem()->GetFullPath(m_filename);
 	assert(!fullpath.empty());
 
+	ModelCacheKey cacheKey;
+	const bool hasCacheKey = MakeModelCacheKey(fullpath, *m_vertexLayout, m_scale, m_loadFlags, m_loadMaterials, cacheKey);
+
+	if (hasCacheKey)
+	{
+		if (ModelPtr model = LoadFromCache(cacheKey))
+		{
+			return model;
+		}
+	}
+
+	if (!ImportScene(fullpath))
+	{
+		return nullptr;
+	}
+
+	const CookedModel cookedModel = CookImportedScene();
+	ModelPtr model = CreateModel(cookedModel);
+
+	// Embedded textures live in the source file, so models that use them are always imported
+	if (hasCacheKey && !m_hasEmbeddedTextures)
+	{
+		if (!WriteModelCache(GetModelCacheFilename(cacheKey), cacheKey, cookedModel))
+		{
+			LogWarning(LogModel) << "Failed to write model cache for " << m_filename << endl;
+		}
+	}
+
+	return model;
+}
+
+
+ModelPtr ModelLoader::LoadFromCache(const ModelCacheKey& cacheKey)
+{
+	MappedFile cacheFile;
+	if (!cacheFile.Open(GetModelCacheFilename(cacheKey)))
+	{
+		return nullptr;
+	}
+
+	// The writer range checks every index, so release builds trust the streams of a file whose header and
+	// metadata check out, rather than reading every index on each load
+	const ModelCacheValidation validation = ENABLE_VALIDATION ? ModelCacheValidation::Full : ModelCacheValidation::Header;
+
+	CookedModel cookedModel;
+	if (!ReadModelCache(cacheFile, cacheKey, validation, cookedModel))
+	{
+		LogWarning(LogModel) << "Ignoring invalid model cache for " << m_filename << endl;
+		return nullptr;
+	}
+
+	m_materials.reserve(cookedModel.materials.size());
+	for (const auto& cookedMaterial : cookedModel.materials)
+	{
+		MeshMaterial material{};
+		const float* color = cookedMaterial.diffuseColor;
+		material.diffuseColor = Color{ color[0], color[1], color[2], color[3] };
+		if (!cookedMaterial.diffuseTexture.empty())
+		{
+			material.diffuseTexture = FindOrCreateTexture(nullptr, string{ cookedMaterial.diffuseTexture }, TextureUsage::Albedo);
+		}
+		if (!cookedMaterial.normalTexture.empty())
+		{
+			material.normalTexture = FindOrCreateTexture(nullptr, string{ cookedMaterial.normalTexture }, TextureUsage::NormalMap);
+		}
+		m_materials.push_back(material);
+	}
+
+	// Buffer creation copies the initial data to upload memory, so the file can be unmapped on return
+	return CreateModel(cookedModel);
+}
+
+
+bool ModelLoader::ImportScene(const string& fullpath)
+{
 	Assimp::Importer aiImporter;
 
 	const auto aiScene = aiImporter.ReadFile(fullpath.c_str(), GetPreprocessFlags(m_loadFlags));
@@ -234,47 +351,323 @@ ModelPtr ModelLoader::Load()
 		LogFatal << "Failed to load model file " << m_filename << endl;
 		string errorStr = aiImporter.GetErrorString();
 		LogFatal << errorStr << endl;
-		return nullptr;
+		return false;
 	}
 
-	ModelPtr model = make_shared<Model>();
+	m_meshData.reserve(aiScene->mNumMeshes);
 
-	model->meshes.reserve(aiScene->mNumMeshes);
+	ProcessNode(aiScene->mRootNode, aiScene);
 
-	ProcessNode(model, aiScene->mRootNode, aiScene);
+	// Optimization and encoding only touch each mesh's own streams, so the meshes are finalized in parallel
+	const uint32_t numMeshes = (uint32_t)m_meshData.size();
+	const bool optimize = HasFlag(m_loadFlags, ModelLoad::OptimizeMeshOrder);
 
-	return model;
+	vector<MeshOptimizeStats> optimizeStats(optimize ? numMeshes : 0);
+	ParallelFor(numMeshes, [&](uint32_t meshIndex)
+	{
+		FinalizeMesh(m_meshData[meshIndex], optimize ? &optimizeStats[meshIndex] : nullptr);
+	});
+
+	if (optimize)
+	{
+		MeshOptimizeStats totalStats{};
+		for (const auto& stats : optimizeStats)
+		{
+			totalStats += stats;
+		}
+
+		LogInfo(LogModel) << format("{}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, overdraw {:.3f} -> {:.3f}",
+			m_filename,
+			totalStats.vertexCacheBefore.GetACMR(),
+			totalStats.vertexCacheAfter.GetACMR(),
+			totalStats.vertexCacheBefore.GetATVR(),
+			totalStats.vertexCacheAfter.GetATVR(),
+			totalStats.overdrawBefore.GetOverdraw(),
+			totalStats.overdrawAfter.GetOverdraw()) << endl;
+	}
+
+	if (HasFlag(m_loadFlags, ModelLoad::GenerateLods))
+	{
+		LogLodSummary();
+	}
+
+	return true;
 }
 
 
-void ModelLoader::ProcessNode(ModelPtr model, const aiNode* node, const aiScene* scene)
+CookedModel ModelLoader::CookImportedScene() const
 {
-	for (uint32_t i = 0; i < node->mNumMeshes; i++)
+	CookedModel cookedModel;
+
+	const bool isEncoded = m_vertexLayout->GetEncoding() != VertexEncoding::None;
+
+	cookedModel.meshes.reserve(m_meshData.size());
+	for (const auto& meshData : m_meshData)
 	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		ProcessMesh(model, mesh, scene);
+		CookedMesh cookedMesh{
+			.name					= meshData.name,
+			.materialIndex			= meshData.materialIndex,
+			.vertexStride			= m_vertexLayout->GetSizeInBytes(),
+			.indexSize				= meshData.use16BitIndices ? (uint32_t)sizeof(uint16_t) : (uint32_t)sizeof(uint32_t),
+			.vertexData				= isEncoded ? span{ meshData.encodedVertexData } : as_bytes(span{ meshData.vertexData }),
+			.vertexDataPositionOnly = isEncoded ? span{ meshData.encodedVertexDataPositionOnly } : as_bytes(span{ meshData.vertexDataPositionOnly }),
+			.indexData				= meshData.use16BitIndices ? as_bytes(span{ meshData.indexData16 }) : as_bytes(span{ meshData.indexData }),
+			.meshParts				= meshData.lods.empty() ? span{ &meshData.meshPart, 1 } : span{ meshData.lodMeshParts },
+			.lods					= meshData.lods,
+			.decodeParams			= meshData.decodeParams
+		};
+		DirectX::XMStoreFloat3((DirectX::XMFLOAT3*)cookedMesh.boundsMin, meshData.minExtents);
+		DirectX::XMStoreFloat3((DirectX::XMFLOAT3*)cookedMesh.boundsMax, meshData.maxExtents);
+
+		cookedModel.meshes.push_back(cookedMesh);
 	}
 
-	for (uint32_t i = 0; i < node->mNumChildren; i++)
+	cookedModel.materials.reserve(m_materials.size());
+	for (size_t i = 0; i < m_materials.size(); ++i)
 	{
-		ProcessNode(model, node->mChildren[i], scene);
+		const Color& color = m_materials[i].diffuseColor;
+
+		CookedMaterial cookedMaterial{
+			.diffuseColor	= { color.R(), color.G(), color.B(), color.A() },
+			.diffuseTexture	= m_materialTextureNames[i].first,
+			.normalTexture	= m_materialTextureNames[i].second
+		};
+		cookedModel.materials.push_back(cookedMaterial);
 	}
 
-	// Compute the model's bounding box
+	return cookedModel;
+}
+
+
+ModelPtr ModelLoader::CreateModel(const CookedModel& cookedModel)
+{
+	ModelPtr model = make_shared<Model>();
+
+	model->meshes.reserve(cookedModel.meshes.size());
+
 	vector<BoundingBox> meshBounds;
-	for (const auto mesh : model->meshes)
+	meshBounds.reserve(cookedModel.meshes.size());
+
+	const VertexEncoding encoding = m_vertexLayout->GetEncoding();
+	const bool isPositionEncoded = HasAnyFlag(encoding, VertexEncoding::PositionHalf | VertexEncoding::PositionUNorm16);
+	const uint32_t positionStride = GetVertexComponentSizeInBytes(VertexComponent::Position, encoding);
+
+	// Meshlets are built from the cooked streams, so cache hits get them too
+	const uint32_t numMeshes = (uint32_t)cookedModel.meshes.size();
+	vector<shared_ptr<MeshletData>> meshletData(numMeshes);
+	if (HasFlag(m_loadFlags, ModelLoad::GenerateMeshlets))
 	{
+		ParallelFor(numMeshes, [&](uint32_t meshIndex)
+		{
+			const auto& cookedMesh = cookedModel.meshes[meshIndex];
+
+			// Cull data comes from the positions the GPU will see
+			span<const std::byte> positions = cookedMesh.vertexDataPositionOnly;
+			vector<float> decodedPositions;
+			if (isPositionEncoded)
+			{
+				DecodePositions(positions, positionStride, encoding, cookedMesh.decodeParams, decodedPositions);
+				positions = as_bytes(span{ decodedPositions });
+			}
+
+			// Only LOD 0, the coarser levels follow it in the index buffer
+			span<const std::byte> indices = cookedMesh.indexData;
+			if (!cookedMesh.lods.empty())
+			{
+				uint32_t lod0IndexEnd = 0;
+				for (const auto& meshPart : cookedMesh.meshParts.subspan(cookedMesh.lods[0].meshPartOffset, cookedMesh.lods[0].meshPartCount))
+				{
+					lod0IndexEnd = max(lod0IndexEnd, meshPart.indexBase + meshPart.indexCount);
+				}
+				indices = indices.first((size_t)lod0IndexEnd * cookedMesh.indexSize);
+			}
+
+			auto meshlets = make_shared<MeshletData>();
+			if (BuildMeshlets(positions, 3 * sizeof(float), indices, cookedMesh.indexSize, MeshletBuildDesc{}, *meshlets))
+			{
+				meshletData[meshIndex] = meshlets;
+			}
+		});
+	}
+
+	for (uint32_t meshIndex = 0; meshIndex < numMeshes; ++meshIndex)
+	{
+		const auto& cookedMesh = cookedModel.meshes[meshIndex];
+
+		MeshPtr mesh = make_shared<Mesh>();
+		mesh->name = cookedMesh.name;
+		mesh->materialIndex = cookedMesh.materialIndex;
+
+		// Create vertex buffer
+		GpuBufferDesc vertexBufferDesc{
+			.name			= "Model|VertexBuffer",
+			.resourceType	= ResourceType::VertexBuffer,
+			.memoryAccess	= MemoryAccess::GpuRead,
+			.elementCount	= cookedMesh.vertexData.size() / cookedMesh.vertexStride,
+			.elementSize	= cookedMesh.vertexStride,
+			.initialData	= cookedMesh.vertexData.data()
+		};
+		mesh->vertexBuffer = m_device->CreateGpuBuffer(vertexBufferDesc);
+
+		// Create position-only vertex buffer
+		GpuBufferDesc positionOnlyVertexBufferDesc
+		{
+			.name			= "Model|VertexBuffer (Position Only)",
+			.resourceType	= ResourceType::VertexBuffer,
+			.memoryAccess	= MemoryAccess::GpuRead,
+			.elementCount	= cookedMesh.vertexDataPositionOnly.size() / positionStride,
+			.elementSize	= positionStride,
+			.initialData	= cookedMesh.vertexDataPositionOnly.data()
+		};
+		mesh->vertexBufferPositionOnly = m_device->CreateGpuBuffer(positionOnlyVertexBufferDesc);
+
+		// Create index buffer
+		GpuBufferDesc indexBufferDesc{
+			.name			= "Model|IndexBuffer",
+			.resourceType	= ResourceType::IndexBuffer,
+			.memoryAccess	= MemoryAccess::GpuRead,
+			.elementCount	= cookedMesh.indexData.size() / cookedMesh.indexSize,
+			.elementSize	= cookedMesh.indexSize,
+			.initialData	= cookedMesh.indexData.data()
+		};
+		mesh->indexBuffer = m_device->CreateGpuBuffer(indexBufferDesc);
+
+		// Set bounding box
+		const Vector3 boundsMin{ cookedMesh.boundsMin[0], cookedMesh.boundsMin[1], cookedMesh.boundsMin[2] };
+		const Vector3 boundsMax{ cookedMesh.boundsMax[0], cookedMesh.boundsMax[1], cookedMesh.boundsMax[2] };
+		mesh->boundingBox = Math::BoundingBoxFromMinMax(boundsMin, boundsMax);
 		meshBounds.push_back(mesh->boundingBox);
+
+		mesh->decodeParams = cookedMesh.decodeParams;
+
+		if (cookedMesh.lods.empty())
+		{
+			mesh->meshParts.assign(cookedMesh.meshParts.begin(), cookedMesh.meshParts.end());
+		}
+		else
+		{
+			mesh->lods.reserve(cookedMesh.lods.size());
+			for (const auto& cookedLod : cookedMesh.lods)
+			{
+				const auto lodMeshParts = cookedMesh.meshParts.subspan(cookedLod.meshPartOffset, cookedLod.meshPartCount);
+
+				MeshLod& lod = mesh->lods.emplace_back();
+				lod.meshParts.assign(lodMeshParts.begin(), lodMeshParts.end());
+				lod.error = cookedLod.error;
+			}
+			mesh->meshParts = mesh->lods[0].meshParts;
+		}
+
+		mesh->meshlets = move(meshletData[meshIndex]);
+		if (HasFlag(m_loadFlags, ModelLoad::GenerateMeshlets) && !mesh->meshlets)
+		{
+			LogWarning(LogModel) << "Failed to build meshlets for mesh " << mesh->name << " in " << m_filename << endl;
+		}
+
+		mesh->model = model.get();
+
+		model->meshes.push_back(mesh);
 	}
+
+	// Compute the model's bounding box
 	model->boundingBox = Math::BoundingBoxUnion(meshBounds);
+
+	model->materials = move(m_materials);
+
+	if (encoding != VertexEncoding::None)
+	{
+		LogVertexEncodingSavings(cookedModel);
+	}
+
+	return model;
+}
+
+
+void ModelLoader::LogVertexEncodingSavings(const CookedModel& cookedModel) const
+{
+	const uint32_t stride = m_vertexLayout->GetSizeInBytes();
+	const uint32_t floatStride = m_vertexLayout->GetNumFloats() * sizeof(float);
+	const uint32_t positionStride = GetVertexComponentSizeInBytes(VertexComponent::Position, m_vertexLayout->GetEncoding());
+	const uint32_t floatPositionStride = GetVertexComponentSizeInBytes(VertexComponent::Position);
+
+	size_t numVertices = 0;
+	for (const auto& cookedMesh : cookedModel.meshes)
+	{
+		numVertices += cookedMesh.vertexData.size() / stride;
+	}
+
+	LogInfo(LogModel) << format("{}: {} vertices, {} bytes per vertex ({} as floats, {:.0f}%), {} bytes per position-only vertex ({} as floats), {} bytes saved",
+		m_filename,
+		numVertices,
+		stride,
+		floatStride,
+		100.0f * (float)stride / (float)floatStride,
+		positionStride,
+		floatPositionStride,
+		numVertices * ((floatStride - stride) + (floatPositionStride - positionStride))) << endl;
+}
+
+
+void ModelLoader::LogLodSummary() const
+{
+	// Triangles per level, summed over the meshes that have that level
+	vector<uint32_t> numLodTriangles;
+	float maxError = 0.0f;
+	uint32_t numMeshesWithLods = 0;
+
+	for (const auto& meshData : m_meshData)
+	{
+		if (meshData.lods.empty())
+		{
+			continue;
+		}
+
+		++numMeshesWithLods;
+		numLodTriangles.resize(max(numLodTriangles.size(), meshData.lods.size()), 0);
+
+		for (size_t i = 0; i < meshData.lods.size(); ++i)
+		{
+			const CookedMeshLod& lod = meshData.lods[i];
+			for (uint32_t j = 0; j < lod.meshPartCount; ++j)
+			{
+				numLodTriangles[i] += meshData.lodMeshParts[lod.meshPartOffset + j].indexCount / 3;
+			}
+			maxError = max(maxError, lod.error);
+		}
+	}
+
+	string trianglesString;
+	for (uint32_t numTriangles : numLodTriangles)
+	{
+		trianglesString += trianglesString.empty() ? format("{}", numTriangles) : format(" / {}", numTriangles);
+	}
+
+	LogInfo(LogModel) << format("{}: LODs for {} of {} meshes, triangles {}, max error {}",
+		m_filename,
+		numMeshesWithLods,
+		m_meshData.size(),
+		trianglesString.empty() ? "-" : trianglesString,
+		maxError) << endl;
 }
 
 
-void ModelLoader::ProcessMesh(ModelPtr model, const aiMesh* aiMesh, const aiScene* aiScene)
+void ModelLoader::ProcessNode(const aiNode* node, const aiScene* scene)
 {
-	uint32_t vertexCount = 0;
-	uint32_t indexCount = 0;
+	for (uint32_t i = 0; i < node->mNumMeshes; i++)
+	{
+		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+		ProcessMesh(mesh, scene);
+	}
 
+	for (uint32_t i = 0; i < node->mNumChildren; i++)
+	{
+		ProcessNode(node->mChildren[i], scene);
+	}
+}
+
+
+void ModelLoader::ProcessMesh(const aiMesh* aiMesh, const aiScene* aiScene)
+{
 	const aiVector3D zero(0.0f, 0.0f, 0.0f);
 
 	const VertexComponent components = m_vertexLayout->GetComponents();
@@ -284,15 +677,16 @@ void ModelLoader::ProcessMesh(ModelPtr model, const aiMesh* aiMesh, const aiScen
 	Vector3 minExtents{ maxF, maxF, maxF };
 	Vector3 maxExtents{ -maxF, -maxF, -maxF };
 
-	vector<float> vertexData;
-	vector<float> vertexDataPositionOnly;
-	vector<uint32_t> indexData;
-	vector<uint16_t> indexData16;
+	MeshData& meshData = m_meshData.emplace_back();
+	meshData.name = aiMesh->mName.C_Str();
 
-	MeshPtr mesh = make_shared<Mesh>();
-	MeshPart meshPart{};
+	vector<float>& vertexData = meshData.vertexData;
+	vector<float>& vertexDataPositionOnly = meshData.vertexDataPositionOnly;
+	vector<uint32_t>& indexData = meshData.indexData;
+	MeshPart& meshPart = meshData.meshPart;
 
-	vertexCount += aiMesh->mNumVertices;
+	vertexData.reserve((size_t)aiMesh->mNumVertices * m_vertexLayout->GetNumFloats());
+	vertexDataPositionOnly.reserve((size_t)aiMesh->mNumVertices * 3);
 
 	aiColor4D defaultColor(0.0f, 0.0f, 0.0f, 1.0f);
 	aiScene->mMaterials[aiMesh->mMaterialIndex]->Get(AI_MATKEY_COLOR_DIFFUSE, defaultColor);
@@ -361,129 +755,96 @@ void ModelLoader::ProcessMesh(ModelPtr model, const aiMesh* aiMesh, const aiScen
 
 	meshPart.vertexCount = aiMesh->mNumVertices;
 
-	// Find the max index value.  If less than 65536, we can use 16-bit indices
-	bool bUse16BitIndices = true;
-	for (uint32_t j = 0; j < aiMesh->mNumFaces; ++j)
+	// Indices stay 32-bit until FinalizeMesh, which narrows them once the vertex count is final
+	indexData.reserve((size_t)aiMesh->mNumFaces * 3);
+	for (unsigned int j = 0; j < aiMesh->mNumFaces; j++)
 	{
 		const aiFace& Face = aiMesh->mFaces[j];
 		if (Face.mNumIndices != 3)
 			continue;
-		if (Face.mIndices[0] >= 65536)
-		{
-			bUse16BitIndices = false;
-			break;
-		}
-		if (Face.mIndices[1] >= 65536)
-		{
-			bUse16BitIndices = false;
-			break;
-		}
-		if (Face.mIndices[2] >= 65536)
-		{
-			bUse16BitIndices = false;
-			break;
-		}
+		indexData.push_back(Face.mIndices[0]);
+		indexData.push_back(Face.mIndices[1]);
+		indexData.push_back(Face.mIndices[2]);
+		meshPart.indexCount += 3;
 	}
 
-	if (bUse16BitIndices)
-	{
-		for (unsigned int j = 0; j < aiMesh->mNumFaces; j++)
-		{
-			const aiFace& Face = aiMesh->mFaces[j];
-			if (Face.mNumIndices != 3)
-				continue;
-			indexData16.push_back((uint16_t)Face.mIndices[0]);
-			indexData16.push_back((uint16_t)Face.mIndices[1]);
-			indexData16.push_back((uint16_t)Face.mIndices[2]);
-			meshPart.indexCount += 3;
-			indexCount += 3;
-		}
-	}
-	else
+	meshData.minExtents = minExtents;
+	meshData.maxExtents = maxExtents;
+
+	// Process materials
+	if (m_loadMaterials && aiMesh->mMaterialIndex >= 0)
 	{
-		for (unsigned int j = 0; j < aiMesh->mNumFaces; j++)
-		{
-			const aiFace& Face = aiMesh->mFaces[j];
-			if (Face.mNumIndices != 3)
-				continue;
-			indexData.push_back(Face.mIndices[0]);
-			indexData.push_back(Face.mIndices[1]);
-			indexData.push_back(Face.mIndices[2]);
-			meshPart.indexCount += 3;
-			indexCount += 3;
-		}
+		::aiMaterial* aiMaterial = aiScene->mMaterials[aiMesh->mMaterialIndex];
+		int materialIndex = ProcessMaterial(aiMaterial, aiScene);
+		meshData.materialIndex = materialIndex;
 	}
+}
 
-	// Create vertex buffer
-	uint32_t stride = m_vertexLayout->GetSizeInBytes();
 
-	GpuBufferDesc vertexBufferDesc{
-		.name			= "Model|VertexBuffer",
-		.resourceType	= ResourceType::VertexBuffer,
-		.memoryAccess	= MemoryAccess::GpuRead,
-		.elementCount	= sizeof(float) * vertexData.size() / stride,
-		.elementSize	= stride,
-		.initialData	= vertexData.data()
-	};
-	mesh->vertexBuffer = m_device->CreateGpuBuffer(vertexBufferDesc);
+void ModelLoader::FinalizeMesh(MeshData& meshData, MeshOptimizeStats* optimizeStats) const
+{
+	const VertexComponent components = m_vertexLayout->GetComponents();
 
-	// Create position-only vertex buffer
-	stride = 3 * sizeof(float);
-	GpuBufferDesc positionOnlyVertexBufferDesc
+	if (HasFlag(m_loadFlags, ModelLoad::OptimizeMeshOrder) && !meshData.indexData.empty())
 	{
-		.name			= "Model|VertexBuffer (Position Only)",
-		.resourceType	= ResourceType::VertexBuffer,
-		.memoryAccess	= MemoryAccess::GpuRead,
-		.elementCount	= sizeof(float) * vertexDataPositionOnly.size() / stride,
-		.elementSize	= stride,
-		.initialData	= vertexDataPositionOnly.data()
-	};
-	mesh->vertexBufferPositionOnly = m_device->CreateGpuBuffer(positionOnlyVertexBufferDesc);
+		OptimizeMesh(meshData.indexData, meshData.vertexData, m_vertexLayout->GetNumFloats(), meshData.vertexDataPositionOnly, MeshOptimizeDesc{}, optimizeStats);
 
-	// Create index buffer
-	if (bUse16BitIndices)
-	{
-		GpuBufferDesc indexBufferDesc{
-			.name			= "Model|IndexBuffer",
-			.resourceType	= ResourceType::IndexBuffer,
-			.memoryAccess	= MemoryAccess::GpuRead,
-			.elementCount	= indexData16.size(),
-			.elementSize	= sizeof(uint16_t),
-			.initialData	= indexData16.data()
-		};
-		mesh->indexBuffer = m_device->CreateGpuBuffer(indexBufferDesc);
-	}
-	else
-	{
-		GpuBufferDesc indexBufferDesc{
-			.name			= "Model|IndexBuffer",
-			.resourceType	= ResourceType::IndexBuffer,
-			.memoryAccess	= MemoryAccess::GpuRead,
-			.elementCount	= indexData.size(),
-			.elementSize	= sizeof(uint32_t),
-			.initialData	= indexData.data()
-		};
-		mesh->indexBuffer = m_device->CreateGpuBuffer(indexBufferDesc);
+		// Unreferenced vertices are dropped
+		meshData.meshPart.vertexCount = (uint32_t)(meshData.vertexData.size() / m_vertexLayout->GetNumFloats());
 	}
 
-	// Set bounding box
-	mesh->boundingBox = Math::BoundingBoxFromMinMax(minExtents, maxExtents);
+	// The levels are appended to the index buffer, after LOD 0
+	if (HasFlag(m_loadFlags, ModelLoad::GenerateLods) && !meshData.vertexDataPositionOnly.empty())
+	{
+		vector<MeshLodLevel> levels;
+		GenerateMeshLods(meshData.indexData, meshData.vertexDataPositionOnly, 3, MeshLodDesc{}, levels);
 
-	mesh->meshParts.push_back(meshPart);
+		if (levels.size() > 1)
+		{
+			for (const auto& level : levels)
+			{
+				MeshPart meshPart = meshData.meshPart;
+				meshPart.indexBase = level.indexOffset;
+				meshPart.indexCount = level.indexCount;
+
+				meshData.lods.push_back(CookedMeshLod{
+					.meshPartOffset = (uint32_t)meshData.lodMeshParts.size(),
+					.meshPartCount	= 1,
+					.error			= level.error
+				});
+				meshData.lodMeshParts.push_back(meshPart);
+			}
+		}
+	}
 
-	model->meshes.push_back(mesh);
+	// If every index is less than 65536, we can use 16-bit indices
+	meshData.use16BitIndices = meshData.meshPart.vertexCount <= 65536;
+	if (meshData.use16BitIndices)
+	{
+		meshData.indexData16.reserve(meshData.indexData.size());
+		for (uint32_t index : meshData.indexData)
+		{
+			meshData.indexData16.push_back((uint16_t)index);
+		}
+		meshData.indexData.clear();
+	}
 
-	// Process materials
-	if (m_loadMaterials && aiMesh->mMaterialIndex >= 0)
+	// Pack the float streams into the layout's encoding.  The position-only stream shares the position encoding.
+	const VertexEncoding encoding = m_vertexLayout->GetEncoding();
+	if (encoding != VertexEncoding::None)
 	{
-		::aiMaterial* aiMaterial = aiScene->mMaterials[aiMesh->mMaterialIndex];
-		int materialIndex = ProcessMaterial(model, aiMaterial, aiScene);
-		mesh->materialIndex = materialIndex;
+		meshData.decodeParams = ComputeVertexDecodeParams(meshData.vertexData, components, encoding);
+		EncodeVertices(meshData.vertexData, components, encoding, meshData.decodeParams, meshData.encodedVertexData);
+
+		if (HasFlag(components, VertexComponent::Position))
+		{
+			EncodeVertices(meshData.vertexDataPositionOnly, VertexComponent::Position, encoding, meshData.decodeParams, meshData.encodedVertexDataPositionOnly);
+		}
 	}
 }
 
 
-int ModelLoader::ProcessMaterial(ModelPtr model, const aiMaterial* aiMaterial, const aiScene* scene)
+int ModelLoader::ProcessMaterial(const aiMaterial* aiMaterial, const aiScene* scene)
 {
 	MeshMaterialData materialData{};
 
@@ -562,13 +923,13 @@ int ModelLoader::ProcessMaterial(ModelPtr model, const aiMaterial* aiMaterial, c
 	TexturePtr diffuseTex;
 	if (materialData.diffuseTex.has_value())
 	{
-		diffuseTex = FindOrCreateTexture(scene, materialData.diffuseTex.value());
+		diffuseTex = FindOrCreateTexture(scene, materialData.diffuseTex.value(), TextureUsage::Albedo);
 	}
 
 	TexturePtr normalTex;
 	if (materialData.normalTex.has_value())
 	{
-		normalTex = FindOrCreateTexture(scene, materialData.normalTex.value());
+		normalTex = FindOrCreateTexture(scene, materialData.normalTex.value(), TextureUsage::NormalMap);
 	}
 
 	MeshMaterial material{};
@@ -579,14 +940,15 @@ int ModelLoader::ProcessMaterial(ModelPtr model, const aiMaterial* aiMaterial, c
 	material.diffuseTexture = diffuseTex;
 	material.normalTexture = normalTex;
 
-	int index = (int)model->materials.size();
-	model->materials.push_back(material);
+	int index = (int)m_materials.size();
+	m_materials.push_back(material);
+	m_materialTextureNames.emplace_back(materialData.diffuseTex.value_or(""), materialData.normalTex.value_or(""));
 
 	return index;
 }
 
 
-TexturePtr ModelLoader::FindOrCreateTexture(const aiScene* scene, const string& textureName)
+TexturePtr ModelLoader::FindOrCreateTexture(const aiScene* scene, const string& textureName, TextureUsage usage)
 {
 	// Check the texture cache to see if we've already created this texture
 	auto iter = m_textureCache.find(textureName);
@@ -595,19 +957,23 @@ TexturePtr ModelLoader::FindOrCreateTexture(const aiScene* scene, const string&
 		return iter->second;
 	}
 
-	TexturePtr texture = CreateTexture(scene, textureName);
+	TexturePtr texture = CreateTexture(scene, textureName, usage);
 	m_textureCache[textureName] = texture;
 
 	return texture;
 }
 
 
-TexturePtr ModelLoader::CreateTexture(const aiScene* scene, const string& textureName)
+TexturePtr ModelLoader::CreateTexture(const aiScene* scene, const string& textureName, TextureUsage usage)
 {
-	const aiTexture* aiTexture = scene->GetEmbeddedTexture(textureName.c_str());
+	// There is no scene when loading from the model cache, which never contains embedded textures
+	const aiTexture* aiTexture = (scene != nullptr) ? scene->GetEmbeddedTexture(textureName.c_str()) : nullptr;
 
+	// Embedded textures have no source file to key the texture cache on, so they are never compressed
 	if (aiTexture != nullptr)
 	{
+		m_hasEmbeddedTextures = true;
+
 		string filename = aiTexture->mFilename.C_Str();
 
 		TexturePtr texture = m_device->CreateUninitializedTexture(filename, filename);
@@ -621,37 +987,51 @@ TexturePtr ModelLoader::CreateTexture(const aiScene* scene, const string& textur
 	}
 	else
 	{
-		TexturePtr texture = GetTextureManager()->Load(textureName, Format::Unknown, false, false);
+		// Decode in the background.  Materials bind the fallback texture until this is ready.
+		if (!HasFlag(m_loadFlags, ModelLoad::CompressTextures))
+		{
+			usage = TextureUsage::Default;
+		}
+
+		TexturePtr texture = GetTextureManager()->LoadAsync(textureName, Format::Unknown, false, false, usage);
 
 		return texture;
 	}
 }
 
 
-void Mesh::Render(GraphicsContext& context, bool positionOnly)
+void Mesh::Render(GraphicsContext& context, bool positionOnly, uint32_t lodIndex)
 {
 	context.SetIndexBuffer(indexBuffer);
 	context.SetVertexBuffer(0, positionOnly ? vertexBufferPositionOnly : vertexBuffer);
 
-	for (const auto& meshPart : meshParts)
+	for (const auto& meshPart : GetLodMeshParts(lodIndex))
 	{
 		context.DrawIndexed(meshPart.indexCount, meshPart.indexBase, meshPart.vertexBase);
 	}
 }
 
 
-void Mesh::RenderInstanced(GraphicsContext& context, uint32_t numInstances, bool positionOnly)
+void Mesh::RenderInstanced(GraphicsContext& context, uint32_t numInstances, bool positionOnly, uint32_t lodIndex)
 {
 	context.SetIndexBuffer(indexBuffer);
 	context.SetVertexBuffer(0, positionOnly ? vertexBufferPositionOnly : vertexBuffer);
 
-	for (const auto& meshPart : meshParts)
+	for (const auto& meshPart : GetLodMeshParts(lodIndex))
 	{
 		context.DrawIndexedInstanced(meshPart.indexCount, numInstances, meshPart.indexBase, meshPart.vertexBase, 0);
 	}
 }
 
 
+const vector<MeshPart>& Mesh::GetLodMeshParts(uint32_t lodIndex) const
+{
+	assert(lodIndex < GetNumLods());
+
+	return lods.empty() ? meshParts : lods[lodIndex].meshParts;
+}
+
+
 void Model::Render(GraphicsContext& context, bool positionOnly)
 {
 	for (auto mesh : meshes)
@@ -680,6 +1060,8 @@ ModelPtr LoadModel(IDevice* device, const string& filename, const VertexLayoutBa
 
 ModelPtr MakePlane(IDevice* device, const VertexLayoutBase& layout, float width, float height)
 {
+	assert_msg(layout.GetEncoding() == VertexEncoding::None, "MakePlane only builds float vertex streams");
+
 	bool bHasNormals = HasFlag(layout.GetComponents(), VertexComponent::Normal);
 	bool bHasUVs = HasFlag(layout.GetComponents(), VertexComponent::Texcoord);
 
@@ -824,6 +1206,8 @@ ModelPtr MakePlane(IDevice* device, const VertexLayoutBase& layout, float width,
 
 ModelPtr MakeCylinder(IDevice* device, const VertexLayoutBase& layout, float height, float radius, uint32_t numVerts)
 {
+	assert_msg(layout.GetEncoding() == VertexEncoding::None, "MakeCylinder only builds float vertex streams");
+
 	bool bHasNormals = HasFlag(layout.GetComponents(), VertexComponent::Normal);
 	bool bHasUVs = HasFlag(layout.GetComponents(), VertexComponent::Texcoord);
 
@@ -1082,6 +1466,8 @@ ModelPtr MakeCylinder(IDevice* device, const VertexLayoutBase& layout, float hei
 
 ModelPtr MakeSphere(IDevice* device, const VertexLayoutBase& layout, float radius, uint32_t numVerts, uint32_t numRings)
 {
+	assert_msg(layout.GetEncoding() == VertexEncoding::None, "MakeSphere only builds float vertex streams");
+
 	bool bHasNormals = HasFlag(layout.GetComponents(), VertexComponent::Normal);
 	bool bHasUVs = HasFlag(layout.GetComponents(), VertexComponent::Texcoord);
 
@@ -1203,6 +1589,8 @@ ModelPtr MakeSphere(IDevice* device, const VertexLayoutBase& layout, float radiu
 
 ModelPtr MakeBox(IDevice* device, const VertexLayoutBase& layout, float width, float height, float depth)
 {
+	assert_msg(layout.GetEncoding() == VertexEncoding::None, "MakeBox only builds float vertex streams");
+
 	bool bHasNormals = HasFlag(layout.GetComponents(), VertexComponent::Normal);
 	bool bHasUVs = HasFlag(layout.GetComponents(), VertexComponent::Texcoord);
 
@@ -1343,4 +1731,34 @@ ModelPtr MakeBox(IDevice* device, const VertexLayoutBase& layout, float width, f
 	return model;
 }
 
+
+uint32_t SelectMeshLod(const Mesh& mesh, const Camera& camera, const Matrix4& localToWorld, float viewportHeight, float maxPixelError)
+{
+	const uint32_t numLods = mesh.GetNumLods();
+	if (numLods == 1)
+	{
+		return 0;
+	}
+
+	// World-space bounding sphere, scaled by the largest axis scale to stay conservative
+	const Matrix4 meshToWorld = localToWorld * mesh.meshToModelMatrix;
+	const float scale = Max(Max(Length(Vector3(meshToWorld.GetX())), Length(Vector3(meshToWorld.GetY()))), Length(Vector3(meshToWorld.GetZ())));
+	const Vector3 center = meshToWorld * mesh.boundingBox.GetCenter();
+	const float radius = Length(mesh.boundingBox.GetExtents()) * scale;
+
+	// Pixels covered by one world unit at the near side of the sphere
+	const float distance = Max((float)Length(center - camera.GetPosition()) - radius, camera.GetNearClip());
+	const float pixelsPerUnit = viewportHeight / (2.0f * tanf(0.5f * camera.GetFOV()) * distance);
+
+	for (uint32_t lodIndex = numLods - 1; lodIndex > 0; --lodIndex)
+	{
+		if (mesh.lods[lodIndex].error * scale * pixelsPerUnit <= maxPixelError)
+		{
+			return lodIndex;
+		}
+	}
+
+	return 0;
+}
+
 } // namespace Luna
\ No newline at end of file
@@ -11,6 +11,8 @@
 #pragma once
 
 #include "Graphics\GpuBuffer.h"
+#include "Graphics\InputLayout.h"
+#include "Graphics\ModelTypes.h"
 #include "Graphics\Texture.h"
 
 // TODO: Going to need a ModelManager (like TextureManager) to cache models loaded from file.
@@ -19,77 +21,13 @@ namespace Luna
 {
 
 // Forward declarations
+class Camera;
 class GraphicsContext;
 class IDevice;
 class VertexLayoutBase;
+struct MeshletData;
 
 
-enum class ModelLoad
-{
-	CalcTangentSpace			= 1 << 0,
-	JoinIdenticalVertices		= 1 << 1,
-	MakeLeftHanded				= 1 << 2,
-	Triangulate					= 1 << 3,
-	RemoveComponent				= 1 << 4,
-	GenNormals					= 1 << 5,
-	GenSmoothNormals			= 1 << 6,
-	SplitLargeMeshes			= 1 << 7,
-	PreTransformVertices		= 1 << 8,
-	LimitBoneWeights			= 1 << 9,
-	ValidateDataStructure		= 1 << 10,
-	ImproveCacheLocality		= 1 << 11,
-	RemoveRedundantMaterials	= 1 << 12,
-	FixInfacingNormals			= 1 << 13,
-	SortByPType					= 1 << 14,
-	FindDegenerates				= 1 << 15,
-	FindInvalidData				= 1 << 16,
-	GenUVCoords					= 1 << 17,
-	TransformUVCoords			= 1 << 18,
-	FindInstances				= 1 << 19,
-	OptimizeMeshes				= 1 << 20,
-	OptimizeGraph				= 1 << 21,
-	FlipUVs						= 1 << 22,
-	FlipWindingOrder			= 1 << 23,
-	SplitByBoneCount			= 1 << 24,
-	Debone						= 1 << 25,
-
-	ConvertToLeftHandded = MakeLeftHanded |
-	FlipUVs |
-	FlipWindingOrder,
-
-	TargetRealtime_Fast = CalcTangentSpace |
-	GenNormals |
-	JoinIdenticalVertices |
-	Triangulate |
-	GenUVCoords |
-	SortByPType,
-
-	TargetRealtime_Quality = CalcTangentSpace |
-	GenSmoothNormals |
-	JoinIdenticalVertices |
-	Triangulate |
-	GenUVCoords |
-	SortByPType |
-	ImproveCacheLocality |
-	LimitBoneWeights |
-	RemoveRedundantMaterials |
-	SplitLargeMeshes |
-	FindDegenerates |
-	FindInvalidData,
-
-	TargetRealtime_MaxQuality = TargetRealtime_Quality |
-	FindInstances |
-	ValidateDataStructure |
-	OptimizeMeshes,
-
-	StandardDefault = FlipUVs |
-	Triangulate |
-	PreTransformVertices |
-	CalcTangentSpace
-};
-
-template <> struct EnableBitmaskOperators<ModelLoad> { static const bool enable = true; };
-
 struct MeshMaterial
 { 
 	Color diffuseColor{ DirectX::Colors::Black };
@@ -98,19 +36,20 @@ struct MeshMaterial
 };
 
 
-struct MeshPart
+struct MeshLod
 {
-	uint32_t vertexBase{ 0 };
-	uint32_t vertexCount{ 0 };
-	uint32_t indexBase{ 0 };
-	uint32_t indexCount{ 0 };
+	std::vector<MeshPart> meshParts;
+	float error{ 0.0f };	// Largest geometric deviation from LOD 0, in model units
 };
 
 
 struct Mesh
 {
-	void Render(GraphicsContext& context, bool positionOnly = false);
-	void RenderInstanced(GraphicsContext& context, uint32_t numInstances, bool positionOnly = false);
+	void Render(GraphicsContext& context, bool positionOnly = false, uint32_t lodIndex = 0);
+	void RenderInstanced(GraphicsContext& context, uint32_t numInstances, bool positionOnly = false, uint32_t lodIndex = 0);
+
+	uint32_t GetNumLods() const noexcept { return lods.empty() ? 1 : (uint32_t)lods.size(); }
+	const std::vector<MeshPart>& GetLodMeshParts(uint32_t lodIndex) const;
 
 	std::string name;
 
@@ -123,8 +62,18 @@ struct Mesh
 	Math::Matrix4 meshToModelMatrix{ Math::kIdentity };
 	Math::BoundingBox boundingBox;
 
+	// Undoes the range normalization of the layout's VertexEncoding, for both vertex buffers
+	VertexDecodeParams decodeParams;
+
 	std::vector<MeshPart> meshParts;
 
+	// Levels of detail that share the vertex and index buffers, only built when the model is loaded with
+	// ModelLoad::GenerateLods.  lods[0] has the same parts as meshParts.
+	std::vector<MeshLod> lods;
+
+	// CPU-side meshlets, only built when the model is loaded with ModelLoad::GenerateMeshlets
+	std::shared_ptr<MeshletData> meshlets;
+
 	struct Model* model{ nullptr };
 };
 
@@ -156,6 +105,10 @@ ModelPtr MakeCylinder(IDevice* device, const VertexLayoutBase& layout, float hei
 ModelPtr MakeSphere(IDevice* device, const VertexLayoutBase& layout, float radius, uint32_t numVerts, uint32_t numRings);
 ModelPtr MakeBox(IDevice* device, const VertexLayoutBase& layout, float width, float height, float depth);
 
+// Picks the coarsest LOD whose error, projected at the near side of the mesh's bounding sphere, covers at most
+// maxPixelError pixels of a viewport viewportHeight pixels tall.  localToWorld places the mesh's model in the world.
+uint32_t SelectMeshLod(const Mesh& mesh, const Camera& camera, const Math::Matrix4& localToWorld, float viewportHeight, float maxPixelError = 1.0f);
+
 inline LogCategory LogModel{ "LogModel" };
 
 } // namespace Luna
\ No newline at end of file
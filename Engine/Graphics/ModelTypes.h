@@ -0,0 +1,104 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/BitmaskEnum.h"
+
+
+namespace Luna
+{
+
+// LoadModel's import and processing flags.  Kept apart from Model.h, along with MeshPart, so that the model cache
+// builds without a graphics API.
+enum class ModelLoad
+{
+	CalcTangentSpace			= 1 << 0,
+	JoinIdenticalVertices		= 1 << 1,
+	MakeLeftHanded				= 1 << 2,
+	Triangulate					= 1 << 3,
+	RemoveComponent				= 1 << 4,
+	GenNormals					= 1 << 5,
+	GenSmoothNormals			= 1 << 6,
+	SplitLargeMeshes			= 1 << 7,
+	PreTransformVertices		= 1 << 8,
+	LimitBoneWeights			= 1 << 9,
+	ValidateDataStructure		= 1 << 10,
+	ImproveCacheLocality		= 1 << 11,
+	RemoveRedundantMaterials	= 1 << 12,
+	FixInfacingNormals			= 1 << 13,
+	SortByPType					= 1 << 14,
+	FindDegenerates				= 1 << 15,
+	FindInvalidData				= 1 << 16,
+	GenUVCoords					= 1 << 17,
+	TransformUVCoords			= 1 << 18,
+	FindInstances				= 1 << 19,
+	OptimizeMeshes				= 1 << 20,
+	OptimizeGraph				= 1 << 21,
+	FlipUVs						= 1 << 22,
+	FlipWindingOrder			= 1 << 23,
+	SplitByBoneCount			= 1 << 24,
+	Debone						= 1 << 25,
+
+	// Engine-side processing, not passed to Assimp
+	GenerateMeshlets			= 1 << 26,
+	OptimizeMeshOrder			= 1 << 27,	// Vertex cache, overdraw and vertex fetch ordering, see MeshOptimizer.h.  Opt-in, since it
+											// renumbers the vertices and drops unreferenced ones
+	GenerateLods				= 1 << 28,	// Simplified levels of detail in the same buffers, see MeshSimplifier.h
+	CompressTextures			= 1 << 29,	// Block-compressed material textures: albedo as BC1/BC3, normal maps as BC5.  Opt-in, since
+											// BC5 keeps only X and Y, so normal map shaders must rebuild Z
+
+	ConvertToLeftHandded = MakeLeftHanded |
+	FlipUVs |
+	FlipWindingOrder,
+
+	TargetRealtime_Fast = CalcTangentSpace |
+	GenNormals |
+	JoinIdenticalVertices |
+	Triangulate |
+	GenUVCoords |
+	SortByPType,
+
+	TargetRealtime_Quality = CalcTangentSpace |
+	GenSmoothNormals |
+	JoinIdenticalVertices |
+	Triangulate |
+	GenUVCoords |
+	SortByPType |
+	ImproveCacheLocality |
+	LimitBoneWeights |
+	RemoveRedundantMaterials |
+	SplitLargeMeshes |
+	FindDegenerates |
+	FindInvalidData,
+
+	TargetRealtime_MaxQuality = TargetRealtime_Quality |
+	FindInstances |
+	ValidateDataStructure |
+	OptimizeMeshes,
+
+	StandardDefault = FlipUVs |
+	Triangulate |
+	PreTransformVertices |
+	CalcTangentSpace
+};
+
+template <> struct EnableBitmaskOperators<ModelLoad> { static const bool enable = true; };
+
+
+struct MeshPart
+{
+	uint32_t vertexBase{ 0 };
+	uint32_t vertexCount{ 0 };
+	uint32_t indexBase{ 0 };
+	uint32_t indexCount{ 0 };
+};
+
+} // namespace Luna
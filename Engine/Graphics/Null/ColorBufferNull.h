@@ -0,0 +1,42 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\ColorBuffer.h"
+#include "Graphics\Null\DescriptorNull.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+class ColorBuffer : public IColorBuffer
+{
+	friend class Device;
+
+public:
+	const IDescriptor* GetSrvDescriptor() const noexcept override { return &m_srvDescriptor; }
+	const IDescriptor* GetRtvDescriptor() const noexcept override { return &m_rtvDescriptor; }
+	const IDescriptor* GetUavDescriptor(uint32_t index = 0) const noexcept override
+	{
+		return index < m_numMips ? &m_uavDescriptor : nullptr;
+	}
+
+protected:
+	Descriptor m_srvDescriptor;
+	Descriptor m_rtvDescriptor;
+	Descriptor m_uavDescriptor;
+};
+
+} // namespace Luna::Null
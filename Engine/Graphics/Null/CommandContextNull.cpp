@@ -0,0 +1,1269 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "CommandContextNull.h"
+
+#include "Graphics\ResourceSet.h"
+
+#include "ColorBufferNull.h"
+#include "DepthBufferNull.h"
+#include "DescriptorNull.h"
+#include "DescriptorSetNull.h"
+#include "DeviceManagerNull.h"
+#include "GpuBufferNull.h"
+#include "PipelineStateNull.h"
+#include "RootSignatureNull.h"
+#include "TextureNull.h"
+
+using namespace std;
+
+
+namespace Luna::Null
+{
+
+static bool IsValidComputeResourceState(ResourceState state)
+{
+	switch (state)
+	{
+	case ResourceState::NonPixelShaderResource:
+	case ResourceState::UnorderedAccess:
+	case ResourceState::CopyDest:
+	case ResourceState::CopySource:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+static uint64_t GetPrimitiveCount(PrimitiveTopology topology, uint64_t vertexCount)
+{
+	switch (topology)
+	{
+	case PrimitiveTopology::PointList:		return vertexCount;
+	case PrimitiveTopology::LineList:		return vertexCount / 2;
+	case PrimitiveTopology::LineStrip:		return vertexCount > 1 ? vertexCount - 1 : 0;
+	case PrimitiveTopology::TriangleList:	return vertexCount / 3;
+	case PrimitiveTopology::TriangleStrip:	return vertexCount > 2 ? vertexCount - 2 : 0;
+	default:								return 0;
+	}
+}
+
+
+CommandStats& CommandStats::operator+=(const CommandStats& other) noexcept
+{
+	numContexts += other.numContexts;
+	numDraws += other.numDraws;
+	numDispatches += other.numDispatches;
+	numMeshDispatches += other.numMeshDispatches;
+	numIndirect += other.numIndirect;
+	numPrimitives += other.numPrimitives;
+	numPipelineChanges += other.numPipelineChanges;
+	numRedundantPipelineChanges += other.numRedundantPipelineChanges;
+	numRootSignatureChanges += other.numRootSignatureChanges;
+	numDescriptorBinds += other.numDescriptorBinds;
+	numConstantUpdates += other.numConstantUpdates;
+	numVertexBufferBinds += other.numVertexBufferBinds;
+	numIndexBufferBinds += other.numIndexBufferBinds;
+	numTransitions += other.numTransitions;
+	numUAVBarriers += other.numUAVBarriers;
+	numBarrierFlushes += other.numBarrierFlushes;
+	numRenderPasses += other.numRenderPasses;
+	numClears += other.numClears;
+	numQueries += other.numQueries;
+	uploadBytes += other.uploadBytes;
+
+	return *this;
+}
+
+
+CommandContextNull::CommandContextNull(CommandListType type)
+	: m_commandListType{ type }
+{
+	m_stats.numContexts = 1;
+}
+
+
+void CommandContextNull::EndEvent()
+{
+	if (m_eventDepth == 0)
+	{
+		ReportError("EndEvent called without a matching BeginEvent");
+		return;
+	}
+	--m_eventDepth;
+}
+
+
+void CommandContextNull::Reset()
+{
+	m_stats = CommandStats{};
+	m_stats.numContexts = 1;
+
+	m_graphicsState = BindingState{};
+	m_computeState = BindingState{};
+	m_isMeshletPipeline = false;
+	m_primitiveTopology = PrimitiveTopology::TriangleList;
+	m_hasIndexBuffer = false;
+	m_isRendering = false;
+	m_eventDepth = 0;
+
+	m_pendingTransitions.clear();
+	m_pendingShaderResources.clear();
+	m_numBarriersToFlush = 0;
+
+	// Keep the regular upload pages for the next user of this context
+	m_largeUploadPages.clear();
+	m_currentPage = 0;
+	m_currentOffset = 0;
+}
+
+
+uint64_t CommandContextNull::Finish(bool bWaitForCompletion)
+{
+	assert(m_commandListType == CommandListType::Graphics || m_commandListType == CommandListType::Compute);
+
+	ValidateForSubmit();
+
+	auto deviceManager = GetNullDeviceManager();
+
+	deviceManager->AddCommandStats(m_stats);
+
+	// Nothing executes, so every fence is complete as soon as it is signaled
+	return deviceManager->SignalFence(m_commandListType);
+}
+
+
+uint64_t CommandContextNull::ExecuteChildren(span<ICommandContext* const> childContexts)
+{
+	ValidateForSubmit();
+
+	CommandStats stats = m_stats;
+
+	for (ICommandContext* childContext : childContexts)
+	{
+		CommandContextNull* childContextNull = (CommandContextNull*)childContext;
+		assert(childContextNull != nullptr && childContextNull->GetType() == m_commandListType);
+
+		// Transitions change the tracked state of a resource, which only has a defined order on a single thread
+		if (childContextNull->m_stats.numTransitions > 0)
+		{
+			childContextNull->ReportError(format("Parallel context recorded {} resource transitions", childContextNull->m_stats.numTransitions));
+		}
+
+		childContextNull->ValidateForSubmit();
+		stats += childContextNull->m_stats;
+	}
+
+	auto deviceManager = GetNullDeviceManager();
+
+	deviceManager->AddCommandStats(stats);
+	const uint64_t fenceValue = deviceManager->SignalFence(m_commandListType);
+
+	// Debug events stay open across the submission, and the context itself has already been counted
+	const uint32_t eventDepth = m_eventDepth;
+	Reset();
+	m_eventDepth = eventDepth;
+	m_stats.numContexts = 0;
+
+	return fenceValue;
+}
+
+
+void CommandContextNull::TransitionResource(IColorBuffer* colorBuffer, ResourceState newState, bool bFlushImmediate)
+{
+	assert(colorBuffer != nullptr);
+	TransitionResource_Internal(colorBuffer, newState, bFlushImmediate);
+}
+
+
+void CommandContextNull::TransitionResource(IDepthBuffer* depthBuffer, ResourceState newState, bool bFlushImmediate)
+{
+	assert(depthBuffer != nullptr);
+	TransitionResource_Internal(depthBuffer, newState, bFlushImmediate);
+}
+
+
+void CommandContextNull::TransitionResource(IGpuBuffer* gpuBuffer, ResourceState newState, bool bFlushImmediate)
+{
+	assert(gpuBuffer != nullptr);
+	TransitionResource_Internal(gpuBuffer, newState, bFlushImmediate);
+}
+
+
+void CommandContextNull::TransitionResource(ITexture* texture, ResourceState newState, bool bFlushImmediate)
+{
+	assert(texture != nullptr);
+	TransitionResource_Internal(texture, newState, bFlushImmediate);
+}
+
+
+void CommandContextNull::InsertUAVBarrier(const IColorBuffer* colorBuffer, bool bFlushImmediate)
+{
+	assert(colorBuffer != nullptr);
+
+	++m_stats.numUAVBarriers;
+	++m_numBarriersToFlush;
+
+	if (bFlushImmediate)
+	{
+		FlushResourceBarriers();
+	}
+}
+
+
+void CommandContextNull::InsertUAVBarrier(const IGpuBuffer* gpuBuffer, bool bFlushImmediate)
+{
+	assert(gpuBuffer != nullptr);
+
+	++m_stats.numUAVBarriers;
+	++m_numBarriersToFlush;
+
+	if (bFlushImmediate)
+	{
+		FlushResourceBarriers();
+	}
+}
+
+
+void CommandContextNull::BeginResourceTransition(IColorBuffer* colorBuffer, ResourceState newState)
+{
+	assert(colorBuffer != nullptr);
+
+	// The usage state only changes once the transition ends
+	if (colorBuffer->GetUsageState() != newState)
+	{
+		m_pendingTransitions.emplace_back(colorBuffer, newState);
+	}
+}
+
+
+void CommandContextNull::BeginResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState)
+{
+	assert(depthBuffer != nullptr);
+
+	if (depthBuffer->GetUsageState() != newState)
+	{
+		m_pendingTransitions.emplace_back(depthBuffer, newState);
+	}
+}
+
+
+void CommandContextNull::EndResourceTransition(IColorBuffer* colorBuffer, ResourceState newState)
+{
+	assert(colorBuffer != nullptr);
+
+	if (colorBuffer->GetUsageState() == newState)
+	{
+		return;
+	}
+
+	// Backends without split barriers do the whole transition here, so a missing begin is not an error
+	auto it = find(m_pendingTransitions.begin(), m_pendingTransitions.end(), make_pair((const IGpuResource*)colorBuffer, newState));
+	if (it != m_pendingTransitions.end())
+	{
+		m_pendingTransitions.erase(it);
+	}
+
+	TransitionResource_Internal(colorBuffer, newState, false);
+}
+
+
+void CommandContextNull::EndResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState)
+{
+	assert(depthBuffer != nullptr);
+
+	if (depthBuffer->GetUsageState() == newState)
+	{
+		return;
+	}
+
+	auto it = find(m_pendingTransitions.begin(), m_pendingTransitions.end(), make_pair((const IGpuResource*)depthBuffer, newState));
+	if (it != m_pendingTransitions.end())
+	{
+		m_pendingTransitions.erase(it);
+	}
+
+	TransitionResource_Internal(depthBuffer, newState, false);
+}
+
+
+void CommandContextNull::FlushResourceBarriers()
+{
+	if (m_numBarriersToFlush > 0)
+	{
+		++m_stats.numBarrierFlushes;
+		m_numBarriersToFlush = 0;
+	}
+}
+
+
+DynAlloc CommandContextNull::ReserveUploadMemory(size_t sizeInBytes)
+{
+	const size_t alignedSize = Math::AlignUp(sizeInBytes, 256);
+
+	m_stats.uploadBytes += sizeInBytes;
+
+	std::byte* pageData = nullptr;
+	size_t offset = 0;
+
+	if (alignedSize > s_uploadPageSize)
+	{
+		m_largeUploadPages.emplace_back(make_unique<std::byte[]>(alignedSize));
+		pageData = m_largeUploadPages.back().get();
+	}
+	else
+	{
+		if (m_currentOffset + alignedSize > s_uploadPageSize)
+		{
+			++m_currentPage;
+			m_currentOffset = 0;
+		}
+
+		if (m_currentPage == m_uploadPages.size())
+		{
+			m_uploadPages.emplace_back(make_unique<std::byte[]>(s_uploadPageSize));
+		}
+
+		pageData = m_uploadPages[m_currentPage].get();
+		offset = m_currentOffset;
+		m_currentOffset += alignedSize;
+	}
+
+	DynAlloc dynAlloc{
+		.resource	= pageData,
+		.offset		= offset,
+		.size		= alignedSize,
+		.dataPtr	= pageData + offset,
+		.gpuAddress	= (uint64_t)(pageData + offset)
+	};
+
+	return dynAlloc;
+}
+
+
+void CommandContextNull::ClearUAV(IGpuBuffer* gpuBuffer)
+{
+	FlushResourceBarriers();
+
+	const Descriptor* uavDescriptor = (const Descriptor*)gpuBuffer->GetUavDescriptor();
+	if (!uavDescriptor->IsValid())
+	{
+		ReportError("ClearUAV called on a buffer without a UAV");
+	}
+	else if (gpuBuffer->GetUsageState() != ResourceState::UnorderedAccess)
+	{
+		ReportError("ClearUAV called on a buffer that is not in the UnorderedAccess state");
+	}
+
+	++m_stats.numClears;
+}
+
+
+void CommandContextNull::ClearColor(IColorBuffer* colorBuffer)
+{
+	ClearColor(colorBuffer, colorBuffer->GetClearColor());
+}
+
+
+void CommandContextNull::ClearColor(IColorBuffer* colorBuffer, Color clearColor)
+{
+	FlushResourceBarriers();
+
+	if (colorBuffer->GetUsageState() != ResourceState::RenderTarget)
+	{
+		ReportError("ClearColor called on a color buffer that is not in the RenderTarget state");
+	}
+
+	++m_stats.numClears;
+}
+
+
+void CommandContextNull::ClearDepth(IDepthBuffer* depthBuffer)
+{
+	FlushResourceBarriers();
+
+	if (depthBuffer->GetUsageState() != ResourceState::DepthWrite)
+	{
+		ReportError("ClearDepth called on a depth buffer that is not in the DepthWrite state");
+	}
+
+	++m_stats.numClears;
+}
+
+
+void CommandContextNull::ClearStencil(IDepthBuffer* depthBuffer)
+{
+	FlushResourceBarriers();
+
+	if (depthBuffer->GetUsageState() != ResourceState::DepthWrite)
+	{
+		ReportError("ClearStencil called on a depth buffer that is not in the DepthWrite state");
+	}
+
+	++m_stats.numClears;
+}
+
+
+void CommandContextNull::ClearDepthAndStencil(IDepthBuffer* depthBuffer)
+{
+	FlushResourceBarriers();
+
+	if (depthBuffer->GetUsageState() != ResourceState::DepthWrite)
+	{
+		ReportError("ClearDepthAndStencil called on a depth buffer that is not in the DepthWrite state");
+	}
+
+	++m_stats.numClears;
+}
+
+
+void CommandContextNull::BeginRendering(const IColorBuffer* renderTarget)
+{
+	ValidateRenderTargets({ &renderTarget, 1 }, nullptr, DepthStencilAspect::ReadWrite);
+}
+
+
+void CommandContextNull::BeginRendering(const IColorBuffer* renderTarget, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect)
+{
+	ValidateRenderTargets({ &renderTarget, 1 }, depthTarget, depthStencilAspect);
+}
+
+
+void CommandContextNull::BeginRendering(const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect)
+{
+	ValidateRenderTargets({}, depthTarget, depthStencilAspect);
+}
+
+
+void CommandContextNull::BeginRendering(std::span<const IColorBuffer*> renderTargets)
+{
+	ValidateRenderTargets(renderTargets, nullptr, DepthStencilAspect::ReadWrite);
+}
+
+
+void CommandContextNull::BeginRendering(std::span<const IColorBuffer*> renderTargets, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect)
+{
+	ValidateRenderTargets(renderTargets, depthTarget, depthStencilAspect);
+}
+
+
+void CommandContextNull::EndRendering()
+{
+	if (!m_isRendering)
+	{
+		ReportError("EndRendering called without a matching BeginRendering");
+	}
+	m_isRendering = false;
+}
+
+
+void CommandContextNull::BeginQuery(const IQueryHeap* queryHeap, uint32_t heapIndex)
+{
+	assert(queryHeap != nullptr);
+
+	if (heapIndex >= queryHeap->GetQueryCount())
+	{
+		ReportError(format("BeginQuery index {} is past the end of a heap with {} queries", heapIndex, queryHeap->GetQueryCount()));
+	}
+
+	++m_stats.numQueries;
+}
+
+
+void CommandContextNull::EndQuery(const IQueryHeap* queryHeap, uint32_t heapIndex)
+{
+	assert(queryHeap != nullptr);
+
+	if (heapIndex >= queryHeap->GetQueryCount())
+	{
+		ReportError(format("EndQuery index {} is past the end of a heap with {} queries", heapIndex, queryHeap->GetQueryCount()));
+	}
+
+	++m_stats.numQueries;
+}
+
+
+void CommandContextNull::ResolveQueries(const IQueryHeap* queryHeap, uint32_t startIndex, uint32_t numQueries, const IGpuBuffer* destBuffer, uint64_t destBufferOffset)
+{
+	assert(queryHeap != nullptr);
+	assert(destBuffer != nullptr);
+
+	if (startIndex + numQueries > queryHeap->GetQueryCount())
+	{
+		ReportError(format("ResolveQueries range [{}, {}) is past the end of a heap with {} queries", startIndex, startIndex + numQueries, queryHeap->GetQueryCount()));
+		return;
+	}
+
+	const size_t resolveSize = numQueries * queryHeap->GetQuerySize();
+	if (destBufferOffset + resolveSize > destBuffer->GetBufferSize())
+	{
+		ReportError(format("ResolveQueries writes {} bytes at offset {}, past the end of a {} byte buffer", resolveSize, destBufferOffset, destBuffer->GetBufferSize()));
+		return;
+	}
+
+	// Queries never execute, so resolve them to zero
+	GpuBuffer* destBufferNull = (GpuBuffer*)destBuffer;
+	memset(destBufferNull->GetData() + destBufferOffset, 0, resolveSize);
+}
+
+
+void CommandContextNull::SetRootSignature(CommandListType type, const IRootSignature* rootSignature)
+{
+	assert(type == CommandListType::Graphics || type == CommandListType::Compute);
+	assert(rootSignature != nullptr);
+
+	auto& state = GetBindingState(type);
+	if (state.rootSignature == rootSignature)
+	{
+		return;
+	}
+
+	// Changing the root signature invalidates all root parameters
+	state.rootSignature = (const RootSignature*)rootSignature;
+	state.rootParameterBitmap = 0;
+
+	++m_stats.numRootSignatureChanges;
+}
+
+
+void CommandContextNull::SetGraphicsPipeline(const IGraphicsPipeline* graphicsPipeline)
+{
+	assert(graphicsPipeline != nullptr);
+
+	SetPipeline_Internal(CommandListType::Graphics, graphicsPipeline, graphicsPipeline->GetRootSignature());
+	m_isMeshletPipeline = false;
+
+	m_primitiveTopology = graphicsPipeline->GetPrimitiveTopology();
+}
+
+
+void CommandContextNull::SetComputePipeline(const IComputePipeline* computePipeline)
+{
+	assert(computePipeline != nullptr);
+
+	SetPipeline_Internal(CommandListType::Compute, computePipeline, computePipeline->GetRootSignature());
+}
+
+
+void CommandContextNull::SetMeshletPipeline(const IMeshletPipeline* meshletPipeline)
+{
+	assert(meshletPipeline != nullptr);
+
+	SetPipeline_Internal(CommandListType::Graphics, meshletPipeline, meshletPipeline->GetRootSignature());
+	m_isMeshletPipeline = true;
+}
+
+
+void CommandContextNull::SetConstantArray(CommandListType type, uint32_t rootIndex, uint32_t numConstants, const void* constants, uint32_t offset)
+{
+	if (!ValidateRootParameter(type, rootIndex, RootParameterType::RootConstants, "SetConstantArray"))
+	{
+		return;
+	}
+
+	const auto& rootParam = GetBindingState(type).rootSignature->GetRootParameter(rootIndex);
+	if (offset + numConstants > rootParam.num32BitConstants)
+	{
+		ReportError(format("SetConstantArray writes {} constants at offset {}, but root parameter {} holds {}", numConstants, offset, rootIndex, rootParam.num32BitConstants));
+	}
+
+	++m_stats.numConstantUpdates;
+}
+
+
+void CommandContextNull::SetConstant(CommandListType type, uint32_t rootIndex, uint32_t offset, DWParam val)
+{
+	SetConstantArray(type, rootIndex, 1, &val, offset);
+}
+
+
+void CommandContextNull::SetConstants(CommandListType type, uint32_t rootIndex, DWParam x)
+{
+	SetConstantArray(type, rootIndex, 1, &x, 0);
+}
+
+
+void CommandContextNull::SetConstants(CommandListType type, uint32_t rootIndex, DWParam x, DWParam y)
+{
+	const DWParam values[] = { x, y };
+	SetConstantArray(type, rootIndex, 2, values, 0);
+}
+
+
+void CommandContextNull::SetConstants(CommandListType type, uint32_t rootIndex, DWParam x, DWParam y, DWParam z)
+{
+	const DWParam values[] = { x, y, z };
+	SetConstantArray(type, rootIndex, 3, values, 0);
+}
+
+
+void CommandContextNull::SetConstants(CommandListType type, uint32_t rootIndex, DWParam x, DWParam y, DWParam z, DWParam w)
+{
+	const DWParam values[] = { x, y, z, w };
+	SetConstantArray(type, rootIndex, 4, values, 0);
+}
+
+
+void CommandContextNull::SetRootCBV(CommandListType type, uint32_t rootIndex, const IGpuBuffer* gpuBuffer, size_t offsetInBytes)
+{
+	assert(gpuBuffer != nullptr);
+
+	if (ValidateRootParameter(type, rootIndex, RootParameterType::RootCBV, "SetRootCBV"))
+	{
+		if (offsetInBytes >= gpuBuffer->GetBufferSize() || !Math::IsAligned(offsetInBytes, 256))
+		{
+			ReportError(format("SetRootCBV offset {} is unaligned or past the end of a {} byte buffer", offsetInBytes, gpuBuffer->GetBufferSize()));
+		}
+	}
+
+	++m_stats.numDescriptorBinds;
+}
+
+
+void CommandContextNull::SetRootSRV(CommandListType type, uint32_t rootIndex, const IGpuBuffer* gpuBuffer, size_t offsetInBytes)
+{
+	assert(gpuBuffer != nullptr);
+
+	if (ValidateRootParameter(type, rootIndex, RootParameterType::RootSRV, "SetRootSRV"))
+	{
+		TrackShaderResource(gpuBuffer, false);
+	}
+
+	++m_stats.numDescriptorBinds;
+}
+
+
+void CommandContextNull::SetRootUAV(CommandListType type, uint32_t rootIndex, const IGpuBuffer* gpuBuffer, size_t offsetInBytes)
+{
+	assert(gpuBuffer != nullptr);
+
+	if (ValidateRootParameter(type, rootIndex, RootParameterType::RootUAV, "SetRootUAV"))
+	{
+		TrackShaderResource(gpuBuffer, true);
+	}
+
+	++m_stats.numDescriptorBinds;
+}
+
+
+void CommandContextNull::SetDescriptors(CommandListType type, uint32_t rootIndex, IDescriptorSet* descriptorSet)
+{
+	assert(descriptorSet != nullptr);
+
+	const DescriptorSet* descriptorSetNull = (const DescriptorSet*)descriptorSet;
+	const auto& setParam = descriptorSetNull->GetRootParameter();
+
+	if (!ValidateRootParameter(type, rootIndex, setParam.parameterType, "SetDescriptors"))
+	{
+		return;
+	}
+
+	const auto& rootParam = GetBindingState(type).rootSignature->GetRootParameter(rootIndex);
+	if (rootParam.GetNumDescriptors() != setParam.GetNumDescriptors() || rootParam.startRegister != setParam.startRegister)
+	{
+		ReportError(format("SetDescriptors: descriptor set layout does not match root parameter {}", rootIndex));
+	}
+
+	// Every descriptor must be written, unless the table allows partially bound ranges
+	if (descriptorSetNull->GetNumWrittenDescriptors() < descriptorSetNull->GetNumDescriptors())
+	{
+		bool isPartiallyBound = false;
+		for (const auto& range : setParam.table)
+		{
+			isPartiallyBound = isPartiallyBound || HasFlag(range.flags, DescriptorRangeFlags::PartiallyBound);
+		}
+
+		if (!isPartiallyBound)
+		{
+			ReportError(format("SetDescriptors: only {} of {} descriptors written for root parameter {}",
+				descriptorSetNull->GetNumWrittenDescriptors(), descriptorSetNull->GetNumDescriptors(), rootIndex));
+		}
+	}
+
+	++m_stats.numDescriptorBinds;
+}
+
+
+void CommandContextNull::SetResources(CommandListType type, ResourceSet& resourceSet)
+{
+	// Held until the descriptor sets are bound, in case another thread is resolving the same set
+	auto pendingTextureLock = resourceSet.ResolvePendingTextures();
+
+	FlushResourceBarriers();
+
+	const uint32_t numDescriptorSets = resourceSet.GetNumDescriptorSets();
+	for (uint32_t i = 0; i < numDescriptorSets; ++i)
+	{
+		// Skip null entries, which are for root constants
+		if (resourceSet[i] == nullptr)
+		{
+			continue;
+		}
+		SetDescriptors(type, i, resourceSet[i].get());
+	}
+}
+
+
+void CommandContextNull::SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const IColorBuffer* colorBuffer)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::SRV, srvRegister, colorBuffer->GetSrvDescriptor());
+	TrackShaderResource(colorBuffer, false);
+}
+
+
+void CommandContextNull::SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const IDepthBuffer* depthBuffer, bool depthSrv)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::SRV, srvRegister, depthBuffer->GetSrvDescriptor(depthSrv));
+	TrackShaderResource(depthBuffer, false);
+}
+
+
+void CommandContextNull::SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const IGpuBuffer* gpuBuffer)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::SRV, srvRegister, gpuBuffer->GetSrvDescriptor());
+	TrackShaderResource(gpuBuffer, false);
+}
+
+
+void CommandContextNull::SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const ITexture* texture)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::SRV, srvRegister, texture->GetDescriptor());
+	TrackShaderResource(texture, false);
+}
+
+
+void CommandContextNull::SetUAV(CommandListType type, uint32_t rootIndex, uint32_t uavRegister, const IColorBuffer* colorBuffer)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::UAV, uavRegister, colorBuffer->GetUavDescriptor());
+	TrackShaderResource(colorBuffer, true);
+}
+
+
+void CommandContextNull::SetUAV(CommandListType type, uint32_t rootIndex, uint32_t uavRegister, const IDepthBuffer* depthBuffer)
+{
+	ReportError(format("SetUAV: depth buffer UAVs are not supported (register u{})", uavRegister));
+}
+
+
+void CommandContextNull::SetUAV(CommandListType type, uint32_t rootIndex, uint32_t uavRegister, const IGpuBuffer* gpuBuffer)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::UAV, uavRegister, gpuBuffer->GetUavDescriptor());
+	TrackShaderResource(gpuBuffer, true);
+}
+
+
+void CommandContextNull::SetCBV(CommandListType type, uint32_t rootIndex, uint32_t cbvRegister, const IGpuBuffer* gpuBuffer)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::CBV, cbvRegister, gpuBuffer->GetCbvDescriptor());
+}
+
+
+void CommandContextNull::SetSampler(CommandListType type, uint32_t rootIndex, uint32_t samplerRegister, const ISampler* sampler)
+{
+	ValidateDynamicDescriptor(type, rootIndex, DescriptorRegisterType::Sampler, samplerRegister, sampler->GetDescriptor());
+}
+
+
+void CommandContextNull::SetIndexBuffer(const IGpuBuffer* gpuBuffer)
+{
+	assert(gpuBuffer != nullptr);
+
+	if (gpuBuffer->GetResourceType() != ResourceType::IndexBuffer)
+	{
+		ReportError("SetIndexBuffer called with a buffer that is not an index buffer");
+	}
+
+	m_hasIndexBuffer = true;
+	++m_stats.numIndexBufferBinds;
+}
+
+
+void CommandContextNull::SetVertexBuffer(uint32_t slot, const IGpuBuffer* gpuBuffer)
+{
+	assert(gpuBuffer != nullptr);
+
+	if (gpuBuffer->GetResourceType() != ResourceType::VertexBuffer)
+	{
+		ReportError(format("SetVertexBuffer called with a buffer that is not a vertex buffer (slot {})", slot));
+	}
+
+	++m_stats.numVertexBufferBinds;
+}
+
+
+void CommandContextNull::SetDynamicVertexBuffer(uint32_t slot, size_t numVertices, size_t vertexStride, DynAlloc dynAlloc)
+{
+	if (dynAlloc.size < numVertices * vertexStride)
+	{
+		ReportError(format("SetDynamicVertexBuffer: {} vertices of {} bytes do not fit in a {} byte allocation", numVertices, vertexStride, dynAlloc.size));
+	}
+
+	++m_stats.numVertexBufferBinds;
+}
+
+
+void CommandContextNull::SetDynamicVertexBuffer(uint32_t slot, size_t numVertices, size_t vertexStride, const void* data)
+{
+	assert(data != nullptr && Math::IsAligned(data, 16));
+
+	const size_t bufferSize = numVertices * vertexStride;
+	DynAlloc vb = ReserveUploadMemory(bufferSize);
+	memcpy(vb.dataPtr, data, bufferSize);
+
+	SetDynamicVertexBuffer(slot, numVertices, vertexStride, vb);
+}
+
+
+void CommandContextNull::SetDynamicIndexBuffer(uint32_t indexCount, bool indexSize16Bit, DynAlloc dynAlloc)
+{
+	const size_t elementSize = indexSize16Bit ? sizeof(uint16_t) : sizeof(uint32_t);
+	if (dynAlloc.size < indexCount * elementSize)
+	{
+		ReportError(format("SetDynamicIndexBuffer: {} indices do not fit in a {} byte allocation", indexCount, dynAlloc.size));
+	}
+
+	m_hasIndexBuffer = true;
+	++m_stats.numIndexBufferBinds;
+}
+
+
+void CommandContextNull::SetDynamicIndexBuffer(uint32_t indexCount, bool indexSize16Bit, const void* data)
+{
+	assert(data != nullptr && Math::IsAligned(data, 16));
+
+	const size_t bufferSize = indexCount * (indexSize16Bit ? sizeof(uint16_t) : sizeof(uint32_t));
+	DynAlloc ib = ReserveUploadMemory(bufferSize);
+	memcpy(ib.dataPtr, data, bufferSize);
+
+	SetDynamicIndexBuffer(indexCount, indexSize16Bit, ib);
+}
+
+
+void CommandContextNull::DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount,
+	uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+	ValidateDraw(false, "DrawInstanced");
+
+	++m_stats.numDraws;
+	m_stats.numPrimitives += GetPrimitiveCount(m_primitiveTopology, vertexCountPerInstance) * instanceCount;
+}
+
+
+void CommandContextNull::DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation,
+	int32_t baseVertexLocation, uint32_t startInstanceLocation)
+{
+	ValidateDraw(true, "DrawIndexedInstanced");
+
+	++m_stats.numDraws;
+	m_stats.numPrimitives += GetPrimitiveCount(m_primitiveTopology, indexCountPerInstance) * instanceCount;
+}
+
+
+void CommandContextNull::DrawIndirect(const IGpuBuffer* argumentBuffer, uint64_t argumentBufferOffset)
+{
+	assert(argumentBuffer->GetResourceType() == ResourceType::IndirectArgsBuffer);
+
+	ValidateDraw(false, "DrawIndirect");
+
+	++m_stats.numDraws;
+	++m_stats.numIndirect;
+}
+
+
+void CommandContextNull::DrawIndexedIndirect(const IGpuBuffer* argumentBuffer, uint64_t argumentBufferOffset)
+{
+	assert(argumentBuffer->GetResourceType() == ResourceType::IndirectArgsBuffer);
+
+	ValidateDraw(true, "DrawIndexedIndirect");
+
+	++m_stats.numDraws;
+	++m_stats.numIndirect;
+}
+
+
+void CommandContextNull::DispatchMesh(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	FlushResourceBarriers();
+
+	if (!m_isMeshletPipeline)
+	{
+		ReportError("DispatchMesh called without a meshlet pipeline");
+	}
+	if (!m_isRendering)
+	{
+		ReportError("DispatchMesh called outside of BeginRendering/EndRendering");
+	}
+	ValidateBindings(CommandListType::Graphics, "DispatchMesh");
+
+	++m_stats.numMeshDispatches;
+}
+
+
+void CommandContextNull::Resolve(const IColorBuffer* srcBuffer, const IColorBuffer* destBuffer, Format format)
+{
+	FlushResourceBarriers();
+
+	if (srcBuffer->GetUsageState() != ResourceState::ResolveSource)
+	{
+		ReportError("Resolve source is not in the ResolveSource state");
+	}
+	if (destBuffer->GetUsageState() != ResourceState::ResolveDest)
+	{
+		ReportError("Resolve destination is not in the ResolveDest state");
+	}
+	if (srcBuffer->GetNumSamples() <= 1)
+	{
+		ReportError("Resolve source is not multisampled");
+	}
+}
+
+
+void CommandContextNull::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	FlushResourceBarriers();
+
+	if (m_computeState.pipeline == nullptr)
+	{
+		ReportError("Dispatch called without a compute pipeline");
+	}
+	if (groupCountX == 0 || groupCountY == 0 || groupCountZ == 0)
+	{
+		ReportError(format("Dispatch called with an empty group count ({}, {}, {})", groupCountX, groupCountY, groupCountZ));
+	}
+	ValidateBindings(CommandListType::Compute, "Dispatch");
+
+	++m_stats.numDispatches;
+}
+
+
+void CommandContextNull::Dispatch1D(uint32_t threadCountX, uint32_t groupSizeX)
+{
+	Dispatch(Math::DivideByMultiple(threadCountX, groupSizeX), 1, 1);
+}
+
+
+void CommandContextNull::Dispatch2D(uint32_t threadCountX, uint32_t threadCountY, uint32_t groupSizeX, uint32_t groupSizeY)
+{
+	Dispatch(
+		Math::DivideByMultiple(threadCountX, groupSizeX),
+		Math::DivideByMultiple(threadCountY, groupSizeY), 1);
+}
+
+
+void CommandContextNull::Dispatch3D(uint32_t threadCountX, uint32_t threadCountY, uint32_t threadCountZ, uint32_t groupSizeX, uint32_t groupSizeY, uint32_t groupSizeZ)
+{
+	Dispatch(
+		Math::DivideByMultiple(threadCountX, groupSizeX),
+		Math::DivideByMultiple(threadCountY, groupSizeY),
+		Math::DivideByMultiple(threadCountZ, groupSizeZ));
+}
+
+
+void CommandContextNull::DispatchIndirect(const IGpuBuffer* argumentBuffer, uint64_t argumentBufferOffset)
+{
+	assert(argumentBuffer->GetResourceType() == ResourceType::IndirectArgsBuffer);
+
+	FlushResourceBarriers();
+
+	if (m_computeState.pipeline == nullptr)
+	{
+		ReportError("DispatchIndirect called without a compute pipeline");
+	}
+	ValidateBindings(CommandListType::Compute, "DispatchIndirect");
+
+	++m_stats.numDispatches;
+	++m_stats.numIndirect;
+}
+
+
+void CommandContextNull::InitializeBuffer_Internal(IGpuBuffer* destBuffer, const void* bufferData, size_t numBytes, size_t offset)
+{
+	GpuBuffer* destBufferNull = (GpuBuffer*)destBuffer;
+	assert(destBufferNull != nullptr);
+
+	// Stage through upload memory like the GPU backends, so upload costs show up in the numbers
+	DynAlloc mem = ReserveUploadMemory(numBytes);
+	memcpy(mem.dataPtr, bufferData, numBytes);
+
+	TransitionResource(destBuffer, ResourceState::CopyDest, true);
+
+	if (offset + numBytes > destBufferNull->GetBufferSize())
+	{
+		ReportError(format("InitializeBuffer writes {} bytes at offset {}, past the end of a {} byte buffer", numBytes, offset, destBufferNull->GetBufferSize()));
+	}
+	else
+	{
+		memcpy(destBufferNull->GetData() + offset, mem.dataPtr, numBytes);
+	}
+
+	TransitionResource(destBuffer, ResourceState::GenericRead, true);
+}
+
+
+void CommandContextNull::InitializeTexture_Internal(ITexture* destTexture, const TextureInitializer& texInit)
+{
+	Texture* textureNull = (Texture*)destTexture;
+	assert(textureNull != nullptr);
+
+	if (texInit.baseData != nullptr && texInit.totalBytes > 0)
+	{
+		DynAlloc mem = ReserveUploadMemory(texInit.totalBytes);
+		memcpy(mem.dataPtr, texInit.baseData, texInit.totalBytes);
+	}
+
+	TransitionResource(destTexture, ResourceState::GenericRead, true);
+}
+
+
+CommandContextNull::BindingState& CommandContextNull::GetBindingState(CommandListType type)
+{
+	assert(type == CommandListType::Graphics || type == CommandListType::Compute);
+	return (type == CommandListType::Graphics) ? m_graphicsState : m_computeState;
+}
+
+
+void CommandContextNull::TransitionResource_Internal(IGpuResource* resource, ResourceState newState, bool bFlushImmediate)
+{
+	const ResourceState oldState = resource->GetUsageState();
+
+	if (m_commandListType == CommandListType::Compute)
+	{
+		if (!IsValidComputeResourceState(oldState) || !IsValidComputeResourceState(newState))
+		{
+			ReportError(format("Transition from 0x{:x} to 0x{:x} is not allowed on a compute queue", (uint32_t)oldState, (uint32_t)newState));
+		}
+	}
+
+	if (oldState != newState)
+	{
+		++m_stats.numTransitions;
+		++m_numBarriersToFlush;
+	}
+
+	resource->SetUsageState(newState);
+
+	if (bFlushImmediate)
+	{
+		FlushResourceBarriers();
+	}
+}
+
+
+void CommandContextNull::SetPipeline_Internal(CommandListType type, const void* pipeline, const IRootSignature* pipelineRootSignature)
+{
+	auto& state = GetBindingState(type);
+
+	if (state.pipeline == pipeline)
+	{
+		++m_stats.numRedundantPipelineChanges;
+		return;
+	}
+
+	state.pipeline = pipeline;
+	state.pipelineRootSignature = pipelineRootSignature;
+
+	++m_stats.numPipelineChanges;
+}
+
+
+bool CommandContextNull::ValidateRootParameter(CommandListType type, uint32_t rootIndex, RootParameterType parameterType, const char* caller)
+{
+	auto& state = GetBindingState(type);
+
+	if (state.rootSignature == nullptr)
+	{
+		ReportError(format("{} called before SetRootSignature", caller));
+		return false;
+	}
+
+	if (rootIndex >= state.rootSignature->GetNumRootParameters())
+	{
+		ReportError(format("{}: root index {} is out of range, the root signature has {} parameters", caller, rootIndex, state.rootSignature->GetNumRootParameters()));
+		return false;
+	}
+
+	const auto& rootParam = state.rootSignature->GetRootParameter(rootIndex);
+	if (rootParam.parameterType != parameterType)
+	{
+		ReportError(format("{}: root parameter {} has type {}, expected {}", caller, rootIndex, (uint32_t)rootParam.parameterType, (uint32_t)parameterType));
+		return false;
+	}
+
+	state.rootParameterBitmap |= (1u << rootIndex);
+	return true;
+}
+
+
+void CommandContextNull::ValidateDynamicDescriptor(CommandListType type, uint32_t rootIndex, DescriptorRegisterType registerType, uint32_t registerIndex, const IDescriptor* descriptor)
+{
+	++m_stats.numDescriptorBinds;
+
+	if (!ValidateRootParameter(type, rootIndex, RootParameterType::Table, "Dynamic descriptor"))
+	{
+		return;
+	}
+
+	const auto& rootParam = GetBindingState(type).rootSignature->GetRootParameter(rootIndex);
+	if (rootParam.FindMatchingRangeIndex(registerType, registerIndex) == ~0u)
+	{
+		ReportError(format("Dynamic descriptor: no range in root parameter {} contains register {} of type {}", rootIndex, registerIndex, (uint32_t)registerType));
+		return;
+	}
+
+	const Descriptor* descriptorNull = (const Descriptor*)descriptor;
+	if (descriptorNull == nullptr || !descriptorNull->IsValid())
+	{
+		ReportError(format("Dynamic descriptor: null or uninitialized descriptor bound to root parameter {}, register {}", rootIndex, registerIndex));
+	}
+	else if (!descriptorNull->IsShaderVisible() || descriptorNull->GetRegisterType() != registerType)
+	{
+		ReportError(format("Dynamic descriptor: descriptor of the wrong type bound to root parameter {}, register {}", rootIndex, registerIndex));
+	}
+}
+
+
+void CommandContextNull::TrackShaderResource(const IGpuResource* resource, bool bUnorderedAccess)
+{
+	m_pendingShaderResources.emplace_back(resource, bUnorderedAccess);
+}
+
+
+void CommandContextNull::ValidateBindings(CommandListType type, const char* caller)
+{
+	const auto& state = GetBindingState(type);
+
+	if (state.rootSignature == nullptr)
+	{
+		ReportError(format("{} called without a root signature", caller));
+	}
+	else
+	{
+		if (state.pipelineRootSignature != nullptr && state.pipelineRootSignature != state.rootSignature)
+		{
+			ReportError(format("{}: the pipeline was created with a different root signature than the one bound", caller));
+		}
+
+		const uint32_t numRootParameters = state.rootSignature->GetNumRootParameters();
+		const uint32_t requiredBitmap = numRootParameters == 32 ? ~0u : ((1u << numRootParameters) - 1);
+		if ((state.rootParameterBitmap & requiredBitmap) != requiredBitmap)
+		{
+			ReportError(format("{}: root parameters 0x{:x} were never set", caller, requiredBitmap & ~state.rootParameterBitmap));
+		}
+	}
+
+	const ResourceState shaderResourceStates =
+		ResourceState::PixelShaderResource | ResourceState::NonPixelShaderResource | ResourceState::GenericRead | ResourceState::DepthRead;
+
+	for (const auto& [resource, bUnorderedAccess] : m_pendingShaderResources)
+	{
+		const ResourceState usageState = resource->GetUsageState();
+		if (bUnorderedAccess && usageState != ResourceState::UnorderedAccess)
+		{
+			ReportError(format("{}: UAV bound to a resource in state 0x{:x}", caller, (uint32_t)usageState));
+		}
+		else if (!bUnorderedAccess && !HasAnyFlag(usageState, shaderResourceStates))
+		{
+			ReportError(format("{}: SRV bound to a resource in state 0x{:x}", caller, (uint32_t)usageState));
+		}
+	}
+	m_pendingShaderResources.clear();
+}
+
+
+void CommandContextNull::ValidateDraw(bool bIndexed, const char* caller)
+{
+	FlushResourceBarriers();
+
+	if (m_graphicsState.pipeline == nullptr || m_isMeshletPipeline)
+	{
+		ReportError(format("{} called without a graphics pipeline", caller));
+	}
+	if (!m_isRendering)
+	{
+		ReportError(format("{} called outside of BeginRendering/EndRendering", caller));
+	}
+	if (bIndexed && !m_hasIndexBuffer)
+	{
+		ReportError(format("{} called without an index buffer", caller));
+	}
+	ValidateBindings(CommandListType::Graphics, caller);
+}
+
+
+void CommandContextNull::ValidateRenderTargets(std::span<const IColorBuffer*> renderTargets, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect)
+{
+	if (m_isRendering)
+	{
+		ReportError("BeginRendering called twice without EndRendering");
+	}
+
+	if (renderTargets.size() > 8)
+	{
+		ReportError(format("BeginRendering called with {} render targets, the limit is 8", renderTargets.size()));
+	}
+
+	FlushResourceBarriers();
+
+	for (const auto* renderTarget : renderTargets)
+	{
+		assert(renderTarget != nullptr);
+		if (renderTarget->GetUsageState() != ResourceState::RenderTarget)
+		{
+			ReportError(format("BeginRendering: render target is in state 0x{:x}, expected RenderTarget", (uint32_t)renderTarget->GetUsageState()));
+		}
+	}
+
+	if (depthTarget != nullptr)
+	{
+		const ResourceState depthState = depthTarget->GetUsageState();
+		const bool isReadOnly = depthStencilAspect == DepthStencilAspect::ReadOnly;
+		const bool isReadWrite = depthStencilAspect == DepthStencilAspect::ReadWrite;
+
+		if ((isReadWrite && depthState != ResourceState::DepthWrite) ||
+			(isReadOnly && !HasAnyFlag(depthState, ResourceState::DepthRead)) ||
+			(!isReadOnly && !isReadWrite && !HasAnyFlag(depthState, ResourceState::DepthRead | ResourceState::DepthWrite)))
+		{
+			ReportError(format("BeginRendering: depth target is in state 0x{:x}, which does not match its depth-stencil aspect", (uint32_t)depthState));
+		}
+	}
+
+	m_isRendering = true;
+	++m_stats.numRenderPasses;
+}
+
+
+void CommandContextNull::ValidateForSubmit()
+{
+	FlushResourceBarriers();
+
+	if (m_isRendering)
+	{
+		ReportError("Finish called between BeginRendering and EndRendering");
+		m_isRendering = false;
+	}
+
+	if (!m_pendingTransitions.empty())
+	{
+		ReportError(format("Finish called with {} split transitions still open", m_pendingTransitions.size()));
+		m_pendingTransitions.clear();
+	}
+}
+
+
+void CommandContextNull::ReportError(const std::string& message)
+{
+	GetNullDeviceManager()->ReportValidationError(m_id.empty() ? message : format("[{}] {}", m_id, message));
+}
+
+} // namespace Luna::Null
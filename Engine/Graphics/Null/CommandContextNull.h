@@ -0,0 +1,240 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\CommandContext.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class RootSignature;
+
+
+// Everything a context recorded.  Contexts merge their counts into the device manager when they finish,
+// which keeps per-frame and whole-run totals.
+struct CommandStats
+{
+	uint64_t numContexts{ 0 };
+	uint64_t numDraws{ 0 };
+	uint64_t numDispatches{ 0 };
+	uint64_t numMeshDispatches{ 0 };
+	uint64_t numIndirect{ 0 };
+	uint64_t numPrimitives{ 0 };
+	uint64_t numPipelineChanges{ 0 };
+	uint64_t numRedundantPipelineChanges{ 0 };
+	uint64_t numRootSignatureChanges{ 0 };
+	uint64_t numDescriptorBinds{ 0 };
+	uint64_t numConstantUpdates{ 0 };
+	uint64_t numVertexBufferBinds{ 0 };
+	uint64_t numIndexBufferBinds{ 0 };
+	uint64_t numTransitions{ 0 };
+	uint64_t numUAVBarriers{ 0 };
+	uint64_t numBarrierFlushes{ 0 };
+	uint64_t numRenderPasses{ 0 };
+	uint64_t numClears{ 0 };
+	uint64_t numQueries{ 0 };
+	uint64_t uploadBytes{ 0 };
+
+	CommandStats& operator+=(const CommandStats& other) noexcept;
+};
+
+
+class CommandContextNull final : public ICommandContext
+{
+public:
+	explicit CommandContextNull(CommandListType type);
+
+	void SetId(const std::string& id) override { m_id = id; }
+	CommandListType GetType() const override { return m_commandListType; }
+
+	// Debug events and markers
+	void BeginEvent(const std::string& label) override { ++m_eventDepth; }
+	void EndEvent() override;
+	void SetMarker(const std::string& label) override {}
+
+	void Reset() override;
+	void Initialize() override {}
+
+	void BeginFrame() override {}
+	uint64_t Finish(bool bWaitForCompletion) override;
+	uint64_t ExecuteChildren(std::span<ICommandContext* const> childContexts) override;
+
+	void TransitionResource(IColorBuffer* colorBuffer, ResourceState newState, bool bFlushImmediate) override;
+	void TransitionResource(IDepthBuffer* depthBuffer, ResourceState newState, bool bFlushImmediate) override;
+	void TransitionResource(IGpuBuffer* gpuBuffer, ResourceState newState, bool bFlushImmediate) override;
+	void TransitionResource(ITexture* texture, ResourceState newState, bool bFlushImmediate) override;
+	void InsertUAVBarrier(const IColorBuffer* colorBuffer, bool bFlushImmediate) override;
+	void InsertUAVBarrier(const IGpuBuffer* gpuBuffer, bool bFlushImmediate) override;
+	void BeginResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) override;
+	void BeginResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) override;
+	void EndResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) override;
+	void EndResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) override;
+	void FlushResourceBarriers() override;
+
+	DynAlloc ReserveUploadMemory(size_t sizeInBytes) override;
+
+	// Graphics context
+	void ClearUAV(IGpuBuffer* gpuBuffer) override;
+	void ClearColor(IColorBuffer* colorBuffer) override;
+	void ClearColor(IColorBuffer* colorBuffer, Color clearColor) override;
+	void ClearDepth(IDepthBuffer* depthBuffer) override;
+	void ClearStencil(IDepthBuffer* depthBuffer) override;
+	void ClearDepthAndStencil(IDepthBuffer* depthBuffer) override;
+
+	void BeginRendering(const IColorBuffer* renderTarget) override;
+	void BeginRendering(const IColorBuffer* renderTarget, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect) override;
+	void BeginRendering(const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect) override;
+	void BeginRendering(std::span<const IColorBuffer*> renderTargets) override;
+	void BeginRendering(std::span<const IColorBuffer*> renderTargets, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect) override;
+	void EndRendering() override;
+
+	void BeginQuery(const IQueryHeap* queryHeap, uint32_t heapIndex) override;
+	void EndQuery(const IQueryHeap* queryHeap, uint32_t heapIndex) override;
+	void ResolveQueries(const IQueryHeap* queryHeap, uint32_t startIndex, uint32_t numQueries, const IGpuBuffer* destBuffer, uint64_t destBufferOffset) override;
+	void ResetQueries(const IQueryHeap* queryHeap, uint32_t startIndex, uint32_t numQueries) override {}
+
+	void SetRootSignature(CommandListType type, const IRootSignature* rootSignature) override;
+	void SetGraphicsPipeline(const IGraphicsPipeline* graphicsPipeline) override;
+	void SetComputePipeline(const IComputePipeline* computePipeline) override;
+	void SetMeshletPipeline(const IMeshletPipeline* meshletPipeline) override;
+
+	void SetViewport(float x, float y, float w, float h, float minDepth = 0.0f, float maxDepth = 1.0f) override {}
+	void SetScissor(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom) override {}
+	void SetStencilRef(uint32_t stencilRef) override {}
+	void SetBlendFactor(Color blendFactor) override {}
+	void SetPrimitiveTopology(PrimitiveTopology topology) override { m_primitiveTopology = topology; }
+	void SetDepthBias(float depthBiasConstantFactor, float depthBiasClamp, float depthBiasSlopeFactor) override {}
+
+	// Root constants
+	void SetConstantArray(CommandListType type, uint32_t rootIndex, uint32_t numConstants, const void* constants, uint32_t offset) override;
+	void SetConstant(CommandListType type, uint32_t rootIndex, uint32_t offset, DWParam val) override;
+	void SetConstants(CommandListType type, uint32_t rootIndex, DWParam x) override;
+	void SetConstants(CommandListType type, uint32_t rootIndex, DWParam x, DWParam y) override;
+	void SetConstants(CommandListType type, uint32_t rootIndex, DWParam x, DWParam y, DWParam z) override;
+	void SetConstants(CommandListType type, uint32_t rootIndex, DWParam x, DWParam y, DWParam z, DWParam w) override;
+
+	// Root CBV/SRV/UAV
+	void SetRootCBV(CommandListType type, uint32_t rootIndex, const IGpuBuffer* gpuBuffer, size_t offsetInBytes) override;
+	void SetRootSRV(CommandListType type, uint32_t rootIndex, const IGpuBuffer* gpuBuffer, size_t offsetInBytes) override;
+	void SetRootUAV(CommandListType type, uint32_t rootIndex, const IGpuBuffer* gpuBuffer, size_t offsetInBytes) override;
+
+	// Descriptor tables
+	void SetDescriptors(CommandListType type, uint32_t rootIndex, IDescriptorSet* descriptorSet) override;
+	void SetResources(CommandListType type, ResourceSet& resourceSet) override;
+
+	// Dynamic SRVs
+	void SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const IColorBuffer* colorBuffer) override;
+	void SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const IDepthBuffer* depthBuffer, bool depthSrv) override;
+	void SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const IGpuBuffer* gpuBuffer) override;
+	void SetSRV(CommandListType type, uint32_t rootIndex, uint32_t srvRegister, const ITexture* texture) override;
+
+	// Dynamic UAVs
+	void SetUAV(CommandListType type, uint32_t rootIndex, uint32_t uavRegister, const IColorBuffer* colorBuffer) override;
+	void SetUAV(CommandListType type, uint32_t rootIndex, uint32_t uavRegister, const IDepthBuffer* depthBuffer) override;
+	void SetUAV(CommandListType type, uint32_t rootIndex, uint32_t uavRegister, const IGpuBuffer* gpuBuffer) override;
+
+	// Dynamic CBV
+	void SetCBV(CommandListType type, uint32_t rootIndex, uint32_t cbvRegister, const IGpuBuffer* gpuBuffer) override;
+
+	// Dynamic sampler
+	void SetSampler(CommandListType type, uint32_t rootIndex, uint32_t samplerRegister, const ISampler* sampler) override;
+
+	void SetIndexBuffer(const IGpuBuffer* gpuBuffer) override;
+	void SetVertexBuffer(uint32_t slot, const IGpuBuffer* gpuBuffer) override;
+	void SetDynamicVertexBuffer(uint32_t slot, size_t numVertices, size_t vertexStride, DynAlloc dynAlloc) override;
+	void SetDynamicVertexBuffer(uint32_t slot, size_t numVertices, size_t vertexStride, const void* data) override;
+	void SetDynamicIndexBuffer(uint32_t indexCount, bool indexSize16Bit, DynAlloc dynAlloc) override;
+	void SetDynamicIndexBuffer(uint32_t indexCount, bool indexSize16Bit, const void* data) override;
+
+	void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount,
+		uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
+	void DrawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation,
+		int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+	void DrawIndirect(const IGpuBuffer* argumentBuffer, uint64_t argumentBufferOffset) override;
+	void DrawIndexedIndirect(const IGpuBuffer* argumentBuffer, uint64_t argumentBufferOffset) override;
+
+	void DispatchMesh(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) override;
+
+	void Resolve(const IColorBuffer* srcBuffer, const IColorBuffer* destBuffer, Format format) override;
+
+	// Compute context
+	void Dispatch(uint32_t groupCountX = 1, uint32_t groupCountY = 1, uint32_t groupCountZ = 1) override;
+	void Dispatch1D(uint32_t threadCountX, uint32_t groupSizeX = 64) override;
+	void Dispatch2D(uint32_t threadCountX, uint32_t threadCountY, uint32_t groupSizeX = 8, uint32_t groupSizeY = 8) override;
+	void Dispatch3D(uint32_t threadCountX, uint32_t threadCountY, uint32_t threadCountZ, uint32_t groupSizeX, uint32_t groupSizeY, uint32_t groupSizeZ) override;
+	void DispatchIndirect(const IGpuBuffer* argumentBuffer, uint64_t argumentBufferOffset) override;
+
+	const CommandStats& GetStats() const noexcept { return m_stats; }
+
+protected:
+	void InitializeBuffer_Internal(IGpuBuffer* destBuffer, const void* bufferData, size_t numBytes, size_t offset) override;
+	void InitializeTexture_Internal(ITexture* destTexture, const TextureInitializer& texInit) override;
+
+private:
+	// Root signature and root parameter state for one bind point
+	struct BindingState
+	{
+		const RootSignature* rootSignature{ nullptr };
+		const void* pipeline{ nullptr };
+		const IRootSignature* pipelineRootSignature{ nullptr };
+		uint32_t rootParameterBitmap{ 0 };
+	};
+
+	BindingState& GetBindingState(CommandListType type);
+
+	void TransitionResource_Internal(IGpuResource* resource, ResourceState newState, bool bFlushImmediate);
+	void SetPipeline_Internal(CommandListType type, const void* pipeline, const IRootSignature* pipelineRootSignature);
+
+	bool ValidateRootParameter(CommandListType type, uint32_t rootIndex, RootParameterType parameterType, const char* caller);
+	void ValidateDynamicDescriptor(CommandListType type, uint32_t rootIndex, DescriptorRegisterType registerType, uint32_t registerIndex, const IDescriptor* descriptor);
+	void TrackShaderResource(const IGpuResource* resource, bool bUnorderedAccess);
+	void ValidateBindings(CommandListType type, const char* caller);
+	void ValidateDraw(bool bIndexed, const char* caller);
+	void ValidateRenderTargets(std::span<const IColorBuffer*> renderTargets, const IDepthBuffer* depthTarget, DepthStencilAspect depthStencilAspect);
+
+	void ValidateForSubmit();
+
+	void ReportError(const std::string& message);
+
+private:
+	std::string m_id;
+	CommandListType m_commandListType;
+
+	CommandStats m_stats;
+
+	BindingState m_graphicsState;
+	BindingState m_computeState;
+	bool m_isMeshletPipeline{ false };
+
+	PrimitiveTopology m_primitiveTopology{ PrimitiveTopology::TriangleList };
+	bool m_hasIndexBuffer{ false };
+	bool m_isRendering{ false };
+	uint32_t m_eventDepth{ 0 };
+
+	// Split transitions that have begun but not ended
+	std::vector<std::pair<const IGpuResource*, ResourceState>> m_pendingTransitions;
+	uint32_t m_numBarriersToFlush{ 0 };
+
+	// Resources bound through dynamic descriptors since the last draw or dispatch.  Their states are checked
+	// when the work is recorded, since a transition between the bind and the draw is legal.
+	std::vector<std::pair<const IGpuResource*, bool>> m_pendingShaderResources;
+
+	// Upload memory.  Pages are kept across Reset(), except for oversized allocations which get their own page.
+	static constexpr size_t s_uploadPageSize{ 0x200000 };
+	std::vector<std::unique_ptr<std::byte[]>> m_uploadPages;
+	std::vector<std::unique_ptr<std::byte[]>> m_largeUploadPages;
+	size_t m_currentPage{ 0 };
+	size_t m_currentOffset{ 0 };
+};
+
+} // namespace Luna::Null
@@ -0,0 +1,41 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\DepthBuffer.h"
+#include "Graphics\Null\DescriptorNull.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+class DepthBuffer : public IDepthBuffer
+{
+	friend class Device;
+
+public:
+	const IDescriptor* GetDsvDescriptor(DepthStencilAspect aspect) const noexcept override { return &m_dsvDescriptor; }
+	const IDescriptor* GetSrvDescriptor(bool depthSrv) const noexcept override
+	{
+		return depthSrv ? &m_depthSrvDescriptor : &m_stencilSrvDescriptor;
+	}
+
+protected:
+	Descriptor m_dsvDescriptor;
+	Descriptor m_depthSrvDescriptor;
+	Descriptor m_stencilSrvDescriptor;
+};
+
+} // namespace Luna::Null
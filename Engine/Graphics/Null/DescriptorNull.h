@@ -0,0 +1,61 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\Descriptor.h"
+#include "Graphics\Enums.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+// A view of a resource, without any backing storage.  The register type says which kind of descriptor
+// range a shader-visible view can be written to.  Render target and depth stencil views cannot be written to
+// descriptor sets at all, and a descriptor that was never created is rejected by validation.
+class Descriptor : public IDescriptor
+{
+	friend class Device;
+
+public:
+	Descriptor() = default;
+
+	void Create(const void* resource, DescriptorRegisterType registerType) noexcept
+	{
+		m_resource = resource;
+		m_registerType = registerType;
+		m_isValid = true;
+		m_isShaderVisible = true;
+	}
+
+	void CreateTargetView(const void* resource) noexcept
+	{
+		m_resource = resource;
+		m_isValid = true;
+		m_isShaderVisible = false;
+	}
+
+	bool IsValid() const noexcept { return m_isValid; }
+	bool IsShaderVisible() const noexcept { return m_isShaderVisible; }
+	const void* GetResource() const noexcept { return m_resource; }
+	DescriptorRegisterType GetRegisterType() const noexcept { return m_registerType; }
+
+private:
+	const void* m_resource{ nullptr };
+	DescriptorRegisterType m_registerType{ DescriptorRegisterType::SRV };
+	bool m_isValid{ false };
+	bool m_isShaderVisible{ false };
+};
+
+} // namespace Luna::Null
@@ -0,0 +1,226 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "DescriptorSetNull.h"
+
+#include "Graphics\ColorBuffer.h"
+#include "Graphics\DepthBuffer.h"
+#include "Graphics\GpuBuffer.h"
+#include "Graphics\Sampler.h"
+#include "Graphics\Texture.h"
+
+#include "DescriptorNull.h"
+#include "DeviceManagerNull.h"
+
+using namespace std;
+
+
+namespace Luna::Null
+{
+
+static DescriptorRegisterType RootParameterTypeToRegisterType(RootParameterType parameterType)
+{
+	switch (parameterType)
+	{
+	case RootParameterType::RootCBV:	return DescriptorRegisterType::CBV;
+	case RootParameterType::RootSRV:	return DescriptorRegisterType::SRV;
+	default:							return DescriptorRegisterType::UAV;
+	}
+}
+
+
+static const char* RegisterTypeToString(DescriptorRegisterType registerType)
+{
+	switch (registerType)
+	{
+	case DescriptorRegisterType::CBV:		return "CBV";
+	case DescriptorRegisterType::SRV:		return "SRV";
+	case DescriptorRegisterType::UAV:		return "UAV";
+	default:								return "Sampler";
+	}
+}
+
+
+DescriptorSet::DescriptorSet(const RootParameter& rootParameter)
+	: m_rootParameter{ rootParameter }
+{
+	if (IsRootDescriptorType(m_rootParameter.parameterType))
+	{
+		m_descriptors.resize(1, nullptr);
+		return;
+	}
+
+	uint32_t offset = 0;
+	for (const auto& range : m_rootParameter.table)
+	{
+		m_rangeOffsets.push_back(offset);
+		offset += range.numDescriptors;
+	}
+	m_descriptors.resize(offset, nullptr);
+}
+
+
+void DescriptorSet::SetBindlessSRVs(uint32_t srvRegister, std::span<const IDescriptor*> descriptors)
+{
+	WriteDescriptors(DescriptorRegisterType::SRV, srvRegister, descriptors);
+}
+
+
+void DescriptorSet::SetSRV(uint32_t srvRegister, ColorBufferPtr colorBuffer)
+{
+	const IDescriptor* descriptor = colorBuffer ? colorBuffer->GetSrvDescriptor() : nullptr;
+	WriteDescriptors(DescriptorRegisterType::SRV, srvRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::SetSRV(uint32_t srvRegister, DepthBufferPtr depthBuffer, bool depthSrv)
+{
+	const IDescriptor* descriptor = depthBuffer ? depthBuffer->GetSrvDescriptor(depthSrv) : nullptr;
+	WriteDescriptors(DescriptorRegisterType::SRV, srvRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::SetSRV(uint32_t srvRegister, GpuBufferPtr gpuBuffer)
+{
+	const IDescriptor* descriptor = gpuBuffer ? gpuBuffer->GetSrvDescriptor() : nullptr;
+	WriteDescriptors(DescriptorRegisterType::SRV, srvRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::SetSRV(uint32_t srvRegister, TexturePtr texture)
+{
+	const IDescriptor* descriptor = nullptr;
+	if (texture.Get() != nullptr)
+	{
+		texture->WaitForLoad();
+		descriptor = texture->GetDescriptor();
+	}
+	WriteDescriptors(DescriptorRegisterType::SRV, srvRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::SetUAV(uint32_t uavRegister, ColorBufferPtr colorBuffer, uint32_t uavIndex)
+{
+	const IDescriptor* descriptor = colorBuffer ? colorBuffer->GetUavDescriptor(uavIndex) : nullptr;
+	WriteDescriptors(DescriptorRegisterType::UAV, uavRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::SetUAV(uint32_t uavRegister, DepthBufferPtr depthBuffer)
+{
+	GetNullDeviceManager()->ReportValidationError(
+		format("DescriptorSet: depth buffer UAVs are not supported (register u{})", uavRegister));
+}
+
+
+void DescriptorSet::SetUAV(uint32_t uavRegister, GpuBufferPtr gpuBuffer)
+{
+	const IDescriptor* descriptor = gpuBuffer ? gpuBuffer->GetUavDescriptor() : nullptr;
+	WriteDescriptors(DescriptorRegisterType::UAV, uavRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::SetCBV(uint32_t cbvRegister, GpuBufferPtr gpuBuffer)
+{
+	const IDescriptor* descriptor = gpuBuffer ? gpuBuffer->GetCbvDescriptor() : nullptr;
+	WriteDescriptors(DescriptorRegisterType::CBV, cbvRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::SetSampler(uint32_t samplerRegister, SamplerPtr sampler)
+{
+	const IDescriptor* descriptor = sampler ? sampler->GetDescriptor() : nullptr;
+	WriteDescriptors(DescriptorRegisterType::Sampler, samplerRegister, { &descriptor, 1 });
+}
+
+
+void DescriptorSet::Rename()
+{
+	// There is no GPU reading the table, so the descriptors stay where they are
+	++m_numRenames;
+}
+
+
+void DescriptorSet::WriteDescriptors(DescriptorRegisterType registerType, uint32_t registerIndex, std::span<const IDescriptor*> descriptors)
+{
+	auto deviceManager = GetNullDeviceManager();
+
+	uint32_t firstSlot = 0;
+	uint32_t lastSlot = 0;
+
+	if (IsRootDescriptorType(m_rootParameter.parameterType))
+	{
+		if (RootParameterTypeToRegisterType(m_rootParameter.parameterType) != registerType ||
+			m_rootParameter.startRegister != registerIndex ||
+			descriptors.size() != 1)
+		{
+			deviceManager->ReportValidationError(
+				format("DescriptorSet: {} register {} does not match the root descriptor parameter", RegisterTypeToString(registerType), registerIndex));
+			return;
+		}
+		lastSlot = 1;
+	}
+	else
+	{
+		const uint32_t rangeIndex = m_rootParameter.FindMatchingRangeIndex(registerType, registerIndex);
+		if (rangeIndex == ~0u)
+		{
+			deviceManager->ReportValidationError(
+				format("DescriptorSet: no {} range in the descriptor table contains register {}", RegisterTypeToString(registerType), registerIndex));
+			return;
+		}
+
+		const auto& range = m_rootParameter.table[rangeIndex];
+		const uint32_t registerOffset = registerIndex - range.startRegister;
+		if (registerOffset + descriptors.size() > range.numDescriptors)
+		{
+			deviceManager->ReportValidationError(
+				format("DescriptorSet: writing {} {}s at register {} overflows a range of {} descriptors",
+					descriptors.size(), RegisterTypeToString(registerType), registerIndex, range.numDescriptors));
+			return;
+		}
+
+		firstSlot = m_rangeOffsets[rangeIndex] + registerOffset;
+		lastSlot = firstSlot + (uint32_t)descriptors.size();
+	}
+
+	for (uint32_t slot = firstSlot; slot < lastSlot; ++slot)
+	{
+		const Descriptor* descriptor = (const Descriptor*)descriptors[slot - firstSlot];
+		const uint32_t slotRegister = registerIndex + (slot - firstSlot);
+
+		if (descriptor == nullptr || !descriptor->IsValid())
+		{
+			deviceManager->ReportValidationError(
+				format("DescriptorSet: null or uninitialized descriptor written to {} register {}", RegisterTypeToString(registerType), slotRegister));
+			continue;
+		}
+
+		if (!descriptor->IsShaderVisible() || descriptor->GetRegisterType() != registerType)
+		{
+			deviceManager->ReportValidationError(
+				format("DescriptorSet: {} descriptor written to {} register {}",
+					descriptor->IsShaderVisible() ? RegisterTypeToString(descriptor->GetRegisterType()) : "render target",
+					RegisterTypeToString(registerType),
+					slotRegister));
+			continue;
+		}
+
+		if (m_descriptors[slot] == nullptr)
+		{
+			++m_numWrittenDescriptors;
+		}
+		m_descriptors[slot] = descriptor;
+	}
+}
+
+} // namespace Luna::Null
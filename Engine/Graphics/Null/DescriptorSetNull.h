@@ -0,0 +1,67 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\DescriptorSet.h"
+#include "Graphics\RootSignature.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Descriptor;
+
+
+// Records which descriptor is written to each slot of a table, or to a root CBV/SRV/UAV.  Every write is
+// checked against the root parameter: the register must fall inside a range of the matching type, and the
+// descriptor must exist and be of that type.
+class DescriptorSet : public IDescriptorSet
+{
+public:
+	explicit DescriptorSet(const RootParameter& rootParameter);
+
+	void SetBindlessSRVs(uint32_t srvRegister, std::span<const IDescriptor*> descriptors) override;
+
+	void SetSRV(uint32_t srvRegister, ColorBufferPtr colorBuffer) override;
+	void SetSRV(uint32_t srvRegister, DepthBufferPtr depthBuffer, bool depthSrv = true) override;
+	void SetSRV(uint32_t srvRegister, GpuBufferPtr gpuBuffer) override;
+	void SetSRV(uint32_t srvRegister, TexturePtr texture) override;
+
+	void SetUAV(uint32_t uavRegister, ColorBufferPtr colorBuffer, uint32_t uavIndex = 0) override;
+	void SetUAV(uint32_t uavRegister, DepthBufferPtr depthBuffer) override;
+	void SetUAV(uint32_t uavRegister, GpuBufferPtr gpuBuffer) override;
+
+	void SetCBV(uint32_t cbvRegister, GpuBufferPtr gpuBuffer) override;
+
+	void SetSampler(uint32_t samplerRegister, SamplerPtr sampler) override;
+
+	void Rename() override;
+
+	const RootParameter& GetRootParameter() const noexcept { return m_rootParameter; }
+	uint32_t GetNumDescriptors() const noexcept { return (uint32_t)m_descriptors.size(); }
+	uint32_t GetNumWrittenDescriptors() const noexcept { return m_numWrittenDescriptors; }
+	uint32_t GetNumRenames() const noexcept { return m_numRenames; }
+
+protected:
+	void WriteDescriptors(DescriptorRegisterType registerType, uint32_t registerIndex, std::span<const IDescriptor*> descriptors);
+
+protected:
+	RootParameter m_rootParameter;
+
+	// One entry per descriptor in the table, with the ranges laid out in declaration order
+	std::vector<const Descriptor*> m_descriptors;
+	std::vector<uint32_t> m_rangeOffsets;
+	uint32_t m_numWrittenDescriptors{ 0 };
+	uint32_t m_numRenames{ 0 };
+};
+
+} // namespace Luna::Null
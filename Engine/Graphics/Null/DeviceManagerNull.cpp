@@ -0,0 +1,293 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "DeviceManagerNull.h"
+
+#include "Graphics\CommandContext.h"
+
+#include "DeviceNull.h"
+
+using namespace std;
+
+
+namespace Luna::Null
+{
+
+static DeviceManager* g_nullDeviceManager{ nullptr };
+
+
+DeviceManager::DeviceManager(const DeviceManagerDesc& desc)
+	: m_desc{ desc }
+	, m_contextPool{ [](CommandListType type) -> ICommandContext* { return new CommandContextNull(type); } }
+{
+	for (uint32_t i = 0; i < (uint32_t)CommandListType::Count; ++i)
+	{
+		m_fenceValues[i] = (uint64_t)i << 56;
+	}
+
+	extern Luna::IDeviceManager* g_deviceManager;
+	assert(!g_deviceManager);
+
+	g_deviceManager = this;
+	g_nullDeviceManager = this;
+}
+
+
+DeviceManager::~DeviceManager()
+{
+	// Streaming textures record their uploads, so let them finish first
+	if (m_textureManager)
+	{
+		m_textureManager->WaitForAsyncLoads();
+	}
+
+	if (m_uploadQueue)
+	{
+		m_uploadQueue->Flush();
+	}
+
+	WaitForGpu();
+
+	// Release the resources still referenced by in-flight upload batches
+	m_uploadQueue.reset();
+
+	LogSummary();
+
+	extern Luna::IDeviceManager* g_deviceManager;
+	g_deviceManager = nullptr;
+	g_nullDeviceManager = nullptr;
+}
+
+
+void DeviceManager::BeginFrame()
+{
+	ScopedEvent event{ "DeviceManager::BeginFrame" };
+
+	lock_guard<mutex> lock(m_statsMutex);
+	m_frameStats = CommandStats{};
+}
+
+
+void DeviceManager::Present()
+{
+	ScopedEvent event{ "DeviceManager::Present" };
+
+	{
+		lock_guard<mutex> lock(m_statsMutex);
+		m_lastFrameStats = m_frameStats;
+	}
+
+	++m_frameNumber;
+	m_backBufferIndex = (uint32_t)(m_frameNumber % m_desc.numSwapChainBuffers);
+}
+
+
+void DeviceManager::WaitForGpu()
+{
+	// Nothing is ever in flight
+}
+
+
+void DeviceManager::WaitForFence(uint64_t fenceValue)
+{
+	// Fences complete when they are signaled
+}
+
+
+bool DeviceManager::IsFenceComplete(uint64_t fenceValue)
+{
+	const uint32_t typeIndex = (uint32_t)(fenceValue >> 56);
+	assert(typeIndex < (uint32_t)CommandListType::Count);
+
+	return fenceValue <= m_fenceValues[typeIndex];
+}
+
+
+void DeviceManager::SetWindowSize(uint32_t width, uint32_t height)
+{
+	if (m_desc.backBufferWidth == width && m_desc.backBufferHeight == height)
+	{
+		return;
+	}
+
+	m_desc.backBufferWidth = width;
+	m_desc.backBufferHeight = height;
+
+	for (auto& swapChainBuffer : m_swapChainBuffers)
+	{
+		m_device->ResizeSwapChainBuffer(swapChainBuffer.get(), width, height);
+	}
+}
+
+
+void DeviceManager::CreateDeviceResources()
+{
+	m_device = make_unique<Device>();
+
+	if (m_desc.logDeviceCaps)
+	{
+		m_device->GetDeviceCaps().LogCaps();
+	}
+
+	m_textureManager = make_unique<TextureManager>(m_device.get());
+	m_uploadQueue = make_unique<UploadQueue>();
+
+	LogInfo(LogNullDevice) << "Created null device, no GPU commands will be submitted" << endl;
+}
+
+
+void DeviceManager::CreateWindowSizeDependentResources()
+{
+	m_swapChainBuffers.clear();
+
+	// There is no presentation engine, so the swap chain format is used as-is
+	m_swapChainFormat = RemoveSrgb(m_desc.swapChainFormat);
+
+	for (uint32_t i = 0; i < m_desc.numSwapChainBuffers; ++i)
+	{
+		ColorBufferPtr swapChainBuffer = m_device->CreateSwapChainBuffer(
+			format("Primary SwapChain Image {}", i),
+			m_desc.backBufferWidth,
+			m_desc.backBufferHeight,
+			m_swapChainFormat);
+		m_swapChainBuffers.emplace_back(swapChainBuffer);
+	}
+
+	m_backBufferIndex = (uint32_t)(m_frameNumber % m_desc.numSwapChainBuffers);
+}
+
+
+CommandContext* DeviceManager::AllocateContext(CommandListType commandListType)
+{
+	return m_contextPool.Allocate(commandListType);
+}
+
+
+void DeviceManager::FreeContext(CommandContext* usedContext)
+{
+	m_contextPool.Free(usedContext);
+}
+
+
+ColorBufferPtr DeviceManager::GetColorBuffer() const
+{
+	return m_swapChainBuffers[m_backBufferIndex];
+}
+
+
+Format DeviceManager::GetColorFormat() const
+{
+	return m_swapChainFormat;
+}
+
+
+Format DeviceManager::GetDepthFormat() const
+{
+	return m_desc.depthBufferFormat;
+}
+
+
+const string& DeviceManager::GetDeviceName() const
+{
+	return m_deviceName;
+}
+
+
+IDevice* DeviceManager::GetDevice()
+{
+	return m_device.get();
+}
+
+
+uint64_t DeviceManager::SignalFence(CommandListType commandListType)
+{
+	return ++m_fenceValues[(uint32_t)commandListType];
+}
+
+
+void DeviceManager::ReportValidationError(const string& message)
+{
+	++m_numValidationErrors;
+
+	lock_guard<mutex> lock(m_validationMutex);
+
+	if (m_reportedErrors.insert(message).second)
+	{
+		LogError(LogNullDevice) << message << endl;
+	}
+}
+
+
+void DeviceManager::AddCommandStats(const CommandStats& stats)
+{
+	lock_guard<mutex> lock(m_statsMutex);
+
+	m_frameStats += stats;
+	m_totalStats += stats;
+}
+
+
+CommandStats DeviceManager::GetLastFrameStats() const
+{
+	lock_guard<mutex> lock(m_statsMutex);
+	return m_lastFrameStats;
+}
+
+
+CommandStats DeviceManager::GetTotalStats() const
+{
+	lock_guard<mutex> lock(m_statsMutex);
+	return m_totalStats;
+}
+
+
+void DeviceManager::LogSummary()
+{
+	const CommandStats totalStats = GetTotalStats();
+	const uint64_t numFrames = max<uint64_t>(m_frameNumber, 1);
+
+	LogInfo(LogNullDevice) << format("Null device summary over {} frames", m_frameNumber) << endl;
+	LogInfo(LogNullDevice) << format("  Contexts:          {} ({:.1f}/frame)", totalStats.numContexts, (double)totalStats.numContexts / numFrames) << endl;
+	LogInfo(LogNullDevice) << format("  Draws:             {} ({:.1f}/frame)", totalStats.numDraws, (double)totalStats.numDraws / numFrames) << endl;
+	LogInfo(LogNullDevice) << format("  Dispatches:        {} ({:.1f}/frame)", totalStats.numDispatches, (double)totalStats.numDispatches / numFrames) << endl;
+	LogInfo(LogNullDevice) << format("  Mesh dispatches:   {} ({:.1f}/frame)", totalStats.numMeshDispatches, (double)totalStats.numMeshDispatches / numFrames) << endl;
+	LogInfo(LogNullDevice) << format("  Indirect:          {} ({:.1f}/frame)", totalStats.numIndirect, (double)totalStats.numIndirect / numFrames) << endl;
+	LogInfo(LogNullDevice) << format("  Primitives:        {} ({:.1f}/frame)", totalStats.numPrimitives, (double)totalStats.numPrimitives / numFrames) << endl;
+	LogInfo(LogNullDevice) << format("  Pipeline changes:  {} ({} redundant)", totalStats.numPipelineChanges, totalStats.numRedundantPipelineChanges) << endl;
+	LogInfo(LogNullDevice) << format("  Descriptor binds:  {} ({:.1f}/frame)", totalStats.numDescriptorBinds, (double)totalStats.numDescriptorBinds / numFrames) << endl;
+	LogInfo(LogNullDevice) << format("  Transitions:       {} in {} barrier flushes", totalStats.numTransitions, totalStats.numBarrierFlushes) << endl;
+	LogInfo(LogNullDevice) << format("  Upload bytes:      {} ({:.1f}/frame)", totalStats.uploadBytes, (double)totalStats.uploadBytes / numFrames) << endl;
+
+	if (m_device)
+	{
+		const ResourceStats resourceStats = m_device->GetResourceStats();
+		LogInfo(LogNullDevice) << format("  Buffers:           {} ({} bytes)", resourceStats.numGpuBuffers, resourceStats.gpuBufferBytes) << endl;
+		LogInfo(LogNullDevice) << format("  Textures:          {} ({} bytes)", resourceStats.numTextures, resourceStats.textureBytes) << endl;
+		LogInfo(LogNullDevice) << format("  Render targets:    {} color, {} depth", resourceStats.numColorBuffers, resourceStats.numDepthBuffers) << endl;
+		LogInfo(LogNullDevice) << format("  Pipelines:         {} ({} root signatures)", resourceStats.numPipelines, resourceStats.numRootSignatures) << endl;
+	}
+
+	if (m_numValidationErrors > 0)
+	{
+		LogWarning(LogNullDevice) << format("  Validation errors: {} ({} unique)", m_numValidationErrors.load(), m_reportedErrors.size()) << endl;
+	}
+}
+
+
+DeviceManager* GetNullDeviceManager()
+{
+	assert(g_nullDeviceManager != nullptr);
+
+	return g_nullDeviceManager;
+}
+
+} // namespace Luna::Null
@@ -0,0 +1,122 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\ColorBuffer.h"
+#include "Graphics\CommandContextPool.h"
+#include "Graphics\DeviceManager.h"
+#include "Graphics\Texture.h"
+#include "Graphics\UploadQueue.h"
+
+#include "CommandContextNull.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+// Runs the renderer without a GPU or a window.  Command contexts validate and count what they record, and the
+// "swap chain" is a ring of plain color buffers, so any Application can run headless for a fixed number of frames.
+class DeviceManager final : public IDeviceManager, public NonCopyable
+{
+public:
+	DeviceManager(const DeviceManagerDesc& desc);
+	virtual ~DeviceManager();
+
+	void BeginFrame() final;
+	void Present() final;
+
+	void WaitForGpu() final;
+	void WaitForFence(uint64_t fenceValue) final;
+	bool IsFenceComplete(uint64_t fenceValue) final;
+
+	void SetWindowSize(uint32_t width, uint32_t height) final;
+	void CreateDeviceResources() final;
+	void CreateWindowSizeDependentResources() final;
+
+	CommandContext* AllocateContext(CommandListType commandListType) final;
+	void FreeContext(CommandContext* usedContext) final;
+
+	GraphicsApi GetGraphicsApi() const override { return GraphicsApi::Null; }
+
+	Luna::ColorBufferPtr GetColorBuffer() const final;
+
+	Format GetColorFormat() const final;
+	Format GetDepthFormat() const final;
+
+	const std::string& GetDeviceName() const override;
+
+	uint32_t GetNumSwapChainBuffers() const override { return m_desc.numSwapChainBuffers; }
+	uint32_t GetActiveFrame() const override { return m_backBufferIndex; }
+	uint64_t GetFrameNumber() const override { return m_frameNumber; }
+
+	IDevice* GetDevice() override;
+
+	// Fence values carry the command list type in the top 8 bits, like the GPU backends
+	uint64_t SignalFence(CommandListType commandListType);
+
+	// Validation errors are counted every time, but each distinct message is only logged once
+	void ReportValidationError(const std::string& message);
+	uint64_t GetNumValidationErrors() const { return m_numValidationErrors; }
+
+	// Command stats, merged in by contexts as they finish
+	void AddCommandStats(const CommandStats& stats);
+	CommandStats GetLastFrameStats() const;
+	CommandStats GetTotalStats() const;
+
+private:
+	void LogSummary();
+
+private:
+	DeviceManagerDesc m_desc{};
+
+	std::string m_deviceName{ "Null Device" };
+
+	// Null device
+	std::unique_ptr<Device> m_device;
+
+	// Texture manager
+	std::unique_ptr<TextureManager> m_textureManager;
+
+	// Batched resource initialization
+	std::unique_ptr<UploadQueue> m_uploadQueue;
+
+	// Swap-chain objects
+	std::vector<ColorBufferPtr> m_swapChainBuffers;
+	uint32_t m_backBufferIndex{ 0 };
+	Format m_swapChainFormat{ Format::Unknown };
+	uint64_t m_frameNumber{ 0 };
+
+	// Fences complete as soon as they are signaled
+	std::array<std::atomic<uint64_t>, (uint32_t)CommandListType::Count> m_fenceValues;
+
+	// Command context handling
+	CommandContextPool m_contextPool;
+
+	// Validation
+	std::mutex m_validationMutex;
+	std::atomic<uint64_t> m_numValidationErrors{ 0 };
+	std::set<std::string> m_reportedErrors;
+
+	// Command stats
+	mutable std::mutex m_statsMutex;
+	CommandStats m_frameStats;
+	CommandStats m_lastFrameStats;
+	CommandStats m_totalStats;
+};
+
+
+DeviceManager* GetNullDeviceManager();
+
+} // namespace Luna::Null
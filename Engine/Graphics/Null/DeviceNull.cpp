@@ -0,0 +1,510 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "DeviceNull.h"
+
+#include "Graphics\CommandContext.h"
+#include "Graphics\Formats.h"
+#include "Graphics\MipGenerator.h"
+
+#include "ColorBufferNull.h"
+#include "DepthBufferNull.h"
+#include "GpuBufferNull.h"
+#include "PipelineStateNull.h"
+#include "QueryHeapNull.h"
+#include "RootSignatureNull.h"
+#include "SamplerNull.h"
+#include "TextureNull.h"
+
+using namespace std;
+
+
+namespace Luna::Null
+{
+
+static Device* g_nullDevice{ nullptr };
+
+
+Device::Device()
+{
+	FillCaps();
+
+	assert(g_nullDevice == nullptr);
+	g_nullDevice = this;
+}
+
+
+Device::~Device()
+{
+	g_nullDevice = nullptr;
+}
+
+
+Luna::ColorBufferPtr Device::CreateColorBuffer(const ColorBufferDesc& colorBufferDesc)
+{
+	auto colorBuffer = std::make_shared<ColorBuffer>();
+	colorBuffer->m_type = colorBufferDesc.resourceType;
+	colorBuffer->m_width = colorBufferDesc.width;
+	colorBuffer->m_height = colorBufferDesc.height;
+	colorBuffer->m_arraySizeOrDepth = colorBufferDesc.arraySizeOrDepth;
+	colorBuffer->m_numMips = colorBufferDesc.numMips == 0 ? GetFullMipCount((uint32_t)colorBufferDesc.width, colorBufferDesc.height) : colorBufferDesc.numMips;
+	colorBuffer->m_numSamples = colorBufferDesc.numSamples;
+	colorBuffer->m_planeCount = 1;
+	colorBuffer->m_format = colorBufferDesc.format;
+	colorBuffer->m_dimension = ResourceTypeToTextureDimension(colorBuffer->m_type);
+	colorBuffer->m_clearColor = colorBufferDesc.clearColor;
+
+	assert_msg(colorBufferDesc.arraySizeOrDepth == 1 || colorBuffer->m_numMips == 1, "We don't support auto-mips on texture arrays");
+
+	colorBuffer->m_srvDescriptor.Create(colorBuffer.get(), DescriptorRegisterType::SRV);
+	colorBuffer->m_rtvDescriptor.CreateTargetView(colorBuffer.get());
+
+	// Multisampled color buffers have no UAVs
+	if (colorBufferDesc.numSamples == 1)
+	{
+		colorBuffer->m_uavDescriptor.Create(colorBuffer.get(), DescriptorRegisterType::UAV);
+	}
+
+	++m_numColorBuffers;
+
+	return colorBuffer;
+}
+
+
+Luna::DepthBufferPtr Device::CreateDepthBuffer(const DepthBufferDesc& depthBufferDesc)
+{
+	auto depthBuffer = std::make_shared<DepthBuffer>();
+	depthBuffer->m_type = depthBufferDesc.resourceType;
+	depthBuffer->m_width = depthBufferDesc.width;
+	depthBuffer->m_height = depthBufferDesc.height;
+	depthBuffer->m_arraySizeOrDepth = depthBufferDesc.arraySizeOrDepth;
+	depthBuffer->m_numMips = 1;
+	depthBuffer->m_numSamples = depthBufferDesc.numSamples;
+	depthBuffer->m_planeCount = IsStencilFormat(depthBufferDesc.format) ? 2 : 1;
+	depthBuffer->m_format = depthBufferDesc.format;
+	depthBuffer->m_dimension = ResourceTypeToTextureDimension(depthBuffer->m_type);
+	depthBuffer->m_clearDepth = depthBufferDesc.clearDepth;
+	depthBuffer->m_clearStencil = depthBufferDesc.clearStencil;
+
+	if (!IsDepthStencilFormat(depthBufferDesc.format))
+	{
+		LogError(LogNullDevice) << "Depth buffer " << depthBufferDesc.name << " created with a format that has no depth or stencil" << endl;
+	}
+
+	depthBuffer->m_dsvDescriptor.CreateTargetView(depthBuffer.get());
+
+	if (depthBufferDesc.createShaderResources)
+	{
+		depthBuffer->m_depthSrvDescriptor.Create(depthBuffer.get(), DescriptorRegisterType::SRV);
+
+		if (IsStencilFormat(depthBufferDesc.format))
+		{
+			depthBuffer->m_stencilSrvDescriptor.Create(depthBuffer.get(), DescriptorRegisterType::SRV);
+		}
+	}
+
+	++m_numDepthBuffers;
+
+	return depthBuffer;
+}
+
+
+Luna::GpuBufferPtr Device::CreateGpuBuffer(const GpuBufferDesc& gpuBufferDescIn)
+{
+	GpuBufferDesc gpuBufferDesc = gpuBufferDescIn;
+	if (gpuBufferDescIn.resourceType == ResourceType::ConstantBuffer)
+	{
+		gpuBufferDesc.elementSize = Math::AlignUp(gpuBufferDescIn.elementSize, 256);
+	}
+
+	auto gpuBuffer = std::make_shared<GpuBuffer>();
+	gpuBuffer->m_type = gpuBufferDesc.resourceType;
+	gpuBuffer->m_usageState = ResourceState::GenericRead;
+	gpuBuffer->m_format = gpuBufferDesc.format;
+	gpuBuffer->m_elementSize = gpuBufferDescIn.elementSize;
+	gpuBuffer->m_elementCount = gpuBufferDesc.elementCount;
+	gpuBuffer->m_bufferSize = gpuBuffer->m_elementCount * gpuBuffer->m_elementSize;
+	gpuBuffer->m_isCpuWriteable = HasFlag(gpuBufferDesc.memoryAccess, MemoryAccess::CpuWrite);
+
+	const size_t bufferSize = gpuBufferDesc.elementCount * gpuBufferDesc.elementSize;
+	gpuBuffer->m_data.resize(bufferSize);
+
+	if (gpuBufferDesc.resourceType == ResourceType::ByteAddressBuffer || gpuBufferDesc.resourceType == ResourceType::IndirectArgsBuffer ||
+		gpuBufferDesc.resourceType == ResourceType::StructuredBuffer || gpuBufferDesc.resourceType == ResourceType::TypedBuffer)
+	{
+		gpuBuffer->m_srvDescriptor.Create(gpuBuffer.get(), DescriptorRegisterType::SRV);
+		gpuBuffer->m_uavDescriptor.Create(gpuBuffer.get(), DescriptorRegisterType::UAV);
+	}
+
+	if (gpuBufferDesc.resourceType == ResourceType::ConstantBuffer)
+	{
+		gpuBuffer->m_cbvDescriptor.Create(gpuBuffer.get(), DescriptorRegisterType::CBV);
+	}
+
+	if (gpuBufferDesc.resourceType == ResourceType::VertexBuffer || gpuBufferDesc.resourceType == ResourceType::IndexBuffer)
+	{
+		if (gpuBufferDesc.bAllowShaderResource)
+		{
+			gpuBuffer->m_srvDescriptor.Create(gpuBuffer.get(), DescriptorRegisterType::SRV);
+		}
+
+		if (gpuBufferDesc.bAllowUnorderedAccess)
+		{
+			gpuBuffer->m_uavDescriptor.Create(gpuBuffer.get(), DescriptorRegisterType::UAV);
+		}
+	}
+
+	++m_numGpuBuffers;
+	m_gpuBufferBytes += bufferSize;
+
+	if (gpuBufferDescIn.initialData)
+	{
+		if (gpuBuffer->m_type == ResourceType::ConstantBuffer)
+		{
+			memcpy(gpuBuffer->m_data.data(), gpuBufferDesc.initialData, gpuBuffer->GetBufferSize());
+		}
+		else
+		{
+			GpuBufferPtr temp = gpuBuffer;
+			CommandContext::InitializeBuffer(temp, gpuBufferDescIn.initialData, gpuBuffer->GetBufferSize());
+		}
+	}
+
+	return gpuBuffer;
+}
+
+
+Luna::RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignatureDesc)
+{
+	const uint32_t numRootParameters = (uint32_t)rootSignatureDesc.rootParameters.size();
+	if (numRootParameters > MaxRootParameters)
+	{
+		LogError(LogNullDevice) << "Root signature " << rootSignatureDesc.name << " has " << numRootParameters
+			<< " root parameters, the limit is " << MaxRootParameters << endl;
+	}
+
+	for (uint32_t i = 0; i < numRootParameters; ++i)
+	{
+		const auto& rootParam = rootSignatureDesc.rootParameters[i];
+		if (rootParam.parameterType == RootParameterType::Table)
+		{
+			if (rootParam.table.empty())
+			{
+				LogError(LogNullDevice) << "Root signature " << rootSignatureDesc.name << ": root parameter " << i << " is an empty table" << endl;
+			}
+
+			// Sampler ranges cannot share a table with CBV/SRV/UAV ranges
+			const bool isSamplerTable = rootParam.IsSamplerTable();
+			for (const auto& range : rootParam.table)
+			{
+				if ((range.descriptorType == DescriptorType::Sampler) != isSamplerTable)
+				{
+					LogError(LogNullDevice) << "Root signature " << rootSignatureDesc.name << ": root parameter " << i << " mixes samplers with other descriptors" << endl;
+					break;
+				}
+			}
+		}
+	}
+
+	auto rootSignature = std::make_shared<RootSignature>();
+	rootSignature->m_desc = rootSignatureDesc;
+	rootSignature->m_device = this;
+	rootSignature->m_rootParameterBitmap = numRootParameters >= 32 ? ~0u : ((1u << numRootParameters) - 1);
+
+	++m_numRootSignatures;
+
+	return rootSignature;
+}
+
+
+Luna::GraphicsPipelinePtr Device::CreateGraphicsPipeline(const GraphicsPipelineDesc& pipelineDesc)
+{
+	auto graphicsPipeline = std::make_shared<GraphicsPipeline>();
+	graphicsPipeline->m_desc = pipelineDesc;
+	graphicsPipeline->m_rootSignature = pipelineDesc.rootSignature;
+
+	++m_numPipelines;
+
+	return graphicsPipeline;
+}
+
+
+Luna::ComputePipelinePtr Device::CreateComputePipeline(const ComputePipelineDesc& pipelineDesc)
+{
+	auto computePipeline = std::make_shared<ComputePipeline>();
+	computePipeline->m_desc = pipelineDesc;
+	computePipeline->m_rootSignature = pipelineDesc.rootSignature;
+
+	++m_numPipelines;
+
+	return computePipeline;
+}
+
+
+Luna::MeshletPipelinePtr Device::CreateMeshletPipeline(const MeshletPipelineDesc& pipelineDesc)
+{
+	auto meshletPipeline = std::make_shared<MeshletPipeline>();
+	meshletPipeline->m_desc = pipelineDesc;
+	meshletPipeline->m_rootSignature = pipelineDesc.rootSignature;
+
+	++m_numPipelines;
+
+	return meshletPipeline;
+}
+
+
+Luna::QueryHeapPtr Device::CreateQueryHeap(const QueryHeapDesc& queryHeapDesc)
+{
+	auto queryHeap = make_shared<QueryHeap>();
+	queryHeap->m_desc = queryHeapDesc;
+
+	++m_numQueryHeaps;
+
+	return queryHeap;
+}
+
+
+Luna::SamplerPtr Device::CreateSampler(const SamplerDesc& samplerDesc)
+{
+	shared_ptr<Sampler> sampler;
+
+	const size_t hashValue = Utility::HashState(&samplerDesc);
+
+	std::lock_guard lock(m_samplerMutex);
+
+	auto iter = m_samplerMap.find(hashValue);
+	if (iter != m_samplerMap.end())
+	{
+		sampler = iter->second;
+	}
+	else
+	{
+		sampler = make_shared<Sampler>();
+		sampler->m_desc = samplerDesc;
+		sampler->m_samplerDescriptor.Create(sampler.get(), DescriptorRegisterType::Sampler);
+
+		m_samplerMap[hashValue] = sampler;
+	}
+
+	return sampler;
+}
+
+
+TexturePtr Device::CreateTexture1D(const TextureDesc& textureDesc)
+{
+	return CreateTextureSimple(TextureDimension::Texture1D, textureDesc);
+}
+
+
+TexturePtr Device::CreateTexture2D(const TextureDesc& textureDesc)
+{
+	return CreateTextureSimple(TextureDimension::Texture2D, textureDesc);
+}
+
+
+TexturePtr Device::CreateTexture3D(const TextureDesc& textureDesc)
+{
+	return CreateTextureSimple(TextureDimension::Texture3D, textureDesc);
+}
+
+
+ITexture* Device::CreateUninitializedTexture(const std::string& name, const std::string& mapKey)
+{
+	Texture* tex = new Texture();
+	tex->m_name = name;
+	tex->m_mapKey = mapKey;
+	return tex;
+}
+
+
+bool Device::InitializeTexture(ITexture* texture, const TextureInitializer& texInit)
+{
+	Texture* textureNull = (Texture*)texture;
+	assert(textureNull != nullptr);
+
+	const ResourceType type = TextureDimensionToResourceType(texInit.dimension);
+	const bool isCubemap = HasAnyFlag(type, ResourceType::TextureCube_Type);
+	uint32_t effectiveArraySize = isCubemap ? texInit.arraySizeOrDepth / 6 : texInit.arraySizeOrDepth;
+
+	if (type == ResourceType::Unknown)
+	{
+		LogError(LogNullDevice) << "Texture " << textureNull->m_name << " has an unknown dimension" << endl;
+		return false;
+	}
+
+	textureNull->m_type = type;
+	textureNull->m_usageState = ResourceState::CopyDest;
+	textureNull->m_width = texInit.width;
+	textureNull->m_height = texInit.height;
+	textureNull->m_arraySizeOrDepth = effectiveArraySize;
+	textureNull->m_numMips = texInit.numMips;
+	textureNull->m_numSamples = 1;
+	textureNull->m_planeCount = 1;
+	textureNull->m_format = texInit.format;
+	textureNull->m_dimension = texInit.dimension;
+
+	// Copy initial data
+	TexturePtr temp = texture;
+	CommandContext::InitializeTexture(temp, texInit);
+
+	textureNull->m_srvDescriptor.Create(textureNull, DescriptorRegisterType::SRV);
+	textureNull->m_isInitialized = true;
+
+	++m_numTextures;
+	m_textureBytes += texInit.totalBytes;
+
+	return true;
+}
+
+
+ColorBufferPtr Device::CreateSwapChainBuffer(const std::string& name, uint32_t width, uint32_t height, Format format)
+{
+	ColorBufferDesc colorBufferDesc{
+		.name				= name,
+		.resourceType		= ResourceType::Texture2D,
+		.width				= width,
+		.height				= height,
+		.format				= format
+	};
+
+	auto colorBuffer = CreateColorBuffer(colorBufferDesc);
+	colorBuffer->SetUsageState(ResourceState::Present);
+
+	return colorBuffer;
+}
+
+
+void Device::ResizeSwapChainBuffer(IColorBuffer* colorBuffer, uint32_t width, uint32_t height)
+{
+	ColorBuffer* colorBufferNull = (ColorBuffer*)colorBuffer;
+	assert(colorBufferNull != nullptr);
+
+	colorBufferNull->m_width = width;
+	colorBufferNull->m_height = height;
+	colorBufferNull->m_usageState = ResourceState::Present;
+}
+
+
+ResourceStats Device::GetResourceStats() const
+{
+	ResourceStats stats{
+		.numColorBuffers	= m_numColorBuffers,
+		.numDepthBuffers	= m_numDepthBuffers,
+		.numGpuBuffers		= m_numGpuBuffers,
+		.gpuBufferBytes		= m_gpuBufferBytes,
+		.numTextures		= m_numTextures,
+		.textureBytes		= m_textureBytes,
+		.numRootSignatures	= m_numRootSignatures,
+		.numPipelines		= m_numPipelines,
+		.numQueryHeaps		= m_numQueryHeaps
+	};
+
+	{
+		std::lock_guard lock(m_samplerMutex);
+		stats.numSamplers = m_samplerMap.size();
+	}
+
+	return stats;
+}
+
+
+void Device::FillCaps()
+{
+	m_caps.adapterInfo.name = "Null Device";
+	m_caps.adapterInfo.adapterType = AdapterType::Software;
+	m_caps.api = GraphicsApi::Null;
+	m_caps.shaderModel = 66;
+
+	m_caps.viewport.maxNum = 16;
+	m_caps.viewport.boundsMin = -32768;
+	m_caps.viewport.boundsMax = 32767;
+
+	m_caps.dimensions.typedBufferMaxDim = 1 << 27;
+	m_caps.dimensions.attachmentMaxDim = 16384;
+	m_caps.dimensions.attachmentLayerMaxNum = 2048;
+	m_caps.dimensions.texture1DMaxDim = 16384;
+	m_caps.dimensions.texture2DMaxDim = 16384;
+	m_caps.dimensions.texture3DMaxDim = 2048;
+	m_caps.dimensions.textureCubeMaxDim = 16384;
+	m_caps.dimensions.textureLayerMaxNum = 2048;
+
+	m_caps.memory.allocationMaxNum = 0xFFFFFFFF;
+	m_caps.memory.samplerAllocationMaxNum = 2048;
+	m_caps.memory.constantBufferMaxRange = 64 * 1024;
+	m_caps.memory.storageBufferMaxRange = 1 << 27;
+	m_caps.memory.bufferMaxSize = 2048ull * 1024ull * 1024ull;
+
+	m_caps.memoryAlignment.uploadBufferTextureRow = 256;
+	m_caps.memoryAlignment.uploadBufferTextureSlice = 512;
+	m_caps.memoryAlignment.bufferShaderResourceOffset = 16;
+	m_caps.memoryAlignment.constantBufferOffset = 256;
+
+	m_caps.pipelineLayout.descriptorSetMaxNum = MaxRootParameters;
+	m_caps.pipelineLayout.rootConstantMaxSize = 256;
+	m_caps.pipelineLayout.rootDescriptorMaxNum = MaxRootParameters;
+
+	// No timestamps, so the GPU profiler stays idle
+	m_caps.other.timestampFrequencyHz = 0;
+
+	// Report mesh shader support so the meshlet samples record their full workload
+	m_caps.features.swapChain = 1;
+	m_caps.features.meshShader = 1;
+}
+
+
+TexturePtr Device::CreateTextureSimple(TextureDimension dimension, const TextureDesc& textureDesc)
+{
+	const size_t height = dimension == TextureDimension::Texture1D ? 1 : textureDesc.height;
+	const size_t depth = dimension == TextureDimension::Texture3D ? textureDesc.depth : 1;
+
+	assert(textureDesc.dataSize != 0);
+	assert(textureDesc.data != nullptr);
+
+	TextureInitializer texInit{
+		.format				= textureDesc.format,
+		.dimension			= dimension,
+		.width				= textureDesc.width,
+		.height				= (uint32_t)height,
+		.arraySizeOrDepth	= (uint32_t)depth,
+		.numMips			= textureDesc.numMips
+	};
+	texInit.subResourceData.push_back(TextureSubresourceData{});
+
+	size_t skipMip = 0;
+	FillTextureInitializer(
+		textureDesc.width,
+		height,
+		depth,
+		textureDesc.numMips,
+		1, // arraySize
+		textureDesc.format,
+		0, // maxSize
+		textureDesc.dataSize,
+		textureDesc.data,
+		skipMip,
+		texInit);
+
+	TexturePtr texture = CreateUninitializedTexture(textureDesc.name, textureDesc.name);
+	InitializeTexture(texture.Get(), texInit);
+
+	return texture;
+}
+
+
+Device* GetNullDevice()
+{
+	assert(g_nullDevice != nullptr);
+
+	return g_nullDevice;
+}
+
+} // namespace Luna::Null
@@ -0,0 +1,110 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\Device.h"
+#include "Graphics\DeviceCaps.h"
+#include "Graphics\PipelineCache.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Sampler;
+
+
+inline LogCategory LogNullDevice{ "LogNullDevice" };
+
+
+// Number of objects created over the lifetime of the device
+struct ResourceStats
+{
+	uint64_t numColorBuffers{ 0 };
+	uint64_t numDepthBuffers{ 0 };
+	uint64_t numGpuBuffers{ 0 };
+	uint64_t gpuBufferBytes{ 0 };
+	uint64_t numTextures{ 0 };
+	uint64_t textureBytes{ 0 };
+	uint64_t numRootSignatures{ 0 };
+	uint64_t numPipelines{ 0 };
+	uint64_t numSamplers{ 0 };
+	uint64_t numQueryHeaps{ 0 };
+};
+
+
+// Creates resource objects with the same descs, initial states and descriptors as the GPU backends, but
+// without any GPU memory behind them.  Buffers keep a system memory copy of their contents.
+class Device : public IDevice
+{
+public:
+	Device();
+	~Device();
+
+	const DeviceCaps& GetDeviceCaps() const override { return m_caps; }
+
+	ColorBufferPtr CreateColorBuffer(const ColorBufferDesc& colorBufferDesc) override;
+	DepthBufferPtr CreateDepthBuffer(const DepthBufferDesc& depthBufferDesc) override;
+	GpuBufferPtr CreateGpuBuffer(const GpuBufferDesc& gpuBufferDesc) override;
+
+	RootSignaturePtr CreateRootSignature(const RootSignatureDesc& rootSignatureDesc) override;
+
+	GraphicsPipelinePtr CreateGraphicsPipeline(const GraphicsPipelineDesc& pipelineDesc) override;
+	ComputePipelinePtr CreateComputePipeline(const ComputePipelineDesc& pipelineDesc) override;
+	MeshletPipelinePtr CreateMeshletPipeline(const MeshletPipelineDesc& pipelineDesc) override;
+
+	// There is nothing to cache
+	PipelineCacheStats GetPipelineCacheStats() const override { return PipelineCacheStats{}; }
+
+	QueryHeapPtr CreateQueryHeap(const QueryHeapDesc& queryHeapDesc) override;
+
+	SamplerPtr CreateSampler(const SamplerDesc& samplerDesc) override;
+
+	TexturePtr CreateTexture1D(const TextureDesc& textureDesc) override;
+	TexturePtr CreateTexture2D(const TextureDesc& textureDesc) override;
+	TexturePtr CreateTexture3D(const TextureDesc& textureDesc) override;
+
+	ITexture* CreateUninitializedTexture(const std::string& name, const std::string& mapKey) override;
+	bool InitializeTexture(ITexture* texture, const TextureInitializer& texInit) override;
+
+	// Swap chain images, which start out in the Present state
+	ColorBufferPtr CreateSwapChainBuffer(const std::string& name, uint32_t width, uint32_t height, Format format);
+	void ResizeSwapChainBuffer(IColorBuffer* colorBuffer, uint32_t width, uint32_t height);
+
+	ResourceStats GetResourceStats() const;
+
+protected:
+	void FillCaps();
+	TexturePtr CreateTextureSimple(TextureDimension dimension, const TextureDesc& textureDesc);
+
+protected:
+	DeviceCaps m_caps{};
+
+	// Sampler cache
+	mutable std::mutex m_samplerMutex;
+	std::map<size_t, std::shared_ptr<Sampler>> m_samplerMap;
+
+	// Resource stats
+	std::atomic<uint64_t> m_numColorBuffers{ 0 };
+	std::atomic<uint64_t> m_numDepthBuffers{ 0 };
+	std::atomic<uint64_t> m_numGpuBuffers{ 0 };
+	std::atomic<uint64_t> m_gpuBufferBytes{ 0 };
+	std::atomic<uint64_t> m_numTextures{ 0 };
+	std::atomic<uint64_t> m_textureBytes{ 0 };
+	std::atomic<uint64_t> m_numRootSignatures{ 0 };
+	std::atomic<uint64_t> m_numPipelines{ 0 };
+	std::atomic<uint64_t> m_numQueryHeaps{ 0 };
+};
+
+
+Device* GetNullDevice();
+
+} // namespace Luna::Null
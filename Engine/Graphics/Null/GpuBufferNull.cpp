@@ -0,0 +1,57 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "GpuBufferNull.h"
+
+#include "DeviceManagerNull.h"
+
+using namespace std;
+
+
+namespace Luna::Null
+{
+
+void GpuBuffer::Update(size_t sizeInBytes, const void* data)
+{
+	Update(sizeInBytes, 0, data);
+}
+
+
+void GpuBuffer::Update(size_t sizeInBytes, size_t offset, const void* data)
+{
+	if (!m_isCpuWriteable)
+	{
+		GetNullDeviceManager()->ReportValidationError("GpuBuffer::Update called on a buffer without CPU write access");
+		return;
+	}
+
+	if ((sizeInBytes + offset) > m_data.size())
+	{
+		GetNullDeviceManager()->ReportValidationError(format("GpuBuffer::Update writes {} bytes at offset {}, past the end of a {} byte buffer",
+			sizeInBytes, offset, m_data.size()));
+		return;
+	}
+
+	memcpy(m_data.data() + offset, data, sizeInBytes);
+}
+
+
+void* GpuBuffer::Map()
+{
+	return m_data.data();
+}
+
+
+void GpuBuffer::Unmap()
+{}
+
+} // namespace Luna::Null
@@ -0,0 +1,54 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\GpuBuffer.h"
+#include "Graphics\Null\DescriptorNull.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+// The buffer contents live in system memory, so Map(), Update() and initial data behave as they do on a GPU,
+// and readback buffers return whatever was last written to them.
+class GpuBuffer : public IGpuBuffer
+{
+	friend class Device;
+
+public:
+	void Update(size_t sizeInBytes, const void* data) override;
+	void Update(size_t sizeInBytes, size_t offset, const void* data) override;
+
+	void* Map() override;
+	void Unmap() override;
+
+	const IDescriptor* GetSrvDescriptor() const noexcept override { return &m_srvDescriptor; }
+	const IDescriptor* GetUavDescriptor() const noexcept override { return &m_uavDescriptor; }
+	const IDescriptor* GetCbvDescriptor() const noexcept override { return &m_cbvDescriptor; }
+
+	std::byte* GetData() noexcept { return m_data.data(); }
+	bool IsCpuWriteable() const noexcept { return m_isCpuWriteable; }
+
+protected:
+	std::vector<std::byte> m_data;
+
+	Descriptor m_srvDescriptor{};
+	Descriptor m_uavDescriptor{};
+	Descriptor m_cbvDescriptor{};
+
+	bool m_isCpuWriteable{ false };
+};
+
+} // namespace Luna::Null
@@ -0,0 +1,50 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\PipelineState.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+// Shaders are not loaded, so pipelines are just their descs
+class GraphicsPipeline : public IGraphicsPipeline
+{
+	friend class Device;
+
+public:
+	const GraphicsPipelineDesc& GetDesc() const noexcept { return m_desc; }
+};
+
+
+class ComputePipeline : public IComputePipeline
+{
+	friend class Device;
+
+public:
+	const ComputePipelineDesc& GetDesc() const noexcept { return m_desc; }
+};
+
+
+class MeshletPipeline : public IMeshletPipeline
+{
+	friend class Device;
+
+public:
+	const MeshletPipelineDesc& GetDesc() const noexcept { return m_desc; }
+};
+
+} // namespace Luna::Null
@@ -0,0 +1,28 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\QueryHeap.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declaration
+class Device;
+
+
+class QueryHeap : public IQueryHeap
+{
+	friend class Device;
+};
+
+} // namespace Luna::Null
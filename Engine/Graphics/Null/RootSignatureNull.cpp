@@ -0,0 +1,31 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "RootSignatureNull.h"
+
+#include "DescriptorSetNull.h"
+
+
+namespace Luna::Null
+{
+
+Luna::DescriptorSetPtr RootSignature::CreateDescriptorSet(uint32_t rootParamIndex) const
+{
+	const auto& rootParam = GetRootParameter(rootParamIndex);
+
+	// Root constants are set directly on the context
+	assert(rootParam.parameterType != RootParameterType::RootConstants);
+
+	return std::make_shared<DescriptorSet>(rootParam);
+}
+
+} // namespace Luna::Null
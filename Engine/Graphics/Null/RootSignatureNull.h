@@ -0,0 +1,39 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\RootSignature.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+class RootSignature : public IRootSignature
+{
+	friend class Device;
+
+public:
+	Luna::DescriptorSetPtr CreateDescriptorSet(uint32_t rootParamIndex) const override;
+
+	// One bit per root parameter.  Every parameter must be set before a draw or dispatch.
+	uint32_t GetRootParameterBitmap() const noexcept { return m_rootParameterBitmap; }
+
+protected:
+	Device* m_device{ nullptr };
+
+	uint32_t m_rootParameterBitmap{ 0 };
+};
+
+} // namespace Luna::Null
@@ -0,0 +1,38 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\Sampler.h"
+#include "Graphics\Null\DescriptorNull.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+class Sampler : public ISampler
+{
+	friend class Device;
+
+public:
+	const IDescriptor* GetDescriptor() const noexcept override { return &m_samplerDescriptor; }
+
+	const SamplerDesc& GetDesc() const noexcept { return m_desc; }
+
+protected:
+	Descriptor m_samplerDescriptor;
+	SamplerDesc m_desc{};
+};
+
+} // namespace Luna::Null
@@ -0,0 +1,39 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\Texture.h"
+#include "Graphics\Null\DescriptorNull.h"
+
+
+namespace Luna::Null
+{
+
+// Forward declarations
+class Device;
+
+
+class Texture : public ITexture
+{
+	friend class Device;
+
+public:
+	bool IsValid() const noexcept override { return m_isInitialized; }
+
+	const IDescriptor* GetDescriptor() const override { return &m_srvDescriptor; }
+
+protected:
+	Descriptor m_srvDescriptor;
+	std::string m_name;
+	bool m_isInitialized{ false };
+};
+
+} // namespace Luna::Null
@@ -0,0 +1,621 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "OcclusionCuller.h"
+
+#include "Core/CpuFeatures.h"
+#include "Core/Math/BatchKernels.h"
+
+#include <bit>
+#include <immintrin.h>
+#include <limits>
+
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+constexpr int32_t s_tileSize = 8;
+constexpr int32_t s_binWidth = 64;
+constexpr int32_t s_binHeight = 32;
+
+constexpr float s_clearDepth = numeric_limits<float>::max();
+
+
+bool UseAVX(BatchPath path) noexcept
+{
+	return (path == BatchPath::AVX || path == BatchPath::Best) && Luna::HasAVX();
+}
+
+
+uint32_t RoundUpToTile(uint32_t size) noexcept
+{
+	return max(1u, (size + s_tileSize - 1) / s_tileSize) * s_tileSize;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+OcclusionCullerStats& OcclusionCullerStats::operator+=(const OcclusionCullerStats& other) noexcept
+{
+	numOccluders += other.numOccluders;
+	numOccluderTriangles += other.numOccluderTriangles;
+	numRasterizedTriangles += other.numRasterizedTriangles;
+	numOccludeesTested += other.numOccludeesTested;
+	numOccludeesVisible += other.numOccludeesVisible;
+
+	return *this;
+}
+
+
+OcclusionCuller::OcclusionCuller(const OcclusionCullerDesc& desc)
+	: m_desc{ desc }
+	, m_width{ RoundUpToTile(desc.width) }
+	, m_height{ RoundUpToTile(desc.height) }
+	, m_numTilesX{ m_width / s_tileSize }
+	, m_numTilesY{ m_height / s_tileSize }
+	, m_numBinsX{ (m_width + s_binWidth - 1) / s_binWidth }
+	, m_numBinsY{ (m_height + s_binHeight - 1) / s_binHeight }
+{
+	m_depthBuffer.resize((size_t)m_width * m_height, s_clearDepth);
+	m_tileMaxDepth.resize((size_t)m_numTilesX * m_numTilesY, s_clearDepth);
+	m_binTriangles.resize((size_t)m_numBinsX * m_numBinsY);
+}
+
+
+void OcclusionCuller::BeginFrame(const float* viewProjectionMatrix)
+{
+	memcpy(m_viewProjectionMatrix, viewProjectionMatrix, sizeof(m_viewProjectionMatrix));
+
+	fill(m_depthBuffer.begin(), m_depthBuffer.end(), s_clearDepth);
+	fill(m_tileMaxDepth.begin(), m_tileMaxDepth.end(), s_clearDepth);
+
+	m_triangles.clear();
+	for (auto& binTriangles : m_binTriangles)
+	{
+		binTriangles.clear();
+	}
+
+	m_stats = OcclusionCullerStats{};
+}
+
+
+void OcclusionCuller::AddOccluder(const float* localToWorld, span<const float> positions, uint32_t positionStride, span<const uint32_t> indices)
+{
+	assert(positionStride >= 3);
+	assert(indices.size() % 3 == 0);
+
+	float localToClip[16];
+	MultiplyMatrices(m_viewProjectionMatrix, localToWorld, localToClip, 1, m_desc.path);
+
+	const size_t numVertices = positions.size() / positionStride;
+
+	// The positions are transformed in place, as points of four floats
+	static_assert(sizeof(ClipVertex) == 4 * sizeof(float));
+	m_clipVertices.resize(numVertices);
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const float* position = &positions[i * positionStride];
+		m_clipVertices[i] = ClipVertex{ position[0], position[1], position[2], 1.0f };
+	}
+	TransformPoints(localToClip, &m_clipVertices[0].x, &m_clipVertices[0].x, numVertices, m_desc.path);
+
+	++m_stats.numOccluders;
+	m_stats.numOccluderTriangles += indices.size() / 3;
+
+	// Signed distance to the near plane, which is at z = 0, or at z = w with reverse Z
+	const bool reverseZ = m_desc.reverseZ;
+	auto NearDistance = [reverseZ](const ClipVertex& v) { return reverseZ ? v.w - v.z : v.z; };
+
+	for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+	{
+		assert(indices[i] < numVertices && indices[i + 1] < numVertices && indices[i + 2] < numVertices);
+
+		const ClipVertex triangle[3] = { m_clipVertices[indices[i]], m_clipVertices[indices[i + 1]], m_clipVertices[indices[i + 2]] };
+		const float distances[3] = { NearDistance(triangle[0]), NearDistance(triangle[1]), NearDistance(triangle[2]) };
+
+		if (distances[0] >= 0.0f && distances[1] >= 0.0f && distances[2] >= 0.0f)
+		{
+			SetupTriangle(triangle[0], triangle[1], triangle[2]);
+			continue;
+		}
+
+		if (distances[0] < 0.0f && distances[1] < 0.0f && distances[2] < 0.0f)
+		{
+			continue;
+		}
+
+		// Clip against the near plane, which leaves a triangle or a quad with the same winding
+		ClipVertex polygon[4];
+		uint32_t numPolygonVertices = 0;
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			const uint32_t k = (j + 1) % 3;
+			const ClipVertex& a = triangle[j];
+			const ClipVertex& b = triangle[k];
+
+			if (distances[j] >= 0.0f)
+			{
+				polygon[numPolygonVertices++] = a;
+			}
+
+			if ((distances[j] >= 0.0f) != (distances[k] >= 0.0f))
+			{
+				const float t = distances[j] / (distances[j] - distances[k]);
+				polygon[numPolygonVertices++] = ClipVertex{ a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), a.z + t * (b.z - a.z), a.w + t * (b.w - a.w) };
+			}
+		}
+
+		for (uint32_t j = 2; j < numPolygonVertices; ++j)
+		{
+			SetupTriangle(polygon[0], polygon[j - 1], polygon[j]);
+		}
+	}
+}
+
+
+void OcclusionCuller::RasterizeOccluders()
+{
+	ScopedEvent event("OcclusionCuller::RasterizeOccluders");
+
+	// Bin the triangles by the screen regions their bounds touch
+	for (uint32_t i = 0; i < (uint32_t)m_triangles.size(); ++i)
+	{
+		const Triangle& triangle = m_triangles[i];
+
+		for (int32_t binY = triangle.minY / s_binHeight; binY <= triangle.maxY / s_binHeight; ++binY)
+		{
+			for (int32_t binX = triangle.minX / s_binWidth; binX <= triangle.maxX / s_binWidth; ++binX)
+			{
+				m_binTriangles[binY * m_numBinsX + binX].push_back(i);
+			}
+		}
+	}
+
+	// Bins cover separate pixels and tiles, so they need no synchronization.  Depth is resolved with min(), so the
+	// result doesn't depend on which thread rasterizes what.
+	ParallelFor(m_numBinsX * m_numBinsY, [this](uint32_t binIndex) { RasterizeBin(binIndex); });
+}
+
+
+void OcclusionCuller::CullBoundingBoxes(const BoundingBoxSoA& boxes, span<uint64_t> inOutVisibleMask)
+{
+	ScopedEvent event("OcclusionCuller::CullBoundingBoxes");
+
+	const size_t numBoxes = boxes.GetCount();
+	const uint32_t numWords = (uint32_t)((numBoxes + 63) / 64);
+	assert(inOutVisibleMask.size() >= numWords);
+
+	auto GetValidBits = [numBoxes](uint32_t wordIndex)
+	{
+		const size_t numBits = min<size_t>(64, numBoxes - (size_t)wordIndex * 64);
+		return numBits == 64 ? ~0ull : (1ull << numBits) - 1;
+	};
+
+	for (uint32_t i = 0; i < numWords; ++i)
+	{
+		m_stats.numOccludeesTested += popcount(inOutVisibleMask[i] & GetValidBits(i));
+	}
+
+	// Each job owns whole words of the mask
+	ParallelFor(numWords, [&](uint32_t wordIndex)
+		{
+			const uint64_t validBits = GetValidBits(wordIndex);
+
+			uint64_t bits = inOutVisibleMask[wordIndex] & validBits;
+			uint64_t visibleBits = bits;
+			while (bits != 0)
+			{
+				const uint32_t bit = (uint32_t)countr_zero(bits);
+				bits &= bits - 1;
+
+				const size_t i = (size_t)wordIndex * 64 + bit;
+				const float boxMin[3] = { boxes.minX[i], boxes.minY[i], boxes.minZ[i] };
+				const float boxMax[3] = { boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i] };
+
+				if (!TestBox(boxMin, boxMax))
+				{
+					visibleBits &= ~(1ull << bit);
+				}
+			}
+
+			inOutVisibleMask[wordIndex] = (inOutVisibleMask[wordIndex] & ~validBits) | visibleBits;
+		});
+
+	for (uint32_t i = 0; i < numWords; ++i)
+	{
+		m_stats.numOccludeesVisible += popcount(inOutVisibleMask[i] & GetValidBits(i));
+	}
+}
+
+
+bool OcclusionCuller::IsVisible(const float boxMin[3], const float boxMax[3]) const noexcept
+{
+	return TestBox(boxMin, boxMax);
+}
+
+
+OcclusionCullerStats OcclusionCuller::GetStats() const noexcept
+{
+	OcclusionCullerStats stats = m_stats;
+	stats.numRasterizedTriangles = m_triangles.size();
+	return stats;
+}
+
+
+void OcclusionCuller::SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+	// Set up in double precision, so that triangles spanning the guard band keep their shape.  Only the
+	// coefficients are rounded to float, and they're relative to a pixel in the triangle's bounds.
+	const double width = (double)m_width;
+	const double height = (double)m_height;
+	const double depthSign = m_desc.reverseZ ? -1.0 : 1.0;
+
+	double x[3], y[3], depth[3];
+	const ClipVertex* vertices[3] = { &v0, &v1, &v2 };
+	for (int i = 0; i < 3; ++i)
+	{
+		const double invW = 1.0 / (double)vertices[i]->w;
+		x[i] = ((double)vertices[i]->x * invW * 0.5 + 0.5) * width;
+		y[i] = (0.5 - (double)vertices[i]->y * invW * 0.5) * height;
+		depth[i] = depthSign * (double)vertices[i]->z * invW;
+	}
+
+	// Positive when counterclockwise on the screen, which is clockwise with Y up
+	double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area == 0.0 || !isfinite(area))
+	{
+		return;
+	}
+
+	const bool isFrontFace = m_desc.frontCounterClockwise ? area < 0.0 : area > 0.0;
+	if ((m_desc.cullMode == CullMode::Back && !isFrontFace) || (m_desc.cullMode == CullMode::Front && isFrontFace))
+	{
+		return;
+	}
+
+	// Swap to make the edge functions positive inside
+	if (area < 0.0)
+	{
+		swap(x[1], x[2]);
+		swap(y[1], y[2]);
+		swap(depth[1], depth[2]);
+		area = -area;
+	}
+
+	// Pixels whose centers fall in the triangle's bounds
+	const double minX = max(ceil(min({ x[0], x[1], x[2] }) - 0.5), 0.0);
+	const double minY = max(ceil(min({ y[0], y[1], y[2] }) - 0.5), 0.0);
+	const double maxX = min(floor(max({ x[0], x[1], x[2] }) - 0.5), width - 1.0);
+	const double maxY = min(floor(max({ y[0], y[1], y[2] }) - 0.5), height - 1.0);
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	const double originX = minX + 0.5;
+	const double originY = minY + 0.5;
+
+	Triangle triangle{};
+	for (int i = 0; i < 3; ++i)
+	{
+		const int a = (i + 1) % 3;
+		const int b = (i + 2) % 3;
+
+		// Edge from vertex a to vertex b, opposite vertex i
+		const double edgeA = y[a] - y[b];
+		const double edgeB = x[b] - x[a];
+		triangle.edgeA[i] = (float)edgeA;
+		triangle.edgeB[i] = (float)edgeB;
+		triangle.edgeC[i] = (float)(edgeA * (originX - x[a]) + edgeB * (originY - y[a]));
+	}
+
+	const double depthA = ((depth[1] - depth[0]) * (y[2] - y[0]) - (depth[2] - depth[0]) * (y[1] - y[0])) / area;
+	const double depthB = ((depth[2] - depth[0]) * (x[1] - x[0]) - (depth[1] - depth[0]) * (x[2] - x[0])) / area;
+	triangle.depthA = (float)depthA;
+	triangle.depthB = (float)depthB;
+	triangle.depthC = (float)(depth[0] + depthA * (originX - x[0]) + depthB * (originY - y[0]));
+
+	triangle.minX = (int32_t)minX;
+	triangle.minY = (int32_t)minY;
+	triangle.maxX = (int32_t)maxX;
+	triangle.maxY = (int32_t)maxY;
+
+	m_triangles.push_back(triangle);
+}
+
+
+void OcclusionCuller::RasterizeBin(uint32_t binIndex)
+{
+	const int32_t binX0 = (int32_t)(binIndex % m_numBinsX) * s_binWidth;
+	const int32_t binY0 = (int32_t)(binIndex / m_numBinsX) * s_binHeight;
+	const int32_t binX1 = min(binX0 + s_binWidth, (int32_t)m_width) - 1;
+	const int32_t binY1 = min(binY0 + s_binHeight, (int32_t)m_height) - 1;
+
+	for (uint32_t triangleIndex : m_binTriangles[binIndex])
+	{
+		const Triangle& triangle = m_triangles[triangleIndex];
+
+		const int32_t x0 = max(triangle.minX, binX0);
+		const int32_t y0 = max(triangle.minY, binY0);
+		const int32_t x1 = min(triangle.maxX, binX1);
+		const int32_t y1 = min(triangle.maxY, binY1);
+
+		if (UseAVX(m_desc.path))
+		{
+			RasterizeTriangleAVX(triangle, x0, y0, x1, y1);
+		}
+		else if (m_desc.path != BatchPath::Scalar)
+		{
+			RasterizeTriangleSSE(triangle, x0, y0, x1, y1);
+		}
+		else
+		{
+			RasterizeTriangleScalar(triangle, x0, y0, x1, y1);
+		}
+	}
+
+	// Farthest depth of each tile, for the box tests
+	for (int32_t tileY = binY0 / s_tileSize; tileY <= binY1 / s_tileSize; ++tileY)
+	{
+		for (int32_t tileX = binX0 / s_tileSize; tileX <= binX1 / s_tileSize; ++tileX)
+		{
+			float maxDepth = -numeric_limits<float>::max();
+			for (int32_t y = tileY * s_tileSize; y < (tileY + 1) * s_tileSize; ++y)
+			{
+				const float* row = &m_depthBuffer[(size_t)y * m_width + tileX * s_tileSize];
+				for (int32_t x = 0; x < s_tileSize; ++x)
+				{
+					maxDepth = max(maxDepth, row[x]);
+				}
+			}
+			m_tileMaxDepth[tileY * m_numTilesX + tileX] = maxDepth;
+		}
+	}
+}
+
+
+// Every kernel evaluates, per pixel at offset (fx, fy) from the triangle's origin pixel,
+//   edge = edgeA * fx + (edgeB * fy + edgeC),  depth = depthA * fx + (depthB * fy + depthC)
+// with the row terms computed once as scalars, so all of them write the same depths.  Pixels on an edge count
+// as covered.
+
+LUNA_TARGET_AVX void OcclusionCuller::RasterizeTriangleAVX(const Triangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+	const __m256 laneOffsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 clearDepth = _mm256_set1_ps(s_clearDepth);
+
+	const __m256 edgeA0 = _mm256_set1_ps(triangle.edgeA[0]);
+	const __m256 edgeA1 = _mm256_set1_ps(triangle.edgeA[1]);
+	const __m256 edgeA2 = _mm256_set1_ps(triangle.edgeA[2]);
+	const __m256 depthA = _mm256_set1_ps(triangle.depthA);
+
+	// Lanes outside [x0, x1] are masked off by their offsets from the origin
+	const __m256 minOffsetX = _mm256_set1_ps((float)(x0 - triangle.minX));
+	const __m256 maxOffsetX = _mm256_set1_ps((float)(x1 - triangle.minX));
+	const int32_t spanX0 = x0 & ~7;
+
+	for (int32_t y = y0; y <= y1; ++y)
+	{
+		const float fy = (float)(y - triangle.minY);
+		const __m256 rowEdge0 = _mm256_set1_ps(triangle.edgeB[0] * fy + triangle.edgeC[0]);
+		const __m256 rowEdge1 = _mm256_set1_ps(triangle.edgeB[1] * fy + triangle.edgeC[1]);
+		const __m256 rowEdge2 = _mm256_set1_ps(triangle.edgeB[2] * fy + triangle.edgeC[2]);
+		const __m256 rowDepth = _mm256_set1_ps(triangle.depthB * fy + triangle.depthC);
+
+		float* row = &m_depthBuffer[(size_t)y * m_width];
+
+		for (int32_t x = spanX0; x <= x1; x += 8)
+		{
+			const __m256 fx = _mm256_add_ps(_mm256_set1_ps((float)(x - triangle.minX)), laneOffsets);
+
+			__m256 covered = _mm256_and_ps(_mm256_cmp_ps(fx, minOffsetX, _CMP_GE_OQ), _mm256_cmp_ps(fx, maxOffsetX, _CMP_LE_OQ));
+			covered = _mm256_and_ps(covered, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA0, fx), rowEdge0), zero, _CMP_GE_OQ));
+			covered = _mm256_and_ps(covered, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA1, fx), rowEdge1), zero, _CMP_GE_OQ));
+			covered = _mm256_and_ps(covered, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA2, fx), rowEdge2), zero, _CMP_GE_OQ));
+
+			if (_mm256_movemask_ps(covered) == 0)
+			{
+				continue;
+			}
+
+			// Uncovered lanes get the clear depth, which min() leaves alone
+			const __m256 depth = _mm256_add_ps(_mm256_mul_ps(depthA, fx), rowDepth);
+			const __m256 coveredDepth = _mm256_or_ps(_mm256_and_ps(covered, depth), _mm256_andnot_ps(covered, clearDepth));
+			_mm256_storeu_ps(row + x, _mm256_min_ps(_mm256_loadu_ps(row + x), coveredDepth));
+		}
+	}
+
+	_mm256_zeroupper();
+}
+
+
+void OcclusionCuller::RasterizeTriangleSSE(const Triangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+	const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 clearDepth = _mm_set1_ps(s_clearDepth);
+
+	const __m128 edgeA0 = _mm_set1_ps(triangle.edgeA[0]);
+	const __m128 edgeA1 = _mm_set1_ps(triangle.edgeA[1]);
+	const __m128 edgeA2 = _mm_set1_ps(triangle.edgeA[2]);
+	const __m128 depthA = _mm_set1_ps(triangle.depthA);
+
+	const __m128 minOffsetX = _mm_set1_ps((float)(x0 - triangle.minX));
+	const __m128 maxOffsetX = _mm_set1_ps((float)(x1 - triangle.minX));
+	const int32_t spanX0 = x0 & ~3;
+
+	for (int32_t y = y0; y <= y1; ++y)
+	{
+		const float fy = (float)(y - triangle.minY);
+		const __m128 rowEdge0 = _mm_set1_ps(triangle.edgeB[0] * fy + triangle.edgeC[0]);
+		const __m128 rowEdge1 = _mm_set1_ps(triangle.edgeB[1] * fy + triangle.edgeC[1]);
+		const __m128 rowEdge2 = _mm_set1_ps(triangle.edgeB[2] * fy + triangle.edgeC[2]);
+		const __m128 rowDepth = _mm_set1_ps(triangle.depthB * fy + triangle.depthC);
+
+		float* row = &m_depthBuffer[(size_t)y * m_width];
+
+		for (int32_t x = spanX0; x <= x1; x += 4)
+		{
+			const __m128 fx = _mm_add_ps(_mm_set1_ps((float)(x - triangle.minX)), laneOffsets);
+
+			__m128 covered = _mm_and_ps(_mm_cmpge_ps(fx, minOffsetX), _mm_cmple_ps(fx, maxOffsetX));
+			covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, fx), rowEdge0), zero));
+			covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, fx), rowEdge1), zero));
+			covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, fx), rowEdge2), zero));
+
+			if (_mm_movemask_ps(covered) == 0)
+			{
+				continue;
+			}
+
+			const __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, fx), rowDepth);
+			const __m128 coveredDepth = _mm_or_ps(_mm_and_ps(covered, depth), _mm_andnot_ps(covered, clearDepth));
+			_mm_storeu_ps(row + x, _mm_min_ps(_mm_loadu_ps(row + x), coveredDepth));
+		}
+	}
+}
+
+
+void OcclusionCuller::RasterizeTriangleScalar(const Triangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+	for (int32_t y = y0; y <= y1; ++y)
+	{
+		const float fy = (float)(y - triangle.minY);
+		const float rowEdge0 = triangle.edgeB[0] * fy + triangle.edgeC[0];
+		const float rowEdge1 = triangle.edgeB[1] * fy + triangle.edgeC[1];
+		const float rowEdge2 = triangle.edgeB[2] * fy + triangle.edgeC[2];
+		const float rowDepth = triangle.depthB * fy + triangle.depthC;
+
+		float* row = &m_depthBuffer[(size_t)y * m_width];
+
+		for (int32_t x = x0; x <= x1; ++x)
+		{
+			const float fx = (float)(x - triangle.minX);
+
+			if (triangle.edgeA[0] * fx + rowEdge0 >= 0.0f && triangle.edgeA[1] * fx + rowEdge1 >= 0.0f && triangle.edgeA[2] * fx + rowEdge2 >= 0.0f)
+			{
+				row[x] = min(row[x], triangle.depthA * fx + rowDepth);
+			}
+		}
+	}
+}
+
+
+bool OcclusionCuller::TestBox(const float boxMin[3], const float boxMax[3]) const noexcept
+{
+	// Transform the min corner and the three edges once, and build the other corners from them
+	const float* m = m_viewProjectionMatrix;
+
+	float base[4], axisX[4], axisY[4], axisZ[4];
+	for (int c = 0; c < 4; ++c)
+	{
+		base[c] = ((m[12 + c] + boxMin[2] * m[8 + c]) + boxMin[1] * m[4 + c]) + boxMin[0] * m[c];
+		axisX[c] = (boxMax[0] - boxMin[0]) * m[c];
+		axisY[c] = (boxMax[1] - boxMin[1]) * m[4 + c];
+		axisZ[c] = (boxMax[2] - boxMin[2]) * m[8 + c];
+	}
+
+	const float depthSign = m_desc.reverseZ ? -1.0f : 1.0f;
+
+	float minX = numeric_limits<float>::max();
+	float minY = numeric_limits<float>::max();
+	float maxX = -numeric_limits<float>::max();
+	float maxY = -numeric_limits<float>::max();
+	float minDepth = numeric_limits<float>::max();
+
+	for (int i = 0; i < 8; ++i)
+	{
+		float corner[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			corner[c] = ((base[c] + ((i & 1) ? axisX[c] : 0.0f)) + ((i & 2) ? axisY[c] : 0.0f)) + ((i & 4) ? axisZ[c] : 0.0f);
+		}
+
+		const float z = corner[2];
+		const float w = corner[3];
+
+		// A box crossing the near plane covers the camera, or is about to
+		if ((m_desc.reverseZ ? w - z : z) < 0.0f)
+		{
+			return true;
+		}
+
+		const float invW = 1.0f / w;
+		const float x = (corner[0] * invW * 0.5f + 0.5f) * (float)m_width;
+		const float y = (0.5f - corner[1] * invW * 0.5f) * (float)m_height;
+
+		minX = min(minX, x);
+		minY = min(minY, y);
+		maxX = max(maxX, x);
+		maxY = max(maxY, y);
+		minDepth = min(minDepth, depthSign * z * invW);
+	}
+
+	// Every pixel the rectangle touches, clamped to the screen.  A box entirely off the screen can't be seen.
+	if (maxX < 0.0f || maxY < 0.0f || minX >= (float)m_width || minY >= (float)m_height)
+	{
+		return false;
+	}
+
+	const int32_t x0 = (int32_t)max(floorf(minX), 0.0f);
+	const int32_t y0 = (int32_t)max(floorf(minY), 0.0f);
+	const int32_t x1 = (int32_t)min(floorf(maxX), (float)m_width - 1.0f);
+	const int32_t y1 = (int32_t)min(floorf(maxY), (float)m_height - 1.0f);
+
+	// The box is visible if any pixel in the rectangle has an occluder at or behind its nearest depth
+	for (int32_t tileY = y0 / s_tileSize; tileY <= y1 / s_tileSize; ++tileY)
+	{
+		for (int32_t tileX = x0 / s_tileSize; tileX <= x1 / s_tileSize; ++tileX)
+		{
+			if (minDepth > m_tileMaxDepth[tileY * m_numTilesX + tileX])
+			{
+				continue;
+			}
+
+			const int32_t tileX0 = tileX * s_tileSize;
+			const int32_t tileY0 = tileY * s_tileSize;
+			const int32_t testX0 = max(x0, tileX0);
+			const int32_t testY0 = max(y0, tileY0);
+			const int32_t testX1 = min(x1, tileX0 + s_tileSize - 1);
+			const int32_t testY1 = min(y1, tileY0 + s_tileSize - 1);
+
+			// The tile's farthest pixel is in the rectangle
+			if (testX0 == tileX0 && testY0 == tileY0 && testX1 == tileX0 + s_tileSize - 1 && testY1 == tileY0 + s_tileSize - 1)
+			{
+				return true;
+			}
+
+			for (int32_t y = testY0; y <= testY1; ++y)
+			{
+				const float* row = &m_depthBuffer[(size_t)y * m_width];
+				for (int32_t x = testX0; x <= testX1; ++x)
+				{
+					if (row[x] >= minDepth)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+} // namespace Luna
@@ -0,0 +1,167 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/BitmaskEnum.h"
+#include "Core/Math/BatchTypes.h"
+#include "Graphics/Enums.h"
+
+
+namespace Luna
+{
+
+struct OcclusionCullerDesc
+{
+	// Resolution of the depth buffer, rounded up to whole 8x8 tiles.  Occluders only need to be coarse, so
+	// this is usually a fraction of the screen, with the same aspect ratio.
+	uint32_t width{ 320 };
+	uint32_t height{ 192 };
+
+	// Must match the projection and the rasterizer state the occluders are drawn with
+	bool reverseZ{ false };
+	CullMode cullMode{ CullMode::Back };
+	bool frontCounterClockwise{ false };
+
+	// The widest instruction set the rasterizer may use
+	Math::BatchPath path{ Math::BatchPath::Best };
+};
+
+
+struct OcclusionCullerStats
+{
+	uint64_t numOccluders{ 0 };
+	uint64_t numOccluderTriangles{ 0 };
+	uint64_t numRasterizedTriangles{ 0 };	// Left after back face culling and near plane clipping
+	uint64_t numOccludeesTested{ 0 };
+	uint64_t numOccludeesVisible{ 0 };
+
+	OcclusionCullerStats& operator+=(const OcclusionCullerStats& other) noexcept;
+};
+
+
+// Occlusion culling on the CPU, against a coarse depth buffer rasterized from a few low-poly occluders, so the
+// results are ready the same frame, before any draws are recorded.
+//
+// Each frame, call BeginFrame() with the view-projection matrix, add the occluders, call RasterizeOccluders(),
+// and then test world-space boxes with CullBoundingBoxes(), after Math::Frustum::CullBoundingBoxes() has
+// cleared the bits of the boxes outside the frustum.  Triangles are binned into screen regions, which
+// are rasterized in parallel, 8 pixels at a time with AVX, or 4 with SSE.  Each 8x8 tile also keeps its
+// farthest depth, which settles most tests without reading any pixels.
+//
+// Occluders are sampled at pixel centers, so they should lie inside the geometry they stand for.  Occludees are
+// tested by the screen rectangle and nearest depth of their box, which is conservative.  Matrices are four rows
+// of four floats, laid out like Math::Matrix4, so this builds without DirectXMath.
+class OcclusionCuller : public NonCopyable
+{
+public:
+	explicit OcclusionCuller(const OcclusionCullerDesc& desc = OcclusionCullerDesc{});
+
+	// Clears the depth buffer and the occluders of the last frame
+	void BeginFrame(const float* viewProjectionMatrix);
+
+	// Adds an indexed triangle list.  Positions are three floats at the start of each positionStride-float
+	// vertex, and localToWorld places them in the world.  Not thread-safe.
+	void AddOccluder(const float* localToWorld, std::span<const float> positions, uint32_t positionStride, std::span<const uint32_t> indices);
+
+	void RasterizeOccluders();
+
+	// Clears the bits of boxes that are hidden behind the occluders, or off the screen.  Boxes whose bits are
+	// already clear are skipped, so this refines the mask from Math::Frustum::CullBoundingBoxes(), which takes
+	// the same boxes.  inOutVisibleMask must hold at least (boxes.GetCount() + 63) / 64 words.
+	void CullBoundingBoxes(const Math::BoundingBoxSoA& boxes, std::span<uint64_t> inOutVisibleMask);
+
+	// Tests a single box by its min and max corners, for the odd query that isn't worth a batch
+	bool IsVisible(const float boxMin[3], const float boxMax[3]) const noexcept;
+
+#if !defined(LUNA_HEADLESS)
+	void BeginFrame(const Math::Matrix4& viewProjectionMatrix) { BeginFrame((const float*)&viewProjectionMatrix); }
+	void AddOccluder(const Math::Matrix4& localToWorld, std::span<const float> positions, uint32_t positionStride, std::span<const uint32_t> indices)
+	{
+		AddOccluder((const float*)&localToWorld, positions, positionStride, indices);
+	}
+	bool IsVisible(const Math::BoundingBox& box) const noexcept;
+#endif
+
+	uint32_t GetWidth() const noexcept { return m_width; }
+	uint32_t GetHeight() const noexcept { return m_height; }
+
+	// Distance-like depth, growing away from the camera, and FLT_MAX where no occluder was drawn.  For debug views.
+	std::span<const float> GetDepthBuffer() const noexcept { return m_depthBuffer; }
+
+	OcclusionCullerStats GetStats() const noexcept;
+
+private:
+	// Edge functions and depth plane of a triangle, relative to the center of the pixel at (minX, minY)
+	struct Triangle
+	{
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		int32_t minX;
+		int32_t minY;
+		int32_t maxX;
+		int32_t maxY;
+	};
+
+	struct ClipVertex
+	{
+		float x, y, z, w;
+	};
+
+	void SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void RasterizeBin(uint32_t binIndex);
+
+	// Rasterize the part of a triangle inside the inclusive pixel rectangle (x0, y0) - (x1, y1)
+	void RasterizeTriangleAVX(const Triangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+	void RasterizeTriangleSSE(const Triangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+	void RasterizeTriangleScalar(const Triangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+
+	bool TestBox(const float boxMin[3], const float boxMax[3]) const noexcept;
+
+private:
+	const OcclusionCullerDesc m_desc;
+	const uint32_t m_width;
+	const uint32_t m_height;
+	const uint32_t m_numTilesX;
+	const uint32_t m_numTilesY;
+	const uint32_t m_numBinsX;
+	const uint32_t m_numBinsY;
+
+	float m_viewProjectionMatrix[16]{ 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+
+	std::vector<float> m_depthBuffer;
+	std::vector<float> m_tileMaxDepth;	// Farthest depth in each 8x8 tile
+
+	std::vector<Triangle> m_triangles;
+	std::vector<std::vector<uint32_t>> m_binTriangles;	// Keep their capacity from frame to frame
+
+	std::vector<ClipVertex> m_clipVertices;
+
+	OcclusionCullerStats m_stats;
+};
+
+
+#if !defined(LUNA_HEADLESS)
+inline bool OcclusionCuller::IsVisible(const Math::BoundingBox& box) const noexcept
+{
+	const Math::Vector3 minCorner = box.GetMin();
+	const Math::Vector3 maxCorner = box.GetMax();
+	const float boxMin[3] = { minCorner.GetX(), minCorner.GetY(), minCorner.GetZ() };
+	const float boxMax[3] = { maxCorner.GetX(), maxCorner.GetY(), maxCorner.GetZ() };
+
+	return TestBox(boxMin, boxMax);
+}
+#endif
+
+} // namespace Luna
@@ -0,0 +1,78 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "PipelineCache.h"
+
+#include "FileSystem.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+string GetPipelineCacheFilename(GraphicsApi api)
+{
+	const string filename = format("PipelineCache.{}.bin", GraphicsApiToString(api));
+	return (GetFileSystem()->GetCachePath() / filename).string();
+}
+
+
+PipelineCacheStatus ReadPipelineCacheFile(const string& filename, const PipelineCacheIdentity& identity, vector<std::byte>& outPayload)
+{
+	outPayload.clear();
+
+	PipelineCacheStatus status{ PipelineCacheStatus::NotFound };
+	{
+		MappedFile cacheFile;
+		if (!cacheFile.Open(filename))
+		{
+			return PipelineCacheStatus::NotFound;
+		}
+
+		span<const std::byte> payload;
+		status = ValidatePipelineCacheData(cacheFile.GetSpan(), identity, payload);
+		if (status == PipelineCacheStatus::Loaded)
+		{
+			outPayload.assign(payload.begin(), payload.end());
+			return status;
+		}
+	}
+
+	// The file is unmapped now, so it can be deleted
+	error_code ec;
+	filesystem::remove(filename, ec);
+
+	return status;
+}
+
+
+bool WritePipelineCacheFile(const string& filename, const PipelineCacheIdentity& identity, span<const std::byte> payload)
+{
+	// Oversized files would only be thrown away on the next load
+	const vector<std::byte> fileData = MakePipelineCacheData(identity, payload);
+	if (fileData.size() > MaxPipelineCacheSize)
+	{
+		return false;
+	}
+
+	auto fileSystem = GetFileSystem();
+	if (!fileSystem->EnsureCacheDirectory())
+	{
+		return false;
+	}
+
+	return FileSystem::WriteFileAtomic(filename, fileData);
+}
+
+} // namespace Luna
@@ -0,0 +1,37 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\PipelineCacheData.h"
+
+
+namespace Luna
+{
+
+struct PipelineCacheStats
+{
+	uint32_t numHits{ 0 };
+	uint32_t numMisses{ 0 };
+	uint64_t bytesLoaded{ 0 };
+	uint64_t bytesSaved{ 0 };
+};
+
+
+std::string GetPipelineCacheFilename(GraphicsApi api);
+
+// Reads and validates a cache file, copying out its payload.  Files that fail validation are deleted, so
+// that they are replaced on the next save.
+PipelineCacheStatus ReadPipelineCacheFile(const std::string& filename, const PipelineCacheIdentity& identity, std::vector<std::byte>& outPayload);
+bool WritePipelineCacheFile(const std::string& filename, const PipelineCacheIdentity& identity, std::span<const std::byte> payload);
+
+inline LogCategory LogPipelineCache{ "LogPipelineCache" };
+
+} // namespace Luna
@@ -0,0 +1,114 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "PipelineCacheData.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Bump the version whenever the header layout, or the way either backend fills in the payload, changes
+constexpr uint32_t s_pipelineCacheMagic = 0x4F53504C; // 'LPSO'
+constexpr uint32_t s_pipelineCacheVersion = 1;
+
+
+struct FileHeader
+{
+	uint32_t magic{ s_pipelineCacheMagic };
+	uint32_t version{ s_pipelineCacheVersion };
+	uint32_t api{ 0 };
+	uint32_t vendorId{ 0 };
+	uint32_t deviceId{ 0 };
+	uint32_t driverVersion{ 0 };
+	uint8_t driverUuid[16]{};
+	uint64_t payloadSize{ 0 };
+	uint64_t payloadChecksum{ 0 };
+};
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+PipelineCacheStatus ValidatePipelineCacheData(span<const std::byte> fileData, const PipelineCacheIdentity& identity, span<const std::byte>& outPayload, size_t maxSize)
+{
+	outPayload = {};
+
+	if (fileData.size() > maxSize)
+	{
+		return PipelineCacheStatus::TooLarge;
+	}
+
+	if (fileData.size() < sizeof(FileHeader))
+	{
+		return PipelineCacheStatus::Corrupt;
+	}
+
+	FileHeader header{};
+	memcpy(&header, fileData.data(), sizeof(FileHeader));
+
+	if (header.magic != s_pipelineCacheMagic)
+	{
+		return PipelineCacheStatus::Corrupt;
+	}
+
+	if (header.version != s_pipelineCacheVersion ||
+		header.api != (uint32_t)identity.api ||
+		header.vendorId != identity.vendorId ||
+		header.deviceId != identity.deviceId ||
+		header.driverVersion != identity.driverVersion ||
+		memcmp(header.driverUuid, identity.driverUuid.data(), sizeof(header.driverUuid)) != 0)
+	{
+		return PipelineCacheStatus::Stale;
+	}
+
+	if (header.payloadSize != fileData.size() - sizeof(FileHeader))
+	{
+		return PipelineCacheStatus::Corrupt;
+	}
+
+	const auto payload = fileData.subspan(sizeof(FileHeader));
+	if (Utility::HashStable(payload.data(), payload.size()) != header.payloadChecksum)
+	{
+		return PipelineCacheStatus::Corrupt;
+	}
+
+	outPayload = payload;
+	return PipelineCacheStatus::Loaded;
+}
+
+
+vector<std::byte> MakePipelineCacheData(const PipelineCacheIdentity& identity, span<const std::byte> payload)
+{
+	FileHeader header{};
+	header.api = (uint32_t)identity.api;
+	header.vendorId = identity.vendorId;
+	header.deviceId = identity.deviceId;
+	header.driverVersion = identity.driverVersion;
+	memcpy(header.driverUuid, identity.driverUuid.data(), sizeof(header.driverUuid));
+	header.payloadSize = payload.size();
+	header.payloadChecksum = Utility::HashStable(payload.data(), payload.size());
+
+	vector<std::byte> fileData(sizeof(FileHeader) + payload.size());
+	memcpy(fileData.data(), &header, sizeof(FileHeader));
+	if (!payload.empty())
+	{
+		memcpy(fileData.data() + sizeof(FileHeader), payload.data(), payload.size());
+	}
+
+	return fileData;
+}
+
+} // namespace Luna
@@ -0,0 +1,71 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/CoreEnums.h"
+
+
+namespace Luna
+{
+
+// Files larger than this are thrown away on load and rebuilt from the pipelines the application actually
+// creates, which keeps caches that accumulate entries (such as D3D12 pipeline libraries) from growing forever
+constexpr size_t MaxPipelineCacheSize = 128 * 1024 * 1024;
+
+
+// The GPU and driver that produced a pipeline cache.  Blobs from any other device or driver are stale.
+struct PipelineCacheIdentity
+{
+	GraphicsApi api{ GraphicsApi::Unknown };
+	uint32_t vendorId{ 0 };
+	uint32_t deviceId{ 0 };
+	uint32_t driverVersion{ 0 };
+	std::array<uint8_t, 16> driverUuid{};
+};
+
+
+enum class PipelineCacheStatus
+{
+	Loaded,
+	NotFound,
+	Stale,		// Written by another engine version, API, device or driver
+	Corrupt,	// Truncated, or the checksum does not match
+	TooLarge
+};
+
+
+// Checks the header and checksum of a cache file's contents.  On success, outPayload points into fileData.
+// Needs no device or file system, so the headless tests can feed it any bytes.
+PipelineCacheStatus ValidatePipelineCacheData(std::span<const std::byte> fileData, const PipelineCacheIdentity& identity, std::span<const std::byte>& outPayload, size_t maxSize = MaxPipelineCacheSize);
+
+// Wraps a backend's cache blob in a header and checksum
+std::vector<std::byte> MakePipelineCacheData(const PipelineCacheIdentity& identity, std::span<const std::byte> payload);
+
+inline std::string PipelineCacheStatusToString(PipelineCacheStatus status)
+{
+	switch (status)
+	{
+	case PipelineCacheStatus::Loaded:
+		return "Loaded";
+	case PipelineCacheStatus::NotFound:
+		return "NotFound";
+	case PipelineCacheStatus::Stale:
+		return "Stale";
+	case PipelineCacheStatus::Corrupt:
+		return "Corrupt";
+	case PipelineCacheStatus::TooLarge:
+		return "TooLarge";
+	default:
+		return "Unknown";
+	}
+}
+
+} // namespace Luna
@@ -0,0 +1,518 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "RenderGraph.h"
+
+#include "CommandContext.h"
+#include "Device.h"
+#include "DeviceManager.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Pooled textures that go unused for this many frames are released
+constexpr uint64_t s_poolEvictionFrames = 8;
+
+Luna::ResourceType GetTextureResourceType(const Luna::RenderGraphTextureDesc& desc)
+{
+	using enum Luna::ResourceType;
+
+	if (desc.numSamples > 1)
+	{
+		return desc.arraySize > 1 ? Texture2DMS_Array : Texture2DMS;
+	}
+	return desc.arraySize > 1 ? Texture2D_Array : Texture2D;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+bool RenderGraphTextureDesc::operator==(const RenderGraphTextureDesc& rhs) const noexcept
+{
+	return width == rhs.width &&
+		height == rhs.height &&
+		arraySize == rhs.arraySize &&
+		numMips == rhs.numMips &&
+		numSamples == rhs.numSamples &&
+		format == rhs.format &&
+		clearColor == rhs.clearColor &&
+		clearDepth == rhs.clearDepth &&
+		clearStencil == rhs.clearStencil;
+}
+
+
+uint64_t RenderGraphTextureDesc::GetSizeInBytes() const noexcept
+{
+	const uint64_t bitsPerPixel = BitsPerPixel(format);
+
+	uint64_t size{ 0 };
+	uint64_t mipWidth = width;
+	uint64_t mipHeight = height;
+	for (uint32_t mip = 0; mip < numMips; ++mip)
+	{
+		size += mipWidth * mipHeight * bitsPerPixel / 8;
+
+		mipWidth = max<uint64_t>(mipWidth / 2, 1);
+		mipHeight = max<uint64_t>(mipHeight / 2, 1);
+	}
+
+	return size * arraySize * numSamples;
+}
+
+
+RenderGraphHandle RenderGraphPassBuilder::CreateTexture(const string& name, const RenderGraphTextureDesc& desc)
+{
+	return m_graph.CreateTexture(name, desc);
+}
+
+
+void RenderGraphPassBuilder::Read(RenderGraphHandle resource, ResourceState state)
+{
+	m_graph.AddAccess(m_passIndex, resource, state, false);
+}
+
+
+void RenderGraphPassBuilder::Write(RenderGraphHandle resource, ResourceState state)
+{
+	m_graph.AddAccess(m_passIndex, resource, state, true);
+}
+
+
+void RenderGraphPassBuilder::SetNeverCull() noexcept
+{
+	m_graph.m_compiler.SetNeverCull(m_passIndex);
+}
+
+
+RenderGraph::RenderGraph(const RenderGraphDesc& desc)
+	: m_compiler{ desc }
+{}
+
+
+RenderGraph::~RenderGraph() = default;
+
+
+void RenderGraph::Reset()
+{
+	m_compiler.Reset();
+
+	m_resources.clear();
+	m_passes.clear();
+	m_isCompiled = false;
+
+	m_aliasClasses.clear();
+	m_physicalResources.clear();
+}
+
+
+RenderGraphHandle RenderGraph::CreateTexture(const string& name, const RenderGraphTextureDesc& desc)
+{
+	assert(desc.width > 0 && desc.height > 0 && desc.format != Format::Unknown);
+
+	auto it = find(m_aliasClasses.begin(), m_aliasClasses.end(), desc);
+	if (it == m_aliasClasses.end())
+	{
+		m_aliasClasses.push_back(desc);
+		it = m_aliasClasses.end() - 1;
+	}
+
+	Resource resource{
+		.name		= name,
+		.kind		= ResourceKind::Transient,
+		.desc		= desc
+	};
+	m_resources.push_back(std::move(resource));
+
+	m_isCompiled = false;
+
+	return m_compiler.AddTransientTexture((uint32_t)(it - m_aliasClasses.begin()), desc.GetSizeInBytes());
+}
+
+
+RenderGraphHandle RenderGraph::ImportColorBuffer(const string& name, const ColorBufferPtr& colorBuffer, ResourceState finalState)
+{
+	assert(colorBuffer);
+
+	Resource resource{
+		.name			= name,
+		.kind			= ResourceKind::ColorBuffer,
+		.colorBuffer	= colorBuffer
+	};
+
+	return AddImportedResource(std::move(resource), colorBuffer->GetUsageState(), finalState);
+}
+
+
+RenderGraphHandle RenderGraph::ImportDepthBuffer(const string& name, const DepthBufferPtr& depthBuffer, ResourceState finalState)
+{
+	assert(depthBuffer);
+
+	Resource resource{
+		.name			= name,
+		.kind			= ResourceKind::DepthBuffer,
+		.depthBuffer	= depthBuffer
+	};
+
+	return AddImportedResource(std::move(resource), depthBuffer->GetUsageState(), finalState);
+}
+
+
+RenderGraphHandle RenderGraph::ImportGpuBuffer(const string& name, const GpuBufferPtr& gpuBuffer, ResourceState finalState)
+{
+	assert(gpuBuffer);
+
+	Resource resource{
+		.name			= name,
+		.kind			= ResourceKind::GpuBuffer,
+		.gpuBuffer		= gpuBuffer
+	};
+
+	return AddImportedResource(std::move(resource), gpuBuffer->GetUsageState(), finalState);
+}
+
+
+void RenderGraph::AddPass(const string& name, const SetupFunction& setup, ExecuteFunction execute)
+{
+	const uint32_t passIndex = m_compiler.AddPass();
+
+	Pass pass{
+		.name		= name,
+		.execute	= std::move(execute)
+	};
+	m_passes.push_back(std::move(pass));
+
+	RenderGraphPassBuilder builder{ *this, passIndex };
+	setup(builder);
+
+	m_isCompiled = false;
+}
+
+
+bool RenderGraph::Compile()
+{
+	m_compiler.Compile();
+
+	for (const auto& read : m_compiler.GetUninitializedReads())
+	{
+		LogWarning(LogRenderGraph) << "Pass " << m_passes[read.pass].name << " reads transient texture "
+			<< m_resources[read.resource].name << " before any pass writes it" << endl;
+	}
+
+	// Imported resources are known now.  Transients get theirs in AcquirePhysicalResources().
+	const auto& physicalResources = m_compiler.GetPhysicalResources();
+	m_physicalResources.assign(physicalResources.size(), PhysicalResource{});
+	for (size_t i = 0; i < physicalResources.size(); ++i)
+	{
+		const Resource& resource = m_resources[physicalResources[i].firstResource];
+		if (resource.kind != ResourceKind::Transient)
+		{
+			m_physicalResources[i] = { resource.colorBuffer, resource.depthBuffer, resource.gpuBuffer };
+		}
+	}
+
+	m_isCompiled = true;
+
+	return true;
+}
+
+
+void RenderGraph::Execute(GraphicsContext& context)
+{
+	if (!m_isCompiled)
+	{
+		Compile();
+	}
+
+	++m_frameNumber;
+
+	AcquirePhysicalResources(GetDeviceManager()->GetDevice());
+
+	const auto& executedPasses = m_compiler.GetExecutedPasses();
+	const auto& barrierBatches = m_compiler.GetBarrierBatches();
+
+	for (size_t i = 0; i < executedPasses.size(); ++i)
+	{
+		IssueBarriers(context, barrierBatches[i]);
+
+		Pass& pass = m_passes[executedPasses[i]];
+		if (pass.execute)
+		{
+			ScopedDrawEvent event(context, pass.name);
+			pass.execute(context, *this);
+		}
+	}
+
+	IssueBarriers(context, barrierBatches.back());
+
+	ReleasePhysicalResources();
+}
+
+
+ColorBufferPtr RenderGraph::GetColorBuffer(RenderGraphHandle handle) const
+{
+	assert(handle.index < m_resources.size());
+
+	const Resource& resource = m_resources[handle.index];
+	if (resource.kind == ResourceKind::Transient)
+	{
+		const uint32_t physical = m_compiler.GetPhysicalIndex(handle);
+		return physical < m_physicalResources.size() ? m_physicalResources[physical].colorBuffer : nullptr;
+	}
+	return resource.colorBuffer;
+}
+
+
+DepthBufferPtr RenderGraph::GetDepthBuffer(RenderGraphHandle handle) const
+{
+	assert(handle.index < m_resources.size());
+
+	const Resource& resource = m_resources[handle.index];
+	if (resource.kind == ResourceKind::Transient)
+	{
+		const uint32_t physical = m_compiler.GetPhysicalIndex(handle);
+		return physical < m_physicalResources.size() ? m_physicalResources[physical].depthBuffer : nullptr;
+	}
+	return resource.depthBuffer;
+}
+
+
+GpuBufferPtr RenderGraph::GetGpuBuffer(RenderGraphHandle handle) const
+{
+	assert(handle.index < m_resources.size());
+
+	return m_resources[handle.index].gpuBuffer;
+}
+
+
+void RenderGraph::LogStats() const
+{
+	const RenderGraphStats& stats = m_compiler.GetStats();
+
+	LogInfo(LogRenderGraph) << "Render graph: "
+		<< stats.numPasses << " passes (" << stats.numCulledPasses << " culled), "
+		<< stats.numTransientTextures << " transient textures in " << stats.numPhysicalTextures << " resources ("
+		<< stats.physicalBytes / 1024 << " KB, saved " << stats.GetSavedBytes() / 1024 << " KB), "
+		<< stats.numTransitions << " transitions (" << stats.numSplitTransitions << " split), "
+		<< stats.numUAVBarriers << " UAV barriers, "
+		<< stats.numMergedReads << " merged reads, "
+		<< stats.numBarrierBatches << " barrier batches" << endl;
+}
+
+
+RenderGraphHandle RenderGraph::AddImportedResource(Resource&& resource, ResourceState initialState, ResourceState finalState)
+{
+	const auto kind = (resource.kind == ResourceKind::GpuBuffer) ? RenderGraphCompiler::ResourceKind::ImportedBuffer : RenderGraphCompiler::ResourceKind::ImportedTexture;
+
+	m_resources.push_back(std::move(resource));
+
+	m_isCompiled = false;
+
+	return m_compiler.AddImportedResource(kind, initialState, finalState);
+}
+
+
+void RenderGraph::AddAccess(uint32_t passIndex, RenderGraphHandle resource, ResourceState state, bool isWrite)
+{
+	assert(resource.index < m_resources.size());
+
+	const Resource& res = m_resources[resource.index];
+	if (res.kind == ResourceKind::DepthBuffer || (res.kind == ResourceKind::Transient && IsDepthFormat(res.desc.format)))
+	{
+		assert(state != ResourceState::UnorderedAccess);
+	}
+
+	m_compiler.AddAccess(passIndex, resource, state, isWrite);
+}
+
+
+void RenderGraph::AcquirePhysicalResources(IDevice* device)
+{
+	const auto& physicalResources = m_compiler.GetPhysicalResources();
+
+	for (size_t i = 0; i < physicalResources.size(); ++i)
+	{
+		if (physicalResources[i].kind != RenderGraphCompiler::ResourceKind::Transient)
+		{
+			continue;
+		}
+
+		const Resource& resource = m_resources[physicalResources[i].firstResource];
+		const RenderGraphTextureDesc& desc = resource.desc;
+		PhysicalResource& physical = m_physicalResources[i];
+
+		const bool isDepth = IsDepthFormat(desc.format);
+
+		auto it = find_if(m_texturePool.begin(), m_texturePool.end(), [&desc](const PooledTexture& pooled)
+			{
+				return !pooled.inUse && pooled.desc == desc;
+			});
+
+		if (it == m_texturePool.end())
+		{
+			const string& name = resource.name;
+
+			PooledTexture pooled{ .desc = desc };
+
+			if (isDepth)
+			{
+				DepthBufferDesc depthBufferDesc{
+					.name					= name,
+					.resourceType			= GetTextureResourceType(desc),
+					.width					= desc.width,
+					.height					= desc.height,
+					.arraySizeOrDepth		= desc.arraySize,
+					.numMips				= desc.numMips,
+					.numSamples				= desc.numSamples,
+					.format					= desc.format,
+					.clearDepth				= desc.clearDepth,
+					.clearStencil			= desc.clearStencil,
+					.createShaderResources	= true
+				};
+				pooled.depthBuffer = device->CreateDepthBuffer(depthBufferDesc);
+			}
+			else
+			{
+				ColorBufferDesc colorBufferDesc{
+					.name				= name,
+					.resourceType		= GetTextureResourceType(desc),
+					.width				= desc.width,
+					.height				= desc.height,
+					.arraySizeOrDepth	= desc.arraySize,
+					.numMips			= desc.numMips,
+					.numSamples			= desc.numSamples,
+					.format				= desc.format,
+					.clearColor			= desc.clearColor
+				};
+				pooled.colorBuffer = device->CreateColorBuffer(colorBufferDesc);
+			}
+
+			m_texturePool.push_back(pooled);
+			it = m_texturePool.end() - 1;
+		}
+
+		it->inUse = true;
+		it->lastUsedFrame = m_frameNumber;
+
+		physical.colorBuffer = it->colorBuffer;
+		physical.depthBuffer = it->depthBuffer;
+	}
+}
+
+
+void RenderGraph::ReleasePhysicalResources()
+{
+	for (auto& pooled : m_texturePool)
+	{
+		pooled.inUse = false;
+	}
+
+	erase_if(m_texturePool, [this](const PooledTexture& pooled)
+		{
+			return pooled.lastUsedFrame + s_poolEvictionFrames < m_frameNumber;
+		});
+}
+
+
+void RenderGraph::IssueBarriers(GraphicsContext& context, const vector<RenderGraphBarrier>& batch)
+{
+	if (batch.empty())
+	{
+		return;
+	}
+
+	for (const auto& barrier : batch)
+	{
+		const PhysicalResource& physical = m_physicalResources[barrier.physical];
+
+		IGpuResource* gpuResource{ nullptr };
+		if (physical.colorBuffer)
+		{
+			gpuResource = physical.colorBuffer.get();
+		}
+		else if (physical.depthBuffer)
+		{
+			gpuResource = physical.depthBuffer.get();
+		}
+		else
+		{
+			gpuResource = physical.gpuBuffer.get();
+		}
+
+		// Compile() only knows the states it planned for.  Pooled textures, and imported resources touched
+		// between Compile() and Execute(), may already be where they need to be.
+		if (barrier.type != RenderGraphBarrierType::UAV && gpuResource->GetUsageState() == barrier.stateAfter)
+		{
+			continue;
+		}
+
+		switch (barrier.type)
+		{
+		case RenderGraphBarrierType::Transition:
+			if (physical.colorBuffer)
+			{
+				context.TransitionResource(physical.colorBuffer, barrier.stateAfter);
+			}
+			else if (physical.depthBuffer)
+			{
+				context.TransitionResource(physical.depthBuffer, barrier.stateAfter);
+			}
+			else
+			{
+				context.TransitionResource(physical.gpuBuffer, barrier.stateAfter);
+			}
+			break;
+
+		case RenderGraphBarrierType::BeginSplit:
+			if (physical.colorBuffer)
+			{
+				context.BeginResourceTransition(physical.colorBuffer, barrier.stateAfter);
+			}
+			else
+			{
+				context.BeginResourceTransition(physical.depthBuffer, barrier.stateAfter);
+			}
+			break;
+
+		case RenderGraphBarrierType::EndSplit:
+			if (physical.colorBuffer)
+			{
+				context.EndResourceTransition(physical.colorBuffer, barrier.stateAfter);
+			}
+			else
+			{
+				context.EndResourceTransition(physical.depthBuffer, barrier.stateAfter);
+			}
+			break;
+
+		case RenderGraphBarrierType::UAV:
+			if (physical.colorBuffer)
+			{
+				context.InsertUAVBarrier(physical.colorBuffer);
+			}
+			else
+			{
+				context.InsertUAVBarrier(physical.gpuBuffer);
+			}
+			break;
+		}
+	}
+
+	context.FlushResourceBarriers();
+}
+
+} // namespace Luna
@@ -0,0 +1,205 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core\Color.h"
+#include "Graphics\ColorBuffer.h"
+#include "Graphics\DepthBuffer.h"
+#include "Graphics\GpuBuffer.h"
+#include "Graphics\RenderGraphCompiler.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+class GraphicsContext;
+class IDevice;
+class RenderGraph;
+
+
+// Transient textures are owned by the graph.  Depth formats create depth buffers, everything else creates color
+// buffers.  Transients with identical descs and lifetimes that do not overlap share the same resource.
+struct RenderGraphTextureDesc
+{
+	uint64_t width{ 0 };
+	uint32_t height{ 0 };
+	uint32_t arraySize{ 1 };
+	uint32_t numMips{ 1 };
+	uint32_t numSamples{ 1 };
+	Format format{ Format::Unknown };
+	Color clearColor{ DirectX::Colors::Black };
+	float clearDepth{ 1.0f };
+	uint8_t clearStencil{ 0 };
+
+	RenderGraphTextureDesc& SetWidth(uint64_t value) noexcept { width = value; return *this; }
+	RenderGraphTextureDesc& SetHeight(uint32_t value) noexcept { height = value; return *this; }
+	RenderGraphTextureDesc& SetArraySize(uint32_t value) noexcept { arraySize = value; return *this; }
+	RenderGraphTextureDesc& SetNumMips(uint32_t value) noexcept { numMips = value; return *this; }
+	RenderGraphTextureDesc& SetNumSamples(uint32_t value) noexcept { numSamples = value; return *this; }
+	RenderGraphTextureDesc& SetFormat(Format value) noexcept { format = value; return *this; }
+	RenderGraphTextureDesc& SetClearColor(Color value) noexcept { clearColor = value; return *this; }
+	RenderGraphTextureDesc& SetClearDepth(float value) noexcept { clearDepth = value; return *this; }
+	RenderGraphTextureDesc& SetClearStencil(uint8_t value) noexcept { clearStencil = value; return *this; }
+
+	bool operator==(const RenderGraphTextureDesc& rhs) const noexcept;
+
+	// Estimated memory footprint, ignoring placement alignment
+	uint64_t GetSizeInBytes() const noexcept;
+};
+
+
+// Passes declare how they use each resource when they are added.  Anything a pass touches without declaring it
+// is not tracked by the graph.
+class RenderGraphPassBuilder
+{
+	friend class RenderGraph;
+
+public:
+	RenderGraphHandle CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+
+	void Read(RenderGraphHandle resource, ResourceState state = ResourceState::PixelShaderResource);
+	void Write(RenderGraphHandle resource, ResourceState state = ResourceState::RenderTarget);
+
+	// Keeps the pass even if nothing reads its outputs, e.g. for passes with side effects outside the graph
+	void SetNeverCull() noexcept;
+
+private:
+	RenderGraphPassBuilder(RenderGraph& graph, uint32_t passIndex) : m_graph{ graph }, m_passIndex{ passIndex } {}
+
+	RenderGraph& m_graph;
+	const uint32_t m_passIndex;
+};
+
+
+// Frame graph of passes and the resources they read and write.  A frame declares its passes, compiles the graph,
+// and executes it:
+//
+//   Compile() culls passes whose results are never used, places the minimal set of barriers between passes
+//   (merging consecutive reads, splitting transitions across idle passes, batching everything a pass needs
+//   into one flush), and assigns transient textures to physical resources by lifetime.  The work is done by
+//   RenderGraphCompiler, which does not touch the device, so it can run and be inspected headless.
+//
+//   Execute() creates or reuses the physical resources, issues the barrier batches and runs the passes in order
+//   on one graphics context.  Physical resources are kept across frames and reused whenever the descs match.
+//
+// Imported resources are owned by the caller.  The graph starts from their current usage state, and leaves them
+// in their final state if one was given.
+class RenderGraph : NonCopyable
+{
+	friend class RenderGraphPassBuilder;
+
+public:
+	using SetupFunction = std::function<void(RenderGraphPassBuilder&)>;
+	using ExecuteFunction = std::function<void(GraphicsContext&, const RenderGraph&)>;
+
+	explicit RenderGraph(const RenderGraphDesc& desc = RenderGraphDesc{});
+	~RenderGraph();
+
+	// Clears the declared passes and resources.  Physical resources stay in the pool.
+	void Reset();
+
+	RenderGraphHandle CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+	RenderGraphHandle ImportColorBuffer(const std::string& name, const ColorBufferPtr& colorBuffer, ResourceState finalState = ResourceState::Undefined);
+	RenderGraphHandle ImportDepthBuffer(const std::string& name, const DepthBufferPtr& depthBuffer, ResourceState finalState = ResourceState::Undefined);
+	RenderGraphHandle ImportGpuBuffer(const std::string& name, const GpuBufferPtr& gpuBuffer, ResourceState finalState = ResourceState::Undefined);
+
+	// Passes run in the order they are added, so every read must come after the writes it depends on
+	void AddPass(const std::string& name, const SetupFunction& setup, ExecuteFunction execute);
+
+	bool Compile();
+	void Execute(GraphicsContext& context);
+
+	// Valid during Execute()
+	ColorBufferPtr GetColorBuffer(RenderGraphHandle handle) const;
+	DepthBufferPtr GetDepthBuffer(RenderGraphHandle handle) const;
+	GpuBufferPtr GetGpuBuffer(RenderGraphHandle handle) const;
+
+	// Compile results.  Batch i is issued before the i-th executed pass, and the last batch after all of them.
+	const std::vector<uint32_t>& GetExecutedPasses() const noexcept { return m_compiler.GetExecutedPasses(); }
+	const std::vector<std::vector<RenderGraphBarrier>>& GetBarrierBatches() const noexcept { return m_compiler.GetBarrierBatches(); }
+	uint32_t GetPhysicalIndex(RenderGraphHandle handle) const { return m_compiler.GetPhysicalIndex(handle); }
+	bool IsPassCulled(uint32_t passIndex) const { return m_compiler.IsPassCulled(passIndex); }
+	const RenderGraphStats& GetStats() const noexcept { return m_compiler.GetStats(); }
+
+	void LogStats() const;
+
+private:
+	enum class ResourceKind : uint8_t
+	{
+		Transient,
+		ColorBuffer,
+		DepthBuffer,
+		GpuBuffer
+	};
+
+	struct Resource
+	{
+		std::string name;
+		ResourceKind kind{ ResourceKind::Transient };
+		RenderGraphTextureDesc desc;
+
+		ColorBufferPtr colorBuffer;
+		DepthBufferPtr depthBuffer;
+		GpuBufferPtr gpuBuffer;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		ExecuteFunction execute;
+	};
+
+	// The resources behind the compiler's physical resources, in the same order
+	struct PhysicalResource
+	{
+		ColorBufferPtr colorBuffer;
+		DepthBufferPtr depthBuffer;
+		GpuBufferPtr gpuBuffer;
+	};
+
+	struct PooledTexture
+	{
+		RenderGraphTextureDesc desc;
+		ColorBufferPtr colorBuffer;
+		DepthBufferPtr depthBuffer;
+		uint64_t lastUsedFrame{ 0 };
+		bool inUse{ false };
+	};
+
+	RenderGraphHandle AddImportedResource(Resource&& resource, ResourceState initialState, ResourceState finalState);
+	void AddAccess(uint32_t passIndex, RenderGraphHandle resource, ResourceState state, bool isWrite);
+
+	void AcquirePhysicalResources(IDevice* device);
+	void ReleasePhysicalResources();
+	void IssueBarriers(GraphicsContext& context, const std::vector<RenderGraphBarrier>& batch);
+
+private:
+	RenderGraphCompiler m_compiler;
+
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	bool m_isCompiled{ false };
+
+	// Distinct transient descs.  A transient's alias class is the index of its desc.
+	std::vector<RenderGraphTextureDesc> m_aliasClasses;
+
+	std::vector<PhysicalResource> m_physicalResources;
+
+	std::vector<PooledTexture> m_texturePool;
+	uint64_t m_frameNumber{ 0 };
+};
+
+
+// Render graph log category
+inline LogCategory LogRenderGraph{ "LogRenderGraph" };
+
+} // namespace Luna
@@ -0,0 +1,549 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "RenderGraphCompiler.h"
+
+using namespace std;
+
+
+namespace
+{
+
+constexpr uint32_t s_invalidIndex = ~0u;
+
+// Read-only states that can be combined into one state, so that a run of passes reading a resource in different
+// ways needs a single transition
+constexpr Luna::ResourceState s_mergeableReadStates =
+	Luna::ResourceState::ConstantBuffer |
+	Luna::ResourceState::VertexBuffer |
+	Luna::ResourceState::IndexBuffer |
+	Luna::ResourceState::IndirectArgument |
+	Luna::ResourceState::PixelShaderResource |
+	Luna::ResourceState::NonPixelShaderResource;
+
+
+bool IsMergeableReadState(Luna::ResourceState state)
+{
+	return state != Luna::ResourceState::Undefined && (state & ~s_mergeableReadStates) == Luna::ResourceState::Undefined;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+RenderGraphCompiler::RenderGraphCompiler(const RenderGraphDesc& desc)
+	: m_desc{ desc }
+{}
+
+
+void RenderGraphCompiler::Reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+
+	m_executedPasses.clear();
+	m_physicalResources.clear();
+	m_barrierBatches.clear();
+	m_uninitializedReads.clear();
+	m_stats = RenderGraphStats{};
+}
+
+
+RenderGraphHandle RenderGraphCompiler::AddTransientTexture(uint32_t aliasClass, uint64_t sizeInBytes)
+{
+	Resource resource{
+		.kind			= ResourceKind::Transient,
+		.aliasClass		= aliasClass,
+		.sizeInBytes	= sizeInBytes
+	};
+
+	RenderGraphHandle handle{ (uint32_t)m_resources.size() };
+	m_resources.push_back(resource);
+
+	return handle;
+}
+
+
+RenderGraphHandle RenderGraphCompiler::AddImportedResource(ResourceKind kind, ResourceState initialState, ResourceState finalState)
+{
+	assert(kind != ResourceKind::Transient);
+
+	Resource resource{
+		.kind			= kind,
+		.initialState	= initialState,
+		.finalState		= finalState
+	};
+
+	RenderGraphHandle handle{ (uint32_t)m_resources.size() };
+	m_resources.push_back(resource);
+
+	return handle;
+}
+
+
+uint32_t RenderGraphCompiler::AddPass()
+{
+	m_passes.emplace_back();
+	return (uint32_t)m_passes.size() - 1;
+}
+
+
+void RenderGraphCompiler::SetNeverCull(uint32_t passIndex) noexcept
+{
+	m_passes[passIndex].neverCull = true;
+}
+
+
+void RenderGraphCompiler::AddAccess(uint32_t passIndex, RenderGraphHandle resource, ResourceState state, bool isWrite)
+{
+	assert(passIndex < m_passes.size());
+	assert(resource.index < m_resources.size());
+	assert(state != ResourceState::Undefined);
+
+	Pass& pass = m_passes[passIndex];
+
+	for (auto& access : pass.accesses)
+	{
+		if (access.resource != resource.index)
+		{
+			continue;
+		}
+
+		if (isWrite)
+		{
+			access.state = state;
+			access.isWrite = true;
+		}
+		else if (access.isWrite)
+		{
+			access.isRead = true;
+		}
+		else
+		{
+			access.state = access.state | state;
+		}
+		return;
+	}
+
+	Access access{
+		.resource	= resource.index,
+		.state		= state,
+		.isRead		= !isWrite,
+		.isWrite	= isWrite
+	};
+	pass.accesses.push_back(access);
+}
+
+
+void RenderGraphCompiler::Compile()
+{
+	m_executedPasses.clear();
+	m_physicalResources.clear();
+	m_barrierBatches.clear();
+	m_uninitializedReads.clear();
+	m_stats = RenderGraphStats{};
+
+	for (auto& resource : m_resources)
+	{
+		resource.refCount = 0;
+		resource.firstUse = s_invalidIndex;
+		resource.lastUse = 0;
+		resource.physical = s_invalidIndex;
+	}
+
+	CullPasses();
+	ComputeLifetimes();
+	AssignPhysicalResources();
+	PlaceBarriers();
+
+	m_stats.numPasses = (uint32_t)m_passes.size();
+	m_stats.numCulledPasses = m_stats.numPasses - (uint32_t)m_executedPasses.size();
+}
+
+
+uint32_t RenderGraphCompiler::GetPhysicalIndex(RenderGraphHandle handle) const
+{
+	assert(handle.index < m_resources.size());
+
+	return m_resources[handle.index].physical;
+}
+
+
+bool RenderGraphCompiler::IsPassCulled(uint32_t passIndex) const
+{
+	assert(passIndex < m_passes.size());
+
+	return m_passes[passIndex].isCulled;
+}
+
+
+void RenderGraphCompiler::CullPasses()
+{
+	// A pass is kept while anything reads one of its outputs.  Imported resources are always treated as read,
+	// since the caller uses them after the graph runs.
+	for (auto& pass : m_passes)
+	{
+		pass.isCulled = false;
+		pass.refCount = 0;
+
+		for (const auto& access : pass.accesses)
+		{
+			if (access.isWrite)
+			{
+				++pass.refCount;
+			}
+			else
+			{
+				++m_resources[access.resource].refCount;
+			}
+		}
+	}
+
+	for (auto& resource : m_resources)
+	{
+		if (resource.kind != ResourceKind::Transient)
+		{
+			++resource.refCount;
+		}
+	}
+
+	if (!m_desc.enableCulling)
+	{
+		return;
+	}
+
+	vector<uint32_t> unreferenced;
+
+	auto CullPass = [&](Pass& pass)
+	{
+		pass.isCulled = true;
+		for (const auto& access : pass.accesses)
+		{
+			if (!access.isWrite && --m_resources[access.resource].refCount == 0)
+			{
+				unreferenced.push_back(access.resource);
+			}
+		}
+	};
+
+	for (uint32_t i = 0; i < (uint32_t)m_resources.size(); ++i)
+	{
+		if (m_resources[i].refCount == 0)
+		{
+			unreferenced.push_back(i);
+		}
+	}
+
+	for (auto& pass : m_passes)
+	{
+		if (pass.refCount == 0 && !pass.neverCull)
+		{
+			CullPass(pass);
+		}
+	}
+
+	while (!unreferenced.empty())
+	{
+		const uint32_t resourceIndex = unreferenced.back();
+		unreferenced.pop_back();
+
+		for (auto& pass : m_passes)
+		{
+			if (pass.isCulled || pass.neverCull)
+			{
+				continue;
+			}
+
+			for (const auto& access : pass.accesses)
+			{
+				if (access.resource == resourceIndex && access.isWrite)
+				{
+					if (--pass.refCount == 0)
+					{
+						CullPass(pass);
+					}
+					break;
+				}
+			}
+		}
+	}
+}
+
+
+void RenderGraphCompiler::ComputeLifetimes()
+{
+	for (uint32_t passIndex = 0; passIndex < (uint32_t)m_passes.size(); ++passIndex)
+	{
+		if (m_passes[passIndex].isCulled)
+		{
+			continue;
+		}
+
+		const uint32_t executedIndex = (uint32_t)m_executedPasses.size();
+		m_executedPasses.push_back(passIndex);
+
+		for (const auto& access : m_passes[passIndex].accesses)
+		{
+			Resource& resource = m_resources[access.resource];
+			if (resource.firstUse == s_invalidIndex)
+			{
+				resource.firstUse = executedIndex;
+
+				if (resource.kind == ResourceKind::Transient && access.isRead)
+				{
+					m_uninitializedReads.push_back({ passIndex, access.resource });
+				}
+			}
+			resource.lastUse = executedIndex;
+		}
+	}
+}
+
+
+void RenderGraphCompiler::AssignPhysicalResources()
+{
+	vector<uint32_t> transients;
+
+	for (uint32_t i = 0; i < (uint32_t)m_resources.size(); ++i)
+	{
+		Resource& resource = m_resources[i];
+		if (resource.firstUse == s_invalidIndex)
+		{
+			continue;
+		}
+
+		if (resource.kind == ResourceKind::Transient)
+		{
+			transients.push_back(i);
+			continue;
+		}
+
+		PhysicalResource physical{
+			.kind			= resource.kind,
+			.firstResource	= i,
+			.lastUse		= resource.lastUse
+		};
+
+		resource.physical = (uint32_t)m_physicalResources.size();
+		m_physicalResources.push_back(physical);
+	}
+
+	// Greedy interval assignment in order of first use.  A transient moves into a resource with the same desc
+	// once every earlier tenant is done with it.
+	sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b)
+		{
+			return m_resources[a].firstUse < m_resources[b].firstUse;
+		});
+
+	for (uint32_t resourceIndex : transients)
+	{
+		Resource& resource = m_resources[resourceIndex];
+
+		m_stats.numTransientTextures++;
+		m_stats.transientBytes += resource.sizeInBytes;
+
+		if (m_desc.enableAliasing)
+		{
+			for (uint32_t i = 0; i < (uint32_t)m_physicalResources.size(); ++i)
+			{
+				PhysicalResource& physical = m_physicalResources[i];
+				if (physical.kind == ResourceKind::Transient && physical.lastUse < resource.firstUse && m_resources[physical.firstResource].aliasClass == resource.aliasClass)
+				{
+					physical.lastUse = resource.lastUse;
+					resource.physical = i;
+					break;
+				}
+			}
+
+			if (resource.physical != s_invalidIndex)
+			{
+				continue;
+			}
+		}
+
+		PhysicalResource physical{
+			.kind			= ResourceKind::Transient,
+			.firstResource	= resourceIndex,
+			.lastUse		= resource.lastUse
+		};
+
+		resource.physical = (uint32_t)m_physicalResources.size();
+		m_physicalResources.push_back(physical);
+
+		m_stats.numPhysicalTextures++;
+		m_stats.physicalBytes += resource.sizeInBytes;
+	}
+}
+
+
+void RenderGraphCompiler::PlaceBarriers()
+{
+	const uint32_t numExecuted = (uint32_t)m_executedPasses.size();
+
+	// One batch before each executed pass, plus one after the last pass for the final states
+	m_barrierBatches.resize(numExecuted + 1);
+
+	struct PhysicalState
+	{
+		ResourceState state{ ResourceState::Undefined };
+		uint32_t lastAccess{ s_invalidIndex };
+		bool lastAccessWasWrite{ false };
+	};
+
+	vector<PhysicalState> states(m_physicalResources.size());
+	for (uint32_t i = 0; i < (uint32_t)m_physicalResources.size(); ++i)
+	{
+		const PhysicalResource& physical = m_physicalResources[i];
+		if (physical.kind != ResourceKind::Transient)
+		{
+			states[i].state = m_resources[physical.firstResource].initialState;
+		}
+	}
+
+	// Finds an executed pass's access to a physical resource, for looking ahead when merging reads
+	auto FindAccess = [this](uint32_t executedIndex, uint32_t physical) -> const Access*
+	{
+		for (const auto& access : m_passes[m_executedPasses[executedIndex]].accesses)
+		{
+			if (m_resources[access.resource].physical == physical)
+			{
+				return &access;
+			}
+		}
+		return nullptr;
+	};
+
+	for (uint32_t k = 0; k < numExecuted; ++k)
+	{
+		for (const auto& access : m_passes[m_executedPasses[k]].accesses)
+		{
+			const Resource& resource = m_resources[access.resource];
+			const uint32_t physicalIndex = resource.physical;
+			const PhysicalResource& physical = m_physicalResources[physicalIndex];
+			PhysicalState& state = states[physicalIndex];
+
+			ResourceState targetState = access.state;
+
+			if (!access.isWrite && state.state != ResourceState::Undefined && HasAllFlags(state.state, targetState) && IsMergeableReadState(state.state))
+			{
+				// An earlier transition already moved the resource into a combined read state that covers this one
+				m_stats.numMergedReads++;
+				state.lastAccess = k;
+				state.lastAccessWasWrite = false;
+				continue;
+			}
+
+			if (state.state == targetState)
+			{
+				// Back to back UAV access needs the writes of the first to be visible to the second
+				if (targetState == ResourceState::UnorderedAccess && state.lastAccess != s_invalidIndex && (access.isWrite || state.lastAccessWasWrite))
+				{
+					RenderGraphBarrier barrier{
+						.resource		= access.resource,
+						.physical		= physicalIndex,
+						.type			= RenderGraphBarrierType::UAV,
+						.stateBefore	= state.state,
+						.stateAfter		= targetState
+					};
+					m_barrierBatches[k].push_back(barrier);
+					m_stats.numUAVBarriers++;
+				}
+
+				state.lastAccess = k;
+				state.lastAccessWasWrite = access.isWrite;
+				continue;
+			}
+
+			// Fold the following run of reads into this transition
+			if (!access.isWrite && IsMergeableReadState(targetState))
+			{
+				for (uint32_t next = k + 1; next < numExecuted; ++next)
+				{
+					const Access* nextAccess = FindAccess(next, physicalIndex);
+					if (!nextAccess)
+					{
+						continue;
+					}
+
+					if (nextAccess->isWrite || !IsMergeableReadState(nextAccess->state))
+					{
+						break;
+					}
+
+					targetState = targetState | nextAccess->state;
+				}
+			}
+
+			// Textures that sit idle between two passes start their transition right after the earlier one, so
+			// the GPU can overlap it with the passes in between
+			const uint32_t beginBatch = (state.lastAccess == s_invalidIndex) ? 0 : state.lastAccess + 1;
+			const bool isTexture = (physical.kind != ResourceKind::ImportedBuffer);
+			const bool canSplit = m_desc.enableSplitBarriers && isTexture && beginBatch < k && state.state != ResourceState::Undefined;
+
+			RenderGraphBarrier barrier{
+				.resource		= access.resource,
+				.physical		= physicalIndex,
+				.type			= canSplit ? RenderGraphBarrierType::EndSplit : RenderGraphBarrierType::Transition,
+				.stateBefore	= state.state,
+				.stateAfter		= targetState
+			};
+			m_barrierBatches[k].push_back(barrier);
+
+			if (canSplit)
+			{
+				barrier.type = RenderGraphBarrierType::BeginSplit;
+				m_barrierBatches[beginBatch].push_back(barrier);
+				m_stats.numSplitTransitions++;
+			}
+			m_stats.numTransitions++;
+
+			state.state = targetState;
+			state.lastAccess = k;
+			state.lastAccessWasWrite = access.isWrite;
+		}
+	}
+
+	// Imported resources go back to the state the caller asked for
+	for (uint32_t i = 0; i < (uint32_t)m_physicalResources.size(); ++i)
+	{
+		const PhysicalResource& physical = m_physicalResources[i];
+		if (physical.kind == ResourceKind::Transient)
+		{
+			continue;
+		}
+
+		const Resource& resource = m_resources[physical.firstResource];
+		if (resource.finalState == ResourceState::Undefined || resource.finalState == states[i].state)
+		{
+			continue;
+		}
+
+		RenderGraphBarrier barrier{
+			.resource		= physical.firstResource,
+			.physical		= i,
+			.type			= RenderGraphBarrierType::Transition,
+			.stateBefore	= states[i].state,
+			.stateAfter		= resource.finalState
+		};
+		m_barrierBatches[numExecuted].push_back(barrier);
+		m_stats.numTransitions++;
+	}
+
+	for (const auto& batch : m_barrierBatches)
+	{
+		m_stats.numBarrierBatches += batch.empty() ? 0 : 1;
+	}
+}
+
+} // namespace Luna
\ No newline at end of file
@@ -0,0 +1,187 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/BitmaskEnum.h"
+#include "Graphics/Enums.h"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace Luna
+{
+
+struct RenderGraphHandle
+{
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	uint32_t index{ InvalidIndex };
+
+	bool IsValid() const noexcept { return index != InvalidIndex; }
+	bool operator==(const RenderGraphHandle& rhs) const noexcept = default;
+};
+
+
+enum class RenderGraphBarrierType : uint8_t
+{
+	Transition,
+	BeginSplit,
+	EndSplit,
+	UAV
+};
+
+
+struct RenderGraphBarrier
+{
+	uint32_t resource{ 0 };		// Resource index, as in RenderGraphHandle
+	uint32_t physical{ 0 };		// Physical resource index.  Aliased transients share one.
+	RenderGraphBarrierType type{ RenderGraphBarrierType::Transition };
+	ResourceState stateBefore{ ResourceState::Undefined };
+	ResourceState stateAfter{ ResourceState::Undefined };
+};
+
+
+struct RenderGraphStats
+{
+	uint32_t numPasses{ 0 };
+	uint32_t numCulledPasses{ 0 };
+	uint32_t numTransientTextures{ 0 };
+	uint32_t numPhysicalTextures{ 0 };
+	uint64_t transientBytes{ 0 };		// If every transient texture had its own memory
+	uint64_t physicalBytes{ 0 };		// After aliasing
+	uint32_t numTransitions{ 0 };		// Including split transitions, counted once each
+	uint32_t numSplitTransitions{ 0 };
+	uint32_t numUAVBarriers{ 0 };
+	uint32_t numMergedReads{ 0 };		// Reads that needed no barrier because an earlier one covered them
+	uint32_t numBarrierBatches{ 0 };	// Non-empty batches, i.e. calls to FlushResourceBarriers()
+
+	uint64_t GetSavedBytes() const noexcept { return transientBytes - physicalBytes; }
+};
+
+
+struct RenderGraphDesc
+{
+	bool enableCulling{ true };
+	bool enableAliasing{ true };
+	bool enableSplitBarriers{ true };
+};
+
+
+// The device-independent half of RenderGraph: culls passes, assigns transient textures to physical resources and
+// places barriers, working only on indices and states.  RenderGraph feeds it the passes and resources it is given,
+// and owns everything that touches the device.  It builds headless, so the compile step can be tested on its own.
+//
+// Transients in the same alias class are interchangeable, i.e. they have identical descs, and share a physical
+// resource when their lifetimes do not overlap.
+class RenderGraphCompiler
+{
+public:
+	enum class ResourceKind : uint8_t
+	{
+		Transient,
+		ImportedTexture,
+		ImportedBuffer
+	};
+
+	struct PhysicalResource
+	{
+		ResourceKind kind{ ResourceKind::Transient };
+		uint32_t firstResource{ 0 };	// The first resource assigned to it, whose desc it is created with
+		uint32_t lastUse{ 0 };			// Executed pass index
+	};
+
+	// A transient texture read by a pass before any pass writes it
+	struct UninitializedRead
+	{
+		uint32_t pass{ 0 };
+		uint32_t resource{ 0 };
+	};
+
+	explicit RenderGraphCompiler(const RenderGraphDesc& desc = RenderGraphDesc{});
+
+	void Reset();
+
+	RenderGraphHandle AddTransientTexture(uint32_t aliasClass, uint64_t sizeInBytes);
+	RenderGraphHandle AddImportedResource(ResourceKind kind, ResourceState initialState, ResourceState finalState = ResourceState::Undefined);
+
+	uint32_t AddPass();
+	void SetNeverCull(uint32_t passIndex) noexcept;
+
+	// One access per resource per pass.  A pass that reads and writes a resource uses it in the write state, and
+	// several reads are combined into one state.
+	void AddAccess(uint32_t passIndex, RenderGraphHandle resource, ResourceState state, bool isWrite);
+
+	void Compile();
+
+	uint32_t GetNumResources() const noexcept { return (uint32_t)m_resources.size(); }
+	uint32_t GetNumPasses() const noexcept { return (uint32_t)m_passes.size(); }
+
+	// Compile results.  Batch i is issued before the i-th executed pass, and the last batch after all of them.
+	const std::vector<uint32_t>& GetExecutedPasses() const noexcept { return m_executedPasses; }
+	const std::vector<std::vector<RenderGraphBarrier>>& GetBarrierBatches() const noexcept { return m_barrierBatches; }
+	const std::vector<PhysicalResource>& GetPhysicalResources() const noexcept { return m_physicalResources; }
+	const std::vector<UninitializedRead>& GetUninitializedReads() const noexcept { return m_uninitializedReads; }
+	uint32_t GetPhysicalIndex(RenderGraphHandle handle) const;
+	bool IsPassCulled(uint32_t passIndex) const;
+	const RenderGraphStats& GetStats() const noexcept { return m_stats; }
+
+private:
+	struct Resource
+	{
+		ResourceKind kind{ ResourceKind::Transient };
+		uint32_t aliasClass{ 0 };
+		uint64_t sizeInBytes{ 0 };
+		ResourceState initialState{ ResourceState::Undefined };
+		ResourceState finalState{ ResourceState::Undefined };
+
+		uint32_t refCount{ 0 };
+		uint32_t firstUse{ ~0u };
+		uint32_t lastUse{ 0 };
+		uint32_t physical{ ~0u };
+	};
+
+	struct Access
+	{
+		uint32_t resource{ 0 };
+		ResourceState state{ ResourceState::Undefined };
+		bool isRead{ false };
+		bool isWrite{ false };
+	};
+
+	struct Pass
+	{
+		std::vector<Access> accesses;
+		bool neverCull{ false };
+
+		uint32_t refCount{ 0 };
+		bool isCulled{ false };
+	};
+
+	void CullPasses();
+	void ComputeLifetimes();
+	void AssignPhysicalResources();
+	void PlaceBarriers();
+
+private:
+	const RenderGraphDesc m_desc;
+
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+
+	std::vector<uint32_t> m_executedPasses;
+	std::vector<PhysicalResource> m_physicalResources;
+	std::vector<std::vector<RenderGraphBarrier>> m_barrierBatches;
+	std::vector<UninitializedRead> m_uninitializedReads;
+	RenderGraphStats m_stats;
+};
+
+} // namespace Luna
\ No newline at end of file
@@ -15,6 +15,8 @@
 #include "RootSignature.h"
 #include "Texture.h"
 
+using namespace std;
+
 
 namespace Luna
 {
@@ -45,6 +47,7 @@ void ResourceSet::Initialize(RootSignaturePtr rootSignature)
 void ResourceSet::SetSRV(int param, int slot, ColorBufferPtr colorBuffer)
 {
 	assert(param < (int)m_descriptorSets.size());
+	ClearPendingTexture(param, slot);
 	m_descriptorSets[param]->SetSRV(slot, colorBuffer);
 }
 
@@ -52,6 +55,7 @@ void ResourceSet::SetSRV(int param, int slot, ColorBufferPtr colorBuffer)
 void ResourceSet::SetSRV(int param, int slot, DepthBufferPtr depthBuffer, bool depthSrv)
 {
 	assert(param < (int)m_descriptorSets.size());
+	ClearPendingTexture(param, slot);
 	m_descriptorSets[param]->SetSRV(slot, depthBuffer, depthSrv);
 }
 
@@ -59,6 +63,7 @@ void ResourceSet::SetSRV(int param, int slot, DepthBufferPtr depthBuffer, bool d
 void ResourceSet::SetSRV(int param, int slot, GpuBufferPtr gpuBuffer)
 {
 	assert(param < (int)m_descriptorSets.size());
+	ClearPendingTexture(param, slot);
 	m_descriptorSets[param]->SetSRV(slot, gpuBuffer);
 }
 
@@ -66,6 +71,19 @@ void ResourceSet::SetSRV(int param, int slot, GpuBufferPtr gpuBuffer)
 void ResourceSet::SetSRV(int param, int slot, TexturePtr texture)
 {
 	assert(param < (int)m_descriptorSets.size());
+
+	lock_guard<mutex> lock(m_pendingTextureMutex);
+
+	ClearPendingTexture_Internal(param, slot);
+
+	if (texture->IsLoading())
+	{
+		m_pendingTextures.push_back({ .param = param, .slot = slot, .texture = texture });
+		m_hasPendingTextures.store(true, memory_order_release);
+		m_descriptorSets[param]->SetSRV(slot, GetTextureManager()->GetFallbackTexture());
+		return;
+	}
+
 	m_descriptorSets[param]->SetSRV(slot, texture);
 }
 
@@ -105,6 +123,46 @@ void ResourceSet::SetSampler(int param, int slot, SamplerPtr sampler)
 }
 
 
+unique_lock<mutex> ResourceSet::ResolvePendingTextures()
+{
+	// Nothing can be renamed without a pending texture, and only SetSRV() adds one
+	if (!m_hasPendingTextures.load(memory_order_acquire))
+	{
+		return {};
+	}
+
+	unique_lock<mutex> lock(m_pendingTextureMutex);
+
+	auto firstLoaded = partition(m_pendingTextures.begin(), m_pendingTextures.end(),
+		[](const PendingTexture& pending) { return pending.texture->IsLoading(); });
+
+	if (firstLoaded == m_pendingTextures.end())
+	{
+		return lock;
+	}
+
+	// Rename each descriptor set once, however many of its textures finished loading
+	sort(firstLoaded, m_pendingTextures.end(), [](const PendingTexture& a, const PendingTexture& b) { return a.param < b.param; });
+
+	int renamedParam = -1;
+	for (auto it = firstLoaded; it != m_pendingTextures.end(); ++it)
+	{
+		if (it->param != renamedParam)
+		{
+			m_descriptorSets[it->param]->Rename();
+			renamedParam = it->param;
+		}
+
+		m_descriptorSets[it->param]->SetSRV(it->slot, it->texture);
+	}
+
+	m_pendingTextures.erase(firstLoaded, m_pendingTextures.end());
+	m_hasPendingTextures.store(!m_pendingTextures.empty(), memory_order_release);
+
+	return lock;
+}
+
+
 DescriptorSetPtr& ResourceSet::operator[](uint32_t index)
 {
 	assert(index < (int)m_descriptorSets.size());
@@ -118,4 +176,24 @@ const DescriptorSetPtr& ResourceSet::operator[](uint32_t index) const
 	return m_descriptorSets[index];
 }
 
+
+void ResourceSet::ClearPendingTexture(int param, int slot)
+{
+	if (!m_hasPendingTextures.load(memory_order_acquire))
+	{
+		return;
+	}
+
+	lock_guard<mutex> lock(m_pendingTextureMutex);
+	ClearPendingTexture_Internal(param, slot);
+}
+
+
+void ResourceSet::ClearPendingTexture_Internal(int param, int slot)
+{
+	// A new SRV replaces whatever was set before, including a texture that has not finished loading
+	std::erase_if(m_pendingTextures, [param, slot](const PendingTexture& pending) { return pending.param == param && pending.slot == slot; });
+	m_hasPendingTextures.store(!m_pendingTextures.empty(), memory_order_release);
+}
+
 } // namespace Luna
\ No newline at end of file
@@ -12,6 +12,7 @@
 
 #include "Graphics\GraphicsCommon.h"
 #include "Graphics\DescriptorSet.h"
+#include "Graphics\Texture.h"
 
 
 namespace Luna
@@ -23,7 +24,6 @@ class IDepthBuffer;
 class IGpuBuffer;
 class IRootSignature;
 class ISampler;
-class TexturePtr;
 
 using ColorBufferPtr = std::shared_ptr<IColorBuffer>;
 using DepthBufferPtr = std::shared_ptr<IDepthBuffer>;
@@ -50,13 +50,35 @@ public:
 
 	void SetSampler(int param, int slot, SamplerPtr sampler);
 
+	// Replaces the fallback texture with any textures that have finished streaming in since they were set.
+	// Called by the command context when the set is bound.  The descriptor sets that change are renamed first,
+	// since submitted work, or an earlier bind in a command list still being recorded, may be reading them.
+	// While there are pending textures, the returned lock keeps other threads from renaming the sets until the
+	// caller has finished binding them.
+	std::unique_lock<std::mutex> ResolvePendingTextures();
+
 	uint32_t GetNumDescriptorSets() const { return (uint32_t)m_descriptorSets.size(); }
 
 	DescriptorSetPtr& operator[](uint32_t index);
 	const DescriptorSetPtr& operator[](uint32_t index) const;
 
+private:
+	void ClearPendingTexture(int param, int slot);
+	void ClearPendingTexture_Internal(int param, int slot);
+
 private:
 	std::vector<DescriptorSetPtr> m_descriptorSets;
+
+	// Textures that were still loading when set, and are bound to the fallback texture for now
+	struct PendingTexture
+	{
+		int param{ 0 };
+		int slot{ 0 };
+		TexturePtr texture;
+	};
+	std::mutex m_pendingTextureMutex;
+	std::vector<PendingTexture> m_pendingTextures;
+	std::atomic<bool> m_hasPendingTextures{ false };
 };
 
 } // namespace Luna
\ No newline at end of file
@@ -70,9 +70,12 @@ Shader* Shader::Load(const ShaderDesc& shaderDesc)
 	string fullpath = fileSystem->GetFullPath(shader->GetFilenameWithExtension());
 
 	assert_succeeded(BinaryReader::ReadEntireFile(fullpath, shader->m_byteCode, &shader->m_byteCodeSize));
-	shader->m_isLoaded = true;
 	shader->m_hash = std::hash<std::u8string_view>{}(std::u8string_view{ (char8_t*)shader->GetByteCode(), shader->GetByteCodeSize() });
 
+	// Publish after the hash is written, since waiters read it as soon as they are released
+	shader->m_isLoaded = true;
+	NotifyJobWaiters();
+
 	return shader;
 }
 
@@ -86,11 +89,7 @@ Shader::Shader(const ShaderDesc& shaderDesc)
 
 void Shader::WaitForLoad() const
 {
-	volatile bool& volIsLoaded = (volatile bool&)m_isLoaded;
-	while (!volIsLoaded)
-	{
-		this_thread::yield();
-	}
+	WaitUntil([this] { return m_isLoaded.load(); });
 }
 
 } // namespace Luna
\ No newline at end of file
@@ -57,7 +57,7 @@ private:
 	size_t m_byteCodeSize{ 0 };
 	size_t m_hash{ 0 };
 
-	bool m_isLoaded{ false };
+	std::atomic<bool> m_isLoaded{ false };
 };
 
 } // namespace Luna
\ No newline at end of file
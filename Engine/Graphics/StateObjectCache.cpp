@@ -0,0 +1,54 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "StateObjectCache.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+float StateObjectCacheStats::GetHitRate() const noexcept
+{
+	return numLookups > 0 ? (float)numHits / (float)numLookups : 0.0f;
+}
+
+
+StateObjectCacheStats& StateObjectCacheStats::operator+=(const StateObjectCacheStats& other) noexcept
+{
+	numLookups += other.numLookups;
+	numHits += other.numHits;
+	numWaits += other.numWaits;
+	numCreates += other.numCreates;
+	numFailures += other.numFailures;
+	numCollisions += other.numCollisions;
+	numEntries += other.numEntries;
+
+	return *this;
+}
+
+
+void StateObjectKey::AppendBytes(const void* data, size_t sizeInBytes)
+{
+	const byte* bytes = (const byte*)data;
+	m_data.insert(m_data.end(), bytes, bytes + sizeInBytes);
+}
+
+
+void StateObjectKey::AppendString(string_view str)
+{
+	Append((uint32_t)str.size());
+	AppendBytes(str.data(), str.size());
+}
+
+} // namespace Luna
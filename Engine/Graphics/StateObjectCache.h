@@ -0,0 +1,369 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <bit>
+
+
+namespace Luna
+{
+
+struct StateObjectCacheStats
+{
+	uint64_t numLookups{ 0 };
+	uint64_t numHits{ 0 };
+	uint64_t numWaits{ 0 };			// Hits on an object another thread was still creating
+	uint64_t numCreates{ 0 };
+	uint64_t numFailures{ 0 };		// Creation returned null or threw
+	uint64_t numCollisions{ 0 };	// Equal hashes, different keys
+	uint64_t numEntries{ 0 };
+
+	float GetHitRate() const noexcept;
+
+	StateObjectCacheStats& operator+=(const StateObjectCacheStats& other) noexcept;
+};
+
+
+// The bytes that identify a state object.  Build it from a canonical form of the descriptor:  pointers are
+// replaced by what they point to, unless the pointee is itself a cached object, like a root signature or shader,
+// whose address is then as good as its contents.  Structs are appended as raw bytes, so their padding must be
+// zeroed, which value-initialization (T{}) does.  Padding that isn't zeroed only costs a duplicate object, since
+// keys are compared in full.
+class StateObjectKey
+{
+public:
+	StateObjectKey() { m_data.reserve(256); }
+
+	template <class T>
+	void Append(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Key values must be trivially copyable");
+		AppendBytes(&value, sizeof(T));
+	}
+
+	template <class T>
+	void Append(const T* values, size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Key values must be trivially copyable");
+		AppendBytes(values, count * sizeof(T));
+	}
+
+	void AppendBytes(const void* data, size_t sizeInBytes);
+
+	// Length-prefixed, so ("ab", "c") and ("a", "bc") are different keys
+	void AppendString(std::string_view str);
+
+	std::span<const std::byte> GetBytes() const noexcept { return m_data; }
+	uint64_t GetHash() const noexcept { return Utility::HashBytes64(m_data.data(), m_data.size()); }
+
+private:
+	std::vector<std::byte> m_data;
+};
+
+
+// Maps StateObjectKeys to the objects built from them, shared across threads.  Keys are hashed with
+// Utility::HashBytes64() and then compared in full, so two descriptors whose hashes collide still get their own
+// objects.  The table is split into shards by hash, each a flat array with open addressing behind a
+// reader-writer lock, so finding an existing object, by far the common case once a level is loaded, only takes
+// a shared lock.  On a miss, the caller inserts a pending entry and creates the object outside the lock, and
+// other threads asking for the same key block until it is published.  They don't run jobs meanwhile, since a job
+// run there could need the very object being waited on, further down the same stack.  Entries live as long as
+// the cache.
+// TValue must be default-constructible and testable for null, like wil::com_ptr and std::shared_ptr.
+template <class TValue>
+class StateObjectCache : public NonCopyable
+{
+public:
+	explicit StateObjectCache(uint32_t numShards = 16);
+
+	// Returns the cached object, or the result of createFunction().  If creation returns null or throws, the
+	// threads waiting on it get null, and the next lookup tries again.
+	template <class TCreateFunction>
+	TValue FindOrCreate(const StateObjectKey& key, TCreateFunction&& createFunction)
+	{
+		return FindOrCreate(key.GetHash(), key, std::forward<TCreateFunction>(createFunction));
+	}
+
+	// For callers that already have the key's hash.  Equal keys must come with equal hashes.
+	template <class TCreateFunction>
+	TValue FindOrCreate(uint64_t hash, const StateObjectKey& key, TCreateFunction&& createFunction);
+
+	StateObjectCacheStats GetStats() const;
+
+private:
+	enum class EntryState : uint32_t
+	{
+		Pending,
+		Ready,
+		Failed
+	};
+
+	struct Entry
+	{
+		std::vector<std::byte> key;
+		TValue value{};		// Written once, before state becomes Ready
+		std::atomic<EntryState> state{ EntryState::Pending };
+		std::atomic<std::thread::id> creator{};		// The thread creating the object while Pending
+	};
+
+	struct Slot
+	{
+		uint64_t hash{ 0 };
+		std::unique_ptr<Entry> entry;	// Null for an empty slot
+	};
+
+	// Padded to a cache line, so threads working in different shards don't contend
+	struct alignas(64) Shard
+	{
+		mutable std::shared_mutex mutex;
+
+		// Open addressing with linear probing, kept at most half full
+		std::vector<Slot> slots;
+		uint32_t numEntries{ 0 };
+
+		mutable std::atomic<uint64_t> numLookups{ 0 };
+		mutable std::atomic<uint64_t> numHits{ 0 };
+		mutable std::atomic<uint64_t> numWaits{ 0 };
+		mutable std::atomic<uint64_t> numCreates{ 0 };
+		mutable std::atomic<uint64_t> numFailures{ 0 };
+		mutable std::atomic<uint64_t> numCollisions{ 0 };
+	};
+
+	Shard& GetShard(uint64_t hash) const noexcept { return m_shards[(hash >> 32) & m_shardMask]; }
+	Entry* Find(const Shard& shard, uint64_t hash, std::span<const std::byte> key) const noexcept;
+	Entry* Insert(Shard& shard, uint64_t hash, std::span<const std::byte> key);
+
+	template <class TCreateFunction>
+	TValue Create(Shard& shard, Entry* entry, TCreateFunction&& createFunction);
+
+private:
+	const uint32_t m_shardMask;
+	std::unique_ptr<Shard[]> m_shards;
+};
+
+
+template <class TValue>
+StateObjectCache<TValue>::StateObjectCache(uint32_t numShards)
+	: m_shardMask{ std::bit_ceil(std::max(numShards, 1u)) - 1 }
+	, m_shards{ std::make_unique<Shard[]>(m_shardMask + 1) }
+{
+}
+
+
+template <class TValue>
+template <class TCreateFunction>
+TValue StateObjectCache<TValue>::FindOrCreate(uint64_t hash, const StateObjectKey& key, TCreateFunction&& createFunction)
+{
+	const std::span<const std::byte> keyBytes = key.GetBytes();
+
+	Shard& shard = GetShard(hash);
+	shard.numLookups.fetch_add(1, std::memory_order_relaxed);
+
+	Entry* entry{ nullptr };
+	{
+		std::shared_lock lock(shard.mutex);
+		entry = Find(shard, hash, keyBytes);
+	}
+
+	if (entry == nullptr)
+	{
+		std::unique_lock lock(shard.mutex);
+
+		// Another thread may have inserted it between the two locks
+		entry = Find(shard, hash, keyBytes);
+		if (entry == nullptr)
+		{
+			entry = Insert(shard, hash, keyBytes);
+			lock.unlock();
+
+			return Create(shard, entry, std::forward<TCreateFunction>(createFunction));
+		}
+	}
+
+	EntryState state = entry->state.load(std::memory_order_acquire);
+
+	// Retry a failed creation, unless another thread already is
+	if (state == EntryState::Failed && entry->state.compare_exchange_strong(state, EntryState::Pending, std::memory_order_acquire))
+	{
+		return Create(shard, entry, std::forward<TCreateFunction>(createFunction));
+	}
+
+	if (state == EntryState::Pending)
+	{
+		// The thread creating it is asking again, from its own createFunction or from a job it ran meanwhile.
+		// Waiting would never end, so it gets an object of its own, which isn't cached.
+		if (entry->creator.load(std::memory_order_relaxed) == std::this_thread::get_id())
+		{
+			shard.numCreates.fetch_add(1, std::memory_order_relaxed);
+			return createFunction();
+		}
+
+		shard.numWaits.fetch_add(1, std::memory_order_relaxed);
+
+		// Another thread is creating it.  Returns once the state has moved on from Pending.
+		entry->state.wait(EntryState::Pending, std::memory_order_acquire);
+		state = entry->state.load(std::memory_order_acquire);
+	}
+
+	if (state != EntryState::Ready)
+	{
+		return TValue{};
+	}
+
+	shard.numHits.fetch_add(1, std::memory_order_relaxed);
+	return entry->value;
+}
+
+
+template <class TValue>
+StateObjectCacheStats StateObjectCache<TValue>::GetStats() const
+{
+	StateObjectCacheStats stats;
+
+	for (uint32_t i = 0; i <= m_shardMask; ++i)
+	{
+		const Shard& shard = m_shards[i];
+
+		stats.numLookups += shard.numLookups.load(std::memory_order_relaxed);
+		stats.numHits += shard.numHits.load(std::memory_order_relaxed);
+		stats.numWaits += shard.numWaits.load(std::memory_order_relaxed);
+		stats.numCreates += shard.numCreates.load(std::memory_order_relaxed);
+		stats.numFailures += shard.numFailures.load(std::memory_order_relaxed);
+		stats.numCollisions += shard.numCollisions.load(std::memory_order_relaxed);
+
+		std::shared_lock lock(shard.mutex);
+		stats.numEntries += shard.numEntries;
+	}
+
+	return stats;
+}
+
+
+template <class TValue>
+typename StateObjectCache<TValue>::Entry* StateObjectCache<TValue>::Find(const Shard& shard, uint64_t hash, std::span<const std::byte> key) const noexcept
+{
+	if (shard.numEntries == 0)
+	{
+		return nullptr;
+	}
+
+	const uint32_t slotMask = (uint32_t)shard.slots.size() - 1;
+
+	for (uint32_t index = (uint32_t)hash & slotMask; shard.slots[index].entry; index = (index + 1) & slotMask)
+	{
+		const Slot& slot = shard.slots[index];
+		if (slot.hash != hash)
+		{
+			continue;
+		}
+
+		const std::vector<std::byte>& entryKey = slot.entry->key;
+		if (entryKey.size() == key.size() && memcmp(entryKey.data(), key.data(), key.size()) == 0)
+		{
+			return slot.entry.get();
+		}
+
+		shard.numCollisions.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return nullptr;
+}
+
+
+template <class TValue>
+typename StateObjectCache<TValue>::Entry* StateObjectCache<TValue>::Insert(Shard& shard, uint64_t hash, std::span<const std::byte> key)
+{
+	// Entries are heap nodes, so growing only moves the slots, and pointers handed out stay valid
+	if (2 * (shard.numEntries + 1) > (uint32_t)shard.slots.size())
+	{
+		const uint32_t numSlots = shard.slots.empty() ? 16 : 2 * (uint32_t)shard.slots.size();
+		const uint32_t slotMask = numSlots - 1;
+
+		std::vector<Slot> slots(numSlots);
+		for (Slot& oldSlot : shard.slots)
+		{
+			if (!oldSlot.entry)
+			{
+				continue;
+			}
+
+			uint32_t index = (uint32_t)oldSlot.hash & slotMask;
+			while (slots[index].entry)
+			{
+				index = (index + 1) & slotMask;
+			}
+			slots[index] = std::move(oldSlot);
+		}
+
+		shard.slots = std::move(slots);
+	}
+
+	const uint32_t slotMask = (uint32_t)shard.slots.size() - 1;
+
+	uint32_t index = (uint32_t)hash & slotMask;
+	while (shard.slots[index].entry)
+	{
+		index = (index + 1) & slotMask;
+	}
+
+	Slot& slot = shard.slots[index];
+	slot.hash = hash;
+	slot.entry = std::make_unique<Entry>();
+	slot.entry->key.assign(key.begin(), key.end());
+
+	++shard.numEntries;
+
+	return slot.entry.get();
+}
+
+
+template <class TValue>
+template <class TCreateFunction>
+TValue StateObjectCache<TValue>::Create(Shard& shard, Entry* entry, TCreateFunction&& createFunction)
+{
+	shard.numCreates.fetch_add(1, std::memory_order_relaxed);
+
+	entry->creator.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+	TValue value{};
+
+	try
+	{
+		value = createFunction();
+	}
+	catch (...)
+	{
+		shard.numFailures.fetch_add(1, std::memory_order_relaxed);
+		entry->creator.store(std::thread::id{}, std::memory_order_relaxed);
+		entry->state.store(EntryState::Failed, std::memory_order_release);
+		entry->state.notify_all();
+		throw;
+	}
+
+	entry->creator.store(std::thread::id{}, std::memory_order_relaxed);
+
+	if (value)
+	{
+		entry->value = value;
+		entry->state.store(EntryState::Ready, std::memory_order_release);
+	}
+	else
+	{
+		shard.numFailures.fetch_add(1, std::memory_order_relaxed);
+		entry->state.store(EntryState::Failed, std::memory_order_release);
+	}
+
+	entry->state.notify_all();
+
+	return value;
+}
+
+} // namespace Luna
@@ -12,13 +12,14 @@
 
 #include "Texture.h"
 
-#include "BinaryReader.h"
 #include "FileSystem.h"
+#include "MappedFile.h"
 
 #include "Graphics\Device.h"
 #include "Graphics\Loaders\DDSTextureLoader.h"
 #include "Graphics\Loaders\KTXTextureLoader.h"
 #include "Graphics\Loaders\STBTextureLoader.h"
+#include "Graphics\Loaders\TextureCache.h"
 
 
 namespace Luna
@@ -27,6 +28,14 @@ namespace Luna
 static TextureManager* g_textureManager{ nullptr };
 
 
+// The texture loaders take mutable pointers, but only ever read through them, so they can be handed the
+// read-only pages of a mapping
+static std::byte* GetLoaderData(const std::byte* mappedData)
+{
+	return const_cast<std::byte*>(mappedData);
+}
+
+
 uint32_t TextureInitializer::GetSubresourceIndex(GraphicsApi api, uint32_t face, uint32_t arraySlice, uint32_t mipLevel)
 {
 	const bool isCubemap = dimension == TextureDimension::TextureCube || dimension == TextureDimension::TextureCube_Array;
@@ -50,10 +59,7 @@ uint32_t TextureInitializer::GetSubresourceIndex(GraphicsApi api, uint32_t face,
 
 void ITexture::WaitForLoad() const
 {
-	while (m_isLoading)
-	{
-		std::this_thread::yield();
-	}
+	WaitUntil([this] { return !m_isLoading; });
 }
 
 unsigned long ITexture::AddRef()
@@ -81,11 +87,21 @@ unsigned long ITexture::Release()
 }
 
 
-void ITexture::SetData(std::byte* data, size_t dataSize)
+void ITexture::SetData(const std::byte* data, size_t dataSize, std::shared_ptr<const void> owner)
 {
 	m_dataSize = dataSize;
-	m_data.reset(new std::byte[dataSize]);
-	memcpy(m_data.get(), data, dataSize);
+
+	if (owner)
+	{
+		// Shares ownership with the owner, but points at the data
+		m_data = std::shared_ptr<const std::byte>(std::move(owner), data);
+	}
+	else
+	{
+		std::shared_ptr<std::byte[]> copy(new std::byte[dataSize]);
+		memcpy(copy.get(), data, dataSize);
+		m_data = std::shared_ptr<const std::byte>(copy, copy.get());
+	}
 }
 
 
@@ -173,13 +189,69 @@ TextureManager::TextureManager(IDevice* device)
 
 TextureManager::~TextureManager()
 {
+	WaitForAsyncLoads();
 	g_textureManager = nullptr;
 }
 
 
-TexturePtr TextureManager::Load(const std::string& filename, Format format, bool forceSrgb, bool retainData)
+TexturePtr TextureManager::Load(const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage)
+{
+	return FindOrLoadTexture(filename, format, forceSrgb, retainData, usage);
+}
+
+
+TexturePtr TextureManager::LoadAsync(const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage, TextureLoadPriority priority)
+{
+	bool requestsLoad = false;
+	TexturePtr tex = FindOrCreatePlaceholder(filename, forceSrgb, usage, requestsLoad);
+
+	if (!requestsLoad)
+	{
+		return tex;
+	}
+
+	// Create the fallback up front, so that it is ready before anything tries to bind the placeholder
+	GetFallbackTexture();
+
+	m_asyncLoadQueue.Push([this, tex, filename, format, forceSrgb, retainData, usage]
+		{
+			LoadTextureFromFile(tex.Get(), filename, format, forceSrgb, retainData, usage);
+		},
+		priority);
+
+	return tex;
+}
+
+
+void TextureManager::WaitForAsyncLoads()
 {
-	return FindOrLoadTexture(filename, format, forceSrgb, retainData);
+	m_asyncLoadQueue.Wait();
+}
+
+
+const TexturePtr& TextureManager::GetFallbackTexture()
+{
+	std::lock_guard lock(m_mutex);
+
+	if (m_fallbackTexture.Get() == nullptr)
+	{
+		// Opaque mid-grey
+		std::array<std::byte, 4> texel{ std::byte{ 0x80 }, std::byte{ 0x80 }, std::byte{ 0x80 }, std::byte{ 0xFF } };
+
+		TextureDesc textureDesc{
+			.name		= "Fallback Texture",
+			.width		= 1,
+			.height		= 1,
+			.depth		= 1,
+			.numMips	= 1,
+			.format		= Format::RGBA8_UNorm,
+			.dataSize	= texel.size(),
+			.data		= texel.data()
+		};
+		m_fallbackTexture = m_device->CreateTexture2D(textureDesc);
+	}
+
+	return m_fallbackTexture;
 }
 
 
@@ -195,40 +267,60 @@ void TextureManager::DestroyTexture(const std::string& key)
 }
 
 
-TexturePtr TextureManager::FindOrLoadTexture(const std::string& filename, Format format, bool forceSrgb, bool retainData)
+TexturePtr TextureManager::FindOrLoadTexture(const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage)
 {
-	TexturePtr tex;
+	bool requestsLoad = false;
+	TexturePtr tex = FindOrCreatePlaceholder(filename, forceSrgb, usage, requestsLoad);
 
+	if (requestsLoad)
+	{
+		LoadTextureFromFile(tex.Get(), filename, format, forceSrgb, retainData, usage);
+	}
+	else
 	{
-		std::lock_guard lock(m_mutex);
+		// Wait outside the lock.  The texture might be loading asynchronously, in which case this thread can
+		// end up running the load itself.
+		tex->WaitForLoad();
+	}
 
-		std::string key = filename;
-		if (forceSrgb)
-		{
-			key += "_SRGB";
-		}
+	return tex;
+}
 
-		auto iter = m_textureMap.find(key);
 
-		if (iter != m_textureMap.end())
-		{
-			tex = iter->second.get();
-			tex->WaitForLoad();
-			return tex;
-		}
-		else
-		{
-			tex = m_device->CreateUninitializedTexture(filename, key);
-			m_textureMap[key].reset(tex.Get());
-		}
+TexturePtr TextureManager::FindOrCreatePlaceholder(const std::string& filename, bool forceSrgb, TextureUsage usage, bool& outRequestsLoad)
+{
+	std::lock_guard lock(m_mutex);
+
+	std::string key = filename;
+	if (forceSrgb)
+	{
+		key += "_SRGB";
+	}
+	if (usage != TextureUsage::Default)
+	{
+		key += "_";
+		key += GetTextureUsageName(usage);
 	}
 
-	LoadTextureFromFile(tex.Get(), filename, format, forceSrgb, retainData);
+	auto iter = m_textureMap.find(key);
+	if (iter != m_textureMap.end())
+	{
+		outRequestsLoad = false;
+		return iter->second.get();
+	}
+
+	ITexture* tex = m_device->CreateUninitializedTexture(filename, key);
+	tex->m_isLoading = true;
+	tex->m_isManaged = true;
+	m_textureMap[key].reset(tex);
+
+	// This was the first time it was requested, so the caller must load the file
+	outRequestsLoad = true;
 	return tex;
 }
 
 
-bool TextureManager::LoadTextureFromFile(ITexture* tex, const std::string& filename, Format format, bool forceSrgb, bool retainData)
+bool TextureManager::LoadTextureFromFile(ITexture* tex, const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage)
 {
 	auto fileSystem = GetFileSystem();
 
@@ -238,22 +330,84 @@ bool TextureManager::LoadTextureFromFile(ITexture* tex, const std::string& filen
 	{
 		std::string extension = fileSystem->GetFileExtension(filename);
 
-		size_t dataSize{ 0 };
-		std::unique_ptr<std::byte[]> data;
-		BinaryReader::ReadEntireFile(fileSystem->GetFullPath(filename), data, &dataSize);
+		// DDS and KTX files are already in their final format, so only images decoded by STB are compressed.
+		// An explicit format overrides the usage.  Files in archives have no path to key the cache with, and are
+		// expected to be cooked already.  Only look for the path when it's needed, since that checks every search
+		// path for a file in an archive.
+		const bool compressible = usage != TextureUsage::Default && format == Format::Unknown &&
+			extension != ".dds" && extension != ".ktx" && extension != ".ktx2";
+		const std::string fullPath = compressible ? fileSystem->GetFullPath(filename) : std::string{};
+		const bool compress = compressible && !fullPath.empty();
 
-		CreateTextureFromMemory(m_device, tex, filename, data.get(), dataSize, format, forceSrgb, retainData);
+		if (compress && LoadCompressedTexture(tex, filename, fullPath, forceSrgb, retainData, usage))
+		{
+			loadSucceeded = tex->IsValid();
+		}
+		else
+		{
+			// Loaders read straight from the mapping of the file or archive, and retained DDS data keeps it open
+			// rather than copying it
+			FileData fileData;
+			if (fileSystem->ReadFile(filename, fileData))
+			{
+				CreateTextureFromMemory(m_device, tex, filename, GetLoaderData(fileData.GetData()), fileData.GetSize(), format, forceSrgb, retainData, fileData.GetOwner());
+			}
 
-		loadSucceeded = tex->IsValid();
+			loadSucceeded = tex->IsValid();
+		}
 	}
 
-	tex->m_isManaged = true;
 	tex->m_isLoading = false;
+	NotifyJobWaiters();
+
 	return loadSucceeded;
 }
 
 
-bool CreateTextureFromMemory(IDevice* device, ITexture* texture, const std::string& textureName, std::byte* data, size_t dataSize, Format format, bool forceSrgb, bool retainData)
+bool TextureManager::LoadCompressedTexture(ITexture* tex, const std::string& filename, const std::string& fullPath, bool forceSrgb, bool retainData, TextureUsage usage)
+{
+	TextureCacheKey cacheKey;
+	if (!MakeTextureCacheKey(fullPath, usage, forceSrgb, cacheKey))
+	{
+		return false;
+	}
+
+	const std::string cacheFilename = GetTextureCacheFilename(cacheKey);
+
+	if (std::filesystem::exists(cacheFilename))
+	{
+		auto cacheFile = std::make_shared<MappedFile>();
+		if (cacheFile->Open(cacheFilename))
+		{
+			if (CreateDDSTextureFromMemory(m_device, tex, filename, GetLoaderData(cacheFile->GetData()), cacheFile->GetSize(), Format::Unknown, forceSrgb, retainData, cacheFile))
+			{
+				return true;
+			}
+
+			LogWarning(LogDDS) << "Ignoring invalid texture cache for " << filename << std::endl;
+		}
+	}
+
+	std::vector<std::byte> ddsData;
+	{
+		MappedFile sourceFile;
+		if (!sourceFile.Open(fullPath) || !CompressSTBTextureToDDS(filename, GetLoaderData(sourceFile.GetData()), sourceFile.GetSize(), usage, forceSrgb, ddsData))
+		{
+			return false;
+		}
+	}
+
+	if (!WriteTextureCache(cacheFilename, ddsData))
+	{
+		LogWarning(LogDDS) << "Failed to write texture cache for " << filename << std::endl;
+	}
+
+	return CreateDDSTextureFromMemory(m_device, tex, filename, ddsData.data(), ddsData.size(), Format::Unknown, forceSrgb, retainData);
+}
+
+
+bool CreateTextureFromMemory(IDevice* device, ITexture* texture, const std::string& textureName, std::byte* data, size_t dataSize, Format format, bool forceSrgb, bool retainData,
+	std::shared_ptr<const void> dataOwner)
 {
 	auto fileSystem = GetFileSystem();
 
@@ -261,7 +415,7 @@ bool CreateTextureFromMemory(IDevice* device, ITexture* texture, const std::stri
 
 	if (extension == ".dds")
 	{
-		return CreateDDSTextureFromMemory(device, texture, textureName, data, dataSize, format, forceSrgb, retainData);
+		return CreateDDSTextureFromMemory(device, texture, textureName, data, dataSize, format, forceSrgb, retainData, std::move(dataOwner));
 	}
 	else if (extension == ".ktx" || extension == ".ktx2")
 	{
@@ -281,6 +435,16 @@ TextureManager* GetTextureManager()
 }
 
 
+ITexture* GetBindableTexture(const TexturePtr& texture)
+{
+	if (texture.Get() != nullptr && texture->IsLoading())
+	{
+		return GetTextureManager()->GetFallbackTexture().Get();
+	}
+	return texture.Get();
+}
+
+
 bool FillTextureInitializer(
 	size_t width,
 	size_t height,
@@ -10,8 +10,14 @@
 
 #pragma once
 
+#include "Graphics\BlockCompressor.h"
 #include "Graphics\GraphicsCommon.h"
 #include "Graphics\PixelBuffer.h"
+#include "Graphics\TextureInitializer.h"
+#include "Graphics\TextureLoadQueue.h"
+
+#include <atomic>
+#include <mutex>
 
 namespace Luna
 {
@@ -23,41 +29,6 @@ class TextureManager;
 class TexturePtr;
 
 
-struct TextureSubresourceData
-{
-	// For D3D12_SUBRESOURCE_DATA
-	std::byte* data{ nullptr };
-	uint64_t rowPitch{ 0 };
-	uint64_t slicePitch{ 0 };
-
-	// For VkBufferImageCopy
-	size_t bufferOffset{ 0 };
-	uint32_t mipLevel{ 0 };
-	uint32_t baseArrayLayer{ 0 };
-	uint32_t layerCount{ 0 };
-	uint32_t width{ 0 };
-	uint32_t height{ 0 };
-	uint32_t depth{ 0 };
-};
-
-
-struct TextureInitializer
-{
-	Format format{ Format::Unknown };
-	TextureDimension dimension{ TextureDimension::Unknown };
-	uint64_t width{ 0 };
-	uint32_t height{ 0 };
-	uint32_t arraySizeOrDepth{ 1 };
-	uint32_t numMips{ 1 };
-	std::vector<TextureSubresourceData> subResourceData;
-
-	std::byte* baseData{ nullptr };
-	size_t totalBytes{ 0 };
-
-	uint32_t GetSubresourceIndex(GraphicsApi api, uint32_t arraySlice, uint32_t face, uint32_t mipLevel);
-};
-
-
 struct TextureDesc
 {
 	std::string name;
@@ -83,8 +54,11 @@ public:
 
 	virtual const IDescriptor* GetDescriptor() const = 0;
 
-	void SetData(std::byte* data, size_t dataSize);
-	std::byte* GetData() { return m_data.get(); }
+	// Retains a copy of the data, or only a reference to it when owner keeps the memory it lies in alive, such as
+	// a file mapping
+	void SetData(const std::byte* data, size_t dataSize, std::shared_ptr<const void> owner = nullptr);
+	const std::byte* GetData() const { return m_data.get(); }
+	size_t GetDataSize() const { return m_dataSize; }
 	void ClearRetainedData() 
 	{ 
 		m_data.reset(); 
@@ -98,11 +72,11 @@ protected:
 protected:
 	std::string m_mapKey;
 	std::atomic_ulong m_refCount{ 0 };
-	std::atomic<bool> m_isLoading{ true };
+	std::atomic<bool> m_isLoading{ false };
 	bool m_isManaged{ false };
 
 	// Retained data
-	std::unique_ptr<std::byte[]> m_data;
+	std::shared_ptr<const std::byte> m_data;
 	size_t m_dataSize{ 0 };
 };
 
@@ -135,26 +109,50 @@ public:
 	explicit TextureManager(IDevice* device);
 	~TextureManager();
 
-	TexturePtr Load(const std::string& filename, Format format, bool forceSrgb, bool retainData);
+	// Uncompressed source images with a usage other than TextureUsage::Default are block-compressed on first
+	// load, and loaded from a DDS file in the cache directory after that
+	TexturePtr Load(const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage = TextureUsage::Default);
+
+	// Returns immediately, and reads and decodes the file on the job system.  The texture reports IsLoading()
+	// until it is ready, and the fallback texture is bound in its place until then.  Pending requests are
+	// serviced highest priority first.
+	TexturePtr LoadAsync(const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage = TextureUsage::Default,
+		TextureLoadPriority priority = TextureLoadPriority::Normal);
+	void WaitForAsyncLoads();
+	uint32_t GetNumPendingAsyncLoads() const noexcept { return m_asyncLoadQueue.GetNumPending(); }
+
+	const TexturePtr& GetFallbackTexture();
+
 	void DestroyTexture(const std::string& key);
 
 protected:
-	TexturePtr FindOrLoadTexture(const std::string& filename, Format format, bool forceSrgb, bool retainData);
-	bool LoadTextureFromFile(ITexture* tex, const std::string& filename, Format format, bool forceSrgb, bool retainData);
+	TexturePtr FindOrLoadTexture(const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage);
+	TexturePtr FindOrCreatePlaceholder(const std::string& filename, bool forceSrgb, TextureUsage usage, bool& outRequestsLoad);
+	bool LoadTextureFromFile(ITexture* tex, const std::string& filename, Format format, bool forceSrgb, bool retainData, TextureUsage usage);
+	bool LoadCompressedTexture(ITexture* tex, const std::string& filename, const std::string& fullPath, bool forceSrgb, bool retainData, TextureUsage usage);
 
 protected:
 	IDevice* m_device{ nullptr };
 
 	std::mutex m_mutex;
 	std::unordered_map<std::string, std::unique_ptr<ITexture>> m_textureMap;
+
+	TexturePtr m_fallbackTexture;
+
+	TextureLoadQueue m_asyncLoadQueue;
 };
 
 
-bool CreateTextureFromMemory(IDevice* device, ITexture* texture, const std::string& textureName, std::byte* data, size_t dataSize, Format format, bool forceSrgb, bool retainData);
+// dataOwner keeps data alive, so retained data can point into it instead of being copied
+bool CreateTextureFromMemory(IDevice* device, ITexture* texture, const std::string& textureName, std::byte* data, size_t dataSize, Format format, bool forceSrgb, bool retainData,
+	std::shared_ptr<const void> dataOwner = nullptr);
 
 
 TextureManager* GetTextureManager();
 
+// Returns the texture to bind for a shader read, substituting the fallback texture while it is still loading
+ITexture* GetBindableTexture(const TexturePtr& texture);
+
 bool FillTextureInitializer(
 	size_t width,
 	size_t height,
@@ -0,0 +1,61 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/BitmaskEnum.h"
+#include "Graphics/Enums.h"
+#include "Graphics/Formats.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+enum class GraphicsApi;
+
+
+// The layout of a texture's initial data, as handed to IDevice::InitializeTexture().  Kept apart from Texture.h,
+// so that code that only builds the data, such as the mip generator, needs no graphics API.
+struct TextureSubresourceData
+{
+	// For D3D12_SUBRESOURCE_DATA
+	std::byte* data{ nullptr };
+	uint64_t rowPitch{ 0 };
+	uint64_t slicePitch{ 0 };
+
+	// For VkBufferImageCopy
+	size_t bufferOffset{ 0 };
+	uint32_t mipLevel{ 0 };
+	uint32_t baseArrayLayer{ 0 };
+	uint32_t layerCount{ 0 };
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	uint32_t depth{ 0 };
+};
+
+
+struct TextureInitializer
+{
+	Format format{ Format::Unknown };
+	TextureDimension dimension{ TextureDimension::Unknown };
+	uint64_t width{ 0 };
+	uint32_t height{ 0 };
+	uint32_t arraySizeOrDepth{ 1 };
+	uint32_t numMips{ 1 };
+	std::vector<TextureSubresourceData> subResourceData;
+
+	std::byte* baseData{ nullptr };
+	size_t totalBytes{ 0 };
+
+	uint32_t GetSubresourceIndex(GraphicsApi api, uint32_t arraySlice, uint32_t face, uint32_t mipLevel);
+};
+
+} // namespace Luna
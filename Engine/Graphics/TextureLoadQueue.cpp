@@ -0,0 +1,103 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "TextureLoadQueue.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+TextureLoadQueue::~TextureLoadQueue()
+{
+	// A destructor can't rethrow, and a load that failed has no one left to report to
+	try
+	{
+		Wait();
+	}
+	catch (...)
+	{
+	}
+}
+
+
+void TextureLoadQueue::Push(LoadFunction load, TextureLoadPriority priority)
+{
+	auto jobSystem = GetJobSystem();
+	if (jobSystem == nullptr)
+	{
+		load();
+		return;
+	}
+
+	{
+		lock_guard lock(m_mutex);
+		m_queue.push(Request{ .load = move(load), .priority = priority, .sequence = m_nextSequence++ });
+	}
+	m_numPending.fetch_add(1, memory_order_relaxed);
+
+	// Each job services whichever request is on top of the queue when it runs, rather than the one that
+	// scheduled it, so that later high priority requests overtake earlier low priority ones
+	m_counter->Increment();
+	jobSystem->Schedule([this] { ProcessOne(); }, nullptr, m_counter);
+}
+
+
+void TextureLoadQueue::Wait()
+{
+	WaitForJob(m_counter);
+
+	exception_ptr exception;
+	{
+		lock_guard lock(m_mutex);
+		exception = exchange(m_exception, nullptr);
+	}
+
+	if (exception)
+	{
+		rethrow_exception(exception);
+	}
+}
+
+
+void TextureLoadQueue::ProcessOne()
+{
+	Request request;
+
+	{
+		lock_guard lock(m_mutex);
+
+		assert(!m_queue.empty());
+		request = m_queue.top();
+		m_queue.pop();
+	}
+
+	// Kept here rather than on the counter, which lives as long as the queue, so that a failed load is only
+	// reported by the next Wait()
+	try
+	{
+		request.load();
+	}
+	catch (...)
+	{
+		lock_guard lock(m_mutex);
+		if (!m_exception)
+		{
+			m_exception = current_exception();
+		}
+	}
+
+	m_numPending.fetch_sub(1, memory_order_relaxed);
+}
+
+} // namespace Luna
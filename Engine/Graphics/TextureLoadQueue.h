@@ -0,0 +1,74 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/JobSystem.h"
+
+#include <atomic>
+#include <mutex>
+#include <queue>
+
+
+namespace Luna
+{
+
+enum class TextureLoadPriority
+{
+	Low,
+	Normal,
+	High
+};
+
+
+// The queue behind TextureManager::LoadAsync().  Loads run on the job system, highest priority first and oldest
+// first within a priority.  There is no device behind it, so the headless benchmark can time the same
+// scheduling with its own load function.
+class TextureLoadQueue : NonCopyable, NonMovable
+{
+public:
+	using LoadFunction = std::function<void()>;
+
+	~TextureLoadQueue();
+
+	// Runs the load on the calling thread when there is no job system
+	void Push(LoadFunction load, TextureLoadPriority priority = TextureLoadPriority::Normal);
+
+	// Rethrows the first exception thrown by a load since the last Wait(), once every load has finished
+	void Wait();
+
+	uint32_t GetNumPending() const noexcept { return m_numPending.load(std::memory_order_relaxed); }
+
+private:
+	struct Request
+	{
+		LoadFunction load;
+		TextureLoadPriority priority{ TextureLoadPriority::Normal };
+		uint64_t sequence{ 0 };
+
+		// Orders the priority queue so that the highest priority, oldest request is on top
+		bool operator<(const Request& rhs) const noexcept
+		{
+			return (priority != rhs.priority) ? (priority < rhs.priority) : (sequence > rhs.sequence);
+		}
+	};
+
+	void ProcessOne();
+
+private:
+	std::mutex m_mutex;
+	std::priority_queue<Request> m_queue;
+	uint64_t m_nextSequence{ 0 };
+	JobHandle m_counter{ MakeJobHandle() };
+	std::exception_ptr m_exception;
+	std::atomic<uint32_t> m_numPending{ 0 };
+};
+
+} // namespace Luna
@@ -19,10 +19,80 @@
 #include "GpuBuffer.h"
 #include "Sampler.h"
 
+#include "Core\FrameProfiler.h"
+
 #include "imgui.h"
 #include "backends\imgui_impl_glfw.h"
 
 
+namespace
+{
+
+void ProfileNodeRow(const Luna::FrameProfiler& profiler, const std::vector<Luna::ProfileNode>& tree, uint32_t nodeIndex)
+{
+	const Luna::ProfileNode& node = tree[nodeIndex];
+	const std::string name = profiler.GetName(node.nameId);
+
+	ImGui::TableNextRow();
+	ImGui::TableNextColumn();
+
+	ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen;
+	if (node.children.empty())
+	{
+		flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+	}
+
+	ImGui::PushID((int)nodeIndex);
+	const bool isOpen = ImGui::TreeNodeEx(name.c_str(), flags);
+	ImGui::PopID();
+
+	ImGui::TableNextColumn();
+	ImGui::Text("%.3f", node.lastMs);
+	ImGui::TableNextColumn();
+	ImGui::Text("%.3f", node.GetAvgMs());
+	ImGui::TableNextColumn();
+	ImGui::Text("%.3f", node.minMs);
+	ImGui::TableNextColumn();
+	ImGui::Text("%.3f", node.maxMs);
+	ImGui::TableNextColumn();
+	ImGui::Text("%u", node.lastCalls);
+
+	if (isOpen && !node.children.empty())
+	{
+		for (uint32_t child : node.children)
+		{
+			ProfileNodeRow(profiler, tree, child);
+		}
+		ImGui::TreePop();
+	}
+}
+
+
+void ProfileTreeRows(const Luna::FrameProfiler& profiler, Luna::ProfileTimeline timeline, const char* label)
+{
+	const auto& tree = profiler.GetTree(timeline);
+
+	ImGui::TableNextRow();
+	ImGui::TableNextColumn();
+
+	ImGui::PushID(label);
+	const bool isOpen = ImGui::TreeNodeEx(label, ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen);
+	ImGui::PopID();
+
+	if (isOpen)
+	{
+		// Node 0 is the root
+		for (uint32_t child : tree[0].children)
+		{
+			ProfileNodeRow(profiler, tree, child);
+		}
+		ImGui::TreePop();
+	}
+}
+
+} // anonymous namespace
+
+
 namespace Luna
 {
 
@@ -206,6 +276,69 @@ void UIOverlay::Text(const char* formatstr, ...)
 }
 
 
+void UIOverlay::ProfilerWindow(FrameProfiler& profiler, bool* open)
+{
+	ImGui::SetNextWindowSize(ImVec2(560.0f * m_scale, 400.0f * m_scale), ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin("Profiler", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (ImGui::Button("Reset Stats"))
+	{
+		profiler.ResetStats();
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Save Chrome Trace"))
+	{
+		auto fileSystem = GetFileSystem();
+		fileSystem->EnsureLogDirectory();
+
+		const std::string filename = (fileSystem->GetLogPath() / "ProfileTrace.json").string();
+		if (profiler.ExportChromeTrace(filename))
+		{
+			LogInfo(LogProfiler) << "Saved Chrome trace to " << filename << std::endl;
+		}
+		else
+		{
+			LogWarning(LogProfiler) << "Failed to save Chrome trace to " << filename << std::endl;
+		}
+	}
+
+	if (const uint64_t numDropped = profiler.GetNumDroppedEvents(); numDropped > 0)
+	{
+		ImGui::SameLine();
+		ImGui::Text("Dropped events: %llu", numDropped);
+	}
+
+	const ImGuiTableFlags tableFlags = ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH | ImGuiTableFlags_Resizable | 
+		ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+
+	if (ImGui::BeginTable("ProfilerTree", 6, tableFlags))
+	{
+		const float numberWidth = 60.0f * m_scale;
+
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_NoHide);
+		ImGui::TableSetupColumn("Last (ms)", ImGuiTableColumnFlags_WidthFixed, numberWidth);
+		ImGui::TableSetupColumn("Avg (ms)", ImGuiTableColumnFlags_WidthFixed, numberWidth);
+		ImGui::TableSetupColumn("Min (ms)", ImGuiTableColumnFlags_WidthFixed, numberWidth);
+		ImGui::TableSetupColumn("Max (ms)", ImGuiTableColumnFlags_WidthFixed, numberWidth);
+		ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 0.75f * numberWidth);
+		ImGui::TableHeadersRow();
+
+		ProfileTreeRows(profiler, ProfileTimeline::Cpu, "CPU");
+		ProfileTreeRows(profiler, ProfileTimeline::Gpu, "GPU");
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+
 static inline ImVec4 ColorToImVec4(const Color& color, float alpha)
 {
 	return ImVec4(color.R(), color.G(), color.B(), alpha);
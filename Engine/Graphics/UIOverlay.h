@@ -25,6 +25,7 @@ namespace Luna
 
 // Forward declarations
 class Application;
+class FrameProfiler;
 class GraphicsContext;
 
 
@@ -52,6 +53,9 @@ public:
 	bool Button(const char* caption);
 	void Text(const char* formatstr, ...);
 
+	// Separate window with the CPU and GPU frame trees
+	void ProfilerWindow(FrameProfiler& profiler, bool* open);
+
 protected:
 	void InitImGui();
 	void InitRootSignature();
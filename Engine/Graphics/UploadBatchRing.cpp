@@ -0,0 +1,67 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "UploadBatchRing.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+UploadBatchRing::Batch& UploadBatchRing::Push(uint64_t batchId, uint64_t fenceValue)
+{
+	assert(!IsFull());
+	assert(IsEmpty() || batchId > m_batches[(m_head + m_count - 1) % MaxBatchesInFlight].batchId);
+
+	Batch& batch = m_batches[(m_head + m_count) % MaxBatchesInFlight];
+	batch.batchId = batchId;
+	batch.fenceValue = fenceValue;
+	++m_count;
+
+	return batch;
+}
+
+
+const UploadBatchRing::Batch& UploadBatchRing::Oldest() const
+{
+	assert(!IsEmpty());
+	return m_batches[m_head];
+}
+
+
+uint64_t UploadBatchRing::FindFence(uint64_t batchId) const
+{
+	for (uint32_t i = 0; i < m_count; ++i)
+	{
+		const Batch& batch = m_batches[(m_head + i) % MaxBatchesInFlight];
+		if (batch.batchId == batchId)
+		{
+			return batch.fenceValue;
+		}
+	}
+	return 0;
+}
+
+
+uint64_t UploadBatchRing::GetFenceToMakeRoom() const noexcept
+{
+	return IsFull() ? m_batches[m_head].fenceValue : 0;
+}
+
+
+uint32_t UploadBatchRing::Retire(uint64_t completedFenceValue)
+{
+	return Retire([completedFenceValue](uint64_t fenceValue) { return fenceValue <= completedFenceValue; });
+}
+
+} // namespace Luna
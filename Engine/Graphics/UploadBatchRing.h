@@ -0,0 +1,77 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+
+namespace Luna
+{
+
+// Fixed-size ring of submitted upload batches, ordered by batch id.  Each entry keeps its batch's destination
+// resources alive until the batch's fence completes.  There is no graphics API behind it: the caller supplies
+// the fence values, and tells Retire() which of them have completed.
+class UploadBatchRing
+{
+public:
+	static constexpr uint32_t MaxBatchesInFlight = 8;
+
+	struct Batch
+	{
+		uint64_t batchId{ 0 };
+		uint64_t fenceValue{ 0 };
+		std::vector<std::shared_ptr<const void>> resources;	// Type-erased, the ring only holds the references
+	};
+
+	bool IsEmpty() const noexcept { return m_count == 0; }
+	bool IsFull() const noexcept { return m_count == MaxBatchesInFlight; }
+	uint32_t GetCount() const noexcept { return m_count; }
+
+	// Batch ids must increase.  The ring must not be full.
+	Batch& Push(uint64_t batchId, uint64_t fenceValue);
+	const Batch& Oldest() const;
+
+	// Returns the fence for a submitted batch, or 0 if the batch has already retired
+	uint64_t FindFence(uint64_t batchId) const;
+
+	// Returns the fence to wait on before there is room for another batch, or 0 if there is room already.  This
+	// is the fallback for more batches in flight than the ring holds: the caller waits on the oldest one.
+	uint64_t GetFenceToMakeRoom() const noexcept;
+
+	// Retires batches from the oldest end, stopping at the first one whose fence is still pending
+	template <class TIsFenceComplete>
+	uint32_t Retire(TIsFenceComplete&& isFenceComplete)
+	{
+		uint32_t numRetired = 0;
+		while (m_count > 0)
+		{
+			Batch& batch = m_batches[m_head];
+			if (!isFenceComplete(batch.fenceValue))
+			{
+				break;
+			}
+
+			batch = Batch{};
+			m_head = (m_head + 1) % MaxBatchesInFlight;
+			--m_count;
+			++numRetired;
+		}
+		return numRetired;
+	}
+
+	// Same as above, for fence values from a single queue, which complete in order
+	uint32_t Retire(uint64_t completedFenceValue);
+
+private:
+	std::array<Batch, MaxBatchesInFlight> m_batches;
+	uint32_t m_head{ 0 };
+	uint32_t m_count{ 0 };
+};
+
+} // namespace Luna
@@ -0,0 +1,267 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "UploadQueue.h"
+
+#include "CommandContext.h"
+#include "DeviceManager.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+static UploadQueue* g_uploadQueue{ nullptr };
+
+
+UploadQueue::UploadQueue(size_t maxBatchBytes, uint32_t maxBatchRequests)
+	: m_maxBatchBytes{ maxBatchBytes }
+	, m_maxBatchRequests{ maxBatchRequests }
+{
+	assert(g_uploadQueue == nullptr);
+	g_uploadQueue = this;
+}
+
+
+UploadQueue::~UploadQueue()
+{
+	assert_msg(m_openContext == nullptr, "UploadQueue destroyed with an unsubmitted batch");
+	g_uploadQueue = nullptr;
+}
+
+
+UploadTicket UploadQueue::InitializeBuffer(const GpuBufferPtr& destBuffer, const void* bufferData, size_t numBytes, size_t offset)
+{
+	unique_lock lock(m_mutex);
+
+	// Data is copied to upload memory immediately, so the caller is free to release bufferData on return
+	CommandContext& context = GetOpenContext();
+	context.m_contextImpl->InitializeBuffer_Internal(destBuffer.get(), bufferData, numBytes, offset);
+
+	m_openResources.push_back(destBuffer);
+	m_openBatchBytes += numBytes;
+	++m_openBatchRequests;
+
+	++m_stats.numRequests;
+	m_stats.numBytes += numBytes;
+
+	UploadTicket ticket{ .batchId = m_openBatchId };
+
+	if (m_openBatchBytes >= m_maxBatchBytes || m_openBatchRequests >= m_maxBatchRequests)
+	{
+		CloseOpenBatch(lock);
+	}
+
+	return ticket;
+}
+
+
+UploadTicket UploadQueue::InitializeTexture(const TexturePtr& destTexture, const TextureInitializer& texInit)
+{
+	unique_lock lock(m_mutex);
+
+	CommandContext& context = GetOpenContext();
+	context.m_contextImpl->InitializeTexture_Internal(destTexture.Get(), texInit);
+
+	// TexturePtr holds an intrusive reference, so wrap it to let the ring hold it like any other resource
+	m_openResources.push_back(make_shared<const TexturePtr>(destTexture));
+	m_openBatchBytes += texInit.totalBytes;
+	++m_openBatchRequests;
+
+	++m_stats.numRequests;
+	m_stats.numBytes += texInit.totalBytes;
+
+	UploadTicket ticket{ .batchId = m_openBatchId };
+
+	if (m_openBatchBytes >= m_maxBatchBytes || m_openBatchRequests >= m_maxBatchRequests)
+	{
+		CloseOpenBatch(lock);
+	}
+
+	return ticket;
+}
+
+
+void UploadQueue::Flush()
+{
+	unique_lock lock(m_mutex);
+
+	CloseOpenBatch(lock);
+	RetireCompletedBatches();
+}
+
+
+void UploadQueue::FlushBeforeSubmit()
+{
+	// Most contexts are finished with nothing to upload.  An upload requested by this thread, or by one this
+	// thread has synchronized with since, is always seen here.  Any other is racing the submit anyway.
+	if (!m_hasOpenBatch.load(memory_order_acquire))
+	{
+		return;
+	}
+
+	Flush();
+}
+
+
+bool UploadQueue::IsComplete(UploadTicket ticket)
+{
+	lock_guard lock(m_mutex);
+
+	if (!ticket.IsValid() || ticket.batchId > m_lastSubmittedBatchId)
+	{
+		return !ticket.IsValid();
+	}
+
+	const uint64_t fenceValue = m_submittedBatches.FindFence(ticket.batchId);
+	return fenceValue == 0 || GetDeviceManager()->IsFenceComplete(fenceValue);
+}
+
+
+void UploadQueue::Wait(UploadTicket ticket)
+{
+	if (!ticket.IsValid())
+	{
+		return;
+	}
+
+	uint64_t fenceValue{ 0 };
+
+	{
+		unique_lock lock(m_mutex);
+
+		// The ticket might still belong to the batch being recorded
+		if (ticket.batchId == m_openBatchId)
+		{
+			CloseOpenBatch(lock);
+		}
+
+		fenceValue = GetFenceForBatch(ticket.batchId);
+		++m_stats.numTicketWaits;
+	}
+
+	if (fenceValue != 0)
+	{
+		GetDeviceManager()->WaitForFence(fenceValue);
+	}
+
+	lock_guard lock(m_mutex);
+	RetireCompletedBatches();
+}
+
+
+void UploadQueue::WaitForAll()
+{
+	uint64_t fenceValue{ 0 };
+
+	{
+		unique_lock lock(m_mutex);
+
+		CloseOpenBatch(lock);
+		fenceValue = m_submittedBatches.IsEmpty() ? 0 : m_lastSubmittedFenceValue;
+	}
+
+	if (fenceValue != 0)
+	{
+		GetDeviceManager()->WaitForFence(fenceValue);
+	}
+
+	lock_guard lock(m_mutex);
+	RetireCompletedBatches();
+}
+
+
+UploadQueueStats UploadQueue::GetStats() const
+{
+	lock_guard lock(m_mutex);
+	return m_stats;
+}
+
+
+CommandContext& UploadQueue::GetOpenContext()
+{
+	if (m_openContext == nullptr)
+	{
+		m_openContext = &CommandContext::Begin("Upload Queue");
+		m_hasOpenBatch.store(true, memory_order_release);
+	}
+	return *m_openContext;
+}
+
+
+bool UploadQueue::CloseOpenBatch(unique_lock<mutex>& lock)
+{
+	// Never hold more than a ring's worth of batches in flight.  When the ring is full, block on the oldest one,
+	// but without the lock, so other threads can keep recording into the open batch in the meantime.  One of
+	// them may also submit it, or fill the ring again, before the lock is back.
+	uint64_t fenceValue{ 0 };
+	while (m_openContext != nullptr && (fenceValue = m_submittedBatches.GetFenceToMakeRoom()) != 0)
+	{
+		++m_stats.numRingStalls;
+
+		lock.unlock();
+		GetDeviceManager()->WaitForFence(fenceValue);
+		lock.lock();
+
+		RetireCompletedBatches();
+	}
+
+	if (m_openContext == nullptr)
+	{
+		return false;
+	}
+
+	fenceValue = m_openContext->Submit(false);
+	m_openContext = nullptr;
+	m_hasOpenBatch.store(false, memory_order_relaxed);
+
+	auto& batch = m_submittedBatches.Push(m_openBatchId, fenceValue);
+	batch.resources = std::move(m_openResources);
+
+	m_lastSubmittedBatchId = m_openBatchId;
+	m_lastSubmittedFenceValue = fenceValue;
+
+	m_openResources.clear();
+	m_openBatchBytes = 0;
+	m_openBatchRequests = 0;
+	++m_openBatchId;
+
+	++m_stats.numBatches;
+
+	return true;
+}
+
+
+void UploadQueue::RetireCompletedBatches()
+{
+	auto deviceManager = GetDeviceManager();
+	m_submittedBatches.Retire([deviceManager](uint64_t fenceValue) { return deviceManager->IsFenceComplete(fenceValue); });
+}
+
+
+uint64_t UploadQueue::GetFenceForBatch(uint64_t batchId)
+{
+	assert(batchId <= m_lastSubmittedBatchId);
+
+	// Batches that are no longer in the ring have already retired
+	return m_submittedBatches.FindFence(batchId);
+}
+
+
+UploadQueue* GetUploadQueue()
+{
+	assert(g_uploadQueue != nullptr);
+	return g_uploadQueue;
+}
+
+} // namespace Luna
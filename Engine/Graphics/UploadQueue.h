@@ -0,0 +1,106 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics\Enums.h"
+#include "Graphics\GpuBuffer.h"
+#include "Graphics\Texture.h"
+#include "Graphics\UploadBatchRing.h"
+
+
+namespace Luna
+{
+
+// Forward declarations
+class CommandContext;
+
+
+// Identifies one resource initialization request.  GPU work submitted later on the graphics queue is
+// always ordered after the upload, so a ticket only needs to be waited on when the CPU, or a context on
+// the compute or copy queue, depends on the upload having finished.
+struct UploadTicket
+{
+	uint64_t batchId{ 0 };
+
+	bool IsValid() const noexcept { return batchId != 0; }
+};
+
+
+struct UploadQueueStats
+{
+	uint64_t numRequests{ 0 };
+	uint64_t numBatches{ 0 };
+	uint64_t numBytes{ 0 };
+	uint64_t numTicketWaits{ 0 };
+	uint64_t numRingStalls{ 0 };
+};
+
+
+// Coalesces resource initializations into a single open command context, and submits them as one batch
+// instead of stalling the CPU on each request.  A batch is submitted when it exceeds its size budget, when
+// Flush() is called, or when a graphics context is finished, so that uploads always execute ahead of the
+// graphics work that consumes them.
+class UploadQueue : public NonCopyable
+{
+public:
+	static constexpr size_t DefaultMaxBatchBytes = 64ull * 1024 * 1024;
+	static constexpr uint32_t DefaultMaxBatchRequests = 1024;
+
+	explicit UploadQueue(size_t maxBatchBytes = DefaultMaxBatchBytes, uint32_t maxBatchRequests = DefaultMaxBatchRequests);
+	~UploadQueue();
+
+	UploadTicket InitializeBuffer(const GpuBufferPtr& destBuffer, const void* bufferData, size_t numBytes, size_t offset = 0);
+	UploadTicket InitializeTexture(const TexturePtr& destTexture, const TextureInitializer& texInit);
+
+	// Submits the open batch, if any, without waiting for it
+	void Flush();
+
+	// Called before a graphics context is submitted.  Returns without taking the lock when no batch is open.
+	void FlushBeforeSubmit();
+
+	bool IsComplete(UploadTicket ticket);
+	void Wait(UploadTicket ticket);
+	void WaitForAll();
+
+	UploadQueueStats GetStats() const;
+
+private:
+	CommandContext& GetOpenContext();
+	bool CloseOpenBatch(std::unique_lock<std::mutex>& lock);
+	void RetireCompletedBatches();
+	uint64_t GetFenceForBatch(uint64_t batchId);
+
+private:
+	const size_t m_maxBatchBytes{ DefaultMaxBatchBytes };
+	const uint32_t m_maxBatchRequests{ DefaultMaxBatchRequests };
+
+	mutable std::mutex m_mutex;
+
+	// Batch currently being recorded.  m_hasOpenBatch is written under the lock, and read without it.
+	CommandContext* m_openContext{ nullptr };
+	std::atomic<bool> m_hasOpenBatch{ false };
+	uint64_t m_openBatchId{ 1 };
+	size_t m_openBatchBytes{ 0 };
+	uint32_t m_openBatchRequests{ 0 };
+	std::vector<std::shared_ptr<const void>> m_openResources;
+
+	// Submitted batches, pending retirement
+	UploadBatchRing m_submittedBatches;
+	uint64_t m_lastSubmittedBatchId{ 0 };
+	uint64_t m_lastSubmittedFenceValue{ 0 };
+
+	UploadQueueStats m_stats;
+};
+
+
+UploadQueue* GetUploadQueue();
+
+} // namespace Luna
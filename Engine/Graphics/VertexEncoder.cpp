@@ -0,0 +1,582 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "VertexEncoder.h"
+
+#include <bit>
+
+using namespace std;
+
+
+namespace
+{
+
+// Where one component lives in the float stream and in the encoded stream
+struct StreamElement
+{
+	Luna::VertexComponent component{ Luna::VertexComponent::None };
+	Luna::Format format{ Luna::Format::Unknown };
+	uint32_t floatOffset{ 0 };
+	uint32_t numFloats{ 0 };
+	uint32_t byteOffset{ 0 };
+};
+
+
+struct StreamLayout
+{
+	vector<StreamElement> elements;
+	uint32_t floatStride{ 0 };
+	uint32_t byteStride{ 0 };
+
+	// Float offsets of the components needed for tangent handedness, or -1
+	int32_t normalOffset{ -1 };
+	int32_t bitangentOffset{ -1 };
+};
+
+
+StreamLayout GetStreamLayout(Luna::VertexComponent components, Luna::VertexEncoding encoding)
+{
+	StreamLayout layout;
+
+	uint32_t tempComponents = (uint32_t)components;
+	while (tempComponents != 0)
+	{
+		const uint32_t index = (uint32_t)countr_zero(tempComponents);
+		const Luna::VertexComponent component = Luna::VertexComponent(1 << index);
+		tempComponents ^= (1 << index);
+
+		StreamElement element{
+			.component		= component,
+			.format			= Luna::GetVertexComponentFormat(component, encoding),
+			.floatOffset	= layout.floatStride,
+			.numFloats		= Luna::GetVertexComponentNumFloats(component),
+			.byteOffset		= layout.byteStride
+		};
+
+		if (component == Luna::VertexComponent::Normal)
+		{
+			layout.normalOffset = (int32_t)layout.floatStride;
+		}
+		else if (component == Luna::VertexComponent::Bitangent)
+		{
+			layout.bitangentOffset = (int32_t)layout.floatStride;
+		}
+
+		layout.floatStride += element.numFloats;
+		layout.byteStride += Luna::GetVertexComponentSizeInBytes(component, encoding);
+		layout.elements.push_back(element);
+	}
+
+	return layout;
+}
+
+
+bool IsTexcoord(Luna::VertexComponent component)
+{
+	return HasAnyFlag(component, Luna::VertexComponent::Texcoord0 | Luna::VertexComponent::Texcoord1 | Luna::VertexComponent::Texcoord2 | Luna::VertexComponent::Texcoord3);
+}
+
+
+// Plain float math, so that vertices encode without DirectXMath in the headless tests
+struct Float3
+{
+	float x{ 0.0f };
+	float y{ 0.0f };
+	float z{ 0.0f };
+};
+
+
+Float3 LoadFloat3(const float* values)
+{
+	return Float3{ values[0], values[1], values[2] };
+}
+
+
+float Dot(const Float3& a, const Float3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+Float3 Cross(const Float3& a, const Float3& b)
+{
+	return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+
+// Zero stays zero
+Float3 Normalize(const Float3& a)
+{
+	const float lengthSq = Dot(a, a);
+	const float scale = lengthSq > 0.0f ? 1.0f / sqrtf(lengthSq) : 0.0f;
+	return Float3{ a.x * scale, a.y * scale, a.z * scale };
+}
+
+
+// Reciprocal of the range scale, with zero for a flat axis so that every value on it encodes to zero
+float SafeReciprocal(float scale)
+{
+	return scale != 0.0f ? 1.0f / scale : 0.0f;
+}
+
+
+// Clamps to [0, 1], with NaN going to 0
+float Saturate(float value)
+{
+	return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+}
+
+
+// Clamps to [-1, 1], with NaN going to 0
+float SaturateSigned(float value)
+{
+	return value > -1.0f ? (value < 1.0f ? value : 1.0f) : (value <= -1.0f ? -1.0f : 0.0f);
+}
+
+
+// The packers round to nearest even, like the GPU's own float to normalized conversions
+uint16_t PackUNorm16(float value)
+{
+	return (uint16_t)lrintf(Saturate(value) * 65535.0f);
+}
+
+
+int16_t PackSNorm16(float value)
+{
+	return (int16_t)lrintf(SaturateSigned(value) * 32767.0f);
+}
+
+
+uint8_t PackUNorm8(float value)
+{
+	return (uint8_t)lrintf(Saturate(value) * 255.0f);
+}
+
+
+// IEEE half, rounding to nearest even.  Values past the largest half become infinity, and NaN stays NaN.
+uint16_t PackHalf(float value)
+{
+	const uint32_t bits = bit_cast<uint32_t>(value);
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	const uint32_t absBits = bits & 0x7FFFFFFFu;
+
+	if (absBits >= 0x7F800000u)
+	{
+		return (uint16_t)(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x0200u : 0u));
+	}
+
+	// Halfway between 65504 and 65536 and above
+	if (absBits >= 0x477FF000u)
+	{
+		return (uint16_t)(sign | 0x7C00u);
+	}
+
+	// Below 2^-14, the smallest normal half, the implicit bit is shifted into a denormal
+	if (absBits < 0x38800000u)
+	{
+		const uint32_t shift = 126 - (absBits >> 23);
+		if (shift > 24)
+		{
+			return (uint16_t)sign;
+		}
+
+		const uint32_t mantissa = (absBits & 0x007FFFFFu) | 0x00800000u;
+		const uint32_t rounded = mantissa + (1u << (shift - 1)) - 1 + ((mantissa >> shift) & 1u);
+		return (uint16_t)(sign | (rounded >> shift));
+	}
+
+	// Rebias the exponent from 127 to 15, and round the mantissa from 23 bits to 10.  A carry out of the mantissa
+	// correctly bumps the exponent.
+	const uint32_t rebiased = absBits - 0x38000000u;
+	return (uint16_t)(sign | ((rebiased + 0x0FFFu + ((rebiased >> 13) & 1u)) >> 13));
+}
+
+
+float UnpackHalf(uint16_t half)
+{
+	const uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+	const uint32_t exponent = (half >> 10) & 0x1Fu;
+	const uint32_t mantissa = half & 0x03FFu;
+
+	if (exponent == 0)
+	{
+		const float magnitude = ldexpf((float)mantissa, -24);
+		return sign ? -magnitude : magnitude;
+	}
+
+	const uint32_t bits = exponent == 0x1Fu ?
+		(sign | 0x7F800000u | (mantissa << 13)) :
+		(sign | ((exponent + 112) << 23) | (mantissa << 13));
+	return bit_cast<float>(bits);
+}
+
+
+float UnpackUNorm16(uint16_t value)
+{
+	return (float)value / 65535.0f;
+}
+
+
+// Projects a unit vector onto the octahedron |x| + |y| + |z| = 1, and folds the lower hemisphere over the
+// diagonals, so that xy alone covers the sphere
+void EncodeOctahedral(const Float3& unitVector, float& outX, float& outY)
+{
+	const float l1Norm = max(fabsf(unitVector.x) + fabsf(unitVector.y) + fabsf(unitVector.z), FLT_MIN);
+	const float x = unitVector.x / l1Norm;
+	const float y = unitVector.y / l1Norm;
+	const float z = unitVector.z / l1Norm;
+
+	if (z < 0.0f)
+	{
+		outX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		outY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+	}
+	else
+	{
+		outX = x;
+		outY = y;
+	}
+}
+
+
+#if _DEBUG
+float UnpackSNorm16(int16_t value)
+{
+	return max((float)value / 32767.0f, -1.0f);
+}
+
+
+Float3 DecodeOctahedral(float x, float y)
+{
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+	const float t = max(-z, 0.0f);
+
+	return Normalize(Float3{ x >= 0.0f ? x - t : x + t, y >= 0.0f ? y - t : y + t, z });
+}
+
+
+// Whether a range-normalized value came back within the quantization step, allowing for float rounding
+bool IsWithinRangeError(float decoded, float value, float scale, float step)
+{
+	return fabsf(decoded - value) <= fabsf(scale) * step + fabsf(value) * 1e-5f + 1e-6f;
+}
+
+
+// Half floats keep 11 significant bits, and the normalized values are within [-1, 1]
+constexpr float s_halfStep = 1.0f / 2048.0f;
+constexpr float s_unorm16Step = 1.0f / 65535.0f;
+constexpr float s_unorm8Step = 1.0f / 255.0f;
+constexpr float s_minOctahedralCosine = 0.9999f;
+#endif // _DEBUG
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+VertexDecodeParams ComputeVertexDecodeParams(span<const float> vertices, VertexComponent components, VertexEncoding encoding)
+{
+	VertexDecodeParams decodeParams{};
+
+	const StreamLayout layout = GetStreamLayout(components, VertexEncoding::None);
+	const size_t numVertices = layout.floatStride > 0 ? vertices.size() / layout.floatStride : 0;
+	if (numVertices == 0)
+	{
+		return decodeParams;
+	}
+
+	const bool hasPositionRange = HasFlag(components, VertexComponent::Position) &&
+		HasAnyFlag(encoding, VertexEncoding::PositionHalf | VertexEncoding::PositionUNorm16);
+
+	if (hasPositionRange)
+	{
+		// Position is always the first component
+		float minPosition[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maxPosition[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			const float* position = vertices.data() + i * layout.floatStride;
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				minPosition[j] = min(minPosition[j], position[j]);
+				maxPosition[j] = max(maxPosition[j], position[j]);
+			}
+		}
+
+		const bool isUNorm = HasFlag(encoding, VertexEncoding::PositionUNorm16);
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			if (isUNorm)
+			{
+				decodeParams.positionScale[j] = maxPosition[j] - minPosition[j];
+				decodeParams.positionOffset[j] = minPosition[j];
+			}
+			else
+			{
+				decodeParams.positionScale[j] = (maxPosition[j] - minPosition[j]) * 0.5f;
+				decodeParams.positionOffset[j] = (maxPosition[j] + minPosition[j]) * 0.5f;
+			}
+		}
+	}
+
+	if (HasFlag(encoding, VertexEncoding::TexcoordUNorm16))
+	{
+		float minTexcoord[2] = { FLT_MAX, FLT_MAX };
+		float maxTexcoord[2] = { -FLT_MAX, -FLT_MAX };
+		bool hasTexcoords = false;
+
+		for (const auto& element : layout.elements)
+		{
+			if (!IsTexcoord(element.component))
+			{
+				continue;
+			}
+
+			hasTexcoords = true;
+			for (size_t i = 0; i < numVertices; ++i)
+			{
+				const float* texcoord = vertices.data() + i * layout.floatStride + element.floatOffset;
+				for (uint32_t j = 0; j < 2; ++j)
+				{
+					minTexcoord[j] = min(minTexcoord[j], texcoord[j]);
+					maxTexcoord[j] = max(maxTexcoord[j], texcoord[j]);
+				}
+			}
+		}
+
+		if (hasTexcoords)
+		{
+			decodeParams.texcoordScaleOffset[0] = maxTexcoord[0] - minTexcoord[0];
+			decodeParams.texcoordScaleOffset[1] = maxTexcoord[1] - minTexcoord[1];
+			decodeParams.texcoordScaleOffset[2] = minTexcoord[0];
+			decodeParams.texcoordScaleOffset[3] = minTexcoord[1];
+		}
+	}
+
+	return decodeParams;
+}
+
+
+void EncodeVertices(span<const float> vertices, VertexComponent components, VertexEncoding encoding,
+	const VertexDecodeParams& decodeParams, vector<std::byte>& outVertices)
+{
+	ScopedEvent event("EncodeVertices");
+
+	const StreamLayout layout = GetStreamLayout(components, encoding);
+	assert(layout.floatStride > 0 && (vertices.size() % layout.floatStride) == 0);
+
+	const size_t numVertices = vertices.size() / layout.floatStride;
+	outVertices.resize(numVertices * layout.byteStride);
+
+	const float* positionScale = decodeParams.positionScale;
+	const float* positionOffset = decodeParams.positionOffset;
+	const float invPositionScale[3] = { SafeReciprocal(positionScale[0]), SafeReciprocal(positionScale[1]), SafeReciprocal(positionScale[2]) };
+
+	const float* texcoordScale = decodeParams.texcoordScaleOffset;
+	const float* texcoordOffset = decodeParams.texcoordScaleOffset + 2;
+	const float invTexcoordScale[2] = { SafeReciprocal(texcoordScale[0]), SafeReciprocal(texcoordScale[1]) };
+
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const float* src = vertices.data() + i * layout.floatStride;
+		std::byte* dest = outVertices.data() + i * layout.byteStride;
+
+		for (const auto& element : layout.elements)
+		{
+			const float* srcElement = src + element.floatOffset;
+			void* destElement = dest + element.byteOffset;
+
+			switch (element.format)
+			{
+			case Format::RGBA16_Float:
+			{
+				// Position, [-1, 1] across the bounds.  w is 1 so the shader can use xyzw directly.
+				uint16_t* packed = (uint16_t*)destElement;
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					packed[j] = PackHalf((srcElement[j] - positionOffset[j]) * invPositionScale[j]);
+				}
+				packed[3] = PackHalf(1.0f);
+
+#if _DEBUG
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					const float decoded = UnpackHalf(packed[j]) * positionScale[j] + positionOffset[j];
+					assert(IsWithinRangeError(decoded, srcElement[j], positionScale[j], s_halfStep));
+				}
+#endif // _DEBUG
+				break;
+			}
+
+			case Format::RGBA16_UNorm:
+			{
+				// Position, [0, 1] across the bounds
+				uint16_t* packed = (uint16_t*)destElement;
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					packed[j] = PackUNorm16((srcElement[j] - positionOffset[j]) * invPositionScale[j]);
+				}
+				packed[3] = PackUNorm16(1.0f);
+
+#if _DEBUG
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					const float decoded = UnpackUNorm16(packed[j]) * positionScale[j] + positionOffset[j];
+					assert(IsWithinRangeError(decoded, srcElement[j], positionScale[j], s_unorm16Step));
+				}
+#endif // _DEBUG
+				break;
+			}
+
+			case Format::RG16_SNorm:
+			{
+				// Normal or bitangent, octahedral
+				const Float3 unitVector = Normalize(LoadFloat3(srcElement));
+
+				float x, y;
+				EncodeOctahedral(unitVector, x, y);
+
+				int16_t* packed = (int16_t*)destElement;
+				packed[0] = PackSNorm16(x);
+				packed[1] = PackSNorm16(y);
+
+#if _DEBUG
+				const Float3 decoded = DecodeOctahedral(UnpackSNorm16(packed[0]), UnpackSNorm16(packed[1]));
+				assert(Dot(unitVector, unitVector) < 0.5f || Dot(decoded, unitVector) >= s_minOctahedralCosine);
+#endif // _DEBUG
+				break;
+			}
+
+			case Format::RGBA16_SNorm:
+			{
+				// Tangent, octahedral in xy with the bitangent sign in z
+				const Float3 tangent = Normalize(LoadFloat3(srcElement));
+
+				float handedness = 1.0f;
+				if (layout.normalOffset >= 0 && layout.bitangentOffset >= 0)
+				{
+					const Float3 normal = LoadFloat3(src + layout.normalOffset);
+					const Float3 bitangent = LoadFloat3(src + layout.bitangentOffset);
+					handedness = Dot(Cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+				}
+
+				float x, y;
+				EncodeOctahedral(tangent, x, y);
+
+				int16_t* packed = (int16_t*)destElement;
+				packed[0] = PackSNorm16(x);
+				packed[1] = PackSNorm16(y);
+				packed[2] = PackSNorm16(handedness);
+				packed[3] = 0;
+
+#if _DEBUG
+				const Float3 decoded = DecodeOctahedral(UnpackSNorm16(packed[0]), UnpackSNorm16(packed[1]));
+				assert(Dot(tangent, tangent) < 0.5f || Dot(decoded, tangent) >= s_minOctahedralCosine);
+#endif // _DEBUG
+				break;
+			}
+
+			case Format::RG16_Float:
+			{
+				uint16_t* packed = (uint16_t*)destElement;
+				packed[0] = PackHalf(srcElement[0]);
+				packed[1] = PackHalf(srcElement[1]);
+				break;
+			}
+
+			case Format::RG16_UNorm:
+			{
+				// Texcoord, [0, 1] across the mesh's texcoord range
+				uint16_t* packed = (uint16_t*)destElement;
+				for (uint32_t j = 0; j < 2; ++j)
+				{
+					packed[j] = PackUNorm16((srcElement[j] - texcoordOffset[j]) * invTexcoordScale[j]);
+				}
+
+#if _DEBUG
+				for (uint32_t j = 0; j < 2; ++j)
+				{
+					const float decoded = UnpackUNorm16(packed[j]) * texcoordScale[j] + texcoordOffset[j];
+					assert(IsWithinRangeError(decoded, srcElement[j], texcoordScale[j], s_unorm16Step));
+				}
+#endif // _DEBUG
+				break;
+			}
+
+			case Format::RGBA8_UNorm:
+			{
+				uint8_t* packed = (uint8_t*)destElement;
+				for (uint32_t j = 0; j < 4; ++j)
+				{
+					packed[j] = PackUNorm8(srcElement[j]);
+				}
+
+#if _DEBUG
+				for (uint32_t j = 0; j < 4; ++j)
+				{
+					assert(fabsf((float)packed[j] / 255.0f - Saturate(srcElement[j])) <= s_unorm8Step);
+				}
+#endif // _DEBUG
+				break;
+			}
+
+			default:
+				// Left as floats
+				memcpy(destElement, srcElement, element.numFloats * sizeof(float));
+				break;
+			}
+		}
+	}
+}
+
+
+void DecodePositions(span<const std::byte> vertices, uint32_t stride, VertexEncoding encoding,
+	const VertexDecodeParams& decodeParams, vector<float>& outPositions)
+{
+	assert(stride > 0 && (vertices.size() % stride) == 0);
+
+	const size_t numVertices = vertices.size() / stride;
+	outPositions.resize(numVertices * 3);
+
+	const Format format = GetVertexComponentFormat(VertexComponent::Position, encoding);
+
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		// Position is always the first component
+		const std::byte* src = vertices.data() + i * stride;
+		float* dest = outPositions.data() + i * 3;
+
+		switch (format)
+		{
+		case Format::RGBA16_Float:
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				dest[j] = UnpackHalf(((const uint16_t*)src)[j]) * decodeParams.positionScale[j] + decodeParams.positionOffset[j];
+			}
+			break;
+
+		case Format::RGBA16_UNorm:
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				dest[j] = UnpackUNorm16(((const uint16_t*)src)[j]) * decodeParams.positionScale[j] + decodeParams.positionOffset[j];
+			}
+			break;
+
+		default:
+			memcpy(dest, src, 3 * sizeof(float));
+			break;
+		}
+	}
+}
+
+} // namespace Luna
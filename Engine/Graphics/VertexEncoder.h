@@ -0,0 +1,38 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Graphics/InputLayout.h"
+
+
+namespace Luna
+{
+
+// The functions below take float vertex streams laid out as VertexLayout<components> would lay them out, i.e.
+// with VertexEncoding::None.
+
+// Range normalization for the position and texcoord encodings:  the position bounds, and the range spanned by
+// all the texcoord sets.  Identity for anything the encoding leaves as floats.
+VertexDecodeParams ComputeVertexDecodeParams(std::span<const float> vertices, VertexComponent components, VertexEncoding encoding);
+
+// Packs a float vertex stream into the given encoding, rounding halves and normalized values to nearest even.  The
+// output stride is the size of VertexLayout<components, encoding>.  Tangent handedness is taken from the normal and
+// bitangent, so it is only meaningful when the float stream has both.  Debug builds check every packed value against
+// the round-trip error bound of its encoding.
+void EncodeVertices(std::span<const float> vertices, VertexComponent components, VertexEncoding encoding,
+	const VertexDecodeParams& decodeParams, std::vector<std::byte>& outVertices);
+
+// Unpacks the positions of an encoded stream into three floats per vertex, e.g. to build meshlets from the
+// positions the GPU will actually see
+void DecodePositions(std::span<const std::byte> vertices, uint32_t stride, VertexEncoding encoding,
+	const VertexDecodeParams& decodeParams, std::vector<float>& outPositions);
+
+} // namespace Luna
@@ -12,10 +12,21 @@
 
 #include "ColorBufferVK.h"
 
+#include "DeviceManagerVK.h"
+
 
 namespace Luna::VK
 {
 
+ColorBuffer::~ColorBuffer()
+{
+	if (auto deviceManager = GetVulkanDeviceManager())
+	{
+		deviceManager->ReleaseImage(m_image.get());
+	}
+}
+
+
 const IDescriptor* ColorBuffer::GetUavDescriptor(uint32_t index) const noexcept
 {
 	assert(index == 0);
@@ -27,6 +27,8 @@ class ColorBuffer : public IColorBuffer
 	friend class Device;
 
 public:
+	~ColorBuffer() override;
+
 	const IDescriptor* GetSrvDescriptor() const noexcept override { return &m_srvDescriptor; }
 	const IDescriptor* GetRtvDescriptor() const noexcept override { return &m_rtvDescriptor; }
 	const IDescriptor* GetUavDescriptor(uint32_t index) const noexcept override;
@@ -195,7 +195,7 @@ void CommandContextVK::SetMarker(const string& label)
 void CommandContextVK::Reset()
 {
 	assert(m_commandBuffer == VK_NULL_HANDLE);
-	m_commandBuffer = GetVulkanDeviceManager()->GetQueue(m_commandListType).RequestCommandBuffer();
+	m_commandBuffer = GetVulkanDeviceManager()->GetQueue(m_commandListType).RequestCommandBuffer(m_commandBufferPool);
 
 	m_graphicsPipelineLayout = VK_NULL_HANDLE;
 	m_computePipelineLayout = VK_NULL_HANDLE;
@@ -225,7 +225,14 @@ void CommandContextVK::Reset()
 void CommandContextVK::Initialize()
 {
 	assert(m_commandBuffer == VK_NULL_HANDLE);
-	m_commandBuffer = GetVulkanDeviceManager()->GetQueue(m_commandListType).RequestCommandBuffer();
+
+	auto& queue = GetVulkanDeviceManager()->GetQueue(m_commandListType);
+
+	auto commandPool = queue.CreateCommandPool();
+	assert(commandPool);
+
+	m_commandBufferPool.Initialize(commandPool.get(), m_commandListType);
+	m_commandBuffer = queue.RequestCommandBuffer(m_commandBufferPool);
 }
 
 
@@ -240,15 +247,64 @@ uint64_t CommandContextVK::Finish(bool bWaitForCompletion)
 {
 	assert(m_commandListType == CommandListType::Graphics || m_commandListType == CommandListType::Compute);
 
-	FlushResourceBarriers();
+	PrepareForSubmit();
+
+	auto deviceManager = GetVulkanDeviceManager();
 
-	// TODO
-#if 0
-	if (m_ID.length() > 0)
+	auto& queue = deviceManager->GetQueue(m_commandListType);
+
+	uint64_t fenceValue = queue.ExecuteCommandList(m_commandBuffer);
+	ReleaseAfterSubmit(fenceValue);
+
+	if (bWaitForCompletion)
 	{
-		EngineProfiling::EndBlock(this);
+		queue.WaitForFence(fenceValue);
 	}
-#endif
+
+	return fenceValue;
+}
+
+
+uint64_t CommandContextVK::ExecuteChildren(span<ICommandContext* const> childContexts)
+{
+	assert(m_commandListType == CommandListType::Graphics || m_commandListType == CommandListType::Compute);
+
+	PrepareForSubmit();
+
+	vector<VkCommandBuffer> commandBuffers;
+	commandBuffers.reserve(childContexts.size() + 1);
+	commandBuffers.push_back(m_commandBuffer);
+
+	for (ICommandContext* childContext : childContexts)
+	{
+		CommandContextVK* childContextVK = (CommandContextVK*)childContext;
+		assert(childContextVK != nullptr && childContextVK->m_commandListType == m_commandListType);
+
+		childContextVK->PrepareForSubmit();
+		commandBuffers.push_back(childContextVK->m_commandBuffer);
+	}
+
+	auto& queue = GetVulkanDeviceManager()->GetQueue(m_commandListType);
+
+	uint64_t fenceValue = queue.ExecuteCommandLists(commandBuffers);
+
+	for (ICommandContext* childContext : childContexts)
+	{
+		((CommandContextVK*)childContext)->ReleaseAfterSubmit(fenceValue);
+	}
+	ReleaseAfterSubmit(fenceValue);
+
+	// Carry on recording into a new command buffer
+	Reset();
+	BeginFrame();
+
+	return fenceValue;
+}
+
+
+void CommandContextVK::PrepareForSubmit()
+{
+	FlushResourceBarriers();
 
 #if ENABLE_VULKAN_DEBUG_MARKERS
 	if (m_hasPendingDebugEvent)
@@ -259,13 +315,12 @@ uint64_t CommandContextVK::Finish(bool bWaitForCompletion)
 #endif
 
 	vkEndCommandBuffer(m_commandBuffer);
+}
 
-	auto deviceManager = GetVulkanDeviceManager();
-
-	auto& queue = deviceManager->GetQueue(m_commandListType);
 
-	uint64_t fenceValue = queue.ExecuteCommandList(m_commandBuffer);
-	queue.DiscardCommandBuffer(fenceValue, m_commandBuffer);
+void CommandContextVK::ReleaseAfterSubmit(uint64_t fenceValue)
+{
+	m_commandBufferPool.DiscardCommandBuffer(fenceValue, m_commandBuffer);
 	m_commandBuffer = VK_NULL_HANDLE;
 
 	// Recycle dynamic allocations
@@ -279,20 +334,11 @@ uint64_t CommandContextVK::Finish(bool bWaitForCompletion)
 #endif // USE_LEGACY_DESCRIPTOR_SETS
 
 	m_cpuLinearAllocator.CleanupUsedPages(fenceValue);
-
-	if (bWaitForCompletion)
-	{
-		queue.WaitForFence(fenceValue);
-	}
-
-	return fenceValue;
 }
 
 
 void CommandContextVK::TransitionResource(IColorBuffer* colorBuffer, ResourceState newState, bool bFlushImmediate)
 {
-	BeginEvent("TransitionResource");
-
 	// TODO: Try this with GetPlatformObject()
 	ColorBuffer* colorBufferVK = (ColorBuffer*)colorBuffer;
 	assert(colorBufferVK != nullptr);
@@ -318,15 +364,11 @@ void CommandContextVK::TransitionResource(IColorBuffer* colorBuffer, ResourceSta
 	{
 		FlushResourceBarriers();
 	}
-
-	EndEvent();
 }
 
 
 void CommandContextVK::TransitionResource(IDepthBuffer* depthBuffer, ResourceState newState, bool bFlushImmediate)
 {
-	BeginEvent("TransitionResource");
-
 	// TODO: Try this with GetPlatformObject()
 	DepthBuffer* depthBufferVK = (DepthBuffer*)depthBuffer;
 	assert(depthBufferVK != nullptr);
@@ -352,15 +394,11 @@ void CommandContextVK::TransitionResource(IDepthBuffer* depthBuffer, ResourceSta
 	{
 		FlushResourceBarriers();
 	}
-
-	EndEvent();
 }
 
 
 void CommandContextVK::TransitionResource(IGpuBuffer* gpuBuffer, ResourceState newState, bool bFlushImmediate)
 {
-	BeginEvent("TransitionResource");
-
 	// TODO: Try this with GetPlatformObject()
 	GpuBuffer* gpuBufferVK = (GpuBuffer*)gpuBuffer;
 	assert(gpuBufferVK != nullptr);
@@ -380,15 +418,11 @@ void CommandContextVK::TransitionResource(IGpuBuffer* gpuBuffer, ResourceState n
 	{
 		FlushResourceBarriers();
 	}
-
-	EndEvent();
 }
 
 
 void CommandContextVK::TransitionResource(ITexture* texture, ResourceState newState, bool bFlushImmediate)
 {
-	BeginEvent("TransitionResource");
-
 	// TODO: Try this with GetPlatformObject()
 	Texture* textureVK = (Texture*)texture;
 	assert(textureVK != nullptr);
@@ -417,8 +451,6 @@ void CommandContextVK::TransitionResource(ITexture* texture, ResourceState newSt
 	{
 		FlushResourceBarriers();
 	}
-
-	EndEvent();
 }
 
 
@@ -474,6 +506,18 @@ void CommandContextVK::InsertUAVBarrier(const IGpuBuffer* gpuBuffer, bool bFlush
 }
 
 
+void CommandContextVK::EndResourceTransition(IColorBuffer* colorBuffer, ResourceState newState)
+{
+	TransitionResource(colorBuffer, newState, false);
+}
+
+
+void CommandContextVK::EndResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState)
+{
+	TransitionResource(depthBuffer, newState, false);
+}
+
+
 void CommandContextVK::FlushResourceBarriers()
 {
 	BeginEvent("FlushResourceBarriers");
@@ -787,6 +831,13 @@ void CommandContextVK::EndQuery(const IQueryHeap* queryHeap, uint32_t heapIndex)
 	const QueryHeap* queryHeapVK = (const QueryHeap*)queryHeap;
 	assert(queryHeapVK != nullptr);
 
+	// Timestamps have no begin, matching ID3D12GraphicsCommandList::EndQuery
+	if (queryHeap->GetType() == QueryHeapType::Timestamp)
+	{
+		vkCmdWriteTimestamp2(m_commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, queryHeapVK->GetQueryPool(), heapIndex);
+		return;
+	}
+
 	vkCmdEndQuery(m_commandBuffer, queryHeapVK->GetQueryPool(), heapIndex);
 }
 
@@ -1251,6 +1302,9 @@ void CommandContextVK::SetResources(CommandListType type, ResourceSet& resourceS
 {
 	BeginEvent("SetResources");
 
+	// Held until the descriptor sets are bound, in case another thread is resolving the same set
+	auto pendingTextureLock = resourceSet.ResolvePendingTextures();
+
 	const uint32_t numDescriptorSets = resourceSet.GetNumDescriptorSets();
 	for (uint32_t i = 0; i < numDescriptorSets; ++i)
 	{
@@ -1754,8 +1808,19 @@ void CommandContextVK::InitializeTexture_Internal(ITexture* destTexture, const T
 		bufferCopyRegions[i] = TextureSubResourceDataToVulkan(texInit.subResourceData[i], VK_IMAGE_ASPECT_COLOR_BIT);
 	}
 
+	// The source can be a file mapping that ends right at totalBytes, so the copy must not round up past it.
+	// DDS data also starts just after the header, which is not 16-byte aligned.
 	DynAlloc dynAlloc = ReserveUploadMemory(texInit.totalBytes);
-	SIMDMemCopy(dynAlloc.dataPtr, texInit.baseData, Math::DivideByMultiple(texInit.totalBytes, 16));
+	if (Math::IsAligned(texInit.baseData, 16))
+	{
+		const size_t numQuadwords = texInit.totalBytes / 16;
+		SIMDMemCopy(dynAlloc.dataPtr, texInit.baseData, numQuadwords);
+		memcpy((std::byte*)dynAlloc.dataPtr + numQuadwords * 16, texInit.baseData + numQuadwords * 16, texInit.totalBytes % 16);
+	}
+	else
+	{
+		memcpy(dynAlloc.dataPtr, texInit.baseData, texInit.totalBytes);
+	}
 
 	// TODO: Try this with GetPlatformObject()
 	Texture* textureVK = (Texture*)destTexture;
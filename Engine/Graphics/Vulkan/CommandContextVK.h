@@ -12,6 +12,7 @@
 
 #include "Graphics\CommandContext.h"
 #include "Graphics\Vulkan\VulkanCommon.h"
+#include "Graphics\Vulkan\CommandBufferPoolVK.h"
 #include "Graphics\Vulkan\DynamicDescriptorHeapVK.h"
 #include "Graphics\Vulkan\LinearAllocatorVK.h"
 
@@ -74,6 +75,7 @@ public:
 
 	void BeginFrame() override;
 	uint64_t Finish(bool bWaitForCompletion) override;
+	uint64_t ExecuteChildren(std::span<ICommandContext* const> childContexts) override;
 
 	void TransitionResource(IColorBuffer* colorBuffer, ResourceState newState, bool bFlushImmediate) override;
 	void TransitionResource(IDepthBuffer* depthBuffer, ResourceState newSTate, bool bFlushImmediate) override;
@@ -81,6 +83,11 @@ public:
 	void TransitionResource(ITexture* texture, ResourceState newState, bool bFlushImmediate) override;
 	void InsertUAVBarrier(const IColorBuffer* colorBuffer, bool bFlushImmediate) override;
 	void InsertUAVBarrier(const IGpuBuffer* gpuBuffer, bool bFlushImmediate) override;
+	// Vulkan could split these with events.  For now the whole transition happens in EndResourceTransition().
+	void BeginResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) override {}
+	void BeginResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) override {}
+	void EndResourceTransition(IColorBuffer* colorBuffer, ResourceState newState) override;
+	void EndResourceTransition(IDepthBuffer* depthBuffer, ResourceState newState) override;
 	void FlushResourceBarriers() override;
 
 	DynAlloc ReserveUploadMemory(size_t sizeInBytes) override;
@@ -200,6 +207,9 @@ private:
 	void BeginRenderingBlock();
 	void ResetRenderTargets();
 
+	void PrepareForSubmit();
+	void ReleaseAfterSubmit(uint64_t fenceValue);
+
 	void ParseRootSignature(CommandListType type);
 	void MarkDescriptorsDirty(CommandListType type);
 	bool HasDirtyDescriptors(CommandListType type);
@@ -226,6 +236,8 @@ private:
 	DynamicDescriptorSet m_dynamicDescriptorSet;
 #endif // USE_LEGACY_DESCRIPTOR_SETS
 
+	// Each context records from its own command pool, so contexts can record on different threads
+	CommandBufferPool m_commandBufferPool;
 	VkCommandBuffer m_commandBuffer{ VK_NULL_HANDLE };
 
 	bool m_bInvertedViewport{ true };
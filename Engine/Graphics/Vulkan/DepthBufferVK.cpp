@@ -12,10 +12,21 @@
 
 #include "DepthBufferVK.h"
 
+#include "DeviceManagerVK.h"
+
 
 namespace Luna::VK
 {
 
+DepthBuffer::~DepthBuffer()
+{
+	if (auto deviceManager = GetVulkanDeviceManager())
+	{
+		deviceManager->ReleaseImage(m_image.get());
+	}
+}
+
+
 const IDescriptor* DepthBuffer::GetDsvDescriptor(DepthStencilAspect depthStencilAspect) const noexcept
 { 
 	switch (depthStencilAspect)
@@ -26,6 +26,8 @@ class DepthBuffer : public IDepthBuffer
 	friend class Device;
 
 public:
+	~DepthBuffer() override;
+
 	const IDescriptor* GetDsvDescriptor(DepthStencilAspect aspect) const noexcept override;
 	const IDescriptor* GetSrvDescriptor(bool depthSrv) const noexcept override;
 
@@ -16,6 +16,7 @@
 #include "DepthBufferVK.h"
 #include "DescriptorVK.h"
 #include "DeviceVK.h"
+#include "DeviceManagerVK.h"
 #include "GpuBufferVK.h"
 #include "SamplerVK.h"
 #include "TextureVK.h"
@@ -62,6 +63,9 @@ void DescriptorSet::SetSRV(uint32_t srvRegister, GpuBufferPtr gpuBuffer)
 
 void DescriptorSet::SetSRV(uint32_t srvRegister, TexturePtr texture)
 {
+	// Descriptor sets are not revisited once written, so this needs the real texture
+	texture->WaitForLoad();
+
 	const auto descriptor = (const Descriptor*)texture->GetDescriptor();
 	descriptor->CopyRawDescriptor((void*)(m_allocation.mem + GetRegisterOffsetSRV(srvRegister)));
 }
@@ -101,6 +105,15 @@ void DescriptorSet::SetSampler(uint32_t samplerRegister, SamplerPtr sampler)
 }
 
 
+void DescriptorSet::Rename()
+{
+	// The descriptor buffer allocator never frees, so the old range is left as it is
+	DescriptorBufferAllocation allocation = AllocateDescriptorBufferMemory(DescriptorBufferType::Resource, m_layout->GetDescriptorSetLayout()->Get());
+	memcpy(allocation.mem, m_allocation.mem, m_layout->GetDescriptorSetSize());
+	m_allocation = allocation;
+}
+
+
 size_t DescriptorSet::GetDescriptorBufferOffset() const
 {
 	return m_allocation.offset;
@@ -194,6 +207,9 @@ void DescriptorSet::SetSRV(uint32_t srvRegister, GpuBufferPtr gpuBuffer)
 
 void DescriptorSet::SetSRV(uint32_t srvRegister, TexturePtr texture)
 {
+	// Descriptor sets are not revisited once written, so this needs the real texture
+	texture->WaitForLoad();
+
 	const Texture* textureVK = (const Texture*)texture.Get();
 	assert(textureVK != nullptr);
 
@@ -334,6 +350,25 @@ void DescriptorSet::SetSampler(uint32_t samplerRegister, SamplerPtr sampler)
 }
 
 
+void DescriptorSet::Rename()
+{
+	if (m_descriptorSet == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	VkDescriptorSet oldDescriptorSet = m_descriptorSet;
+	m_descriptorSet = m_device->CopyDescriptorSet(oldDescriptorSet, m_descriptorSetLayout, m_rootParameter);
+
+	// Submitted work, and work still being recorded, may read the old set until the next graphics fence.
+	// Anything renamed after the device manager is gone is never freed.
+	auto deviceManager = GetVulkanDeviceManager();
+	const uint64_t fenceValue = deviceManager ? deviceManager->GetQueue(QueueType::Graphics).GetNextFenceValue() : UINT64_MAX;
+
+	m_device->FreeDescriptorSet(oldDescriptorSet, m_descriptorSetLayout, fenceValue);
+}
+
+
 bool DescriptorSet::HasDescriptors() const
 {
 	return (m_numDescriptors != 0);
@@ -48,6 +48,8 @@ public:
 
 	void SetSampler(uint32_t samplerRegister, SamplerPtr sampler) override;
 
+	void Rename() override;
+
 #if USE_DESCRIPTOR_BUFFERS
 	size_t GetDescriptorBufferOffset() const;
 #endif // USE_DESCRIPTOR_BUFFERS
@@ -91,6 +93,7 @@ protected:
 
 #if USE_LEGACY_DESCRIPTOR_SETS
 	VkDescriptorSet m_descriptorSet{ VK_NULL_HANDLE };
+	VkDescriptorSetLayout m_descriptorSetLayout{ VK_NULL_HANDLE };
 	uint32_t m_numDescriptors{ 0 };
 #endif // USE_LEGACY_DESCRIPTOR_SETS
 };
@@ -12,6 +12,7 @@
 
 #include "DescriptorVK.h"
 
+#include "DeviceManagerVK.h"
 #include "DeviceVK.h"
 
 
@@ -24,6 +25,41 @@ Descriptor::Descriptor()
 }
 
 
+Descriptor::~Descriptor()
+{
+	// The views share storage, so only the one that was set gets released.  The GPU may still be reading
+	// descriptors that point at it, so it goes through the deferred release queue.
+	auto deviceManager = GetVulkanDeviceManager();
+
+	switch (m_descriptorClass)
+	{
+	case DescriptorClass::Buffer:
+		if (deviceManager)
+		{
+			deviceManager->ReleaseObject(m_bufferView.get());
+		}
+		std::destroy_at(&m_bufferView);
+		break;
+
+	case DescriptorClass::Sampler:
+		if (deviceManager)
+		{
+			deviceManager->ReleaseObject(m_sampler.get());
+		}
+		std::destroy_at(&m_sampler);
+		break;
+
+	default:
+		if (deviceManager)
+		{
+			deviceManager->ReleaseObject(m_imageView.get());
+		}
+		std::destroy_at(&m_imageView);
+		break;
+	}
+}
+
+
 VkImage Descriptor::GetImage() const
 {
 	if (m_image)
@@ -25,7 +25,7 @@ class Descriptor : public IDescriptor
 {
 public:
 	Descriptor();
-	~Descriptor() override {}
+	~Descriptor() override;
 
 	DescriptorClass GetDescriptorClass() const noexcept { return m_descriptorClass; }
 
@@ -106,6 +106,7 @@ VkBool32 DebugMessageCallback(
 
 DeviceManager::DeviceManager(const DeviceManagerDesc& desc)
 	: m_desc{ desc }
+	, m_contextPool{ [this](CommandListType type) -> ICommandContext* { return new CommandContextVK(m_vkDevice.get(), type); } }
 {
 	m_bIsDeveloperModeEnabled = IsDeveloperModeEnabled();
 	m_bIsRenderDocAvailable = IsRenderDocAvailable();
@@ -113,6 +114,10 @@ DeviceManager::DeviceManager(const DeviceManagerDesc& desc)
 	// Can't use the validation layer if the application is launched through RenderDoc
 	m_desc.enableValidation = m_bIsRenderDocAvailable ? false : desc.enableValidation;
 
+#if USE_DESCRIPTOR_BUFFERS
+	DynamicDescriptorBuffer::EnableTableCache(desc.enableDescriptorTableCache);
+#endif // USE_DESCRIPTOR_BUFFERS
+
 	extern Luna::IDeviceManager* g_deviceManager;
 	assert(!g_deviceManager);
 
@@ -123,13 +128,39 @@ DeviceManager::DeviceManager(const DeviceManagerDesc& desc)
 
 DeviceManager::~DeviceManager()
 {
+	// Streaming textures record their uploads, so let them finish first
+	if (m_textureManager)
+	{
+		m_textureManager->WaitForAsyncLoads();
+	}
+
+	if (m_uploadQueue)
+	{
+		m_uploadQueue->Flush();
+	}
+
 	WaitForGpu();
 
-	// Flush pending deferred resources here
+	// Release the resources still referenced by in-flight upload batches
+	m_uploadQueue.reset();
+
+	// The GPU is idle, so everything still pending can go, whatever fence it was waiting on
 	ReleaseDeferredResources();
-	assert(m_deferredResources.empty());
+	m_deferredReleaseQueue.RetireAll();
+	assert(m_deferredReleaseQueue.IsEmpty());
+
+	const DeferredReleaseStats releaseStats = m_deferredReleaseQueue.GetStats();
+	LogInfo(LogVulkan) << format("Deferred release: {} objects released, at most {} pending at once",
+		releaseStats.numReleasedObjects, releaseStats.maxPendingObjects) << endl;
+
+	if (m_device)
+	{
+		m_device->SavePipelineCache();
+		m_device->LogStateObjectCacheStats();
+	}
 
 #if USE_DESCRIPTOR_BUFFERS
+	DynamicDescriptorBuffer::LogTableCacheStats();
 	DescriptorBufferAllocator::DestroyAll();
 	DynamicDescriptorBuffer::DestroyAll();
 #endif // USE_DESCRIPTOR_BUFFERS
@@ -301,6 +332,8 @@ void DeviceManager::CreateDeviceResources()
 
 	m_device->GetDeviceCaps().LogCaps();
 
+	m_device->LoadPipelineCache();
+
 	// Create queues
 	CreateQueue(QueueType::Graphics);
 	CreateQueue(QueueType::Compute);
@@ -425,40 +458,13 @@ void DeviceManager::CreateWindowSizeDependentResources()
 
 CommandContext* DeviceManager::AllocateContext(CommandListType commandListType)
 {
-	lock_guard<mutex> lockGuard(m_contextAllocationMutex);
-
-	ScopedEvent event("AllocateContext");
-
-	auto& availableContexts = m_availableContexts[(uint32_t)commandListType];
-
-	CommandContext* ret{ nullptr };
-	if (availableContexts.empty())
-	{
-		ICommandContext* contextImpl = new CommandContextVK(m_vkDevice.get(), commandListType);
-		ret = new CommandContext(contextImpl);
-
-		m_contextPool[(uint32_t)commandListType].emplace_back(ret);
-		ret->Initialize();
-	}
-	else
-	{
-		ret = availableContexts.front();
-		availableContexts.pop();
-		ret->Reset();
-	}
-
-	assert(ret != nullptr);
-	assert(ret->GetType() == commandListType);
-
-	return ret;
+	return m_contextPool.Allocate(commandListType);
 }
 
 
 void DeviceManager::FreeContext(CommandContext* usedContext)
 {
-	lock_guard<mutex> guard{ m_contextAllocationMutex };
-
-	m_availableContexts[(uint32_t)usedContext->GetType()].push(usedContext);
+	m_contextPool.Free(usedContext);
 }
 
 
@@ -492,25 +498,22 @@ IDevice* DeviceManager::GetDevice()
 }
 
 
-void DeviceManager::ReleaseImage(CVkImage* image)
+void DeviceManager::ReleaseObject(IUnknown* object)
 {
-	lock_guard lock(m_deferredReleaseMutex);
-
-	uint64_t nextFence = GetQueue(QueueType::Graphics).GetNextFenceValue();
+	// Nothing can be in flight before the queues exist, and the caller's reference destroys the object right away
+	if (!m_queues[(uint32_t)QueueType::Graphics])
+	{
+		return;
+	}
 
-	DeferredReleaseResource resource{ nextFence, image, nullptr };
-	m_deferredResources.emplace_back(resource);
+	ReleaseObject(object, GetQueue(QueueType::Graphics).GetNextFenceValue());
 }
 
 
-void DeviceManager::ReleaseBuffer(CVkBuffer* buffer)
+void DeviceManager::ReleaseObject(IUnknown* object, uint64_t fenceValue)
 {
-	lock_guard lock(m_deferredReleaseMutex);
-
-	uint64_t nextFence = GetQueue(QueueType::Graphics).GetNextFenceValue();
-
-	DeferredReleaseResource resource{ nextFence, nullptr, buffer };
-	m_deferredResources.emplace_back(resource);
+	// Fence values carry their queue in the top byte
+	m_deferredReleaseQueue.Release((uint32_t)(fenceValue >> 56), fenceValue, object);
 }
 
 
@@ -1535,6 +1538,7 @@ void DeviceManager::CreateDevice()
 	m_device = std::make_unique<Device>(m_vkDevice.get(), m_vmaAllocator.get(), m_caps);
 
 	m_textureManager = std::make_unique<TextureManager>(m_device.get());
+	m_uploadQueue = std::make_unique<UploadQueue>();
 }
 
 
@@ -1600,8 +1604,11 @@ void DeviceManager::ResizeSwapChain()
 {
 	WaitForGpu();
 
-	m_vkSwapChain.reset();
+	// Views of the swap chain images have to go before the swap chain does
 	m_swapChainBuffers.clear();
+	m_deferredReleaseQueue.RetireAll();
+
+	m_vkSwapChain.reset();
 
 	CreateWindowSizeDependentResources();
 }
@@ -1634,20 +1641,17 @@ void DeviceManager::QueueSignalSemaphore(QueueType queueType, SemaphorePtr semap
 
 void DeviceManager::ReleaseDeferredResources()
 {
-	lock_guard lock(m_deferredReleaseMutex);
+	for (uint32_t i = 0; i < (uint32_t)QueueType::Count; ++i)
+	{
+		m_deferredReleaseQueue.Retire(i, GetQueue((QueueType)i).GetCompletedFenceValue());
+	}
 
-	auto resourceIt = m_deferredResources.begin();
-	while (resourceIt != m_deferredResources.end())
+#if USE_LEGACY_DESCRIPTOR_SETS
+	if (m_device)
 	{
-		if (GetQueue(QueueType::Graphics).IsFenceComplete(resourceIt->fenceValue))
-		{
-			resourceIt = m_deferredResources.erase(resourceIt);
-		}
-		else
-		{
-			++resourceIt;
-		}
+		m_device->ReclaimDescriptorSets(GetQueue(QueueType::Graphics).GetCompletedFenceValue());
 	}
+#endif // USE_LEGACY_DESCRIPTOR_SETS
 }
 
 
@@ -11,9 +11,12 @@
 #pragma once
 
 #include "Graphics\ColorBuffer.h"
+#include "Graphics\CommandContextPool.h"
+#include "Graphics\DeferredReleaseQueue.h"
 #include "Graphics\DeviceCaps.h"
 #include "Graphics\DeviceManager.h"
 #include "Graphics\Texture.h"
+#include "Graphics\UploadQueue.h"
 #include "Graphics\Vulkan\VulkanCommon.h"
 
 using namespace Microsoft::WRL;
@@ -106,8 +109,8 @@ public:
 	void Present() final;
 
 	void WaitForGpu() final;
-	void WaitForFence(uint64_t fenceValue);
-	bool IsFenceComplete(uint64_t fenceValue);
+	void WaitForFence(uint64_t fenceValue) final;
+	bool IsFenceComplete(uint64_t fenceValue) final;
 
 	void SetWindowSize(uint32_t width, uint32_t height) final;
 	void CreateDeviceResources() final;
@@ -131,8 +134,12 @@ public:
 
 	IDevice* GetDevice() override;
 
-	void ReleaseImage(CVkImage* image);
-	void ReleaseBuffer(CVkBuffer* buffer);
+	// Deferred release.  Objects are held until the GPU is done with them, which is the next fence on the graphics
+	// queue unless a fence value is given.
+	void ReleaseImage(CVkImage* image) { ReleaseObject(image); }
+	void ReleaseBuffer(CVkBuffer* buffer) { ReleaseObject(buffer); }
+	void ReleaseObject(IUnknown* object);
+	void ReleaseObject(IUnknown* object, uint64_t fenceValue);
 
 	CVkDevice* GetVulkanDevice() const;
 	CVmaAllocator* GetAllocator() const;
@@ -194,6 +201,9 @@ private:
 	// Texture manager
 	std::unique_ptr<TextureManager> m_textureManager;
 
+	// Batched resource initialization
+	std::unique_ptr<UploadQueue> m_uploadQueue;
+
 	// Swapchain
 	wil::com_ptr<CVkSwapchain> m_vkSwapChain;
 	uint32_t m_swapChainIndex{ (uint32_t)-1 };
@@ -216,19 +226,10 @@ private:
 	uint32_t m_activeFrame{ 0 };
 
 	// Command context handling
-	std::mutex m_contextAllocationMutex;
-	std::vector<std::unique_ptr<CommandContext>> m_contextPool[4];
-	std::queue<CommandContext*> m_availableContexts[4];
-
-	// Deferred resource release
-	std::mutex m_deferredReleaseMutex;
-	struct DeferredReleaseResource
-	{
-		uint64_t fenceValue;
-		wil::com_ptr<CVkImage> image;
-		wil::com_ptr<CVkBuffer> buffer;
-	};
-	std::list<DeferredReleaseResource> m_deferredResources;
+	CommandContextPool m_contextPool;
+
+	// Deferred resource release, one ring of fence buckets per queue
+	DeferredReleaseQueue m_deferredReleaseQueue{ (uint32_t)QueueType::Count };
 };
 
 
@@ -109,8 +109,6 @@ Device::Device(CVkDevice* device, CVmaAllocator* allocator, const Luna::DeviceCa
 	, m_allocator{ allocator }
 	, m_caps{ caps }
 {
-	m_pipelineCache = CreatePipelineCache();
-
 	assert(g_vulkanDevice == nullptr);
 	g_vulkanDevice = this;
 }
@@ -426,7 +424,9 @@ RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignat
 	vector<pair<uint32_t, RootParameter>> pushDescriptorRootParameters;
 	unordered_map<uint32_t, uint32_t> pushDescriptorBindingMap;
 
-	size_t hashCode = Utility::g_hashStart;
+	// Everything the pipeline layout depends on, in root parameter order.  Descriptor set layouts are appended by
+	// what they are built from, since each root signature creates its own.
+	StateObjectKey key;
 	size_t resourceDescriptorSetLayoutSize = 0;
 	size_t samplerDescriptorSetLayoutSize = 0;
 
@@ -439,6 +439,8 @@ RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignat
 
 		DescriptorSetLayoutPtr descriptorSetLayout;
 
+		key.Append(rootParameter.parameterType);
+
 		// Push constants
 		if (rootParameter.parameterType == RootParameterType::RootConstants)
 		{
@@ -448,7 +450,7 @@ RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignat
 			vkPushConstantRange.stageFlags = shaderStageFlags;
 			pushConstantOffset += rootParameter.num32BitConstants * 4;
 
-			hashCode = Utility::HashState(&vkPushConstantRange, 1, hashCode);
+			key.Append(vkPushConstantRange);
 
 			auto emptySetLayout = GetOrCreateEmptyDescriptorSetLayout();
 			vkDescriptorSetLayouts[rootParamIndex] = emptySetLayout->GetDescriptorSetLayout()->Get();
@@ -475,7 +477,16 @@ RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignat
 		{
 			descriptorSetLayout = CreateDescriptorSetLayout(rootParameter);
 
-			hashCode = Utility::HashMerge(hashCode, descriptorSetLayout->GetHashCode());
+			key.Append(rootParameter.shaderVisibility);
+			key.Append((uint32_t)rootParameter.table.size());
+			for (const auto& range : rootParameter.table)
+			{
+				key.Append(range.descriptorType);
+				key.Append(range.startRegister);
+				key.Append(range.numDescriptors);
+				key.Append(range.flags);
+			}
+
 			if (rootParameter.IsSamplerTable())
 			{
 				samplerDescriptorSetLayoutSize += descriptorSetLayout->GetDescriptorSetSize();
@@ -542,7 +553,9 @@ RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignat
 
 			vkLayoutBindings.push_back(vkBinding);
 
-			hashCode = Utility::HashState(&vkBinding, 1, hashCode);
+			// The samplers are cached, so their handles identify them
+			key.Append(vkBinding.binding);
+			key.Append(*vkBinding.pImmutableSamplers);
 		}
 
 		// Create the descriptor set layout for the static samplers
@@ -593,7 +606,7 @@ RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignat
 			};
 			vkLayoutBindings.push_back(vkBinding);
 
-			hashCode = Utility::HashState(&vkBinding, 1, hashCode);
+			key.Append(vkBinding);
 		}
 
 		// Create the descriptor set layout for the push descriptors
@@ -620,54 +633,21 @@ RootSignaturePtr Device::CreateRootSignature(const RootSignatureDesc& rootSignat
 	}
 
 	// Finally, create the VkPipelineLayout
-	CVkPipelineLayout** pipelineLayoutRef = nullptr;
-	bool firstCompile = false;
-	{
-		lock_guard<mutex> CS(m_pipelineLayoutMutex);
-
-		auto iter = m_pipelineLayoutHashMap.find(hashCode);
-
-		// Reserve space so the next inquiry will find that someone got here first.
-		if (iter == m_pipelineLayoutHashMap.end())
-		{
-			pipelineLayoutRef = m_pipelineLayoutHashMap[hashCode].addressof();
-			firstCompile = true;
-		}
-		else
+	auto pPipelineLayout = m_pipelineLayoutCache.FindOrCreate(key, [&]
 		{
-			pipelineLayoutRef = iter->second.addressof();
-		}
-	}
-
-	wil::com_ptr<CVkPipelineLayout> pPipelineLayout;
-
-	if (firstCompile)
-	{
-		VkPipelineLayoutCreateInfo createInfo{
-			.sType						= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-			.setLayoutCount				= (uint32_t)vkDescriptorSetLayouts.size(),
-			.pSetLayouts				= vkDescriptorSetLayouts.data(),
-			.pushConstantRangeCount		= (uint32_t)vkPushConstantRanges.size(),
-			.pPushConstantRanges		= vkPushConstantRanges.data()
-		};
-
-		VkPipelineLayout vkPipelineLayout{ VK_NULL_HANDLE };
-		vkCreatePipelineLayout(*m_device, &createInfo, nullptr, &vkPipelineLayout);
-
-		pPipelineLayout = Create<CVkPipelineLayout>(m_device.get(), vkPipelineLayout);
+			VkPipelineLayoutCreateInfo createInfo{
+				.sType						= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+				.setLayoutCount				= (uint32_t)vkDescriptorSetLayouts.size(),
+				.pSetLayouts				= vkDescriptorSetLayouts.data(),
+				.pushConstantRangeCount		= (uint32_t)vkPushConstantRanges.size(),
+				.pPushConstantRanges		= vkPushConstantRanges.data()
+			};
 
-		m_pipelineLayoutHashMap[hashCode] = pPipelineLayout;
+			VkPipelineLayout vkPipelineLayout{ VK_NULL_HANDLE };
+			vkCreatePipelineLayout(*m_device, &createInfo, nullptr, &vkPipelineLayout);
 
-		assert(*pipelineLayoutRef == pPipelineLayout);
-	}
-	else
-	{
-		while (*pipelineLayoutRef == nullptr)
-		{
-			this_thread::yield();
-		}
-		pPipelineLayout = *pipelineLayoutRef;
-	}
+			return Create<CVkPipelineLayout>(m_device.get(), vkPipelineLayout);
+		});
 
 	auto rootSignature = std::make_shared<RootSignature>();
 
@@ -819,9 +799,17 @@ GraphicsPipelinePtr Device::CreateGraphicsPipeline(const GraphicsPipelineDesc& p
 	VkPipelineCreateFlags flags{};
 #endif // USE_LEGACY_DESCRIPTOR_SETS
 	
+	// Creation feedback, to tell whether the pipeline cache had the pipeline
+	VkPipelineCreationFeedback creationFeedback{};
+	VkPipelineCreationFeedbackCreateInfo creationFeedbackInfo{
+		.sType						= VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+		.pNext						= &dynamicRenderingInfo,
+		.pPipelineCreationFeedback	= &creationFeedback
+	};
+
 	VkGraphicsPipelineCreateInfo pipelineCreateInfo{
 		.sType					= VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-		.pNext					= &dynamicRenderingInfo,
+		.pNext					= &creationFeedbackInfo,
 		.flags					= flags,
 		.stageCount				= (uint32_t)shaderStages.size(),
 		.pStages				= shaderStages.data(),
@@ -846,6 +834,7 @@ GraphicsPipelinePtr Device::CreateGraphicsPipeline(const GraphicsPipelineDesc& p
 	if (VK_SUCCEEDED(vkCreateGraphicsPipelines(*m_device, *m_pipelineCache, 1, &pipelineCreateInfo, nullptr, &vkPipeline)))
 	{
 		pipeline = Create<CVkPipeline>(m_device.get(), vkPipeline);
+		RecordPipelineCacheFeedback(creationFeedback);
 	}
 	else
 	{
@@ -884,9 +873,16 @@ ComputePipelinePtr Device::CreateComputePipeline(const ComputePipelineDesc& pipe
 	VkPipelineCreateFlags flags{};
 #endif // USE_LEGACY_DESCRIPTOR_SETS
 
+	// Creation feedback, to tell whether the pipeline cache had the pipeline
+	VkPipelineCreationFeedback creationFeedback{};
+	VkPipelineCreationFeedbackCreateInfo creationFeedbackInfo{
+		.sType						= VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+		.pPipelineCreationFeedback	= &creationFeedback
+	};
+
 	VkComputePipelineCreateInfo pipelineCreateInfo{
 		.sType					= VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-		.pNext					= nullptr,
+		.pNext					= &creationFeedbackInfo,
 		.flags					= flags,
 		.stage					= shaderStage,
 		.layout					= rootSignature->GetPipelineLayout(),
@@ -899,6 +895,7 @@ ComputePipelinePtr Device::CreateComputePipeline(const ComputePipelineDesc& pipe
 	if (VK_SUCCEEDED(vkCreateComputePipelines(*m_device, *m_pipelineCache, 1, &pipelineCreateInfo, nullptr, &vkPipeline)))
 	{
 		pipeline = Create<CVkPipeline>(m_device.get(), vkPipeline);
+		RecordPipelineCacheFeedback(creationFeedback);
 	}
 	else
 	{
@@ -981,9 +978,17 @@ MeshletPipelinePtr Device::CreateMeshletPipeline(const MeshletPipelineDesc& pipe
 	VkPipelineCreateFlags flags{};
 #endif // USE_LEGACY_DESCRIPTOR_SETS
 	
+	// Creation feedback, to tell whether the pipeline cache had the pipeline
+	VkPipelineCreationFeedback creationFeedback{};
+	VkPipelineCreationFeedbackCreateInfo creationFeedbackInfo{
+		.sType						= VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+		.pNext						= &dynamicRenderingInfo,
+		.pPipelineCreationFeedback	= &creationFeedback
+	};
+
 	VkGraphicsPipelineCreateInfo pipelineCreateInfo{
 		.sType					= VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-		.pNext					= &dynamicRenderingInfo,
+		.pNext					= &creationFeedbackInfo,
 		.flags					= flags,
 		.stageCount				= (uint32_t)shaderStages.size(),
 		.pStages				= shaderStages.data(),
@@ -1008,6 +1013,7 @@ MeshletPipelinePtr Device::CreateMeshletPipeline(const MeshletPipelineDesc& pipe
 	if (VK_SUCCEEDED(vkCreateGraphicsPipelines(*m_device, *m_pipelineCache, 1, &pipelineCreateInfo, nullptr, &vkPipeline)))
 	{
 		pipeline = Create<CVkPipeline>(m_device.get(), vkPipeline);
+		RecordPipelineCacheFeedback(creationFeedback);
 	}
 	else
 	{
@@ -1118,6 +1124,7 @@ DescriptorSetPtr Device::CreateDescriptorSet(const DescriptorSetDesc& descriptor
 
 	auto descriptorSet = std::make_shared<DescriptorSet>(this, descriptorSetDesc.rootParameter);
 	descriptorSet->m_descriptorSet = vkDescriptorSet;
+	descriptorSet->m_descriptorSetLayout = vkDescriptorSetLayout;
 	descriptorSet->m_numDescriptors = descriptorSetDesc.numDescriptors;
 
 	return descriptorSet;
@@ -1125,6 +1132,72 @@ DescriptorSetPtr Device::CreateDescriptorSet(const DescriptorSetDesc& descriptor
 }
 
 
+#if USE_LEGACY_DESCRIPTOR_SETS
+VkDescriptorSet Device::CopyDescriptorSet(VkDescriptorSet descriptorSet, VkDescriptorSetLayout layout, const RootParameter& rootParameter)
+{
+	VkDescriptorSet newDescriptorSet{ VK_NULL_HANDLE };
+	{
+		std::lock_guard guard(m_descriptorSetMutex);
+
+		auto it = m_setPoolMapping.find(layout);
+		assert(it != m_setPoolMapping.end());
+
+		newDescriptorSet = it->second->AllocateDescriptorSet();
+	}
+
+	// Copying only reads the source set on the host, so it is fine for the GPU to still be using it
+	vector<VkCopyDescriptorSet> copies;
+	copies.reserve(rootParameter.table.size());
+
+	for (const auto& range : rootParameter.table)
+	{
+		const uint32_t binding = GetRegisterShift(range.descriptorType) + range.startRegister;
+
+		copies.push_back(VkCopyDescriptorSet{
+			.sType				= VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET,
+			.srcSet				= descriptorSet,
+			.srcBinding			= binding,
+			.srcArrayElement	= 0,
+			.dstSet				= newDescriptorSet,
+			.dstBinding			= binding,
+			.dstArrayElement	= 0,
+			.descriptorCount	= range.numDescriptors
+			});
+	}
+
+	vkUpdateDescriptorSets(m_device->Get(), 0, nullptr, (uint32_t)copies.size(), copies.data());
+
+	return newDescriptorSet;
+}
+
+
+void Device::FreeDescriptorSet(VkDescriptorSet descriptorSet, VkDescriptorSetLayout layout, uint64_t fenceValue)
+{
+	std::lock_guard guard(m_descriptorSetMutex);
+
+	m_pendingDescriptorSetFrees.push_back({ .fenceValue = fenceValue, .descriptorSet = descriptorSet, .layout = layout });
+}
+
+
+void Device::ReclaimDescriptorSets(uint64_t completedFenceValue)
+{
+	std::lock_guard guard(m_descriptorSetMutex);
+
+	// Frees are stamped with increasing fence values, so stop at the first one still in flight
+	while (!m_pendingDescriptorSetFrees.empty() && m_pendingDescriptorSetFrees.front().fenceValue <= completedFenceValue)
+	{
+		const auto& pending = m_pendingDescriptorSetFrees.front();
+
+		auto it = m_setPoolMapping.find(pending.layout);
+		assert(it != m_setPoolMapping.end());
+		it->second->FreeDescriptorSet(pending.descriptorSet);
+
+		m_pendingDescriptorSetFrees.pop_front();
+	}
+}
+#endif // USE_LEGACY_DESCRIPTOR_SETS
+
+
 SamplerPtr Device::CreateSampler(const SamplerDesc& samplerDesc)
 {
 	VkTextureFilterMapping filterMapping = TextureFilterToVulkan(samplerDesc.filter);
@@ -1150,24 +1223,17 @@ SamplerPtr Device::CreateSampler(const SamplerDesc& samplerDesc)
 		.unnormalizedCoordinates	= VK_FALSE
 	};
 
-	wil::com_ptr<CVkSampler> pSampler;
-
-	size_t hashValue = Utility::HashState(&createInfo);
-
-	std::lock_guard lock(m_samplerMutex);
+	// From flags on, every field is four bytes, so this skips pNext and the padding after sType
+	StateObjectKey key;
+	key.AppendBytes(&createInfo.flags, offsetof(VkSamplerCreateInfo, unnormalizedCoordinates) + sizeof(VkBool32) - offsetof(VkSamplerCreateInfo, flags));
 
-	auto iter = m_samplerMap.find(hashValue);
-	if (iter != m_samplerMap.end())
-	{
-		pSampler = iter->second;
-	}
-	else
-	{
-		VkSampler vkSampler = VK_NULL_HANDLE;
-		vkCreateSampler(m_device->Get(), &createInfo, nullptr, &vkSampler);
+	auto pSampler = m_samplerCache.FindOrCreate(key, [&]
+		{
+			VkSampler vkSampler = VK_NULL_HANDLE;
+			vkCreateSampler(m_device->Get(), &createInfo, nullptr, &vkSampler);
 
-		pSampler = Create<CVkSampler>(m_device.get(), vkSampler);
-	}
+			return Create<CVkSampler>(m_device.get(), vkSampler);
+		});
 
 	VkDescriptorImageInfo imageInfoSampler{
 		.sampler		= pSampler->Get(),
@@ -1348,6 +1414,123 @@ ColorBufferPtr Device::CreateColorBufferFromSwapChainImage(CVkImage* swapChainIm
 }
 
 
+PipelineCacheStats Device::GetPipelineCacheStats() const
+{
+	PipelineCacheStats stats{
+		.numHits		= m_pipelineCacheHits.load(),
+		.numMisses		= m_pipelineCacheMisses.load(),
+		.bytesLoaded	= m_pipelineCacheBytesLoaded,
+		.bytesSaved		= m_pipelineCacheBytesSaved
+	};
+	return stats;
+}
+
+
+void Device::LoadPipelineCache()
+{
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(m_device->GetPhysicalDevice(), &properties);
+
+	m_pipelineCacheIdentity = PipelineCacheIdentity{
+		.api			= GraphicsApi::Vulkan,
+		.vendorId		= properties.vendorID,
+		.deviceId		= properties.deviceID,
+		.driverVersion	= properties.driverVersion
+	};
+	static_assert(sizeof(properties.pipelineCacheUUID) == sizeof(m_pipelineCacheIdentity.driverUuid));
+	memcpy(m_pipelineCacheIdentity.driverUuid.data(), properties.pipelineCacheUUID, sizeof(properties.pipelineCacheUUID));
+
+	const string filename = GetPipelineCacheFilename(GraphicsApi::Vulkan);
+
+	vector<std::byte> cacheData;
+	const PipelineCacheStatus status = ReadPipelineCacheFile(filename, m_pipelineCacheIdentity, cacheData);
+	if (status != PipelineCacheStatus::Loaded && status != PipelineCacheStatus::NotFound)
+	{
+		LogInfo(LogPipelineCache) << "Discarded pipeline cache " << filename << " (" << PipelineCacheStatusToString(status) << ")" << endl;
+	}
+
+	if (!cacheData.empty())
+	{
+		m_pipelineCache = CreatePipelineCache(cacheData);
+		if (m_pipelineCache)
+		{
+			m_pipelineCacheBytesLoaded = cacheData.size();
+			return;
+		}
+
+		LogInfo(LogPipelineCache) << "Discarded pipeline cache " << filename << ", rejected by the driver" << endl;
+
+		error_code ec;
+		filesystem::remove(filename, ec);
+	}
+
+	m_pipelineCache = CreatePipelineCache({});
+}
+
+
+void Device::SavePipelineCache()
+{
+	if (!m_pipelineCache)
+	{
+		return;
+	}
+
+	size_t dataSize{ 0 };
+	if (VK_FAILED(vkGetPipelineCacheData(*m_device, *m_pipelineCache, &dataSize, nullptr)))
+	{
+		LogWarning(LogPipelineCache) << "Failed to get pipeline cache size.  Error code: " << res << endl;
+		return;
+	}
+
+	vector<std::byte> cacheData(dataSize);
+	if (VK_FAILED(vkGetPipelineCacheData(*m_device, *m_pipelineCache, &dataSize, cacheData.data())))
+	{
+		LogWarning(LogPipelineCache) << "Failed to get pipeline cache data.  Error code: " << res << endl;
+		return;
+	}
+	cacheData.resize(dataSize);
+
+	if (WritePipelineCacheFile(GetPipelineCacheFilename(GraphicsApi::Vulkan), m_pipelineCacheIdentity, cacheData))
+	{
+		m_pipelineCacheBytesSaved = cacheData.size();
+	}
+	else
+	{
+		LogWarning(LogPipelineCache) << "Failed to write pipeline cache" << endl;
+	}
+
+	LogInfo(LogPipelineCache) << "Pipeline cache: " << m_pipelineCacheHits << " hits, " << m_pipelineCacheMisses << " misses, "
+		<< m_pipelineCacheBytesLoaded << " bytes loaded, " << m_pipelineCacheBytesSaved << " bytes saved" << endl;
+}
+
+
+void Device::LogStateObjectCacheStats() const
+{
+	const pair<const char*, StateObjectCacheStats> caches[] = {
+		{ "Pipeline layout", m_pipelineLayoutCache.GetStats() },
+		{ "Shader module", m_shaderModuleCache.GetStats() },
+		{ "Sampler", m_samplerCache.GetStats() }
+	};
+
+	for (const auto& [name, stats] : caches)
+	{
+		if (stats.numLookups == 0)
+		{
+			continue;
+		}
+
+		LogInfo(LogVulkan) << format("{} cache: {} objects, {:.1f}% of {} lookups hit ({} waited on another thread), {} failures, {} hash collisions",
+			name,
+			stats.numEntries,
+			100.0f * stats.GetHitRate(),
+			stats.numLookups,
+			stats.numWaits,
+			stats.numFailures,
+			stats.numCollisions) << endl;
+	}
+}
+
+
 #if USE_DESCRIPTOR_BUFFERS
 wil::com_ptr<CVkBuffer> Device::CreateDescriptorBuffer(DescriptorBufferType type, size_t sizeInBytes)
 {
@@ -1472,66 +1655,32 @@ wil::com_ptr<CVkImageView> Device::CreateImageView(const ImageViewDesc& imageVie
 
 wil::com_ptr<CVkShaderModule> Device::CreateShaderModule(Shader* shader)
 {
-	CVkShaderModule** shaderModuleRef = nullptr;
-
-	size_t hashCode = shader->GetHash();
+	// Keyed by the SPIR-V itself, so shaders loaded under different names still share a module
+	StateObjectKey key;
+	key.AppendBytes(shader->GetByteCode(), shader->GetByteCodeSize());
 
-	bool firstCompile = false;
-	{
-		lock_guard<mutex> CS(m_shaderModuleMutex);
-		auto iter = m_shaderModuleHashMap.find(hashCode);
-
-		// Reserve space so the next inquiry will find that someone got here first.
-		if (iter == m_shaderModuleHashMap.end())
-		{
-			shaderModuleRef = m_shaderModuleHashMap[hashCode].addressof();
-			firstCompile = true;
-		}
-		else
+	return m_shaderModuleCache.FindOrCreate(key, [&]
 		{
-			shaderModuleRef = iter->second.addressof();
-			assert(shaderModuleRef != nullptr);
-		}
-	}
-
-	wil::com_ptr<CVkShaderModule> pShaderModule;
-
-	if (firstCompile)
-	{
-		VkShaderModuleCreateInfo createInfo{
-			.sType		= VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-			.codeSize	= shader->GetByteCodeSize(),
-			.pCode		= reinterpret_cast<const uint32_t*>(shader->GetByteCode())
-		};
-
-		VkShaderModule vkShaderModule{ VK_NULL_HANDLE };
-		vkCreateShaderModule(*m_device, &createInfo, nullptr, &vkShaderModule);
-
-		pShaderModule = Create<CVkShaderModule>(m_device.get(), vkShaderModule);
-
-		m_shaderModuleHashMap[hashCode] = pShaderModule.get();
+			VkShaderModuleCreateInfo createInfo{
+				.sType		= VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+				.codeSize	= shader->GetByteCodeSize(),
+				.pCode		= reinterpret_cast<const uint32_t*>(shader->GetByteCode())
+			};
 
-		assert(*shaderModuleRef == pShaderModule);
-	}
-	else
-	{
-		while (*shaderModuleRef == nullptr)
-		{
-			this_thread::yield();
-		}
-		pShaderModule = *shaderModuleRef;
-	}
+			VkShaderModule vkShaderModule{ VK_NULL_HANDLE };
+			vkCreateShaderModule(*m_device, &createInfo, nullptr, &vkShaderModule);
 
-	return pShaderModule;
+			return Create<CVkShaderModule>(m_device.get(), vkShaderModule);
+		});
 }
 
 
-wil::com_ptr<CVkPipelineCache> Device::CreatePipelineCache() const
+wil::com_ptr<CVkPipelineCache> Device::CreatePipelineCache(span<const std::byte> initialData) const
 {
 	VkPipelineCacheCreateInfo createInfo{
 		.sType				= VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-		.initialDataSize	= 0,
-		.pInitialData		= nullptr
+		.initialDataSize	= initialData.size(),
+		.pInitialData		= initialData.empty() ? nullptr : initialData.data()
 	};
 
 	VkPipelineCache vkPipelineCache{ VK_NULL_HANDLE };
@@ -1548,6 +1697,24 @@ wil::com_ptr<CVkPipelineCache> Device::CreatePipelineCache() const
 }
 
 
+void Device::RecordPipelineCacheFeedback(const VkPipelineCreationFeedback& feedback)
+{
+	if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) == 0)
+	{
+		return;
+	}
+
+	if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0)
+	{
+		++m_pipelineCacheHits;
+	}
+	else
+	{
+		++m_pipelineCacheMisses;
+	}
+}
+
+
 DescriptorSetLayoutPtr Device::CreateDescriptorSetLayout(const RootParameter& rootParameter)
 {
 	assert(rootParameter.parameterType == RootParameterType::Table);
@@ -1661,7 +1828,7 @@ DescriptorSetLayoutPtr Device::CreateDescriptorSetLayout(const RootParameter& ro
 		.pBindings		= bindings.data()
 	};
 	
-	hashCode = Utility::HashState(&info, 1, hashCode);
+	hashCode = Utility::HashState(&layoutFlags, 1, hashCode);
 
 	VkDescriptorSetLayout vkSetLayout = VK_NULL_HANDLE;
 	vkCreateDescriptorSetLayout(*m_device, &info, nullptr, &vkSetLayout);
@@ -1718,7 +1885,7 @@ DescriptorSetLayoutPtr Device::GetOrCreateEmptyDescriptorSetLayout()
 		};
 
 		size_t hashCode = Utility::g_hashStart;
-		hashCode = Utility::HashState(&info, 1, hashCode);
+		hashCode = Utility::HashState(&info.flags, 1, hashCode);
 
 		VkDescriptorSetLayout vkSetLayout = VK_NULL_HANDLE;
 		vkCreateDescriptorSetLayout(*m_device, &info, nullptr, &vkSetLayout);
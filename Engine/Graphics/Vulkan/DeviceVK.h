@@ -12,6 +12,7 @@
 
 #include "Graphics\Device.h"
 #include "Graphics\DeviceCaps.h"
+#include "Graphics\StateObjectCache.h"
 #include "Graphics\Vulkan\VulkanCommon.h"
 #include "Graphics\Vulkan\DescriptorPoolVK.h"
 #include "Graphics\Vulkan\DescriptorSetLayoutVK.h"
@@ -70,6 +71,15 @@ public:
 
 	DescriptorSetPtr CreateDescriptorSet(const DescriptorSetDesc& descriptorSetDesc);
 
+#if USE_LEGACY_DESCRIPTOR_SETS
+	// Allocates a new set with the same layout, and copies every descriptor in the root parameter's ranges into it
+	VkDescriptorSet CopyDescriptorSet(VkDescriptorSet descriptorSet, VkDescriptorSetLayout layout, const RootParameter& rootParameter);
+
+	// The set goes back to its pool once ReclaimDescriptorSets() sees a completed fence value at or past fenceValue
+	void FreeDescriptorSet(VkDescriptorSet descriptorSet, VkDescriptorSetLayout layout, uint64_t fenceValue);
+	void ReclaimDescriptorSets(uint64_t completedFenceValue);
+#endif // USE_LEGACY_DESCRIPTOR_SETS
+
 	SamplerPtr CreateSampler(const SamplerDesc& samplerDesc) override;
 
 	TexturePtr CreateTexture1D(const TextureDesc& textureDesc);
@@ -87,12 +97,21 @@ public:
 
 	VkDevice GetVulkanDevice() const { return m_device->Get(); }
 
+	PipelineCacheStats GetPipelineCacheStats() const override;
+
+	void LoadPipelineCache();
+	void SavePipelineCache();
+
+	// Pipeline layout, shader module and sampler caches
+	void LogStateObjectCacheStats() const;
+
 protected:
 	wil::com_ptr<CVkImage> CreateImage(const ImageDesc& imageDesc);
 	wil::com_ptr<CVkImageView> CreateImageView(const ImageViewDesc& imageViewDesc);
 
 	wil::com_ptr<CVkShaderModule> CreateShaderModule(Shader* shader);
-	wil::com_ptr<CVkPipelineCache> CreatePipelineCache() const;
+	wil::com_ptr<CVkPipelineCache> CreatePipelineCache(std::span<const std::byte> initialData) const;
+	void RecordPipelineCacheFeedback(const VkPipelineCreationFeedback& feedback);
 
 	DescriptorSetLayoutPtr CreateDescriptorSetLayout(const RootParameter& rootParameter);
 
@@ -108,23 +127,36 @@ protected:
 	Luna::DeviceCaps m_caps{};
 
 	// Pipeline layout cache (RootSignature)
-	std::mutex m_pipelineLayoutMutex;
-	std::map<size_t, wil::com_ptr<CVkPipelineLayout>> m_pipelineLayoutHashMap;
+	StateObjectCache<wil::com_ptr<CVkPipelineLayout>> m_pipelineLayoutCache;
 
 	// Shader modules
-	std::mutex m_shaderModuleMutex;
-	std::map<size_t, wil::com_ptr<CVkShaderModule>> m_shaderModuleHashMap;
+	StateObjectCache<wil::com_ptr<CVkShaderModule>> m_shaderModuleCache;
 
-	// Pipeline cache
+	// Pipeline cache, persisted to disk between runs
 	wil::com_ptr<CVkPipelineCache> m_pipelineCache;
+	PipelineCacheIdentity m_pipelineCacheIdentity{};
+	std::atomic<uint32_t> m_pipelineCacheHits{ 0 };
+	std::atomic<uint32_t> m_pipelineCacheMisses{ 0 };
+	uint64_t m_pipelineCacheBytesLoaded{ 0 };
+	uint64_t m_pipelineCacheBytesSaved{ 0 };
 
 	// Descriptor set cache
 	std::mutex m_descriptorSetMutex;
 	std::unordered_map<VkDescriptorSetLayout, std::unique_ptr<DescriptorPool>> m_setPoolMapping;
 
+#if USE_LEGACY_DESCRIPTOR_SETS
+	// Freed sets in the order they were freed, along with the fence they wait on
+	struct PendingDescriptorSetFree
+	{
+		uint64_t fenceValue{ 0 };
+		VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout layout{ VK_NULL_HANDLE };
+	};
+	std::deque<PendingDescriptorSetFree> m_pendingDescriptorSetFrees;
+#endif // USE_LEGACY_DESCRIPTOR_SETS
+
 	// Sampler state cache
-	std::mutex m_samplerMutex;
-	std::unordered_map<size_t, wil::com_ptr<CVkSampler>> m_samplerMap;
+	StateObjectCache<wil::com_ptr<CVkSampler>> m_samplerCache;
 
 	// Empty descriptor set layout, for gaps in pipeline layouts
 	std::mutex m_emptyDescriptorSetLayoutMutex;
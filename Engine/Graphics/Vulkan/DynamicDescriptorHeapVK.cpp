@@ -36,6 +36,8 @@ std::mutex DynamicDescriptorBuffer::sm_mutex;
 std::vector<wil::com_ptr<CVkBuffer>> DynamicDescriptorBuffer::sm_descriptorBufferPool[2];
 std::queue<std::pair<uint64_t, CVkBuffer*>> DynamicDescriptorBuffer::sm_retiredDescriptorBuffers[2];
 std::queue<CVkBuffer*> DynamicDescriptorBuffer::sm_availableDescriptorBuffers[2];
+bool DynamicDescriptorBuffer::sm_enableTableCache{ true };
+DescriptorTableCacheStats DynamicDescriptorBuffer::sm_tableCacheStats[2];
 
 
 static size_t GetDescriptorSize(DescriptorBufferType bufferType)
@@ -68,6 +70,11 @@ DynamicDescriptorBuffer::DynamicDescriptorBuffer(CommandContextVK& owningContext
 
 	m_graphicsCache.Clear();
 	m_computeCache.Clear();
+
+	if (sm_enableTableCache)
+	{
+		m_tableCache = make_unique<DescriptorTableHashCache>();
+	}
 }
 
 
@@ -91,6 +98,47 @@ void DynamicDescriptorBuffer::CleanupUsedBuffers(uint64_t fenceValue)
 	RetireUsedBuffers(fenceValue);
 	m_graphicsCache.Clear();
 	m_computeCache.Clear();
+
+	if (m_tableCache)
+	{
+		const uint32_t idx = m_bufferType == DescriptorBufferType::Sampler ? 1 : 0;
+
+		lock_guard<mutex> CS(sm_mutex);
+		sm_tableCacheStats[idx] += m_tableCache->TakeStats();
+	}
+}
+
+
+/* static */ DescriptorTableCacheStats DynamicDescriptorBuffer::GetTableCacheStats()
+{
+	lock_guard<mutex> CS(sm_mutex);
+
+	DescriptorTableCacheStats stats = sm_tableCacheStats[0];
+	stats += sm_tableCacheStats[1];
+	return stats;
+}
+
+
+/* static */ void DynamicDescriptorBuffer::LogTableCacheStats()
+{
+	lock_guard<mutex> CS(sm_mutex);
+
+	for (uint32_t idx = 0; idx < 2; ++idx)
+	{
+		const DescriptorTableCacheStats& stats = sm_tableCacheStats[idx];
+		if (stats.numLookups == 0)
+		{
+			continue;
+		}
+
+		LogInfo(LogVulkan) << format("{} descriptor tables: {:.1f}% of {} rebound from the table cache, {} inserts ({} dropped), {} resets",
+			idx == 1 ? "Sampler" : "Resource",
+			100.0f * stats.GetHitRate(),
+			stats.numLookups,
+			stats.numInserts,
+			stats.numDroppedInserts,
+			stats.numResets) << endl;
+	}
 }
 
 
@@ -312,6 +360,12 @@ void DynamicDescriptorBuffer::RetireCurrentBuffer()
 	}
 	m_currentOffset = 0;
 	m_bufferStart = nullptr;
+
+	// Cached tables point into the retired buffer
+	if (m_tableCache)
+	{
+		m_tableCache->Reset();
+	}
 }
 
 
@@ -439,14 +493,34 @@ void DynamicDescriptorBuffer::CopyDescriptors(DynamicDescriptorBuffer::Descripto
 		if (copyAllDescriptors || (copyDirtyDescriptorsOnly && descriptorCache.hasDirtyData[rootIndex]))
 		{
 			size_t tableSize = descriptorCache.tableSizes[rootIndex];
-			memcpy(m_bufferStart + offset, descriptorCache.tableAllocations[rootIndex].mem, tableSize);
+			const std::byte* tableData = descriptorCache.tableAllocations[rootIndex].mem;
+
+			if (m_tableCache)
+			{
+				assert((tableSize & 3) == 0);
+
+				const span<const uint32_t> key{ (const uint32_t*)tableData, tableSize / 4 };
+				const size_t hash = DescriptorTableHashCache::HashKey(key);
+
+				uint64_t cachedOffset{ 0 };
+				if (m_tableCache->Find(hash, key, cachedOffset))
+				{
+					descriptorCache.bindingOffsets[rootIndex] = (size_t)cachedOffset;
+					continue;
+				}
+
+				m_tableCache->Insert(hash, key, offset);
+			}
+
+			memcpy(m_bufferStart + offset, tableData, tableSize);
 			descriptorCache.bindingOffsets[rootIndex] = offset;
 			offset += tableSize;
 		}
 	}
 
-	m_currentOffset += offset;
-	m_freeSpace -= offset;
+	const size_t copiedSize = offset - m_currentOffset;
+	m_currentOffset += copiedSize;
+	m_freeSpace -= copiedSize;
 }
 
 
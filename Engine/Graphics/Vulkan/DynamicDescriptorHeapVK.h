@@ -14,6 +14,7 @@
 #include "Graphics\RootSignature.h"
 
 #if USE_DESCRIPTOR_BUFFERS
+#include "Graphics\DescriptorTableHashCache.h"
 #include "Graphics\Vulkan\DescriptorAllocatorVK.h"
 #endif // USE_DESCRIPTOR_BUFFERS
 
@@ -53,6 +54,11 @@ public:
 
 	static void DestroyAll();
 
+	// Rebind identical descriptor tables instead of copying them again.  Takes effect for buffers created afterwards.
+	static void EnableTableCache(bool enable) { sm_enableTableCache = enable; }
+	static DescriptorTableCacheStats GetTableCacheStats();
+	static void LogTableCacheStats();
+
 	void CleanupUsedBuffers(uint64_t fenceValue);
 
 	void ParseRootSignature(const RootSignature& rootSignature, bool graphicsPipe);
@@ -97,6 +103,8 @@ private:
 	static std::vector<wil::com_ptr<CVkBuffer>> sm_descriptorBufferPool[2];
 	static std::queue<std::pair<uint64_t, CVkBuffer*>> sm_retiredDescriptorBuffers[2];
 	static std::queue<CVkBuffer*> sm_availableDescriptorBuffers[2];
+	static bool sm_enableTableCache;
+	static DescriptorTableCacheStats sm_tableCacheStats[2];
 
 	// Non-static members
 	CommandContextVK& m_owningContext;
@@ -111,6 +119,9 @@ private:
 
 	std::vector<CVkBuffer*> m_retiredBuffers;
 
+	// Tables already copied into the current buffer, keyed by their descriptor bytes
+	std::unique_ptr<DescriptorTableHashCache> m_tableCache;
+
 	struct DescriptorCache
 	{
 		// Pointers to mapped memory for writing descriptors with vkGetDescriptorEXT
@@ -12,10 +12,21 @@
 
 #include "GpuBufferVK.h"
 
+#include "DeviceManagerVK.h"
+
 
 namespace Luna::VK
 {
 
+GpuBuffer::~GpuBuffer()
+{
+	if (auto deviceManager = GetVulkanDeviceManager())
+	{
+		deviceManager->ReleaseBuffer(m_buffer.get());
+	}
+}
+
+
 void GpuBuffer::Update(size_t sizeInBytes, const void* data)
 {
 	Update(sizeInBytes, 0, data);
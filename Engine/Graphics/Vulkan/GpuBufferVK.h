@@ -27,6 +27,8 @@ class GpuBuffer : public IGpuBuffer
 	friend class Device;
 
 public:
+	~GpuBuffer() override;
+
 	void Update(size_t sizeInBytes, const void* data) override;
 	void Update(size_t sizeInBytes, size_t offset, const void* data) override;
 
@@ -88,20 +88,14 @@ void LinearAllocatorPageManager::DiscardPages(uint64_t fenceValue, const vector<
 
 void LinearAllocatorPageManager::FreeLargePages(uint64_t fenceValue, const vector<LinearAllocationPage*>& largePages)
 {
-	lock_guard<mutex> lockGuard(m_mutex);
-
 	auto deviceManager = GetVulkanDeviceManager();
 
-	while (!m_deletionQueue.empty() && deviceManager->IsFenceComplete(m_deletionQueue.front().first))
-	{
-		delete m_deletionQueue.front().second;
-		m_deletionQueue.pop();
-	}
-
+	// The page itself can go now.  Its buffer waits in the device manager's deferred release queue.
 	for (auto iter = largePages.begin(); iter != largePages.end(); ++iter)
 	{
 		(*iter)->Unmap();
-		m_deletionQueue.push(make_pair(fenceValue, *iter));
+		deviceManager->ReleaseObject((*iter)->GetCVkBuffer(), fenceValue);
+		delete *iter;
 	}
 }
 
@@ -38,6 +38,7 @@ public:
 	void Unmap();
 
 	VkBuffer GetBuffer() const { return m_buffer->Get(); }
+	CVkBuffer* GetCVkBuffer() const { return m_buffer.get(); }
 
 	void* m_cpuVirtualAddress{ nullptr };
 
@@ -66,8 +67,8 @@ public:
 	// Discarded pages will get recycled.  This is for fixed size pages.
 	void DiscardPages(uint64_t fenceID, const std::vector<LinearAllocationPage*>& pages);
 
-	// Freed pages will be destroyed once their fence has passed.  This is for single-use,
-	// "large" pages.
+	// Freed pages will be destroyed once their fence has passed, through the device manager's
+	// deferred release queue.  This is for single-use, "large" pages.
 	void FreeLargePages(uint64_t fenceID, const std::vector<LinearAllocationPage*>& pages);
 
 	void Destroy() { m_pagePool.clear(); }
@@ -75,7 +76,6 @@ public:
 private:
 	std::vector<std::unique_ptr<LinearAllocationPage>> m_pagePool;
 	std::queue<std::pair<uint64_t, LinearAllocationPage*>> m_retiredPages;
-	std::queue<std::pair<uint64_t, LinearAllocationPage*>> m_deletionQueue;
 	std::queue<LinearAllocationPage*> m_availablePages;
 	std::mutex m_mutex;
 };
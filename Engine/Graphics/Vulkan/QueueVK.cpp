@@ -35,13 +35,6 @@ Queue::Queue(CVkDevice* device, VkQueue queue, QueueType queueType, uint32_t que
 	m_timelineSemaphore = CreateSemaphore(device, VK_SEMAPHORE_TYPE_TIMELINE, m_lastCompletedFenceValue);
 	assert(m_timelineSemaphore);
 	m_timelineSemaphore->name = std::format("{} Queue Timeline Semaphore", EngineTypeToString(queueType));
-
-	const auto commandListType = QueueTypeToCommandListType(queueType);
-
-	auto commandPool = CreateCommandPool();
-	assert(commandPool);
-
-	m_commandBufferPool.Initialize(commandPool.get(), commandListType);
 }
 
 
@@ -109,6 +102,17 @@ bool Queue::IsFenceComplete(uint64_t fenceValue)
 }
 
 
+uint64_t Queue::GetCompletedFenceValue()
+{
+	uint64_t semaphoreCounterValue{ 0 };
+	auto res = vkGetSemaphoreCounterValue(m_timelineSemaphore->semaphore->GetDevice(), m_timelineSemaphore->semaphore->Get(), &semaphoreCounterValue);
+	assert(res == VK_SUCCESS);
+	m_lastCompletedFenceValue = std::max(m_lastCompletedFenceValue, semaphoreCounterValue);
+
+	return m_lastCompletedFenceValue;
+}
+
+
 void Queue::WaitForFence(uint64_t fenceValue)
 {
 	if (IsFenceComplete(fenceValue))
@@ -133,10 +137,21 @@ void Queue::WaitForFence(uint64_t fenceValue)
 
 
 uint64_t Queue::ExecuteCommandList(VkCommandBuffer cmdList, VkFence fence)
+{
+	if (cmdList == VK_NULL_HANDLE)
+	{
+		return ExecuteCommandLists({}, fence);
+	}
+
+	return ExecuteCommandLists({ &cmdList, 1 }, fence);
+}
+
+
+uint64_t Queue::ExecuteCommandLists(span<VkCommandBuffer> cmdLists, VkFence fence)
 {
 	lock_guard<mutex> guard{ m_fenceMutex };
 
-	const bool incrementFenceAndSignal = (cmdList != VK_NULL_HANDLE);
+	const bool incrementFenceAndSignal = !cmdLists.empty();
 
 	if (incrementFenceAndSignal)
 	{
@@ -173,8 +188,8 @@ uint64_t Queue::ExecuteCommandList(VkCommandBuffer cmdList, VkFence fence)
 	submitInfo.pWaitDstStageMask = m_waitDstStageMask.data();
 	submitInfo.signalSemaphoreCount = (uint32_t)signalSemaphores.size();
 	submitInfo.pSignalSemaphores = signalSemaphores.data();
-	submitInfo.commandBufferCount = cmdList ? 1 : 0;
-	submitInfo.pCommandBuffers = cmdList ? &cmdList : nullptr;
+	submitInfo.commandBufferCount = (uint32_t)cmdLists.size();
+	submitInfo.pCommandBuffers = cmdLists.empty() ? nullptr : cmdLists.data();
 
 	auto res = vkQueueSubmit(m_vkQueue, 1, &submitInfo, fence);
 	assert(res == VK_SUCCESS);
@@ -192,18 +207,12 @@ uint64_t Queue::ExecuteCommandList(VkCommandBuffer cmdList, VkFence fence)
 }
 
 
-VkCommandBuffer Queue::RequestCommandBuffer()
+VkCommandBuffer Queue::RequestCommandBuffer(CommandBufferPool& commandBufferPool)
 {
 	uint64_t completedFence{ 0 };
 	vkGetSemaphoreCounterValue(m_timelineSemaphore->semaphore->GetDevice(), m_timelineSemaphore->semaphore->Get(), &completedFence);
 
-	return m_commandBufferPool.RequestCommandBuffer(completedFence);
-}
-
-
-void Queue::DiscardCommandBuffer(uint64_t fenceValueForReset, VkCommandBuffer commandBuffer)
-{
-	m_commandBufferPool.DiscardCommandBuffer(fenceValueForReset, commandBuffer);
+	return commandBufferPool.RequestCommandBuffer(completedFence);
 }
 
 
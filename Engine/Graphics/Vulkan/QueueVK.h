@@ -42,15 +42,19 @@ public:
 	}
 
 	uint64_t GetNextFenceValue() const noexcept { return m_nextFenceValue; }
+	uint64_t GetCompletedFenceValue();
 	uint64_t GetLastCompletedFenceValue() const noexcept { return m_lastCompletedFenceValue; }
 	uint64_t GetLastSubmittedFenceValue() const noexcept { return m_lastSubmittedFenceValue; }
 
 	uint64_t ExecuteCommandList(VkCommandBuffer cmdList, VkFence fence = VK_NULL_HANDLE);
-	VkCommandBuffer RequestCommandBuffer();
-	void DiscardCommandBuffer(uint64_t fenceValueForReset, VkCommandBuffer commandBuffer);
+	// Submits the command buffers in order, signaling a single fence value once all of them complete
+	uint64_t ExecuteCommandLists(std::span<VkCommandBuffer> cmdLists, VkFence fence = VK_NULL_HANDLE);
 
-private:
+	// Command pools are externally synchronized, so each command context records from its own pool
 	wil::com_ptr<CVkCommandPool> CreateCommandPool();
+	VkCommandBuffer RequestCommandBuffer(CommandBufferPool& commandBufferPool);
+
+private:
 	void ClearSemaphores();
 
 private:
@@ -60,7 +64,6 @@ private:
 	QueueType m_queueType{};
 	uint32_t m_queueFamilyIndex{ 0 };
 
-	CommandBufferPool m_commandBufferPool;
 	std::mutex m_fenceMutex;
 
 	SemaphorePtr m_timelineSemaphore;
@@ -0,0 +1,30 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "TextureVK.h"
+
+#include "DeviceManagerVK.h"
+
+
+namespace Luna::VK
+{
+
+Texture::~Texture()
+{
+	// The GPU may still be sampling the image, so the device manager holds on to it until the current fence passes
+	if (auto deviceManager = GetVulkanDeviceManager())
+	{
+		deviceManager->ReleaseImage(m_image.get());
+	}
+}
+
+} // namespace Luna::VK
@@ -73,7 +73,7 @@ void InputSystem::Update(float deltaSeconds)
 	memset(m_analogs, 0, sizeof(m_analogs));
 
 	XINPUT_STATE newInputState{};
-	for (uint32_t i = 0; i < 4; ++i)
+	for (uint32_t i = 0; m_hwnd != nullptr && i < 4; ++i)
 	{
 		if (ERROR_SUCCESS == XInputGetState(i, &newInputState))
 		{
@@ -207,13 +207,21 @@ float InputSystem::GetTimeCorrectedAnalogInput(AnalogInput ai) const
 
 void InputSystem::Initialize()
 {
-	LogInfo(LogInput) << "Creating DirectInput device" << endl;
-
 	KbmBuildKeyMapping();
 
 	ZeroMemory(m_buttons, sizeof(m_buttons));
 	ZeroMemory(m_analogs, sizeof(m_analogs));
 
+	// Headless apps have no window, so all inputs stay zeroed
+	if (m_hwnd == nullptr)
+	{
+		LogInfo(LogInput) << "No window, input is disabled" << endl;
+		KbmZeroInputs();
+		return;
+	}
+
+	LogInfo(LogInput) << "Creating DirectInput device" << endl;
+
 	if (FAILED(DirectInput8Create(GetModuleHandle(nullptr), DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&m_di, nullptr)))
 	{
 		assert_msg(false, "DirectInput8 initialization failed.");
@@ -412,7 +420,8 @@ void InputSystem::KbmUpdate()
 	HWND foreground = GetForegroundWindow();
 	bool visible = IsWindowVisible(foreground) != 0;
 
-	if (foreground != m_hwnd // wouldn't be able to acquire
+	if (m_hwnd == nullptr
+		|| foreground != m_hwnd // wouldn't be able to acquire
 		|| !visible)
 	{
 		KbmZeroInputs();
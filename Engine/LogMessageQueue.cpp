@@ -0,0 +1,108 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "LogMessageQueue.h"
+
+using namespace std;
+
+
+namespace Luna
+{
+
+LogMessageQueue::LogMessageQueue(size_t capacity, size_t messageReserveSize)
+	: m_slots{ make_unique<Slot[]>(capacity) }
+	, m_capacity{ capacity }
+{
+	assert((capacity & (capacity - 1)) == 0);
+
+	for (size_t i = 0; i < capacity; ++i)
+	{
+		m_slots[i].sequence.store(i, memory_order_relaxed);
+		m_slots[i].message.messageStr.reserve(messageReserveSize);
+	}
+}
+
+
+void LogMessageQueue::Push(LogMessage&& message)
+{
+	uint64_t pos = m_enqueuePos.load(memory_order_relaxed);
+	Slot* slot{ nullptr };
+
+	for (;;)
+	{
+		slot = &m_slots[pos & (m_capacity - 1)];
+		const uint64_t sequence = slot->sequence.load(memory_order_acquire);
+		const int64_t diff = (int64_t)sequence - (int64_t)pos;
+
+		if (diff == 0)
+		{
+			if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The ring is full, wait for the worker to release this slot
+			++m_numBlockedProducers;
+			slot->sequence.wait(sequence);
+			--m_numBlockedProducers;
+
+			pos = m_enqueuePos.load(memory_order_relaxed);
+		}
+		else
+		{
+			pos = m_enqueuePos.load(memory_order_relaxed);
+		}
+	}
+
+	// Copy into the slot's own storage rather than moving, so the slot keeps its preallocated buffer
+	slot->message.messageStr.assign(message.messageStr);
+	slot->message.severity = message.severity;
+	slot->message.category = message.category;
+	slot->message.timestamp = message.timestamp;
+
+	slot->sequence.store(pos + 1);
+
+	if (m_workerWaiting.load())
+	{
+		Wake();
+	}
+}
+
+
+void LogMessageQueue::Wait(const atomic<bool>& cancel)
+{
+	const uint32_t wakeCount = m_wakeCount.load();
+
+	m_workerWaiting.store(true);
+	if (!IsMessageReady() && !cancel.load())
+	{
+		m_wakeCount.wait(wakeCount);
+	}
+	m_workerWaiting.store(false);
+}
+
+
+void LogMessageQueue::Wake()
+{
+	m_wakeCount.fetch_add(1);
+	m_wakeCount.notify_one();
+}
+
+
+bool LogMessageQueue::IsMessageReady() const
+{
+	return m_slots[m_dequeuePos & (m_capacity - 1)].sequence.load() == m_dequeuePos + 1;
+}
+
+} // namespace Luna
@@ -0,0 +1,118 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include "Core/NonCopyable.h"
+#include "Core/NonMovable.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+
+namespace Luna
+{
+
+// Forward declarations
+class LogCategory;
+
+
+enum class Severity
+{
+	Fatal,
+	Error,
+	Warning,
+	Notice,
+	Info,
+	Debug,
+	Log
+};
+
+
+struct LogMessage
+{
+	std::string messageStr;
+	Severity severity{ Severity::Info };
+	const LogCategory* category{ nullptr };
+	std::chrono::system_clock::time_point timestamp{};
+};
+
+
+// Bounded multi-producer, single-consumer ring buffer of preallocated message slots.  Each slot's sequence number
+// tells whose turn it is: a producer may claim position p when the sequence is p, the worker may read it once the
+// sequence is p + 1, and releasing it sets the sequence to p + capacity for the next lap.  Producers only block
+// when the ring is full, and the worker sleeps on a wake counter instead of polling.
+class LogMessageQueue : NonCopyable, NonMovable
+{
+public:
+	// The capacity must be a power of 2.  Slots keep their string storage between messages, so messages up to
+	// messageReserveSize characters never allocate.
+	LogMessageQueue(size_t capacity, size_t messageReserveSize);
+
+	// Safe to call from any thread.  Blocks while the ring is full.
+	void Push(LogMessage&& message);
+
+	// Worker thread only.  Hands each ready message to func, in order, and returns the number of messages.
+	template <typename TFunc>
+	size_t PopAll(TFunc&& func)
+	{
+		size_t count = 0;
+
+		for (;;)
+		{
+			Slot& slot = m_slots[m_dequeuePos & (m_capacity - 1)];
+			if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+			{
+				break;
+			}
+
+			func(slot.message);
+
+			slot.sequence.store(m_dequeuePos + m_capacity);
+			if (m_numBlockedProducers.load() > 0)
+			{
+				slot.sequence.notify_all();
+			}
+
+			++m_dequeuePos;
+			++count;
+		}
+
+		return count;
+	}
+
+	// Worker thread only.  Sleeps until a message is ready, Wake() is called, or cancel is set.
+	void Wait(const std::atomic<bool>& cancel);
+	void Wake();
+
+private:
+	bool IsMessageReady() const;
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> sequence{ 0 };
+		LogMessage message;
+	};
+
+	std::unique_ptr<Slot[]> m_slots;
+	const size_t m_capacity{ 0 };
+
+	alignas(64) std::atomic<uint64_t> m_enqueuePos{ 0 };
+	alignas(64) uint64_t m_dequeuePos{ 0 };
+
+	std::atomic<uint32_t> m_wakeCount{ 0 };
+	std::atomic<bool> m_workerWaiting{ false };
+	std::atomic<uint32_t> m_numBlockedProducers{ 0 };
+};
+
+} // namespace Luna
@@ -24,12 +24,20 @@ namespace
 
 Luna::LogSystem* g_logSystem{ nullptr };
 std::queue<Luna::LogMessage> g_deferredMessages;
+std::atomic<Luna::Severity> g_logVerbosity{ Luna::Severity::Debug };
 
 bool outputToFile{ true };
 bool outputToConsole{ true };
 bool outputToDebug{ true };
 bool allowThreadedLogging{ true };
 
+// Must be a power of 2
+constexpr size_t s_messageQueueCapacity = 4096;
+// Slots keep their string storage between messages, so typical messages never allocate on the worker thread
+constexpr size_t s_messageReserveSize = 256;
+// Output is written early if a batch grows past this
+constexpr size_t s_maxBatchSize = 64 * 1024;
+
 
 string SeverityToString(Luna::Severity level)
 {
@@ -53,6 +61,23 @@ string SeverityToString(Luna::Severity level)
 namespace Luna
 {
 
+void SetLogVerbosity(Severity verbosity)
+{
+	g_logVerbosity.store(verbosity, memory_order_relaxed);
+}
+
+
+bool IsLogSeverityEnabled(Severity severity)
+{
+	if (severity == Severity::Fatal || severity == Severity::Log)
+	{
+		return true;
+	}
+
+	return severity <= g_logVerbosity.load(memory_order_relaxed);
+}
+
+
 void PostLogMessage(LogMessage&& message)
 {
 	auto* logSystem = GetLogSystem();
@@ -94,11 +119,12 @@ void LogSystem::PostLogMessage(LogMessage&& message)
 {
 	if (allowThreadedLogging)
 	{
-		m_messageQueue.push(move(message));
+		m_messageQueue->Push(move(message));
 	}
 	else
 	{
 		OutputLogMessage(message);
+		FlushOutput();
 	}
 }
 
@@ -149,23 +175,15 @@ void LogSystem::Initialize()
 
 	CreateLogFile();
 
+	m_outputBuffer.reserve(s_maxBatchSize);
+	m_consoleBuffer.reserve(s_maxBatchSize);
+
 	m_haltLogging = false;
 
 	if (allowThreadedLogging)
 	{
-		m_workerLoop = async(launch::async,
-			[&]
-			{
-				while (!m_haltLogging)
-				{
-					LogMessage message{};
-					if (m_messageQueue.try_pop(message))
-					{
-						OutputLogMessage(message);
-					}
-				}
-			}
-		);
+		m_messageQueue = make_unique<LogMessageQueue>(s_messageQueueCapacity, s_messageReserveSize);
+		m_workerLoop = async(launch::async, [&] { WorkerLoop(); });
 	}
 
 	m_initialized = true;
@@ -185,6 +203,7 @@ void LogSystem::Shutdown()
 	m_haltLogging = true;
 	if (allowThreadedLogging)
 	{
+		m_messageQueue->Wake();
 		m_workerLoop.get();
 	}
 
@@ -195,62 +214,130 @@ void LogSystem::Shutdown()
 }
 
 
+void LogSystem::WorkerLoop()
+{
+	for (;;)
+	{
+		// Read the halt flag first, so that messages posted before shutdown are drained
+		const bool haltLogging = m_haltLogging;
+
+		const size_t numMessages = m_messageQueue->PopAll([this](const LogMessage& message) { OutputLogMessage(message); });
+		if (numMessages > 0)
+		{
+			FlushOutput();
+		}
+		else if (haltLogging)
+		{
+			break;
+		}
+		else
+		{
+			m_messageQueue->Wait(m_haltLogging);
+		}
+	}
+}
+
+
 void LogSystem::OutputLogMessage(const LogMessage& message)
 {
 	using enum Severity;
 
 	namespace chr = std::chrono;
-	const auto systemTime = chr::system_clock::now();
-	const auto localTime = chr::zoned_time{ chr::current_zone(), systemTime }.get_local_time();
-	const auto localTimeStr = format("[{:%Y.%m.%d-%H.%M.%S}]", chr::floor<chr::milliseconds>(localTime));
-
-	const string categoryStr = format("{}: ", message.category.GetName());
-	const string severityStr = (message.severity == Severity::Log) ? "" : format("{}: ", SeverityToString(message.severity));
 
-	string messageStr;
-	if (message.category.IsValid())
+	// The zoned time and date formatting only change once a second, so only the milliseconds are formatted per message
+	const auto timestampSecond = chr::floor<chr::seconds>(message.timestamp);
+	if (timestampSecond != m_timestampSecond || m_timestampPrefix.empty())
 	{
-		messageStr = format("{} {}{}{}", localTimeStr, categoryStr, severityStr, message.messageStr);
+		if (timestampSecond < m_timeZoneInfo.begin || timestampSecond >= m_timeZoneInfo.end)
+		{
+			m_timeZoneInfo = chr::current_zone()->get_info(timestampSecond);
+		}
+
+		const chr::local_seconds localTime{ (timestampSecond + m_timeZoneInfo.offset).time_since_epoch() };
+		m_timestampPrefix = format("[{:%Y.%m.%d-%H.%M.%S}", localTime);
+		m_timestampSecond = timestampSecond;
 	}
-	else
+	const auto milliseconds = chr::duration_cast<chr::milliseconds>(message.timestamp - timestampSecond).count();
+
+	const size_t lineStart = m_outputBuffer.size();
+
+	m_outputBuffer += m_timestampPrefix;
+	format_to(back_inserter(m_outputBuffer), ".{:03}] ", milliseconds);
+
+	if (message.category && message.category->IsValid())
 	{
-		messageStr = format("{} {}{}", localTimeStr, severityStr, message.messageStr);
+		m_outputBuffer += message.category->GetName();
+		m_outputBuffer += ": ";
 	}
 
-
-	if (outputToFile)
+	if (message.severity != Severity::Log)
 	{
-		m_file.flush();
-		m_file << messageStr;
+		m_outputBuffer += SeverityToString(message.severity);
+		m_outputBuffer += ": ";
 	}
 
+	m_outputBuffer += message.messageStr;
+
+	const string_view messageStr{ m_outputBuffer.data() + lineStart, m_outputBuffer.size() - lineStart };
+
 	if (outputToConsole)
 	{
 		if (message.severity == Fatal || message.severity == Error)
 		{
+			// Keep stdout and stderr in order
+			cout << m_consoleBuffer;
+			cout.flush();
+			m_consoleBuffer.clear();
+
 			cerr << messageStr;
 		}
 		else
 		{
-			cout << messageStr;
+			m_consoleBuffer += messageStr;
 		}
 	}
 
-	if (outputToDebug)
+	if (message.severity == Fatal)
+	{
+		const string fatalMessageStr{ messageStr };
+
+		FlushOutput();
+		m_file.close();
+
+		cerr.flush();
+		cout.flush();
+
+		Utility::ExitFatal(fatalMessageStr, "Fatal Error");
+	}
+
+	if (m_outputBuffer.size() >= s_maxBatchSize || m_consoleBuffer.size() >= s_maxBatchSize)
 	{
-		OutputDebugStringA(messageStr.c_str());
+		FlushOutput();
 	}
+}
 
-	if (message.severity == Fatal)
+
+void LogSystem::FlushOutput()
+{
+	if (outputToFile && !m_outputBuffer.empty())
 	{
+		m_file.write(m_outputBuffer.data(), (streamsize)m_outputBuffer.size());
 		m_file.flush();
-		m_file.close();
+	}
 
-		cerr.flush();
+	if (outputToConsole && !m_consoleBuffer.empty())
+	{
+		cout << m_consoleBuffer;
 		cout.flush();
+	}
 
-		Utility::ExitFatal(messageStr, "Fatal Error");
+	if (outputToDebug && !m_outputBuffer.empty())
+	{
+		OutputDebugStringA(m_outputBuffer.c_str());
 	}
+
+	m_outputBuffer.clear();
+	m_consoleBuffer.clear();
 }
 
 
@@ -259,4 +346,4 @@ LogSystem* GetLogSystem()
 	return g_logSystem;
 }
 
-} // namespace Luna
\ No newline at end of file
+} // namespace Luna
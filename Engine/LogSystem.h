@@ -10,24 +10,37 @@
 
 #pragma once
 
-#include <concurrent_queue.h>
+#include "Core\NonCopyable.h"
+#include "Core\NonMovable.h"
+#include "LogMessageQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+
+// LogDebug is compiled out unless this is set.  It is defined here, rather than in Stdafx.h, so that every
+// translation unit that includes this header sees the same value, and so the same LogDebug.
+#ifndef FORCE_LOG_DEBUG
+#define FORCE_LOG_DEBUG 0
+#endif
+#define ENABLE_LOG_DEBUG (_DEBUG || _PROFILE || FORCE_LOG_DEBUG)
+
 
 namespace Luna
 {
 
-enum class Severity
-{
-	Fatal,
-	Error,
-	Warning,
-	Notice,
-	Info,
-	Debug,
-	Log
-};
+// Messages more verbose than this are dropped before they are formatted.  Fatal and plain Log messages are never dropped.
+void SetLogVerbosity(Severity verbosity);
+bool IsLogSeverityEnabled(Severity severity);
 
 
-class LogCategory
+class LogCategory : NonCopyable
 {
 public:
 	LogCategory() = default;
@@ -43,18 +56,27 @@ public:
 		return m_name;
 	}
 
+	void SetVerbosity(Severity verbosity) noexcept
+	{
+		m_verbosity.store(verbosity, std::memory_order_relaxed);
+	}
+
+	bool IsEnabled(Severity severity) const
+	{
+		if (severity == Severity::Fatal || severity == Severity::Log)
+		{
+			return true;
+		}
+
+		return severity <= m_verbosity.load(std::memory_order_relaxed) && IsLogSeverityEnabled(severity);
+	}
+
 private:
 	std::string m_name;
+	std::atomic<Severity> m_verbosity{ Severity::Debug };
 };
 
 
-struct LogMessage
-{
-	std::string messageStr;
-	Severity severity;
-	LogCategory category;
-};
-
 void PostLogMessage(LogMessage&& message);
 
 
@@ -73,79 +95,102 @@ private:
 	void Initialize();
 	void Shutdown();
 
+	void WorkerLoop();
 	void OutputLogMessage(const LogMessage& message);
+	void FlushOutput();
 
 private:
 	std::mutex m_initializationMutex;
 	std::ofstream m_file;
-	Concurrency::concurrent_queue<LogMessage> m_messageQueue;
+	std::unique_ptr<LogMessageQueue> m_messageQueue;
 	std::atomic<bool> m_haltLogging;
 	std::future<void> m_workerLoop;
 	std::atomic<bool> m_initialized;
+
+	// Formatted output, written out once per batch of messages.  Only touched by the worker thread.
+	std::string m_outputBuffer;
+	std::string m_consoleBuffer;
+	std::chrono::sys_seconds m_timestampSecond{};
+	std::chrono::sys_info m_timeZoneInfo{};
+	std::string m_timestampPrefix;
 };
 
 
 class LogBase
 {
 public:
+	// Only builds the message stream when the severity and category are enabled
 	class LogProxy : NonCopyable
 	{
 	public:
 		LogProxy() = delete;
-		LogProxy(Severity severity, LogCategory category)
+		LogProxy(Severity severity, const LogCategory* category, bool enabled)
 			: m_severity{ severity }
 			, m_category{ category }
 		{
+			if (enabled)
+			{
+				m_stream.emplace();
+			}
 		}
 		LogProxy(LogProxy&& other) noexcept
 			: m_severity{ other.m_severity }
 			, m_category{ other.m_category }
 			, m_stream{ std::move(other.m_stream) }
 		{
+			other.m_stream.reset();
 		}
 		~LogProxy()
 		{
-			m_stream.flush();
-			PostLogMessage({ m_stream.str(), m_severity, m_category });
+			if (m_stream)
+			{
+				PostLogMessage({ m_stream->str(), m_severity, m_category, std::chrono::system_clock::now() });
+			}
 		}
 
 		template <typename T>
 		LogProxy& operator<<(const T& value)
 		{
-			m_stream << value;
+			if (m_stream)
+			{
+				*m_stream << value;
+			}
 			return *this;
 		}
 
 		LogProxy& operator<<(std::ostream& (*os)(std::ostream&))
 		{
-			m_stream << os;
+			if (m_stream)
+			{
+				*m_stream << os;
+			}
 			return *this;
 		}
 
 	private:
 		Severity m_severity{ Severity::Info };
-		LogCategory m_category;
-		std::ostringstream m_stream;
+		const LogCategory* m_category{ nullptr };
+		std::optional<std::ostringstream> m_stream;
 	};
 
 	LogProxy operator()(const LogCategory& category)
 	{
-		return LogProxy{ m_severity, category };
+		return LogProxy{ m_severity, &category, category.IsEnabled(m_severity) };
 	}
 
 	template <typename T>
 	LogProxy operator<<(const T& value)
 	{
-		LogProxy proxy{ m_severity, LogCategory{} };
+		LogProxy proxy{ m_severity, nullptr, IsLogSeverityEnabled(m_severity) };
 		proxy << value;
 		return proxy;
 	}
 
-	LogProxy&& operator<<(std::ostream& (*os)(std::ostream&))
+	LogProxy operator<<(std::ostream& (*os)(std::ostream&))
 	{
-		LogProxy proxy{ m_severity, LogCategory{} };
+		LogProxy proxy{ m_severity, nullptr, IsLogSeverityEnabled(m_severity) };
 		proxy << os;
-		return std::move(proxy);
+		return proxy;
 	}
 
 public:
@@ -157,13 +202,39 @@ private:
 };
 
 
+#if !ENABLE_LOG_DEBUG
+// Stands in for LogDebug when debug logging is compiled out.  Everything it is handed is discarded inline.
+class NullLog
+{
+public:
+	class NullProxy
+	{
+	public:
+		template <typename T>
+		NullProxy& operator<<(const T&) { return *this; }
+		NullProxy& operator<<(std::ostream& (*)(std::ostream&)) { return *this; }
+	};
+
+	NullProxy operator()(const LogCategory&) const { return NullProxy{}; }
+
+	template <typename T>
+	NullProxy operator<<(const T&) const { return NullProxy{}; }
+	NullProxy operator<<(std::ostream& (*)(std::ostream&)) const { return NullProxy{}; }
+};
+#endif // !ENABLE_LOG_DEBUG
+
+
 inline LogBase Log{ Severity::Log };
 inline LogBase LogFatal{ Severity::Fatal };
 inline LogBase LogError{ Severity::Error };
 inline LogBase LogWarning{ Severity::Warning };
 inline LogBase LogNotice{ Severity::Notice };
 inline LogBase LogInfo{ Severity::Info };
+#if ENABLE_LOG_DEBUG
 inline LogBase LogDebug{ Severity::Debug };
+#else
+inline NullLog LogDebug;
+#endif // ENABLE_LOG_DEBUG
 
 LogSystem* GetLogSystem();
 
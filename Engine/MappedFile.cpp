@@ -0,0 +1,239 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "MappedFile.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+
+namespace
+{
+
+size_t GetAllocationGranularity() noexcept
+{
+#if defined(_WIN32)
+	SYSTEM_INFO systemInfo{};
+	GetSystemInfo(&systemInfo);
+	return (size_t)systemInfo.dwAllocationGranularity;
+#else
+	return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+const size_t s_allocationGranularity = GetAllocationGranularity();
+
+
+// Rounds the window down to where a view can start, and clamps it to the file
+bool GetViewRange(uint64_t fileSize, uint64_t offset, size_t size, uint64_t& outViewOffset, size_t& outViewSize, size_t& outSize) noexcept
+{
+	// Empty files and windows cannot be mapped
+	if (offset >= fileSize)
+	{
+		return false;
+	}
+
+	const uint64_t available = fileSize - offset;
+	if (size == 0 || size > available)
+	{
+		if (available > (uint64_t)numeric_limits<size_t>::max())
+		{
+			return false;
+		}
+		size = (size_t)available;
+	}
+
+	outViewOffset = offset - offset % s_allocationGranularity;
+	outViewSize = (size_t)(offset - outViewOffset) + size;
+	outSize = size;
+
+	return true;
+}
+
+} // anonymous namespace
+
+
+namespace Luna
+{
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = move(other);
+}
+
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+
+#if defined(_WIN32)
+		m_file = move(other.m_file);
+		m_mapping = move(other.m_mapping);
+#endif
+		m_view = exchange(other.m_view, nullptr);
+		m_viewSize = exchange(other.m_viewSize, 0);
+		m_data = exchange(other.m_data, nullptr);
+		m_size = exchange(other.m_size, 0);
+		m_offset = exchange(other.m_offset, 0);
+		m_fileSize = exchange(other.m_fileSize, 0);
+	}
+	return *this;
+}
+
+
+bool MappedFile::Open(const string& fileName)
+{
+	return Open(fileName, 0, 0);
+}
+
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const string& fileName, uint64_t offset, size_t size)
+{
+	Close();
+
+	ScopedHandle hFile(SafeHandle(CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr)));
+	if (!hFile)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize{ 0 };
+	if (!GetFileSizeEx(hFile.get(), &fileSize))
+	{
+		return false;
+	}
+
+	uint64_t viewOffset{ 0 };
+	size_t viewSize{ 0 };
+	if (!GetViewRange((uint64_t)fileSize.QuadPart, offset, size, viewOffset, viewSize, size))
+	{
+		return false;
+	}
+
+	ScopedHandle hMapping(CreateFileMappingA(hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+	if (!hMapping)
+	{
+		return false;
+	}
+
+	const void* view = MapViewOfFile(hMapping.get(), FILE_MAP_READ, (DWORD)(viewOffset >> 32), (DWORD)viewOffset, viewSize);
+	if (view == nullptr)
+	{
+		return false;
+	}
+
+	m_file = move(hFile);
+	m_mapping = move(hMapping);
+	m_view = (const std::byte*)view;
+	m_viewSize = viewSize;
+	m_data = m_view + (offset - viewOffset);
+	m_size = size;
+	m_offset = offset;
+	m_fileSize = (uint64_t)fileSize.QuadPart;
+
+	return true;
+}
+
+
+void MappedFile::Close()
+{
+	if (m_view != nullptr)
+	{
+		UnmapViewOfFile(m_view);
+	}
+
+	m_view = nullptr;
+	m_viewSize = 0;
+	m_data = nullptr;
+	m_size = 0;
+	m_offset = 0;
+	m_fileSize = 0;
+
+	m_mapping.reset();
+	m_file.reset();
+}
+
+#else
+
+bool MappedFile::Open(const string& fileName, uint64_t offset, size_t size)
+{
+	Close();
+
+	const int file = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	// The mapping holds its own reference to the file, so the descriptor isn't needed past mmap()
+	struct stat fileStat {};
+	uint64_t viewOffset{ 0 };
+	size_t viewSize{ 0 };
+	void* view = MAP_FAILED;
+	if (fstat(file, &fileStat) == 0 && GetViewRange((uint64_t)fileStat.st_size, offset, size, viewOffset, viewSize, size))
+	{
+		view = mmap(nullptr, viewSize, PROT_READ, MAP_PRIVATE, file, (off_t)viewOffset);
+	}
+	close(file);
+
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	posix_madvise(view, viewSize, POSIX_MADV_SEQUENTIAL);
+
+	m_view = (const std::byte*)view;
+	m_viewSize = viewSize;
+	m_data = m_view + (offset - viewOffset);
+	m_size = size;
+	m_offset = offset;
+	m_fileSize = (uint64_t)fileStat.st_size;
+
+	return true;
+}
+
+
+void MappedFile::Close()
+{
+	if (m_view != nullptr)
+	{
+		munmap((void*)m_view, m_viewSize);
+	}
+
+	m_view = nullptr;
+	m_viewSize = 0;
+	m_data = nullptr;
+	m_size = 0;
+	m_offset = 0;
+	m_fileSize = 0;
+}
+
+#endif // defined(_WIN32)
+
+} // namespace Luna
@@ -0,0 +1,63 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+
+namespace Luna
+{
+
+// Read-only view of a file, or of a window into one, mapped into the address space.  Pages are faulted in by
+// the OS as they are touched, so nothing is copied up front, and clean pages can be dropped again under memory
+// pressure instead of being written to the page file.
+class MappedFile : NonCopyable
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& fileName) { Open(fileName); }
+	MappedFile(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Maps the entire file
+	bool Open(const std::string& fileName);
+
+	// Maps only the size bytes at offset, clamped to the end of the file, or everything after offset if size is
+	// 0.  Keeps the address space used by large files and archives down to the part being read.
+	bool Open(const std::string& fileName, uint64_t offset, size_t size);
+	void Close();
+
+	bool IsOpen() const noexcept { return m_data != nullptr; }
+	const std::byte* GetData() const noexcept { return m_data; }
+	size_t GetSize() const noexcept { return m_size; }
+	std::span<const std::byte> GetSpan() const noexcept { return { m_data, m_size }; }
+
+	// Where the mapped window starts in the file, and how large the whole file is
+	uint64_t GetOffset() const noexcept { return m_offset; }
+	uint64_t GetFileSize() const noexcept { return m_fileSize; }
+
+private:
+#if defined(_WIN32)
+	ScopedHandle m_file;
+	ScopedHandle m_mapping;
+#endif
+
+	// The view starts at the allocation granularity boundary at or before the requested offset
+	const std::byte* m_view{ nullptr };
+	size_t m_viewSize{ 0 };
+
+	const std::byte* m_data{ nullptr };
+	size_t m_size{ 0 };
+	uint64_t m_offset{ 0 };
+	uint64_t m_fileSize{ 0 };
+};
+
+} // namespace Luna
@@ -10,6 +10,13 @@
 
 #pragma once
 
+#if defined(LUNA_HEADLESS)
+
+// Headless builds, such as the tests and benchmarks, compile only the platform-independent parts of the engine
+#include "StdafxHeadless.h"
+
+#else
+
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -48,10 +55,13 @@
 
 // Standard library headers
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstdarg>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <format>
@@ -62,6 +72,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <set>
 #include <shared_mutex>
@@ -71,6 +82,7 @@
 #include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
@@ -82,6 +94,7 @@
 #include "Core\CoreEnums.h"
 #include "Core\DWParam.h"
 #include "Core\Hash.h"
+#include "Core\JobSystem.h"
 #include "Core\NativeObjectPtr.h"
 #include "Core\NonCopyable.h"
 #include "Core\NonMovable.h"
@@ -108,4 +121,6 @@ static const std::string s_engineVersionStr
 	std::to_string(s_engineMajorVersion) + "." + std::to_string(s_engineMinorVersion) + "." + std::to_string(s_enginePatchVersion)
 };
 
-static const std::string s_engineName{ "Luna" };
\ No newline at end of file
+static const std::string s_engineName{ "Luna" };
+
+#endif // LUNA_HEADLESS
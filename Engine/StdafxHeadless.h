@@ -0,0 +1,115 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+// Included by Stdafx.h when LUNA_HEADLESS is defined.  Code built this way must not depend on Windows, a
+// graphics API or DirectXMath, so that it builds with GCC and Clang on Linux as well as with MSVC.  Includes
+// use forward slashes for the same reason.
+
+// Standard library headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Core headers
+#include "Core/Hash.h"
+#include "Core/HeadlessCom.h"
+#include "Core/JobSystem.h"
+#include "Core/NonCopyable.h"
+#include "Core/NonMovable.h"
+
+// The parts of Core/Utility.h that headless code uses
+#define assert_msg( isTrue, ... ) assert(isTrue)
+
+// The parts of Core/Math/CommonMath.h that headless code uses
+namespace Math
+{
+template <typename T> inline T AlignUp(T value, size_t alignment) noexcept
+{
+	return (T)(((size_t)value + alignment - 1) & ~(alignment - 1));
+}
+
+template <typename T> inline T DivideByMultiple(T value, size_t alignment) noexcept
+{
+	return (T)((value + alignment - 1) / alignment);
+}
+} // namespace Math
+
+// The parts of LogSystem.h that headless code uses.  There is no log to write to, so messages are discarded.
+namespace Luna
+{
+class LogCategory : NonCopyable
+{
+public:
+	explicit LogCategory(const std::string&) {}
+};
+
+class NullLog
+{
+public:
+	class NullProxy
+	{
+	public:
+		template <typename T>
+		NullProxy& operator<<(const T&) { return *this; }
+		NullProxy& operator<<(std::ostream& (*)(std::ostream&)) { return *this; }
+	};
+
+	NullProxy operator()(const LogCategory&) const { return NullProxy{}; }
+};
+
+inline NullLog LogError;
+inline NullLog LogWarning;
+inline NullLog LogInfo;
+} // namespace Luna
+
+// The parts of Core/Profiling.h that headless code uses.  There is no profiler to report to.
+namespace Luna
+{
+class ScopedEvent
+{
+public:
+	explicit ScopedEvent(const std::string&) {}
+};
+} // namespace Luna
@@ -0,0 +1,172 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Core/CpuFeatures.h"
+#include "Core/Math/BatchKernels.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+// Milliseconds for each batch function on one path, and its outputs, which every path must match bit for bit
+struct PathResult
+{
+	double pointsMs{ 0.0 };
+	double matricesMs{ 0.0 };
+	double boxesMs{ 0.0 };
+	double boundsMs{ 0.0 };
+	double sphereMs{ 0.0 };
+	vector<float> points;
+	vector<float> matrices;
+	vector<float> boxes;
+	BatchBounds bounds;
+	float center[3]{};
+	float radius{ 0.0f };
+};
+
+
+struct InputData
+{
+	vector<float> mat;
+	vector<float> points;
+	vector<float> matrices;
+	vector<float> otherMatrices;
+	vector<float> boxes;
+	vector<float> x;
+	vector<float> y;
+	vector<float> z;
+	vector<float> radius;
+};
+
+
+InputData MakeInputData(uint32_t count, mt19937& rng)
+{
+	uniform_real_distribution<float> value{ -100.0f, 100.0f };
+	uniform_real_distribution<float> size{ 0.1f, 5.0f };
+	auto fill = [&](size_t n, auto& distribution)
+		{
+			vector<float> values(n);
+			for (auto& v : values)
+			{
+				v = distribution(rng);
+			}
+			return values;
+		};
+
+	InputData data;
+	data.mat = fill(16, value);
+	data.points = fill(4 * (size_t)count, value);
+	data.matrices = fill(16 * (size_t)count, value);
+	data.otherMatrices = fill(16 * (size_t)count, value);
+	data.boxes = fill(8 * (size_t)count, value);
+	data.x = fill(count, value);
+	data.y = fill(count, value);
+	data.z = fill(count, value);
+	data.radius = fill(count, size);
+	return data;
+}
+
+
+PathResult RunPath(BatchPath path, const InputData& data, uint32_t count, uint32_t numRuns)
+{
+	PathResult result;
+	result.points.resize(4 * (size_t)count);
+	result.matrices.resize(16 * (size_t)count);
+	result.boxes.resize(8 * (size_t)count);
+
+	const Vector3SoA points{ data.x, data.y, data.z };
+	const BoundingSphereSoA spheres{ data.x, data.y, data.z, data.radius };
+
+	result.pointsMs = MeasureMs(numRuns, [&] { TransformPoints(data.mat.data(), data.points.data(), result.points.data(), count, path); });
+	result.matricesMs = MeasureMs(numRuns, [&] { MultiplyMatrices(data.matrices.data(), data.otherMatrices.data(), result.matrices.data(), count, path); });
+	result.boxesMs = MeasureMs(numRuns, [&] { TransformBoundingBoxes(data.matrices.data(), data.boxes.data(), 8, result.boxes.data(), count, path); });
+	result.boundsMs = MeasureMs(numRuns, [&] { result.bounds = ComputeBounds(points, path); });
+	result.sphereMs = MeasureMs(numRuns, [&] { ComputeBoundingSphere(spheres, result.center, result.radius, path); });
+
+	return result;
+}
+
+
+const char* GetPathName(BatchPath path)
+{
+	switch (path)
+	{
+	case BatchPath::Scalar: return "Scalar";
+	case BatchPath::SSE: return "SSE";
+	case BatchPath::AVX: return "AVX";
+	default: return "Best";
+	}
+}
+
+
+bool SameBits(const vector<float>& a, const vector<float>& b)
+{
+	return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t count = commandLine.Size(1000000, 10000);
+	const uint32_t numRuns = commandLine.Size(10, 1);
+
+	mt19937 rng{ 1234 };
+	const InputData data = MakeInputData(count, rng);
+
+	vector<BatchPath> paths{ BatchPath::Scalar, BatchPath::SSE };
+	if (HasAVX())
+	{
+		paths.push_back(BatchPath::AVX);
+	}
+
+	printf("Batch math benchmark, %u elements, fastest of %u runs, ns/element and speedup over scalar\n\n", count, numRuns);
+	printf("%-8s %22s %22s %22s %22s %22s\n", "Path", "TransformPoints", "MultiplyMatrices", "TransformBoxes", "ComputeBounds", "BoundingSphere");
+
+	PathResult scalar;
+	for (BatchPath path : paths)
+	{
+		PathResult result = RunPath(path, data, count, numRuns);
+		if (path == BatchPath::Scalar)
+		{
+			scalar = result;
+		}
+
+		printf("%-8s %12.2f ns %6.2fx %12.2f ns %6.2fx %12.2f ns %6.2fx %12.2f ns %6.2fx %12.2f ns %6.2fx\n", GetPathName(path),
+			result.pointsMs * 1.0e6 / count, scalar.pointsMs / result.pointsMs,
+			result.matricesMs * 1.0e6 / count, scalar.matricesMs / result.matricesMs,
+			result.boxesMs * 1.0e6 / count, scalar.boxesMs / result.boxesMs,
+			result.boundsMs * 1.0e6 / count, scalar.boundsMs / result.boundsMs,
+			result.sphereMs * 1.0e6 / count, scalar.sphereMs / result.sphereMs);
+
+		Check(SameBits(result.points, scalar.points), "every path transforms points to the same bits as the scalar path");
+		Check(SameBits(result.matrices, scalar.matrices), "every path multiplies matrices to the same bits as the scalar path");
+		Check(SameBits(result.boxes, scalar.boxes), "every path transforms boxes to the same bits as the scalar path");
+		Check(memcmp(&result.bounds, &scalar.bounds, sizeof(BatchBounds)) == 0, "every path finds the same bounds as the scalar path");
+		Check(memcmp(result.center, scalar.center, sizeof(result.center)) == 0 && result.radius == scalar.radius, "every path finds the same sphere as the scalar path");
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
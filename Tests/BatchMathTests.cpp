@@ -0,0 +1,339 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Core/CpuFeatures.h"
+#include "Core/Math/BatchKernels.h"
+
+#include "Benchmark.h"
+
+#include <cfloat>
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+// The operation order documented in BatchMath.cpp, written out one float at a time.  Every path must match
+// these bit for bit.
+void ReferenceTransformPoint(const float* mat, const float* point, float* outPoint)
+{
+	for (size_t c = 0; c < 4; ++c)
+	{
+		outPoint[c] = ((mat[12 + c] + point[2] * mat[8 + c]) + point[1] * mat[4 + c]) + point[0] * mat[c];
+	}
+}
+
+
+void ReferenceMultiplyMatrix(const float* lhs, const float* rhs, float* outMatrix)
+{
+	for (size_t r = 0; r < 4; ++r)
+	{
+		for (size_t c = 0; c < 4; ++c)
+		{
+			outMatrix[4 * r + c] = (rhs[4 * r] * lhs[c] + rhs[4 * r + 2] * lhs[8 + c]) + (rhs[4 * r + 1] * lhs[4 + c] + rhs[4 * r + 3] * lhs[12 + c]);
+		}
+	}
+}
+
+
+void ReferenceTransformBox(const float* mat, const float* box, float* outBox)
+{
+	ReferenceTransformPoint(mat, box, outBox);
+	for (size_t c = 0; c < 4; ++c)
+	{
+		outBox[4 + c] = (box[6] * fabsf(mat[8 + c]) + box[5] * fabsf(mat[4 + c])) + box[4] * fabsf(mat[c]);
+	}
+}
+
+
+// Within a few rounding errors of the exact result, which is computed in double precision along with the sum of
+// the magnitudes of its terms.  Catches a kernel that matches the reference because both are wrong.
+bool IsClose(float value, double exact, double magnitude)
+{
+	return fabs((double)value - exact) <= 4.0 * FLT_EPSILON * magnitude;
+}
+
+
+vector<BatchPath> GetPaths()
+{
+	vector<BatchPath> paths{ BatchPath::Scalar, BatchPath::SSE, BatchPath::Best };
+	if (HasAVX())
+	{
+		paths.push_back(BatchPath::AVX);
+	}
+	return paths;
+}
+
+
+// Values across many exponents and both signs, so that rounding differences between paths show up
+vector<float> MakeValues(size_t count, mt19937& rng)
+{
+	uniform_real_distribution<float> mantissa{ -1.0f, 1.0f };
+	uniform_int_distribution<int> exponent{ -8, 8 };
+
+	vector<float> values(count);
+	for (auto& value : values)
+	{
+		value = ldexpf(mantissa(rng), exponent(rng));
+	}
+	return values;
+}
+
+
+// The kernels take unaligned pointers, so the data starts one float into its buffer
+constexpr size_t s_offset = 1;
+
+bool SameBits(const float* a, const float* b, size_t count)
+{
+	return memcmp(a, b, count * sizeof(float)) == 0;
+}
+
+
+void TestTransformPoints(mt19937& rng)
+{
+	for (size_t count = 0; count <= 17; ++count)
+	{
+		const vector<float> mat = MakeValues(16, rng);
+		const vector<float> points = MakeValues(s_offset + 4 * count, rng);
+
+		vector<float> expected(4 * count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			ReferenceTransformPoint(mat.data(), points.data() + s_offset + 4 * i, expected.data() + 4 * i);
+
+			for (size_t c = 0; c < 4; ++c)
+			{
+				const float* point = points.data() + s_offset + 4 * i;
+				const double exact = (double)mat[12 + c] + (double)point[2] * mat[8 + c] + (double)point[1] * mat[4 + c] + (double)point[0] * mat[c];
+				const double magnitude = fabs(mat[12 + c]) + fabs((double)point[2] * mat[8 + c]) + fabs((double)point[1] * mat[4 + c]) + fabs((double)point[0] * mat[c]);
+				Check(IsClose(expected[4 * i + c], exact, magnitude), "transformed points are within a few ULPs of the exact result");
+			}
+		}
+
+		for (BatchPath path : GetPaths())
+		{
+			vector<float> out(s_offset + 4 * count, -1.0f);
+			TransformPoints(mat.data(), points.data() + s_offset, out.data() + s_offset, count, path);
+			Check(SameBits(out.data() + s_offset, expected.data(), 4 * count), "transformed points match the reference bit for bit");
+
+			vector<float> inPlace = points;
+			TransformPoints(mat.data(), inPlace.data() + s_offset, inPlace.data() + s_offset, count, path);
+			Check(SameBits(inPlace.data() + s_offset, expected.data(), 4 * count), "points transformed in place match the reference");
+		}
+	}
+}
+
+
+void TestMultiplyMatrices(mt19937& rng)
+{
+	for (size_t count = 0; count <= 17; ++count)
+	{
+		const vector<float> a = MakeValues(s_offset + 16 * count, rng);
+		const vector<float> b = MakeValues(s_offset + 16 * count, rng);
+
+		vector<float> expected(16 * count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float* lhs = a.data() + s_offset + 16 * i;
+			const float* rhs = b.data() + s_offset + 16 * i;
+			ReferenceMultiplyMatrix(lhs, rhs, expected.data() + 16 * i);
+
+			for (size_t r = 0; r < 4; ++r)
+			{
+				for (size_t c = 0; c < 4; ++c)
+				{
+					double exact = 0.0;
+					double magnitude = 0.0;
+					for (size_t k = 0; k < 4; ++k)
+					{
+						exact += (double)rhs[4 * r + k] * lhs[4 * k + c];
+						magnitude += fabs((double)rhs[4 * r + k] * lhs[4 * k + c]);
+					}
+					Check(IsClose(expected[16 * i + 4 * r + c], exact, magnitude), "matrix products are within a few ULPs of the exact result");
+				}
+			}
+		}
+
+		for (BatchPath path : GetPaths())
+		{
+			vector<float> out(s_offset + 16 * count, -1.0f);
+			MultiplyMatrices(a.data() + s_offset, b.data() + s_offset, out.data() + s_offset, count, path);
+			Check(SameBits(out.data() + s_offset, expected.data(), 16 * count), "matrix products match the reference bit for bit");
+
+			// Either input may also be the output
+			vector<float> inPlaceA = a;
+			MultiplyMatrices(inPlaceA.data() + s_offset, b.data() + s_offset, inPlaceA.data() + s_offset, count, path);
+			Check(SameBits(inPlaceA.data() + s_offset, expected.data(), 16 * count), "products written over the left matrices match the reference");
+
+			vector<float> inPlaceB = b;
+			MultiplyMatrices(a.data() + s_offset, inPlaceB.data() + s_offset, inPlaceB.data() + s_offset, count, path);
+			Check(SameBits(inPlaceB.data() + s_offset, expected.data(), 16 * count), "products written over the right matrices match the reference");
+		}
+	}
+}
+
+
+void TestTransformBoxes(mt19937& rng)
+{
+	for (size_t boxStride : { (size_t)8, (size_t)0 })
+	{
+		for (size_t count = 0; count <= 17; ++count)
+		{
+			const vector<float> matrices = MakeValues(s_offset + 16 * count, rng);
+			vector<float> boxes = MakeValues(s_offset + 8 * max(count, (size_t)1), rng);
+			for (size_t i = 0; i < max(count, (size_t)1); ++i)
+			{
+				for (size_t c = 4; c < 8; ++c)
+				{
+					boxes[s_offset + 8 * i + c] = fabsf(boxes[s_offset + 8 * i + c]);
+				}
+			}
+
+			vector<float> expected(8 * count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float* mat = matrices.data() + s_offset + 16 * i;
+				const float* box = boxes.data() + s_offset + boxStride * i;
+				ReferenceTransformBox(mat, box, expected.data() + 8 * i);
+
+				// The extents must cover every transformed corner
+				for (int corner = 0; corner < 8; ++corner)
+				{
+					float point[4];
+					point[0] = box[0] + ((corner & 1) ? box[4] : -box[4]);
+					point[1] = box[1] + ((corner & 2) ? box[5] : -box[5]);
+					point[2] = box[2] + ((corner & 4) ? box[6] : -box[6]);
+					point[3] = 1.0f;
+
+					for (size_t c = 0; c < 3; ++c)
+					{
+						const double exact = (double)mat[12 + c] + (double)point[2] * mat[8 + c] + (double)point[1] * mat[4 + c] + (double)point[0] * mat[c];
+						const double magnitude = fabs(mat[12 + c]) + fabs((double)point[2] * mat[8 + c]) + fabs((double)point[1] * mat[4 + c]) + fabs((double)point[0] * mat[c]);
+						const double distance = fabs(exact - expected[8 * i + c]);
+						Check(distance <= expected[8 * i + 4 + c] + 8.0 * FLT_EPSILON * magnitude, "transformed boxes cover every transformed corner");
+					}
+				}
+			}
+
+			for (BatchPath path : GetPaths())
+			{
+				vector<float> out(s_offset + 8 * count, -1.0f);
+				TransformBoundingBoxes(matrices.data() + s_offset, boxes.data() + s_offset, boxStride, out.data() + s_offset, count, path);
+				Check(SameBits(out.data() + s_offset, expected.data(), 8 * count), "transformed boxes match the reference bit for bit");
+
+				if (boxStride != 0)
+				{
+					vector<float> inPlace = boxes;
+					TransformBoundingBoxes(matrices.data() + s_offset, inPlace.data() + s_offset, boxStride, inPlace.data() + s_offset, count, path);
+					Check(SameBits(inPlace.data() + s_offset, expected.data(), 8 * count), "boxes transformed in place match the reference");
+				}
+			}
+		}
+	}
+}
+
+
+bool SameBounds(const BatchBounds& a, const BatchBounds& b)
+{
+	return equal(begin(a.min), end(a.min), begin(b.min)) && equal(begin(a.max), end(a.max), begin(b.max));
+}
+
+
+void TestBounds(mt19937& rng)
+{
+	// Counts around the 4 and 8 wide kernels, and a larger one that goes through all three
+	for (size_t count : { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 1003 })
+	{
+		vector<vector<float>> arrays;
+		for (int a = 0; a < 7; ++a)
+		{
+			arrays.push_back(MakeValues(s_offset + count, rng));
+		}
+		for (auto& value : arrays[6])
+		{
+			value = fabsf(value);
+		}
+		auto getSpan = [&](int a) { return span<const float>{ arrays[a].data() + s_offset, count }; };
+
+		const Vector3SoA points{ getSpan(0), getSpan(1), getSpan(2) };
+		const BoundingBoxSoA boxes{ getSpan(0), getSpan(1), getSpan(2), getSpan(3), getSpan(4), getSpan(5) };
+		const BoundingSphereSoA spheres{ getSpan(0), getSpan(1), getSpan(2), getSpan(6) };
+
+		BatchBounds expectedPoints{};
+		BatchBounds expectedBoxes{};
+		BatchBounds sphereBounds{};
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const float low = arrays[c][s_offset + i];
+				const float high = arrays[3 + c][s_offset + i];
+				const float radius = arrays[6][s_offset + i];
+
+				expectedPoints.min[c] = i == 0 ? low : min(expectedPoints.min[c], low);
+				expectedPoints.max[c] = i == 0 ? low : max(expectedPoints.max[c], low);
+				expectedBoxes.min[c] = i == 0 ? low : min(expectedBoxes.min[c], low);
+				expectedBoxes.max[c] = i == 0 ? high : max(expectedBoxes.max[c], high);
+				sphereBounds.min[c] = i == 0 ? low - radius : min(sphereBounds.min[c], low - radius);
+				sphereBounds.max[c] = i == 0 ? low + radius : max(sphereBounds.max[c], low + radius);
+			}
+		}
+
+		float expectedCenter[3];
+		float expectedRadius{ 0.0f };
+		for (int c = 0; c < 3; ++c)
+		{
+			expectedCenter[c] = 0.5f * (sphereBounds.min[c] + sphereBounds.max[c]);
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float dx = spheres.centerX[i] - expectedCenter[0];
+			const float dy = spheres.centerY[i] - expectedCenter[1];
+			const float dz = spheres.centerZ[i] - expectedCenter[2];
+			expectedRadius = max(expectedRadius, sqrtf((dx * dx + dy * dy) + dz * dz) + spheres.radius[i]);
+		}
+
+		for (BatchPath path : GetPaths())
+		{
+			Check(SameBounds(ComputeBounds(points, path), expectedPoints), "point bounds match the reference");
+			Check(SameBounds(ComputeBounds(boxes, path), expectedBoxes), "box unions match the reference");
+
+			float center[3] = { -1.0f, -1.0f, -1.0f };
+			float radius{ -1.0f };
+			ComputeBoundingSphere(spheres, center, radius, path);
+			Check(equal(begin(center), end(center), begin(expectedCenter)) && radius == expectedRadius, "sphere unions match the reference");
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestTransformPoints(rng);
+	TestMultiplyMatrices(rng);
+	TestTransformBoxes(rng);
+	TestBounds(rng);
+
+	printf("Batch math: every path matches the reference%s\n", HasAVX() ? ", AVX included" : ", AVX not supported here");
+
+	return FailureCount() == 0 ? 0 : 1;
+}
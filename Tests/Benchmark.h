@@ -0,0 +1,117 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+
+namespace Luna::Benchmark
+{
+
+// Command line shared by the benchmarks.  --quick shrinks every run to a smoke test, which is how ctest runs
+// them.  Other options are read with GetOption().
+struct CommandLine
+{
+	int argc{ 0 };
+	char** argv{ nullptr };
+	bool quick{ false };
+
+	CommandLine(int argc, char* argv[])
+		: argc{ argc }
+		, argv{ argv }
+	{
+		quick = HasFlag("--quick");
+	}
+
+	bool HasFlag(const char* name) const
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			if (strcmp(argv[i], name) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	uint32_t GetOption(const char* name, uint32_t defaultValue) const
+	{
+		for (int i = 1; i + 1 < argc; ++i)
+		{
+			if (strcmp(argv[i], name) == 0)
+			{
+				return (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+			}
+		}
+		return defaultValue;
+	}
+
+	// The full size, or the smaller one with --quick
+	uint32_t Size(uint32_t fullSize, uint32_t quickSize) const { return quick ? quickSize : fullSize; }
+};
+
+
+// Runs the function numRuns times and returns the fastest run, in milliseconds.  The fastest run is the one
+// least disturbed by the rest of the machine, so it is the most repeatable figure to compare.
+template <class TFunction>
+double MeasureMs(uint32_t numRuns, TFunction&& function)
+{
+	double bestMs = std::numeric_limits<double>::max();
+	for (uint32_t i = 0; i < std::max(numRuns, 1u); ++i)
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		function();
+		const auto endTime = std::chrono::steady_clock::now();
+
+		bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(endTime - startTime).count());
+	}
+	return bestMs;
+}
+
+
+// Keeps the compiler from discarding a result that is otherwise unused
+template <class T>
+void KeepResult(const T& value)
+{
+	static volatile uint8_t s_sink;
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	for (size_t i = 0; i < sizeof(T); ++i)
+	{
+		s_sink = s_sink + bytes[i];
+	}
+}
+
+
+// Reports a wrong result.  The benchmark still finishes, but exits with a failure.
+inline int& FailureCount()
+{
+	static int s_numFailures{ 0 };
+	return s_numFailures;
+}
+
+
+inline void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "FAILED: %s\n", what);
+		++FailureCount();
+	}
+}
+
+} // namespace Luna::Benchmark
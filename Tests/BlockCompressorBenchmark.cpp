@@ -0,0 +1,118 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/BlockCompressor.h"
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureInitializer.h"
+
+#include "Core/CpuFeatures.h"
+
+#include "Benchmark.h"
+
+#include <random>
+#include <thread>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Smooth colour with some noise, and a translucent alpha, so every format has work to do in every block
+vector<std::byte> MakeImage(uint32_t width, uint32_t height)
+{
+	mt19937 rng{ 1234 };
+
+	vector<std::byte> texels((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const double u = (double)x / width;
+			const double v = (double)y / height;
+			const double rgba[4]{
+				0.5 + 0.3 * sin(u * 23.0) + 0.1 * sin(v * 31.0),
+				0.5 + 0.3 * sin(v * 17.0) * cos(u * 13.0),
+				0.4 + 0.3 * cos((u + v) * 19.0),
+				0.6 + 0.3 * sin(u * 11.0) * sin(v * 9.0) };
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				const double noise = (double)(rng() % 9) - 4.0;
+				texels[((size_t)y * width + x) * 4 + c] = (std::byte)clamp(rgba[c] * 255.0 + noise, 0.0, 255.0);
+			}
+		}
+	}
+	return texels;
+}
+
+
+// Compresses the whole chain numRuns times and returns the fastest, in megapixels per second over all levels
+double MeasureMPixps(Format format, const TextureInitializer& source, bool allowSimd, bool allowParallel, uint32_t numRuns,
+	vector<std::byte>& outStorage, double& outPsnr)
+{
+	const BlockCompressionDesc desc{ .format = format, .allowSimd = allowSimd, .allowParallel = allowParallel };
+
+	TextureInitializer texInit;
+	bool succeeded = true;
+	const double ms = MeasureMs(numRuns, [&] { succeeded = CompressTexture(desc, source, outStorage, texInit) && succeeded; });
+
+	BlockCompressionStats stats;
+	succeeded = CompressTexture(desc, source, outStorage, texInit, &stats) && succeeded;
+	Check(succeeded, "the texture was compressed");
+
+	outPsnr = stats.psnr;
+	return (double)stats.numTexels / (ms * 1.0e3);
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t size = commandLine.GetOption("--size", commandLine.Size(1024, 64));
+	const uint32_t numRuns = commandLine.Size(3, 1);
+
+	JobSystem jobSystem{ max(thread::hardware_concurrency(), 1u) - 1 };
+
+	const auto texels = MakeImage(size, size);
+	vector<std::byte> sourceStorage;
+	TextureInitializer source;
+	GenerateMipChain({ .format = Format::RGBA8_UNorm, .width = size, .height = size }, texels.data(), sourceStorage, source);
+
+	printf("Block compression benchmark, %ux%u with mips, %s kernels, %u threads, fastest of %u runs\n\n", size, size,
+		HasAVX2() && HasSSE41() ? "AVX2" : HasSSE41() ? "SSE4.1" : "scalar", jobSystem.GetNumWorkers() + 1, numRuns);
+	printf("%-6s %16s %16s %8s %16s %8s %10s\n", "Format", "Scalar", "SIMD", "Speedup", "SIMD, jobs", "Speedup", "PSNR");
+
+	for (Format format : { Format::BC1_UNorm, Format::BC3_UNorm, Format::BC4_UNorm, Format::BC5_UNorm, Format::BC7_UNorm })
+	{
+		vector<std::byte> scalarStorage;
+		vector<std::byte> simdStorage;
+		vector<std::byte> parallelStorage;
+		double psnr{ 0.0 };
+
+		const double scalarMPixps = MeasureMPixps(format, source, false, false, numRuns, scalarStorage, psnr);
+		const double simdMPixps = MeasureMPixps(format, source, true, false, numRuns, simdStorage, psnr);
+		const double parallelMPixps = MeasureMPixps(format, source, true, true, numRuns, parallelStorage, psnr);
+
+		Check(scalarStorage == simdStorage && scalarStorage == parallelStorage, "every path produces the same blocks");
+
+		printf("%-6s %10.2f MPix/s %10.2f MPix/s %7.1fx %10.2f MPix/s %7.1fx %7.2f dB\n", GetBlockCompressedFormatName(format),
+			scalarMPixps, simdMPixps, simdMPixps / scalarMPixps, parallelMPixps, parallelMPixps / scalarMPixps, psnr);
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,335 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/BlockCompressor.h"
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureInitializer.h"
+
+#include "Benchmark.h"
+
+#include <numbers>
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Procedural RGBA8 test images, so the PSNR floors below always measure the same texels
+enum class TestImage
+{
+	Gradient,	// Smooth colour and alpha ramps
+	Detail,		// Overlapping sine waves with a little noise, like a photograph
+	Edges,		// Flat coloured cells with hard edges that cut through blocks, and a cut-out alpha
+	NormalMap	// Tangent-space bumps, with X and Y in red and green
+};
+
+const char* GetTestImageName(TestImage image)
+{
+	switch (image)
+	{
+	case TestImage::Gradient:	return "gradient";
+	case TestImage::Detail:		return "detail";
+	case TestImage::Edges:		return "edges";
+	default:					return "normal map";
+	}
+}
+
+
+uint8_t ToUNorm8(double value)
+{
+	return (uint8_t)clamp(value * 255.0 + 0.5, 0.0, 255.0);
+}
+
+
+vector<std::byte> MakeImage(TestImage image, uint32_t width, uint32_t height)
+{
+	mt19937 rng{ 1234 };
+	uniform_real_distribution<double> noise{ -0.03, 0.03 };
+
+	vector<std::byte> texels((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const double u = (x + 0.5) / width;
+			const double v = (y + 0.5) / height;
+			double rgba[4]{ 0.0, 0.0, 0.0, 1.0 };
+
+			switch (image)
+			{
+			case TestImage::Gradient:
+				rgba[0] = u;
+				rgba[1] = v;
+				rgba[2] = 1.0 - 0.5 * (u + v);
+				rgba[3] = 0.25 + 0.75 * u * v;
+				break;
+
+			case TestImage::Detail:
+				rgba[0] = 0.5 + 0.25 * sin(u * 23.0) + 0.2 * sin(v * 31.0 + u * 7.0) + noise(rng);
+				rgba[1] = 0.5 + 0.3 * sin(v * 17.0 + 1.0) * cos(u * 13.0) + noise(rng);
+				rgba[2] = 0.4 + 0.3 * cos((u + v) * 19.0) + noise(rng);
+				rgba[3] = 0.6 + 0.3 * sin(u * 11.0) * sin(v * 9.0);
+				break;
+
+			case TestImage::Edges:
+			{
+				const uint32_t cell = (x / 6 + y / 5) % 4;
+				const double colors[4][3]{ { 0.9, 0.1, 0.1 }, { 0.1, 0.8, 0.2 }, { 0.2, 0.3, 0.9 }, { 0.95, 0.9, 0.2 } };
+				rgba[0] = colors[cell][0];
+				rgba[1] = colors[cell][1];
+				rgba[2] = colors[cell][2];
+				rgba[3] = ((x / 7 + y / 9) % 3) == 0 ? 0.0 : 1.0;
+				break;
+			}
+
+			default:
+			{
+				const double dx = 0.6 * cos(u * 2.0 * numbers::pi * 3.0) * sin(v * 2.0 * numbers::pi * 2.0);
+				const double dy = 0.6 * sin(u * 2.0 * numbers::pi * 3.0) * cos(v * 2.0 * numbers::pi * 2.0);
+				const double length = sqrt(dx * dx + dy * dy + 1.0);
+				rgba[0] = 0.5 + 0.5 * dx / length;
+				rgba[1] = 0.5 + 0.5 * dy / length;
+				rgba[2] = 0.5 + 0.5 / length;
+				break;
+			}
+			}
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				texels[((size_t)y * width + x) * 4 + c] = (std::byte)ToUNorm8(rgba[c]);
+			}
+		}
+	}
+	return texels;
+}
+
+
+struct SourceTexture
+{
+	vector<std::byte> storage;
+	TextureInitializer texInit;
+};
+
+
+SourceTexture MakeSourceTexture(TestImage image, uint32_t width, uint32_t height, bool isSrgb = false)
+{
+	const auto texels = MakeImage(image, width, height);
+
+	SourceTexture source;
+	const MipGenerationDesc desc{ .format = isSrgb ? Format::SRGBA8_UNorm : Format::RGBA8_UNorm, .width = width, .height = height };
+	GenerateMipChain(desc, texels.data(), source.storage, source.texInit);
+	return source;
+}
+
+
+uint32_t GetNumStoredChannels(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1_UNorm:
+	case Format::BC1_UNorm_Srgb:	return 3;
+	case Format::BC4_UNorm:			return 1;
+	case Format::BC5_UNorm:			return 2;
+	default:						return 4;
+	}
+}
+
+
+// PSNR of the top level, decoded with DecompressBlocks(), over the channels the format stores
+double MeasurePsnr(Format format, const TextureSubresourceData& srcLevel, const TextureSubresourceData& dstLevel)
+{
+	const uint32_t numChannels = GetNumStoredChannels(format);
+
+	vector<std::byte> decoded((size_t)srcLevel.width * srcLevel.height * 4);
+	DecompressBlocks(format, dstLevel.data, srcLevel.width, srcLevel.height, decoded.data());
+
+	double totalError = 0.0;
+	for (size_t i = 0; i < (size_t)srcLevel.width * srcLevel.height; ++i)
+	{
+		for (uint32_t c = 0; c < numChannels; ++c)
+		{
+			const double delta = (double)srcLevel.data[i * 4 + c] - (double)decoded[i * 4 + c];
+			totalError += delta * delta;
+		}
+	}
+
+	const double meanSquaredError = totalError / ((double)srcLevel.width * srcLevel.height * numChannels);
+	return meanSquaredError > 0.0 ? 10.0 * log10(255.0 * 255.0 / meanSquaredError) : numeric_limits<double>::infinity();
+}
+
+
+void TestFormatSelection()
+{
+	Check(GetBlockCompressedFormat(TextureUsage::Default, false, false) == Format::Unknown, "default usage is not compressed");
+	Check(GetBlockCompressedFormat(TextureUsage::Albedo, false, false) == Format::BC1_UNorm, "opaque albedo is BC1");
+	Check(GetBlockCompressedFormat(TextureUsage::Albedo, true, false) == Format::BC3_UNorm, "translucent albedo is BC3");
+	Check(GetBlockCompressedFormat(TextureUsage::Albedo, false, true) == Format::BC1_UNorm_Srgb, "sRGB albedo stays sRGB");
+	Check(GetBlockCompressedFormat(TextureUsage::AlbedoHighQuality, true, true) == Format::BC7_UNorm_Srgb, "high quality albedo is BC7");
+	Check(GetBlockCompressedFormat(TextureUsage::NormalMap, false, true) == Format::BC5_UNorm, "normal maps are BC5, never sRGB");
+	Check(GetBlockCompressedFormat(TextureUsage::Mask, false, true) == Format::BC4_UNorm, "masks are BC4, never sRGB");
+
+	Check(IsBlockCompressionSupported(Format::RGBA8_UNorm) && IsBlockCompressionSupported(Format::SRGBA8_UNorm), "RGBA8 sources are supported");
+	Check(!IsBlockCompressionSupported(Format::RGBA16_UNorm), "other sources are not");
+}
+
+
+// Every level is laid out back to back as in a DDS file, with partial blocks at the edges of odd sizes
+void TestLayout()
+{
+	const SourceTexture source = MakeSourceTexture(TestImage::Detail, 37, 29);
+
+	vector<std::byte> storage;
+	TextureInitializer texInit;
+	Check(CompressTexture({ .format = Format::BC7_UNorm }, source.texInit, storage, texInit), "an odd-sized texture compresses");
+	Check(texInit.numMips == source.texInit.numMips && texInit.subResourceData.size() == source.texInit.subResourceData.size(), "every level is compressed");
+
+	size_t offset = 0;
+	bool isPacked = true;
+	for (const auto& level : texInit.subResourceData)
+	{
+		const size_t numBlocksWide = max(1u, (level.width + 3) / 4);
+		const size_t numBlocksHigh = max(1u, (level.height + 3) / 4);
+		isPacked = isPacked && level.bufferOffset == offset && level.rowPitch == numBlocksWide * 16 && level.slicePitch == level.rowPitch * numBlocksHigh;
+		isPacked = isPacked && level.data == storage.data() + offset;
+		offset += level.slicePitch;
+	}
+	Check(isPacked && texInit.totalBytes == offset && storage.size() % 16 == 0, "levels are packed back to back, with whole blocks");
+
+	SourceTexture unsupported = MakeSourceTexture(TestImage::Detail, 8, 8);
+	unsupported.texInit.format = Format::RGBA16_UNorm;
+	Check(!CompressTexture({ .format = Format::BC1_UNorm }, unsupported.texInit, storage, texInit), "unsupported sources fail");
+	Check(!CompressTexture({ .format = Format::RGBA8_UNorm }, source.texInit, storage, texInit), "uncompressed targets fail");
+}
+
+
+// Each format must keep the quality it had when its floor was set.  The floors sit about 1 dB under the
+// measured values, so that a regression in endpoint fitting or index selection fails here.
+void TestQuality()
+{
+	struct QualityCase
+	{
+		TestImage image;
+		Format format;
+		double minPsnr;				// Top level
+		double minPsnrAllLevels;	// As reported in BlockCompressionStats
+	};
+
+	const QualityCase cases[] = {
+		{ TestImage::Gradient,	Format::BC1_UNorm,	37.5,	32.0 },
+		{ TestImage::Detail,	Format::BC1_UNorm,	25.5,	23.0 },
+		{ TestImage::Edges,		Format::BC1_UNorm,	22.0,	19.0 },
+		{ TestImage::Gradient,	Format::BC3_UNorm,	38.5,	33.5 },
+		{ TestImage::Detail,	Format::BC3_UNorm,	27.0,	24.5 },
+		{ TestImage::Edges,		Format::BC3_UNorm,	23.5,	20.5 },
+		{ TestImage::Gradient,	Format::BC4_UNorm,	50.0,	48.0 },
+		{ TestImage::Detail,	Format::BC4_UNorm,	36.5,	35.0 },
+		{ TestImage::NormalMap,	Format::BC5_UNorm,	43.5,	41.0 },
+		{ TestImage::Detail,	Format::BC5_UNorm,	38.5,	37.0 },
+		{ TestImage::Gradient,	Format::BC7_UNorm,	40.0,	34.0 },
+		{ TestImage::Detail,	Format::BC7_UNorm,	27.5,	24.5 },
+		{ TestImage::Edges,		Format::BC7_UNorm,	17.0,	16.0 }
+	};
+
+	for (const QualityCase& qualityCase : cases)
+	{
+		const SourceTexture source = MakeSourceTexture(qualityCase.image, 64, 64);
+
+		vector<std::byte> storage;
+		TextureInitializer texInit;
+		BlockCompressionStats stats;
+		const bool succeeded = CompressTexture({ .format = qualityCase.format }, source.texInit, storage, texInit, &stats);
+
+		const double psnr = succeeded ? MeasurePsnr(qualityCase.format, source.texInit.subResourceData[0], texInit.subResourceData[0]) : 0.0;
+		printf("%-4s %-11s %6.2f dB, %6.2f dB over all levels\n", GetBlockCompressedFormatName(qualityCase.format), GetTestImageName(qualityCase.image),
+			psnr, stats.psnr);
+
+		Check(succeeded && psnr >= qualityCase.minPsnr, "the compressed image meets its PSNR floor");
+		Check(stats.psnr >= qualityCase.minPsnrAllLevels, "the compressed mip chain meets its PSNR floor");
+	}
+}
+
+
+// A flat block holds its colour exactly in every format, when the colour is representable
+void TestFlatImage()
+{
+	// 0x84, 0x82 and 0x42 are exact in RGB565
+	vector<std::byte> texels(16 * 16 * 4);
+	for (size_t i = 0; i < texels.size(); i += 4)
+	{
+		texels[i] = (std::byte)0x84;
+		texels[i + 1] = (std::byte)0x82;
+		texels[i + 2] = (std::byte)0x42;
+		texels[i + 3] = (std::byte)0xc0;
+	}
+
+	SourceTexture source;
+	GenerateMipChain({ .format = Format::RGBA8_UNorm, .width = 16, .height = 16 }, texels.data(), source.storage, source.texInit);
+
+	for (Format format : { Format::BC1_UNorm, Format::BC3_UNorm, Format::BC4_UNorm, Format::BC5_UNorm, Format::BC7_UNorm })
+	{
+		vector<std::byte> storage;
+		TextureInitializer texInit;
+		CompressTexture({ .format = format }, source.texInit, storage, texInit);
+
+		Check(isinf(MeasurePsnr(format, source.texInit.subResourceData[0], texInit.subResourceData[0])), "a flat image compresses exactly");
+	}
+}
+
+
+// The SIMD kernels must produce the same bits as the scalar reference, and so must bands on the job system
+void TestSimdMatchesScalar()
+{
+	for (TestImage image : { TestImage::Gradient, TestImage::Detail, TestImage::Edges, TestImage::NormalMap })
+	{
+		// Large enough for the top levels to be split into bands
+		const SourceTexture source = MakeSourceTexture(image, 261, 130, image == TestImage::Detail);
+
+		for (Format format : { Format::BC1_UNorm, Format::BC3_UNorm, Format::BC4_UNorm, Format::BC5_UNorm, Format::BC7_UNorm })
+		{
+			vector<std::byte> scalarStorage;
+			vector<std::byte> simdStorage;
+			vector<std::byte> parallelStorage;
+			TextureInitializer texInit;
+
+			CompressTexture({ .format = format, .allowSimd = false, .allowParallel = false }, source.texInit, scalarStorage, texInit);
+			CompressTexture({ .format = format, .allowSimd = true, .allowParallel = false }, source.texInit, simdStorage, texInit);
+			CompressTexture({ .format = format, .allowSimd = true, .allowParallel = true }, source.texInit, parallelStorage, texInit);
+
+			if (scalarStorage != simdStorage || scalarStorage != parallelStorage)
+			{
+				fprintf(stderr, "%s, %s image\n", GetBlockCompressedFormatName(format), GetTestImageName(image));
+				Check(false, "the SIMD and parallel paths match the scalar one");
+				return;
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	JobSystem jobSystem{ 3 };
+
+	TestFormatSelection();
+	TestLayout();
+	TestQuality();
+	TestFlatImage();
+	TestSimdMatchesScalar();
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/ContextPool.h"
+
+#include "Benchmark.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// What a small draw records:  root constants, then the draw itself
+struct FakeDraw
+{
+	uint32_t rootConstants[4]{};
+	uint32_t vertexCount{ 0 };
+	uint32_t instanceCount{ 0 };
+};
+
+
+// Stands in for CommandContext, recording into a command list that keeps its capacity across resets, as command
+// allocators do
+struct FakeContext
+{
+	const CommandListType type;
+	vector<FakeDraw> commands;
+
+	explicit FakeContext(CommandListType type) : type{ type } {}
+
+	CommandListType GetType() const noexcept { return type; }
+	void Initialize() { commands.reserve(1024); }
+	void Reset() { commands.clear(); }
+};
+
+
+using FakeContextPool = ContextPool<FakeContext>;
+
+
+// One frame's draws split across numContexts contexts, as BeginParallelRecording() hands them out, and recorded
+// by whichever threads the job system has.  Returns the number of draws recorded.
+uint64_t RecordFrame(FakeContextPool& pool, uint32_t numDraws, uint32_t numContexts)
+{
+	atomic<uint64_t> numRecorded{ 0 };
+	const uint32_t drawsPerContext = numDraws / numContexts;
+
+	ParallelFor(numContexts, [&](uint32_t contextIndex)
+		{
+			FakeContext* context = pool.Allocate(CommandListType::Graphics);
+
+			const uint32_t firstDraw = contextIndex * drawsPerContext;
+			for (uint32_t i = firstDraw; i < firstDraw + drawsPerContext; ++i)
+			{
+				context->commands.push_back(FakeDraw{ .rootConstants = { i, i * 3, i * 7, contextIndex }, .vertexCount = 36, .instanceCount = 1 });
+			}
+
+			numRecorded.fetch_add(context->commands.size(), memory_order_relaxed);
+			pool.Free(context);
+		});
+
+	return numRecorded;
+}
+
+
+struct Result
+{
+	double sharedMs{ 0.0 };
+	double cachedMs{ 0.0 };
+	size_t numSharedContexts{ 0 };
+	size_t numCachedContexts{ 0 };
+};
+
+
+// Times one frame on numThreads threads, the calling thread and numThreads - 1 workers, with a pool created before
+// the job system, so every thread shares the locked free list, and with one created after, so workers keep their own
+Result Measure(uint32_t numThreads, uint32_t numDraws, uint32_t numContexts, uint32_t numRuns)
+{
+	const auto createFunction = [](CommandListType type) { return new FakeContext(type); };
+
+	FakeContextPool sharedPool{ createFunction };
+	unique_ptr<JobSystem> jobSystem = numThreads > 1 ? make_unique<JobSystem>(numThreads - 1) : nullptr;
+	FakeContextPool cachedPool{ createFunction };
+
+	uint64_t sharedRecorded{ 0 };
+	uint64_t cachedRecorded{ 0 };
+
+	Result result;
+	result.sharedMs = MeasureMs(numRuns, [&] { sharedRecorded = RecordFrame(sharedPool, numDraws, numContexts); });
+	result.cachedMs = MeasureMs(numRuns, [&] { cachedRecorded = RecordFrame(cachedPool, numDraws, numContexts); });
+	result.numSharedContexts = sharedPool.GetNumContexts();
+	result.numCachedContexts = cachedPool.GetNumContexts();
+
+	const uint64_t expected = (uint64_t)(numDraws / numContexts) * numContexts;
+	Check(sharedRecorded == expected && cachedRecorded == expected, "every draw was recorded");
+	Check(result.numSharedContexts <= numThreads && result.numCachedContexts <= numThreads,
+		"each thread reuses its contexts, so the pool needs no more than one per thread");
+
+	return result;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numDraws = commandLine.GetOption("--draws", commandLine.Size(50000, 2000));
+	const uint32_t maxThreads = commandLine.GetOption("--threads", max(thread::hardware_concurrency(), 4u));
+	const uint32_t numRuns = commandLine.Size(20, 1);
+
+	// Many small contexts make the pool's lock the bottleneck, and a few large ones make recording it
+	const uint32_t contextCounts[]{ 16, numDraws / 8 };
+
+	printf("Context pool benchmark, %u draws per frame, %u hardware threads, fastest of %u runs\n", numDraws,
+		thread::hardware_concurrency(), numRuns);
+
+	for (uint32_t numContexts : contextCounts)
+	{
+		printf("\n%u contexts of %u draws\n", numContexts, numDraws / numContexts);
+		printf("%-8s %14s %14s %12s %10s %10s\n", "Threads", "Shared list", "Worker lists", "MDraws/s", "Scaling", "Contexts");
+
+		double singleThreadMs{ 0.0 };
+		for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+		{
+			const Result result = Measure(numThreads, numDraws, numContexts, numRuns);
+			if (numThreads == 1)
+			{
+				singleThreadMs = result.cachedMs;
+			}
+
+			printf("%-8u %11.3f ms %11.3f ms %12.2f %9.2fx %10zu\n", numThreads, result.sharedMs, result.cachedMs,
+				numDraws / (result.cachedMs * 1.0e3), singleThreadMs / result.cachedMs, result.numCachedContexts);
+		}
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/ContextPool.h"
+
+#include "Benchmark.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Stands in for CommandContext, counting what the pool does to it.  inUse catches a context handed to two
+// owners at once.
+struct FakeContext
+{
+	static inline atomic<int32_t> s_numLive{ 0 };
+
+	const CommandListType type;
+	uint32_t numInitializes{ 0 };
+	uint32_t numResets{ 0 };
+	atomic<bool> inUse{ false };
+
+	explicit FakeContext(CommandListType type) : type{ type } { s_numLive.fetch_add(1); }
+	~FakeContext() { s_numLive.fetch_sub(1); }
+
+	CommandListType GetType() const noexcept { return type; }
+	void Initialize() { ++numInitializes; }
+	void Reset() { ++numResets; }
+};
+
+
+using FakeContextPool = ContextPool<FakeContext>;
+
+FakeContextPool::CreateFunction s_createFunction = [](CommandListType type) { return new FakeContext(type); };
+
+
+// Allocates a context and marks it in use, returning false if it already was
+bool Acquire(FakeContextPool& pool, CommandListType type, FakeContext*& outContext)
+{
+	outContext = pool.Allocate(type);
+	return outContext->GetType() == type && !outContext->inUse.exchange(true);
+}
+
+
+void Release(FakeContextPool& pool, FakeContext* context)
+{
+	context->inUse = false;
+	pool.Free(context);
+}
+
+
+void TestAllocateAndReuse()
+{
+	FakeContextPool pool{ s_createFunction };
+	Check(pool.GetNumContexts() == 0, "a new pool has no contexts");
+
+	FakeContext* first = pool.Allocate(CommandListType::Graphics);
+	Check(first->GetType() == CommandListType::Graphics && first->numInitializes == 1 && first->numResets == 0,
+		"a new context is initialized, not reset");
+	Check(pool.GetNumContexts() == 1, "allocating from an empty pool creates a context");
+
+	pool.Free(first);
+	FakeContext* reused = pool.Allocate(CommandListType::Graphics);
+	Check(reused == first && reused->numInitializes == 1 && reused->numResets == 1, "a freed context is reset and reused");
+	Check(pool.GetNumContexts() == 1, "reusing a context doesn't create one");
+
+	FakeContext* second = pool.Allocate(CommandListType::Graphics);
+	Check(second != first && pool.GetNumContexts() == 2, "a context in use isn't handed out again");
+
+	pool.Free(first);
+	FakeContext* compute = pool.Allocate(CommandListType::Compute);
+	Check(compute != first && compute->GetType() == CommandListType::Compute && pool.GetNumContexts() == 3,
+		"each command list type has its own free list");
+
+	pool.Free(second);
+	Check(pool.Allocate(CommandListType::Graphics) == second, "the most recently freed context comes back first");
+	Check(pool.Allocate(CommandListType::Graphics) == first, "then the one before it");
+
+	FakeContext* copy = pool.Allocate(CommandListType::Copy);
+	pool.Free(copy);
+	pool.Free(compute);
+	Check(pool.Allocate(CommandListType::Copy) == copy && pool.Allocate(CommandListType::Compute) == compute,
+		"freeing another type doesn't disturb a free list");
+}
+
+
+// The pool owns its contexts, including any still allocated when it goes away
+void TestDestruction()
+{
+	{
+		FakeContextPool pool{ s_createFunction };
+		pool.Free(pool.Allocate(CommandListType::Graphics));
+		pool.Allocate(CommandListType::Compute);
+		pool.Allocate(CommandListType::Copy);
+		Check(FakeContext::s_numLive == 3, "the pool created three contexts");
+	}
+	Check(FakeContext::s_numLive == 0, "destroying the pool destroys every context, free or not");
+}
+
+
+// A context freed on a worker goes to that worker's own list, where no other thread can reach it
+void TestWorkerCache()
+{
+	JobSystem jobSystem{ 2 };
+	FakeContextPool pool{ s_createFunction };
+
+	// Spun on rather than waited for, so the calling thread doesn't run the job itself
+	FakeContext* workerContext{ nullptr };
+	uint32_t workerIndex{ 0 };
+	bool reusedOnWorker{ false };
+	atomic<bool> done{ false };
+	jobSystem.Schedule([&] {
+			workerIndex = jobSystem.GetWorkerIndex();
+			workerContext = pool.Allocate(CommandListType::Graphics);
+			pool.Free(workerContext);
+			FakeContext* again = pool.Allocate(CommandListType::Graphics);
+			reusedOnWorker = again == workerContext && again->numResets == 1;
+			pool.Free(again);
+			done = true;
+		});
+	while (!done) { this_thread::yield(); }
+
+	Check(workerIndex < jobSystem.GetNumWorkers(), "the job ran on a worker");
+	Check(reusedOnWorker, "a worker gets back the context it freed");
+
+	FakeContext* mainContext = pool.Allocate(CommandListType::Graphics);
+	Check(mainContext != workerContext && pool.GetNumContexts() == 2,
+		"another thread doesn't see a context cached by a worker, so it creates its own");
+
+	pool.Free(mainContext);
+	FakeContext* otherContext{ nullptr };
+	thread([&pool, &otherContext] { otherContext = pool.Allocate(CommandListType::Graphics); }).join();
+	Check(otherContext == mainContext, "threads that aren't workers share the locked free list");
+}
+
+
+// A pool created without a job system has no worker lists, so workers share the locked list too
+void TestPoolCreatedBeforeJobSystem()
+{
+	FakeContextPool pool{ s_createFunction };
+	JobSystem jobSystem{ 2 };
+
+	FakeContext* workerContext{ nullptr };
+	atomic<bool> done{ false };
+	jobSystem.Schedule([&] {
+			workerContext = pool.Allocate(CommandListType::Graphics);
+			pool.Free(workerContext);
+			done = true;
+		});
+	while (!done) { this_thread::yield(); }
+
+	Check(pool.Allocate(CommandListType::Graphics) == workerContext && pool.GetNumContexts() == 1,
+		"a context freed on a worker is reused by another thread");
+}
+
+
+// Workers and other threads allocating and freeing at once.  No context is ever handed to two owners.  A thread
+// holds at most one of each type at a time, so the pool never needs more than one of each type per thread.
+void TestConcurrent(uint32_t numIterations)
+{
+	JobSystem jobSystem{ 3 };
+	FakeContextPool pool{ s_createFunction };
+
+	atomic<bool> everyContextOwnedOnce{ true };
+	auto work = [&pool, &everyContextOwnedOnce](uint32_t index)
+		{
+			const auto firstType = (CommandListType)(index % 3);
+			const auto secondType = (CommandListType)((index + 1) % 3);
+
+			FakeContext* first{ nullptr };
+			FakeContext* second{ nullptr };
+			const bool ownedOnce = Acquire(pool, firstType, first) && Acquire(pool, secondType, second);
+			Release(pool, second);
+			Release(pool, first);
+
+			if (!ownedOnce)
+			{
+				everyContextOwnedOnce = false;
+			}
+		};
+
+	vector<thread> threads;
+	for (uint32_t t = 0; t < 2; ++t)
+	{
+		threads.emplace_back([&work, numIterations] {
+				for (uint32_t i = 0; i < numIterations; ++i)
+				{
+					work(i);
+				}
+			});
+	}
+	jobSystem.ParallelFor(numIterations, 16, work);
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	const uint32_t numThreads = jobSystem.GetNumWorkers() + 1 + 2;
+	Check(everyContextOwnedOnce, "no context was handed to two owners at once");
+	Check(pool.GetNumContexts() <= (size_t)CommandListType::Count * numThreads, "contexts are reused rather than created for every allocation");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	TestAllocateAndReuse();
+	TestDestruction();
+	TestWorkerCache();
+	TestPoolCreatedBeforeJobSystem();
+	TestConcurrent(20000);
+
+	Check(FakeContext::s_numLive == 0, "every context was destroyed");
+
+	return FailureCount() == 0 ? 0 : 1;
+}
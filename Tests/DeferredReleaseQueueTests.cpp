@@ -0,0 +1,388 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Graphics/DeferredReleaseQueue.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Stands in for a GPU object.  The test holds the first reference, so the object is only destroyed once the test
+// drops it as well as the queue.
+class FakeObject : public IUnknown
+{
+public:
+	unsigned long AddRef() override { return ++m_refCount; }
+
+	unsigned long Release() override
+	{
+		assert(m_refCount > 0);
+
+		const unsigned long refCount = --m_refCount;
+		if (refCount == 0 && m_onDestroy)
+		{
+			m_onDestroy();
+		}
+		return refCount;
+	}
+
+	unsigned long GetRefCount() const { return m_refCount; }
+	bool IsHeldByQueue() const { return m_refCount > 1; }
+
+	void SetOnDestroy(function<void()> onDestroy) { m_onDestroy = move(onDestroy); }
+
+private:
+	atomic<unsigned long> m_refCount{ 1 };
+	function<void()> m_onDestroy;
+};
+
+
+// A GPU queue's fence, advanced by hand.  Signal() hands out the value the next submission will reach, and
+// Complete() plays the GPU catching up.
+struct FakeFence
+{
+	uint64_t nextValue{ 1 };
+	uint64_t completedValue{ 0 };
+
+	uint64_t Signal() { return nextValue++; }
+	void Complete(uint64_t value) { completedValue = max(completedValue, value); }
+};
+
+
+void TestFences()
+{
+	DeferredReleaseQueue queue{ 1 };
+	FakeFence fence;
+
+	FakeObject a, b, c;
+
+	queue.Release(0, fence.Signal(), nullptr);
+	Check(queue.IsEmpty(), "null objects are ignored");
+
+	const uint64_t first = fence.Signal();
+	queue.Release(0, first, &a);
+	queue.Release(0, first, &b);
+	const uint64_t second = fence.Signal();
+	queue.Release(0, second, &c);
+
+	Check(a.IsHeldByQueue() && b.IsHeldByQueue() && c.IsHeldByQueue(), "released objects are held");
+	Check(queue.GetStats().numPendingBuckets == 2, "one bucket per fence value");
+
+	Check(queue.Retire(0, fence.completedValue) == 0, "nothing is retired before its fence");
+	Check(a.IsHeldByQueue(), "objects are held while their fence is in flight");
+
+	fence.Complete(first);
+	Check(queue.Retire(0, fence.completedValue) == 2, "objects are retired once their fence completes");
+	Check(!a.IsHeldByQueue() && !b.IsHeldByQueue(), "retired objects are released");
+	Check(c.IsHeldByQueue(), "objects on a later fence are still held");
+
+	fence.Complete(second);
+	Check(queue.Retire(0, fence.completedValue) == 1, "the later fence retires the rest");
+	Check(queue.Retire(0, fence.completedValue) == 0, "objects are retired once");
+	Check(a.GetRefCount() == 1 && b.GetRefCount() == 1 && c.GetRefCount() == 1, "the queue drops exactly the references it took");
+
+	const DeferredReleaseStats stats = queue.GetStats();
+	Check(queue.IsEmpty() && stats.numPendingObjects == 0 && stats.numPendingBuckets == 0, "the queue is empty");
+	Check(stats.numReleasedObjects == 3 && stats.maxPendingObjects == 3, "stats count released and peak pending objects");
+}
+
+
+void TestOlderFence()
+{
+	DeferredReleaseQueue queue{ 1 };
+
+	FakeObject a, b;
+
+	// An object released against an older fence joins the newest bucket, and is held a little longer
+	queue.Release(0, 10, &a);
+	queue.Release(0, 5, &b);
+	Check(queue.GetStats().numPendingBuckets == 1, "an older fence joins the newest bucket");
+
+	queue.Retire(0, 5);
+	Check(b.IsHeldByQueue(), "an object on an older fence waits for the newest bucket");
+
+	queue.Retire(0, 10);
+	Check(!a.IsHeldByQueue() && !b.IsHeldByQueue(), "the newest bucket releases both");
+}
+
+
+void TestQueues()
+{
+	DeferredReleaseQueue queue{ 3 };
+	FakeFence fences[3];
+
+	FakeObject objects[3];
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		queue.Release(i, fences[i].Signal(), &objects[i]);
+	}
+
+	// Each queue has its own fence, so completing one leaves the others alone
+	fences[1].Complete(1);
+	Check(queue.Retire(1, fences[1].completedValue) == 1, "a queue retires against its own fence");
+	Check(queue.Retire(0, fences[0].completedValue) == 0 && queue.Retire(2, fences[2].completedValue) == 0,
+		"other queues are unaffected");
+	Check(objects[0].IsHeldByQueue() && !objects[1].IsHeldByQueue() && objects[2].IsHeldByQueue(), "only that queue's objects are released");
+
+	Check(queue.RetireAll() == 2 && queue.IsEmpty(), "RetireAll ignores the fences");
+}
+
+
+// More fences in flight than the initial ring holds, with the head part way round the ring when it grows
+void TestRingGrowth()
+{
+	DeferredReleaseQueue queue{ 1 };
+	FakeFence fence;
+
+	deque<FakeObject> objects;
+	deque<uint64_t> fenceValues;
+	uint32_t maxPendingBuckets{ 0 };
+
+	for (uint32_t frame = 0; frame < 200; ++frame)
+	{
+		const uint64_t fenceValue = fence.Signal();
+		for (uint32_t i = 0; i < frame % 4; ++i)
+		{
+			objects.emplace_back();
+			fenceValues.push_back(fenceValue);
+			queue.Release(0, fenceValue, &objects.back());
+		}
+
+		maxPendingBuckets = max(maxPendingBuckets, queue.GetStats().numPendingBuckets);
+
+		// The GPU falls further behind, then catches up
+		if (frame % 50 < 40 && frame % 3 == 0)
+		{
+			fence.Complete(min(fence.completedValue + 2, fenceValue));
+		}
+		else if (frame % 50 == 49)
+		{
+			fence.Complete(fenceValue - 5);
+		}
+		queue.Retire(0, fence.completedValue);
+
+		bool isCorrect = true;
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			isCorrect = isCorrect && objects[i].IsHeldByQueue() == (fenceValues[i] > fence.completedValue);
+		}
+		if (!isCorrect)
+		{
+			Check(false, "exactly the objects on completed fences are released as the ring grows and wraps");
+			break;
+		}
+	}
+
+	Check(maxPendingBuckets > 8, "the ring grew past its initial size");
+	queue.RetireAll();
+	Check(queue.IsEmpty(), "the grown ring empties");
+}
+
+
+// Objects that release others from their destructors, as a heap releasing its allocations does
+void TestReentrantRelease()
+{
+	DeferredReleaseQueue queue{ 2 };
+
+	FakeObject outer, inner;
+	outer.SetOnDestroy([&] { queue.Release(0, 2, &inner); queue.Release(1, 1, &inner); });
+
+	queue.Release(0, 1, &outer);
+	outer.Release();
+
+	Check(queue.Retire(0, 1) == 1, "the outer object is retired");
+	Check(inner.GetRefCount() == 3, "its destructor released into the queue without deadlocking");
+
+	Check(queue.Retire(0, 2) == 1 && queue.Retire(1, 1) == 1, "the inner object is retired in turn");
+	Check(inner.GetRefCount() == 1, "the inner object is released");
+}
+
+
+void TestDestructor()
+{
+	FakeObject object;
+	{
+		DeferredReleaseQueue queue{ 1 };
+		queue.Release(0, 100, &object);
+	}
+	Check(object.GetRefCount() == 1, "destroying the queue releases what it holds");
+}
+
+
+// Every thread releases against a fence it shares with the others, as recording threads do, while the calling
+// thread retires
+void TestThreads()
+{
+	const uint32_t numThreads = 4;
+	const uint32_t numPerThread = 5000;
+
+	DeferredReleaseQueue queue{ 1 };
+	deque<FakeObject> objects(numThreads * numPerThread);
+	atomic<uint64_t> fenceValue{ 1 };
+	atomic<uint32_t> numDone{ 0 };
+
+	vector<thread> threads;
+	for (uint32_t t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&, t]
+			{
+				for (uint32_t i = 0; i < numPerThread; ++i)
+				{
+					queue.Release(0, fenceValue.load(), &objects[t * numPerThread + i]);
+					if (i % 64 == 0)
+					{
+						fenceValue.fetch_add(1);
+					}
+				}
+				numDone.fetch_add(1);
+			});
+	}
+
+	size_t numRetired{ 0 };
+	while (numDone.load() < numThreads)
+	{
+		numRetired += queue.Retire(0, fenceValue.load() - 1);
+		this_thread::yield();
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	numRetired += queue.RetireAll();
+
+	Check(numRetired == numThreads * numPerThread, "every object released from many threads is retired once");
+	Check(all_of(objects.begin(), objects.end(), [](const FakeObject& object) { return object.GetRefCount() == 1; }),
+		"every reference taken from many threads is dropped");
+	Check(queue.GetStats().numReleasedObjects == numThreads * numPerThread, "released objects are counted across threads");
+}
+
+
+// Random releases and retires over several queues, checked object by object against the fences
+void TestRandomSequences(mt19937& rng)
+{
+	struct Expected
+	{
+		uint32_t queueIndex{ 0 };
+		uint64_t fenceValue{ 0 };	// That the object is held to
+		bool isHeld{ true };
+	};
+
+	for (uint32_t iteration = 0; iteration < 50; ++iteration)
+	{
+		const uint32_t numQueues = 1 + rng() % 3;
+
+		DeferredReleaseQueue queue{ numQueues };
+		vector<FakeFence> fences(numQueues);
+
+		deque<FakeObject> objects;
+		vector<Expected> expected;
+
+		const int numFailures = FailureCount();
+
+		for (uint32_t step = 0; step < 2000; ++step)
+		{
+			const uint32_t queueIndex = rng() % numQueues;
+			FakeFence& fence = fences[queueIndex];
+
+			const uint32_t choice = rng() % 10;
+			if (choice < 6)
+			{
+				// Sometimes a new fence value, sometimes the current one, and sometimes one that already completed
+				uint64_t fenceValue = (rng() % 4 == 0) ? fence.Signal() : fence.nextValue - 1;
+				if (rng() % 8 == 0)
+				{
+					fenceValue = fence.completedValue;
+				}
+
+				// An older value joins the newest bucket still pending, so it is held as long as that bucket
+				uint64_t heldTo = fenceValue;
+				for (const auto& other : expected)
+				{
+					if (other.queueIndex == queueIndex && other.isHeld)
+					{
+						heldTo = max(heldTo, other.fenceValue);
+					}
+				}
+
+				objects.emplace_back();
+				expected.push_back({ queueIndex, heldTo, true });
+				queue.Release(queueIndex, fenceValue, &objects.back());
+			}
+			else
+			{
+				fence.Complete(fence.completedValue + rng() % (fence.nextValue - fence.completedValue));
+
+				size_t numExpected{ 0 };
+				for (auto& object : expected)
+				{
+					if (object.queueIndex == queueIndex && object.isHeld && object.fenceValue <= fence.completedValue)
+					{
+						object.isHeld = false;
+						++numExpected;
+					}
+				}
+
+				Check(queue.Retire(queueIndex, fence.completedValue) == numExpected, "Retire releases exactly the objects on completed fences");
+			}
+
+			if (step % 100 == 0)
+			{
+				uint64_t numHeld{ 0 };
+				for (size_t i = 0; i < objects.size(); ++i)
+				{
+					Check(objects[i].IsHeldByQueue() == expected[i].isHeld, "objects are held until their fence completes");
+					numHeld += expected[i].isHeld ? 1 : 0;
+				}
+				Check(queue.GetStats().numPendingObjects == numHeld, "pending objects are counted");
+			}
+		}
+
+		queue.RetireAll();
+		Check(queue.IsEmpty() && queue.GetStats().numReleasedObjects == objects.size(), "every object is released in the end");
+
+		if (FailureCount() > numFailures)
+		{
+			fprintf(stderr, "random sequence %u failed\n", iteration);
+			return;
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestFences();
+	TestOlderFence();
+	TestQueues();
+	TestRingGrowth();
+	TestReentrantRelease();
+	TestDestructor();
+	TestThreads();
+	TestRandomSequences(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,363 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Graphics/DescriptorSlotAllocator.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+enum class SlotState : uint8_t
+{
+	Unused,
+	Allocated,
+	Pending
+};
+
+
+// Mirrors every call into the allocator with a plain per-slot state map, so the checks below can verify its
+// results independently
+struct TestAllocator
+{
+	uint32_t slotsPerPage{ 0 };
+	vector<uint32_t> createdPages;
+	DescriptorSlotAllocator allocator;
+
+	vector<SlotState> slots;
+	vector<DescriptorSlotRange> liveRanges;
+	deque<pair<uint64_t, DescriptorSlotRange>> pendingRanges;
+
+	explicit TestAllocator(uint32_t slotsPerPage)
+		: slotsPerPage{ slotsPerPage }
+		, allocator{ slotsPerPage, [this](uint32_t pageIndex) { createdPages.push_back(pageIndex); } }
+	{}
+
+	static uint32_t ClassSize(uint32_t count) { return bit_ceil(count); }
+
+	uint32_t FirstSlot(const DescriptorSlotRange& range) const { return range.pageIndex * slotsPerPage + range.offset; }
+
+	DescriptorSlotRange Allocate(uint32_t count)
+	{
+		const DescriptorSlotRange range = allocator.Allocate(count);
+
+		Check(range.count == count, "an allocation has the requested count");
+		Check((range.generation & 1) == 1, "an allocated range has an odd generation");
+		Check(range.offset + ClassSize(count) <= slotsPerPage, "an allocation stays inside its page");
+		Check(range.pageIndex < createdPages.size(), "an allocation is in a page that was created");
+		Check(allocator.IsAllocated(range), "a new range is allocated");
+
+		slots.resize(createdPages.size() * slotsPerPage, SlotState::Unused);
+
+		bool isUnused = true;
+		for (uint32_t i = 0; i < ClassSize(count); ++i)
+		{
+			isUnused = isUnused && slots[FirstSlot(range) + i] == SlotState::Unused;
+			slots[FirstSlot(range) + i] = SlotState::Allocated;
+		}
+		Check(isUnused, "an allocation overlaps no allocated or pending slot");
+
+		liveRanges.push_back(range);
+		return range;
+	}
+
+	void Free(size_t liveIndex, uint64_t fenceValue)
+	{
+		const DescriptorSlotRange range = liveRanges[liveIndex];
+		liveRanges[liveIndex] = liveRanges.back();
+		liveRanges.pop_back();
+
+		allocator.Free(range, fenceValue);
+		Check(!allocator.IsAllocated(range), "a freed range is no longer allocated");
+
+		for (uint32_t i = 0; i < ClassSize(range.count); ++i)
+		{
+			slots[FirstSlot(range) + i] = SlotState::Pending;
+		}
+		pendingRanges.emplace_back(fenceValue, range);
+	}
+
+	void Reclaim(uint64_t completedFenceValue)
+	{
+		allocator.Reclaim(completedFenceValue);
+
+		while (!pendingRanges.empty() && pendingRanges.front().first <= completedFenceValue)
+		{
+			const DescriptorSlotRange& range = pendingRanges.front().second;
+			for (uint32_t i = 0; i < ClassSize(range.count); ++i)
+			{
+				slots[FirstSlot(range) + i] = SlotState::Unused;
+			}
+			pendingRanges.pop_front();
+		}
+	}
+
+	void CheckStats() const
+	{
+		uint32_t numAllocatedSlots = 0;
+		uint32_t numRequestedSlots = 0;
+		for (const auto& range : liveRanges)
+		{
+			numAllocatedSlots += ClassSize(range.count);
+			numRequestedSlots += range.count;
+		}
+
+		uint32_t numPendingSlots = 0;
+		for (const auto& [fenceValue, range] : pendingRanges)
+		{
+			numPendingSlots += ClassSize(range.count);
+		}
+
+		const DescriptorSlotStats stats = allocator.GetStats();
+		Check(stats.numPages == createdPages.size(), "stats count every created page");
+		Check(stats.slotsPerPage == slotsPerPage, "stats report the page size");
+		Check(stats.numAllocatedSlots == numAllocatedSlots, "stats count the allocated slots by size class");
+		Check(stats.numRequestedSlots == numRequestedSlots, "stats count the requested slots");
+		Check(stats.numPendingSlots == numPendingSlots, "stats count the pending slots");
+
+		// Whatever is neither allocated, pending nor on a free list is the untouched end of the last page
+		const uint32_t numTotalSlots = stats.numPages * slotsPerPage;
+		const uint32_t numAccountedSlots = stats.numAllocatedSlots + stats.numPendingSlots + stats.numFreeSlots;
+		Check(numAccountedSlots <= numTotalSlots && (stats.numPages == 0 || numTotalSlots - numAccountedSlots < slotsPerPage),
+			"only the end of the last page is untouched");
+
+		for (const auto& range : liveRanges)
+		{
+			if (!allocator.IsAllocated(range))
+			{
+				Check(false, "every live range is still allocated");
+				break;
+			}
+		}
+
+		for (uint32_t i = 1; i < createdPages.size(); ++i)
+		{
+			if (createdPages[i] != createdPages[i - 1] + 1)
+			{
+				Check(false, "pages are created in order");
+				break;
+			}
+		}
+	}
+};
+
+
+void TestSizeClasses()
+{
+	TestAllocator test{ 64 };
+
+	const uint32_t counts[] = { 1, 2, 3, 4, 5, 7, 8, 9, 16, 17, 31, 32, 33, 63, 64 };
+	for (uint32_t count : counts)
+	{
+		test.Allocate(count);
+	}
+	test.CheckStats();
+
+	const DescriptorSlotStats stats = test.allocator.GetStats();
+	Check(stats.numRequestedSlots == 295, "requested slots add up");
+	Check(stats.numAllocatedSlots == 1 + 2 + 4 + 4 + 8 + 8 + 8 + 16 + 16 + 32 + 32 + 32 + 64 + 64 + 64, "allocated slots round up to powers of two");
+}
+
+
+void TestFenceReclaim()
+{
+	TestAllocator test{ 16 };
+
+	vector<DescriptorSlotRange> ranges;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		ranges.push_back(test.Allocate(1));
+	}
+	Check(test.createdPages.size() == 1, "one page holds 16 single slots");
+
+	// Free half against fence 1 and half against fence 2, then refill.  Nothing comes back before its fence.
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		test.Free(test.liveRanges.size() - 1, i < 8 ? 1 : 2);
+	}
+
+	test.Reclaim(0);
+	test.Allocate(1);
+	Check(test.createdPages.size() == 2, "pending slots are not reused before their fence completes");
+
+	test.Reclaim(1);
+	const DescriptorSlotStats afterFirstFence = test.allocator.GetStats();
+	Check(afterFirstFence.numPendingSlots == 8, "reclaiming fence 1 leaves the fence 2 frees pending");
+	test.CheckStats();
+
+	test.Reclaim(2);
+	const uint64_t numReusedBefore = test.allocator.GetStats().numReusedAllocations;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const DescriptorSlotRange range = test.Allocate(1);
+		Check(range.pageIndex == 0 || range.pageIndex == 1, "reclaimed slots are reused before a new page is created");
+	}
+	Check(test.createdPages.size() == 2, "no page is created while reclaimed slots fit");
+	Check(test.allocator.GetStats().numReusedAllocations > numReusedBefore, "reused allocations are counted");
+	test.CheckStats();
+}
+
+
+void TestStaleRanges()
+{
+	TestAllocator test{ 8 };
+
+	const DescriptorSlotRange first = test.Allocate(4);
+	test.Free(0, 1);
+	test.Reclaim(1);
+
+	const DescriptorSlotRange second = test.Allocate(4);
+	Check(second.pageIndex == first.pageIndex && second.offset == first.offset, "a freed range is reused");
+	Check(second.generation != first.generation, "a reused range has a new generation");
+	Check(!test.allocator.IsAllocated(first), "a stale copy of a reused range is not allocated");
+	Check(test.allocator.IsAllocated(second), "the reused range is allocated");
+
+	Check(!test.allocator.IsAllocated(DescriptorSlotRange{}), "the null range is not allocated");
+	Check(!test.allocator.IsAllocated({ .pageIndex = 5, .offset = 0, .count = 1, .generation = 1 }), "a range past the last page is not allocated");
+	Check(!test.allocator.IsAllocated({ .pageIndex = 0, .offset = 6, .count = 4, .generation = 1 }), "a range past the end of its page is not allocated");
+
+#ifdef NDEBUG
+	// Double frees assert in debug builds, and are ignored otherwise
+	const DescriptorSlotStats before = test.allocator.GetStats();
+	test.allocator.Free(first, 2);
+	const DescriptorSlotStats after = test.allocator.GetStats();
+	Check(after.numPendingSlots == before.numPendingSlots && after.numAllocatedSlots == before.numAllocatedSlots, "a stale free is ignored");
+	Check(test.allocator.IsAllocated(second), "a stale free leaves the reused range allocated");
+#endif // NDEBUG
+}
+
+
+void TestSplitting()
+{
+	TestAllocator test{ 32 };
+
+	// A 32 slot range, freed and reclaimed, then split into smaller classes
+	test.Allocate(32);
+	test.Free(0, 1);
+	test.Reclaim(1);
+
+	for (uint32_t count : { 1u, 2u, 4u, 8u, 16u, 1u })
+	{
+		const DescriptorSlotRange range = test.Allocate(count);
+		Check(range.pageIndex == 0, "smaller ranges are split out of a larger free range");
+	}
+	Check(test.createdPages.size() == 1, "splitting needs no new page");
+
+	// The end of a page that is too short for the next allocation goes to the free lists
+	TestAllocator tail{ 16 };
+	tail.Allocate(4);
+	tail.Allocate(8);
+	tail.Allocate(16);
+	Check(tail.createdPages.size() == 2, "a range that does not fit starts a new page");
+	Check(tail.allocator.GetStats().numFreeSlots == 4, "the rest of the old page is free");
+
+	const DescriptorSlotRange reused = tail.Allocate(2);
+	Check(reused.pageIndex == 0 && reused.offset == 12, "the rest of the old page is reused");
+	tail.CheckStats();
+}
+
+
+void TestStatsHelpers()
+{
+	DescriptorSlotStats stats{};
+	Check(stats.GetFragmentation() == 0.0f && stats.GetReuseRate() == 0.0f, "empty stats report zero");
+
+	stats = { .numPages = 1, .slotsPerPage = 16, .numAllocatedSlots = 8, .numFreeSlots = 4, .numAllocations = 4, .numReusedAllocations = 1 };
+	Check(stats.GetFragmentation() == 0.5f, "fragmentation is the free share of the unallocated slots");
+	Check(stats.GetReuseRate() == 0.25f, "reuse rate is the share of reused allocations");
+}
+
+
+// Random allocations, frees and reclaims, with a fence that advances like a frame loop
+void TestRandomSequences(mt19937& rng)
+{
+	const uint32_t pageSizes[] = { 1, 2, 16, 64, 256 };
+
+	for (uint32_t iteration = 0; iteration < 200; ++iteration)
+	{
+		const uint32_t slotsPerPage = pageSizes[iteration % size(pageSizes)];
+		TestAllocator test{ slotsPerPage };
+
+		uint64_t fenceValue = 1;
+		uint64_t completedFenceValue = 0;
+
+		const int numFailures = FailureCount();
+
+		for (uint32_t step = 0; step < 2000; ++step)
+		{
+			const uint32_t choice = rng() % 10;
+			if (choice < 5 || test.liveRanges.empty())
+			{
+				// Mostly small ranges, as for CPU descriptors, with the occasional big one
+				const uint32_t maxCount = (rng() % 8 == 0) ? slotsPerPage : min(slotsPerPage, 4u);
+				test.Allocate(1 + rng() % maxCount);
+			}
+			else if (choice < 9)
+			{
+				test.Free(rng() % test.liveRanges.size(), fenceValue);
+			}
+			else
+			{
+				++fenceValue;
+				completedFenceValue += rng() % (fenceValue - completedFenceValue);
+				test.Reclaim(completedFenceValue);
+			}
+
+			if (step % 64 == 0)
+			{
+				test.CheckStats();
+			}
+		}
+
+		// Freeing and reclaiming everything leaves every slot on the free lists
+		while (!test.liveRanges.empty())
+		{
+			test.Free(test.liveRanges.size() - 1, fenceValue);
+		}
+		test.Reclaim(fenceValue);
+		test.CheckStats();
+
+		const DescriptorSlotStats stats = test.allocator.GetStats();
+		Check(stats.numAllocatedSlots == 0 && stats.numPendingSlots == 0, "nothing is left allocated or pending");
+
+		if (FailureCount() > numFailures)
+		{
+			fprintf(stderr, "random sequence %u failed\n", iteration);
+			return;
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestSizeClasses();
+	TestFenceReclaim();
+	TestStaleRanges();
+	TestSplitting();
+	TestStatsHelpers();
+	TestRandomSequences(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
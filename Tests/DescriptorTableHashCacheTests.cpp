@@ -0,0 +1,336 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Graphics/DescriptorTableHashCache.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+using Key = vector<uint32_t>;
+
+
+// Mirrors every call into the cache with a map from the full key contents, applying the same budget, so the checks
+// below can verify its results independently
+struct TestCache
+{
+	uint32_t maxEntries{ 0 };
+	uint32_t maxKeyWords{ 0 };
+	DescriptorTableHashCache cache;
+
+	map<Key, uint64_t> entries;
+	uint32_t numKeyWords{ 0 };
+	DescriptorTableCacheStats expectedStats;
+
+	TestCache(uint32_t maxEntries, uint32_t maxKeyWords)
+		: maxEntries{ maxEntries }
+		, maxKeyWords{ maxKeyWords }
+		, cache{ maxEntries, maxKeyWords }
+	{}
+
+	void Find(size_t hash, const Key& key)
+	{
+		uint64_t location{ ~0ull };
+		const bool found = cache.Find(hash, key, location);
+
+		++expectedStats.numLookups;
+
+		auto it = entries.find(key);
+		if (it == entries.end())
+		{
+			Check(!found, "a key that was never inserted is not found");
+			return;
+		}
+
+		++expectedStats.numHits;
+		Check(found, "an inserted key is found");
+		Check(!found || location == it->second, "a found key has the location it was last inserted with");
+	}
+
+	void Insert(size_t hash, const Key& key, uint64_t location)
+	{
+		cache.Insert(hash, key, location);
+
+		// A full cache drops every insert, even one that would only update an existing entry
+		if (entries.size() == maxEntries || numKeyWords + key.size() > maxKeyWords)
+		{
+			++expectedStats.numDroppedInserts;
+			return;
+		}
+
+		auto [it, inserted] = entries.insert_or_assign(key, location);
+		if (inserted)
+		{
+			numKeyWords += (uint32_t)key.size();
+			++expectedStats.numInserts;
+		}
+	}
+
+	void Reset()
+	{
+		cache.Reset();
+
+		if (!entries.empty())
+		{
+			++expectedStats.numResets;
+		}
+		entries.clear();
+		numKeyWords = 0;
+	}
+
+	void CheckStats() const
+	{
+		const DescriptorTableCacheStats& stats = cache.GetStats();
+		Check(cache.GetNumEntries() == entries.size(), "the entry count matches");
+		Check(stats.numLookups == expectedStats.numLookups, "lookups are counted");
+		Check(stats.numHits == expectedStats.numHits, "hits are counted");
+		Check(stats.numInserts == expectedStats.numInserts, "inserts are counted");
+		Check(stats.numDroppedInserts == expectedStats.numDroppedInserts, "dropped inserts are counted");
+		Check(stats.numResets == expectedStats.numResets, "resets are counted");
+	}
+};
+
+
+void TestHashKey()
+{
+	const Key a{ 1, 2, 3, 4, 5 };
+	const Key b{ 1, 2, 3, 4, 6 };
+	const Key c{ 1, 2, 3, 4 };
+
+	Check(DescriptorTableHashCache::HashKey(a) == DescriptorTableHashCache::HashKey(Key{ a }), "equal keys hash the same");
+	Check(DescriptorTableHashCache::HashKey(a) != DescriptorTableHashCache::HashKey(b), "keys differing in the last word hash differently");
+	Check(DescriptorTableHashCache::HashKey(a) != DescriptorTableHashCache::HashKey(c), "a key and its prefix hash differently");
+
+	// The CRC path reads 64 bits at a time, so the result must not depend on where the key starts
+	const uint32_t words[] = { 0, 7, 11, 13, 17, 19, 23, 29, 31 };
+	const span<const uint32_t> aligned{ words + 1, 4 };
+	Key copy{ aligned.begin(), aligned.end() };
+	Check(DescriptorTableHashCache::HashKey(aligned) == DescriptorTableHashCache::HashKey(copy), "hashes do not depend on alignment");
+	Check(DescriptorTableHashCache::HashKey(span<const uint32_t>{ words, 5 }) != DescriptorTableHashCache::HashKey(span<const uint32_t>{ words + 1, 5 }),
+		"shifted keys hash differently");
+
+	// Handles, as the dynamic descriptor heaps hash them, are rarely all different in the low bits
+	mt19937 rng{ 5678 };
+	unordered_set<size_t> hashes;
+	const uint32_t numKeys = 10000;
+	for (uint32_t i = 0; i < numKeys; ++i)
+	{
+		Key key(1 + rng() % 8);
+		for (auto& word : key)
+		{
+			word = 0x1000u + 32u * (rng() % 4096);
+		}
+		key[0] = i;
+		hashes.insert(DescriptorTableHashCache::HashKey(key));
+	}
+	Check(hashes.size() > numKeys * 99 / 100, "distinct keys rarely share a hash");
+}
+
+
+void TestFindAndInsert()
+{
+	TestCache test{ 8, 64 };
+
+	const Key a{ 10, 20, 30 };
+	const Key b{ 10, 20 };
+
+	test.Find(DescriptorTableHashCache::HashKey(a), a);
+	test.Insert(DescriptorTableHashCache::HashKey(a), a, 100);
+	test.Find(DescriptorTableHashCache::HashKey(a), a);
+	test.Find(DescriptorTableHashCache::HashKey(b), b);
+
+	// Copying the same contents again points the entry at the newest copy, without another entry
+	test.Insert(DescriptorTableHashCache::HashKey(a), a, 200);
+	test.Find(DescriptorTableHashCache::HashKey(a), a);
+	Check(test.cache.GetNumEntries() == 1, "reinserting a key updates its entry");
+
+	test.CheckStats();
+	Check(test.cache.GetStats().GetHitRate() == 0.5f, "hit rate is hits over lookups");
+}
+
+
+// Keys are compared in full, so keys that share a hash never return each other's location
+void TestCollisions()
+{
+	TestCache test{ 16, 256 };
+
+	const size_t hash = 42;
+	const Key keys[] = { { 1 }, { 2 }, { 1, 2 }, { 2, 1 }, { 1, 2, 3 }, { 0 }, { 0, 0 } };
+
+	for (size_t i = 0; i < size(keys); ++i)
+	{
+		test.Insert(hash, keys[i], 1000 + i);
+	}
+	for (const Key& key : keys)
+	{
+		test.Find(hash, key);
+	}
+
+	// Neighbors of the shared slot probe past the colliding run
+	test.Insert(hash + 1, Key{ 9 }, 5000);
+	test.Find(hash + 1, Key{ 9 });
+
+	// Keys that were never inserted probe through the whole run, and still miss
+	test.Find(hash, Key{ 3 });
+	test.Find(hash + 1, Key{ 1, 2, 3, 4 });
+
+	// Runs that start near the end of the table wrap around to the start
+	test.Insert(~0ull, Key{ 7 }, 6000);
+	test.Insert(~0ull, Key{ 8 }, 7000);
+	test.Find(~0ull, Key{ 7 });
+	test.Find(~0ull, Key{ 8 });
+
+	test.CheckStats();
+}
+
+
+void TestBudgets()
+{
+	// The entry budget
+	TestCache entries{ 4, 1024 };
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		const Key key{ i };
+		entries.Insert(DescriptorTableHashCache::HashKey(key), key, i);
+	}
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		const Key key{ i };
+		entries.Find(DescriptorTableHashCache::HashKey(key), key);
+	}
+	entries.CheckStats();
+	Check(entries.cache.GetStats().numDroppedInserts == 2, "inserts past the entry budget are dropped");
+
+	// The key budget
+	TestCache words{ 64, 10 };
+	const Key big(8, 3);
+	const Key small(3, 4);
+	words.Insert(DescriptorTableHashCache::HashKey(big), big, 1);
+	words.Insert(DescriptorTableHashCache::HashKey(small), small, 2);
+	words.Find(DescriptorTableHashCache::HashKey(small), small);
+	words.CheckStats();
+	Check(words.cache.GetStats().numDroppedInserts == 1, "inserts past the key budget are dropped");
+
+	// A reset makes room again
+	words.Reset();
+	words.Insert(DescriptorTableHashCache::HashKey(small), small, 3);
+	words.Find(DescriptorTableHashCache::HashKey(small), small);
+	words.Find(DescriptorTableHashCache::HashKey(big), big);
+	words.CheckStats();
+}
+
+
+void TestResetAndStats()
+{
+	TestCache test{ 8, 64 };
+
+	test.Reset();
+	Check(test.cache.GetStats().numResets == 0, "resetting an empty cache is not counted");
+
+	const Key key{ 5, 6 };
+	test.Insert(DescriptorTableHashCache::HashKey(key), key, 1);
+	test.Reset();
+	test.Find(DescriptorTableHashCache::HashKey(key), key);
+	test.CheckStats();
+
+	const DescriptorTableCacheStats taken = test.cache.TakeStats();
+	Check(taken.numInserts == 1 && taken.numResets == 1 && taken.numLookups == 1 && taken.numHits == 0, "taken stats are the ones gathered");
+	Check(test.cache.GetStats().numLookups == 0 && test.cache.GetStats().numResets == 0, "taking the stats clears them");
+
+	DescriptorTableCacheStats total{ .numLookups = 4, .numHits = 1 };
+	total += DescriptorTableCacheStats{ .numLookups = 4, .numHits = 3, .numInserts = 2, .numDroppedInserts = 1, .numResets = 5 };
+	Check(total.numLookups == 8 && total.numHits == 4 && total.numInserts == 2 && total.numDroppedInserts == 1 && total.numResets == 5,
+		"stats add up");
+	Check(total.GetHitRate() == 0.5f, "merged hit rate is hits over lookups");
+	Check(DescriptorTableCacheStats{}.GetHitRate() == 0.0f, "no lookups is a zero hit rate");
+}
+
+
+// Random tables, as the dynamic descriptor heaps see them from frame to frame:  a working set of tables rebound
+// often, with a reset whenever the heap is retired.  Hashes are folded down to a few bits on some runs, so most
+// lookups go through colliding probe runs.
+void TestRandomSequences(mt19937& rng)
+{
+	for (uint32_t iteration = 0; iteration < 100; ++iteration)
+	{
+		const uint32_t maxEntries = 1 + rng() % 64;
+		const uint32_t maxKeyWords = 1 + rng() % 256;
+		const size_t hashMask = (iteration % 2 == 0) ? ~(size_t)0 : 3;
+
+		TestCache test{ maxEntries, maxKeyWords };
+
+		vector<Key> workingSet(1 + rng() % 100);
+		for (auto& key : workingSet)
+		{
+			key.resize(1 + rng() % 8);
+			for (auto& word : key)
+			{
+				word = rng() % 4;
+			}
+		}
+
+		const int numFailures = FailureCount();
+
+		for (uint32_t step = 0; step < 5000; ++step)
+		{
+			const Key& key = workingSet[rng() % workingSet.size()];
+			const size_t hash = DescriptorTableHashCache::HashKey(key) & hashMask;
+
+			const uint32_t choice = rng() % 100;
+			if (choice < 60)
+			{
+				test.Find(hash, key);
+			}
+			else if (choice < 98)
+			{
+				test.Insert(hash, key, step);
+			}
+			else
+			{
+				test.Reset();
+			}
+		}
+		test.CheckStats();
+
+		if (FailureCount() > numFailures)
+		{
+			fprintf(stderr, "random sequence %u failed\n", iteration);
+			return;
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestHashKey();
+	TestFindAndInsert();
+	TestCollisions();
+	TestBudgets();
+	TestResetAndStats();
+	TestRandomSequences(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
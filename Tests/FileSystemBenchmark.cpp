@@ -0,0 +1,215 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "AssetArchive.h"
+#include "FileSystem.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Small assets, partly compressible, spread over 50 directories like a content tree
+vector<string> WriteAssets(const filesystem::path& assetPath, uint32_t numFiles)
+{
+	mt19937 rng{ 1234 };
+
+	vector<string> names;
+	for (uint32_t i = 0; i < numFiles; ++i)
+	{
+		const string name = "Dir" + to_string(i % 50) + "/Asset" + to_string(i) + ".bin";
+
+		vector<char> data(1024 + rng() % (31 * 1024));
+		for (size_t j = 0; j < data.size(); ++j)
+		{
+			data[j] = ((j / 16 + i) % 3) != 0 ? (char)('a' + (j * 7 + i) % 11) : (char)rng();
+		}
+
+		const filesystem::path filePath = assetPath / name;
+		filesystem::create_directories(filePath.parent_path());
+		ofstream(filePath, ios::out | ios::binary).write(data.data(), (streamsize)data.size());
+
+		names.push_back(name);
+	}
+
+	shuffle(names.begin(), names.end(), rng);
+	return names;
+}
+
+
+uint64_t Checksum(span<const std::byte> data)
+{
+	uint64_t sum = data.size();
+	for (size_t i = 0; i < data.size(); i += 64)
+	{
+		sum += (uint8_t)data[i];
+	}
+	return sum;
+}
+
+
+// What the texture loader did before archives:  Exists() and then GetFullPath() each checked every search path, and
+// the file was read into memory
+double LookupAndReadByPath(const vector<filesystem::path>& searchPaths, const vector<string>& names, uint64_t& outChecksum)
+{
+	auto findFile = [&searchPaths](const string& name)
+		{
+			for (const auto& searchPath : searchPaths)
+			{
+				auto fullPath = searchPath / name;
+				if (filesystem::exists(fullPath))
+				{
+					return fullPath;
+				}
+			}
+			return filesystem::path{};
+		};
+
+	return MeasureMs(1, [&]
+		{
+			outChecksum = 0;
+			vector<std::byte> data;
+			for (const auto& name : names)
+			{
+				if (findFile(name).empty())
+				{
+					continue;
+				}
+
+				ifstream inFile(findFile(name), ios::in | ios::binary | ios::ate);
+				data.resize((size_t)inFile.tellg());
+				inFile.seekg(0);
+				inFile.read((char*)data.data(), (streamsize)data.size());
+				outChecksum += Checksum(data);
+			}
+		});
+}
+
+
+// What the texture loader does for a file it doesn't compress.  Nothing is remembered from the last run, so every
+// name is looked up afresh.
+double LookupAndRead(FileSystem& fileSystem, const vector<string>& names, uint64_t& outChecksum)
+{
+	return MeasureMs(1, [&]
+		{
+			fileSystem.ClearLookupCache();
+
+			outChecksum = 0;
+			for (const auto& name : names)
+			{
+				FileData fileData;
+				if (fileSystem.Exists(name) && fileSystem.ReadFile(name, fileData))
+				{
+					outChecksum += Checksum(fileData.GetSpan());
+				}
+			}
+		});
+}
+
+
+// Names that aren't anywhere, like the alternate extensions that loaders probe for
+double LookupMissing(const FileSystem& fileSystem, const vector<string>& names, uint32_t& outNumFound)
+{
+	return MeasureMs(1, [&]
+		{
+			for (const auto& name : names)
+			{
+				outNumFound += fileSystem.Exists(name + ".missing") ? 1 : 0;
+			}
+		});
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numFiles = commandLine.Size(10000, 200);
+	const uint32_t numRuns = commandLine.Size(5, 1);
+
+	const filesystem::path rootPath = filesystem::temp_directory_path() / "LunaFileSystemBenchmark";
+	filesystem::remove_all(rootPath);
+
+	// The assets are in the last of three search paths, as when an app's own paths come ahead of shared data
+	const vector<string> names = WriteAssets(rootPath / "Assets", numFiles);
+	filesystem::create_directories(rootPath / "Shaders");
+	filesystem::create_directories(rootPath / "Textures");
+
+	AssetArchiveBuildStats storedStats;
+	AssetArchiveBuildStats compressedStats;
+	Check(BuildAssetArchive({ .archiveFileName = (rootPath / "Stored.lpak").string(), .rootPath = rootPath / "Assets", .compress = false }, &storedStats),
+		"the stored archive builds");
+	Check(BuildAssetArchive({ .archiveFileName = (rootPath / "Compressed.lpak").string(), .rootPath = rootPath / "Assets" }, &compressedStats),
+		"the compressed archive builds");
+
+	FileSystem fileSystem{ "LunaFileSystemBenchmark" };
+	fileSystem.SetRootPath(rootPath);
+	fileSystem.AddSearchPath("Assets");
+	fileSystem.AddSearchPath("Textures");
+	fileSystem.AddSearchPath("Shaders");
+
+	// The modes take turns, so that each sees the same state of the machine, and the fastest turn of each is kept
+	uint64_t byPathChecksum{ 0 };
+	uint64_t looseChecksum{ 0 };
+	uint64_t storedChecksum{ 0 };
+	uint64_t compressedChecksum{ 0 };
+	double byPathMs = numeric_limits<double>::max();
+	double looseMs = numeric_limits<double>::max();
+	double storedMs = numeric_limits<double>::max();
+	double compressedMs = numeric_limits<double>::max();
+
+	for (uint32_t run = 0; run < numRuns; ++run)
+	{
+		byPathMs = min(byPathMs, LookupAndReadByPath(fileSystem.GetSearchPaths(), names, byPathChecksum));
+		looseMs = min(looseMs, LookupAndRead(fileSystem, names, looseChecksum));
+
+		Check(fileSystem.MountArchive("Stored.lpak"), "the stored archive mounts");
+		storedMs = min(storedMs, LookupAndRead(fileSystem, names, storedChecksum));
+		fileSystem.UnmountArchive("Stored.lpak");
+
+		Check(fileSystem.MountArchive("Compressed.lpak"), "the compressed archive mounts");
+		compressedMs = min(compressedMs, LookupAndRead(fileSystem, names, compressedChecksum));
+		fileSystem.UnmountArchive("Compressed.lpak");
+	}
+
+	uint32_t numMissingFound{ 0 };
+	const double firstMissingMs = LookupMissing(fileSystem, names, numMissingFound);
+	const double repeatedMissingMs = LookupMissing(fileSystem, names, numMissingFound);
+
+	Check(byPathChecksum != 0 && looseChecksum == byPathChecksum, "loose files read back the same");
+	Check(storedChecksum == byPathChecksum, "the stored archive reads back the same");
+	Check(compressedChecksum == byPathChecksum, "the compressed archive reads back the same");
+	Check(numMissingFound == 0, "missing files aren't found");
+
+	printf("File system benchmark, %u lookups and reads of 1-32KB files, fastest of %u runs\n\n", numFiles, numRuns);
+	printf("%-28s %12.2f us/file\n", "Search paths, by path", byPathMs * 1.0e3 / numFiles);
+	printf("%-28s %12.2f us/file\n", "Search paths", looseMs * 1.0e3 / numFiles);
+	printf("%-28s %12.2f us/file\n", "Archive, stored", storedMs * 1.0e3 / numFiles);
+	printf("%-28s %12.2f us/file   %u of %u entries compressed, %.1f to %.1f MB\n", "Archive, compressed", compressedMs * 1.0e3 / numFiles,
+		compressedStats.numCompressedEntries, compressedStats.numEntries, compressedStats.totalBytes / 1.0e6, compressedStats.storedBytes / 1.0e6);
+	printf("\n%u missing files:  %.2f us/file the first time, %.2f us/file once remembered\n", numFiles,
+		firstMissingMs * 1.0e3 / numFiles, repeatedMissingMs * 1.0e3 / numFiles);
+
+	filesystem::remove_all(rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "AssetArchive.h"
+#include "FileSystem.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+const filesystem::path s_rootPath = filesystem::temp_directory_path() / "LunaFileSystemTests";
+
+
+vector<std::byte> MakeData(size_t size, bool compressible, mt19937& rng)
+{
+	vector<std::byte> data(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		data[i] = compressible ? (std::byte)('a' + (i * i / 7) % 5) : (std::byte)rng();
+	}
+	return data;
+}
+
+
+void WriteFile(const filesystem::path& filePath, const vector<std::byte>& data)
+{
+	filesystem::create_directories(filePath.parent_path());
+	ofstream(filePath, ios::out | ios::binary).write((const char*)data.data(), (streamsize)data.size());
+}
+
+
+bool Matches(const FileData& fileData, const vector<std::byte>& data)
+{
+	return fileData.GetSize() == data.size() && equal(data.begin(), data.end(), fileData.GetData());
+}
+
+
+void TestStableHash()
+{
+	// Published FNV-1a values.  Anything on disk named or checked with this hash depends on them never changing.
+	Check(Utility::HashStable("", 0) == 0xcbf29ce484222325ull, "the stable hash of nothing is the FNV-1a basis");
+	Check(Utility::HashStable("a", 1) == 0xaf63dc4c8601ec8cull, "the stable hash of 'a' is FNV-1a");
+	Check(Utility::HashStable("foobar", 6) == 0x85944171f73967e8ull, "the stable hash of 'foobar' is FNV-1a");
+
+	const uint32_t value = 0x64636261;	// "abcd" on a little-endian CPU
+	Check(Utility::HashStableValue(value, Utility::g_stableHashStart) == Utility::HashStable(&value, sizeof(value)),
+		"hashing a value hashes its bytes");
+	Check(Utility::HashStable("bar", 3, Utility::HashStable("foo", 3)) == Utility::HashStable("foobar", 6),
+		"hashes chain through the seed");
+}
+
+
+void TestWriteFileAtomic()
+{
+	const string fileName = (s_rootPath / "Atomic.bin").string();
+	const vector<std::byte> first(100, std::byte{ 1 });
+	const vector<std::byte> second(200, std::byte{ 2 });
+
+	Check(FileSystem::WriteFileAtomic(fileName, first), "a new file is written");
+	Check(filesystem::file_size(fileName) == first.size(), "the new file has every byte");
+
+	Check(FileSystem::WriteFileAtomic(fileName, second), "an existing file is replaced");
+	Check(filesystem::file_size(fileName) == second.size(), "the replaced file has every byte");
+
+	const bool written = FileSystem::WriteFileAtomic(fileName, [](ostream& outFile)
+		{
+			outFile << "partial";
+			return false;
+		});
+	Check(!written, "a writer that gives up fails the write");
+	Check(filesystem::file_size(fileName) == second.size(), "a failed write leaves the file alone");
+	Check(!filesystem::exists(fileName + ".tmp"), "a failed write leaves no temporary behind");
+
+	Check(!FileSystem::WriteFileAtomic((s_rootPath / "NoSuchDirectory" / "File.bin").string(), first), "a file that can't be created fails");
+}
+
+
+void TestArchive()
+{
+	mt19937 rng{ 1234 };
+
+	// Every size class:  empty, smaller than an entry's alignment, and larger
+	map<string, vector<std::byte>> files;
+	for (uint32_t i = 0; i < 60; ++i)
+	{
+		const string name = "Dir" + to_string(i % 7) + "/Sub" + to_string(i % 3) + "/File" + to_string(i) + ".bin";
+		const size_t size = i == 5 ? 0 : (i % 10 == 0 ? 100000 + rng() % 100000 : rng() % 5000);
+		files[name] = MakeData(size, i % 2 == 0, rng);
+		WriteFile(s_rootPath / "Source" / name, files[name]);
+	}
+
+	for (bool compress : { false, true })
+	{
+		const string archiveFileName = (s_rootPath / "Test.lpak").string();
+
+		AssetArchiveBuildStats stats;
+		Check(BuildAssetArchive({ .archiveFileName = archiveFileName, .rootPath = s_rootPath / "Source", .compress = compress }, &stats),
+			"the archive builds");
+		Check(stats.numEntries == files.size(), "every file is in the archive");
+		Check(compress ? (stats.numCompressedEntries > 0 && stats.numCompressedEntries < stats.numEntries) : stats.numCompressedEntries == 0,
+			"only compressible entries are compressed");
+		Check(!filesystem::exists(archiveFileName + ".tmp"), "building leaves no temporary behind");
+
+		AssetArchive archive;
+		Check(archive.Open(archiveFileName) && archive.GetNumEntries() == files.size(), "the archive opens");
+
+		for (const auto& [name, data] : files)
+		{
+			// Case and slashes don't matter
+			string spelled = name;
+			replace(spelled.begin(), spelled.end(), '/', '\\');
+			transform(spelled.begin(), spelled.end(), spelled.begin(), ::toupper);
+
+			FileData fileData;
+			Check(archive.Contains(name) && archive.Contains(spelled), "the archive has every file");
+			Check(archive.ReadFile(spelled, fileData) && Matches(fileData, data), "every file reads back the same");
+		}
+
+		Check(!archive.Contains("Dir0/Missing.bin") && !archive.Contains("") && !archive.Contains("Dir0"), "the archive has nothing else");
+
+		// Data read from the archive outlives it
+		FileData kept;
+		archive.ReadFile(files.begin()->first, kept);
+		archive.Close();
+		Check(Matches(kept, files.begin()->second), "data read from an archive outlives it");
+	}
+
+	// A truncated archive is rejected rather than read past its end
+	{
+		const string archiveFileName = (s_rootPath / "Test.lpak").string();
+		filesystem::resize_file(archiveFileName, filesystem::file_size(archiveFileName) / 2);
+
+		AssetArchive archive;
+		Check(!archive.Open(archiveFileName), "a truncated archive doesn't open");
+	}
+
+	Check(!BuildAssetArchive({ .archiveFileName = (s_rootPath / "Duplicate.lpak").string(), .rootPath = s_rootPath / "Source",
+		.files = { "Dir0/Sub0/File0.bin", "dir0\\sub0\\FILE0.BIN" } }), "an archive can't hold the same name twice");
+}
+
+
+void TestFileSystem()
+{
+	mt19937 rng{ 1234 };
+
+	const vector<std::byte> small = MakeData(1000, false, rng);
+	const vector<std::byte> large = MakeData(200000, false, rng);
+	const vector<std::byte> inArchive = MakeData(3000, false, rng);
+
+	WriteFile(s_rootPath / "Loose" / "Small.bin", small);
+	WriteFile(s_rootPath / "Loose" / "Large.bin", large);
+	WriteFile(s_rootPath / "Loose" / "Empty.bin", {});
+	WriteFile(s_rootPath / "Loose" / "Shadowed.bin", small);
+	WriteFile(s_rootPath / "Packed" / "Shadowed.bin", inArchive);
+	Check(BuildAssetArchive({ .archiveFileName = (s_rootPath / "Packed.lpak").string(), .rootPath = s_rootPath / "Packed" }), "the archive builds");
+
+	FileSystem fileSystem{ "LunaFileSystemTests" };
+	fileSystem.SetRootPath(s_rootPath);
+	fileSystem.AddSearchPath("Loose");
+
+	// Small files are read, and larger ones mapped
+	FileData fileData;
+	Check(fileSystem.ReadFile("Small.bin", fileData) && Matches(fileData, small), "a small loose file reads back the same");
+	Check(fileSystem.ReadFile("Large.bin", fileData) && Matches(fileData, large), "a large loose file reads back the same");
+	Check(fileSystem.ReadFile("Empty.bin", fileData) && fileData.GetSize() == 0, "an empty loose file reads back empty");
+	Check(!fileSystem.ReadFile("Missing.bin", fileData), "a missing file can't be read");
+
+	// Mounted archives come ahead of loose files, but only loose files have a path
+	Check(fileSystem.ReadFile("Shadowed.bin", fileData) && Matches(fileData, small), "the loose file is found before mounting");
+	Check(fileSystem.MountArchive("Packed.lpak"), "the archive mounts");
+	Check(fileSystem.ReadFile("shadowed.BIN", fileData) && Matches(fileData, inArchive), "the archive comes ahead of loose files");
+	Check(fileSystem.Exists("Small.bin") && !fileSystem.GetFullPath("Small.bin").empty(), "loose files are still found");
+	fileSystem.UnmountArchive("Packed.lpak");
+	Check(fileSystem.ReadFile("Shadowed.bin", fileData) && Matches(fileData, small), "the loose file is found after unmounting");
+	Check(!fileSystem.MountArchive("Missing.lpak"), "a missing archive doesn't mount");
+
+	// Missing files are remembered until the lookup cache is cleared
+	Check(!fileSystem.Exists("Later.bin"), "a file that isn't there yet isn't found");
+	WriteFile(s_rootPath / "Loose" / "Later.bin", small);
+	Check(!fileSystem.Exists("Later.bin"), "a missing file is remembered");
+	fileSystem.ClearLookupCache();
+	Check(fileSystem.Exists("Later.bin"), "clearing the lookup cache finds new files");
+
+	// Where files were found is remembered too, but a file that moves to another search path is found again
+	filesystem::create_directories(s_rootPath / "Moved");
+	fileSystem.AddSearchPath("Moved", true);
+	Check(fileSystem.ReadFile("Small.bin", fileData) && Matches(fileData, small), "the file is found where it was");
+	filesystem::rename(s_rootPath / "Loose" / "Small.bin", s_rootPath / "Moved" / "Small.bin");
+	Check(fileSystem.ReadFile("Small.bin", fileData) && Matches(fileData, small), "a file that moved is found again");
+	Check(fileSystem.GetFullPath("Small.bin") == (s_rootPath / "Moved" / "Small.bin").string(), "a file that moved has its new path");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	filesystem::remove_all(s_rootPath);
+	filesystem::create_directories(s_rootPath);
+
+	TestStableHash();
+	TestWriteFileAtomic();
+	TestArchive();
+	TestFileSystem();
+
+	filesystem::remove_all(s_rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
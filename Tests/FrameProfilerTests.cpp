@@ -0,0 +1,376 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Core/FrameProfiler.h"
+
+#include "Benchmark.h"
+
+#include <cmath>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// The mock clock runs at 1MHz, so a tick is a microsecond and 1000 ticks are a millisecond
+constexpr uint64_t s_clockFrequency = 1'000'000;
+
+// Set by hand, for tests that need exact times
+atomic<uint64_t> s_now{ 0 };
+
+uint64_t ManualClock()
+{
+	return s_now.load(memory_order_relaxed);
+}
+
+
+// Advances on every reading, so every timestamp a thread reads is unique, and the next one is known
+thread_local uint64_t t_ticks{ 0 };
+
+uint64_t CountingClock()
+{
+	return ++t_ticks;
+}
+
+
+bool NearlyEqual(double a, double b)
+{
+	return fabs(a - b) < 1.0e-9;
+}
+
+
+// Opens a scope at the current time, and closes it after the given number of ticks and whatever the body records
+template <class TFunction>
+void Scope(FrameProfiler& profiler, const string& name, uint64_t ticks, TFunction&& body)
+{
+	profiler.BeginScope(name);
+	body();
+	s_now += ticks;
+	profiler.EndScope();
+}
+
+
+void Scope(FrameProfiler& profiler, const string& name, uint64_t ticks)
+{
+	Scope(profiler, name, ticks, [] {});
+}
+
+
+// Index of the child of parent with the given name, or InvalidProfileNode
+uint32_t FindChild(const FrameProfiler& profiler, const vector<ProfileNode>& tree, uint32_t parent, const string& name)
+{
+	for (uint32_t child : tree[parent].children)
+	{
+		if (profiler.GetName(tree[child].nameId) == name)
+		{
+			return child;
+		}
+	}
+	return InvalidProfileNode;
+}
+
+
+void TestTree()
+{
+	s_now = 0;
+	FrameProfiler profiler{ ManualClock, s_clockFrequency };
+
+	// Update 1ms { Physics 0.1ms, Physics 0.2ms, Animation 0.3ms }, Render 0.5ms { Physics 0.05ms }
+	Scope(profiler, "Update", 400, [&]
+		{
+			Scope(profiler, "Physics", 100);
+			Scope(profiler, "Physics", 200);
+			Scope(profiler, "Animation", 300);
+		});
+	Scope(profiler, "Render", 450, [&] { Scope(profiler, "Physics", 50); });
+	profiler.EndFrame();
+
+	const auto& tree = profiler.GetTree(ProfileTimeline::Cpu);
+	const uint32_t update = FindChild(profiler, tree, 0, "Update");
+	const uint32_t render = FindChild(profiler, tree, 0, "Render");
+	Check(update != InvalidProfileNode && render != InvalidProfileNode && tree[0].children.size() == 2, "top level scopes are children of the root");
+	if (update == InvalidProfileNode || render == InvalidProfileNode)
+	{
+		return;
+	}
+
+	const uint32_t updatePhysics = FindChild(profiler, tree, update, "Physics");
+	const uint32_t animation = FindChild(profiler, tree, update, "Animation");
+	const uint32_t renderPhysics = FindChild(profiler, tree, render, "Physics");
+	Check(updatePhysics != InvalidProfileNode && animation != InvalidProfileNode && renderPhysics != InvalidProfileNode,
+		"nested scopes are children of the enclosing scope");
+	Check(updatePhysics != renderPhysics, "scopes with the same name under different parents are different nodes");
+	if (updatePhysics == InvalidProfileNode || animation == InvalidProfileNode || renderPhysics == InvalidProfileNode)
+	{
+		return;
+	}
+
+	Check(tree[updatePhysics].parent == update && tree[renderPhysics].parent == render, "children know their parents");
+	Check(NearlyEqual(tree[update].lastMs, 1.0) && tree[update].lastCalls == 1, "a parent's time includes its children");
+	Check(NearlyEqual(tree[updatePhysics].lastMs, 0.3) && tree[updatePhysics].lastCalls == 2, "repeated scopes merge their times and calls");
+	Check(NearlyEqual(tree[animation].lastMs, 0.3), "a child has its own time");
+	Check(NearlyEqual(tree[render].lastMs, 0.5) && NearlyEqual(tree[renderPhysics].lastMs, 0.05), "a second parent has its own times");
+	Check(tree[updatePhysics].children.empty() && tree[animation].children.empty(), "leaf scopes have no children");
+}
+
+
+void TestAggregation()
+{
+	s_now = 0;
+	FrameProfiler profiler{ ManualClock, s_clockFrequency };
+
+	for (uint64_t ticks : { 1000, 3000, 2000 })
+	{
+		Scope(profiler, "Update", ticks);
+		profiler.EndFrame();
+	}
+
+	const auto& tree = profiler.GetTree(ProfileTimeline::Cpu);
+	const uint32_t update = FindChild(profiler, tree, 0, "Update");
+	if (update == InvalidProfileNode)
+	{
+		Check(false, "the scope is in the tree");
+		return;
+	}
+
+	Check(tree[update].numFrames == 3, "every frame the scope appeared in is counted");
+	Check(NearlyEqual(tree[update].minMs, 1.0) && NearlyEqual(tree[update].maxMs, 3.0), "min and max are over frames");
+	Check(NearlyEqual(tree[update].GetAvgMs(), 2.0) && NearlyEqual(tree[update].lastMs, 2.0), "the average is over frames");
+
+	// A frame without the scope doesn't count towards its statistics
+	profiler.EndFrame();
+	Check(tree[update].numFrames == 3 && tree[update].lastMs == 0.0 && tree[update].lastCalls == 0, "frames without the scope are skipped");
+
+	profiler.ResetStats();
+	Check(tree[update].numFrames == 0 && tree[update].GetAvgMs() == 0.0, "resetting clears the statistics");
+
+	Scope(profiler, "Update", 5000);
+	profiler.EndFrame();
+	Check(NearlyEqual(tree[update].minMs, 5.0) && NearlyEqual(tree[update].maxMs, 5.0), "statistics start over after a reset");
+}
+
+
+void TestChromeTrace()
+{
+	s_now = 0;
+	FrameProfiler profiler{ ManualClock, s_clockFrequency };
+
+	s_now = 100;
+	Scope(profiler, "Update", 1000, [&] { Scope(profiler, "Quote \" slash \\ tab \t bell \x01", 250); });
+	s_now += 150;
+	profiler.EndFrame();
+
+	const ProfileEvent gpuEvents[] = { { .nameId = profiler.RegisterName("Shadows"), .threadIndex = 1, .depth = 0, .start = 300, .end = 700 } };
+	profiler.AddGpuEvents(0, gpuEvents);
+
+	ostringstream stream;
+	profiler.ExportChromeTrace(stream);
+	const string trace = stream.str();
+
+	auto contains = [&trace](const string& text) { return trace.find(text) != string::npos; };
+	auto count = [&trace](const string& text)
+		{
+			size_t numFound = 0;
+			for (size_t pos = trace.find(text); pos != string::npos; pos = trace.find(text, pos + 1))
+			{
+				++numFound;
+			}
+			return numFound;
+		};
+
+	Check(trace.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") && trace.ends_with("\n]}\n"), "the trace is one JSON object");
+	Check(count("{") == count("}") && count("[") == count("]"), "the trace's braces balance");
+	Check(count("\"ph\":\"X\"") == 4, "the frame, both CPU scopes and the GPU scope are exported");
+
+	// Times are in microseconds from the start of the first frame
+	Check(contains("{\"ph\":\"X\",\"pid\":1,\"tid\":0,\"name\":\"Frame 0\",\"ts\":0.000,\"dur\":1500.000}"), "frames are on the first track");
+	Check(contains("{\"ph\":\"X\",\"pid\":1,\"tid\":1,\"name\":\"Update\",\"ts\":100.000,\"dur\":1250.000}"), "CPU scopes are on their thread's track");
+	Check(contains("\"name\":\"Quote \\\" slash \\\\ tab \\t bell \\u0001\",\"ts\":100.000,\"dur\":250.000}"), "names are escaped");
+	Check(contains("{\"ph\":\"X\",\"pid\":2,\"tid\":1,\"name\":\"Shadows\",\"ts\":300.000,\"dur\":400.000}"), "GPU scopes are on their queue's track");
+	Check(contains("\"pid\":1,\"tid\":1,\"name\":\"thread_name\",\"args\":{\"name\":\"Thread 0\"}"), "CPU threads are named");
+	Check(contains("\"pid\":2,\"tid\":1,\"name\":\"thread_name\",\"args\":{\"name\":\"Queue 1\"}"), "GPU queues are named");
+}
+
+
+// Nested scopes, recorded as the profiler should report them:  by start time, the outer scope first
+struct RecordedEvent
+{
+	uint32_t nameId{ 0 };
+	uint32_t depth{ 0 };
+	uint64_t start{ 0 };
+	uint64_t end{ 0 };
+
+	bool operator==(const RecordedEvent&) const = default;
+};
+
+
+void RecordPair(FrameProfiler& profiler, uint32_t outerNameId, uint32_t innerNameId, vector<RecordedEvent>& outRecorded)
+{
+	const uint64_t outerStart = t_ticks + 1;
+	profiler.BeginScope(outerNameId);
+	const uint64_t innerStart = t_ticks + 1;
+	profiler.BeginScope(innerNameId);
+	const uint64_t innerEnd = t_ticks + 1;
+	profiler.EndScope();
+	const uint64_t outerEnd = t_ticks + 1;
+	profiler.EndScope();
+
+	outRecorded.push_back({ outerNameId, 0, outerStart, outerEnd });
+	outRecorded.push_back({ innerNameId, 1, innerStart, innerEnd });
+}
+
+
+vector<RecordedEvent> ToRecorded(const vector<ProfileEvent>& events)
+{
+	vector<RecordedEvent> recorded;
+	for (const auto& event : events)
+	{
+		recorded.push_back({ event.nameId, event.depth, event.start, event.end });
+	}
+	sort(recorded.begin(), recorded.end(), [](const auto& a, const auto& b) { return a.start < b.start; });
+	return recorded;
+}
+
+
+void TestRingOneThread()
+{
+	FrameProfiler profiler{ CountingClock, s_clockFrequency };
+
+	const uint32_t outer = profiler.RegisterName("Outer");
+	const uint32_t inner = profiler.RegisterName("Inner");
+
+	// 6000 events a frame, so that the ring wraps around every few frames
+	for (uint32_t frame = 0; frame < 10; ++frame)
+	{
+		vector<RecordedEvent> recorded;
+		for (uint32_t i = 0; i < 3000; ++i)
+		{
+			RecordPair(profiler, outer, inner, recorded);
+		}
+		profiler.EndFrame();
+
+		Check(ToRecorded(profiler.GetHistory().back().cpuEvents) == recorded, "a frame has every event, as recorded");
+	}
+	Check(profiler.GetNumDroppedEvents() == 0, "a ring that is drained every frame drops nothing");
+
+	// A full ring keeps the oldest events, and counts the rest as dropped
+	vector<RecordedEvent> recorded;
+	for (uint32_t i = 0; i < 10000; ++i)
+	{
+		RecordPair(profiler, outer, inner, recorded);
+	}
+	profiler.EndFrame();
+
+	// The ring holds an even number of events, so it keeps whole pairs
+	const vector<RecordedEvent> kept = ToRecorded(profiler.GetHistory().back().cpuEvents);
+	Check(kept.size() == 16384 && profiler.GetNumDroppedEvents() == 20000 - 16384, "a full ring drops the newest events");
+	Check(kept.size() == 16384 && equal(kept.begin(), kept.end(), recorded.begin()), "a full ring keeps the oldest events");
+}
+
+
+// Every producer writes into its own ring while the frame's owner drains them all.  Producers hold back once
+// they are a batch ahead of the drain, so that no ring fills up and every event has to arrive.
+void TestRingManyThreads()
+{
+	constexpr uint32_t numProducers = 4;
+	constexpr uint32_t numBatches = 20;
+	constexpr uint32_t pairsPerBatch = 2000;
+
+	FrameProfiler profiler{ CountingClock, s_clockFrequency };
+
+	atomic<uint64_t> numFramesDone{ 0 };
+	atomic<uint32_t> numProducersDone{ 0 };
+	vector<vector<RecordedEvent>> recorded(numProducers);
+
+	vector<thread> producers;
+	for (uint32_t p = 0; p < numProducers; ++p)
+	{
+		producers.emplace_back([&, p]
+			{
+				const uint32_t outer = profiler.RegisterName("Outer " + to_string(p));
+				const uint32_t inner = profiler.RegisterName("Inner " + to_string(p));
+
+				for (uint32_t batch = 0; batch < numBatches; ++batch)
+				{
+					const uint64_t framesBefore = numFramesDone.load();
+					for (uint32_t i = 0; i < pairsPerBatch; ++i)
+					{
+						RecordPair(profiler, outer, inner, recorded[p]);
+					}
+
+					// Wait for a frame that started after the batch was written
+					while (numFramesDone.load() < framesBefore + 2)
+					{
+						this_thread::yield();
+					}
+				}
+				numProducersDone.fetch_add(1);
+			});
+	}
+
+	map<uint32_t, vector<ProfileEvent>> eventsByThread;
+	auto endFrame = [&]
+		{
+			profiler.EndFrame();
+			for (const auto& event : profiler.GetHistory().back().cpuEvents)
+			{
+				eventsByThread[event.threadIndex].push_back(event);
+			}
+			numFramesDone.fetch_add(1);
+		};
+
+	while (numProducersDone.load() < numProducers)
+	{
+		endFrame();
+		this_thread::yield();
+	}
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+	endFrame();
+
+	Check(profiler.GetNumDroppedEvents() == 0, "no producer fills its ring");
+	Check(eventsByThread.size() == numProducers, "every producer has its own ring");
+
+	vector<bool> matched(numProducers, false);
+	for (const auto& [threadIndex, events] : eventsByThread)
+	{
+		const string name = profiler.GetName(events.front().nameId);
+		const uint32_t p = (uint32_t)stoul(name.substr(name.find(' ') + 1));
+
+		Check(p < numProducers && !matched[p], "each ring belongs to one producer");
+		if (p < numProducers)
+		{
+			matched[p] = true;
+			Check(ToRecorded(events) == recorded[p], "every event arrives once, in order, on its producer's thread");
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	TestTree();
+	TestAggregation();
+	TestChromeTrace();
+	TestRingOneThread();
+	TestRingManyThreads();
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Core/CpuFeatures.h"
+#include "Core/Math/FrustumCulling.h"
+
+#include "Benchmark.h"
+#include "FrustumCullingData.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace Luna::Tests;
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+struct PathResult
+{
+	double sphereMs{ 0.0 };
+	double boxMs{ 0.0 };
+	uint32_t numVisibleSpheres{ 0 };
+	uint32_t numVisibleBoxes{ 0 };
+	vector<uint32_t> visibleSpheres;
+	vector<uint32_t> visibleBoxes;
+};
+
+
+PathResult RunPath(BatchPath path, const FrustumPlanes& planes, const BoundingSphereSoA& spheres, const BoundingBoxSoA& boxes, uint32_t numRuns)
+{
+	PathResult result;
+	result.visibleSpheres.resize(spheres.GetCount());
+	result.visibleBoxes.resize(boxes.GetCount());
+
+	result.sphereMs = MeasureMs(numRuns, [&] { result.numVisibleSpheres = CullSpheres(planes, spheres, span<uint32_t>{ result.visibleSpheres }, path); });
+	result.boxMs = MeasureMs(numRuns, [&] { result.numVisibleBoxes = CullBoundingBoxes(planes, boxes, span<uint32_t>{ result.visibleBoxes }, path); });
+
+	result.visibleSpheres.resize(result.numVisibleSpheres);
+	result.visibleBoxes.resize(result.numVisibleBoxes);
+	return result;
+}
+
+
+const char* GetPathName(BatchPath path)
+{
+	switch (path)
+	{
+	case BatchPath::Scalar: return "Scalar";
+	case BatchPath::SSE: return "SSE";
+	case BatchPath::AVX: return "AVX";
+	default: return "Best";
+	}
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numObjects = commandLine.Size(1000000, 10000);
+	const uint32_t numRuns = commandLine.Size(10, 1);
+
+	mt19937 rng{ 1234 };
+	const auto sphereArrays = MakeSpheres(numObjects, 100.0f, rng);
+	const auto boxArrays = MakeBoxes(numObjects, 100.0f, rng);
+	const auto spheres = sphereArrays.GetSoA(numObjects);
+	const auto boxes = boxArrays.GetSoA(numObjects);
+
+	const float position[3] = { 0.0f, 0.0f, 0.0f };
+	const FrustumPlanes planes = MakePerspectiveFrustum(1.0f, 0.5625f, 0.1f, 150.0f, 0.4f, position);
+
+	vector<BatchPath> paths{ BatchPath::Scalar, BatchPath::SSE };
+	if (HasAVX())
+	{
+		paths.push_back(BatchPath::AVX);
+	}
+
+	printf("Frustum culling benchmark, %u objects, fastest of %u runs\n\n", numObjects, numRuns);
+	printf("%-8s %28s %28s\n", "Path", "Spheres", "Boxes");
+
+	PathResult scalar;
+	for (BatchPath path : paths)
+	{
+		PathResult result = RunPath(path, planes, spheres, boxes, numRuns);
+
+		printf("%-8s %9.2f ns/object %6.1fM/s %9.2f ns/object %6.1fM/s\n", GetPathName(path),
+			result.sphereMs * 1.0e6 / numObjects, numObjects / (result.sphereMs * 1.0e3),
+			result.boxMs * 1.0e6 / numObjects, numObjects / (result.boxMs * 1.0e3));
+
+		if (path == BatchPath::Scalar)
+		{
+			scalar = move(result);
+		}
+		else
+		{
+			Check(result.visibleSpheres == scalar.visibleSpheres, "every path culls the same spheres as the scalar path");
+			Check(result.visibleBoxes == scalar.visibleBoxes, "every path culls the same boxes as the scalar path");
+		}
+	}
+
+	printf("\n%.1f%% of spheres and %.1f%% of boxes visible\n", 100.0 * scalar.numVisibleSpheres / numObjects, 100.0 * scalar.numVisibleBoxes / numObjects);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#pragma once
+
+// Frusta and random objects shared by the frustum culling tests and benchmark, in plain floats
+
+#include "Core/Math/FrustumCulling.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+namespace Luna::Tests
+{
+
+// A perspective frustum looking down -Z, built like Frustum::ConstructPerspectiveFrustum(), then rotated about
+// Y and moved to position
+inline Math::FrustumPlanes MakePerspectiveFrustum(float hTan, float vTan, float nearClip, float farClip, float yaw, const float position[3])
+{
+	const float nhx = 1.0f / sqrtf(1.0f + hTan * hTan);
+	const float nvy = 1.0f / sqrtf(1.0f + vTan * vTan);
+
+	// Near, far, left, right, top, bottom, as (nx, ny, nz, d) in view space
+	const float viewPlanes[6][4] = {
+		{ 0.0f, 0.0f, -1.0f, -nearClip },
+		{ 0.0f, 0.0f, 1.0f, farClip },
+		{ nhx, 0.0f, -nhx * hTan, 0.0f },
+		{ -nhx, 0.0f, -nhx * hTan, 0.0f },
+		{ 0.0f, -nvy, -nvy * vTan, 0.0f },
+		{ 0.0f, nvy, -nvy * vTan, 0.0f }
+	};
+
+	const float cosYaw = cosf(yaw);
+	const float sinYaw = sinf(yaw);
+
+	Math::FrustumPlanes planes{};
+	for (int i = 0; i < 6; ++i)
+	{
+		const float nx = cosYaw * viewPlanes[i][0] + sinYaw * viewPlanes[i][2];
+		const float ny = viewPlanes[i][1];
+		const float nz = -sinYaw * viewPlanes[i][0] + cosYaw * viewPlanes[i][2];
+
+		planes.normalX[i] = nx;
+		planes.normalY[i] = ny;
+		planes.normalZ[i] = nz;
+		planes.distance[i] = viewPlanes[i][3] - (nx * position[0] + ny * position[1] + nz * position[2]);
+	}
+	return planes;
+}
+
+
+struct SphereArrays
+{
+	std::vector<float> centerX, centerY, centerZ, radius;
+
+	Math::BoundingSphereSoA GetSoA(size_t count) const { return { { centerX.data(), count }, { centerY.data(), count }, { centerZ.data(), count }, { radius.data(), count } }; }
+};
+
+
+struct BoxArrays
+{
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+	Math::BoundingBoxSoA GetSoA(size_t count) const
+	{
+		return { { minX.data(), count }, { minY.data(), count }, { minZ.data(), count }, { maxX.data(), count }, { maxY.data(), count }, { maxZ.data(), count } };
+	}
+};
+
+
+// Objects scattered through a cube around the origin, sized so that a good share of them straddle the planes
+inline SphereArrays MakeSpheres(size_t count, float halfSize, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> coordinate{ -halfSize, halfSize };
+	std::uniform_real_distribution<float> size{ 0.0f, halfSize * 0.05f };
+
+	SphereArrays spheres;
+	for (size_t i = 0; i < count; ++i)
+	{
+		spheres.centerX.push_back(coordinate(rng));
+		spheres.centerY.push_back(coordinate(rng));
+		spheres.centerZ.push_back(coordinate(rng));
+		spheres.radius.push_back(size(rng));
+	}
+	return spheres;
+}
+
+
+inline BoxArrays MakeBoxes(size_t count, float halfSize, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> coordinate{ -halfSize, halfSize };
+	std::uniform_real_distribution<float> size{ 0.0f, halfSize * 0.05f };
+
+	BoxArrays boxes;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float x = coordinate(rng);
+		const float y = coordinate(rng);
+		const float z = coordinate(rng);
+		boxes.minX.push_back(x);
+		boxes.minY.push_back(y);
+		boxes.minZ.push_back(z);
+		boxes.maxX.push_back(x + size(rng));
+		boxes.maxY.push_back(y + size(rng));
+		boxes.maxZ.push_back(z + size(rng));
+	}
+	return boxes;
+}
+
+} // namespace Luna::Tests
@@ -0,0 +1,215 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Core/CpuFeatures.h"
+#include "Core/Math/FrustumCulling.h"
+
+#include "Benchmark.h"
+#include "FrustumCullingData.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace Luna::Tests;
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+// The contract from FrustumCulling.h, one object at a time
+bool IsSphereVisible(const FrustumPlanes& planes, const SphereArrays& spheres, size_t i)
+{
+	for (int p = 0; p < 6; ++p)
+	{
+		const float distance = spheres.centerX[i] * planes.normalX[p] + spheres.centerY[i] * planes.normalY[p] + spheres.centerZ[i] * planes.normalZ[p] + planes.distance[p];
+		if (distance + spheres.radius[i] < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool IsBoxVisible(const FrustumPlanes& planes, const BoxArrays& boxes, size_t i)
+{
+	for (int p = 0; p < 6; ++p)
+	{
+		const float x = planes.normalX[p] > 0.0f ? boxes.maxX[i] : boxes.minX[i];
+		const float y = planes.normalY[p] > 0.0f ? boxes.maxY[i] : boxes.minY[i];
+		const float z = planes.normalZ[p] > 0.0f ? boxes.maxZ[i] : boxes.minZ[i];
+		if (x * planes.normalX[p] + y * planes.normalY[p] + z * planes.normalZ[p] + planes.distance[p] < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+template <class TIsVisible, class TCullIndices, class TCullMask>
+void CheckPath(const char* what, BatchPath path, size_t count, TIsVisible&& isVisible, TCullIndices&& cullIndices, TCullMask&& cullMask)
+{
+	vector<uint32_t> expected;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (isVisible(i))
+		{
+			expected.push_back((uint32_t)i);
+		}
+	}
+
+	// Poison the outputs, so that bits and indices left unwritten show up
+	vector<uint32_t> visible(count + 1, ~0u);
+	const uint32_t numVisible = cullIndices(span<uint32_t>{ visible.data(), count }, path);
+	visible.resize(numVisible);
+
+	vector<uint64_t> mask((count + 63) / 64, ~0ull);
+	cullMask(span<uint64_t>{ mask }, path);
+
+	bool maskMatches = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const bool bit = (mask[i / 64] >> (i % 64)) & 1;
+		maskMatches = maskMatches && bit == isVisible(i);
+	}
+	for (size_t i = count; i < mask.size() * 64; ++i)
+	{
+		maskMatches = maskMatches && ((mask[i / 64] >> (i % 64)) & 1) == 0;
+	}
+
+	if (visible != expected || !maskMatches)
+	{
+		fprintf(stderr, "%s, path %d, %zu objects: %u visible, %zu expected\n", what, (int)path, count, numVisible, expected.size());
+	}
+	Check(visible == expected, "visible indices match the reference");
+	Check(maskMatches, "visibility masks match the reference");
+}
+
+
+void CheckAllPaths(const FrustumPlanes& planes, const SphereArrays& spheres, const BoxArrays& boxes, size_t count)
+{
+	vector<BatchPath> paths{ BatchPath::Scalar, BatchPath::SSE, BatchPath::Best };
+	if (HasAVX())
+	{
+		paths.push_back(BatchPath::AVX);
+	}
+
+	const auto sphereSoA = spheres.GetSoA(count);
+	const auto boxSoA = boxes.GetSoA(count);
+
+	for (BatchPath path : paths)
+	{
+		CheckPath("spheres", path, count,
+			[&](size_t i) { return IsSphereVisible(planes, spheres, i); },
+			[&](span<uint32_t> out, BatchPath p) { return CullSpheres(planes, sphereSoA, out, p); },
+			[&](span<uint64_t> out, BatchPath p) { CullSpheres(planes, sphereSoA, out, p); });
+
+		CheckPath("boxes", path, count,
+			[&](size_t i) { return IsBoxVisible(planes, boxes, i); },
+			[&](span<uint32_t> out, BatchPath p) { return CullBoundingBoxes(planes, boxSoA, out, p); },
+			[&](span<uint64_t> out, BatchPath p) { CullBoundingBoxes(planes, boxSoA, out, p); });
+	}
+}
+
+
+// Objects that sit exactly on a plane, or just either side of it, where a different corner or summation order
+// would change the answer
+void AddPlaneHuggers(const FrustumPlanes& planes, SphereArrays& spheres, BoxArrays& boxes)
+{
+	for (int p = 0; p < 6; ++p)
+	{
+		// The point on the plane closest to the origin
+		const float x = -planes.distance[p] * planes.normalX[p];
+		const float y = -planes.distance[p] * planes.normalY[p];
+		const float z = -planes.distance[p] * planes.normalZ[p];
+
+		for (float offset : { -1.0e-3f, -1.0e-6f, 0.0f, 1.0e-6f, 1.0e-3f })
+		{
+			spheres.centerX.push_back(x - planes.normalX[p] * offset);
+			spheres.centerY.push_back(y - planes.normalY[p] * offset);
+			spheres.centerZ.push_back(z - planes.normalZ[p] * offset);
+			spheres.radius.push_back(0.0f);
+
+			// Degenerate boxes, so the corner that is tested is the point itself
+			boxes.minX.push_back(spheres.centerX.back());
+			boxes.minY.push_back(spheres.centerY.back());
+			boxes.minZ.push_back(spheres.centerZ.back());
+			boxes.maxX.push_back(spheres.centerX.back());
+			boxes.maxY.push_back(spheres.centerY.back());
+			boxes.maxZ.push_back(spheres.centerZ.back());
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 42 };
+
+	const float position[3] = { 3.0f, -2.0f, 10.0f };
+	const FrustumPlanes frusta[] = {
+		MakePerspectiveFrustum(1.0f, 0.5625f, 0.1f, 100.0f, 0.0f, position),
+		MakePerspectiveFrustum(0.7f, 0.7f, 1.0f, 50.0f, 2.3f, position),
+		MakePerspectiveFrustum(3.0f, 0.2f, 0.01f, 1000.0f, -0.8f, position)
+	};
+
+	// The first objects test the obvious cases, so the counts below include them even when small
+	for (const auto& planes : frusta)
+	{
+		SphereArrays spheres;
+		BoxArrays boxes;
+		AddPlaneHuggers(planes, spheres, boxes);
+
+		const size_t numHuggers = spheres.radius.size();
+		const auto randomSpheres = MakeSpheres(2000, 60.0f, rng);
+		const auto randomBoxes = MakeBoxes(2000, 60.0f, rng);
+
+		spheres.centerX.insert(spheres.centerX.end(), randomSpheres.centerX.begin(), randomSpheres.centerX.end());
+		spheres.centerY.insert(spheres.centerY.end(), randomSpheres.centerY.begin(), randomSpheres.centerY.end());
+		spheres.centerZ.insert(spheres.centerZ.end(), randomSpheres.centerZ.begin(), randomSpheres.centerZ.end());
+		spheres.radius.insert(spheres.radius.end(), randomSpheres.radius.begin(), randomSpheres.radius.end());
+
+		boxes.minX.insert(boxes.minX.end(), randomBoxes.minX.begin(), randomBoxes.minX.end());
+		boxes.minY.insert(boxes.minY.end(), randomBoxes.minY.begin(), randomBoxes.minY.end());
+		boxes.minZ.insert(boxes.minZ.end(), randomBoxes.minZ.begin(), randomBoxes.minZ.end());
+		boxes.maxX.insert(boxes.maxX.end(), randomBoxes.maxX.begin(), randomBoxes.maxX.end());
+		boxes.maxY.insert(boxes.maxY.end(), randomBoxes.maxY.begin(), randomBoxes.maxY.end());
+		boxes.maxZ.insert(boxes.maxZ.end(), randomBoxes.maxZ.begin(), randomBoxes.maxZ.end());
+
+		// Counts around the 4 and 8 wide kernels and the 64 bit mask words
+		for (size_t count : { (size_t)0, (size_t)1, (size_t)3, (size_t)4, (size_t)7, (size_t)8, (size_t)9, (size_t)63, (size_t)64, (size_t)65, numHuggers, spheres.radius.size() })
+		{
+			CheckAllPaths(planes, spheres, boxes, count);
+		}
+
+		// A box around the camera and past the near plane is always visible, and one past the far plane never is
+		const float cameraBox[6] = { position[0] - 2.0f, position[1] - 2.0f, position[2] - 2.0f, position[0] + 2.0f, position[1] + 2.0f, position[2] + 2.0f };
+		const BoundingBoxSoA cameraSoA{ { &cameraBox[0], 1 }, { &cameraBox[1], 1 }, { &cameraBox[2], 1 }, { &cameraBox[3], 1 }, { &cameraBox[4], 1 }, { &cameraBox[5], 1 } };
+		uint64_t cameraMask{ 0 };
+		CullBoundingBoxes(planes, cameraSoA, span<uint64_t>{ &cameraMask, 1 });
+		Check(cameraMask == 1, "a box around the camera is visible");
+
+		const float farAway = 1.0e6f;
+		const BoundingBoxSoA farSoA{ { &farAway, 1 }, { &farAway, 1 }, { &farAway, 1 }, { &farAway, 1 }, { &farAway, 1 }, { &farAway, 1 } };
+		uint64_t farMask{ 1 };
+		CullBoundingBoxes(planes, farSoA, span<uint64_t>{ &farMask, 1 });
+		Check(farMask == 0, "a box past the far plane is culled");
+	}
+
+	printf("Frustum culling: every path matches the reference%s\n", HasAVX() ? ", AVX included" : ", AVX not supported here");
+
+	return FailureCount() == 0 ? 0 : 1;
+}
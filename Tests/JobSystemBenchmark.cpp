@@ -0,0 +1,229 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Core/JobSystem.h"
+
+#include "Benchmark.h"
+
+#include <cmath>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Stands in for a small amount of real work, about a nanosecond per iteration
+uint32_t Work(uint32_t seed, uint32_t numIterations)
+{
+	uint32_t value = seed;
+	for (uint32_t i = 0; i < numIterations; ++i)
+	{
+		value = value * 1664525u + 1013904223u;
+	}
+	return value;
+}
+
+
+// Empty jobs scheduled from a thread that is not a worker, so every one goes through the shared queue
+double TinyJobsOneProducer(JobSystem& jobSystem, uint32_t numJobs, uint32_t numRuns)
+{
+	atomic<uint32_t> numDone{ 0 };
+
+	const double ms = MeasureMs(numRuns, [&]
+		{
+			auto counter = MakeJobHandle(numJobs);
+			for (uint32_t i = 0; i < numJobs; ++i)
+			{
+				jobSystem.Schedule([&numDone] { numDone.fetch_add(1, memory_order_relaxed); }, nullptr, counter);
+			}
+			jobSystem.Wait(counter);
+		});
+
+	Check(numDone == numJobs * max(numRuns, 1u), "every tiny job from one producer ran once");
+	return ms;
+}
+
+
+// Empty jobs scheduled from every thread at once, each into its own queue
+double TinyJobsAllProducers(JobSystem& jobSystem, uint32_t numJobs, uint32_t numRuns)
+{
+	const uint32_t numProducers = jobSystem.GetNumWorkers() + 1;
+	const uint32_t jobsPerProducer = numJobs / numProducers;
+	atomic<uint32_t> numDone{ 0 };
+
+	const double ms = MeasureMs(numRuns, [&]
+		{
+			auto counter = MakeJobHandle(jobsPerProducer * numProducers);
+			jobSystem.ParallelFor(numProducers, 1, [&](uint32_t)
+				{
+					for (uint32_t i = 0; i < jobsPerProducer; ++i)
+					{
+						jobSystem.Schedule([&numDone] { numDone.fetch_add(1, memory_order_relaxed); }, nullptr, counter);
+					}
+				});
+			jobSystem.Wait(counter);
+		});
+
+	Check(numDone == jobsPerProducer * numProducers * max(numRuns, 1u), "every tiny job from all producers ran once");
+	return ms;
+}
+
+
+// Each job spawns fanOut children and waits for them, down to the given depth.  Waiting jobs run other jobs,
+// so this measures the cost of nested waits as well as of scheduling.
+void ForkJoin(JobSystem& jobSystem, uint32_t fanOut, uint32_t depth, atomic<uint32_t>& numLeaves)
+{
+	if (depth == 0)
+	{
+		KeepResult(Work(fanOut, 100));
+		numLeaves.fetch_add(1, memory_order_relaxed);
+		return;
+	}
+
+	auto counter = MakeJobHandle(fanOut);
+	for (uint32_t i = 0; i < fanOut; ++i)
+	{
+		jobSystem.Schedule([&jobSystem, fanOut, depth, &numLeaves] { ForkJoin(jobSystem, fanOut, depth - 1, numLeaves); }, nullptr, counter);
+	}
+	jobSystem.Wait(counter);
+}
+
+
+double ForkJoinTree(JobSystem& jobSystem, uint32_t fanOut, uint32_t depth, uint32_t numRuns)
+{
+	atomic<uint32_t> numLeaves{ 0 };
+
+	const double ms = MeasureMs(numRuns, [&] { ForkJoin(jobSystem, fanOut, depth, numLeaves); });
+
+	Check(numLeaves == (uint32_t)pow(fanOut, depth) * max(numRuns, 1u), "every fork/join leaf ran once");
+	return ms;
+}
+
+
+// One worker queues every job, so all of the other threads have to steal from the same queue
+double StealContention(JobSystem& jobSystem, uint32_t numJobs, uint32_t numRuns, double& outStolenFraction)
+{
+	atomic<uint32_t> numDone{ 0 };
+	const auto statsBefore = jobSystem.GetStats();
+
+	const double ms = MeasureMs(numRuns, [&]
+		{
+			auto counter = MakeJobHandle(numJobs);
+			auto producer = jobSystem.Schedule([&]
+				{
+					for (uint32_t i = 0; i < numJobs; ++i)
+					{
+						jobSystem.Schedule([&numDone, i] { KeepResult(Work(i, 200)); numDone.fetch_add(1, memory_order_relaxed); }, nullptr, counter);
+					}
+				});
+			jobSystem.Wait(producer);
+			jobSystem.Wait(counter);
+		});
+
+	const auto statsAfter = jobSystem.GetStats();
+	outStolenFraction = (double)(statsAfter.numJobsStolen - statsBefore.numJobsStolen) / (double)(numJobs * max(numRuns, 1u));
+
+	Check(numDone == numJobs * max(numRuns, 1u), "every contended job ran once");
+	return ms;
+}
+
+
+// Data-parallel loop over a compute-bound kernel, compared against the same loop on one thread
+double ParallelForKernel(JobSystem* jobSystem, vector<float>& data, uint32_t numRuns)
+{
+	const uint32_t count = (uint32_t)data.size();
+	auto kernel = [&data](uint32_t i)
+		{
+			float x = (float)i;
+			for (uint32_t j = 0; j < 16; ++j)
+			{
+				x = sqrt(x * 1.0001f + 1.0f);
+			}
+			data[i] = x;
+		};
+
+	return MeasureMs(numRuns, [&]
+		{
+			if (jobSystem)
+			{
+				jobSystem->ParallelFor(count, kernel);
+			}
+			else
+			{
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					kernel(i);
+				}
+			}
+		});
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numTinyJobs = commandLine.Size(200000, 2000);
+	const uint32_t numContendedJobs = commandLine.Size(100000, 1000);
+	const uint32_t fanOut = commandLine.Size(16, 4);
+	const uint32_t numRuns = commandLine.Size(5, 1);
+
+	// Sweep 2, 4, 8... threads, the calling thread included, up to the number of hardware threads
+	const uint32_t maxThreads = commandLine.GetOption("--threads", max(thread::hardware_concurrency(), 2u));
+	vector<uint32_t> threadCounts;
+	for (uint32_t numThreads = 2; numThreads < maxThreads; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+	}
+	threadCounts.push_back(max(maxThreads, 2u));
+
+	vector<float> data(commandLine.Size(1u << 22, 1u << 12));
+	const double serialMs = ParallelForKernel(nullptr, data, numRuns);
+	const float serialChecksum = data[data.size() / 2];
+
+	printf("Job system benchmark, %u hardware threads, fastest of %u runs\n\n", thread::hardware_concurrency(), numRuns);
+	printf("%-8s %26s %26s %18s %26s %22s\n", "Threads", "Tiny jobs, 1 producer", "Tiny jobs, all producers",
+		"Fork/join, 3 deep", "Steal contention", "ParallelFor speedup");
+
+	for (uint32_t numThreads : threadCounts)
+	{
+		JobSystem jobSystem{ numThreads - 1 };
+
+		const double oneProducerMs = TinyJobsOneProducer(jobSystem, numTinyJobs, numRuns);
+		const double allProducersMs = TinyJobsAllProducers(jobSystem, numTinyJobs, numRuns);
+		const double forkJoinMs = ForkJoinTree(jobSystem, fanOut, 3, numRuns);
+
+		double stolenFraction{ 0.0 };
+		const double stealMs = StealContention(jobSystem, numContendedJobs, numRuns, stolenFraction);
+
+		fill(data.begin(), data.end(), 0.0f);
+		const double parallelMs = ParallelForKernel(&jobSystem, data, numRuns);
+		Check(data[data.size() / 2] == serialChecksum, "ParallelFor matches the serial loop");
+
+		const uint32_t numForkJoinJobs = fanOut + fanOut * fanOut + fanOut * fanOut * fanOut;
+
+		printf("%-8u %12.1f ns/job %5.1fM/s %12.1f ns/job %5.1fM/s %11.1f ns/job %12.1f ns/job %5.1f%% stolen %18.2fx\n",
+			numThreads,
+			oneProducerMs * 1.0e6 / numTinyJobs, numTinyJobs / (oneProducerMs * 1.0e3),
+			allProducersMs * 1.0e6 / numTinyJobs, numTinyJobs / (allProducersMs * 1.0e3),
+			forkJoinMs * 1.0e6 / numForkJoinJobs,
+			stealMs * 1.0e6 / numContendedJobs, stolenFraction * 100.0,
+			serialMs / parallelMs);
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
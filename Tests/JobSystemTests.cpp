@@ -0,0 +1,191 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Core/JobSystem.h"
+
+#include "Benchmark.h"
+
+#include <stdexcept>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Returns the message of the exception the wait rethrows, or an empty string if it returns normally
+template <class TWait>
+string CatchMessage(TWait&& wait)
+{
+	try
+	{
+		wait();
+	}
+	catch (const exception& e)
+	{
+		return e.what();
+	}
+	return {};
+}
+
+
+void TestScheduleAndWait()
+{
+	JobSystem jobSystem{ 2 };
+
+	atomic<uint32_t> numDone{ 0 };
+	auto counter = MakeJobHandle(100);
+	for (uint32_t i = 0; i < 100; ++i)
+	{
+		jobSystem.Schedule([&numDone] { numDone.fetch_add(1); }, nullptr, counter);
+	}
+	jobSystem.Wait(counter);
+	Check(numDone == 100 && counter->IsDone() && !counter->HasFailed(), "every job ran, and the counter finished cleanly");
+
+	uint32_t order{ 0 };
+	auto first = jobSystem.Schedule([&order] { order = order * 10 + 1; });
+	auto second = jobSystem.Schedule([&order] { order = order * 10 + 2; }, first);
+	WaitForJob(second);
+	Check(order == 12, "a job runs after the job it depends on");
+}
+
+
+// A throwing job used to skip the decrement, so whoever waited on its counter slept forever
+void TestThrowingJob()
+{
+	JobSystem jobSystem{ 2 };
+
+	auto handle = jobSystem.Schedule([] { throw runtime_error("job failed"); });
+	Check(CatchMessage([&] { WaitForJob(handle); }) == "job failed", "waiting on a job that threw rethrows its exception");
+	Check(handle->IsDone() && handle->HasFailed(), "the job still counts as finished");
+	Check(CatchMessage([&] { jobSystem.Wait(handle); }) == "job failed", "every wait on the counter rethrows");
+
+	auto after = jobSystem.Schedule([] {});
+	WaitForJob(after);
+	Check(after->IsDone() && !after->HasFailed(), "the job system carries on after a job throws");
+}
+
+
+// The other jobs on the counter all finish before the wait rethrows
+void TestThrowingJobInGroup()
+{
+	JobSystem jobSystem{ 3 };
+
+	atomic<uint32_t> numDone{ 0 };
+	auto counter = MakeJobHandle(64);
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		jobSystem.Schedule([&numDone, i] {
+				if (i == 17)
+				{
+					throw runtime_error("one of many");
+				}
+				numDone.fetch_add(1);
+			}, nullptr, counter);
+	}
+
+	Check(CatchMessage([&] { jobSystem.Wait(counter); }) == "one of many", "the group's wait rethrows");
+	Check(numDone == 63, "every other job in the group ran first");
+}
+
+
+// With one worker taking jobs oldest first from the shared queue, the first job to throw is known
+void TestFirstExceptionKept()
+{
+	JobSystem jobSystem{ 1 };
+
+	auto counter = MakeJobHandle(2);
+	jobSystem.Schedule([] { throw runtime_error("first"); }, nullptr, counter);
+	jobSystem.Schedule([] { throw logic_error("second"); }, nullptr, counter);
+
+	// Spun on rather than waited for, so the calling thread doesn't run either job itself
+	while (!counter->IsDone()) { this_thread::yield(); }
+
+	Check(CatchMessage([&] { jobSystem.Wait(counter); }) == "first", "the first exception is the one kept");
+}
+
+
+void TestDependentOfThrowingJob()
+{
+	JobSystem jobSystem{ 2 };
+
+	bool dependentRan{ false };
+	auto failed = jobSystem.Schedule([] { throw runtime_error("dependency failed"); });
+	auto dependent = jobSystem.Schedule([&dependentRan] { dependentRan = true; }, failed);
+
+	Check(CatchMessage([&] { WaitForJob(dependent); }).empty() && dependentRan, "a job depending on one that threw still runs");
+	Check(CatchMessage([&] { WaitForJob(failed); }) == "dependency failed", "and the failed job's own wait rethrows");
+}
+
+
+// A thread that waits runs other jobs meanwhile.  One of those throwing belongs to its own counter, and must not
+// escape into the unrelated wait.
+void TestThrowWhileRunningAnotherWait()
+{
+	JobSystem jobSystem{ 1 };
+
+	// Hold the only worker, so the calling thread runs the queued jobs itself while it waits
+	atomic<bool> gateEntered{ false };
+	atomic<bool> gateOpen{ false };
+	auto gate = jobSystem.Schedule([&] {
+			gateEntered = true;
+			while (!gateOpen) { this_thread::yield(); }
+		});
+	while (!gateEntered) { this_thread::yield(); }
+
+	auto failed = jobSystem.Schedule([] { throw runtime_error("not yours"); });
+	auto opener = jobSystem.Schedule([&gateOpen] { gateOpen = true; });
+
+	Check(CatchMessage([&] { jobSystem.Wait(opener); }).empty(), "a job run while waiting doesn't throw into the wait");
+	Check(failed->IsDone() && failed->HasFailed(), "the job that threw ran on the waiting thread");
+	Check(CatchMessage([&] { WaitForJob(failed); }) == "not yours", "its own wait rethrows");
+
+	WaitForJob(gate);
+}
+
+
+void TestParallelForThrows()
+{
+	JobSystem jobSystem{ 3 };
+
+	atomic<uint32_t> numDone{ 0 };
+	const string message = CatchMessage([&] {
+			jobSystem.ParallelFor(1000, 10, [&numDone](uint32_t i) {
+					if (i == 555)
+					{
+						throw out_of_range("index 555");
+					}
+					numDone.fetch_add(1);
+				});
+		});
+
+	Check(message == "index 555", "ParallelFor rethrows on the calling thread");
+	Check(numDone >= 990 && numDone < 1000, "the other batches still ran");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	TestScheduleAndWait();
+	TestThrowingJob();
+	TestThrowingJobInGroup();
+	TestFirstExceptionKept();
+	TestDependentOfThrowingJob();
+	TestThrowWhileRunningAnotherWait();
+	TestParallelForThrows();
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "LogMessageQueue.h"
+
+#include "Benchmark.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// LogSystem's own settings
+const size_t s_capacity = 4096;
+const size_t s_messageReserveSize = 256;
+
+
+struct Result
+{
+	double messagesPerSecond{ 0.0 };
+	double p50Us{ 0.0 };
+	double p99Us{ 0.0 };
+	double maxUs{ 0.0 };
+};
+
+
+// Producers push typical log lines as fast as they can while one worker drains them, the way LogSystem does.
+// Latency is from the message's timestamp, taken just before Push, to the worker popping it.
+Result Run(uint32_t numProducers, uint32_t messagesPerProducer)
+{
+	LogMessageQueue queue{ s_capacity, s_messageReserveSize };
+	atomic<bool> cancel{ false };
+
+	const uint32_t numMessages = numProducers * messagesPerProducer;
+	vector<float> latenciesUs;
+	latenciesUs.reserve(numMessages);
+
+	const auto startTime = chrono::steady_clock::now();
+
+	thread worker{ [&]
+		{
+			auto receive = [&latenciesUs](const LogMessage& message)
+				{
+					const auto latency = chrono::system_clock::now() - message.timestamp;
+					latenciesUs.push_back(chrono::duration<float, micro>(latency).count());
+				};
+
+			for (;;)
+			{
+				queue.PopAll(receive);
+				if (cancel.load())
+				{
+					queue.PopAll(receive);
+					break;
+				}
+				queue.Wait(cancel);
+			}
+		} };
+
+	vector<thread> producers;
+	for (uint32_t producer = 0; producer < numProducers; ++producer)
+	{
+		producers.emplace_back([&queue, producer, messagesPerProducer]
+			{
+				char text[128];
+				for (uint32_t i = 0; i < messagesPerProducer; ++i)
+				{
+					snprintf(text, sizeof(text), "Info: Graphics - Created texture %u of producer %u (1024x1024, 11 mips)", i, producer);
+					queue.Push(LogMessage{
+						.messageStr		= text,
+						.severity		= Severity::Info,
+						.timestamp		= chrono::system_clock::now() });
+				}
+			});
+	}
+
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	cancel = true;
+	queue.Wake();
+	worker.join();
+
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+	Check(latenciesUs.size() == numMessages, "every message is popped once");
+
+	Result result{ .messagesPerSecond = (double)latenciesUs.size() / seconds };
+	if (!latenciesUs.empty())
+	{
+		sort(latenciesUs.begin(), latenciesUs.end());
+		result.p50Us = latenciesUs[latenciesUs.size() / 2];
+		result.p99Us = latenciesUs[latenciesUs.size() * 99 / 100];
+		result.maxUs = latenciesUs.back();
+	}
+	return result;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t messagesPerProducer = commandLine.Size(200000, 2000);
+	const uint32_t maxProducers = commandLine.GetOption("--threads", max(thread::hardware_concurrency(), 2u));
+
+	printf("Log message queue benchmark, %u hardware threads, %u slots, %u messages per producer\n\n",
+		thread::hardware_concurrency(), (uint32_t)s_capacity, messagesPerProducer);
+	printf("%-10s %16s %14s %14s %14s\n", "Producers", "Messages/s", "p50 latency", "p99 latency", "Max latency");
+
+	for (uint32_t numProducers = 1; numProducers <= maxProducers; numProducers *= 2)
+	{
+		const Result result = Run(numProducers, messagesPerProducer);
+		printf("%-10u %16.0f %12.1fus %12.1fus %12.1fus\n", numProducers, result.messagesPerSecond, result.p50Us,
+			result.p99Us, result.maxUs);
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "LogMessageQueue.h"
+
+#include "Benchmark.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+LogMessage MakeMessage(const string& text)
+{
+	return LogMessage{ .messageStr = text, .severity = Severity::Info };
+}
+
+
+vector<string> PopAllText(LogMessageQueue& queue)
+{
+	vector<string> texts;
+	queue.PopAll([&texts](const LogMessage& message) { texts.push_back(message.messageStr); });
+	return texts;
+}
+
+
+void TestFifo()
+{
+	LogMessageQueue queue{ 8, 64 };
+
+	Check(PopAllText(queue).empty(), "a new queue is empty");
+
+	queue.Push(MakeMessage("a"));
+	queue.Push(MakeMessage("b"));
+	queue.Push(MakeMessage("c"));
+
+	Check(PopAllText(queue) == vector<string>{ "a", "b", "c" }, "messages pop in the order they were pushed");
+	Check(PopAllText(queue).empty(), "popping releases the messages");
+}
+
+
+void TestWraparound()
+{
+	// Fill and drain a small ring many times over, so every slot is reused on many laps
+	LogMessageQueue queue{ 4, 16 };
+
+	uint32_t nextPush = 0;
+	uint32_t nextPop = 0;
+	bool inOrder = true;
+
+	for (uint32_t lap = 0; lap < 50; ++lap)
+	{
+		const uint32_t numToPush = 1 + lap % 4;
+		for (uint32_t i = 0; i < numToPush; ++i)
+		{
+			queue.Push(MakeMessage(to_string(nextPush++)));
+		}
+
+		for (const auto& text : PopAllText(queue))
+		{
+			inOrder = inOrder && text == to_string(nextPop++);
+		}
+	}
+
+	Check(inOrder, "messages stay in order across laps of the ring");
+	Check(nextPop == nextPush, "every message pushed across laps of the ring is popped");
+}
+
+
+void TestLongMessages()
+{
+	// Messages longer than the reserve size still arrive whole
+	LogMessageQueue queue{ 2, 8 };
+
+	const string longText(1000, 'x');
+	queue.Push(MakeMessage(longText));
+	queue.Push(MakeMessage("short"));
+
+	Check(PopAllText(queue) == vector<string>{ longText, "short" }, "long messages are copied whole");
+}
+
+
+void TestWait()
+{
+	LogMessageQueue queue{ 8, 16 };
+	atomic<bool> cancel{ false };
+
+	// A ready message, or cancel, returns straight away
+	queue.Push(MakeMessage("ready"));
+	queue.Wait(cancel);
+	Check(PopAllText(queue).size() == 1, "Wait returns when a message is ready");
+
+	cancel = true;
+	queue.Wait(cancel);
+	cancel = false;
+
+	// A push from another thread wakes the worker
+	thread producer{ [&queue]
+		{
+			this_thread::sleep_for(chrono::milliseconds(10));
+			queue.Push(MakeMessage("late"));
+		} };
+	queue.Wait(cancel);
+	producer.join();
+	Check(PopAllText(queue) == vector<string>{ "late" }, "a push wakes the waiting worker");
+
+	// So does Wake, with nothing in the queue
+	thread waker{ [&queue]
+		{
+			this_thread::sleep_for(chrono::milliseconds(10));
+			queue.Wake();
+		} };
+	queue.Wait(cancel);
+	waker.join();
+	Check(PopAllText(queue).empty(), "Wake returns from Wait without a message");
+}
+
+
+// Several producers push into a ring much smaller than the number of messages, so they spend most of the test
+// blocked on a full ring.  The worker must see every message exactly once, and each producer's messages in the
+// order that producer pushed them.
+void TestManyProducers(uint32_t numProducers, uint32_t messagesPerProducer, size_t capacity)
+{
+	LogMessageQueue queue{ capacity, 32 };
+	atomic<bool> cancel{ false };
+
+	vector<uint32_t> nextIndex(numProducers, 0);
+	uint32_t numReceived = 0;
+	uint32_t numOutOfOrder = 0;
+	uint32_t numMalformed = 0;
+
+	thread worker{ [&]
+		{
+			auto receive = [&](const LogMessage& message)
+				{
+					uint32_t producer = 0;
+					uint32_t index = 0;
+					if (sscanf(message.messageStr.c_str(), "%u:%u", &producer, &index) != 2 || producer >= numProducers)
+					{
+						++numMalformed;
+						return;
+					}
+
+					if (index != nextIndex[producer])
+					{
+						++numOutOfOrder;
+					}
+					nextIndex[producer] = index + 1;
+					++numReceived;
+				};
+
+			// The worker's loop in LogSystem: drain, then sleep until there is more
+			for (;;)
+			{
+				queue.PopAll(receive);
+				if (cancel.load())
+				{
+					queue.PopAll(receive);
+					break;
+				}
+				queue.Wait(cancel);
+			}
+		} };
+
+	vector<thread> producers;
+	for (uint32_t producer = 0; producer < numProducers; ++producer)
+	{
+		producers.emplace_back([&queue, producer, messagesPerProducer]
+			{
+				for (uint32_t i = 0; i < messagesPerProducer; ++i)
+				{
+					queue.Push(MakeMessage(to_string(producer) + ":" + to_string(i)));
+				}
+			});
+	}
+
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	cancel = true;
+	queue.Wake();
+	worker.join();
+
+	Check(numMalformed == 0, "every message arrives intact");
+	Check(numReceived == numProducers * messagesPerProducer, "every message from every producer arrives exactly once");
+	Check(numOutOfOrder == 0, "each producer's messages arrive in the order it pushed them");
+
+	bool allComplete = true;
+	for (uint32_t producer = 0; producer < numProducers; ++producer)
+	{
+		allComplete = allComplete && nextIndex[producer] == messagesPerProducer;
+	}
+	Check(allComplete, "the last message from each producer arrives");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	TestFifo();
+	TestWraparound();
+	TestLongMessages();
+	TestWait();
+
+	TestManyProducers(1, 20000, 16);
+	TestManyProducers(4, 20000, 16);
+	TestManyProducers(8, 5000, 2);
+	TestManyProducers(4, 20000, 1024);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "MappedFile.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+const filesystem::path s_rootPath = filesystem::temp_directory_path() / "LunaMappedFileBenchmark";
+
+
+// Resident memory in bytes, split into what the process allocated and what it has mapped from files.  Clean file
+// pages can be dropped under memory pressure and read again, so only the anonymous part is a real cost.
+struct ResidentMemory
+{
+	uint64_t anonymous{ 0 };
+	uint64_t fileBacked{ 0 };
+};
+
+
+ResidentMemory GetResidentMemory()
+{
+	ResidentMemory memory;
+
+	ifstream status("/proc/self/status");
+	string line;
+	while (getline(status, line))
+	{
+		if (line.starts_with("RssAnon:"))
+		{
+			memory.anonymous = stoull(line.substr(8)) * 1024;
+		}
+		else if (line.starts_with("RssFile:"))
+		{
+			memory.fileBacked = stoull(line.substr(8)) * 1024;
+		}
+	}
+	return memory;
+}
+
+
+// The highest resident memory seen, above what was resident when it was created
+struct PeakMemory
+{
+	ResidentMemory baseline{ GetResidentMemory() };
+	ResidentMemory peak;
+
+	void Sample()
+	{
+		const ResidentMemory current = GetResidentMemory();
+		peak.anonymous = max(peak.anonymous, current.anonymous - min(current.anonymous, baseline.anonymous));
+		peak.fileBacked = max(peak.fileBacked, current.fileBacked - min(current.fileBacked, baseline.fileBacked));
+	}
+};
+
+
+// A texture set of equal sized files of noise, standing in for the texel data of DDS files
+vector<string> WriteTextureSet(uint32_t numFiles, size_t fileSize)
+{
+	mt19937_64 rng{ 1234 };
+
+	filesystem::create_directories(s_rootPath);
+
+	vector<string> fileNames;
+	vector<uint64_t> data(fileSize / sizeof(uint64_t));
+	for (uint32_t i = 0; i < numFiles; ++i)
+	{
+		for (auto& value : data)
+		{
+			value = rng();
+		}
+
+		fileNames.push_back((s_rootPath / ("Texture" + to_string(i) + ".dds")).string());
+		ofstream(fileNames.back(), ios::out | ios::binary).write((const char*)data.data(), (streamsize)(data.size() * sizeof(uint64_t)));
+	}
+	return fileNames;
+}
+
+
+// Reads every 64th byte, as creating the texture and uploading it touches every page
+uint64_t Checksum(span<const std::byte> data)
+{
+	uint64_t sum = data.size();
+	for (size_t i = 0; i < data.size(); i += 64)
+	{
+		sum += (uint8_t)data[i];
+	}
+	return sum;
+}
+
+
+// Before:  ReadEntireFile() copied the file into the heap, and retaining the data copied it again with SetData(),
+// so each texture peaked at twice its size and kept one copy
+uint64_t LoadByReading(const vector<string>& fileNames, vector<vector<std::byte>>& outRetained, PeakMemory& peakMemory)
+{
+	uint64_t checksum{ 0 };
+	for (const auto& fileName : fileNames)
+	{
+		ifstream file(fileName, ios::in | ios::binary | ios::ate);
+		vector<std::byte> fileData((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)fileData.data(), (streamsize)fileData.size());
+
+		checksum += Checksum(fileData);
+		outRetained.emplace_back(fileData.begin(), fileData.end());
+
+		peakMemory.Sample();
+	}
+	return checksum;
+}
+
+
+// After:  the subresources point into the mapping, and the texture retains the mapping itself
+uint64_t LoadByMapping(const vector<string>& fileNames, vector<shared_ptr<const MappedFile>>& outRetained, PeakMemory& peakMemory)
+{
+	uint64_t checksum{ 0 };
+	for (const auto& fileName : fileNames)
+	{
+		auto file = make_shared<const MappedFile>(fileName);
+		checksum += Checksum(file->GetSpan());
+		outRetained.push_back(move(file));
+
+		peakMemory.Sample();
+	}
+	return checksum;
+}
+
+
+// Without retained data, a large file is read through one window at a time, so only a window's worth of it is
+// mapped at once
+uint64_t LoadByWindows(const vector<string>& fileNames, size_t windowSize, PeakMemory& peakMemory)
+{
+	uint64_t checksum{ 0 };
+	for (const auto& fileName : fileNames)
+	{
+		uint64_t offset{ 0 };
+		MappedFile window;
+		while (window.Open(fileName, offset, windowSize))
+		{
+			checksum += Checksum(window.GetSpan());
+			offset += window.GetSize();
+
+			peakMemory.Sample();
+		}
+		checksum += offset;
+	}
+	return checksum;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t setMB = commandLine.GetOption("--mb", commandLine.Size(2048, 16));
+	const uint32_t numFiles = commandLine.GetOption("--files", commandLine.Size(32, 4));
+	const uint32_t windowMB = commandLine.GetOption("--window", commandLine.Size(16, 1));
+	const uint32_t numRuns = commandLine.Size(3, 1);
+
+	const size_t fileSize = ((size_t)setMB << 20) / max(numFiles, 1u);
+	const size_t windowSize = (size_t)windowMB << 20;
+
+	filesystem::remove_all(s_rootPath);
+	const auto fileNames = WriteTextureSet(numFiles, fileSize);
+
+	// Each run starts with nothing retained, and the memory of the last run is reported.  The files were just
+	// written, so they come from the page cache on every path, and the times compare the copies rather than the disk.
+	uint64_t readChecksum{ 0 };
+	uint64_t mappedChecksum{ 0 };
+	uint64_t windowedChecksum{ 0 };
+	PeakMemory readMemory;
+	PeakMemory mappedMemory;
+	PeakMemory windowedMemory;
+
+	const double readMs = MeasureMs(numRuns, [&]
+		{
+			vector<vector<std::byte>> retained;
+			readMemory = PeakMemory{};
+			readChecksum = LoadByReading(fileNames, retained, readMemory);
+		});
+
+	const double mappedMs = MeasureMs(numRuns, [&]
+		{
+			vector<shared_ptr<const MappedFile>> retained;
+			mappedMemory = PeakMemory{};
+			mappedChecksum = LoadByMapping(fileNames, retained, mappedMemory);
+		});
+
+	const double windowedMs = MeasureMs(numRuns, [&]
+		{
+			windowedMemory = PeakMemory{};
+			windowedChecksum = LoadByWindows(fileNames, windowSize, windowedMemory) - (uint64_t)numFiles * fileSize;
+		});
+
+	Check(readChecksum != 0 && mappedChecksum == readChecksum, "mapping reads the same data as copying");
+	Check(windowedChecksum == readChecksum, "windows read the same data as mapping the whole file");
+	Check(mappedMemory.peak.anonymous < readMemory.peak.anonymous / 2, "mapping allocates less than half of what copying did");
+
+	auto printRow = [numFiles](const char* name, double ms, const PeakMemory& memory)
+		{
+			printf("%-30s %10.1f ms %10.2f ms/file %12.1f MB %12.1f MB\n", name, ms, ms / numFiles,
+				memory.peak.anonymous / 1048576.0, memory.peak.fileBacked / 1048576.0);
+		};
+
+	printf("Mapped file benchmark, %u textures of %.1f MB, %u MB in all, fastest of %u runs\n\n", numFiles, fileSize / 1048576.0,
+		setMB, numRuns);
+	printf("%-30s %13s %18s %15s %15s\n", "Path", "Load", "Per file", "Peak heap", "Peak mapped");
+	printRow("Read and retain a copy", readMs, readMemory);
+	printRow("Map and retain the mapping", mappedMs, mappedMemory);
+	printf("%-30s %10.1f ms %10.2f ms/file %12.1f MB %12.1f MB   %u MB windows\n", "Map in windows, no retain", windowedMs,
+		windowedMs / numFiles, windowedMemory.peak.anonymous / 1048576.0, windowedMemory.peak.fileBacked / 1048576.0, windowMB);
+
+	filesystem::remove_all(s_rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FileSystem.h"
+#include "MappedFile.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+#include <unistd.h>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+const filesystem::path s_rootPath = filesystem::temp_directory_path() / "LunaMappedFileTests";
+const size_t s_pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+
+vector<std::byte> MakeData(size_t size, mt19937& rng)
+{
+	vector<std::byte> data(size);
+	for (auto& value : data)
+	{
+		value = (std::byte)rng();
+	}
+	return data;
+}
+
+
+void WriteFile(const filesystem::path& filePath, const vector<std::byte>& data)
+{
+	ofstream(filePath, ios::out | ios::binary).write((const char*)data.data(), (streamsize)data.size());
+}
+
+
+// The mapping shows exactly the bytes of the file from offset on, and reports where it is
+bool Matches(const MappedFile& file, const vector<std::byte>& data, uint64_t offset, size_t size)
+{
+	return file.IsOpen() && file.GetOffset() == offset && file.GetFileSize() == data.size() && file.GetSize() == size &&
+		file.GetSpan().size() == size && equal(file.GetData(), file.GetData() + size, data.begin() + (ptrdiff_t)offset);
+}
+
+
+void TestWholeFile(mt19937& rng)
+{
+	const auto fileName = (s_rootPath / "Whole.bin").string();
+	const auto data = MakeData(3 * s_pageSize + 123, rng);
+	WriteFile(fileName, data);
+
+	MappedFile file{ fileName };
+	Check(Matches(file, data, 0, data.size()), "the whole file maps");
+
+	file.Close();
+	Check(!file.IsOpen() && file.GetData() == nullptr && file.GetSize() == 0 && file.GetFileSize() == 0, "Close() resets the file");
+}
+
+
+// Views have to start on the allocation granularity, so windows that don't are mapped from the boundary before them,
+// and the data pointer skips the difference
+void TestUnalignedWindows(mt19937& rng)
+{
+	const auto fileName = (s_rootPath / "Windows.bin").string();
+	const auto data = MakeData(4 * s_pageSize + 321, rng);
+	WriteFile(fileName, data);
+
+	const uint64_t offsets[]{ 0, 1, 7, s_pageSize - 1, s_pageSize, s_pageSize + 1, 2 * s_pageSize + 5, 4 * s_pageSize, data.size() - 1 };
+	const size_t sizes[]{ 1, 100, s_pageSize - 3, s_pageSize, 2 * s_pageSize + 1 };
+
+	bool everyWindowMatches = true;
+	bool everyRemainderMatches = true;
+	for (uint64_t offset : offsets)
+	{
+		const size_t available = data.size() - (size_t)offset;
+		for (size_t size : sizes)
+		{
+			MappedFile window;
+			const bool opened = window.Open(fileName, offset, size);
+			everyWindowMatches = everyWindowMatches && opened && Matches(window, data, offset, min(size, available));
+		}
+
+		MappedFile remainder;
+		const bool opened = remainder.Open(fileName, offset, 0);
+		everyRemainderMatches = everyRemainderMatches && opened && Matches(remainder, data, offset, available);
+	}
+	Check(everyWindowMatches, "windows at any offset map the right bytes, clamped to the end of the file");
+	Check(everyRemainderMatches, "a size of 0 maps everything after the offset");
+
+	MappedFile file;
+	Check(!file.Open(fileName, data.size(), 0), "a window starting at the end of the file fails");
+	Check(!file.Open(fileName, data.size() + s_pageSize + 1, 16), "a window past the end of the file fails");
+	Check(!file.IsOpen(), "a failed Open() leaves the file closed");
+
+	Check(file.Open(fileName, 5, 10), "a window opens");
+	Check(!file.Open(fileName, data.size() + 1, 10) && !file.IsOpen(), "a failed Open() closes the window that was open");
+}
+
+
+void TestMissingAndEmpty()
+{
+	const auto emptyName = (s_rootPath / "Empty.bin").string();
+	WriteFile(emptyName, {});
+
+	MappedFile file;
+	Check(!file.Open((s_rootPath / "Missing.bin").string()), "a missing file fails");
+	Check(!file.Open(emptyName), "an empty file fails, since there is nothing to map");
+	Check(!file.IsOpen(), "and the file stays closed");
+}
+
+
+// A mapping keeps the file it was made from, whatever happens to the name.  The model and texture caches replace
+// their files with WriteFileAtomic(), and a tool may delete or rename assets, while an older mapping is in use.
+void TestDeleteAndRenameWhileMapped(mt19937& rng)
+{
+	const auto fileName = (s_rootPath / "Live.bin").string();
+	const auto renamedName = (s_rootPath / "Renamed.bin").string();
+	const auto data = MakeData(2 * s_pageSize + 77, rng);
+	const auto newData = MakeData(s_pageSize + 9, rng);
+
+	{
+		WriteFile(fileName, data);
+		MappedFile whole{ fileName };
+		MappedFile window;
+		Check(window.Open(fileName, s_pageSize + 3, 40), "the window opens before the delete");
+
+		error_code ec;
+		Check(filesystem::remove(fileName, ec), "a mapped file can be deleted");
+		Check(Matches(whole, data, 0, data.size()) && Matches(window, data, s_pageSize + 3, 40), "the mappings still read the deleted file");
+
+		WriteFile(fileName, newData);
+		Check(Matches(whole, data, 0, data.size()), "a new file with the same name doesn't show through");
+		Check(Matches(MappedFile{ fileName }, newData, 0, newData.size()), "opening the name again maps the new file");
+	}
+
+	{
+		WriteFile(fileName, data);
+		MappedFile whole{ fileName };
+
+		error_code ec;
+		filesystem::rename(fileName, renamedName, ec);
+		Check(!ec, "a mapped file can be renamed");
+		Check(Matches(whole, data, 0, data.size()), "the mapping still reads the renamed file");
+		Check(!MappedFile{ fileName }.IsOpen(), "the old name no longer opens");
+		Check(Matches(MappedFile{ renamedName }, data, 0, data.size()), "the new name opens the same data");
+	}
+
+	{
+		WriteFile(fileName, data);
+		MappedFile whole{ fileName };
+
+		Check(FileSystem::WriteFileAtomic(fileName, newData), "a mapped file can be replaced");
+		Check(Matches(whole, data, 0, data.size()), "the mapping still reads the file it replaced");
+		Check(Matches(MappedFile{ fileName }, newData, 0, newData.size()), "opening the name again maps the replacement");
+	}
+}
+
+
+void TestMove(mt19937& rng)
+{
+	const auto fileName = (s_rootPath / "Move.bin").string();
+	const auto data = MakeData(s_pageSize + 50, rng);
+	WriteFile(fileName, data);
+
+	MappedFile first;
+	Check(first.Open(fileName, 17, 200), "the window opens");
+
+	MappedFile second{ move(first) };
+	Check(!first.IsOpen() && Matches(second, data, 17, 200), "moving hands over the window");
+
+	MappedFile third{ fileName };
+	third = move(second);
+	Check(!second.IsOpen() && Matches(third, data, 17, 200), "move assignment closes the old mapping and takes the window");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	filesystem::remove_all(s_rootPath);
+	filesystem::create_directories(s_rootPath);
+
+	mt19937 rng{ 1234 };
+
+	TestWholeFile(rng);
+	TestUnalignedWindows(rng);
+	TestMissingAndEmpty();
+	TestDeleteAndRenameWhileMapped(rng);
+	TestMove(rng);
+
+	filesystem::remove_all(s_rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/MeshOptimizer.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Positions are three floats per vertex
+struct TestMesh
+{
+	const char* name{ nullptr };
+	vector<float> positions;
+	vector<uint32_t> indices;
+};
+
+
+void AppendGrid(uint32_t size, TestMesh& mesh)
+{
+	const uint32_t baseVertex = (uint32_t)(mesh.positions.size() / 3);
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			mesh.positions.insert(mesh.positions.end(), { (float)x, (float)y, 0.0f });
+		}
+	}
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			const uint32_t v0 = baseVertex + y * (size + 1) + x;
+			const uint32_t v1 = v0 + 1;
+			const uint32_t v2 = v0 + size + 1;
+			const uint32_t v3 = v2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+}
+
+
+void AppendSphere(float radius, uint32_t numRings, uint32_t numSegments, TestMesh& mesh)
+{
+	const uint32_t baseVertex = (uint32_t)(mesh.positions.size() / 3);
+	for (uint32_t ring = 0; ring <= numRings; ++ring)
+	{
+		const float theta = 3.14159265f * (float)ring / (float)numRings;
+		for (uint32_t segment = 0; segment <= numSegments; ++segment)
+		{
+			const float phi = 2.0f * 3.14159265f * (float)segment / (float)numSegments;
+			mesh.positions.insert(mesh.positions.end(), { radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi) });
+		}
+	}
+
+	for (uint32_t ring = 0; ring < numRings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < numSegments; ++segment)
+		{
+			const uint32_t v0 = baseVertex + ring * (numSegments + 1) + segment;
+			const uint32_t v1 = v0 + 1;
+			const uint32_t v2 = v0 + numSegments + 1;
+			const uint32_t v3 = v2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+}
+
+
+void ShuffleTriangles(vector<uint32_t>& indices, mt19937& rng)
+{
+	const size_t numTriangles = indices.size() / 3;
+	for (size_t i = numTriangles - 1; i > 0; --i)
+	{
+		const size_t j = uniform_int_distribution<size_t>{ 0, i }(rng);
+		swap_ranges(indices.begin() + i * 3, indices.begin() + i * 3 + 3, indices.begin() + j * 3);
+	}
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t gridSize = commandLine.Size(512, 64);
+	const uint32_t numRings = commandLine.Size(256, 32);
+	const uint32_t numRuns = commandLine.Size(5, 1);
+
+	mt19937 rng{ 1234 };
+
+	// A mesh in authoring order, one with its triangles shuffled, and a sphere inside another, which from
+	// outside is drawn twice unless the outer one goes first
+	vector<TestMesh> meshes(4);
+
+	meshes[0].name = "Grid";
+	AppendGrid(gridSize, meshes[0]);
+
+	meshes[1].name = "Shuffled grid";
+	AppendGrid(gridSize, meshes[1]);
+	ShuffleTriangles(meshes[1].indices, rng);
+
+	meshes[2].name = "Sphere";
+	AppendSphere(10.0f, numRings, numRings * 2, meshes[2]);
+
+	meshes[3].name = "Nested spheres";
+	AppendSphere(5.0f, numRings / 2, numRings, meshes[3]);
+	AppendSphere(10.0f, numRings / 2, numRings, meshes[3]);
+	ShuffleTriangles(meshes[3].indices, rng);
+
+	printf("Mesh optimizer benchmark, %u entry FIFO, overdraw from 6 axis views, fastest of %u runs\n\n", MeshOptimizeDesc{}.analyzeCacheSize, numRuns);
+	printf("%-16s %9s %15s %15s %15s %12s\n", "Mesh", "Triangles", "ACMR", "ATVR", "Overdraw", "Optimize");
+
+	for (const TestMesh& mesh : meshes)
+	{
+		vector<uint32_t> indices;
+		vector<float> vertices;
+		vector<float> positionsOnly;
+		MeshOptimizeStats stats;
+
+		const double optimizeMs = MeasureMs(numRuns, [&]
+			{
+				indices = mesh.indices;
+				vertices = mesh.positions;
+				positionsOnly = mesh.positions;
+				stats = MeshOptimizeStats{};
+				OptimizeMesh(indices, vertices, 3, positionsOnly, MeshOptimizeDesc{}, &stats);
+			});
+
+		printf("%-16s %9zu %6.3f -> %5.3f %6.3f -> %5.3f %6.3f -> %5.3f %9.2f ms\n", mesh.name, mesh.indices.size() / 3,
+			stats.vertexCacheBefore.GetACMR(), stats.vertexCacheAfter.GetACMR(),
+			stats.vertexCacheBefore.GetATVR(), stats.vertexCacheAfter.GetATVR(),
+			stats.overdrawBefore.GetOverdraw(), stats.overdrawAfter.GetOverdraw(), optimizeMs);
+
+		// The overdraw pass may give back a little of the cache order, up to its threshold
+		Check(stats.vertexCacheAfter.GetACMR() <= stats.vertexCacheBefore.GetACMR() * MeshOptimizeDesc{}.overdrawThreshold,
+			"optimizing never makes the vertex cache much worse");
+		Check(stats.overdrawAfter.GetOverdraw() <= stats.overdrawBefore.GetOverdraw() * 1.01f, "optimizing never makes overdraw worse");
+		KeepResult(indices.data());
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
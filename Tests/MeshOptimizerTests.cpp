@@ -0,0 +1,388 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/MeshOptimizer.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Positions are three floats per vertex
+struct TestMesh
+{
+	vector<float> positions;
+	vector<uint32_t> indices;
+
+	uint32_t GetNumVertices() const { return (uint32_t)(positions.size() / 3); }
+};
+
+
+// A flat grid of quads, so every interior vertex is shared by six triangles
+TestMesh MakeGrid(uint32_t size)
+{
+	TestMesh mesh;
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			mesh.positions.insert(mesh.positions.end(), { (float)x, (float)y, 0.0f });
+		}
+	}
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			const uint32_t v0 = y * (size + 1) + x;
+			const uint32_t v1 = v0 + 1;
+			const uint32_t v2 = v0 + size + 1;
+			const uint32_t v3 = v2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+	return mesh;
+}
+
+
+// Closed, outward facing latitude/longitude sphere, appended to the mesh
+void AppendSphere(float radius, uint32_t numRings, uint32_t numSegments, TestMesh& mesh)
+{
+	const uint32_t baseVertex = mesh.GetNumVertices();
+	for (uint32_t ring = 0; ring <= numRings; ++ring)
+	{
+		const float theta = 3.14159265f * (float)ring / (float)numRings;
+		for (uint32_t segment = 0; segment <= numSegments; ++segment)
+		{
+			const float phi = 2.0f * 3.14159265f * (float)segment / (float)numSegments;
+			mesh.positions.insert(mesh.positions.end(), { radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi) });
+		}
+	}
+
+	for (uint32_t ring = 0; ring < numRings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < numSegments; ++segment)
+		{
+			const uint32_t v0 = baseVertex + ring * (numSegments + 1) + segment;
+			const uint32_t v1 = v0 + 1;
+			const uint32_t v2 = v0 + numSegments + 1;
+			const uint32_t v3 = v2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+}
+
+
+// Worst case for the vertex cache, the triangles in random order
+void ShuffleTriangles(vector<uint32_t>& indices, mt19937& rng)
+{
+	const size_t numTriangles = indices.size() / 3;
+	for (size_t i = numTriangles - 1; i > 0; --i)
+	{
+		const size_t j = uniform_int_distribution<size_t>{ 0, i }(rng);
+		swap_ranges(indices.begin() + i * 3, indices.begin() + i * 3 + 3, indices.begin() + j * 3);
+	}
+}
+
+
+// The triangles as a sorted list, each rotated to start at its smallest vertex, so that reordering triangles
+// compares equal but changing a winding does not
+vector<array<uint32_t, 3>> GetTriangleSet(span<const uint32_t> indices)
+{
+	vector<array<uint32_t, 3>> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		array<uint32_t, 3> triangle{ indices[i], indices[i + 1], indices[i + 2] };
+		while (triangle[0] > triangle[1] || triangle[0] > triangle[2])
+		{
+			rotate(triangle.begin(), triangle.begin() + 1, triangle.end());
+		}
+		triangles.push_back(triangle);
+	}
+	sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+
+// The same, by vertex position, to compare meshes whose vertices were renumbered
+vector<array<float, 9>> GetTrianglePositionSet(span<const uint32_t> indices, span<const float> positions)
+{
+	vector<array<float, 9>> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		array<array<float, 3>, 3> corners;
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			const float* p = positions.data() + (size_t)indices[i + j] * 3;
+			corners[j] = { p[0], p[1], p[2] };
+		}
+		while (corners[0] > corners[1] || corners[0] > corners[2])
+		{
+			rotate(corners.begin(), corners.begin() + 1, corners.end());
+		}
+
+		array<float, 9> triangle;
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			copy(corners[j].begin(), corners[j].end(), triangle.begin() + j * 3);
+		}
+		triangles.push_back(triangle);
+	}
+	sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+
+void TestAnalyzeVertexCache()
+{
+	// One triangle transforms each of its vertices once
+	const vector<uint32_t> triangle{ 0, 1, 2 };
+	const VertexCacheStats single = AnalyzeVertexCache(triangle, 3);
+	Check(single.numTriangles == 1 && single.numVertices == 3 && single.numTransformed == 3, "one triangle transforms three vertices");
+	Check(single.GetACMR() == 3.0f && single.GetATVR() == 1.0f, "one triangle has an ACMR of 3 and an ATVR of 1");
+
+	// A second triangle sharing an edge only transforms its new vertex
+	const vector<uint32_t> quad{ 0, 1, 2, 2, 1, 3 };
+	const VertexCacheStats shared = AnalyzeVertexCache(quad, 4);
+	Check(shared.numTransformed == 4 && shared.GetACMR() == 2.0f, "a shared edge stays in the cache");
+
+	// Unreferenced vertices are not counted, and a vertex evicted from a small cache is transformed again
+	const vector<uint32_t> evicted{ 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+	Check(AnalyzeVertexCache(evicted, 10, 4).numTransformed == 9 && AnalyzeVertexCache(evicted, 10, 4).numVertices == 6,
+		"a four entry cache has evicted the first triangle after two more");
+	Check(AnalyzeVertexCache(evicted, 10, 8).numTransformed == 6, "an eight entry cache still holds the first triangle after two more");
+
+	// A full cache still holds its oldest entry
+	const vector<uint32_t> full{ 0, 1, 2, 3, 0, 1 };
+	Check(AnalyzeVertexCache(full, 4, 4).numTransformed == 4, "a four entry cache holds four vertices");
+	Check(AnalyzeVertexCache(full, 4, 3).numTransformed == 6, "a three entry cache has evicted the oldest vertex");
+
+	VertexCacheStats sum = single;
+	sum += shared;
+	Check(sum.numTriangles == 3 && sum.numVertices == 7 && sum.numTransformed == 7, "stats add up across meshes");
+}
+
+
+void TestOptimizeVertexCache(mt19937& rng)
+{
+	for (uint32_t size : { 8u, 64u })
+	{
+		TestMesh mesh = MakeGrid(size);
+		ShuffleTriangles(mesh.indices, rng);
+
+		const auto trianglesBefore = GetTriangleSet(mesh.indices);
+		const float acmrBefore = AnalyzeVertexCache(mesh.indices, mesh.GetNumVertices()).GetACMR();
+
+		OptimizeVertexCache(mesh.indices, mesh.GetNumVertices());
+		const float acmrAfter = AnalyzeVertexCache(mesh.indices, mesh.GetNumVertices()).GetACMR();
+
+		Check(GetTriangleSet(mesh.indices) == trianglesBefore, "the vertex cache order keeps every triangle and its winding");
+		Check(acmrAfter < acmrBefore * 0.5f, "the vertex cache order at least halves the ACMR of shuffled triangles");
+
+		// A grid has one vertex per two triangles, so an ACMR near 0.5 is the best possible.  Forsyth reaches
+		// about 0.7 on large grids with a 16 entry FIFO.
+		if (size >= 64)
+		{
+			Check(acmrAfter < 0.8f, "the vertex cache order of a large grid comes close to the best ACMR");
+		}
+	}
+
+	// Too little to reorder
+	vector<uint32_t> single{ 2, 0, 1 };
+	OptimizeVertexCache(single, 3);
+	Check((single == vector<uint32_t>{ 2, 0, 1 }), "a single triangle is left alone");
+}
+
+
+void TestAnalyzeOverdraw()
+{
+	// Two squares, one behind the other along z.  Whichever order they are drawn in, the covered area is the
+	// same, but drawing the far one first shades the near one's pixels twice in the views along z.
+	TestMesh mesh;
+	mesh.positions = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1 };
+	const vector<uint32_t> nearQuad{ 4, 5, 6, 6, 5, 7 };
+	const vector<uint32_t> farQuad{ 0, 1, 2, 2, 1, 3 };
+
+	// The viewer along -z looks from +z, so with this winding the z = 1 square is in front
+	vector<uint32_t> nearFirst = nearQuad;
+	nearFirst.insert(nearFirst.end(), farQuad.begin(), farQuad.end());
+	vector<uint32_t> farFirst = farQuad;
+	farFirst.insert(farFirst.end(), nearQuad.begin(), nearQuad.end());
+
+	const OverdrawStats nearFirstStats = AnalyzeOverdraw(nearFirst, mesh.positions, 3);
+	const OverdrawStats farFirstStats = AnalyzeOverdraw(farFirst, mesh.positions, 3);
+
+	Check(nearFirstStats.numPixelsCovered > 0 && nearFirstStats.numPixelsCovered == farFirstStats.numPixelsCovered,
+		"the order of the triangles does not change the area they cover");
+	Check(nearFirstStats.GetOverdraw() == 1.0f, "drawing the near square first shades each pixel once");
+	Check(farFirstStats.GetOverdraw() > 1.5f, "drawing the far square first shades the near square's pixels twice");
+
+	// Extra floats per vertex are skipped
+	vector<float> widePositions;
+	for (size_t i = 0; i < mesh.positions.size(); i += 3)
+	{
+		widePositions.insert(widePositions.end(), { mesh.positions[i], mesh.positions[i + 1], mesh.positions[i + 2], 9.0f, 9.0f });
+	}
+	Check(AnalyzeOverdraw(farFirst, widePositions, 5).numPixelsShaded == farFirstStats.numPixelsShaded, "positions are read at the vertex stride");
+
+	Check(AnalyzeOverdraw({}, mesh.positions, 3).numPixelsCovered == 0, "an empty mesh covers nothing");
+}
+
+
+void TestOptimizeOverdraw()
+{
+	// A sphere inside another, with the inner one first, so from outside everything is drawn twice
+	TestMesh mesh;
+	AppendSphere(5.0f, 24, 48, mesh);
+	AppendSphere(10.0f, 24, 48, mesh);
+
+	OptimizeVertexCache(mesh.indices, mesh.GetNumVertices());
+	const auto trianglesBefore = GetTriangleSet(mesh.indices);
+	const float acmrBefore = AnalyzeVertexCache(mesh.indices, mesh.GetNumVertices()).GetACMR();
+	const float overdrawBefore = AnalyzeOverdraw(mesh.indices, mesh.positions, 3).GetOverdraw();
+
+	const float threshold = 1.05f;
+	OptimizeOverdraw(mesh.indices, mesh.positions, 3, threshold);
+	const float acmrAfter = AnalyzeVertexCache(mesh.indices, mesh.GetNumVertices()).GetACMR();
+	const float overdrawAfter = AnalyzeOverdraw(mesh.indices, mesh.positions, 3).GetOverdraw();
+
+	Check(GetTriangleSet(mesh.indices) == trianglesBefore, "the overdraw order keeps every triangle and its winding");
+	Check(overdrawAfter < overdrawBefore * 0.8f, "the overdraw order draws the outer sphere first");
+
+	// Clusters are cut where the cache is flushed, which costs a little on top of the threshold
+	Check(acmrAfter <= acmrBefore * threshold * 1.1f, "the overdraw order stays near the vertex cache order's ACMR");
+}
+
+
+void TestOptimizeVertexFetch()
+{
+	// Vertices 0 and 5 are unused, and the rest are used back to front
+	vector<uint32_t> indices{ 4, 3, 2, 2, 3, 1 };
+	vector<uint32_t> remap;
+	const uint32_t newNumVertices = OptimizeVertexFetchRemap(indices, 6, remap);
+
+	Check(newNumVertices == 4, "unreferenced vertices are dropped");
+	Check((indices == vector<uint32_t>{ 0, 1, 2, 2, 1, 3 }), "vertices are renumbered in the order they are first used");
+	Check((remap == vector<uint32_t>{ ~0u, 3, 2, 1, 0, ~0u }), "the remap maps old vertices to new ones");
+
+	// Two floats per vertex, the vertex's old number and a marker
+	vector<float> vertices;
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		vertices.insert(vertices.end(), { (float)i, 100.0f + (float)i });
+	}
+	RemapVertices(vertices, 2, remap, newNumVertices);
+	Check((vertices == vector<float>{ 4, 104, 3, 103, 2, 102, 1, 101 }), "vertex data follows the remap");
+}
+
+
+void TestOptimizeMesh(mt19937& rng)
+{
+	TestMesh mesh;
+	AppendSphere(5.0f, 16, 32, mesh);
+	AppendSphere(10.0f, 16, 32, mesh);
+	ShuffleTriangles(mesh.indices, rng);
+
+	// An unreferenced vertex, to be dropped
+	mesh.positions.insert(mesh.positions.end(), { 99.0f, 99.0f, 99.0f });
+
+	// The vertex stream holds the position and then the vertex number, so the remap can be traced
+	const uint32_t vertexStride = 4;
+	vector<float> vertices;
+	for (uint32_t i = 0; i < mesh.GetNumVertices(); ++i)
+	{
+		vertices.insert(vertices.end(), { mesh.positions[i * 3], mesh.positions[i * 3 + 1], mesh.positions[i * 3 + 2], (float)i });
+	}
+
+	const auto trianglesBefore = GetTrianglePositionSet(mesh.indices, mesh.positions);
+
+	vector<uint32_t> indices = mesh.indices;
+	vector<float> positionsOnly = mesh.positions;
+	MeshOptimizeStats stats;
+	OptimizeMesh(indices, vertices, vertexStride, positionsOnly, MeshOptimizeDesc{}, &stats);
+
+	const uint32_t newNumVertices = (uint32_t)(positionsOnly.size() / 3);
+	Check(newNumVertices == mesh.GetNumVertices() - 1 && vertices.size() == (size_t)newNumVertices * vertexStride,
+		"both streams lose the unreferenced vertex");
+	Check(GetTrianglePositionSet(indices, positionsOnly) == trianglesBefore, "the optimized mesh draws the same triangles");
+
+	bool streamsMatch = true;
+	for (uint32_t i = 0; i < newNumVertices; ++i)
+	{
+		const uint32_t oldVertex = (uint32_t)vertices[i * vertexStride + 3];
+		streamsMatch = streamsMatch && memcmp(&vertices[i * vertexStride], &mesh.positions[oldVertex * 3], 3 * sizeof(float)) == 0 &&
+			memcmp(&positionsOnly[i * 3], &mesh.positions[oldVertex * 3], 3 * sizeof(float)) == 0;
+	}
+	Check(streamsMatch, "both streams are remapped the same way");
+
+	uint32_t maxIndex = 0;
+	bool firstUseOrder = true;
+	for (uint32_t index : indices)
+	{
+		firstUseOrder = firstUseOrder && index <= maxIndex + 1;
+		maxIndex = max(maxIndex, index);
+	}
+	Check(firstUseOrder, "the optimized vertices are in first use order");
+
+	Check(stats.vertexCacheBefore.numTriangles == indices.size() / 3 && stats.vertexCacheAfter.numTriangles == indices.size() / 3, "stats cover every triangle");
+	Check(stats.vertexCacheAfter.GetACMR() < stats.vertexCacheBefore.GetACMR() * 0.5f, "the optimized mesh at least halves the ACMR");
+	Check(stats.overdrawAfter.GetOverdraw() < stats.overdrawBefore.GetOverdraw(), "the optimized mesh has less overdraw");
+
+	// The same input gives the same output, so meshes can be optimized in parallel and cached
+	vector<uint32_t> indicesAgain = mesh.indices;
+	vector<float> verticesAgain;
+	for (uint32_t i = 0; i < mesh.GetNumVertices(); ++i)
+	{
+		verticesAgain.insert(verticesAgain.end(), { mesh.positions[i * 3], mesh.positions[i * 3 + 1], mesh.positions[i * 3 + 2], (float)i });
+	}
+	vector<float> positionsOnlyAgain = mesh.positions;
+	OptimizeMesh(indicesAgain, verticesAgain, vertexStride, positionsOnlyAgain, MeshOptimizeDesc{});
+	Check(indicesAgain == indices && verticesAgain == vertices, "optimization is deterministic");
+
+	// Without a position stream, the overdraw step is skipped
+	vector<uint32_t> indicesNoPositions = mesh.indices;
+	vector<float> verticesNoPositions = verticesAgain;
+	vector<float> noPositions;
+	verticesNoPositions.assign(vertices.size() + vertexStride, 0.0f);
+	for (uint32_t i = 0; i < mesh.GetNumVertices(); ++i)
+	{
+		memcpy(&verticesNoPositions[i * vertexStride], &mesh.positions[i * 3], 3 * sizeof(float));
+	}
+	MeshOptimizeStats noPositionStats;
+	OptimizeMesh(indicesNoPositions, verticesNoPositions, vertexStride, noPositions, MeshOptimizeDesc{}, &noPositionStats);
+	Check(noPositionStats.overdrawBefore.numPixelsCovered == 0 && noPositionStats.vertexCacheAfter.GetACMR() < noPositionStats.vertexCacheBefore.GetACMR(),
+		"without positions only the vertex cache and fetch steps run");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestAnalyzeVertexCache();
+	TestOptimizeVertexCache(rng);
+	TestAnalyzeOverdraw();
+	TestOptimizeOverdraw();
+	TestOptimizeVertexFetch();
+	TestOptimizeMesh(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
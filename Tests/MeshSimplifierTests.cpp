@@ -0,0 +1,340 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/MeshSimplifier.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Positions are three floats per vertex
+struct TestMesh
+{
+	vector<float> positions;
+	vector<uint32_t> indices;
+
+	uint32_t GetNumVertices() const { return (uint32_t)(positions.size() / 3); }
+};
+
+
+// A grid of quads with an open border, with its heights scaled by noise.  With splitColumn, the vertices down
+// that column are duplicated, as a UV seam would be, and the two halves index their own copies.
+TestMesh MakeGrid(uint32_t size, float noise, mt19937& rng, uint32_t splitColumn = ~0u)
+{
+	uniform_real_distribution<float> heightDistribution{ -1.0f, 1.0f };
+
+	TestMesh mesh;
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			mesh.positions.insert(mesh.positions.end(), { (float)x, (float)y, noise * heightDistribution(rng) });
+		}
+	}
+
+	vector<uint32_t> seamVertices(size + 1, ~0u);
+	if (splitColumn <= size)
+	{
+		for (uint32_t y = 0; y <= size; ++y)
+		{
+			const float* p = &mesh.positions[(y * (size + 1) + splitColumn) * 3];
+			seamVertices[y] = mesh.GetNumVertices();
+			mesh.positions.insert(mesh.positions.end(), { p[0], p[1], p[2] });
+		}
+	}
+
+	auto getVertex = [&](uint32_t x, uint32_t y, uint32_t quadX)
+	{
+		return (x == splitColumn && quadX >= splitColumn) ? seamVertices[y] : y * (size + 1) + x;
+	};
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			const uint32_t v0 = getVertex(x, y, x);
+			const uint32_t v1 = getVertex(x + 1, y, x);
+			const uint32_t v2 = getVertex(x, y + 1, x);
+			const uint32_t v3 = getVertex(x + 1, y + 1, x);
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+	return mesh;
+}
+
+
+// Closed, outward facing sphere with a single vertex at each pole and no seam, so nothing is locked
+TestMesh MakeSphere(float radius, uint32_t numRings, uint32_t numSegments)
+{
+	TestMesh mesh;
+	mesh.positions.insert(mesh.positions.end(), { 0.0f, radius, 0.0f });
+	for (uint32_t ring = 1; ring < numRings; ++ring)
+	{
+		const float theta = 3.14159265f * (float)ring / (float)numRings;
+		for (uint32_t segment = 0; segment < numSegments; ++segment)
+		{
+			const float phi = 2.0f * 3.14159265f * (float)segment / (float)numSegments;
+			mesh.positions.insert(mesh.positions.end(), { radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi) });
+		}
+	}
+	mesh.positions.insert(mesh.positions.end(), { 0.0f, -radius, 0.0f });
+
+	const uint32_t southPole = mesh.GetNumVertices() - 1;
+	auto getVertex = [numSegments](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * numSegments + segment % numSegments; };
+
+	for (uint32_t segment = 0; segment < numSegments; ++segment)
+	{
+		mesh.indices.insert(mesh.indices.end(), { 0, getVertex(1, segment + 1), getVertex(1, segment) });
+		mesh.indices.insert(mesh.indices.end(), { southPole, getVertex(numRings - 1, segment), getVertex(numRings - 1, segment + 1) });
+	}
+
+	for (uint32_t ring = 1; ring < numRings - 1; ++ring)
+	{
+		for (uint32_t segment = 0; segment < numSegments; ++segment)
+		{
+			const uint32_t v0 = getVertex(ring, segment);
+			const uint32_t v1 = getVertex(ring, segment + 1);
+			const uint32_t v2 = getVertex(ring + 1, segment);
+			const uint32_t v3 = getVertex(ring + 1, segment + 1);
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+	return mesh;
+}
+
+
+bool IsValid(span<const uint32_t> indices, uint32_t numVertices)
+{
+	if ((indices.size() % 3) != 0)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const uint32_t i0 = indices[i];
+		const uint32_t i1 = indices[i + 1];
+		const uint32_t i2 = indices[i + 2];
+		if (i0 >= numVertices || i1 >= numVertices || i2 >= numVertices || i0 == i1 || i1 == i2 || i2 == i0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+vector<bool> GetReferencedVertices(span<const uint32_t> indices, uint32_t numVertices)
+{
+	vector<bool> referenced(numVertices, false);
+	for (uint32_t index : indices)
+	{
+		referenced[index] = true;
+	}
+	return referenced;
+}
+
+
+// Counts the triangles of a mesh around the origin that face inward, which is what a fold over looks like
+uint32_t CountInwardTriangles(span<const uint32_t> indices, span<const float> positions)
+{
+	uint32_t numInward = 0;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const float* a = &positions[indices[i] * 3];
+		const float* b = &positions[indices[i + 1] * 3];
+		const float* c = &positions[indices[i + 2] * 3];
+
+		// Six times the signed volume of the tetrahedron with the origin
+		const double volume = (double)a[0] * (b[1] * c[2] - b[2] * c[1]) - (double)a[1] * (b[0] * c[2] - b[2] * c[0]) + (double)a[2] * (b[0] * c[1] - b[1] * c[0]);
+		numInward += volume <= 0.0 ? 1 : 0;
+	}
+	return numInward;
+}
+
+
+void TestReachesTarget()
+{
+	const TestMesh sphere = MakeSphere(10.0f, 32, 64);
+	const uint32_t numTriangles = (uint32_t)(sphere.indices.size() / 3);
+
+	for (float ratio : { 0.5f, 0.25f, 0.1f })
+	{
+		const uint32_t targetIndexCount = (uint32_t)((float)sphere.indices.size() * ratio) / 3 * 3;
+
+		vector<uint32_t> simplified;
+		const float error = SimplifyMesh(sphere.indices, sphere.positions, 3, targetIndexCount, 1.0f, simplified);
+
+		Check(IsValid(simplified, sphere.GetNumVertices()), "simplified triangles index existing vertices and aren't degenerate");
+		Check(simplified.size() <= targetIndexCount, "simplification stops at the target index count");
+
+		// A collapse removes the two triangles on its edge, and more where the mesh is pinched, so the last
+		// one can overshoot a little
+		Check(simplified.size() + 8 * 3 >= targetIndexCount, "simplification reaches the target index count within a few triangles");
+
+		Check(error > 0.0f && error <= 1.0f, "a curved surface reports a nonzero error");
+		Check(CountInwardTriangles(simplified, sphere.positions) == 0, "no simplified triangle of the sphere folds over");
+	}
+
+	// Already small enough
+	vector<uint32_t> unchanged;
+	Check(SimplifyMesh(sphere.indices, sphere.positions, 3, numTriangles * 3, 1.0f, unchanged) == 0.0f && unchanged == sphere.indices,
+		"a mesh at its target is copied unchanged");
+}
+
+
+void TestErrorLimit(mt19937& rng)
+{
+	// Every plane of a flat grid is the same, so interior collapses are free
+	const TestMesh flat = MakeGrid(32, 0.0f, rng);
+	vector<uint32_t> simplified;
+	const float flatError = SimplifyMesh(flat.indices, flat.positions, 3, 0, 0.001f, simplified);
+	Check(flatError == 0.0f, "a flat grid simplifies without error");
+	Check(simplified.size() < flat.indices.size() / 4, "a flat grid collapses down to not much more than its border");
+
+	// A rough grid stops on the error limit before reaching an unreachable target
+	const TestMesh rough = MakeGrid(32, 0.5f, rng);
+	const float tightError = SimplifyMesh(rough.indices, rough.positions, 3, 0, 0.002f, simplified);
+	const size_t tightSize = simplified.size();
+	const float looseError = SimplifyMesh(rough.indices, rough.positions, 3, 0, 0.05f, simplified);
+	const size_t looseSize = simplified.size();
+
+	Check(tightError <= 0.002f && looseError <= 0.05f, "simplification never reports more than the target error");
+	Check(tightSize < rough.indices.size(), "a tight error limit still allows some collapses");
+	Check(looseSize < tightSize && looseError > tightError, "a looser error limit allows more collapses at more error");
+}
+
+
+void TestLockedVertices(mt19937& rng)
+{
+	const uint32_t size = 24;
+	const uint32_t splitColumn = 11;
+	const TestMesh grid = MakeGrid(size, 0.2f, rng, splitColumn);
+
+	vector<uint32_t> simplified;
+	SimplifyMesh(grid.indices, grid.positions, 3, 0, 1.0f, simplified);
+	Check(IsValid(simplified, grid.GetNumVertices()), "simplified triangles index existing vertices and aren't degenerate");
+	Check(simplified.size() < grid.indices.size() / 4, "the interior of the grid collapses");
+
+	// Collapses move a vertex onto a neighbor, so a vertex that moved is no longer referenced
+	const vector<bool> referenced = GetReferencedVertices(simplified, grid.GetNumVertices());
+
+	bool bordersKept = true;
+	bool seamsKept = true;
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			const uint32_t vertex = y * (size + 1) + x;
+			if (x == 0 || y == 0 || x == size || y == size)
+			{
+				bordersKept = bordersKept && referenced[vertex];
+			}
+			if (x == splitColumn)
+			{
+				seamsKept = seamsKept && referenced[vertex] && referenced[(size + 1) * (size + 1) + y];
+			}
+		}
+	}
+	Check(bordersKept, "vertices on an open border never move");
+	Check(seamsKept, "vertices on a seam never move, on either side");
+
+	// The two sides of the seam still meet there, so no triangle crosses it
+	bool sidesSeparate = true;
+	for (size_t i = 0; i < simplified.size(); i += 3)
+	{
+		bool left = false;
+		bool right = false;
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			const uint32_t vertex = simplified[i + j];
+			const float x = grid.positions[vertex * 3];
+			const bool onSeam = x == (float)splitColumn;
+			const bool rightCopy = vertex >= (size + 1) * (size + 1);
+			left = left || (!onSeam && x < (float)splitColumn) || (onSeam && !rightCopy);
+			right = right || (!onSeam && x > (float)splitColumn) || rightCopy;
+		}
+		sidesSeparate = sidesSeparate && !(left && right);
+	}
+	Check(sidesSeparate, "no triangle joins the two sides of a seam");
+}
+
+
+void TestGenerateMeshLods()
+{
+	const TestMesh sphere = MakeSphere(10.0f, 48, 96);
+	const uint32_t lod0IndexCount = (uint32_t)sphere.indices.size();
+
+	vector<uint32_t> indices = sphere.indices;
+	vector<MeshLodLevel> levels;
+	const MeshLodDesc desc{ .maxLods = 6, .indexRatio = 0.5f, .maxError = 0.05f, .minTriangles = 64 };
+	GenerateMeshLods(indices, sphere.positions, 3, desc, levels);
+
+	Check(levels.size() >= 4 && levels.size() <= desc.maxLods, "a sphere gets several levels");
+	Check(levels[0].indexOffset == 0 && levels[0].indexCount == lod0IndexCount && levels[0].error == 0.0f, "LOD 0 is the source mesh");
+	Check(equal(sphere.indices.begin(), sphere.indices.end(), indices.begin()), "LOD 0 is left in place");
+
+	bool contiguous = true;
+	bool shrinking = true;
+	bool monotonicError = true;
+	bool withinLimit = true;
+	bool valid = true;
+	for (size_t lod = 1; lod < levels.size(); ++lod)
+	{
+		const MeshLodLevel& level = levels[lod];
+		const MeshLodLevel& previous = levels[lod - 1];
+
+		contiguous = contiguous && level.indexOffset == previous.indexOffset + previous.indexCount;
+		shrinking = shrinking && level.indexCount < previous.indexCount && level.indexCount / 3 >= desc.minTriangles;
+		monotonicError = monotonicError && level.error >= previous.error;
+
+		// Errors are reported in model units, and the sphere is 20 units across
+		withinLimit = withinLimit && level.error <= desc.maxError * 20.0f;
+		valid = valid && IsValid(span<const uint32_t>{ indices.data() + level.indexOffset, level.indexCount }, sphere.GetNumVertices());
+	}
+
+	Check(contiguous && levels.back().indexOffset + levels.back().indexCount == indices.size(), "levels follow each other in the index buffer");
+	Check(shrinking, "each level has fewer triangles than the one before it, and no fewer than the minimum");
+	Check(monotonicError, "the error never decreases from one level to the next");
+	Check(withinLimit, "no level exceeds the error limit");
+	Check(valid, "every level indexes existing vertices");
+	Check(levels.back().error > 0.0f, "the coarsest level of a sphere reports an error");
+
+	// A tiny mesh is below the minimum, so only LOD 0
+	const TestMesh small = MakeSphere(1.0f, 4, 8);
+	vector<uint32_t> smallIndices = small.indices;
+	GenerateMeshLods(smallIndices, small.positions, 3, desc, levels);
+	Check(levels.size() == 1 && smallIndices == small.indices, "a mesh below the minimum triangle count gets no levels");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestReachesTarget();
+	TestErrorLimit(rng);
+	TestLockedVertices(rng);
+	TestGenerateMeshLods();
+
+	return FailureCount() == 0 ? 0 : 1;
+}
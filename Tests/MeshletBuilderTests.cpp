@@ -0,0 +1,427 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/MeshletBuilder.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+struct Vec3
+{
+	float x{ 0.0f };
+	float y{ 0.0f };
+	float z{ 0.0f };
+};
+
+
+Vec3 operator+(const Vec3& a, const Vec3& b) { return Vec3{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+Vec3 operator-(const Vec3& a, const Vec3& b) { return Vec3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+Vec3 operator*(const Vec3& a, float s) { return Vec3{ a.x * s, a.y * s, a.z * s }; }
+float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+Vec3 Cross(const Vec3& a, const Vec3& b) { return Vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+float Length(const Vec3& a) { return sqrtf(Dot(a, a)); }
+Vec3 Normalize(const Vec3& a) { return a * (1.0f / Length(a)); }
+
+
+struct TestMesh
+{
+	const char* name{ nullptr };
+	vector<Vec3> positions;
+	vector<uint32_t> indices;
+};
+
+
+// Height field with a little noise, so the normals are close but not identical
+TestMesh MakeGrid(uint32_t size, mt19937& rng)
+{
+	uniform_real_distribution<float> noise{ -0.05f, 0.05f };
+
+	TestMesh mesh{ .name = "grid" };
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			mesh.positions.push_back(Vec3{ (float)x, (float)y, noise(rng) });
+		}
+	}
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			const uint32_t v0 = y * (size + 1) + x;
+			const uint32_t v1 = v0 + 1;
+			const uint32_t v2 = v0 + size + 1;
+			const uint32_t v3 = v2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+	return mesh;
+}
+
+
+// Closed, outward facing latitude/longitude sphere
+TestMesh MakeSphere(uint32_t numRings, uint32_t numSegments)
+{
+	TestMesh mesh{ .name = "sphere" };
+	for (uint32_t ring = 0; ring <= numRings; ++ring)
+	{
+		const float theta = 3.14159265f * (float)ring / (float)numRings;
+		for (uint32_t segment = 0; segment <= numSegments; ++segment)
+		{
+			const float phi = 2.0f * 3.14159265f * (float)segment / (float)numSegments;
+			mesh.positions.push_back(Vec3{ sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) } * 10.0f);
+		}
+	}
+
+	for (uint32_t ring = 0; ring < numRings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < numSegments; ++segment)
+		{
+			const uint32_t v0 = ring * (numSegments + 1) + segment;
+			const uint32_t v1 = v0 + 1;
+			const uint32_t v2 = v0 + numSegments + 1;
+			const uint32_t v3 = v2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, v2, v2, v1, v3 });
+		}
+	}
+	return mesh;
+}
+
+
+// Unconnected triangles pointing every which way, including degenerate ones, so most cones are degenerate
+TestMesh MakeSoup(uint32_t numVertices, uint32_t numTriangles, mt19937& rng)
+{
+	uniform_real_distribution<float> coordinate{ -5.0f, 5.0f };
+	uniform_int_distribution<uint32_t> vertex{ 0, numVertices - 1 };
+
+	TestMesh mesh{ .name = "soup" };
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		mesh.positions.push_back(Vec3{ coordinate(rng), coordinate(rng), coordinate(rng) });
+	}
+
+	for (uint32_t i = 0; i < numTriangles; ++i)
+	{
+		const uint32_t a = vertex(rng);
+		const uint32_t b = (i % 17 == 0) ? a : vertex(rng);
+		mesh.indices.insert(mesh.indices.end(), { a, b, vertex(rng) });
+	}
+	return mesh;
+}
+
+
+// Vertices with other attributes after the position, as they are in a real vertex buffer
+vector<byte> PackPositions(const TestMesh& mesh, uint32_t stride)
+{
+	vector<byte> positions(mesh.positions.size() * stride, byte{ 0xcd });
+	for (size_t i = 0; i < mesh.positions.size(); ++i)
+	{
+		memcpy(positions.data() + i * stride, &mesh.positions[i], sizeof(Vec3));
+	}
+	return positions;
+}
+
+
+vector<byte> PackIndices(span<const uint32_t> indices, uint32_t indexSize)
+{
+	vector<byte> packed(indices.size() * indexSize);
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		if (indexSize == sizeof(uint16_t))
+		{
+			const uint16_t index = (uint16_t)indices[i];
+			memcpy(packed.data() + i * indexSize, &index, indexSize);
+		}
+		else
+		{
+			memcpy(packed.data() + i * indexSize, &indices[i], indexSize);
+		}
+	}
+	return packed;
+}
+
+
+uint32_t ReadUniqueVertexIndex(const MeshletData& data, uint32_t i)
+{
+	if (data.indexSize == sizeof(uint16_t))
+	{
+		uint16_t index{ 0 };
+		memcpy(&index, data.uniqueVertexIndices.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+		return index;
+	}
+
+	uint32_t index{ 0 };
+	memcpy(&index, data.uniqueVertexIndices.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+	return index;
+}
+
+
+// The cone test from the meshlet amplification shader, with an identity world transform
+bool IsConeCulled(const MeshletCullData& cullData, const Vec3& viewPosition)
+{
+	if (cullData.normalCone[3] == 0xff)
+	{
+		return false;
+	}
+
+	const Vec3 center{ cullData.boundingSphere[0], cullData.boundingSphere[1], cullData.boundingSphere[2] };
+	const Vec3 axis = Normalize(Vec3{
+		(float)cullData.normalCone[0] / 255.0f * 2.0f - 1.0f,
+		(float)cullData.normalCone[1] / 255.0f * 2.0f - 1.0f,
+		(float)cullData.normalCone[2] / 255.0f * 2.0f - 1.0f });
+	const float cutoff = (float)cullData.normalCone[3] / 255.0f;
+
+	const Vec3 apex = center - axis * cullData.apexOffset;
+	const Vec3 view = Normalize(viewPosition - apex);
+	return Dot(view, axis * -1.0f) > cutoff;
+}
+
+
+struct ConeStats
+{
+	uint32_t numCones{ 0 };
+	uint32_t numCulledViews{ 0 };
+};
+
+
+void CheckMeshlets(const TestMesh& mesh, uint32_t positionStride, uint32_t indexSize, const MeshletBuildDesc& desc, mt19937& rng, ConeStats& coneStats)
+{
+	const auto positions = PackPositions(mesh, positionStride);
+	const auto indices = PackIndices(mesh.indices, indexSize);
+
+	MeshletData data;
+	if (!BuildMeshlets(positions, positionStride, indices, indexSize, desc, data))
+	{
+		Check(false, "BuildMeshlets accepts a valid mesh");
+		return;
+	}
+
+	Check(data.indexSize == indexSize, "meshlets keep the mesh's index size");
+	Check(data.cullData.size() == data.meshlets.size(), "every meshlet has culling data");
+
+	// Every input triangle comes out exactly once, with its winding intact
+	vector<array<uint32_t, 3>> expected;
+	for (size_t i = 0; i < mesh.indices.size(); i += 3)
+	{
+		expected.push_back({ mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2] });
+	}
+
+	vector<array<uint32_t, 3>> emitted;
+	uint32_t nextVertOffset = 0;
+	uint32_t nextPrimOffset = 0;
+	bool limitsHeld = true;
+	bool offsetsContiguous = true;
+	bool localIndicesInRange = true;
+	bool verticesUnique = true;
+	bool spheresEnclose = true;
+
+	for (size_t m = 0; m < data.meshlets.size(); ++m)
+	{
+		const Meshlet& meshlet = data.meshlets[m];
+
+		limitsHeld = limitsHeld && meshlet.vertCount <= desc.maxVertices && meshlet.primCount <= desc.maxPrimitives && meshlet.primCount > 0;
+		offsetsContiguous = offsetsContiguous && meshlet.vertOffset == nextVertOffset && meshlet.primOffset == nextPrimOffset;
+		nextVertOffset += meshlet.vertCount;
+		nextPrimOffset += meshlet.primCount;
+
+		if (nextVertOffset * indexSize > data.uniqueVertexIndices.size() || nextPrimOffset > data.primitiveIndices.size())
+		{
+			Check(false, "meshlets stay inside their index buffers");
+			return;
+		}
+
+		vector<uint32_t> meshletVertices;
+		for (uint32_t v = 0; v < meshlet.vertCount; ++v)
+		{
+			meshletVertices.push_back(ReadUniqueVertexIndex(data, meshlet.vertOffset + v));
+		}
+
+		vector<uint32_t> sortedVertices = meshletVertices;
+		sort(sortedVertices.begin(), sortedVertices.end());
+		verticesUnique = verticesUnique && adjacent_find(sortedVertices.begin(), sortedVertices.end()) == sortedVertices.end();
+
+		const MeshletCullData& cullData = data.cullData[m];
+		const Vec3 center{ cullData.boundingSphere[0], cullData.boundingSphere[1], cullData.boundingSphere[2] };
+		const float radius = cullData.boundingSphere[3];
+		for (uint32_t vertex : meshletVertices)
+		{
+			spheresEnclose = spheresEnclose && Length(mesh.positions[vertex] - center) <= radius * 1.0001f + 1.0e-5f;
+		}
+
+		for (uint32_t p = 0; p < meshlet.primCount; ++p)
+		{
+			const MeshletTriangle& triangle = data.primitiveIndices[meshlet.primOffset + p];
+			if (triangle.i0 >= meshlet.vertCount || triangle.i1 >= meshlet.vertCount || triangle.i2 >= meshlet.vertCount)
+			{
+				localIndicesInRange = false;
+				continue;
+			}
+			emitted.push_back({ meshletVertices[triangle.i0], meshletVertices[triangle.i1], meshletVertices[triangle.i2] });
+		}
+
+		// Any view the cone rejects must see every triangle in the meshlet from behind.  Views are sampled all
+		// around the meshlet, and along the inverted axis, where the cone does reject them.
+		if (cullData.normalCone[3] == 0xff)
+		{
+			continue;
+		}
+		++coneStats.numCones;
+
+		const Vec3 axis = Normalize(Vec3{
+			(float)cullData.normalCone[0] / 255.0f * 2.0f - 1.0f,
+			(float)cullData.normalCone[1] / 255.0f * 2.0f - 1.0f,
+			(float)cullData.normalCone[2] / 255.0f * 2.0f - 1.0f });
+		const Vec3 apex = center - axis * cullData.apexOffset;
+
+		uniform_real_distribution<float> direction{ -1.0f, 1.0f };
+		uniform_real_distribution<float> distance{ 0.0f, 4.0f * radius + cullData.apexOffset + 1.0f };
+
+		for (uint32_t sample = 0; sample < 64; ++sample)
+		{
+			const Vec3 randomDirection{ direction(rng), direction(rng), direction(rng) };
+			const Vec3 origin = (sample % 2 == 0) ? center : apex;
+			const Vec3 towards = (sample % 2 == 0) ? randomDirection : (axis * -1.0f + randomDirection * 0.25f);
+			if (Dot(towards, towards) < 1.0e-6f)
+			{
+				continue;
+			}
+			const Vec3 viewPosition = origin + Normalize(towards) * distance(rng);
+
+			if (!IsConeCulled(cullData, viewPosition))
+			{
+				continue;
+			}
+			++coneStats.numCulledViews;
+
+			for (uint32_t p = 0; p < meshlet.primCount; ++p)
+			{
+				const MeshletTriangle& triangle = data.primitiveIndices[meshlet.primOffset + p];
+				const Vec3& p0 = mesh.positions[meshletVertices[triangle.i0]];
+				const Vec3& p1 = mesh.positions[meshletVertices[triangle.i1]];
+				const Vec3& p2 = mesh.positions[meshletVertices[triangle.i2]];
+
+				const Vec3 normal = Cross(p1 - p0, p2 - p0);
+				if (Dot(normal, normal) <= numeric_limits<float>::min())
+				{
+					continue;
+				}
+
+				if (Dot(viewPosition - p0, Normalize(normal)) > 1.0e-4f * (1.0f + radius))
+				{
+					fprintf(stderr, "%s: meshlet %zu culls a view that sees triangle %u from the front\n", mesh.name, m, p);
+					Check(false, "normal cones are conservative");
+					return;
+				}
+			}
+		}
+	}
+
+	Check(limitsHeld, "meshlets stay within the vertex and primitive limits");
+	Check(offsetsContiguous, "meshlet offsets are contiguous");
+	Check(localIndicesInRange, "primitive indices stay inside their meshlet");
+	Check(verticesUnique, "each meshlet lists a vertex once");
+	Check(spheresEnclose, "bounding spheres enclose their meshlet");
+
+	sort(expected.begin(), expected.end());
+	sort(emitted.begin(), emitted.end());
+	if (emitted != expected)
+	{
+		fprintf(stderr, "%s: %zu triangles in, %zu out\n", mesh.name, expected.size(), emitted.size());
+	}
+	Check(emitted == expected, "every triangle is emitted exactly once");
+
+	// The same input always gives the same meshlets
+	MeshletData rebuilt;
+	BuildMeshlets(positions, positionStride, indices, indexSize, desc, rebuilt);
+	Check(rebuilt.meshlets.size() == data.meshlets.size()
+		&& rebuilt.uniqueVertexIndices == data.uniqueVertexIndices
+		&& rebuilt.primitiveIndices.size() == data.primitiveIndices.size()
+		&& memcmp(rebuilt.cullData.data(), data.cullData.data(), data.cullData.size() * sizeof(MeshletCullData)) == 0,
+		"meshlets are deterministic");
+}
+
+
+void CheckInvalidInput(mt19937& rng)
+{
+	const TestMesh mesh = MakeGrid(4, rng);
+	const auto positions = PackPositions(mesh, sizeof(Vec3));
+	const auto indices = PackIndices(mesh.indices, sizeof(uint32_t));
+
+	MeshletData data;
+	Check(!BuildMeshlets(positions, sizeof(Vec3), indices, 3, MeshletBuildDesc{}, data), "odd index sizes are rejected");
+	Check(!BuildMeshlets(positions, 8, indices, sizeof(uint32_t), MeshletBuildDesc{}, data), "strides smaller than a position are rejected");
+	Check(!BuildMeshlets(positions, sizeof(Vec3), indices, sizeof(uint32_t), MeshletBuildDesc{ .maxVertices = 2 }, data), "meshlets need room for a triangle");
+	Check(!BuildMeshlets(positions, sizeof(Vec3), indices, sizeof(uint32_t), MeshletBuildDesc{ .maxVertices = MaxMeshletVertices + 1 }, data), "meshlets fit the packed primitive indices");
+
+	const span<const byte> partialTriangle{ indices.data(), indices.size() - sizeof(uint32_t) };
+	Check(!BuildMeshlets(positions, sizeof(Vec3), partialTriangle, sizeof(uint32_t), MeshletBuildDesc{}, data), "partial triangles are rejected");
+
+	vector<uint32_t> outOfRange = mesh.indices;
+	outOfRange.back() = (uint32_t)mesh.positions.size();
+	const auto outOfRangeIndices = PackIndices(outOfRange, sizeof(uint32_t));
+	Check(!BuildMeshlets(positions, sizeof(Vec3), outOfRangeIndices, sizeof(uint32_t), MeshletBuildDesc{}, data), "out of range indices are rejected");
+
+	MeshletData empty;
+	Check(BuildMeshlets(positions, sizeof(Vec3), {}, sizeof(uint32_t), MeshletBuildDesc{}, empty) && empty.meshlets.empty(), "no triangles give no meshlets");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	const TestMesh grid = MakeGrid(40, rng);
+	const TestMesh sphere = MakeSphere(32, 48);
+	const TestMesh soup = MakeSoup(500, 3000, rng);
+
+	const MeshletBuildDesc descs[] = {
+		MeshletBuildDesc{},
+		MeshletBuildDesc{ .maxVertices = MaxMeshletVertices, .maxPrimitives = MaxMeshletPrimitives },
+		MeshletBuildDesc{ .maxVertices = 3, .maxPrimitives = 1 },
+		MeshletBuildDesc{ .maxVertices = 32, .maxPrimitives = 200 }
+	};
+
+	ConeStats closedStats;
+	ConeStats soupStats;
+
+	for (const auto& desc : descs)
+	{
+		for (uint32_t indexSize : { (uint32_t)sizeof(uint16_t), (uint32_t)sizeof(uint32_t) })
+		{
+			CheckMeshlets(grid, sizeof(Vec3), indexSize, desc, rng, closedStats);
+			CheckMeshlets(sphere, 32, indexSize, desc, rng, closedStats);
+			CheckMeshlets(soup, sizeof(Vec3), indexSize, desc, rng, soupStats);
+		}
+	}
+
+	// Make sure the cone checks above actually had something to check
+	Check(closedStats.numCones > 0 && closedStats.numCulledViews > 0, "smooth meshes get normal cones that reject views");
+
+	CheckInvalidInput(rng);
+
+	printf("MeshletBuilder: %u cones checked against %u rejected views, %u cones in the triangle soup\n",
+		closedStats.numCones, closedStats.numCulledViews, soupStats.numCones);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureInitializer.h"
+
+#include "Core/CpuFeatures.h"
+
+#include "Benchmark.h"
+
+#include <random>
+#include <thread>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+struct MipCase
+{
+	const char* name{ nullptr };
+	Format format{ Format::Unknown };
+	uint32_t bytesPerPixel{ 0 };
+	MipFilter filter{ MipFilter::Box };
+};
+
+
+// Generates the chain numRuns times and returns the fastest, in MB/s of top-level image
+double MeasureMBps(const MipCase& mipCase, uint32_t width, uint32_t height, const vector<std::byte>& image, bool allowSimd, bool allowParallel,
+	uint32_t numRuns, vector<std::byte>& outStorage)
+{
+	const MipGenerationDesc desc{
+		.format			= mipCase.format,
+		.width			= width,
+		.height			= height,
+		.filter			= mipCase.filter,
+		.allowSimd		= allowSimd,
+		.allowParallel	= allowParallel
+	};
+
+	TextureInitializer texInit;
+	bool succeeded = true;
+	const double ms = MeasureMs(numRuns, [&] { succeeded = GenerateMipChain(desc, image.data(), outStorage, texInit) && succeeded; });
+
+	Check(succeeded, "the mip chain was generated");
+	return (double)width * height * mipCase.bytesPerPixel / (ms * 1.0e3);
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t size = commandLine.GetOption("--size", commandLine.Size(2048, 128));
+	const uint32_t numRuns = commandLine.Size(5, 1);
+
+	// An odd width keeps the box filter off its 2x2 path below the top level
+	const uint32_t width = commandLine.HasFlag("--odd") ? size - 1 : size;
+	const uint32_t height = size;
+
+	JobSystem jobSystem{ max(thread::hardware_concurrency(), 1u) - 1 };
+
+	const MipCase cases[] = {
+		{ "RGBA8, box",			Format::RGBA8_UNorm,	4,	MipFilter::Box },
+		{ "sRGBA8, box",		Format::SRGBA8_UNorm,	4,	MipFilter::Box },
+		{ "RGBA8, Lanczos",		Format::RGBA8_UNorm,	4,	MipFilter::Lanczos },
+		{ "RGBA16, box",		Format::RGBA16_UNorm,	8,	MipFilter::Box },
+		{ "RGBA32F, box",		Format::RGBA32_Float,	16,	MipFilter::Box },
+		{ "RGBA32F, Lanczos",	Format::RGBA32_Float,	16,	MipFilter::Lanczos }
+	};
+
+	printf("Mip generation benchmark, %ux%u, %s kernels, %u threads, fastest of %u runs\n\n", width, height,
+		HasAVX2() && HasSSE41() ? "AVX2" : HasSSE41() ? "SSE4.1" : "scalar", jobSystem.GetNumWorkers() + 1, numRuns);
+	printf("%-18s %14s %14s %8s %14s %8s\n", "Format", "Scalar", "SIMD", "Speedup", "SIMD, jobs", "Speedup");
+
+	mt19937 rng{ 1234 };
+
+	for (const MipCase& mipCase : cases)
+	{
+		vector<std::byte> image((size_t)width * height * mipCase.bytesPerPixel);
+		if (mipCase.format == Format::RGBA32_Float)
+		{
+			uniform_real_distribution<float> distribution{ 0.0f, 1.0f };
+			for (size_t i = 0; i < image.size(); i += sizeof(float))
+			{
+				const float value = distribution(rng);
+				memcpy(&image[i], &value, sizeof(float));
+			}
+		}
+		else
+		{
+			for (auto& value : image)
+			{
+				value = (std::byte)(rng() & 0xff);
+			}
+		}
+
+		vector<std::byte> scalarStorage;
+		vector<std::byte> simdStorage;
+		vector<std::byte> parallelStorage;
+
+		const double scalarMBps = MeasureMBps(mipCase, width, height, image, false, false, numRuns, scalarStorage);
+		const double simdMBps = MeasureMBps(mipCase, width, height, image, true, false, numRuns, simdStorage);
+		const double parallelMBps = MeasureMBps(mipCase, width, height, image, true, true, numRuns, parallelStorage);
+
+		Check(scalarStorage == simdStorage && scalarStorage == parallelStorage, "every path produces the same chain");
+
+		printf("%-18s %9.0f MB/s %9.0f MB/s %7.1fx %9.0f MB/s %7.1fx\n", mipCase.name,
+			scalarMBps, simdMBps, simdMBps / scalarMBps, parallelMBps, parallelMBps / scalarMBps);
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureInitializer.h"
+
+#include "Core/CpuFeatures.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+struct MipChain
+{
+	vector<std::byte> storage;
+	TextureInitializer texInit;
+	bool succeeded{ false };
+};
+
+
+MipChain Generate(const MipGenerationDesc& desc, const vector<std::byte>& srcData)
+{
+	MipChain chain;
+	chain.succeeded = GenerateMipChain(desc, srcData.data(), chain.storage, chain.texInit);
+	return chain;
+}
+
+
+uint32_t GetBytesPerPixel(Format format)
+{
+	switch (format)
+	{
+	case Format::R8_UNorm:		return 1;
+	case Format::RG8_UNorm:
+	case Format::R16_UNorm:		return 2;
+	case Format::RGBA16_UNorm:
+	case Format::RG32_Float:	return 8;
+	case Format::RGB32_Float:	return 12;
+	case Format::RGBA32_Float:	return 16;
+	default:					return 4;
+	}
+}
+
+
+bool IsFloatFormat(Format format)
+{
+	return format == Format::RG32_Float || format == Format::RGB32_Float || format == Format::RGBA32_Float;
+}
+
+
+// Random texels.  Float images stay in [0, 1], with a few out-of-range values to check clamping does not differ.
+vector<std::byte> MakeImage(Format format, uint32_t width, uint32_t height, mt19937& rng)
+{
+	vector<std::byte> image((size_t)width * height * GetBytesPerPixel(format));
+
+	if (IsFloatFormat(format))
+	{
+		uniform_real_distribution<float> distribution{ -0.1f, 1.1f };
+		float* texels = (float*)image.data();
+		for (size_t i = 0; i < image.size() / sizeof(float); ++i)
+		{
+			texels[i] = distribution(rng);
+		}
+		return image;
+	}
+
+	for (auto& value : image)
+	{
+		value = (std::byte)(rng() & 0xff);
+	}
+	return image;
+}
+
+
+void TestLayout()
+{
+	mt19937 rng{ 1234 };
+
+	Check(GetFullMipCount(1, 1) == 1 && GetFullMipCount(256, 256) == 9 && GetFullMipCount(37, 300) == 9, "full mip counts");
+	Check(!IsMipGenerationSupported(Format::BC1_UNorm) && IsMipGenerationSupported(Format::SRGBA8_UNorm), "supported formats");
+
+	for (Format format : { Format::RGBA8_UNorm, Format::RGB32_Float, Format::R8_UNorm })
+	{
+		const uint32_t bytesPerPixel = GetBytesPerPixel(format);
+		const auto image = MakeImage(format, 37, 20, rng);
+		const MipChain chain = Generate({ .format = format, .width = 37, .height = 20 }, image);
+
+		Check(chain.succeeded && chain.texInit.numMips == 6 && chain.texInit.subResourceData.size() == 6, "an odd-sized image gets a full chain");
+		Check(memcmp(chain.storage.data(), image.data(), image.size()) == 0, "the top level is the source image");
+		Check(chain.storage.size() % 16 == 0 && chain.texInit.totalBytes <= chain.storage.size(), "the storage is padded to whole 16-byte blocks");
+
+		for (uint32_t mipLevel = 0; mipLevel < chain.texInit.numMips; ++mipLevel)
+		{
+			const auto& level = chain.texInit.subResourceData[mipLevel];
+			const bool sizeMatches = level.width == max(37u >> mipLevel, 1u) && level.height == max(20u >> mipLevel, 1u);
+			const bool pitchMatches = level.rowPitch == level.width * bytesPerPixel && level.slicePitch == level.rowPitch * level.height;
+			const bool offsetAligned = level.bufferOffset % bytesPerPixel == 0 && level.bufferOffset % 4 == 0;
+			const bool inStorage = level.data == chain.storage.data() + level.bufferOffset && level.bufferOffset + level.slicePitch <= chain.texInit.totalBytes;
+			Check(sizeMatches && pitchMatches && offsetAligned && inStorage, "each level has its size, pitch and an aligned offset");
+		}
+	}
+
+	const MipChain partial = Generate({ .format = Format::RGBA8_UNorm, .width = 64, .height = 64, .numMips = 3 }, MakeImage(Format::RGBA8_UNorm, 64, 64, rng));
+	Check(partial.succeeded && partial.texInit.numMips == 3, "a partial chain stops at the requested level");
+
+	vector<std::byte> image(16);
+	MipChain chain;
+	Check(!GenerateMipChain({ .format = Format::BC1_UNorm, .width = 4, .height = 4 }, image.data(), chain.storage, chain.texInit), "unsupported formats fail");
+	Check(!GenerateMipChain({ .format = Format::RGBA8_UNorm, .width = 0, .height = 4 }, image.data(), chain.storage, chain.texInit), "empty images fail");
+}
+
+
+// A 2x2 box of known texels filters to their rounded average.  In sRGB, the colour channels are averaged in
+// linear space, and alpha is not.
+void TestBoxAverage()
+{
+	const auto bytes = [](initializer_list<uint8_t> values)
+		{
+			vector<std::byte> image;
+			for (uint8_t value : values)
+			{
+				image.push_back((std::byte)value);
+			}
+			return image;
+		};
+
+	const auto image = bytes({
+		0, 10, 255, 0,		255, 20, 255, 255,
+		0, 30, 0, 0,		255, 41, 0, 255 });
+
+	const MipChain unorm = Generate({ .format = Format::RGBA8_UNorm, .width = 2, .height = 2 }, image);
+	const uint8_t* unormTexel = (const uint8_t*)unorm.texInit.subResourceData[1].data;
+	Check(unormTexel[0] == 128 && unormTexel[1] == 25 && unormTexel[2] == 128 && unormTexel[3] == 128, "UNorm texels average linearly");
+
+	const MipChain srgb = Generate({ .format = Format::SRGBA8_UNorm, .width = 2, .height = 2 }, image);
+	const uint8_t* srgbTexel = (const uint8_t*)srgb.texInit.subResourceData[1].data;
+	Check(srgbTexel[0] == 188 && srgbTexel[2] == 188, "sRGB colour channels average in linear space");
+	Check(srgbTexel[3] == 128, "sRGB alpha averages without gamma");
+}
+
+
+// Filter weights sum to one, so a flat image stays flat at every level, whatever its size and filter
+void TestFlatImage()
+{
+	for (MipFilter filter : { MipFilter::Box, MipFilter::Lanczos })
+	{
+		for (const auto& [width, height] : { pair{ 3u, 3u }, pair{ 37u, 20u }, pair{ 1u, 17u }, pair{ 64u, 64u } })
+		{
+			vector<std::byte> image8((size_t)width * height * 4);
+			for (size_t i = 0; i < image8.size(); ++i)
+			{
+				image8[i] = (std::byte)(40 + 50 * (i % 4));
+			}
+
+			vector<uint16_t> image16((size_t)width * height * 4);
+			for (size_t i = 0; i < image16.size(); ++i)
+			{
+				image16[i] = (uint16_t)(1000 + 20000 * (i % 4));
+			}
+
+			vector<std::byte> image16Bytes(image16.size() * sizeof(uint16_t));
+			memcpy(image16Bytes.data(), image16.data(), image16Bytes.size());
+
+			const MipChain chain8 = Generate({ .format = Format::RGBA8_UNorm, .width = width, .height = height, .filter = filter }, image8);
+			const MipChain chain16 = Generate({ .format = Format::RGBA16_UNorm, .width = width, .height = height, .filter = filter }, image16Bytes);
+
+			bool isFlat = chain8.succeeded && chain16.succeeded;
+			for (size_t i = 0; i < chain8.texInit.totalBytes; ++i)
+			{
+				isFlat = isFlat && chain8.storage[i] == (std::byte)(40 + 50 * (i % 4));
+			}
+
+			for (const auto& level : chain16.texInit.subResourceData)
+			{
+				const uint16_t* texels = (const uint16_t*)level.data;
+				for (size_t i = 0; i < level.slicePitch / sizeof(uint16_t); ++i)
+				{
+					isFlat = isFlat && texels[i] == (uint16_t)(1000 + 20000 * (i % 4));
+				}
+			}
+			Check(isFlat, "a flat image stays flat at every level");
+		}
+	}
+}
+
+
+// The SIMD kernels must produce the same bits as the scalar reference, for every format, filter, and size,
+// including odd and non-power-of-two sizes, where the kernels leave texels over for the narrower ones
+void TestSimdMatchesScalar(mt19937& rng)
+{
+	const Format formats[] = {
+		Format::R8_UNorm, Format::RG8_UNorm, Format::RGBA8_UNorm, Format::BGRA8_UNorm, Format::SRGBA8_UNorm, Format::SBGRA8_UNorm,
+		Format::R16_UNorm, Format::RGBA16_UNorm, Format::RG32_Float, Format::RGB32_Float, Format::RGBA32_Float };
+
+	const pair<uint32_t, uint32_t> sizes[] = {
+		{ 1, 1 }, { 2, 2 }, { 3, 5 }, { 5, 3 }, { 37, 20 }, { 64, 64 }, { 129, 67 }, { 300, 7 }, { 1, 64 }, { 256, 256 } };
+
+	for (Format format : formats)
+	{
+		for (const auto& [width, height] : sizes)
+		{
+			const auto image = MakeImage(format, width, height, rng);
+
+			for (MipFilter filter : { MipFilter::Box, MipFilter::Lanczos })
+			{
+				const MipGenerationDesc scalarDesc{ .format = format, .width = width, .height = height, .filter = filter, .allowSimd = false, .allowParallel = false };
+				const MipChain scalar = Generate(scalarDesc, image);
+
+				MipGenerationDesc simdDesc = scalarDesc;
+				simdDesc.allowSimd = true;
+				const MipChain simd = Generate(simdDesc, image);
+
+				// Bands on the job system must not change the result either
+				simdDesc.allowParallel = true;
+				const MipChain parallel = Generate(simdDesc, image);
+
+				const size_t numBytes = scalar.texInit.totalBytes;
+				const bool matches = scalar.succeeded && simd.succeeded && parallel.succeeded
+					&& memcmp(scalar.storage.data(), simd.storage.data(), numBytes) == 0
+					&& memcmp(scalar.storage.data(), parallel.storage.data(), numBytes) == 0;
+
+				if (!matches)
+				{
+					fprintf(stderr, "format %u, %ux%u, %s filter\n", (uint32_t)format, width, height, filter == MipFilter::Box ? "box" : "Lanczos");
+					Check(false, "the SIMD and parallel paths match the scalar one");
+					return;
+				}
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	// Large levels are split across the job system
+	JobSystem jobSystem{ 3 };
+
+	mt19937 rng{ 1234 };
+
+	printf("SIMD kernels: %s\n", HasAVX2() && HasSSE41() ? "AVX2" : HasSSE41() ? "SSE4.1" : "none, scalar only");
+
+	TestLayout();
+	TestBoxAverage();
+	TestFlatImage();
+	TestSimdMatchesScalar(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
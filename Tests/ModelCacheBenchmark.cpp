@@ -0,0 +1,145 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FileSystem.h"
+#include "MappedFile.h"
+#include "Graphics/Loaders/ModelCache.h"
+
+#include "Benchmark.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+const filesystem::path s_rootPath = filesystem::temp_directory_path() / "LunaModelCacheBenchmark";
+
+const uint32_t s_vertexStride = 32;
+
+
+// A square grid of position, normal and texcoord vertices, with 32-bit indices, as ModelLoader would cook it
+struct SyntheticMesh
+{
+	vector<float> vertices;
+	vector<float> positions;
+	vector<uint32_t> indices;
+	MeshPart meshPart;
+};
+
+
+void MakeSyntheticMesh(uint32_t gridSize, SyntheticMesh& outMesh)
+{
+	for (uint32_t y = 0; y < gridSize; ++y)
+	{
+		for (uint32_t x = 0; x < gridSize; ++x)
+		{
+			const float u = (float)x / (float)(gridSize - 1);
+			const float v = (float)y / (float)(gridSize - 1);
+			outMesh.vertices.insert(outMesh.vertices.end(), { u, 0.0f, v, 0.0f, 1.0f, 0.0f, u, v });
+			outMesh.positions.insert(outMesh.positions.end(), { u, 0.0f, v });
+		}
+	}
+
+	for (uint32_t y = 0; y + 1 < gridSize; ++y)
+	{
+		for (uint32_t x = 0; x + 1 < gridSize; ++x)
+		{
+			const uint32_t i0 = y * gridSize + x;
+			outMesh.indices.insert(outMesh.indices.end(), { i0, i0 + gridSize, i0 + 1, i0 + 1, i0 + gridSize, i0 + gridSize + 1 });
+		}
+	}
+
+	outMesh.meshPart = MeshPart{
+		.vertexBase		= 0,
+		.vertexCount	= gridSize * gridSize,
+		.indexBase		= 0,
+		.indexCount		= (uint32_t)outMesh.indices.size() };
+}
+
+
+// Maps the cache file and validates it, as ModelLoader does on a cache hit, and returns the number of meshes
+size_t LoadFromCache(const string& filename, const ModelCacheKey& key, ModelCacheValidation validation)
+{
+	MappedFile cacheFile;
+	CookedModel model;
+	if (!cacheFile.Open(filename) || !ReadModelCache(cacheFile, key, validation, model))
+	{
+		return 0;
+	}
+	return model.meshes.size();
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t gridSize = commandLine.Size(1024, 64);
+	const uint32_t numRuns = commandLine.Size(5, 1);
+
+	filesystem::remove_all(s_rootPath);
+	filesystem::create_directories(s_rootPath);
+
+	FileSystem fileSystem{ "LunaModelCacheBenchmark" };
+	fileSystem.SetRootPath(s_rootPath);
+
+	SyntheticMesh mesh;
+	MakeSyntheticMesh(gridSize, mesh);
+
+	CookedModel model;
+	model.meshes.push_back(CookedMesh{
+		.name					= "Grid",
+		.vertexStride			= s_vertexStride,
+		.indexSize				= sizeof(uint32_t),
+		.vertexData				= as_bytes(span{ mesh.vertices }),
+		.vertexDataPositionOnly = as_bytes(span{ mesh.positions }),
+		.indexData				= as_bytes(span{ mesh.indices }),
+		.meshParts				= span{ &mesh.meshPart, 1 },
+		.boundsMax				= { 1.0f, 0.0f, 1.0f } });
+
+	const ModelCacheKey key{
+		.sourcePath		= (s_rootPath / "Grid.obj").string(),
+		.sourceSize		= 1,
+		.components		= VertexComponent::PositionNormalTexcoord,
+		.vertexStride	= s_vertexStride };
+	const string filename = GetModelCacheFilename(key);
+
+	// Cold: the cooked model is serialized and written, which is what a cache miss adds on top of the import
+	bool written = true;
+	const double coldMs = MeasureMs(numRuns, [&] { written = written && WriteModelCache(filename, key, model); });
+	Check(written, "the cache file is written");
+
+	// Warm: map and validate.  The file was just written, so it is in the OS file cache, and this measures the
+	// engine's own cost.
+	size_t numLoaded = 0;
+	const double headerMs = MeasureMs(numRuns, [&] { numLoaded += LoadFromCache(filename, key, ModelCacheValidation::Header); });
+	const double fullMs = MeasureMs(numRuns, [&] { numLoaded += LoadFromCache(filename, key, ModelCacheValidation::Full); });
+	Check(numLoaded == 2 * max(numRuns, 1u), "every warm load reads the model back");
+
+	const double fileMB = (double)filesystem::file_size(filename) / (1024.0 * 1024.0);
+
+	printf("Model cache benchmark, %ux%u grid, %u vertices, %u indices, %.1f MB cache file, fastest of %u runs\n\n",
+		gridSize, gridSize, gridSize * gridSize, (uint32_t)mesh.indices.size(), fileMB, numRuns);
+	printf("%-34s %12s\n", "Load", "Time");
+	printf("%-34s %10.3fms\n", "Cold, serialize and write", coldMs);
+	printf("%-34s %10.3fms\n", "Warm, header validation", headerMs);
+	printf("%-34s %10.3fms\n", "Warm, full index validation", fullMs);
+
+	filesystem::remove_all(s_rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
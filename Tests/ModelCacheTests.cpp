@@ -0,0 +1,409 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FileSystem.h"
+#include "MappedFile.h"
+#include "Graphics/Loaders/ModelCache.h"
+
+#include "Benchmark.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+const filesystem::path s_rootPath = filesystem::temp_directory_path() / "LunaModelCacheTests";
+
+const VertexComponent s_components = VertexComponent::PositionNormalTexcoord;
+const uint32_t s_vertexStride = 32;
+const uint32_t s_positionStride = 12;
+
+
+// The streams behind one synthetic mesh: a square grid, with a second LOD that skips every other row and column
+struct SyntheticMesh
+{
+	string name;
+	vector<std::byte> vertexData;
+	vector<std::byte> vertexDataPositionOnly;
+	vector<std::byte> indexData;
+	vector<MeshPart> meshParts;
+	vector<CookedMeshLod> lods;
+};
+
+
+template <typename TIndex>
+void AppendGridIndices(uint32_t gridSize, uint32_t step, vector<std::byte>& indexData)
+{
+	for (uint32_t y = 0; y + step < gridSize; y += step)
+	{
+		for (uint32_t x = 0; x + step < gridSize; x += step)
+		{
+			const TIndex i0 = (TIndex)(y * gridSize + x);
+			const TIndex i1 = (TIndex)(i0 + step);
+			const TIndex i2 = (TIndex)(i0 + step * gridSize);
+			const TIndex i3 = (TIndex)(i2 + step);
+			for (TIndex index : { i0, i2, i1, i1, i2, i3 })
+			{
+				const auto bytes = as_bytes(span{ &index, 1 });
+				indexData.insert(indexData.end(), bytes.begin(), bytes.end());
+			}
+		}
+	}
+}
+
+
+void MakeSyntheticMesh(const string& name, uint32_t gridSize, uint32_t indexSize, SyntheticMesh& outMesh)
+{
+	outMesh.name = name;
+
+	const uint32_t numVertices = gridSize * gridSize;
+	vector<float> vertices;
+	vector<float> positions;
+	vertices.reserve(numVertices * s_vertexStride / sizeof(float));
+	for (uint32_t y = 0; y < gridSize; ++y)
+	{
+		for (uint32_t x = 0; x < gridSize; ++x)
+		{
+			const float u = (float)x / (float)(gridSize - 1);
+			const float v = (float)y / (float)(gridSize - 1);
+			vertices.insert(vertices.end(), { u, 0.0f, v, 0.0f, 1.0f, 0.0f, u, v });
+			positions.insert(positions.end(), { u, 0.0f, v });
+		}
+	}
+	const auto vertexBytes = as_bytes(span{ vertices });
+	const auto positionBytes = as_bytes(span{ positions });
+	outMesh.vertexData.assign(vertexBytes.begin(), vertexBytes.end());
+	outMesh.vertexDataPositionOnly.assign(positionBytes.begin(), positionBytes.end());
+
+	for (uint32_t step : { 1u, 2u })
+	{
+		const uint32_t indexBase = (uint32_t)(outMesh.indexData.size() / indexSize);
+		if (indexSize == sizeof(uint16_t))
+		{
+			AppendGridIndices<uint16_t>(gridSize, step, outMesh.indexData);
+		}
+		else
+		{
+			AppendGridIndices<uint32_t>(gridSize, step, outMesh.indexData);
+		}
+		const uint32_t indexCount = (uint32_t)(outMesh.indexData.size() / indexSize) - indexBase;
+
+		outMesh.lods.push_back(CookedMeshLod{ .meshPartOffset = (uint32_t)outMesh.meshParts.size(), .meshPartCount = 1, .error = 0.25f * (float)(step - 1) });
+		outMesh.meshParts.push_back(MeshPart{ .vertexBase = 0, .vertexCount = numVertices, .indexBase = indexBase, .indexCount = indexCount });
+	}
+}
+
+
+CookedMesh MakeCookedMesh(const SyntheticMesh& mesh, int materialIndex, uint32_t indexSize)
+{
+	CookedMesh cookedMesh{
+		.name					= mesh.name,
+		.materialIndex			= materialIndex,
+		.vertexStride			= s_vertexStride,
+		.indexSize				= indexSize,
+		.vertexData				= mesh.vertexData,
+		.vertexDataPositionOnly = mesh.vertexDataPositionOnly,
+		.indexData				= mesh.indexData,
+		.meshParts				= mesh.meshParts,
+		.lods					= mesh.lods,
+		.boundsMin				= { 0.0f, 0.0f, 0.0f },
+		.boundsMax				= { 1.0f, 0.0f, 1.0f }
+	};
+	cookedMesh.decodeParams.texcoordScaleOffset[2] = 0.5f;
+	return cookedMesh;
+}
+
+
+// Two meshes, one with 16-bit and one with 32-bit indices, and two materials
+struct SyntheticModel
+{
+	SyntheticMesh meshes[2];
+	CookedModel model;
+
+	explicit SyntheticModel(uint32_t gridSize)
+	{
+		MakeSyntheticMesh("Floor", gridSize, sizeof(uint16_t), meshes[0]);
+		MakeSyntheticMesh("Ceiling", gridSize, sizeof(uint32_t), meshes[1]);
+
+		model.meshes.push_back(MakeCookedMesh(meshes[0], 0, sizeof(uint16_t)));
+		model.meshes.push_back(MakeCookedMesh(meshes[1], 1, sizeof(uint32_t)));
+
+		model.materials.push_back(CookedMaterial{ .diffuseColor = { 0.5f, 0.25f, 0.125f, 1.0f }, .diffuseTexture = "Floor.png", .normalTexture = "Floor_normal.png" });
+		model.materials.push_back(CookedMaterial{ .diffuseTexture = "Ceiling.png" });
+	}
+};
+
+
+ModelCacheKey MakeKey()
+{
+	return ModelCacheKey{
+		.sourcePath			= (s_rootPath / "Models" / "Room.obj").string(),
+		.sourceSize			= 123456,
+		.sourceWriteTime	= 987654321,
+		.loadFlags			= ModelLoad::StandardDefault,
+		.scale				= 1.0f,
+		.components			= s_components,
+		.encoding			= VertexEncoding::None,
+		.vertexStride		= s_vertexStride,
+		.loadMaterials		= true
+	};
+}
+
+
+template <typename T>
+bool SameElements(span<const T> a, span<const T> b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size_bytes()) == 0);
+}
+
+
+bool SameModel(const CookedModel& a, const CookedModel& b)
+{
+	if (a.meshes.size() != b.meshes.size() || a.materials.size() != b.materials.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < a.meshes.size(); ++i)
+	{
+		const CookedMesh& meshA = a.meshes[i];
+		const CookedMesh& meshB = b.meshes[i];
+		if (meshA.name != meshB.name ||
+			meshA.materialIndex != meshB.materialIndex ||
+			meshA.vertexStride != meshB.vertexStride ||
+			meshA.indexSize != meshB.indexSize ||
+			!SameElements(meshA.vertexData, meshB.vertexData) ||
+			!SameElements(meshA.vertexDataPositionOnly, meshB.vertexDataPositionOnly) ||
+			!SameElements(meshA.indexData, meshB.indexData) ||
+			!SameElements(meshA.meshParts, meshB.meshParts) ||
+			!SameElements(meshA.lods, meshB.lods) ||
+			memcmp(meshA.boundsMin, meshB.boundsMin, sizeof(meshA.boundsMin)) != 0 ||
+			memcmp(meshA.boundsMax, meshB.boundsMax, sizeof(meshA.boundsMax)) != 0 ||
+			memcmp(&meshA.decodeParams, &meshB.decodeParams, sizeof(VertexDecodeParams)) != 0)
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < a.materials.size(); ++i)
+	{
+		const CookedMaterial& materialA = a.materials[i];
+		const CookedMaterial& materialB = b.materials[i];
+		if (memcmp(materialA.diffuseColor, materialB.diffuseColor, sizeof(materialA.diffuseColor)) != 0 ||
+			materialA.diffuseTexture != materialB.diffuseTexture ||
+			materialA.normalTexture != materialB.normalTexture)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool CanRead(span<const std::byte> data, const ModelCacheKey& key, ModelCacheValidation validation)
+{
+	CookedModel model;
+	return ReadModelCache(data, key, validation, model);
+}
+
+
+void TestRoundTrip()
+{
+	const SyntheticModel synthetic{ 17 };
+	const ModelCacheKey key = MakeKey();
+
+	vector<std::byte> data;
+	Check(BuildModelCache(key, synthetic.model, data), "a valid model is serialized");
+
+	for (auto validation : { ModelCacheValidation::Header, ModelCacheValidation::Full })
+	{
+		CookedModel model;
+		Check(ReadModelCache(data, key, validation, model), "a cache file reads back");
+		Check(SameModel(model, synthetic.model), "a cache file reads back the model it was built from");
+
+		const bool pointsIntoData = !model.meshes.empty() &&
+			model.meshes[0].indexData.data() >= data.data() && model.meshes[0].indexData.data() < data.data() + data.size();
+		Check(pointsIntoData, "the streams read back point into the file, rather than being copied");
+	}
+
+	CookedModel empty;
+	Check(BuildModelCache(key, CookedModel{}, data) && ReadModelCache(data, key, ModelCacheValidation::Full, empty) && empty.meshes.empty(),
+		"a model without meshes round trips");
+}
+
+
+void TestTruncated()
+{
+	const SyntheticModel synthetic{ 9 };
+	const ModelCacheKey key = MakeKey();
+
+	vector<std::byte> data;
+	Check(BuildModelCache(key, synthetic.model, data), "a valid model is serialized");
+
+	bool allRejected = true;
+	for (size_t size = 0; size < data.size(); ++size)
+	{
+		allRejected = allRejected && !CanRead(span{ data }.first(size), key, ModelCacheValidation::Header);
+	}
+	Check(allRejected, "every truncation of a cache file is rejected");
+
+	vector<std::byte> extended = data;
+	extended.resize(data.size() + 16);
+	Check(!CanRead(extended, key, ModelCacheValidation::Header), "a cache file with trailing bytes is rejected");
+}
+
+
+void TestCorrupt()
+{
+	const SyntheticModel synthetic{ 9 };
+	const ModelCacheKey key = MakeKey();
+
+	vector<std::byte> data;
+	Check(BuildModelCache(key, synthetic.model, data), "a valid model is serialized");
+
+	// Everything ahead of the first stream is header, tables, strings, mesh parts and LODs, so must be checked
+	const CookedModel& model = synthetic.model;
+	CookedModel readBack;
+	Check(ReadModelCache(data, key, ModelCacheValidation::Header, readBack), "the cache file reads back");
+	const size_t metadataSize = (size_t)(readBack.meshes[0].vertexData.data() - data.data());
+
+	uint32_t numAccepted = 0;
+	for (size_t i = 0; i < metadataSize; ++i)
+	{
+		for (uint8_t flip : { (uint8_t)0x01, (uint8_t)0x80 })
+		{
+			vector<std::byte> corrupt = data;
+			corrupt[i] ^= (std::byte)flip;
+			numAccepted += CanRead(corrupt, key, ModelCacheValidation::Header) ? 1 : 0;
+		}
+	}
+	Check(numAccepted == 0, "a flipped bit anywhere in the header, tables, strings, mesh parts or LODs is rejected");
+
+	// An index past the end of the vertex buffer is only caught by the full check, which reads the streams
+	vector<std::byte> badIndex = data;
+	const size_t indexOffset = (size_t)(readBack.meshes[1].indexData.data() - data.data());
+	const uint32_t outOfRange = (uint32_t)(model.meshes[1].vertexData.size() / s_vertexStride);
+	memcpy(badIndex.data() + indexOffset, &outOfRange, sizeof(outOfRange));
+	Check(!CanRead(badIndex, key, ModelCacheValidation::Full), "the full check rejects an index past the end of the vertex buffer");
+	Check(CanRead(badIndex, key, ModelCacheValidation::Header), "the header check trusts the streams");
+
+	vector<std::byte> lastIndex = data;
+	const uint32_t inRange = outOfRange - 1;
+	memcpy(lastIndex.data() + indexOffset, &inRange, sizeof(inRange));
+	Check(CanRead(lastIndex, key, ModelCacheValidation::Full), "the full check accepts an index to the last vertex");
+}
+
+
+void TestStale()
+{
+	const SyntheticModel synthetic{ 5 };
+	const ModelCacheKey key = MakeKey();
+
+	vector<std::byte> data;
+	Check(BuildModelCache(key, synthetic.model, data), "a valid model is serialized");
+	Check(CanRead(data, key, ModelCacheValidation::Header), "a cache file reads back with its own key");
+
+	vector<pair<const char*, function<void(ModelCacheKey&)>>> changes{
+		{ "source path",		[](ModelCacheKey& k) { k.sourcePath += "x"; } },
+		{ "source size",		[](ModelCacheKey& k) { k.sourceSize += 1; } },
+		{ "source write time",	[](ModelCacheKey& k) { k.sourceWriteTime += 1; } },
+		{ "load flags",			[](ModelCacheKey& k) { k.loadFlags = k.loadFlags | ModelLoad::GenerateLods; } },
+		{ "scale",				[](ModelCacheKey& k) { k.scale = 2.0f; } },
+		{ "components",			[](ModelCacheKey& k) { k.components = VertexComponent::PositionNormal; } },
+		{ "encoding",			[](ModelCacheKey& k) { k.encoding = VertexEncoding::Compact; } },
+		{ "vertex stride",		[](ModelCacheKey& k) { k.vertexStride = 24; } },
+		{ "load materials",		[](ModelCacheKey& k) { k.loadMaterials = false; } }
+	};
+
+	for (const auto& [what, change] : changes)
+	{
+		ModelCacheKey staleKey = key;
+		change(staleKey);
+		if (CanRead(data, staleKey, ModelCacheValidation::Full))
+		{
+			fprintf(stderr, "a changed %s was not rejected\n", what);
+			Check(false, "a cache file is rejected when any part of its key changes");
+		}
+		Check(staleKey.GetHash() != key.GetHash(), "every part of the key changes the cache filename");
+	}
+}
+
+
+void TestBadModels()
+{
+	const ModelCacheKey key = MakeKey();
+	vector<std::byte> data;
+
+	auto rejects = [&](const char* what, function<void(SyntheticMesh&, CookedMesh&)> change)
+		{
+			SyntheticModel synthetic{ 5 };
+			change(synthetic.meshes[1], synthetic.model.meshes[1]);
+			Check(!BuildModelCache(key, synthetic.model, data), what);
+		};
+
+	rejects("a mesh part past the end of the index stream is not written", [](SyntheticMesh& mesh, CookedMesh&) { mesh.meshParts[1].indexCount += 1; });
+	rejects("a LOD past the end of the mesh parts is not written", [](SyntheticMesh& mesh, CookedMesh&) { mesh.lods[1].meshPartCount = 2; });
+	rejects("an index past the end of the vertex buffer is not written", [](SyntheticMesh& mesh, CookedMesh&) { mesh.meshParts[0].vertexBase = 1; });
+	rejects("an index size other than 16 or 32 bits is not written", [](SyntheticMesh&, CookedMesh& cookedMesh) { cookedMesh.indexSize = 1; });
+}
+
+
+void TestWriteAndMap()
+{
+	const SyntheticModel synthetic{ 33 };
+	const ModelCacheKey key = MakeKey();
+
+	const string filename = GetModelCacheFilename(key);
+	const filesystem::path filenamePath{ filename };
+	Check(filenamePath.parent_path() == GetFileSystem()->GetCachePath(), "cache files go in the cache directory");
+	Check(filenamePath.extension() == ".lmc" && filenamePath.stem().string().size() == string("Room.").size() + 16
+		&& filenamePath.stem().string().starts_with("Room."), "cache files are named after the source, its hash, and .lmc");
+
+	Check(WriteModelCache(filename, key, synthetic.model), "a cache file is written");
+
+	MappedFile cacheFile;
+	Check(cacheFile.Open(filename), "a cache file is mapped");
+
+	CookedModel model;
+	Check(ReadModelCache(cacheFile, key, ModelCacheValidation::Full, model) && SameModel(model, synthetic.model),
+		"a mapped cache file reads back the model it was written from");
+
+	MappedFile closed;
+	Check(!ReadModelCache(closed, key, ModelCacheValidation::Header, model), "a file that is not open is rejected");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	filesystem::remove_all(s_rootPath);
+	filesystem::create_directories(s_rootPath);
+
+	FileSystem fileSystem{ "LunaModelCacheTests" };
+	fileSystem.SetRootPath(s_rootPath);
+
+	TestRoundTrip();
+	TestTruncated();
+	TestCorrupt();
+	TestStale();
+	TestBadModels();
+	TestWriteAndMap();
+
+	filesystem::remove_all(s_rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Core/CpuFeatures.h"
+#include "Graphics/OcclusionCuller.h"
+
+#include "Benchmark.h"
+#include "FrustumCullingData.h"
+#include "OcclusionCullerData.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace Luna::Tests;
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+struct PathResult
+{
+	double occluderMs{ 0.0 };
+	double occludeeMs{ 0.0 };
+	uint64_t numRasterizedTriangles{ 0 };
+	vector<float> depthBuffer;
+	vector<uint64_t> visibleMask;
+};
+
+
+// The occluder pass, from BeginFrame() through RasterizeOccluders(), and then the occludee pass
+PathResult RunPath(BatchPath path, const Matrix& viewProjection, const vector<Mesh>& occluders, const BoundingBoxSoA& occludees, uint32_t numRuns)
+{
+	OcclusionCuller culler{ OcclusionCullerDesc{ .path = path } };
+	const Matrix identity = MakeTranslation(0.0f, 0.0f, 0.0f);
+
+	PathResult result;
+	result.occluderMs = MeasureMs(numRuns, [&]
+		{
+			culler.BeginFrame(viewProjection.data());
+			for (const auto& occluder : occluders)
+			{
+				culler.AddOccluder(identity.data(), occluder.positions, 3, occluder.indices);
+			}
+			culler.RasterizeOccluders();
+		});
+
+	result.visibleMask.resize((occludees.GetCount() + 63) / 64);
+	result.occludeeMs = MeasureMs(numRuns, [&]
+		{
+			fill(result.visibleMask.begin(), result.visibleMask.end(), ~0ull);
+			culler.CullBoundingBoxes(occludees, result.visibleMask);
+		});
+
+	result.numRasterizedTriangles = culler.GetStats().numRasterizedTriangles;
+	result.depthBuffer.assign(culler.GetDepthBuffer().begin(), culler.GetDepthBuffer().end());
+	return result;
+}
+
+
+const char* GetPathName(BatchPath path)
+{
+	switch (path)
+	{
+	case BatchPath::Scalar: return "Scalar";
+	case BatchPath::SSE: return "SSE";
+	case BatchPath::AVX: return "AVX";
+	default: return "Best";
+	}
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numBuildings = commandLine.Size(2000, 100);
+	const uint32_t numOccludees = commandLine.Size(1000000, 10000);
+	const uint32_t numRuns = commandLine.Size(10, 1);
+
+	mt19937 rng{ 1234 };
+	const vector<Mesh> occluders = MakeCity(numBuildings, rng);
+	const BoxArrays boxArrays = MakeBoxes(numOccludees, 150.0f, rng);
+	const BoundingBoxSoA occludees = boxArrays.GetSoA(numOccludees);
+
+	const float position[3] = { 0.0f, 6.0f, 10.0f };
+	const Matrix viewProjection = MakeViewProjection(1.0f, 16.0f / 9.0f, 0.5f, 300.0f, false, 0.1f, position);
+
+	uint64_t numTriangles = 0;
+	for (const auto& occluder : occluders)
+	{
+		numTriangles += occluder.indices.size() / 3;
+	}
+
+	vector<BatchPath> paths{ BatchPath::Scalar, BatchPath::SSE };
+	if (HasAVX())
+	{
+		paths.push_back(BatchPath::AVX);
+	}
+
+	printf("Occlusion culling benchmark, %llu occluder triangles, %u occludees, 320x192, fastest of %u runs\n\n",
+		(unsigned long long)numTriangles, numOccludees, numRuns);
+	printf("%-12s %28s %28s\n", "Path", "Occluders", "Occludees");
+
+	PathResult scalar;
+	auto report = [&](const char* name, const PathResult& result)
+		{
+			printf("%-12s %9.2f ms %9.0f tris/ms %9.2f ms %9.0f boxes/ms\n", name,
+				result.occluderMs, numTriangles / result.occluderMs,
+				result.occludeeMs, numOccludees / result.occludeeMs);
+
+			Check(result.depthBuffer == scalar.depthBuffer, "every path writes the same depths as the scalar path");
+			Check(result.visibleMask == scalar.visibleMask, "every path culls the same occludees as the scalar path");
+		};
+
+	for (BatchPath path : paths)
+	{
+		PathResult result = RunPath(path, viewProjection, occluders, occludees, numRuns);
+		if (path == BatchPath::Scalar)
+		{
+			scalar = result;
+		}
+		report(GetPathName(path), result);
+	}
+
+	// Screen regions and occludee words are spread over the workers
+	const uint32_t numThreads = max(thread::hardware_concurrency(), 2u);
+	{
+		JobSystem jobSystem{ numThreads - 1 };
+
+		char name[32];
+		snprintf(name, sizeof(name), "Best, %u thr", numThreads);
+		report(name, RunPath(BatchPath::Best, viewProjection, occluders, occludees, numRuns));
+	}
+
+	uint64_t numVisible = 0;
+	for (uint64_t word : scalar.visibleMask)
+	{
+		numVisible += popcount(word);
+	}
+
+	printf("\n%llu of %llu triangles rasterized after culling and clipping, %.1f%% of occludees visible\n",
+		(unsigned long long)scalar.numRasterizedTriangles, (unsigned long long)numTriangles, 100.0 * numVisible / numOccludees);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
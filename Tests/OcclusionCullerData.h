@@ -0,0 +1,145 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#pragma once
+
+// Cameras and scenes shared by the occlusion culling tests and benchmark, in plain floats.  Matrices are four
+// rows of four, laid out like Math::Matrix4, and transform row vectors.
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+namespace Luna::Tests
+{
+
+using Matrix = std::array<float, 16>;
+
+
+// a * b, so that a row vector is transformed by a and then by b
+inline Matrix Multiply(const Matrix& a, const Matrix& b)
+{
+	Matrix result{};
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			result[4 * r + c] = a[4 * r] * b[c] + a[4 * r + 1] * b[4 + c] + a[4 * r + 2] * b[8 + c] + a[4 * r + 3] * b[12 + c];
+		}
+	}
+	return result;
+}
+
+
+inline Matrix MakeTranslation(float x, float y, float z)
+{
+	return Matrix{ 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f };
+}
+
+
+// A right-handed perspective camera looking down -Z, like Camera::SetPerspectiveMatrix(), rotated about Y and
+// moved to position.  Reverse Z swaps the near and far planes, so depth is 1 at the near plane.
+inline Matrix MakeViewProjection(float verticalFov, float aspect, float nearClip, float farClip, bool reverseZ, float yaw, const float position[3])
+{
+	const float yScale = 1.0f / tanf(0.5f * verticalFov);
+	const float xScale = yScale / aspect;
+	const float n = reverseZ ? farClip : nearClip;
+	const float f = reverseZ ? nearClip : farClip;
+	const float range = f / (n - f);
+
+	const Matrix projection{
+		xScale, 0.0f, 0.0f, 0.0f,
+		0.0f, yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, range, -1.0f,
+		0.0f, 0.0f, range * n, 0.0f };
+
+	// The inverse of the camera's rotation
+	const float cosYaw = cosf(yaw);
+	const float sinYaw = sinf(yaw);
+	const Matrix rotation{
+		cosYaw, 0.0f, sinYaw, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		-sinYaw, 0.0f, cosYaw, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f };
+
+	return Multiply(Multiply(MakeTranslation(-position[0], -position[1], -position[2]), rotation), projection);
+}
+
+
+// An indexed triangle list of three-float positions
+struct Mesh
+{
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+
+	void AddTriangle(const float* p0, const float* p1, const float* p2)
+	{
+		const uint32_t first = (uint32_t)positions.size() / 3;
+		positions.insert(positions.end(), p0, p0 + 3);
+		positions.insert(positions.end(), p1, p1 + 3);
+		positions.insert(positions.end(), p2, p2 + 3);
+		indices.insert(indices.end(), { first, first + 1, first + 2 });
+	}
+};
+
+
+// A closed box, with its faces wound clockwise seen from outside, which is front facing with the default
+// rasterizer state of OcclusionCullerDesc
+inline Mesh MakeBox(const float boxMin[3], const float boxMax[3])
+{
+	Mesh mesh;
+	for (int i = 0; i < 8; ++i)
+	{
+		mesh.positions.push_back((i & 1) ? boxMax[0] : boxMin[0]);
+		mesh.positions.push_back((i & 2) ? boxMax[1] : boxMin[1]);
+		mesh.positions.push_back((i & 4) ? boxMax[2] : boxMin[2]);
+	}
+
+	mesh.indices = {
+		0, 6, 4, 0, 2, 6,	// -X
+		1, 7, 3, 1, 5, 7,	// +X
+		0, 5, 1, 0, 4, 5,	// -Y
+		2, 7, 6, 2, 3, 7,	// +Y
+		0, 3, 2, 0, 1, 3,	// -Z
+		4, 7, 5, 4, 6, 7	// +Z
+	};
+	return mesh;
+}
+
+
+// Boxes on a grid in front of a camera at the origin looking down -Z, standing on y = 0.  Walls and blocks of
+// different sizes, like a city, so the nearer ones hide many of the farther ones.
+inline std::vector<Mesh> MakeCity(uint32_t numBuildings, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> position{ -60.0f, 60.0f };
+	std::uniform_real_distribution<float> depth{ 5.0f, 150.0f };
+	std::uniform_real_distribution<float> size{ 1.0f, 8.0f };
+	std::uniform_real_distribution<float> height{ 2.0f, 20.0f };
+
+	std::vector<Mesh> buildings;
+	for (uint32_t i = 0; i < numBuildings; ++i)
+	{
+		const float x = position(rng);
+		const float z = -depth(rng);
+		const float halfWidth = size(rng);
+		const float halfDepth = size(rng);
+
+		const float boxMin[3] = { x - halfWidth, -2.0f, z - halfDepth };
+		const float boxMax[3] = { x + halfWidth, height(rng), z + halfDepth };
+		buildings.push_back(MakeBox(boxMin, boxMax));
+	}
+	return buildings;
+}
+
+} // namespace Luna::Tests
@@ -0,0 +1,622 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Core/CpuFeatures.h"
+#include "Graphics/OcclusionCuller.h"
+
+#include "Benchmark.h"
+#include "FrustumCullingData.h"
+#include "OcclusionCullerData.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace Luna::Tests;
+using namespace Math;
+using namespace std;
+
+
+namespace
+{
+
+constexpr float s_clearDepth = numeric_limits<float>::max();
+
+// How close to an edge, the near plane, or a pixel boundary a reference result may be and still count.  Closer
+// than this, rounding decides the answer, so the reference doesn't check it.
+constexpr double s_edgeTolerance = 2.0e-4;
+constexpr double s_pixelTolerance = 1.0e-3;
+constexpr double s_depthTolerance = 1.0e-5;
+
+
+// An occluder triangle in clip space, in double precision
+struct ClipTriangle
+{
+	double v[3][4];
+};
+
+
+void TransformToClip(const Matrix& viewProjection, const float* position, double* outClip)
+{
+	for (int c = 0; c < 4; ++c)
+	{
+		outClip[c] = (double)position[0] * viewProjection[c] + (double)position[1] * viewProjection[4 + c] + (double)position[2] * viewProjection[8 + c] + viewProjection[12 + c];
+	}
+}
+
+
+vector<ClipTriangle> GetClipTriangles(const Matrix& viewProjection, const vector<Mesh>& meshes)
+{
+	vector<ClipTriangle> triangles;
+	for (const auto& mesh : meshes)
+	{
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			ClipTriangle triangle;
+			for (int j = 0; j < 3; ++j)
+			{
+				TransformToClip(viewProjection, &mesh.positions[3 * mesh.indices[i + j]], triangle.v[j]);
+			}
+			triangles.push_back(triangle);
+		}
+	}
+	return triangles;
+}
+
+
+double Determinant(double a0, double a1, double a2, double b0, double b1, double b2, double c0, double c1, double c2)
+{
+	return a0 * (b1 * c2 - b2 * c1) - a1 * (b0 * c2 - b2 * c0) + a2 * (b0 * c1 - b1 * c0);
+}
+
+
+enum class Coverage
+{
+	Outside,
+	Inside,
+	Unsure
+};
+
+
+// Brute force, one pixel and one triangle at a time, in homogeneous coordinates, so that the near plane needs
+// no clipping.  The point of the triangle under the pixel center has barycentric coordinates b, with
+// sum(b * (x - ndcX * w)) = 0, sum(b * (y - ndcY * w)) = 0 and sum(b) = 1.
+Coverage ReferenceCoverage(const OcclusionCullerDesc& desc, const ClipTriangle& triangle, double ndcX, double ndcY, double& outDepth)
+{
+	const double(&v)[3][4] = triangle.v;
+
+	// Facing, from the side of the triangle's plane the eye is on.  Positive screen area, with Y down, is clockwise.
+	const double facing = -Determinant(v[0][0], v[0][1], v[0][3], v[1][0], v[1][1], v[1][3], v[2][0], v[2][1], v[2][3]);
+	if (facing == 0.0)
+	{
+		return Coverage::Outside;
+	}
+	const bool isFrontFace = desc.frontCounterClockwise ? facing < 0.0 : facing > 0.0;
+	if ((desc.cullMode == CullMode::Back && !isFrontFace) || (desc.cullMode == CullMode::Front && isFrontFace))
+	{
+		return Coverage::Outside;
+	}
+
+	double rowX[3], rowY[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		rowX[i] = v[i][0] - ndcX * v[i][3];
+		rowY[i] = v[i][1] - ndcY * v[i][3];
+	}
+
+	// Cramer's rule
+	const double det = Determinant(rowX[0], rowX[1], rowX[2], rowY[0], rowY[1], rowY[2], 1.0, 1.0, 1.0);
+	if (fabs(det) < 1.0e-12)
+	{
+		return Coverage::Unsure;
+	}
+
+	const double b[3] = {
+		Determinant(0.0, rowX[1], rowX[2], 0.0, rowY[1], rowY[2], 1.0, 1.0, 1.0) / det,
+		Determinant(rowX[0], 0.0, rowX[2], rowY[0], 0.0, rowY[2], 1.0, 1.0, 1.0) / det,
+		Determinant(rowX[0], rowX[1], 0.0, rowY[0], rowY[1], 0.0, 1.0, 1.0, 1.0) / det
+	};
+
+	double w = 0.0, z = 0.0, nearDistance = 0.0, nearScale = 0.0;
+	for (int i = 0; i < 3; ++i)
+	{
+		const double vertexNear = desc.reverseZ ? v[i][3] - v[i][2] : v[i][2];
+		w += b[i] * v[i][3];
+		z += b[i] * v[i][2];
+		nearDistance += b[i] * vertexNear;
+		nearScale = max(nearScale, fabs(vertexNear));
+	}
+
+	// Behind the eye, the pixel's ray doesn't reach the triangle at all
+	if (w <= 0.0)
+	{
+		return Coverage::Outside;
+	}
+
+	const double minB = min({ b[0], b[1], b[2] });
+	if (minB < -s_edgeTolerance || nearDistance < -s_edgeTolerance * nearScale)
+	{
+		return Coverage::Outside;
+	}
+
+	outDepth = (desc.reverseZ ? -z : z) / w;
+	return (minB > s_edgeTolerance && nearDistance > s_edgeTolerance * nearScale) ? Coverage::Inside : Coverage::Unsure;
+}
+
+
+void RasterizeScene(OcclusionCuller& culler, const Matrix& viewProjection, const vector<Mesh>& meshes)
+{
+	culler.BeginFrame(viewProjection.data());
+
+	// Half of the meshes are moved into place by their world matrix, and the other half are already there
+	const Matrix offset = MakeTranslation(1.5f, -0.5f, 2.0f);
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		if (i % 2 == 0)
+		{
+			culler.AddOccluder(MakeTranslation(0.0f, 0.0f, 0.0f).data(), meshes[i].positions, 3, meshes[i].indices);
+		}
+		else
+		{
+			vector<float> positions = meshes[i].positions;
+			for (size_t j = 0; j < positions.size(); j += 3)
+			{
+				positions[j] -= offset[12];
+				positions[j + 1] -= offset[13];
+				positions[j + 2] -= offset[14];
+			}
+			culler.AddOccluder(offset.data(), positions, 3, meshes[i].indices);
+		}
+	}
+
+	culler.RasterizeOccluders();
+}
+
+
+// Compares every pixel with the brute force reference, other than those that rounding decides
+void CheckDepthBuffer(const char* what, const OcclusionCullerDesc& desc, const Matrix& viewProjection, const vector<Mesh>& meshes)
+{
+	OcclusionCuller culler{ desc };
+	RasterizeScene(culler, viewProjection, meshes);
+	const vector<ClipTriangle> triangles = GetClipTriangles(viewProjection, meshes);
+
+	const uint32_t width = culler.GetWidth();
+	const uint32_t height = culler.GetHeight();
+	const auto depthBuffer = culler.GetDepthBuffer();
+
+	uint32_t numCovered = 0;
+	uint32_t numUnsure = 0;
+	uint32_t numWrong = 0;
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const double ndcX = ((double)x + 0.5) / width * 2.0 - 1.0;
+			const double ndcY = 1.0 - ((double)y + 0.5) / height * 2.0;
+
+			double nearestInside = s_clearDepth;
+			double nearestUnsure = s_clearDepth;
+			for (const auto& triangle : triangles)
+			{
+				double depth = 0.0;
+				const Coverage coverage = ReferenceCoverage(desc, triangle, ndcX, ndcY, depth);
+				if (coverage == Coverage::Inside)
+				{
+					nearestInside = min(nearestInside, depth);
+				}
+				else if (coverage == Coverage::Unsure)
+				{
+					nearestUnsure = min(nearestUnsure, depth);
+				}
+			}
+
+			// A triangle that may or may not cover the pixel only matters when it would be in front
+			if (nearestUnsure != s_clearDepth && nearestUnsure <= nearestInside + s_depthTolerance)
+			{
+				++numUnsure;
+				continue;
+			}
+
+			const float depth = depthBuffer[(size_t)y * width + x];
+			const bool isCorrect = nearestInside == s_clearDepth ? depth == s_clearDepth : fabs(depth - nearestInside) <= s_depthTolerance;
+			numCovered += nearestInside == s_clearDepth ? 0 : 1;
+			numWrong += isCorrect ? 0 : 1;
+		}
+	}
+
+	if (numWrong != 0 || numUnsure * 20 > width * height)
+	{
+		fprintf(stderr, "%s: %u of %u pixels wrong, %u too close to call\n", what, numWrong, width * height, numUnsure);
+	}
+	Check(numWrong == 0, "rasterized depth matches the brute force reference");
+	Check(numUnsure * 20 <= width * height, "few pixels are too close to the edges to check");
+	if (numCovered == 0)
+	{
+		fprintf(stderr, "%s: no pixels covered\n", what);
+	}
+	Check(numCovered > 0, "the occluders cover some pixels");
+}
+
+
+// Brute force, from the box's eight corners in double precision, against every pixel its screen rectangle
+// touches.  Sets outVisible and returns true when the answer doesn't depend on rounding.
+bool ReferenceIsVisible(const OcclusionCuller& culler, const OcclusionCullerDesc& desc, const Matrix& viewProjection, const float boxMin[3], const float boxMax[3], bool& outVisible)
+{
+	const double width = (double)culler.GetWidth();
+	const double height = (double)culler.GetHeight();
+
+	double minX = numeric_limits<double>::max(), minY = numeric_limits<double>::max(), minDepth = numeric_limits<double>::max();
+	double maxX = -numeric_limits<double>::max(), maxY = -numeric_limits<double>::max();
+	for (int i = 0; i < 8; ++i)
+	{
+		const float corner[3] = { (i & 1) ? boxMax[0] : boxMin[0], (i & 2) ? boxMax[1] : boxMin[1], (i & 4) ? boxMax[2] : boxMin[2] };
+		double clip[4];
+		TransformToClip(viewProjection, corner, clip);
+
+		// A box crossing the near plane always counts as visible
+		const double nearDistance = desc.reverseZ ? clip[3] - clip[2] : clip[2];
+		if (nearDistance < -s_edgeTolerance * fabs(clip[3]))
+		{
+			outVisible = true;
+			return true;
+		}
+		if (nearDistance <= s_edgeTolerance * fabs(clip[3]))
+		{
+			return false;
+		}
+
+		const double x = (clip[0] / clip[3] * 0.5 + 0.5) * width;
+		const double y = (0.5 - clip[1] / clip[3] * 0.5) * height;
+		minX = min(minX, x);
+		maxX = max(maxX, x);
+		minY = min(minY, y);
+		maxY = max(maxY, y);
+		minDepth = min(minDepth, (desc.reverseZ ? -clip[2] : clip[2]) / clip[3]);
+	}
+
+	// Is any pixel in the rectangle, grown or shrunk by the tolerances, at or behind the box?
+	const auto depthBuffer = culler.GetDepthBuffer();
+	auto anyPixelBehind = [&](double margin, double depthMargin)
+		{
+			const double x0 = max(floor(minX - margin), 0.0);
+			const double y0 = max(floor(minY - margin), 0.0);
+			const double x1 = min(floor(maxX + margin), width - 1.0);
+			const double y1 = min(floor(maxY + margin), height - 1.0);
+			if (minX - margin > maxX + margin || minY - margin > maxY + margin)
+			{
+				return false;
+			}
+
+			for (double y = y0; y <= y1; ++y)
+			{
+				for (double x = x0; x <= x1; ++x)
+				{
+					if ((double)depthBuffer[(size_t)y * (size_t)width + (size_t)x] >= minDepth + depthMargin)
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		};
+
+	const bool surelyVisible = anyPixelBehind(-s_pixelTolerance, s_depthTolerance);
+	const bool maybeVisible = anyPixelBehind(s_pixelTolerance, -s_depthTolerance);
+	outVisible = surelyVisible;
+	return surelyVisible == maybeVisible;
+}
+
+
+void CheckOccludees(const char* what, const OcclusionCullerDesc& desc, const Matrix& viewProjection, const vector<Mesh>& meshes, const BoxArrays& boxes, mt19937& rng)
+{
+	OcclusionCuller culler{ desc };
+	RasterizeScene(culler, viewProjection, meshes);
+
+	const size_t count = boxes.minX.size();
+	const BoundingBoxSoA boxSoA = boxes.GetSoA(count);
+
+	// Some boxes start out culled, as if by the frustum, and the bits past the last box must be left alone
+	vector<uint64_t> mask((count + 63) / 64 + 1, ~0ull);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (rng() % 8 == 0)
+		{
+			mask[i / 64] &= ~(1ull << (i % 64));
+		}
+	}
+	const vector<uint64_t> inputMask = mask;
+
+	culler.CullBoundingBoxes(boxSoA, mask);
+
+	uint32_t numTested = 0;
+	uint32_t numVisible = 0;
+	uint32_t numHidden = 0;
+	uint32_t numUnsure = 0;
+	uint32_t numWrong = 0;
+	bool skippedCulled = true;
+	bool matchesIsVisible = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const bool wasSet = (inputMask[i / 64] >> (i % 64)) & 1;
+		const bool isSet = (mask[i / 64] >> (i % 64)) & 1;
+
+		const float boxMin[3] = { boxes.minX[i], boxes.minY[i], boxes.minZ[i] };
+		const float boxMax[3] = { boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i] };
+		const bool isVisible = culler.IsVisible(boxMin, boxMax);
+
+		if (!wasSet)
+		{
+			skippedCulled = skippedCulled && !isSet;
+			continue;
+		}
+
+		++numTested;
+		numVisible += isSet ? 1 : 0;
+		numHidden += isVisible ? 0 : 1;
+		matchesIsVisible = matchesIsVisible && isSet == isVisible;
+
+		bool expected = false;
+		if (!ReferenceIsVisible(culler, desc, viewProjection, boxMin, boxMax, expected))
+		{
+			++numUnsure;
+			continue;
+		}
+		numWrong += isSet == expected ? 0 : 1;
+	}
+
+	bool keptOtherBits = true;
+	for (size_t i = count; i < mask.size() * 64; ++i)
+	{
+		keptOtherBits = keptOtherBits && ((mask[i / 64] >> (i % 64)) & 1);
+	}
+
+	const auto stats = culler.GetStats();
+
+	if (numWrong != 0 || numUnsure * 20 > numTested)
+	{
+		fprintf(stderr, "%s: %u of %u occludees wrong, %u too close to call\n", what, numWrong, numTested, numUnsure);
+	}
+	Check(numWrong == 0, "occludee visibility matches the brute force reference");
+	Check(numUnsure * 20 <= numTested, "few occludees are too close to call");
+	Check(skippedCulled, "occludees culled before the test stay culled");
+	Check(keptOtherBits, "bits past the last occludee are left alone");
+	Check(matchesIsVisible, "IsVisible() agrees with CullBoundingBoxes()");
+	Check(stats.numOccludeesTested == numTested && stats.numOccludeesVisible == numVisible, "stats count the occludees tested and visible");
+	Check(numHidden > 0 && numVisible > 0, "the scene hides some occludees and not others");
+}
+
+
+// Triangles scattered in front of the camera, some of them large, and some crossing the near plane or passing
+// behind the camera
+vector<Mesh> MakeRandomTriangles(uint32_t count, mt19937& rng)
+{
+	uniform_real_distribution<float> coordinate{ -12.0f, 12.0f };
+	uniform_real_distribution<float> depth{ -40.0f, 2.0f };
+	uniform_real_distribution<float> offset{ -3.0f, 3.0f };
+
+	vector<Mesh> meshes(4);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const float center[3] = { coordinate(rng), coordinate(rng), depth(rng) };
+		const float scale = (i % 8 == 0) ? 6.0f : 1.0f;
+
+		float p[3][3];
+		for (int j = 0; j < 3; ++j)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				p[j][c] = center[c] + scale * offset(rng);
+			}
+		}
+		meshes[i % meshes.size()].AddTriangle(p[0], p[1], p[2]);
+	}
+	return meshes;
+}
+
+
+// Small boxes just in front of and just behind the faces of the buildings toward the camera, where the test
+// comes down to the depths of single pixels and tiles
+BoxArrays MakeBoxesAroundFaces(const vector<Mesh>& buildings, size_t count, mt19937& rng)
+{
+	uniform_real_distribution<float> fraction{ 0.0f, 1.0f };
+	uniform_real_distribution<float> offset{ -1.0f, 1.0f };
+	uniform_real_distribution<float> size{ 0.05f, 1.0f };
+
+	BoxArrays boxes;
+	for (size_t i = 0; i < count; ++i)
+	{
+		// MakeBox() puts the min corner first and the max corner last
+		const auto& positions = buildings[i % buildings.size()].positions;
+		const float* boxMin = &positions[0];
+		const float* boxMax = &positions[21];
+
+		const float x = boxMin[0] + fraction(rng) * (boxMax[0] - boxMin[0]);
+		const float y = boxMin[1] + fraction(rng) * (boxMax[1] - boxMin[1]);
+		const float z = boxMax[2] + offset(rng);
+		const float halfSize = 0.5f * size(rng);
+
+		boxes.minX.push_back(x - halfSize);
+		boxes.minY.push_back(y - halfSize);
+		boxes.minZ.push_back(z - halfSize);
+		boxes.maxX.push_back(x + halfSize);
+		boxes.maxY.push_back(y + halfSize);
+		boxes.maxZ.push_back(z + halfSize);
+	}
+	return boxes;
+}
+
+
+OcclusionCullerDesc MakeDesc(uint32_t width, uint32_t height, bool reverseZ, CullMode cullMode, bool frontCounterClockwise, BatchPath path = BatchPath::Best)
+{
+	return OcclusionCullerDesc{
+		.width					= width,
+		.height					= height,
+		.reverseZ				= reverseZ,
+		.cullMode				= cullMode,
+		.frontCounterClockwise	= frontCounterClockwise,
+		.path					= path
+	};
+}
+
+
+void TestAgainstReference(mt19937& rng)
+{
+	const float position[3] = { 0.5f, 1.0f, 0.0f };
+	const CullMode cullModes[] = { CullMode::None, CullMode::Back, CullMode::Front };
+
+	for (uint32_t iteration = 0; iteration < 12; ++iteration)
+	{
+		const bool reverseZ = iteration % 2 == 1;
+		const CullMode cullMode = cullModes[(iteration / 2) % 3];
+		const bool frontCounterClockwise = iteration >= 6;
+
+		// Sizes that aren't whole tiles or bins, and an aspect ratio that isn't the screen's
+		const OcclusionCullerDesc desc = MakeDesc(150 + 7 * iteration, 90 + 5 * iteration, reverseZ, cullMode, frontCounterClockwise);
+		const Matrix viewProjection = MakeViewProjection(1.0f, 1.6f, 0.5f, 100.0f, reverseZ, 0.1f * (float)iteration - 0.5f, position);
+
+		char what[64];
+		snprintf(what, sizeof(what), "random triangles %u", iteration);
+
+		const int numFailures = FailureCount();
+		CheckDepthBuffer(what, desc, viewProjection, MakeRandomTriangles(60, rng));
+		if (FailureCount() > numFailures)
+		{
+			return;
+		}
+	}
+}
+
+
+void TestBoxOccluders(mt19937& rng)
+{
+	const float position[3] = { 0.0f, 6.0f, 10.0f };
+
+	for (bool reverseZ : { false, true })
+	{
+		const OcclusionCullerDesc desc = MakeDesc(256, 144, reverseZ, CullMode::Back, false);
+		const Matrix viewProjection = MakeViewProjection(1.0f, 16.0f / 9.0f, 0.5f, 300.0f, reverseZ, 0.1f, position);
+
+		const vector<Mesh> city = MakeCity(60, rng);
+		CheckDepthBuffer(reverseZ ? "city, reverse Z" : "city", desc, viewProjection, city);
+
+		// Occludees through the city, and around and behind the camera, and then right at the buildings' faces
+		const BoxArrays boxes = MakeBoxes(3000, 150.0f, rng);
+		CheckOccludees(reverseZ ? "occludees, reverse Z" : "occludees", desc, viewProjection, city, boxes, rng);
+
+		const BoxArrays faceBoxes = MakeBoxesAroundFaces(city, 3000, rng);
+		CheckOccludees(reverseZ ? "occludees at faces, reverse Z" : "occludees at faces", desc, viewProjection, city, faceBoxes, rng);
+	}
+}
+
+
+// One wall, with a box right behind it, one in front of it, and one that peeks out past its side
+void TestSimpleScene()
+{
+	const float position[3] = { 0.0f, 0.0f, 0.0f };
+	const Matrix viewProjection = MakeViewProjection(1.0f, 1.0f, 0.5f, 100.0f, false, 0.0f, position);
+
+	const float wallMin[3] = { -5.0f, -5.0f, -21.0f };
+	const float wallMax[3] = { 5.0f, 5.0f, -20.0f };
+
+	for (CullMode cullMode : { CullMode::Back, CullMode::None })
+	{
+		OcclusionCuller culler{ MakeDesc(64, 64, false, cullMode, false) };
+		RasterizeScene(culler, viewProjection, { MakeBox(wallMin, wallMax) });
+
+		const float behindMin[3] = { -1.0f, -1.0f, -40.0f }, behindMax[3] = { 1.0f, 1.0f, -38.0f };
+		const float frontMin[3] = { -1.0f, -1.0f, -12.0f }, frontMax[3] = { 1.0f, 1.0f, -10.0f };
+		const float peekMin[3] = { 5.0f, -1.0f, -40.0f }, peekMax[3] = { 12.0f, 1.0f, -38.0f };
+		const float offscreenMin[3] = { 500.0f, -1.0f, -40.0f }, offscreenMax[3] = { 502.0f, 1.0f, -38.0f };
+		const float aroundCameraMin[3] = { -1.0f, -1.0f, -1.0f }, aroundCameraMax[3] = { 1.0f, 1.0f, 1.0f };
+
+		Check(!culler.IsVisible(behindMin, behindMax), "a box behind the wall is hidden");
+		Check(culler.IsVisible(frontMin, frontMax), "a box in front of the wall is visible");
+		Check(culler.IsVisible(peekMin, peekMax), "a box that peeks past the wall is visible");
+		Check(!culler.IsVisible(offscreenMin, offscreenMax), "a box off the screen is hidden");
+		Check(culler.IsVisible(aroundCameraMin, aroundCameraMax), "a box around the camera is visible");
+
+		// Only the face toward the camera is front facing
+		Check(cullMode != CullMode::Back || culler.GetStats().numRasterizedTriangles == 2, "back face culling leaves the two triangles facing the camera");
+	}
+
+	// Culling the front faces leaves the far side of the wall and its four sides, which hide the same boxes
+	OcclusionCuller frontCulled{ MakeDesc(64, 64, false, CullMode::Front, false) };
+	RasterizeScene(frontCulled, viewProjection, { MakeBox(wallMin, wallMax) });
+	const float behindMin[3] = { -1.0f, -1.0f, -40.0f }, behindMax[3] = { 1.0f, 1.0f, -38.0f };
+	Check(!frontCulled.IsVisible(behindMin, behindMax), "the back of the wall hides a box behind it");
+	Check(frontCulled.GetStats().numRasterizedTriangles == 10, "front face culling leaves the ten triangles facing away from the camera");
+}
+
+
+// Every instruction set, and any number of threads, must write the same depths and cull the same boxes
+void TestPathsAndThreadsMatch(mt19937& rng)
+{
+	const float position[3] = { 0.0f, 6.0f, 10.0f };
+	const Matrix viewProjection = MakeViewProjection(1.0f, 16.0f / 9.0f, 0.5f, 300.0f, true, -0.2f, position);
+	const vector<Mesh> city = MakeCity(200, rng);
+	const BoxArrays boxes = MakeBoxes(5000, 150.0f, rng);
+	const BoundingBoxSoA boxSoA = boxes.GetSoA(boxes.minX.size());
+
+	vector<BatchPath> paths{ BatchPath::Scalar, BatchPath::SSE, BatchPath::Best };
+	if (HasAVX())
+	{
+		paths.push_back(BatchPath::AVX);
+	}
+
+	auto run = [&](BatchPath path, vector<float>& outDepth, vector<uint64_t>& outMask)
+		{
+			OcclusionCuller culler{ MakeDesc(320, 192, true, CullMode::Back, false, path) };
+			RasterizeScene(culler, viewProjection, city);
+			outDepth.assign(culler.GetDepthBuffer().begin(), culler.GetDepthBuffer().end());
+			outMask.assign((boxSoA.GetCount() + 63) / 64, ~0ull);
+			culler.CullBoundingBoxes(boxSoA, outMask);
+		};
+
+	vector<float> expectedDepth;
+	vector<uint64_t> expectedMask;
+	run(BatchPath::Scalar, expectedDepth, expectedMask);
+
+	for (BatchPath path : paths)
+	{
+		vector<float> depth;
+		vector<uint64_t> mask;
+		run(path, depth, mask);
+		Check(memcmp(depth.data(), expectedDepth.data(), depth.size() * sizeof(float)) == 0, "every path writes the same depths");
+		Check(mask == expectedMask, "every path culls the same occludees");
+	}
+
+	JobSystem jobSystem{ 3 };
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		vector<float> depth;
+		vector<uint64_t> mask;
+		run(BatchPath::Best, depth, mask);
+		Check(memcmp(depth.data(), expectedDepth.data(), depth.size() * sizeof(float)) == 0, "threads write the same depths as one thread");
+		Check(mask == expectedMask, "threads cull the same occludees as one thread");
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestSimpleScene();
+	TestAgainstReference(rng);
+	TestBoxOccluders(rng);
+	TestPathsAndThreadsMatch(rng);
+
+	printf("Occlusion culling: every path matches the brute force reference%s\n", HasAVX() ? ", AVX included" : ", AVX not supported here");
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/PipelineCacheData.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// The header starts with the magic and the engine's cache version
+constexpr size_t s_versionOffset = 4;
+
+
+PipelineCacheIdentity MakeIdentity()
+{
+	return PipelineCacheIdentity{
+		.api			= GraphicsApi::Vulkan,
+		.vendorId		= 0x10DE,
+		.deviceId		= 0x2684,
+		.driverVersion	= 0x8A2C0000,
+		.driverUuid		= { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 }
+	};
+}
+
+
+vector<std::byte> MakePayload(size_t size, mt19937& rng)
+{
+	vector<std::byte> payload(size);
+	for (auto& value : payload)
+	{
+		value = std::byte(rng());
+	}
+	return payload;
+}
+
+
+PipelineCacheStatus Validate(span<const std::byte> fileData, const PipelineCacheIdentity& identity, size_t maxSize = MaxPipelineCacheSize)
+{
+	span<const std::byte> payload;
+	const PipelineCacheStatus status = ValidatePipelineCacheData(fileData, identity, payload, maxSize);
+	if (status != PipelineCacheStatus::Loaded && !payload.empty())
+	{
+		Check(false, "a cache that fails validation hands back no payload");
+	}
+	return status;
+}
+
+
+void TestRoundTrip(mt19937& rng)
+{
+	const PipelineCacheIdentity identity = MakeIdentity();
+
+	for (size_t size : { 0, 1, 1000, 1 << 20 })
+	{
+		const vector<std::byte> payload = MakePayload(size, rng);
+		const vector<std::byte> fileData = MakePipelineCacheData(identity, payload);
+		Check(fileData.size() > payload.size(), "the cache data has a header");
+
+		span<const std::byte> loaded;
+		const PipelineCacheStatus status = ValidatePipelineCacheData(fileData, identity, loaded);
+		Check(status == PipelineCacheStatus::Loaded, "a freshly made cache validates");
+		Check(loaded.size() == payload.size() && equal(loaded.begin(), loaded.end(), payload.begin()), "the payload comes back unchanged");
+		Check(loaded.empty() || (loaded.data() >= fileData.data() && loaded.data() + loaded.size() == fileData.data() + fileData.size()),
+			"the payload points into the file data");
+	}
+
+	// The same payload and identity give the same bytes, so an unchanged cache rewrites identically
+	const vector<std::byte> payload = MakePayload(256, rng);
+	Check(MakePipelineCacheData(identity, payload) == MakePipelineCacheData(identity, payload), "cache data is deterministic");
+}
+
+
+void TestTruncated(mt19937& rng)
+{
+	const PipelineCacheIdentity identity = MakeIdentity();
+	const vector<std::byte> fileData = MakePipelineCacheData(identity, MakePayload(200, rng));
+
+	// Every length short of the whole file, through the header and into the payload
+	bool allCorrupt = true;
+	for (size_t size = 0; size < fileData.size(); ++size)
+	{
+		allCorrupt = allCorrupt && Validate(span{ fileData.data(), size }, identity) == PipelineCacheStatus::Corrupt;
+	}
+	Check(allCorrupt, "a truncated cache is corrupt");
+
+	// A file with trailing bytes doesn't match its payload size either
+	vector<std::byte> extended = fileData;
+	extended.push_back(std::byte{ 0 });
+	Check(Validate(extended, identity) == PipelineCacheStatus::Corrupt, "a cache with trailing bytes is corrupt");
+}
+
+
+void TestBadChecksum(mt19937& rng)
+{
+	const PipelineCacheIdentity identity = MakeIdentity();
+	const vector<std::byte> payload = MakePayload(300, rng);
+	const vector<std::byte> fileData = MakePipelineCacheData(identity, payload);
+	const size_t headerSize = fileData.size() - payload.size();
+
+	// Every bit of the payload, and of the checksum that ends the header
+	bool allCorrupt = true;
+	for (size_t i = headerSize - sizeof(uint64_t); i < fileData.size(); ++i)
+	{
+		for (uint32_t bit = 0; bit < 8; ++bit)
+		{
+			vector<std::byte> flipped = fileData;
+			flipped[i] ^= std::byte(1 << bit);
+			allCorrupt = allCorrupt && Validate(flipped, identity) == PipelineCacheStatus::Corrupt;
+		}
+	}
+	Check(allCorrupt, "a flipped bit in the payload or its checksum makes the cache corrupt");
+
+	// Not a cache file at all
+	vector<std::byte> badMagic = fileData;
+	badMagic[0] ^= std::byte{ 0xFF };
+	Check(Validate(badMagic, identity) == PipelineCacheStatus::Corrupt, "a file without the magic is corrupt");
+
+	const vector<std::byte> garbage = MakePayload(fileData.size(), rng);
+	Check(Validate(garbage, identity) == PipelineCacheStatus::Corrupt, "random bytes are corrupt");
+}
+
+
+void TestStale(mt19937& rng)
+{
+	const PipelineCacheIdentity identity = MakeIdentity();
+	const vector<std::byte> fileData = MakePipelineCacheData(identity, MakePayload(100, rng));
+
+	// Anything that identifies the device or driver changing
+	vector<PipelineCacheIdentity> others(6, identity);
+	others[0].api = GraphicsApi::D3D12;
+	others[1].vendorId = 0x1002;
+	others[2].deviceId = 0x2685;
+	others[3].driverVersion = identity.driverVersion + 1;
+	others[4].driverUuid[15] ^= 1;
+	others[5].driverUuid[0] ^= 0x80;
+
+	bool allStale = true;
+	for (const auto& other : others)
+	{
+		allStale = allStale && Validate(fileData, other) == PipelineCacheStatus::Stale;
+	}
+	Check(allStale, "a cache from another API, vendor, device, driver version or driver UUID is stale");
+
+	// A cache written by an older or newer build of the engine
+	for (int32_t delta : { -1, 1 })
+	{
+		vector<std::byte> otherVersion = fileData;
+		uint32_t version;
+		memcpy(&version, otherVersion.data() + s_versionOffset, sizeof(version));
+		version += delta;
+		memcpy(otherVersion.data() + s_versionOffset, &version, sizeof(version));
+		Check(Validate(otherVersion, identity) == PipelineCacheStatus::Stale, "a cache from another engine version is stale");
+	}
+
+	// Staleness is checked before the checksum, so a stale file is reported as stale even when truncated
+	const span<const std::byte> truncated{ fileData.data(), fileData.size() - 1 };
+	Check(Validate(truncated, others[3]) == PipelineCacheStatus::Stale, "a truncated cache from another driver is stale");
+}
+
+
+void TestTooLarge(mt19937& rng)
+{
+	const PipelineCacheIdentity identity = MakeIdentity();
+	const vector<std::byte> fileData = MakePipelineCacheData(identity, MakePayload(1000, rng));
+
+	Check(Validate(fileData, identity, fileData.size()) == PipelineCacheStatus::Loaded, "a cache at the size limit loads");
+	Check(Validate(fileData, identity, fileData.size() - 1) == PipelineCacheStatus::TooLarge, "a cache over the size limit is too large");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestRoundTrip(rng);
+	TestTruncated(rng);
+	TestBadChecksum(rng);
+	TestStale(rng);
+	TestTooLarge(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
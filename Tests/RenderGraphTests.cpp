@@ -0,0 +1,745 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/RenderGraphCompiler.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+using ResourceKind = RenderGraphCompiler::ResourceKind;
+
+
+namespace
+{
+
+constexpr uint32_t s_invalidIndex = ~0u;
+
+
+// What RenderGraph hands the compiler for a transient texture.  Textures with the same alias class have the
+// same desc.
+struct TextureDesc
+{
+	uint32_t aliasClass{ 0 };
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	uint32_t bytesPerPixel{ 0 };
+
+	uint64_t GetSizeInBytes() const { return (uint64_t)width * height * bytesPerPixel; }
+};
+
+
+struct TestAccess
+{
+	uint32_t resource{ 0 };
+	ResourceState state{ ResourceState::Undefined };
+	bool isWrite{ false };
+};
+
+
+// Mirrors every call into the compiler, so the checks below can recompute the results independently
+struct TestGraph
+{
+	RenderGraphCompiler compiler;
+
+	vector<ResourceKind> kinds;
+	vector<uint32_t> aliasClasses;
+	vector<ResourceState> initialStates;
+	vector<ResourceState> finalStates;
+	vector<vector<TestAccess>> passes;
+	vector<bool> neverCull;
+
+	explicit TestGraph(const RenderGraphDesc& desc = RenderGraphDesc{})
+		: compiler{ desc }
+	{}
+
+	uint32_t Transient(const TextureDesc& desc)
+	{
+		kinds.push_back(ResourceKind::Transient);
+		aliasClasses.push_back(desc.aliasClass);
+		initialStates.push_back(ResourceState::Undefined);
+		finalStates.push_back(ResourceState::Undefined);
+		return compiler.AddTransientTexture(desc.aliasClass, desc.GetSizeInBytes()).index;
+	}
+
+	uint32_t Import(ResourceKind kind, ResourceState initialState, ResourceState finalState = ResourceState::Undefined)
+	{
+		kinds.push_back(kind);
+		aliasClasses.push_back(s_invalidIndex);
+		initialStates.push_back(initialState);
+		finalStates.push_back(finalState);
+		return compiler.AddImportedResource(kind, initialState, finalState).index;
+	}
+
+	// Each resource at most once per pass, so the accesses here are exactly the compiler's
+	uint32_t Pass(initializer_list<TestAccess> accesses, bool keep = false)
+	{
+		const uint32_t passIndex = compiler.AddPass();
+		for (const auto& access : accesses)
+		{
+			compiler.AddAccess(passIndex, RenderGraphHandle{ access.resource }, access.state, access.isWrite);
+		}
+		if (keep)
+		{
+			compiler.SetNeverCull(passIndex);
+		}
+
+		passes.emplace_back(accesses);
+		neverCull.push_back(keep);
+		return passIndex;
+	}
+
+	uint32_t Pass(const vector<TestAccess>& accesses)
+	{
+		const uint32_t passIndex = compiler.AddPass();
+		for (const auto& access : accesses)
+		{
+			compiler.AddAccess(passIndex, RenderGraphHandle{ access.resource }, access.state, access.isWrite);
+		}
+
+		passes.push_back(accesses);
+		neverCull.push_back(false);
+		return passIndex;
+	}
+};
+
+
+TestAccess Read(uint32_t resource, ResourceState state = ResourceState::PixelShaderResource) { return { resource, state, false }; }
+TestAccess Write(uint32_t resource, ResourceState state = ResourceState::RenderTarget) { return { resource, state, true }; }
+
+
+// Culling by brute force: keep removing passes that nothing needs, until nothing changes.  A pass is needed if it
+// must never be culled, or if it writes an imported resource, or a resource that a remaining pass reads.
+vector<bool> ReferenceCulledPasses(const TestGraph& graph, bool enableCulling)
+{
+	const size_t numPasses = graph.passes.size();
+	vector<bool> culled(numPasses, false);
+	if (!enableCulling)
+	{
+		return culled;
+	}
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t p = 0; p < numPasses; ++p)
+		{
+			if (culled[p] || graph.neverCull[p])
+			{
+				continue;
+			}
+
+			bool isNeeded = false;
+			for (const auto& write : graph.passes[p])
+			{
+				if (!write.isWrite)
+				{
+					continue;
+				}
+
+				isNeeded = isNeeded || graph.kinds[write.resource] != ResourceKind::Transient;
+				for (size_t q = 0; q < numPasses && !isNeeded; ++q)
+				{
+					for (const auto& read : graph.passes[q])
+					{
+						isNeeded = isNeeded || (!culled[q] && !read.isWrite && read.resource == write.resource);
+					}
+				}
+			}
+
+			if (!isNeeded)
+			{
+				culled[p] = true;
+				changed = true;
+			}
+		}
+	}
+	return culled;
+}
+
+
+// Checks the compile results against the graph: culling against the reference above, transients sharing a physical
+// resource only when their descs match and their lifetimes do not overlap, and the barriers by replaying them.
+void CheckCompiled(const TestGraph& graph, const RenderGraphDesc& desc)
+{
+	const RenderGraphCompiler& compiler = graph.compiler;
+	const size_t numPasses = graph.passes.size();
+	const size_t numResources = graph.kinds.size();
+
+	// Culling, and the executed passes in order
+	const vector<bool> expectedCulled = ReferenceCulledPasses(graph, desc.enableCulling);
+	vector<uint32_t> expectedExecuted;
+	bool cullingMatches = true;
+	for (uint32_t p = 0; p < numPasses; ++p)
+	{
+		cullingMatches = cullingMatches && compiler.IsPassCulled(p) == expectedCulled[p];
+		if (!expectedCulled[p])
+		{
+			expectedExecuted.push_back(p);
+		}
+	}
+	Check(cullingMatches, "culled passes match the reference");
+	Check(compiler.GetExecutedPasses() == expectedExecuted, "executed passes are the unculled ones, in order");
+	if (compiler.GetExecutedPasses() != expectedExecuted)
+	{
+		return;
+	}
+
+	// Lifetimes, in executed pass indices
+	vector<uint32_t> firstUse(numResources, s_invalidIndex);
+	vector<uint32_t> lastUse(numResources, 0);
+	for (uint32_t k = 0; k < expectedExecuted.size(); ++k)
+	{
+		for (const auto& access : graph.passes[expectedExecuted[k]])
+		{
+			firstUse[access.resource] = min(firstUse[access.resource], k);
+			lastUse[access.resource] = k;
+		}
+	}
+
+	const auto& physicalResources = compiler.GetPhysicalResources();
+	vector<vector<uint32_t>> tenants(physicalResources.size());
+	bool physicalValid = true;
+	for (uint32_t r = 0; r < numResources; ++r)
+	{
+		const uint32_t physical = compiler.GetPhysicalIndex(RenderGraphHandle{ r });
+		if (firstUse[r] == s_invalidIndex)
+		{
+			physicalValid = physicalValid && physical == s_invalidIndex;
+			continue;
+		}
+
+		physicalValid = physicalValid && physical < physicalResources.size();
+		if (physical < physicalResources.size())
+		{
+			tenants[physical].push_back(r);
+		}
+	}
+	Check(physicalValid, "every used resource, and only those, has a physical resource");
+
+	bool aliasingValid = true;
+	for (size_t i = 0; i < tenants.size(); ++i)
+	{
+		const auto& residents = tenants[i];
+		// The physical resource is created for its first tenant
+		const uint32_t firstResource = physicalResources[i].firstResource;
+		aliasingValid = aliasingValid && find(residents.begin(), residents.end(), firstResource) != residents.end();
+
+		for (size_t a = 0; a < residents.size(); ++a)
+		{
+			const uint32_t ra = residents[a];
+			aliasingValid = aliasingValid && firstUse[firstResource] <= firstUse[ra];
+			aliasingValid = aliasingValid && (graph.kinds[ra] == ResourceKind::Transient || residents.size() == 1);
+			aliasingValid = aliasingValid && (desc.enableAliasing || residents.size() == 1);
+
+			for (size_t b = a + 1; b < residents.size(); ++b)
+			{
+				const uint32_t rb = residents[b];
+				const bool overlaps = firstUse[ra] <= lastUse[rb] && firstUse[rb] <= lastUse[ra];
+				aliasingValid = aliasingValid && !overlaps && graph.aliasClasses[ra] == graph.aliasClasses[rb];
+			}
+		}
+	}
+	Check(aliasingValid, "only transients with the same desc and disjoint lifetimes share a physical resource");
+
+	// Replay the barriers against every access
+	const auto& batches = compiler.GetBarrierBatches();
+	Check(batches.size() == expectedExecuted.size() + 1, "one barrier batch per executed pass, plus one at the end");
+	if (batches.size() != expectedExecuted.size() + 1)
+	{
+		return;
+	}
+
+	struct State
+	{
+		ResourceState current{ ResourceState::Undefined };
+		ResourceState pending{ ResourceState::Undefined };
+		bool lastWasUAVWrite{ false };
+		bool lastWasUAV{ false };
+	};
+	vector<State> states(physicalResources.size());
+	for (size_t i = 0; i < physicalResources.size(); ++i)
+	{
+		states[i].current = graph.initialStates[physicalResources[i].firstResource];
+	}
+
+	bool barriersValid = true;
+	bool accessesValid = true;
+	bool uavOrdered = true;
+
+	auto ApplyBatch = [&](const vector<RenderGraphBarrier>& batch, vector<bool>& hasUAVBarrier)
+	{
+		for (const auto& barrier : batch)
+		{
+			if (barrier.physical >= states.size())
+			{
+				barriersValid = false;
+				continue;
+			}
+
+			State& state = states[barrier.physical];
+			switch (barrier.type)
+			{
+			case RenderGraphBarrierType::Transition:
+				barriersValid = barriersValid && state.pending == ResourceState::Undefined && barrier.stateBefore == state.current && barrier.stateBefore != barrier.stateAfter;
+				state.current = barrier.stateAfter;
+				break;
+
+			case RenderGraphBarrierType::BeginSplit:
+				barriersValid = barriersValid && state.pending == ResourceState::Undefined && barrier.stateBefore == state.current;
+				barriersValid = barriersValid && graph.kinds[physicalResources[barrier.physical].firstResource] != ResourceKind::ImportedBuffer;
+				state.pending = barrier.stateAfter;
+				break;
+
+			case RenderGraphBarrierType::EndSplit:
+				barriersValid = barriersValid && state.pending == barrier.stateAfter;
+				state.current = barrier.stateAfter;
+				state.pending = ResourceState::Undefined;
+				break;
+
+			case RenderGraphBarrierType::UAV:
+				barriersValid = barriersValid && state.current == ResourceState::UnorderedAccess;
+				hasUAVBarrier[barrier.physical] = true;
+				break;
+			}
+		}
+	};
+
+	for (uint32_t k = 0; k < expectedExecuted.size(); ++k)
+	{
+		vector<bool> hasUAVBarrier(states.size(), false);
+		vector<ResourceState> stateBefore(states.size());
+		for (size_t i = 0; i < states.size(); ++i)
+		{
+			stateBefore[i] = states[i].current;
+		}
+
+		ApplyBatch(batches[k], hasUAVBarrier);
+
+		for (const auto& access : graph.passes[expectedExecuted[k]])
+		{
+			const uint32_t physical = compiler.GetPhysicalIndex(RenderGraphHandle{ access.resource });
+			State& state = states[physical];
+
+			accessesValid = accessesValid && state.pending == ResourceState::Undefined;
+			accessesValid = accessesValid && (access.isWrite ? state.current == access.state : HasAllFlags(state.current, access.state));
+
+			// A UAV access after a UAV write, or a UAV write after any UAV access, needs the earlier writes to be
+			// visible, through either a UAV barrier or a transition
+			const bool isUAV = access.state == ResourceState::UnorderedAccess;
+			if (isUAV && (state.lastWasUAVWrite || (access.isWrite && state.lastWasUAV)) && stateBefore[physical] == ResourceState::UnorderedAccess)
+			{
+				uavOrdered = uavOrdered && hasUAVBarrier[physical];
+			}
+			state.lastWasUAV = isUAV;
+			state.lastWasUAVWrite = isUAV && access.isWrite;
+		}
+	}
+
+	vector<bool> unused(states.size(), false);
+	ApplyBatch(batches.back(), unused);
+
+	bool finalStatesValid = true;
+	for (size_t i = 0; i < states.size(); ++i)
+	{
+		const ResourceState finalState = graph.finalStates[physicalResources[i].firstResource];
+		finalStatesValid = finalStatesValid && states[i].pending == ResourceState::Undefined;
+		finalStatesValid = finalStatesValid && (finalState == ResourceState::Undefined || states[i].current == finalState);
+	}
+
+	Check(barriersValid, "every barrier starts from the state the resource is in");
+	Check(accessesValid, "every access finds its resource in the declared state, with no split barrier in flight");
+	Check(uavOrdered, "dependent UAV accesses are separated by a UAV barrier");
+	Check(finalStatesValid, "imported resources end in their final state, and every split barrier ends");
+
+	// The stats agree with the batches
+	const RenderGraphStats& stats = compiler.GetStats();
+	uint32_t numTransitions{ 0 };
+	uint32_t numSplits{ 0 };
+	uint32_t numUAVBarriers{ 0 };
+	uint32_t numBatches{ 0 };
+	for (const auto& batch : batches)
+	{
+		numBatches += batch.empty() ? 0 : 1;
+		for (const auto& barrier : batch)
+		{
+			numTransitions += (barrier.type == RenderGraphBarrierType::Transition || barrier.type == RenderGraphBarrierType::EndSplit) ? 1 : 0;
+			numSplits += barrier.type == RenderGraphBarrierType::EndSplit ? 1 : 0;
+			numUAVBarriers += barrier.type == RenderGraphBarrierType::UAV ? 1 : 0;
+		}
+	}
+	Check(stats.numPasses == numPasses && stats.numCulledPasses == numPasses - expectedExecuted.size(), "pass stats match");
+	Check(stats.numTransitions == numTransitions && stats.numSplitTransitions == numSplits && stats.numUAVBarriers == numUAVBarriers, "barrier stats match");
+	Check(stats.numBarrierBatches == numBatches, "batch stats match");
+	Check(stats.physicalBytes <= stats.transientBytes, "aliasing never costs memory");
+}
+
+
+uint32_t CountBarriers(const RenderGraphCompiler& compiler, uint32_t resource, RenderGraphBarrierType type)
+{
+	uint32_t count{ 0 };
+	for (const auto& batch : compiler.GetBarrierBatches())
+	{
+		for (const auto& barrier : batch)
+		{
+			count += (barrier.resource == resource && barrier.type == type) ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+
+void TestCulling()
+{
+	const TextureDesc desc{ 0, 64, 64, 4 };
+
+	TestGraph graph;
+	const uint32_t output = graph.Import(ResourceKind::ImportedTexture, ResourceState::Present, ResourceState::Present);
+	const uint32_t used = graph.Transient(desc);
+	const uint32_t unused = graph.Transient(desc);
+	const uint32_t chained = graph.Transient(desc);
+	const uint32_t sideEffect = graph.Transient(desc);
+
+	const uint32_t writeUsed = graph.Pass({ Write(used) });
+	const uint32_t writeUnused = graph.Pass({ Write(unused) });
+	const uint32_t readUnused = graph.Pass({ Read(unused), Write(chained) });
+	const uint32_t keep = graph.Pass({ Write(sideEffect) }, true);
+	const uint32_t present = graph.Pass({ Read(used), Write(output) });
+
+	graph.compiler.Compile();
+	CheckCompiled(graph, RenderGraphDesc{});
+
+	Check(!graph.compiler.IsPassCulled(writeUsed), "a pass whose output is read is kept");
+	Check(graph.compiler.IsPassCulled(writeUnused) && graph.compiler.IsPassCulled(readUnused), "a chain of passes nothing reads is culled");
+	Check(!graph.compiler.IsPassCulled(keep), "a never-cull pass is kept");
+	Check(!graph.compiler.IsPassCulled(present), "a pass writing an imported resource is kept");
+	Check(graph.compiler.GetPhysicalIndex(RenderGraphHandle{ unused }) == s_invalidIndex, "resources of culled passes get no physical resource");
+}
+
+
+void TestAliasing()
+{
+	const TextureDesc full{ 0, 256, 256, 4 };
+	const TextureDesc half{ 1, 128, 128, 4 };
+
+	for (bool enableAliasing : { true, false })
+	{
+		const RenderGraphDesc desc{ .enableAliasing = enableAliasing };
+
+		TestGraph graph{ desc };
+		const uint32_t output = graph.Import(ResourceKind::ImportedTexture, ResourceState::RenderTarget);
+		const uint32_t a = graph.Transient(full);
+		const uint32_t b = graph.Transient(full);
+		const uint32_t c = graph.Transient(full);
+		const uint32_t d = graph.Transient(half);
+
+		graph.Pass({ Write(a) });
+		graph.Pass({ Read(a), Write(b) });
+		graph.Pass({ Read(b), Write(c) });		// a is done, so c can take its place
+		graph.Pass({ Read(c), Write(d) });		// Different desc, so d cannot take b's
+		graph.Pass({ Read(d), Write(output) });
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, desc);
+
+		const auto& compiler = graph.compiler;
+		const auto& stats = compiler.GetStats();
+		if (enableAliasing)
+		{
+			Check(compiler.GetPhysicalIndex(RenderGraphHandle{ a }) == compiler.GetPhysicalIndex(RenderGraphHandle{ c }), "a transient reuses a finished one with the same desc");
+			Check(compiler.GetPhysicalIndex(RenderGraphHandle{ a }) != compiler.GetPhysicalIndex(RenderGraphHandle{ b }), "transients alive at the same time do not share");
+			Check(stats.numTransientTextures == 4 && stats.numPhysicalTextures == 3, "four transients fit in three textures");
+			Check(stats.GetSavedBytes() == full.GetSizeInBytes(), "aliasing saves one full size texture");
+		}
+		else
+		{
+			Check(stats.numPhysicalTextures == 4 && stats.GetSavedBytes() == 0, "without aliasing every transient has its own texture");
+		}
+	}
+}
+
+
+void TestBarriers()
+{
+	const TextureDesc desc{ 0, 64, 64, 4 };
+
+	// Reads in different states fold into one transition to the combined state
+	{
+		TestGraph graph;
+		const uint32_t output = graph.Import(ResourceKind::ImportedTexture, ResourceState::RenderTarget);
+		const uint32_t texture = graph.Transient(desc);
+
+		graph.Pass({ Write(texture) });
+		graph.Pass({ Read(texture, ResourceState::PixelShaderResource), Write(output) });
+		graph.Pass({ Read(texture, ResourceState::NonPixelShaderResource), Write(output) });
+		graph.Pass({ Read(texture, ResourceState::PixelShaderResource), Write(output) });
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, RenderGraphDesc{});
+
+		Check(CountBarriers(graph.compiler, texture, RenderGraphBarrierType::Transition) == 2, "a texture needs one transition to write and one to read");
+		Check(graph.compiler.GetStats().numMergedReads == 2, "the later reads are covered by the first transition");
+	}
+
+	// An imported texture already in one read state still needs a transition for a combined read
+	{
+		TestGraph graph;
+		const uint32_t output = graph.Import(ResourceKind::ImportedTexture, ResourceState::RenderTarget);
+		const uint32_t input = graph.Import(ResourceKind::ImportedTexture, ResourceState::PixelShaderResource);
+
+		const uint32_t pass = graph.compiler.AddPass();
+		graph.compiler.AddAccess(pass, RenderGraphHandle{ input }, ResourceState::PixelShaderResource, false);
+		graph.compiler.AddAccess(pass, RenderGraphHandle{ input }, ResourceState::NonPixelShaderResource, false);
+		graph.compiler.AddAccess(pass, RenderGraphHandle{ output }, ResourceState::RenderTarget, true);
+		graph.passes.push_back({ Read(input, ResourceState::PixelShaderResource | ResourceState::NonPixelShaderResource), Write(output) });
+		graph.neverCull.push_back(false);
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, RenderGraphDesc{});
+
+		Check(graph.compiler.GetStats().numMergedReads == 0, "a read is only merged when the current state covers all of it");
+	}
+
+	// Back to back UAV writes get a UAV barrier, and reads after them a transition
+	{
+		TestGraph graph;
+		const uint32_t output = graph.Import(ResourceKind::ImportedTexture, ResourceState::RenderTarget);
+		const uint32_t buffer = graph.Import(ResourceKind::ImportedBuffer, ResourceState::Common, ResourceState::Common);
+
+		graph.Pass({ Write(buffer, ResourceState::UnorderedAccess) });
+		graph.Pass({ Write(buffer, ResourceState::UnorderedAccess) });
+		graph.Pass({ Read(buffer, ResourceState::UnorderedAccess), Write(output) });
+		graph.Pass({ Read(buffer, ResourceState::NonPixelShaderResource), Write(output) });
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, RenderGraphDesc{});
+
+		Check(graph.compiler.GetStats().numUAVBarriers == 2, "each UAV access after a UAV write gets a UAV barrier");
+	}
+
+	// A texture idle between its write and its read transitions with a split barrier, and a buffer does not
+	for (bool enableSplitBarriers : { true, false })
+	{
+		const RenderGraphDesc graphDesc{ .enableSplitBarriers = enableSplitBarriers };
+
+		TestGraph graph{ graphDesc };
+		const uint32_t output = graph.Import(ResourceKind::ImportedTexture, ResourceState::RenderTarget);
+		const uint32_t buffer = graph.Import(ResourceKind::ImportedBuffer, ResourceState::UnorderedAccess);
+		const uint32_t shadowMap = graph.Transient(desc);
+		const uint32_t other = graph.Transient(desc);
+
+		graph.Pass({ Write(shadowMap, ResourceState::DepthWrite), Write(buffer, ResourceState::UnorderedAccess) });
+		graph.Pass({ Write(other) });
+		graph.Pass({ Read(other), Write(output) });
+		graph.Pass({ Read(shadowMap), Read(buffer, ResourceState::NonPixelShaderResource), Write(output) });
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, graphDesc);
+
+		const uint32_t numSplits = CountBarriers(graph.compiler, shadowMap, RenderGraphBarrierType::BeginSplit);
+		Check(numSplits == (enableSplitBarriers ? 1u : 0u), "an idle texture's transition is split when split barriers are enabled");
+		Check(CountBarriers(graph.compiler, buffer, RenderGraphBarrierType::BeginSplit) == 0, "buffers never get split barriers");
+	}
+
+	// Imported resources go back to their final state after the last pass
+	{
+		TestGraph graph;
+		const uint32_t backBuffer = graph.Import(ResourceKind::ImportedTexture, ResourceState::Present, ResourceState::Present);
+
+		graph.Pass({ Write(backBuffer) });
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, RenderGraphDesc{});
+
+		const auto& lastBatch = graph.compiler.GetBarrierBatches().back();
+		Check(lastBatch.size() == 1 && lastBatch[0].stateAfter == ResourceState::Present, "the back buffer goes back to present");
+	}
+
+	// Reading a transient nobody wrote is reported
+	{
+		TestGraph graph;
+		const uint32_t output = graph.Import(ResourceKind::ImportedTexture, ResourceState::RenderTarget);
+		const uint32_t texture = graph.Transient(desc);
+
+		const uint32_t pass = graph.Pass({ Read(texture), Write(output) });
+
+		graph.compiler.Compile();
+
+		const auto& reads = graph.compiler.GetUninitializedReads();
+		Check(reads.size() == 1 && reads[0].pass == pass && reads[0].resource == texture, "uninitialized reads are reported");
+	}
+}
+
+
+// Random graphs: passes read what earlier passes wrote, and write new transients, earlier transients or imports
+void TestRandomGraphs(mt19937& rng)
+{
+	const ResourceState readStates[] = { ResourceState::PixelShaderResource, ResourceState::NonPixelShaderResource, ResourceState::UnorderedAccess, ResourceState::CopySource };
+	const ResourceState writeStates[] = { ResourceState::RenderTarget, ResourceState::UnorderedAccess, ResourceState::CopyDest };
+	const TextureDesc descs[] = { { 0, 64, 64, 4 }, { 1, 32, 32, 4 }, { 2, 64, 64, 8 } };
+
+	for (uint32_t iteration = 0; iteration < 2000; ++iteration)
+	{
+		const RenderGraphDesc desc{
+			.enableCulling			= (iteration % 8) != 1,
+			.enableAliasing			= (iteration % 8) != 2,
+			.enableSplitBarriers	= (iteration % 8) != 3
+		};
+
+		TestGraph graph{ desc };
+
+		const uint32_t numImports = 1 + rng() % 3;
+		for (uint32_t i = 0; i < numImports; ++i)
+		{
+			const ResourceKind kind = (rng() % 3 == 0) ? ResourceKind::ImportedBuffer : ResourceKind::ImportedTexture;
+			const ResourceState finalState = (rng() % 2 == 0) ? ResourceState::Undefined : ResourceState::Common;
+			graph.Import(kind, ResourceState::Common, finalState);
+		}
+
+		vector<uint32_t> written;
+		const uint32_t numPasses = 1 + rng() % 12;
+		for (uint32_t p = 0; p < numPasses; ++p)
+		{
+			vector<TestAccess> accesses;
+			auto Uses = [&accesses](uint32_t resource)
+			{
+				return any_of(accesses.begin(), accesses.end(), [resource](const TestAccess& access) { return access.resource == resource; });
+			};
+
+			const uint32_t numReads = written.empty() ? 0 : rng() % 3;
+			for (uint32_t i = 0; i < numReads; ++i)
+			{
+				const uint32_t resource = written[rng() % written.size()];
+				if (!Uses(resource))
+				{
+					accesses.push_back(Read(resource, readStates[rng() % size(readStates)]));
+				}
+			}
+
+			const uint32_t numWrites = 1 + rng() % 2;
+			for (uint32_t i = 0; i < numWrites; ++i)
+			{
+				uint32_t resource{ 0 };
+				const uint32_t choice = rng() % 4;
+				if (choice == 0)
+				{
+					resource = rng() % numImports;
+				}
+				else if (choice == 1 && !written.empty())
+				{
+					resource = written[rng() % written.size()];
+				}
+				else
+				{
+					resource = graph.Transient(descs[rng() % size(descs)]);
+				}
+
+				if (!Uses(resource))
+				{
+					accesses.push_back(Write(resource, writeStates[rng() % size(writeStates)]));
+					written.push_back(resource);
+				}
+			}
+
+			graph.Pass(accesses);
+		}
+
+		const int numFailures = FailureCount();
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, desc);
+
+		if (FailureCount() > numFailures)
+		{
+			fprintf(stderr, "random graph %u failed\n", iteration);
+			return;
+		}
+	}
+}
+
+
+// A deferred frame with SSAO and bloom at 1080p, shaped like the Deferred, SSAO and Bloom samples put together
+void ReportFrame()
+{
+	const TextureDesc gbuffer{ 0, 1920, 1080, 8 };	// RGBA16F
+	const TextureDesc albedo{ 1, 1920, 1080, 4 };	// RGBA8
+	const TextureDesc depth{ 2, 1920, 1080, 4 };	// D32
+	const TextureDesc ao{ 3, 1920, 1080, 1 };		// R8
+	const TextureDesc bloom{ 4, 960, 540, 8 };		// RGBA16F, half size
+
+	printf("%-12s %8s %12s %12s %12s %8s %8s %8s %8s\n", "Aliasing", "Passes", "Transient", "Physical", "Saved", "Trans.", "Split", "Merged", "Batches");
+
+	for (bool enableAliasing : { false, true })
+	{
+		const RenderGraphDesc desc{ .enableAliasing = enableAliasing };
+		TestGraph graph{ desc };
+
+		const uint32_t backBuffer = graph.Import(ResourceKind::ImportedTexture, ResourceState::Present, ResourceState::Present);
+		const uint32_t position = graph.Transient(gbuffer);
+		const uint32_t normal = graph.Transient(gbuffer);
+		const uint32_t color = graph.Transient(albedo);
+		const uint32_t depthBuffer = graph.Transient(depth);
+		const uint32_t ssao = graph.Transient(ao);
+		const uint32_t ssaoBlur = graph.Transient(ao);
+		const uint32_t hdr = graph.Transient(gbuffer);
+		const uint32_t bright = graph.Transient(bloom);
+		const uint32_t blurV = graph.Transient(bloom);
+		const uint32_t blurH = graph.Transient(bloom);
+		const uint32_t debug = graph.Transient(albedo);
+
+		graph.Pass({ Write(position), Write(normal), Write(color), Write(depthBuffer, ResourceState::DepthWrite) });
+		graph.Pass({ Read(position), Read(normal), Read(depthBuffer, ResourceState::DepthRead), Write(ssao) });
+		graph.Pass({ Read(ssao), Write(ssaoBlur) });
+		graph.Pass({ Read(position), Read(normal), Read(color), Read(ssaoBlur), Write(hdr) });
+		graph.Pass({ Read(hdr), Write(bright) });
+		graph.Pass({ Read(bright), Write(blurV) });
+		graph.Pass({ Read(blurV), Write(blurH) });
+		graph.Pass({ Read(hdr), Read(blurH), Write(backBuffer) });
+		graph.Pass({ Read(normal), Write(debug) });	// Debug view nobody displays
+
+		graph.compiler.Compile();
+		CheckCompiled(graph, desc);
+
+		const RenderGraphStats& stats = graph.compiler.GetStats();
+		printf("%-12s %4u (%u) %9.1f MB %9.1f MB %9.1f MB %8u %8u %8u %8u\n", enableAliasing ? "on" : "off",
+			stats.numPasses, stats.numCulledPasses,
+			stats.transientBytes / (1024.0 * 1024.0), stats.physicalBytes / (1024.0 * 1024.0), stats.GetSavedBytes() / (1024.0 * 1024.0),
+			stats.numTransitions, stats.numSplitTransitions, stats.numMergedReads, stats.numBarrierBatches);
+
+		if (enableAliasing)
+		{
+			Check(stats.numCulledPasses == 1, "the debug view is culled");
+			Check(stats.GetSavedBytes() > 0, "the frame's transients alias");
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestCulling();
+	TestAliasing();
+	TestBarriers();
+	TestRandomGraphs(rng);
+	ReportFrame();
+
+	return FailureCount() == 0 ? 0 : 1;
+}
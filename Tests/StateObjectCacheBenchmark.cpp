@@ -0,0 +1,226 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Graphics/StateObjectCache.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+using Value = shared_ptr<uint32_t>;
+
+
+// About the size of a graphics pipeline key:  a few state blocks, shader and root signature addresses, and
+// the formats
+StateObjectKey MakeKey(uint32_t id)
+{
+	StateObjectKey key;
+	key.AppendString("Benchmark Graphics PSO");
+	for (uint32_t i = 0; i < 48; ++i)
+	{
+		key.Append(id * 2654435761u + i);
+	}
+	return key;
+}
+
+
+// What the cache replaced:  one map behind one mutex
+class LockedMapCache
+{
+public:
+	template <class TCreateFunction>
+	Value FindOrCreate(const StateObjectKey& key, TCreateFunction&& createFunction)
+	{
+		const auto bytes = key.GetBytes();
+		string keyString{ (const char*)bytes.data(), bytes.size() };
+
+		lock_guard lock(m_mutex);
+
+		auto it = m_map.find(keyString);
+		if (it != m_map.end())
+		{
+			return it->second;
+		}
+
+		Value value = createFunction();
+		m_map.emplace(move(keyString), value);
+		return value;
+	}
+
+private:
+	mutex m_mutex;
+	unordered_map<string, Value> m_map;
+};
+
+
+// Runs function(threadIndex) on numThreads threads at once, and returns the wall time in milliseconds
+template <class TFunction>
+double RunThreads(uint32_t numThreads, TFunction&& function)
+{
+	atomic<uint32_t> numReady{ 0 };
+	atomic<bool> go{ false };
+
+	vector<thread> threads;
+	for (uint32_t t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&, t]
+			{
+				numReady.fetch_add(1);
+				while (!go.load())
+				{
+					this_thread::yield();
+				}
+				function(t);
+			});
+	}
+
+	while (numReady.load() < numThreads)
+	{
+		this_thread::yield();
+	}
+
+	const auto startTime = chrono::steady_clock::now();
+	go = true;
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+}
+
+
+// Every thread looks up random keys from a warm working set.  Keys are built once, so this measures the
+// cache rather than key building.
+template <class TCache>
+double WarmLookups(TCache& cache, const vector<StateObjectKey>& keys, uint32_t numThreads, uint32_t numLookupsPerThread)
+{
+	atomic<uint32_t> numWrong{ 0 };
+
+	const double ms = RunThreads(numThreads, [&](uint32_t threadIndex)
+		{
+			mt19937 rng{ threadIndex + 1 };
+			uint32_t numThreadWrong{ 0 };
+
+			for (uint32_t i = 0; i < numLookupsPerThread; ++i)
+			{
+				const uint32_t id = rng() % (uint32_t)keys.size();
+				const Value value = cache.FindOrCreate(keys[id], [] { return Value{}; });
+				numThreadWrong += (value && *value == id) ? 0 : 1;
+			}
+
+			numWrong.fetch_add(numThreadWrong);
+		});
+
+	Check(numWrong == 0, "warm lookups find the cached object");
+	return ms;
+}
+
+
+// Every thread walks the same keys into an empty cache at once, as worker threads do when a level loads.  Each
+// creation takes a while, so threads pile up on keys that are still being created.
+double ColdCreates(uint32_t numThreads, uint32_t numKeys, uint32_t createSpinUs, StateObjectCacheStats& outStats)
+{
+	StateObjectCache<Value> cache;
+	vector<StateObjectKey> keys;
+	for (uint32_t i = 0; i < numKeys; ++i)
+	{
+		keys.push_back(MakeKey(i));
+	}
+
+	vector<atomic<uint32_t>> numCreated(numKeys);
+
+	const double ms = RunThreads(numThreads, [&](uint32_t threadIndex)
+		{
+			for (uint32_t i = 0; i < numKeys; ++i)
+			{
+				const uint32_t id = (i + threadIndex * 7) % numKeys;
+				cache.FindOrCreate(keys[id], [&, id]
+					{
+						numCreated[id].fetch_add(1);
+
+						const auto endTime = chrono::steady_clock::now() + chrono::microseconds(createSpinUs);
+						while (chrono::steady_clock::now() < endTime)
+						{
+						}
+						return make_shared<uint32_t>(id);
+					});
+			}
+		});
+
+	Check(all_of(numCreated.begin(), numCreated.end(), [](const atomic<uint32_t>& count) { return count.load() == 1; }),
+		"every key is created once under contention");
+
+	outStats = cache.GetStats();
+	return ms;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t maxThreads = commandLine.GetOption("--threads", 16);
+	const uint32_t numKeys = commandLine.Size(4096, 256);
+	const uint32_t numLookupsPerThread = commandLine.Size(200000, 2000);
+	const uint32_t numColdKeys = commandLine.Size(512, 32);
+
+	vector<StateObjectKey> keys;
+	for (uint32_t i = 0; i < numKeys; ++i)
+	{
+		keys.push_back(MakeKey(i));
+	}
+
+	StateObjectCache<Value> cache;
+	LockedMapCache lockedMap;
+	for (uint32_t i = 0; i < numKeys; ++i)
+	{
+		cache.FindOrCreate(keys[i], [i] { return make_shared<uint32_t>(i); });
+		lockedMap.FindOrCreate(keys[i], [i] { return make_shared<uint32_t>(i); });
+	}
+
+	printf("State object cache benchmark, %u keys of %zu bytes, %u hardware threads\n\n", numKeys, keys[0].GetBytes().size(),
+		thread::hardware_concurrency());
+	printf("%-8s %26s %26s %10s\n", "Threads", "Sharded cache", "One mutex, unordered_map", "Speedup");
+
+	for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		const double cacheMs = WarmLookups(cache, keys, numThreads, numLookupsPerThread);
+		const double lockedMs = WarmLookups(lockedMap, keys, numThreads, numLookupsPerThread);
+		const double numLookups = (double)numThreads * numLookupsPerThread;
+
+		printf("%-8u %12.1f ns %7.1fM/s %12.1f ns %7.1fM/s %9.2fx\n", numThreads,
+			cacheMs * 1.0e6 / numLookups, numLookups / (cacheMs * 1.0e3),
+			lockedMs * 1.0e6 / numLookups, numLookups / (lockedMs * 1.0e3),
+			lockedMs / cacheMs);
+	}
+
+	StateObjectCacheStats coldStats;
+	const double coldMs = ColdCreates(maxThreads, numColdKeys, 50, coldStats);
+	printf("\nCold start, %u threads on %u keys taking 50 us each:  %.1f ms, %llu creates, %llu waits, %llu hits\n",
+		maxThreads, numColdKeys, coldMs, (unsigned long long)coldStats.numCreates, (unsigned long long)coldStats.numWaits,
+		(unsigned long long)coldStats.numHits);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
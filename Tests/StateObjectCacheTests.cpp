@@ -0,0 +1,296 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+
+#include "Stdafx.h"
+
+#include "Graphics/StateObjectCache.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+using Value = shared_ptr<uint32_t>;
+using Cache = StateObjectCache<Value>;
+
+
+StateObjectKey MakeKey(uint32_t id, uint32_t numWords = 4)
+{
+	StateObjectKey key;
+	key.AppendString("Test PSO");
+	for (uint32_t i = 0; i < numWords; ++i)
+	{
+		key.Append(id * 7919u + i);
+	}
+	return key;
+}
+
+
+void TestKeys()
+{
+	StateObjectKey ab, c, a, bc;
+	ab.AppendString("ab");
+	ab.AppendString("c");
+	a.AppendString("a");
+	a.AppendString("bc");
+	Check(ab.GetBytes().size() == a.GetBytes().size(), "split strings make keys of the same size");
+	Check(!equal(ab.GetBytes().begin(), ab.GetBytes().end(), a.GetBytes().begin()), "strings are length-prefixed");
+
+	Check(MakeKey(1).GetHash() == MakeKey(1).GetHash(), "equal keys hash the same");
+	Check(MakeKey(1).GetHash() != MakeKey(2).GetHash(), "different keys hash differently");
+
+	const uint32_t values[] = { 1, 2, 3 };
+	StateObjectKey array, scalars;
+	array.Append(values, size(values));
+	for (uint32_t value : values)
+	{
+		scalars.Append(value);
+	}
+	Check(array.GetHash() == scalars.GetHash(), "arrays append the same bytes as their elements");
+}
+
+
+void TestFindOrCreate()
+{
+	Cache cache{ 4 };
+
+	uint32_t numCreated{ 0 };
+	auto Create = [&numCreated](uint32_t value) { return [&numCreated, value] { ++numCreated; return make_shared<uint32_t>(value); }; };
+
+	const Value first = cache.FindOrCreate(MakeKey(1), Create(1));
+	const Value again = cache.FindOrCreate(MakeKey(1), Create(100));
+	const Value second = cache.FindOrCreate(MakeKey(2), Create(2));
+
+	Check(first && *first == 1 && again == first, "a cached object is returned for an equal key");
+	Check(second && *second == 2, "a different key gets its own object");
+	Check(numCreated == 2, "each key is created once");
+
+	const StateObjectCacheStats stats = cache.GetStats();
+	Check(stats.numLookups == 3 && stats.numHits == 1 && stats.numCreates == 2 && stats.numEntries == 2, "stats count lookups, hits and creates");
+	Check(stats.GetHitRate() == 1.0f / 3.0f, "hit rate is hits over lookups");
+
+	StateObjectCacheStats total = stats;
+	total += stats;
+	Check(total.numLookups == 6 && total.numEntries == 4, "stats add up");
+}
+
+
+// Keys that share a full hash are still compared in full
+void TestCollisions()
+{
+	Cache cache{ 1 };
+
+	const uint32_t numKeys = 100;
+	const uint64_t sharedHash = 0x1234'5678'9ABC'DEF0ull;
+
+	for (uint32_t i = 0; i < numKeys; ++i)
+	{
+		// Half the keys share one hash, and the rest share the low bits of it, so they land in the same probe run
+		const uint64_t hash = (i % 2 == 0) ? sharedHash : sharedHash + ((uint64_t)i << 40);
+		cache.FindOrCreate(hash, MakeKey(i, 1 + i % 5), [i] { return make_shared<uint32_t>(i); });
+	}
+
+	bool isCorrect = true;
+	for (uint32_t i = 0; i < numKeys; ++i)
+	{
+		const uint64_t hash = (i % 2 == 0) ? sharedHash : sharedHash + ((uint64_t)i << 40);
+		const Value value = cache.FindOrCreate(hash, MakeKey(i, 1 + i % 5), [] { return make_shared<uint32_t>(~0u); });
+		isCorrect = isCorrect && value && *value == i;
+	}
+	Check(isCorrect, "keys that share a hash keep their own objects, through growth of the table");
+
+	const StateObjectCacheStats stats = cache.GetStats();
+	Check(stats.numEntries == numKeys && stats.numCreates == numKeys, "colliding keys are each created once");
+	Check(stats.numCollisions > 0, "collisions are counted");
+
+	// A key that was never inserted walks the whole colliding run, and misses
+	bool isCreated = false;
+	cache.FindOrCreate(sharedHash, MakeKey(numKeys), [&isCreated] { isCreated = true; return make_shared<uint32_t>(0); });
+	Check(isCreated, "a new key with a colliding hash is created");
+}
+
+
+void TestFailures()
+{
+	Cache cache;
+
+	// Null is not cached, so the next lookup tries again
+	Check(!cache.FindOrCreate(MakeKey(1), [] { return Value{}; }), "a failed creation returns null");
+	const Value retried = cache.FindOrCreate(MakeKey(1), [] { return make_shared<uint32_t>(1); });
+	Check(retried && *retried == 1, "a failed creation is retried");
+
+	// Exceptions reach the caller, and the entry is retried as well
+	bool isThrown = false;
+	try
+	{
+		cache.FindOrCreate(MakeKey(2), []() -> Value { throw runtime_error("compile error"); });
+	}
+	catch (const runtime_error&)
+	{
+		isThrown = true;
+	}
+	Check(isThrown, "exceptions from creation reach the caller");
+
+	const Value afterThrow = cache.FindOrCreate(MakeKey(2), [] { return make_shared<uint32_t>(2); });
+	Check(afterThrow && *afterThrow == 2, "a creation that threw is retried");
+
+	const StateObjectCacheStats stats = cache.GetStats();
+	Check(stats.numFailures == 2 && stats.numCreates == 4 && stats.numEntries == 2, "failures are counted");
+}
+
+
+// A createFunction that asks for its own key, as it might through a shared helper, gets an object of its own
+// rather than waiting on itself
+void TestSelfWait()
+{
+	Cache cache;
+
+	Value inner;
+	const Value outer = cache.FindOrCreate(MakeKey(1), [&]
+		{
+			inner = cache.FindOrCreate(MakeKey(1), [] { return make_shared<uint32_t>(2); });
+			return make_shared<uint32_t>(1);
+		});
+
+	Check(inner && *inner == 2, "a nested request for the key being created gets its own object");
+	Check(outer && *outer == 1, "the outer creation is the one cached");
+	Check(cache.FindOrCreate(MakeKey(1), [] { return Value{}; }) == outer, "later lookups get the cached object");
+}
+
+
+// A thread waiting on an object another thread is creating blocks, rather than running queued jobs.  A job run
+// there could need the object itself, further down the waiting thread's stack.
+void TestWaitersDontRunJobs()
+{
+	JobSystem jobSystem{ 1 };
+	Cache cache;
+
+	atomic<bool> isCreating{ true };
+	atomic<bool> jobRanWhileCreating{ false };
+	JobHandle waiter;
+	JobHandle bystander;
+
+	const Value value = cache.FindOrCreate(MakeKey(1), [&]
+		{
+			// The only worker waits on this object
+			waiter = jobSystem.Schedule([&] { cache.FindOrCreate(MakeKey(1), [] { return make_shared<uint32_t>(2); }); });
+			while (cache.GetStats().numWaits == 0)
+			{
+				this_thread::yield();
+			}
+
+			// Nothing else can run this job while the worker waits, unless the worker runs it
+			bystander = jobSystem.Schedule([&] { jobRanWhileCreating = isCreating.load(); });
+			this_thread::sleep_for(chrono::milliseconds(20));
+
+			isCreating = false;
+			return make_shared<uint32_t>(1);
+		});
+
+	jobSystem.Wait(waiter);
+	jobSystem.Wait(bystander);
+
+	Check(value && *value == 1, "the object is created");
+	Check(!jobRanWhileCreating, "a waiting thread runs no jobs");
+	Check(cache.GetStats().numCreates == 1 && cache.GetStats().numWaits == 1, "the waiter got the published object");
+}
+
+
+// Many threads asking for the same keys at once, with a job system underneath, as a level load does.  Every
+// key is created exactly once, and every thread sees the same object for it.
+void TestContention(mt19937& rng)
+{
+	const uint32_t numThreads = 16;
+	const uint32_t numKeys = 256;
+	const uint32_t numLookupsPerThread = 4000;
+
+	JobSystem jobSystem{ 3 };
+	Cache cache;
+
+	vector<atomic<uint32_t>> numCreated(numKeys);
+	vector<atomic<uintptr_t>> objects(numKeys);
+	atomic<uint32_t> numMismatches{ 0 };
+
+	vector<uint32_t> seeds(numThreads);
+	for (auto& seed : seeds)
+	{
+		seed = rng();
+	}
+
+	vector<thread> threads;
+	for (uint32_t t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&, t]
+			{
+				mt19937 threadRng{ seeds[t] };
+				for (uint32_t i = 0; i < numLookupsPerThread; ++i)
+				{
+					const uint32_t id = threadRng() % numKeys;
+					const Value value = cache.FindOrCreate(MakeKey(id), [&, id]
+						{
+							numCreated[id].fetch_add(1);
+
+							// Slow creation, with nested parallel work, so other threads pile up on the same key
+							atomic<uint32_t> sum{ 0 };
+							jobSystem.ParallelFor(8, 1, [&sum](uint32_t j) { sum.fetch_add(j); });
+							this_thread::yield();
+
+							return make_shared<uint32_t>(id + sum.load() - 28);
+						});
+
+					uintptr_t expected{ 0 };
+					const uintptr_t address = (uintptr_t)value.get();
+					if (!value || *value != id || (!objects[id].compare_exchange_strong(expected, address) && expected != address))
+					{
+						numMismatches.fetch_add(1);
+					}
+				}
+			});
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	const StateObjectCacheStats stats = cache.GetStats();
+	Check(all_of(numCreated.begin(), numCreated.end(), [](const atomic<uint32_t>& count) { return count.load() == 1; }),
+		"every contended key is created exactly once");
+	Check(numMismatches == 0, "every thread sees the one cached object for a key");
+	Check(stats.numLookups == numThreads * numLookupsPerThread && stats.numEntries == numKeys && stats.numCreates == numKeys,
+		"contended stats add up");
+	Check(stats.numHits == stats.numLookups - numKeys, "every lookup but the creating ones is a hit");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestKeys();
+	TestFindOrCreate();
+	TestCollisions();
+	TestFailures();
+	TestSelfWait();
+	TestWaitersDontRunJobs();
+	TestContention(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "FileSystem.h"
+#include "Graphics/Loaders/TextureCache.h"
+
+#include "Benchmark.h"
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+const filesystem::path s_rootPath = filesystem::temp_directory_path() / "LunaTextureCacheTests";
+
+
+void WriteFile(const filesystem::path& filePath, size_t size, char fill)
+{
+	filesystem::create_directories(filePath.parent_path());
+	const string data(size, fill);
+	ofstream(filePath, ios::out | ios::binary).write(data.data(), (streamsize)data.size());
+}
+
+
+string MakeCacheFilename(const filesystem::path& sourcePath, TextureUsage usage, bool forceSrgb)
+{
+	TextureCacheKey key;
+	return MakeTextureCacheKey(sourcePath.string(), usage, forceSrgb, key) ? GetTextureCacheFilename(key) : string{};
+}
+
+
+void TestKey()
+{
+	const filesystem::path sourcePath = s_rootPath / "Textures" / "Brick.png";
+	WriteFile(sourcePath, 1000, 'a');
+
+	TextureCacheKey key;
+	Check(MakeTextureCacheKey(sourcePath.string(), TextureUsage::Albedo, true, key), "a key is made for an existing file");
+	Check(key.sourcePath == sourcePath.string() && key.sourceSize == 1000 && key.usage == TextureUsage::Albedo && key.forceSrgb, "the key holds the file and load parameters");
+	Check(!MakeTextureCacheKey((s_rootPath / "Missing.png").string(), TextureUsage::Albedo, true, key), "a missing file has no key");
+
+	const string filename = MakeCacheFilename(sourcePath, TextureUsage::Albedo, true);
+	const filesystem::path filenamePath{ filename };
+	Check(filenamePath.parent_path() == GetFileSystem()->GetCachePath(), "cache files go in the cache directory");
+	Check(filenamePath.extension() == ".dds" && filenamePath.stem().string().size() == string("Brick.").size() + 16
+		&& filenamePath.stem().string().starts_with("Brick."), "cache files are named after the source, its hash, and .dds");
+	Check(MakeCacheFilename(sourcePath, TextureUsage::Albedo, true) == filename, "the same source and parameters give the same cache file");
+
+	// Each load parameter picks a different cache file
+	Check(MakeCacheFilename(sourcePath, TextureUsage::AlbedoHighQuality, true) != filename, "the usage is part of the key");
+	Check(MakeCacheFilename(sourcePath, TextureUsage::Albedo, false) != filename, "forceSrgb is part of the key");
+
+	// The same contents at another path are cached separately, since paths are how sources are told apart
+	const filesystem::path otherPath = s_rootPath / "Other" / "Brick.png";
+	WriteFile(otherPath, 1000, 'a');
+	Check(MakeCacheFilename(otherPath, TextureUsage::Albedo, true) != filename, "the source path is part of the key");
+}
+
+
+// Editing the source must never load the old cache file
+void TestInvalidation()
+{
+	const filesystem::path sourcePath = s_rootPath / "Textures" / "Stone.png";
+	WriteFile(sourcePath, 1000, 'a');
+	const string original = MakeCacheFilename(sourcePath, TextureUsage::Albedo, false);
+
+	// A different size
+	WriteFile(sourcePath, 1001, 'a');
+	const string resized = MakeCacheFilename(sourcePath, TextureUsage::Albedo, false);
+	Check(resized != original, "a source that changes size is rebuilt");
+
+	// The same size, saved later
+	const auto writeTime = filesystem::last_write_time(sourcePath);
+	WriteFile(sourcePath, 1001, 'b');
+	filesystem::last_write_time(sourcePath, writeTime + chrono::seconds(2));
+	const string edited = MakeCacheFilename(sourcePath, TextureUsage::Albedo, false);
+	Check(edited != resized && edited != original, "a source that is saved again is rebuilt");
+
+	// Putting the old timestamp back on the same contents finds the old cache file again
+	filesystem::last_write_time(sourcePath, writeTime);
+	Check(MakeCacheFilename(sourcePath, TextureUsage::Albedo, false) == resized, "an unchanged source keeps its cache file");
+}
+
+
+void TestWrite()
+{
+	const filesystem::path sourcePath = s_rootPath / "Textures" / "Moss.png";
+	WriteFile(sourcePath, 500, 'm');
+	const string filename = MakeCacheFilename(sourcePath, TextureUsage::NormalMap, false);
+
+	filesystem::remove_all(GetFileSystem()->GetCachePath());
+
+	vector<std::byte> ddsData(300);
+	for (size_t i = 0; i < ddsData.size(); ++i)
+	{
+		ddsData[i] = (std::byte)i;
+	}
+
+	Check(WriteTextureCache(filename, ddsData), "the cache file is written, creating the cache directory");
+
+	ifstream file(filename, ios::in | ios::binary);
+	vector<std::byte> readBack(ddsData.size() + 1);
+	file.read((char*)readBack.data(), (streamsize)readBack.size());
+	readBack.resize((size_t)file.gcount());
+	Check(readBack == ddsData, "the cache file holds exactly the data written");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	filesystem::remove_all(s_rootPath);
+	filesystem::create_directories(s_rootPath);
+
+	FileSystem fileSystem{ "LunaTextureCacheTests" };
+	fileSystem.SetRootPath(s_rootPath);
+
+	TestKey();
+	TestInvalidation();
+	TestWrite();
+
+	filesystem::remove_all(s_rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
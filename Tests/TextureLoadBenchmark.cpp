@@ -0,0 +1,213 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/BlockCompressor.h"
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureInitializer.h"
+#include "Graphics/TextureLoadQueue.h"
+
+#include "MappedFile.h"
+
+#include "Benchmark.h"
+
+#include <random>
+#include <thread>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+const filesystem::path s_rootPath = filesystem::temp_directory_path() / "LunaTextureLoadBenchmark";
+
+
+// stb_image isn't part of the headless build, so the images are stored decoded:  the width and height, followed
+// by tightly packed RGBA8 texels.  Reading one maps the file, which stands in for the decode.
+struct ImageHeader
+{
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+};
+
+
+// Smooth colour with some noise, with a translucent alpha in every third image so both BC1 and BC3 are timed
+vector<filesystem::path> WriteImages(uint32_t numImages, uint32_t size)
+{
+	mt19937 rng{ 1234 };
+
+	filesystem::create_directories(s_rootPath);
+
+	vector<filesystem::path> fileNames;
+	for (uint32_t i = 0; i < numImages; ++i)
+	{
+		const ImageHeader header{ .width = size >> (i % 2), .height = size };
+		const bool isTranslucent = (i % 3) == 0;
+
+		vector<uint8_t> texels((size_t)header.width * header.height * 4);
+		for (uint32_t y = 0; y < header.height; ++y)
+		{
+			for (uint32_t x = 0; x < header.width; ++x)
+			{
+				const double u = (double)x / header.width + i * 0.1;
+				const double v = (double)y / header.height;
+				const double rgba[4]{
+					0.5 + 0.3 * sin(u * 23.0) + 0.1 * sin(v * 31.0),
+					0.5 + 0.3 * sin(v * 17.0) * cos(u * 13.0),
+					0.4 + 0.3 * cos((u + v) * 19.0),
+					isTranslucent ? 0.6 + 0.3 * sin(u * 11.0) * sin(v * 9.0) : 1.0 };
+
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const double noise = c < 3 ? (double)(rng() % 9) - 4.0 : 0.0;
+					texels[((size_t)y * header.width + x) * 4 + c] = (uint8_t)clamp(rgba[c] * 255.0 + noise, 0.0, 255.0);
+				}
+			}
+		}
+
+		fileNames.push_back(s_rootPath / ("Image" + to_string(i) + ".rgba"));
+		ofstream file(fileNames.back(), ios::out | ios::binary);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)texels.data(), (streamsize)texels.size());
+	}
+	return fileNames;
+}
+
+
+// The CPU side of LoadTextureFromFile() for an albedo texture:  read, scan for translucency, build the mip chain
+// with the Lanczos filter and block-compress it.  Returns the compressed levels, or nothing on failure.
+vector<std::byte> LoadImage(const filesystem::path& fileName)
+{
+	MappedFile file{ fileName.string() };
+	if (!file.IsOpen() || file.GetSize() < sizeof(ImageHeader))
+	{
+		return {};
+	}
+
+	ImageHeader header;
+	memcpy(&header, file.GetData(), sizeof(header));
+
+	const std::byte* imageData = file.GetData() + sizeof(header);
+	const size_t numBytes = (size_t)header.width * header.height * 4;
+	if (file.GetSize() - sizeof(header) < numBytes)
+	{
+		return {};
+	}
+
+	bool hasTranslucency = false;
+	for (size_t i = 3; i < numBytes && !hasTranslucency; i += 4)
+	{
+		hasTranslucency = imageData[i] != std::byte{ 0xFF };
+	}
+
+	const MipGenerationDesc mipDesc{
+		.format		= Format::RGBA8_UNorm,
+		.width		= header.width,
+		.height		= header.height,
+		.filter		= MipFilter::Lanczos
+	};
+
+	vector<std::byte> mipData;
+	TextureInitializer mipInit;
+	if (!GenerateMipChain(mipDesc, imageData, mipData, mipInit))
+	{
+		return {};
+	}
+
+	const BlockCompressionDesc compressionDesc{ .format = GetBlockCompressedFormat(TextureUsage::Albedo, hasTranslucency, false) };
+
+	vector<std::byte> compressedData;
+	TextureInitializer compressedInit;
+	if (!CompressTexture(compressionDesc, mipInit, compressedData, compressedInit))
+	{
+		return {};
+	}
+	return compressedData;
+}
+
+
+// One image after another on the calling thread, as a loading screen without LoadAsync() would
+void LoadSequential(const vector<filesystem::path>& fileNames, vector<vector<std::byte>>& outImages)
+{
+	for (size_t i = 0; i < fileNames.size(); ++i)
+	{
+		outImages[i] = LoadImage(fileNames[i]);
+	}
+}
+
+
+// Every image pushed through the queue LoadAsync() uses, then waited for, with the calling thread taking part
+void LoadQueued(TextureLoadQueue& queue, const vector<filesystem::path>& fileNames, vector<vector<std::byte>>& outImages)
+{
+	for (size_t i = 0; i < fileNames.size(); ++i)
+	{
+		queue.Push([&fileNames, &outImages, i] { outImages[i] = LoadImage(fileNames[i]); },
+			(TextureLoadPriority)(i % 3));
+	}
+	queue.Wait();
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numImages = commandLine.GetOption("--count", commandLine.Size(32, 6));
+	const uint32_t size = commandLine.GetOption("--size", commandLine.Size(512, 64));
+	const uint32_t numRuns = commandLine.Size(3, 1);
+
+	filesystem::remove_all(s_rootPath);
+	const auto fileNames = WriteImages(numImages, size);
+
+	uint64_t numTexels = 0;
+	for (uint32_t i = 0; i < numImages; ++i)
+	{
+		numTexels += (uint64_t)(size >> (i % 2)) * size;
+	}
+
+	vector<vector<std::byte>> sequentialImages(numImages);
+	const double sequentialMs = MeasureMs(numRuns, [&] { LoadSequential(fileNames, sequentialImages); });
+
+	JobSystem jobSystem{ max(thread::hardware_concurrency(), 1u) - 1 };
+	const uint32_t numThreads = jobSystem.GetNumWorkers() + 1;
+
+	// The sequential loads above ran with no job system, so their block compression ran on one thread too
+	vector<vector<std::byte>> queuedImages(numImages);
+	TextureLoadQueue queue;
+	const double queuedMs = MeasureMs(numRuns, [&] { LoadQueued(queue, fileNames, queuedImages); });
+
+	bool everyImageLoaded = true;
+	for (const auto& image : sequentialImages)
+	{
+		everyImageLoaded = everyImageLoaded && !image.empty();
+	}
+	Check(everyImageLoaded, "every image was read, mipped and compressed");
+	Check(sequentialImages == queuedImages, "the queue produces the same blocks as loading one after another");
+
+	printf("Texture load benchmark, %u images of up to %ux%u in %s, fastest of %u runs\n", numImages, size, size,
+		s_rootPath.string().c_str(), numRuns);
+	printf("Read, Lanczos mips and BC1/BC3 compression per image.  No PNG decode, since stb_image is not in the headless build.\n\n");
+	printf("%-28s %10s %12s %12s %8s\n", "Path", "Threads", "Time", "Images/s", "Speedup");
+	printf("%-28s %10u %9.2f ms %12.1f %7.1fx\n", "Sequential", 1u, sequentialMs, numImages * 1000.0 / sequentialMs, 1.0);
+	printf("%-28s %10u %9.2f ms %12.1f %7.1fx\n", "TextureLoadQueue", numThreads, queuedMs, numImages * 1000.0 / queuedMs,
+		sequentialMs / queuedMs);
+	printf("\n%.2f MPix/s sequential, %.2f MPix/s queued, across the source levels\n", numTexels / (sequentialMs * 1.0e3),
+		numTexels / (queuedMs * 1.0e3));
+
+	filesystem::remove_all(s_rootPath);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/TextureLoadQueue.h"
+
+#include "Benchmark.h"
+
+#include <stdexcept>
+#include <thread>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// Without a job system, LoadAsync() falls back to loading on the calling thread
+void TestInlineWithoutJobSystem()
+{
+	TextureLoadQueue queue;
+
+	uint32_t numLoaded = 0;
+	queue.Push([&numLoaded] { ++numLoaded; }, TextureLoadPriority::Low);
+	Check(numLoaded == 1, "the load ran inside Push() without a job system");
+	Check(queue.GetNumPending() == 0, "an inline load is never pending");
+
+	queue.Wait();
+	Check(numLoaded == 1, "Wait() without a job system returns at once");
+}
+
+
+// One worker, held on a first load while the rest are queued, then left to drain the queue on its own, so that
+// the order they run in is the order they were popped
+void TestPriorityOrder()
+{
+	JobSystem jobSystem{ 1 };
+	TextureLoadQueue queue;
+
+	atomic<bool> gateEntered{ false };
+	atomic<bool> gateOpen{ false };
+	queue.Push([&] {
+			gateEntered = true;
+			while (!gateOpen) { this_thread::yield(); }
+		});
+
+	while (!gateEntered) { this_thread::yield(); }
+
+	mutex orderMutex;
+	vector<uint32_t> order;
+	auto pushLoad = [&](uint32_t id, TextureLoadPriority priority)
+		{
+			queue.Push([&, id] { lock_guard lock(orderMutex); order.push_back(id); }, priority);
+		};
+
+	pushLoad(0, TextureLoadPriority::Low);
+	pushLoad(1, TextureLoadPriority::High);
+	pushLoad(2, TextureLoadPriority::Normal);
+	pushLoad(3, TextureLoadPriority::Low);
+	pushLoad(4, TextureLoadPriority::High);
+	pushLoad(5, TextureLoadPriority::Normal);
+
+	Check(queue.GetNumPending() == 7, "every load is pending while the first one is held");
+
+	gateOpen = true;
+	while (queue.GetNumPending() != 0) { this_thread::yield(); }
+	queue.Wait();
+
+	Check(order == vector<uint32_t>{ 1, 4, 2, 5, 0, 3 }, "loads run highest priority first, oldest first within a priority");
+}
+
+
+// Many loads from several threads at once, with Wait() on the calling thread taking part
+void TestManyLoads(uint32_t numLoads)
+{
+	JobSystem jobSystem{ 3 };
+	TextureLoadQueue queue;
+
+	vector<atomic<uint32_t>> numRuns(numLoads);
+	vector<thread> producers;
+	for (uint32_t p = 0; p < 4; ++p)
+	{
+		producers.emplace_back([&queue, &numRuns, p, numLoads] {
+				for (uint32_t i = p; i < numLoads; i += 4)
+				{
+					queue.Push([&numRuns, i] { numRuns[i].fetch_add(1); }, (TextureLoadPriority)(i % 3));
+				}
+			});
+	}
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	queue.Wait();
+
+	bool everyLoadRanOnce = queue.GetNumPending() == 0;
+	for (const auto& count : numRuns)
+	{
+		everyLoadRanOnce = everyLoadRanOnce && count == 1;
+	}
+	Check(everyLoadRanOnce, "every load ran exactly once, and none are pending after Wait()");
+}
+
+
+// The queue is a TextureManager member, so it must not be destroyed while a load that touches the manager runs
+void TestDestructorWaits()
+{
+	JobSystem jobSystem{ 2 };
+
+	atomic<uint32_t> numLoaded{ 0 };
+	{
+		TextureLoadQueue queue;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			queue.Push([&numLoaded] {
+					this_thread::sleep_for(chrono::microseconds(200));
+					numLoaded.fetch_add(1);
+				});
+		}
+	}
+	Check(numLoaded == 16, "destroying the queue waits for its loads");
+}
+
+// A load that throws is no longer pending, and the exception reaches Wait() rather than the worker
+void TestThrowingLoad()
+{
+	JobSystem jobSystem{ 2 };
+	TextureLoadQueue queue;
+
+	atomic<uint32_t> numLoaded{ 0 };
+	queue.Push([] { throw runtime_error("corrupt texture"); });
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		queue.Push([&numLoaded] { numLoaded.fetch_add(1); });
+	}
+
+	string message;
+	try
+	{
+		queue.Wait();
+	}
+	catch (const exception& e)
+	{
+		message = e.what();
+	}
+
+	Check(message == "corrupt texture", "Wait() rethrows the exception of a load that threw");
+	Check(numLoaded == 8 && queue.GetNumPending() == 0, "the other loads ran, and none are pending");
+
+	queue.Push([&numLoaded] { numLoaded.fetch_add(1); });
+	bool waitedCleanly = true;
+	try
+	{
+		queue.Wait();
+	}
+	catch (...)
+	{
+		waitedCleanly = false;
+	}
+	Check(waitedCleanly && numLoaded == 9, "the failure is only reported once, and the queue carries on");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	TestInlineWithoutJobSystem();
+	TestPriorityOrder();
+	TestManyLoads(4000);
+	TestDestructorWaits();
+	TestThrowingLoad();
+
+	return FailureCount() == 0 ? 0 : 1;
+}
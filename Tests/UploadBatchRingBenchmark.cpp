@@ -0,0 +1,182 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/UploadBatchRing.h"
+
+#include "Benchmark.h"
+
+#include <thread>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+using Clock = chrono::steady_clock;
+
+
+// Stands in for the graphics queue.  Each submission completes a fixed latency after the previous one finishes,
+// plus a cost per request, so the GPU is modelled as a timeline rather than a thread that would compete with the
+// one recording on a small machine.
+class FakeGpuQueue
+{
+public:
+	FakeGpuQueue(chrono::nanoseconds submitLatency, chrono::nanoseconds requestCost)
+		: m_submitLatency{ submitLatency }
+		, m_requestCost{ requestCost }
+	{}
+
+	uint64_t Submit(uint32_t numRequests)
+	{
+		m_lastCompletion = max(Clock::now(), m_lastCompletion) + m_submitLatency + numRequests * m_requestCost;
+		m_completionTimes.push_back(m_lastCompletion);
+		++m_numSubmits;
+		return m_completionTimes.size();
+	}
+
+	bool IsFenceComplete(uint64_t fenceValue) const
+	{
+		return Clock::now() >= m_completionTimes[fenceValue - 1];
+	}
+
+	void WaitForFence(uint64_t fenceValue) const
+	{
+		while (!IsFenceComplete(fenceValue))
+		{
+			this_thread::yield();
+		}
+	}
+
+	uint64_t GetNumSubmits() const noexcept { return m_numSubmits; }
+
+private:
+	const chrono::nanoseconds m_submitLatency;
+	const chrono::nanoseconds m_requestCost;
+	vector<Clock::time_point> m_completionTimes;
+	Clock::time_point m_lastCompletion{};
+	uint64_t m_numSubmits{ 0 };
+};
+
+
+struct UploadRun
+{
+	double ms{ 0.0 };
+	uint64_t numBatches{ 0 };
+	uint64_t numRingStalls{ 0 };
+};
+
+
+// Records numUploads buffer initializations the way UploadQueue does: copy the data to upload memory, add the
+// request to the open batch, and submit the batch once it holds maxBatchRequests.  With waitForEach, every upload
+// is submitted and waited on by itself, which is what resource creation did before batching.
+UploadRun TimeUploads(uint32_t numUploads, uint32_t uploadSize, uint32_t maxBatchRequests, bool waitForEach, uint32_t numRuns,
+	chrono::nanoseconds submitLatency, chrono::nanoseconds requestCost)
+{
+	const vector<uint8_t> data(uploadSize, 0x5a);
+	vector<uint8_t> uploadMemory(uploadSize * (size_t)(waitForEach ? 1 : maxBatchRequests));
+
+	UploadRun run;
+	uint32_t numReleased = 0;
+
+	run.ms = MeasureMs(numRuns, [&]
+		{
+			FakeGpuQueue queue{ submitLatency, requestCost };
+			UploadBatchRing ring;
+			uint64_t batchId = 1;
+			uint32_t numOpenRequests = 0;
+			vector<shared_ptr<const void>> openResources;
+			run.numRingStalls = 0;
+
+			auto retire = [&] { ring.Retire([&queue](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); }); };
+
+			auto closeBatch = [&]
+				{
+					while (const uint64_t fenceValue = ring.GetFenceToMakeRoom())
+					{
+						++run.numRingStalls;
+						queue.WaitForFence(fenceValue);
+						retire();
+					}
+
+					const uint64_t fenceValue = queue.Submit(numOpenRequests);
+					ring.Push(batchId++, fenceValue).resources = move(openResources);
+					openResources.clear();
+					numOpenRequests = 0;
+					return fenceValue;
+				};
+
+			for (uint32_t i = 0; i < numUploads; ++i)
+			{
+				// Stands in for the destination resource, and counts its release when the batch retires
+				auto resource = shared_ptr<const void>(data.data(), [&numReleased](const void*) { ++numReleased; });
+
+				memcpy(uploadMemory.data() + (size_t)numOpenRequests * uploadSize, data.data(), uploadSize);
+				openResources.push_back(move(resource));
+				++numOpenRequests;
+
+				if (waitForEach)
+				{
+					queue.WaitForFence(closeBatch());
+					retire();
+				}
+				else if (numOpenRequests == maxBatchRequests)
+				{
+					closeBatch();
+				}
+			}
+
+			if (numOpenRequests > 0)
+			{
+				closeBatch();
+			}
+			while (!ring.IsEmpty())
+			{
+				queue.WaitForFence(ring.Oldest().fenceValue);
+				retire();
+			}
+
+			run.numBatches = queue.GetNumSubmits();
+		});
+
+	Check(numReleased == numUploads * max(numRuns, 1u), "every uploaded resource is released once its batch retires");
+	Check(run.numBatches == (waitForEach ? numUploads : (numUploads + maxBatchRequests - 1) / maxBatchRequests), "uploads are split into the expected batches");
+	return run;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numUploads = commandLine.Size(20000, 500);
+	const uint32_t uploadSize = commandLine.GetOption("--size", 4096);
+	const uint32_t maxBatchRequests = commandLine.GetOption("--batch", 64);
+	const uint32_t numRuns = commandLine.Size(5, 1);
+	const chrono::microseconds submitLatency{ commandLine.GetOption("--latency-us", 30) };
+	const chrono::nanoseconds requestCost{ commandLine.GetOption("--request-ns", 200) };
+
+	const UploadRun waitForEach = TimeUploads(numUploads, uploadSize, 1, true, numRuns, submitLatency, requestCost);
+	const UploadRun batched = TimeUploads(numUploads, uploadSize, maxBatchRequests, false, numRuns, submitLatency, requestCost);
+
+	printf("Upload batch benchmark: %u buffers of %u bytes, %lld us per submission, %lld ns per request, fastest of %u runs\n\n",
+		numUploads, uploadSize, (long long)submitLatency.count(), (long long)requestCost.count(), numRuns);
+	printf("  Wait for each:  %8.2f ms, %llu batches\n", waitForEach.ms, (unsigned long long)waitForEach.numBatches);
+	printf("  Batched by %-3u %8.2f ms, %llu batches, %llu ring stalls, %.1fx\n", maxBatchRequests, batched.ms,
+		(unsigned long long)batched.numBatches, (unsigned long long)batched.numRingStalls, waitForEach.ms / batched.ms);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/UploadBatchRing.h"
+
+#include "Benchmark.h"
+
+#include <deque>
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+// The graphics queue's fence, advanced by hand.  Signal() hands out the value the next submission will reach, and
+// Complete() plays the GPU catching up.
+struct FakeFence
+{
+	uint64_t nextValue{ 1 };
+	uint64_t completedValue{ 0 };
+
+	uint64_t Signal() { return nextValue++; }
+	void Complete(uint64_t value) { completedValue = max(completedValue, value); }
+};
+
+
+// Pushes a batch holding one resource, and returns a weak reference to it, which expires once the ring lets go
+weak_ptr<const void> PushBatch(UploadBatchRing& ring, uint64_t batchId, uint64_t fenceValue)
+{
+	auto resource = make_shared<const uint64_t>(batchId);
+	ring.Push(batchId, fenceValue).resources.push_back(resource);
+	return resource;
+}
+
+
+void TestRetire()
+{
+	UploadBatchRing ring;
+	FakeFence fence;
+
+	Check(ring.IsEmpty() && ring.GetCount() == 0, "a new ring is empty");
+	Check(ring.FindFence(1) == 0, "an empty ring has no fences");
+
+	const uint64_t first = fence.Signal();
+	auto a = PushBatch(ring, 1, first);
+	const uint64_t second = fence.Signal();
+	auto b = PushBatch(ring, 2, second);
+	auto c = PushBatch(ring, 3, fence.Signal());
+
+	Check(ring.GetCount() == 3 && ring.Oldest().batchId == 1, "batches are pushed in order");
+	Check(ring.FindFence(1) == first && ring.FindFence(2) == second, "submitted batches report their fences");
+	Check(!a.expired() && !b.expired() && !c.expired(), "submitted batches hold their resources");
+
+	Check(ring.Retire(fence.completedValue) == 0, "nothing is retired before its fence");
+
+	fence.Complete(first);
+	Check(ring.Retire(fence.completedValue) == 1, "a batch is retired once its fence completes");
+	Check(a.expired() && !b.expired(), "a retired batch releases its resources");
+	Check(ring.FindFence(1) == 0, "a retired batch has no fence");
+	Check(ring.Oldest().batchId == 2, "the next batch becomes the oldest");
+
+	fence.Complete(fence.nextValue - 1);
+	Check(ring.Retire(fence.completedValue) == 2, "a later fence retires everything before it");
+	Check(ring.Retire(fence.completedValue) == 0, "batches are retired once");
+	Check(ring.IsEmpty() && b.expired() && c.expired(), "the ring is empty and holds nothing");
+}
+
+
+// Fence values from different queues need not complete in order, so retirement always stops at the oldest batch
+// still pending, even when newer ones are done
+void TestRetireStopsAtPending()
+{
+	UploadBatchRing ring;
+
+	auto a = PushBatch(ring, 1, 10);
+	auto b = PushBatch(ring, 2, 20);
+	auto c = PushBatch(ring, 3, 30);
+
+	auto isComplete = [](uint64_t fenceValue) { return fenceValue != 10; };
+	Check(ring.Retire(isComplete) == 0, "retirement stops at the oldest pending batch");
+	Check(!b.expired() && !c.expired(), "completed batches behind a pending one are still held");
+
+	Check(ring.Retire([](uint64_t) { return true; }) == 3, "everything retires once the oldest batch completes");
+	Check(a.expired() && b.expired() && c.expired(), "every resource is released");
+}
+
+
+// Keeps a few batches in flight over many times the ring's size, so the head and tail wrap around repeatedly
+void TestWraparound()
+{
+	UploadBatchRing ring;
+	FakeFence fence;
+
+	const uint32_t numInFlight = UploadBatchRing::MaxBatchesInFlight - 3;
+	const uint64_t numBatches = 20 * UploadBatchRing::MaxBatchesInFlight + 3;
+
+	deque<pair<uint64_t, uint64_t>> expected;
+	for (uint64_t batchId = 1; batchId <= numBatches; ++batchId)
+	{
+		const uint64_t fenceValue = fence.Signal();
+		PushBatch(ring, batchId, fenceValue);
+		expected.emplace_back(batchId, fenceValue);
+
+		if (expected.size() > numInFlight)
+		{
+			fence.Complete(expected.front().second);
+			const uint32_t numRetired = ring.Retire(fence.completedValue);
+			expected.pop_front();
+
+			if (numRetired != 1)
+			{
+				Check(false, "one batch retires per completed fence across the wraparound");
+				return;
+			}
+		}
+
+		bool fencesMatch = ring.GetCount() == expected.size() && ring.Oldest().batchId == expected.front().first;
+		for (const auto& [id, value] : expected)
+		{
+			fencesMatch = fencesMatch && ring.FindFence(id) == value;
+		}
+		if (!fencesMatch)
+		{
+			Check(false, "the ring matches the batches in flight across the wraparound");
+			return;
+		}
+	}
+
+	Check(ring.FindFence(numBatches - numInFlight) == 0, "batches that wrapped out are retired");
+}
+
+
+// With a full ring, the caller waits on the oldest batch, retires it, and only then pushes the next one
+void TestFullRing()
+{
+	UploadBatchRing ring;
+	FakeFence fence;
+
+	vector<weak_ptr<const void>> resources;
+	for (uint64_t batchId = 1; batchId <= UploadBatchRing::MaxBatchesInFlight; ++batchId)
+	{
+		Check(ring.GetFenceToMakeRoom() == 0, "there is room until the ring is full");
+		resources.push_back(PushBatch(ring, batchId, fence.Signal()));
+	}
+
+	Check(ring.IsFull(), "the ring is full");
+	Check(ring.GetFenceToMakeRoom() == ring.Oldest().fenceValue, "a full ring waits on its oldest batch");
+
+	// What UploadQueue does when it needs to submit into a full ring
+	uint32_t numWaits = 0;
+	while (const uint64_t fenceValue = ring.GetFenceToMakeRoom())
+	{
+		if (++numWaits > UploadBatchRing::MaxBatchesInFlight)
+		{
+			break;
+		}
+		fence.Complete(fenceValue);
+		ring.Retire(fence.completedValue);
+	}
+
+	Check(numWaits == 1 && ring.GetCount() == UploadBatchRing::MaxBatchesInFlight - 1, "waiting for room retires one batch");
+	Check(resources[0].expired() && !resources[1].expired(), "only the oldest batch is released to make room");
+
+	const uint64_t nextId = UploadBatchRing::MaxBatchesInFlight + 1;
+	const uint64_t nextFence = fence.Signal();
+	resources.push_back(PushBatch(ring, nextId, nextFence));
+	Check(ring.IsFull() && ring.FindFence(nextId) == nextFence && ring.Oldest().batchId == 2, "the next batch goes in the freed slot");
+}
+
+
+// Random pushes, partial fence completions and retirements, checked against a deque of the batches in flight
+void TestRandomSequences(mt19937& rng)
+{
+	for (uint32_t iteration = 0; iteration < 200; ++iteration)
+	{
+		UploadBatchRing ring;
+		FakeFence fence;
+		deque<tuple<uint64_t, uint64_t, weak_ptr<const void>>> expected;
+		uint64_t nextBatchId = 1;
+
+		const int numFailures = FailureCount();
+
+		for (uint32_t step = 0; step < 500; ++step)
+		{
+			const uint32_t action = rng() % 3;
+			if (action == 0 && ring.GetFenceToMakeRoom() == 0)
+			{
+				// Batch ids can skip, as when a batch is closed empty
+				nextBatchId += 1 + rng() % 2;
+				const uint64_t fenceValue = fence.Signal();
+				expected.emplace_back(nextBatchId, fenceValue, PushBatch(ring, nextBatchId, fenceValue));
+			}
+			else if (action == 1 && fence.completedValue + 1 < fence.nextValue)
+			{
+				fence.Complete(fence.completedValue + 1 + rng() % (fence.nextValue - fence.completedValue - 1));
+			}
+			else
+			{
+				uint32_t expectedRetired = 0;
+				while (!expected.empty() && get<1>(expected.front()) <= fence.completedValue)
+				{
+					expected.pop_front();
+					++expectedRetired;
+				}
+				Check(ring.Retire(fence.completedValue) == expectedRetired, "the completed batches are retired");
+			}
+
+			Check(ring.GetCount() == expected.size(), "the ring holds the batches in flight");
+			Check(ring.IsFull() == (expected.size() == UploadBatchRing::MaxBatchesInFlight), "the ring is full at capacity");
+			for (const auto& [id, value, resource] : expected)
+			{
+				Check(ring.FindFence(id) == value && !resource.expired(), "batches in flight keep their fences and resources");
+			}
+
+			if (FailureCount() > numFailures)
+			{
+				fprintf(stderr, "random sequence %u failed at step %u\n", iteration, step);
+				return;
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestRetire();
+	TestRetireStopsAtPending();
+	TestWraparound();
+	TestFullRing();
+	TestRandomSequences(rng);
+
+	return FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/VertexEncoder.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+constexpr VertexComponent s_components = VertexComponent::Position | VertexComponent::Normal | VertexComponent::Tangent |
+	VertexComponent::Bitangent | VertexComponent::Color0 | VertexComponent::Texcoord0;
+
+
+// Vertices on a sphere of radius 10 around (100, 20, -50), with a tangent frame, a color and texcoords, laid out
+// as VertexLayout<s_components> would lay them out
+vector<float> MakeVertices(uint32_t numVertices, mt19937& rng)
+{
+	normal_distribution<float> normalDistribution;
+	uniform_real_distribution<float> unitDistribution{ 0.0f, 1.0f };
+
+	vector<float> vertices;
+	vertices.reserve((size_t)numVertices * 21);
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		float n[3] = { normalDistribution(rng), normalDistribution(rng), normalDistribution(rng) };
+		const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		for (float& value : n)
+		{
+			value /= length;
+		}
+
+		// A tangent around the y axis, and a bitangent that completes the frame
+		const float tangentLength = max(sqrtf(n[0] * n[0] + n[2] * n[2]), 1e-6f);
+		const float t[3] = { n[2] / tangentLength, 0.0f, -n[0] / tangentLength };
+		const float b[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+
+		vertices.insert(vertices.end(), {
+			100.0f + 10.0f * n[0], 20.0f + 10.0f * n[1], -50.0f + 10.0f * n[2],
+			n[0], n[1], n[2],
+			t[0], t[1], t[2],
+			b[0], b[1], b[2],
+			unitDistribution(rng), unitDistribution(rng), unitDistribution(rng), 1.0f,
+			4.0f * unitDistribution(rng), 4.0f * unitDistribution(rng) });
+	}
+	return vertices;
+}
+
+
+uint32_t GetStride(VertexComponent components, VertexEncoding encoding)
+{
+	uint32_t stride = 0;
+	for (uint32_t bit = 1; bit <= (uint32_t)components; bit <<= 1)
+	{
+		if (HasFlag(components, VertexComponent(bit)))
+		{
+			stride += GetVertexComponentSizeInBytes(VertexComponent(bit), encoding);
+		}
+	}
+	return stride;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+	const CommandLine commandLine{ argc, argv };
+
+	const uint32_t numVertices = commandLine.Size(1000000, 20000);
+	const uint32_t numRuns = commandLine.Size(5, 1);
+
+	mt19937 rng{ 1234 };
+	const vector<float> vertices = MakeVertices(numVertices, rng);
+	const uint32_t floatStride = VertexLayout<s_components>{}.GetNumFloats();
+	Check(vertices.size() == (size_t)numVertices * floatStride, "the float stream matches the layout");
+
+	struct Encoding
+	{
+		const char* name;
+		VertexEncoding encoding;
+	};
+
+	const Encoding encodings[] = {
+		{ "None", VertexEncoding::None },
+		{ "Half", VertexEncoding::PositionHalf | VertexEncoding::TexcoordHalf },
+		{ "Half + oct", VertexEncoding::PositionHalf | VertexEncoding::NormalOct16 | VertexEncoding::TangentOct16 | VertexEncoding::TexcoordHalf | VertexEncoding::ColorUNorm8 },
+		{ "Compact", VertexEncoding::Compact }
+	};
+
+	printf("Vertex encoding benchmark, position, normal, tangent, bitangent, color and texcoord, %u vertices, fastest of %u runs\n\n", numVertices, numRuns);
+	printf("%-12s %12s %8s %12s %16s\n", "Encoding", "Bytes/vert", "Ratio", "Encode", "Position error");
+
+	uint32_t floatBytes = 0;
+	for (const Encoding& encoding : encodings)
+	{
+		const uint32_t stride = GetStride(s_components, encoding.encoding);
+		if (encoding.encoding == VertexEncoding::None)
+		{
+			floatBytes = stride;
+		}
+
+		VertexDecodeParams decodeParams;
+		vector<std::byte> encoded;
+		const double encodeMs = MeasureMs(numRuns, [&]
+			{
+				decodeParams = ComputeVertexDecodeParams(vertices, s_components, encoding.encoding);
+				EncodeVertices(vertices, s_components, encoding.encoding, decodeParams, encoded);
+			});
+		Check(encoded.size() == (size_t)numVertices * stride, "the encoded stream has the layout's stride");
+
+		// Largest position error, relative to the mesh's 20 unit extent
+		vector<float> positions;
+		DecodePositions(encoded, stride, encoding.encoding, decodeParams, positions);
+		float maxError = 0.0f;
+		for (uint32_t i = 0; i < numVertices; ++i)
+		{
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				maxError = max(maxError, fabsf(positions[i * 3 + j] - vertices[(size_t)i * floatStride + j]));
+			}
+		}
+
+		printf("%-12s %12u %7.2fx %9.2f ms %15.2e\n", encoding.name, stride, (double)floatBytes / stride, encodeMs, maxError / 20.0f);
+		KeepResult(encoded.data());
+	}
+
+	return FailureCount() == 0 ? 0 : 1;
+}
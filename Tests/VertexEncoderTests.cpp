@@ -0,0 +1,462 @@
+//
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Author:  David Elder
+//
+
+#include "Stdafx.h"
+
+#include "Graphics/VertexEncoder.h"
+
+#include "Benchmark.h"
+
+#include <random>
+
+using namespace Luna;
+using namespace Luna::Benchmark;
+using namespace std;
+
+
+namespace
+{
+
+struct Vec3
+{
+	float x{ 0.0f };
+	float y{ 0.0f };
+	float z{ 0.0f };
+};
+
+
+float Dot(const Vec3& a, const Vec3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+Vec3 Cross(const Vec3& a, const Vec3& b)
+{
+	return Vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+
+Vec3 Normalize(const Vec3& a)
+{
+	const float length = sqrtf(Dot(a, a));
+	return Vec3{ a.x / length, a.y / length, a.z / length };
+}
+
+
+Vec3 RandomUnitVector(mt19937& rng)
+{
+	normal_distribution<float> distribution;
+	Vec3 v;
+	do
+	{
+		v = Vec3{ distribution(rng), distribution(rng), distribution(rng) };
+	} while (Dot(v, v) < 1e-6f);
+	return Normalize(v);
+}
+
+
+// The decoders below mirror the shaders, written independently of the encoder
+float DecodeHalf(uint16_t half)
+{
+	const float sign = (half & 0x8000) ? -1.0f : 1.0f;
+	const int exponent = (half >> 10) & 0x1F;
+	const int mantissa = half & 0x3FF;
+
+	if (exponent == 0)
+	{
+		return sign * ldexpf((float)mantissa, -24);
+	}
+	if (exponent == 31)
+	{
+		return mantissa == 0 ? sign * numeric_limits<float>::infinity() : numeric_limits<float>::quiet_NaN();
+	}
+	return sign * ldexpf((float)(mantissa | 0x400), exponent - 25);
+}
+
+
+float DecodeUNorm16(uint16_t value)
+{
+	return (float)value / 65535.0f;
+}
+
+
+float DecodeSNorm16(int16_t value)
+{
+	return max((float)value / 32767.0f, -1.0f);
+}
+
+
+Vec3 DecodeOctahedral(int16_t packedX, int16_t packedY)
+{
+	const float x = DecodeSNorm16(packedX);
+	const float y = DecodeSNorm16(packedY);
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+	const float t = max(-z, 0.0f);
+
+	return Normalize(Vec3{ x >= 0.0f ? x - t : x + t, y >= 0.0f ? y - t : y + t, z });
+}
+
+
+// Byte offset of a component in an encoded vertex, where components are laid out in bit order
+uint32_t GetByteOffset(VertexComponent components, VertexComponent component, VertexEncoding encoding)
+{
+	uint32_t offset = 0;
+	for (uint32_t bit = 1; bit < (uint32_t)component; bit <<= 1)
+	{
+		if (HasFlag(components, VertexComponent(bit)))
+		{
+			offset += GetVertexComponentSizeInBytes(VertexComponent(bit), encoding);
+		}
+	}
+	return offset;
+}
+
+
+template <typename T>
+T Load(const vector<std::byte>& encoded, size_t offset)
+{
+	T value;
+	memcpy(&value, encoded.data() + offset, sizeof(T));
+	return value;
+}
+
+
+void TestOctahedralNormals(mt19937& rng)
+{
+	constexpr VertexComponent components = VertexComponent::PositionNormal;
+	constexpr VertexEncoding encoding = VertexEncoding::NormalOct16;
+	const uint32_t stride = VertexLayout<components, encoding>{}.GetSizeInBytes();
+	const uint32_t normalOffset = GetByteOffset(components, VertexComponent::Normal, encoding);
+	Check(stride == 16 && normalOffset == 12, "an octahedral normal takes four bytes after a float position");
+
+	// The poles and axes, the corners of the folded lower hemisphere, the equator, and then random directions
+	const float d = 1.0f / sqrtf(3.0f);
+	vector<Vec3> normals{
+		{ 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 },
+		{ d, d, -d }, { -d, d, -d }, { d, -d, -d }, { -d, -d, -d },
+		{ d, d, d }, { -d, -d, d },
+		Normalize(Vec3{ 1e-4f, 1e-4f, -1.0f }), Normalize(Vec3{ -1e-4f, 1e-4f, -1.0f }),
+		Normalize(Vec3{ 1, 1, 0 }), Normalize(Vec3{ -1, 1, 1e-6f }), Normalize(Vec3{ 1, -1, -1e-6f })
+	};
+	for (uint32_t i = 0; i < 10000; ++i)
+	{
+		normals.push_back(RandomUnitVector(rng));
+	}
+
+	// Scaled normals are normalized before encoding
+	normals[2] = Vec3{ 5.0f, 0.0f, 0.0f };
+
+	vector<float> vertices;
+	for (const Vec3& normal : normals)
+	{
+		vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, normal.x, normal.y, normal.z });
+	}
+
+	vector<std::byte> encoded;
+	EncodeVertices(vertices, components, encoding, ComputeVertexDecodeParams(vertices, components, encoding), encoded);
+	Check(encoded.size() == normals.size() * stride, "the encoded stream has the layout's stride");
+
+	float minCosine = 1.0f;
+	float minLowerCosine = 1.0f;
+	for (size_t i = 0; i < normals.size(); ++i)
+	{
+		const size_t offset = i * stride + normalOffset;
+		const Vec3 decoded = DecodeOctahedral(Load<int16_t>(encoded, offset), Load<int16_t>(encoded, offset + 2));
+		const float cosine = Dot(decoded, Normalize(normals[i]));
+		minCosine = min(minCosine, cosine);
+		if (normals[i].z < 0.0f)
+		{
+			minLowerCosine = min(minLowerCosine, cosine);
+		}
+	}
+
+	// Half a step of 1/32767 in octahedral space is well under a hundredth of a degree
+	Check(minCosine >= 0.99999f, "octahedral normals round-trip within a hundredth of a degree");
+	Check(minLowerCosine >= 0.99999f, "octahedral normals in the folded lower hemisphere round-trip as well");
+
+	// The poles land exactly on the center and on the folded corners
+	Check(Load<int16_t>(encoded, normalOffset) == 0 && Load<int16_t>(encoded, normalOffset + 2) == 0, "the north pole encodes to the center");
+	Check(abs(Load<int16_t>(encoded, stride + normalOffset)) == 32767 && abs(Load<int16_t>(encoded, stride + normalOffset + 2)) == 32767,
+		"the south pole encodes to a corner");
+	const Vec3 southPole = DecodeOctahedral(Load<int16_t>(encoded, stride + normalOffset), Load<int16_t>(encoded, stride + normalOffset + 2));
+	Check(southPole.z == -1.0f, "the south pole decodes exactly");
+}
+
+
+void TestTangentHandedness(mt19937& rng)
+{
+	constexpr VertexComponent components = VertexComponent::Position | VertexComponent::Normal | VertexComponent::Tangent | VertexComponent::Bitangent;
+	constexpr VertexEncoding encoding = VertexEncoding::NormalOct16 | VertexEncoding::TangentOct16;
+	const uint32_t stride = VertexLayout<components, encoding>{}.GetSizeInBytes();
+	const uint32_t tangentOffset = GetByteOffset(components, VertexComponent::Tangent, encoding);
+	const uint32_t bitangentOffset = GetByteOffset(components, VertexComponent::Bitangent, encoding);
+	Check(stride == 12 + 4 + 8 + 4, "octahedral normal, tangent and bitangent take sixteen bytes");
+
+	// Random frames, half of them mirrored as on the far side of a UV seam
+	const uint32_t numVertices = 4096;
+	vector<float> vertices;
+	vector<float> handedness;
+	vector<Vec3> tangents;
+	vector<Vec3> bitangents;
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		const Vec3 normal = RandomUnitVector(rng);
+		const Vec3 tangent = Normalize(Cross(normal, RandomUnitVector(rng)));
+		const float sign = (i & 1) ? -1.0f : 1.0f;
+		const Vec3 crossProduct = Cross(normal, tangent);
+		const Vec3 bitangent{ crossProduct.x * sign, crossProduct.y * sign, crossProduct.z * sign };
+
+		vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, normal.x, normal.y, normal.z, tangent.x, tangent.y, tangent.z, bitangent.x, bitangent.y, bitangent.z });
+		handedness.push_back(sign);
+		tangents.push_back(tangent);
+		bitangents.push_back(bitangent);
+	}
+
+	vector<std::byte> encoded;
+	EncodeVertices(vertices, components, encoding, VertexDecodeParams{}, encoded);
+
+	bool handednessMatches = true;
+	bool wIsZero = true;
+	float minTangentCosine = 1.0f;
+	float minBitangentCosine = 1.0f;
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		const size_t offset = (size_t)i * stride + tangentOffset;
+		const Vec3 tangent = DecodeOctahedral(Load<int16_t>(encoded, offset), Load<int16_t>(encoded, offset + 2));
+		minTangentCosine = min(minTangentCosine, Dot(tangent, tangents[i]));
+		handednessMatches = handednessMatches && DecodeSNorm16(Load<int16_t>(encoded, offset + 4)) == handedness[i];
+		wIsZero = wIsZero && Load<int16_t>(encoded, offset + 6) == 0;
+
+		const size_t bitangentByte = (size_t)i * stride + bitangentOffset;
+		const Vec3 bitangent = DecodeOctahedral(Load<int16_t>(encoded, bitangentByte), Load<int16_t>(encoded, bitangentByte + 2));
+		minBitangentCosine = min(minBitangentCosine, Dot(bitangent, bitangents[i]));
+	}
+
+	Check(handednessMatches, "the tangent's z holds the sign of the bitangent against cross(normal, tangent)");
+	Check(wIsZero, "the tangent's w is zero");
+	Check(minTangentCosine >= 0.99999f && minBitangentCosine >= 0.99999f, "octahedral tangents and bitangents round-trip");
+
+	// Without a bitangent to compare against, every tangent is right handed
+	constexpr VertexComponent noBitangent = VertexComponent::Position | VertexComponent::Normal | VertexComponent::Tangent;
+	const uint32_t noBitangentStride = VertexLayout<noBitangent, encoding>{}.GetSizeInBytes();
+	vector<float> noBitangentVertices;
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		noBitangentVertices.insert(noBitangentVertices.end(), vertices.begin() + i * 12, vertices.begin() + i * 12 + 9);
+	}
+	EncodeVertices(noBitangentVertices, noBitangent, encoding, VertexDecodeParams{}, encoded);
+
+	bool allRightHanded = true;
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		allRightHanded = allRightHanded && Load<int16_t>(encoded, (size_t)i * noBitangentStride + tangentOffset + 4) == 32767;
+	}
+	Check(allRightHanded, "tangents are right handed without a bitangent");
+}
+
+
+void TestPositions(mt19937& rng)
+{
+	// A box that is wide in x, thin in y, far from the origin in z, and flat in w's place: every vertex has the
+	// same z in the second pass
+	for (bool flatZ : { false, true })
+	{
+		uniform_real_distribution<float> xDistribution{ -50.0f, 50.0f };
+		uniform_real_distribution<float> yDistribution{ 0.0f, 0.01f };
+		uniform_real_distribution<float> zDistribution{ 1000.0f, 1001.0f };
+
+		const uint32_t numVertices = 4096;
+		vector<float> vertices;
+		for (uint32_t i = 0; i < numVertices; ++i)
+		{
+			vertices.insert(vertices.end(), { xDistribution(rng), yDistribution(rng), flatZ ? 7.0f : zDistribution(rng) });
+		}
+
+		for (VertexEncoding encoding : { VertexEncoding::PositionHalf, VertexEncoding::PositionUNorm16 })
+		{
+			const bool isHalf = encoding == VertexEncoding::PositionHalf;
+			const uint32_t stride = isHalf ? VertexLayout<VertexComponent::Position, VertexEncoding::PositionHalf>{}.GetSizeInBytes() :
+				VertexLayout<VertexComponent::Position, VertexEncoding::PositionUNorm16>{}.GetSizeInBytes();
+			Check(stride == 8, "a range-normalized position takes eight bytes");
+
+			const VertexDecodeParams decodeParams = ComputeVertexDecodeParams(vertices, VertexComponent::Position, encoding);
+			vector<std::byte> encoded;
+			EncodeVertices(vertices, VertexComponent::Position, encoding, decodeParams, encoded);
+
+			vector<float> decoded;
+			DecodePositions(encoded, stride, encoding, decodeParams, decoded);
+			Check(decoded.size() == vertices.size(), "every position decodes");
+
+			// Half keeps 11 significant bits of [-1, 1], and UNorm16 a step of 1/65535 of [0, 1]
+			const float step = isHalf ? 1.0f / 2048.0f : 1.0f / 65535.0f;
+
+			bool withinError = true;
+			bool wIsOne = true;
+			bool decoderMatches = true;
+			for (uint32_t i = 0; i < numVertices; ++i)
+			{
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					const float value = vertices[i * 3 + j];
+					const float bound = fabsf(decodeParams.positionScale[j]) * step + fabsf(value) * 1e-5f + 1e-6f;
+					withinError = withinError && fabsf(decoded[i * 3 + j] - value) <= bound;
+
+					const uint16_t packed = Load<uint16_t>(encoded, (size_t)i * stride + j * 2);
+					const float shaderDecoded = (isHalf ? DecodeHalf(packed) : DecodeUNorm16(packed)) * decodeParams.positionScale[j] + decodeParams.positionOffset[j];
+					decoderMatches = decoderMatches && shaderDecoded == decoded[i * 3 + j];
+				}
+
+				const uint16_t w = Load<uint16_t>(encoded, (size_t)i * stride + 6);
+				wIsOne = wIsOne && (isHalf ? w == 0x3C00 : w == 0xFFFF);
+			}
+
+			Check(withinError, "positions round-trip within their encoding's step across the bounds");
+			Check(wIsOne, "the position's w is one");
+			Check(decoderMatches, "DecodePositions agrees with the shader's decode");
+
+			if (flatZ)
+			{
+				bool flatExact = decodeParams.positionScale[2] == 0.0f;
+				for (uint32_t i = 0; i < numVertices; ++i)
+				{
+					flatExact = flatExact && Load<uint16_t>(encoded, (size_t)i * stride + 4) == 0 && decoded[i * 3 + 2] == 7.0f;
+				}
+				Check(flatExact, "a flat axis encodes to zero and decodes exactly");
+			}
+		}
+	}
+
+	// Float positions pass straight through
+	const vector<float> floats{ 1.5f, -2.25f, 1e30f };
+	vector<std::byte> encoded;
+	EncodeVertices(floats, VertexComponent::Position, VertexEncoding::None, VertexDecodeParams{}, encoded);
+	vector<float> decoded;
+	DecodePositions(encoded, 12, VertexEncoding::None, VertexDecodeParams{}, decoded);
+	Check(decoded == floats, "float positions are copied unchanged");
+}
+
+
+void TestTexcoords(mt19937& rng)
+{
+	constexpr VertexComponent components = VertexComponent::Position | VertexComponent::Texcoord0 | VertexComponent::Texcoord1;
+	constexpr VertexEncoding encoding = VertexEncoding::TexcoordUNorm16;
+	const uint32_t stride = VertexLayout<components, encoding>{}.GetSizeInBytes();
+	const uint32_t texcoordOffset = GetByteOffset(components, VertexComponent::Texcoord0, encoding);
+	Check(stride == 12 + 4 + 4 && texcoordOffset == 12, "UNorm16 texcoords take four bytes each");
+
+	// The first set tiles a few times, the second is an atlas region, flat in v
+	uniform_real_distribution<float> tiledDistribution{ -2.0f, 3.0f };
+	uniform_real_distribution<float> atlasDistribution{ 0.25f, 0.5f };
+
+	const uint32_t numVertices = 4096;
+	vector<float> vertices;
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, tiledDistribution(rng), tiledDistribution(rng), atlasDistribution(rng), 0.75f });
+	}
+
+	const VertexDecodeParams decodeParams = ComputeVertexDecodeParams(vertices, components, encoding);
+	const float* scale = decodeParams.texcoordScaleOffset;
+	const float* offset = decodeParams.texcoordScaleOffset + 2;
+	Check(offset[0] <= -1.99f && offset[0] + scale[0] >= 2.99f && offset[1] <= 0.75f && offset[1] + scale[1] >= 2.99f,
+		"the texcoord range spans every set");
+
+	vector<std::byte> encoded;
+	EncodeVertices(vertices, components, encoding, decodeParams, encoded);
+
+	bool withinError = true;
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		for (uint32_t set = 0; set < 2; ++set)
+		{
+			for (uint32_t j = 0; j < 2; ++j)
+			{
+				const float value = vertices[i * 7 + 3 + set * 2 + j];
+				const uint16_t packed = Load<uint16_t>(encoded, (size_t)i * stride + texcoordOffset + set * 4 + j * 2);
+				const float decoded = DecodeUNorm16(packed) * scale[j] + offset[j];
+				withinError = withinError && fabsf(decoded - value) <= scale[j] / 65535.0f + fabsf(value) * 1e-5f + 1e-6f;
+			}
+		}
+	}
+	Check(withinError, "texcoords round-trip within a step of 1/65535 of their range");
+
+	// A mesh whose texcoords are all the same has a flat range in both axes
+	vector<float> flat{ 0.0f, 0.0f, 0.0f, 0.3f, 0.6f, 0.0f, 0.0f, 1.0f, 0.3f, 0.6f };
+	const VertexDecodeParams flatParams = ComputeVertexDecodeParams(flat, VertexComponent::PositionTexcoord, encoding);
+	EncodeVertices(flat, VertexComponent::PositionTexcoord, encoding, flatParams, encoded);
+	const float decodedU = DecodeUNorm16(Load<uint16_t>(encoded, 16 + 12)) * flatParams.texcoordScaleOffset[0] + flatParams.texcoordScaleOffset[2];
+	const float decodedV = DecodeUNorm16(Load<uint16_t>(encoded, 16 + 14)) * flatParams.texcoordScaleOffset[1] + flatParams.texcoordScaleOffset[3];
+	Check(decodedU == 0.3f && decodedV == 0.6f, "flat texcoords decode exactly");
+}
+
+
+void TestHalfAndUNorm8Packing()
+{
+	// Texcoords as halves are packed directly, so they show the rounding at the edges of the format
+	const vector<pair<float, uint16_t>> halves{
+		{ 0.0f, 0x0000 }, { -0.0f, 0x8000 }, { 1.0f, 0x3C00 }, { -2.0f, 0xC000 }, { 0.1f, 0x2E66 },
+		{ 65504.0f, 0x7BFF }, { 65519.0f, 0x7BFF }, { 65520.0f, 0x7C00 }, { -1e10f, 0xFC00 },
+		{ numeric_limits<float>::infinity(), 0x7C00 },
+		{ ldexpf(1.0f, -14), 0x0400 }, { ldexpf(1.0f, -24), 0x0001 }, { ldexpf(1.0f, -25), 0x0000 }, { ldexpf(1.5f, -25), 0x0001 },
+		{ ldexpf(1023.0f, -24), 0x03FF }, { ldexpf(1023.5f, -24), 0x0400 }, { 1e-10f, 0x0000 },
+		{ 1.0f + ldexpf(1.0f, -11), 0x3C00 }, { 1.0f + ldexpf(3.0f, -11), 0x3C02 }, { 1.0f + ldexpf(1.0f, -12), 0x3C00 }
+	};
+
+	vector<float> vertices;
+	for (const auto& [value, expected] : halves)
+	{
+		vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, value, 0.0f });
+	}
+	vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, numeric_limits<float>::quiet_NaN(), 0.0f });
+
+	vector<std::byte> encoded;
+	EncodeVertices(vertices, VertexComponent::PositionTexcoord, VertexEncoding::TexcoordHalf, VertexDecodeParams{}, encoded);
+	const uint32_t stride = VertexLayout<VertexComponent::PositionTexcoord, VertexEncoding::TexcoordHalf>{}.GetSizeInBytes();
+	Check(stride == 16, "half texcoords take four bytes");
+
+	bool halvesMatch = true;
+	for (size_t i = 0; i < halves.size(); ++i)
+	{
+		const uint16_t packed = Load<uint16_t>(encoded, i * stride + 12);
+		if (packed != halves[i].second)
+		{
+			printf("  %g packed to 0x%04X, expected 0x%04X\n", halves[i].first, packed, halves[i].second);
+			halvesMatch = false;
+		}
+	}
+	Check(halvesMatch, "halves round to nearest even, with denormals, overflow to infinity and signed zero");
+
+	const uint16_t nan = Load<uint16_t>(encoded, halves.size() * stride + 12);
+	Check((nan & 0x7C00) == 0x7C00 && (nan & 0x03FF) != 0, "NaN packs to a half NaN");
+
+	// Colors saturate, and 0.5 sits exactly between two steps
+	const vector<float> colors{ 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, -1.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.25f, 0.75f, 1.0f / 255.0f, numeric_limits<float>::quiet_NaN() };
+	EncodeVertices(colors, VertexComponent::PositionColor, VertexEncoding::ColorUNorm8, VertexDecodeParams{}, encoded);
+	const uint8_t expectedColors[8] = { 0, 128, 0, 255, 64, 191, 1, 0 };
+	Check(encoded.size() == 32 && memcmp(encoded.data() + 12, expectedColors, 4) == 0 && memcmp(encoded.data() + 28, expectedColors + 4, 4) == 0,
+		"UNorm8 colors saturate and round to nearest even");
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+	mt19937 rng{ 1234 };
+
+	TestOctahedralNormals(rng);
+	TestTangentHandedness(rng);
+	TestPositions(rng);
+	TestTexcoords(rng);
+	TestHalfAndUNorm8Packing();
+
+	return FailureCount() == 0 ? 0 : 1;
+}